@@ -1742,6 +1742,13 @@ static IRMP_PARAMETER                       irmp_param2;
 #endif
 
 static volatile uint8_t                     irmp_ir_detected = FALSE;
+
+#if IRMP_USE_IDLE_FAST_PATH == 1
+uint8_t                                     irmp_idle;                      // TRUE: irmp_ISR() has nothing to do while input is high
+#endif
+#if IRMP_USE_EXTERNAL_INPUT == 1
+volatile uint8_t                            irmp_external_input = 1;        // level used by irmp_ISR() instead of the input pin
+#endif
 static volatile uint8_t                     irmp_protocol;
 static volatile uint16_t                    irmp_address;
 static volatile uint16_t                    irmp_command;
@@ -2263,7 +2270,11 @@ irmp_ISR (void)
     time_counter++;
 #endif // ANALYZE
 
+#if IRMP_USE_EXTERNAL_INPUT == 1
+    irmp_input = irmp_external_input;
+#else
     irmp_input = input(IRMP_PIN);
+#endif
 
 #if IRMP_USE_CALLBACK == 1
     if (irmp_callback_ptr)
@@ -2294,6 +2305,9 @@ irmp_ISR (void)
                 }
 #endif // ANALYZE
                 irmp_pulse_time++;                                              // increment counter
+#if IRMP_USE_IDLE_FAST_PATH == 1
+                irmp_idle = FALSE;
+#endif
             }
             else
             {                                                                   // no...
@@ -2331,6 +2345,13 @@ irmp_ISR (void)
                     {
                         key_repetition_len++;
 
+#if IRMP_USE_IDLE_FAST_PATH == 1
+                        if (key_repetition_len == 0xFFFF)                       // all counters have run out: nothing to do until next burst
+                        {
+                            irmp_idle = TRUE;
+                        }
+#endif
+
 #if IRMP_SUPPORT_DENON_PROTOCOL == 1
                         if (denon_repetition_len < 0xFFFF)                      // avoid overflow of counter
                         {
@@ -166,6 +166,11 @@
 #error F_INTERRUPTS too high (should be not greater than 20000)
 #endif
 
+#if IRMP_USE_IDLE_FAST_PATH == 1 && (IRMP_LOGGING == 1 || IRMP_USE_CALLBACK == 1 || IRMP_USE_EXTERNAL_INPUT == 1 || defined (UNIX_OR_WINDOWS))
+#  undef IRMP_USE_IDLE_FAST_PATH
+#  define IRMP_USE_IDLE_FAST_PATH               0
+#endif
+
 #include "irmpprotocols.h"
 
 #define IRMP_FLAG_REPETITION            0x01
@@ -183,4 +188,20 @@ extern const char * const               irmp_protocol_names[IRMP_N_PROTOCOLS + 1
 extern void                             irmp_set_callback_ptr (void (*cb)(uint8_t));
 #endif // IRMP_USE_CALLBACK == 1
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * irmp_is_idle() is true when calling irmp_ISR() would not change anything: No frame is in progress, all repetition
+ * counters have run out and there is no burst at the input. The caller of irmp_ISR() can use it to skip the call.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#if IRMP_USE_IDLE_FAST_PATH == 1
+extern uint8_t                          irmp_idle;
+#  define irmp_is_idle()                        (irmp_idle && input(IRMP_PIN))
+#else
+#  define irmp_is_idle()                        0
+#endif // IRMP_USE_IDLE_FAST_PATH == 1
+
+#if IRMP_USE_EXTERNAL_INPUT == 1
+extern volatile uint8_t                 irmp_external_input;
+#endif // IRMP_USE_EXTERNAL_INPUT == 1
+
 #endif /* _IRMP_H_ */
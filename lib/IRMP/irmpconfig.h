@@ -92,6 +92,37 @@
 #define IRMP_SUPPORT_SAMSUNG48_PROTOCOL         0       // Samsung48            >= 10000                 ~100 bytes (SAMSUNG must be enabled!)
 #define IRMP_SUPPORT_RADIO1_PROTOCOL            0       // RADIO, e.g. TEVION   >= 10000                 ~250 bytes (experimental)
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Set IRMP_PROTOCOL_PROFILE to the protocol of the remote control actually being used in order to only build its decoder.
+ * This saves program space and makes irmp_ISR() considerably cheaper, as all other decoders are skipped.
+ *
+ * 0 use all decoders enabled above (default)
+ * 1 SIRCS, 2 NEC, 3 SAMSUNG, 4 MATSUSHITA, 5 KASEIKYO, 7 RC5, 8 DENON, 9 RC6 (see IRMP_xxx_PROTOCOL in irmpprotocols.h)
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_PROTOCOL_PROFILE
+#  define IRMP_PROTOCOL_PROFILE                 0       // 0: all decoders enabled above, otherwise number of the only decoder to build
+#endif
+
+#if IRMP_PROTOCOL_PROFILE != 0
+#  undef IRMP_SUPPORT_SIRCS_PROTOCOL
+#  define IRMP_SUPPORT_SIRCS_PROTOCOL           (IRMP_PROTOCOL_PROFILE == 1)
+#  undef IRMP_SUPPORT_NEC_PROTOCOL
+#  define IRMP_SUPPORT_NEC_PROTOCOL             (IRMP_PROTOCOL_PROFILE == 2)
+#  undef IRMP_SUPPORT_SAMSUNG_PROTOCOL
+#  define IRMP_SUPPORT_SAMSUNG_PROTOCOL         (IRMP_PROTOCOL_PROFILE == 3)
+#  undef IRMP_SUPPORT_MATSUSHITA_PROTOCOL
+#  define IRMP_SUPPORT_MATSUSHITA_PROTOCOL      (IRMP_PROTOCOL_PROFILE == 4)
+#  undef IRMP_SUPPORT_KASEIKYO_PROTOCOL
+#  define IRMP_SUPPORT_KASEIKYO_PROTOCOL        (IRMP_PROTOCOL_PROFILE == 5)
+#  undef IRMP_SUPPORT_RC5_PROTOCOL
+#  define IRMP_SUPPORT_RC5_PROTOCOL             (IRMP_PROTOCOL_PROFILE == 7)
+#  undef IRMP_SUPPORT_DENON_PROTOCOL
+#  define IRMP_SUPPORT_DENON_PROTOCOL           (IRMP_PROTOCOL_PROFILE == 8)
+#  undef IRMP_SUPPORT_RC6_PROTOCOL
+#  define IRMP_SUPPORT_RC6_PROTOCOL             (IRMP_PROTOCOL_PROFILE == 9)
+#endif
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  * Change hardware pin here for ATMEL AVR
  *---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -174,4 +205,24 @@
 #  define IRMP_USE_CALLBACK                     0       // 1: use callbacks. 0: do not. default is 0
 #endif
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Set IRMP_USE_IDLE_FAST_PATH to 1 to be able to skip irmp_ISR() while the input is idle, see irmp_is_idle().
+ * Once no frame is in progress and all repetition counters have run out, irmp_ISR() has nothing left to do until
+ * the next burst starts. It is ignored when IRMP_LOGGING or IRMP_USE_CALLBACK is enabled.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_USE_IDLE_FAST_PATH
+#  define IRMP_USE_IDLE_FAST_PATH               1       // 1: provide irmp_is_idle(), 0: do not. default is 1
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Set IRMP_USE_EXTERNAL_INPUT to 1 if irmp_ISR() should not sample the input pin itself, but use the level stored in irmp_external_input.
+ * This is used to replay recorded edges into the decoder (see IR_USE_EDGE_CAPTURE in ir.h). irmp_ISR() then still needs to be called once
+ * per 1/F_INTERRUPTS of input signal, but not in real time. IRMP_USE_IDLE_FAST_PATH is ignored in this case.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_USE_EXTERNAL_INPUT
+#  define IRMP_USE_EXTERNAL_INPUT               0       // 1: read input from irmp_external_input, 0: read input pin. default is 0
+#endif
+
 #endif /* _WC_IRMPCONFIG_H_ */
@@ -29,7 +29,6 @@
  */
 
 #include <inttypes.h>
-#include <stdio.h>
 
 #include "brightness.h"
 #include "config.h"
@@ -70,9 +69,9 @@ void brightness_handle()
 
         #if (LOG_BRIGHTNESS == 1)
 
-            char buff[5];
+            char buff[FORMAT_DEC_MAX_LENGTH];
 
-            sprintf_P(buff, fmt_unsigned_decimal, ldr_brightness);
+            format_dec(buff, ldr_brightness);
             uart_puts_P("brightness: ");
             uart_puts(buff);
             uart_putc('\n');
@@ -31,6 +31,9 @@
  * @see color.h
  */
 
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
 #include "color.h"
 #include "config.h"
 
@@ -44,54 +47,139 @@
 
 #if (ENABLE_RGB_SUPPORT == 1)
 
+#if (COLOR_HUE_STEPS != 256)
+
+    #error COLOR_HUE_STEPS needs to be 256
+
+#endif
+
 /**
- * @brief Returns the green portion of a given hue
+ * @brief Describes the channels of a color within a single hue region
  *
- * The color space can be understood as a spectrum from 0 to 360 degrees, see
- * [1]. Colors from 0 to 240 degrees contain green portions (green hue) with
- * varying values of saturation and brightness.
+ * Within each of the six hue regions (Red-Yellow, Yellow-Green, Green-Cyan,
+ * Cyan-Blue, Blue-Magenta, Magenta-Red, see [1]) one channel is at its
+ * maximum, one channel is at its minimum and the remaining channel is rising
+ * (even regions) or falling (odd regions) linearly. Channels are referred to
+ * by their offset within color_rgb_t.
  *
- * From 0 up to 60 degrees the hue increases linearly, from 60 up to 180
- * degrees the hue is at a maximum. From 180 up to 240 degrees the hue
- * decreases linearly again. From 240 degrees up to 360 degrees there is no
- * green portion (hue) left. The various degrees are calculated using
- * COLOR_HUE_STEPS and COLOR_HUE_MAX.
+ * [1]: https://en.wikipedia.org/wiki/Hue#Computing_hue_from_RGB
  *
- * This function will return a value from 0 up to 255, where 0 means there is
- * no green portion, and 255 represents completely green.
+ * @see color_hue_regions
+ */
+typedef struct {
+
+    /**
+     * @brief Offset of the channel being at its maximum
+     */
+    uint8_t max;
+
+    /**
+     * @brief Offset of the channel changing linearly
+     */
+    uint8_t mid;
+
+    /**
+     * @brief Offset of the channel being at its minimum
+     */
+    uint8_t min;
+
+} color_hue_region_t;
+
+/**
+ * @brief Offset of the red channel within color_rgb_t
+ */
+#define COLOR_R offsetof(color_rgb_t, red)
+
+/**
+ * @brief Offset of the green channel within color_rgb_t
+ */
+#define COLOR_G offsetof(color_rgb_t, green)
+
+/**
+ * @brief Offset of the blue channel within color_rgb_t
+ */
+#define COLOR_B offsetof(color_rgb_t, blue)
+
+/**
+ * @brief Table describing the channels within each of the hue regions
  *
- * @param hue The given hue
+ * @see color_hue_region_t
+ * @see color_hsv2rgb()
+ * @see color_rgb2hsv()
+ */
+static const color_hue_region_t color_hue_regions[6] PROGMEM = {
+
+    {COLOR_R, COLOR_G, COLOR_B},
+    {COLOR_G, COLOR_R, COLOR_B},
+    {COLOR_G, COLOR_B, COLOR_R},
+    {COLOR_B, COLOR_G, COLOR_R},
+    {COLOR_B, COLOR_R, COLOR_G},
+    {COLOR_R, COLOR_B, COLOR_G},
+
+};
+
+/**
+ * @brief Scales the given value by the given factor
  *
- * @return The green portion of the given hue, ranges from 0 up to 255
+ * This is equivalent to `value * (factor + 1) / 256`, so a factor of 255 will
+ * return the value unchanged. It only involves a single 8 bit multiplication.
  *
- * @see COLOR_HUE_STEPS
- * @see COLOR_HUE_MAX
- * @see color_hue2rgb()
+ * @param value Value to be scaled
+ * @param factor Factor to scale with, ranges from 0 up to 255
  *
- * [1]: https://en.wikipedia.org/wiki/File:HueScale.svg
+ * @return The scaled value
  */
-static uint8_t color_hue_waveform(color_hue_t hue)
+static inline uint8_t color_scale(uint8_t value, uint8_t factor)
 {
 
-    if (hue < (COLOR_HUE_MAX / 6)) {
+    return ((uint16_t)value * factor + value) >> 8;
 
-        return hue * ((COLOR_HUE_STEPS * 6) / COLOR_HUE_MAX);
+}
 
-    } else if (hue < ((COLOR_HUE_MAX * 3) / 6)) {
+/**
+ * @brief Converts a HSV color into its RGB values
+ *
+ * The hue region and the position within it are given by the upper and lower
+ * eight bits of the hue. The region is then looked up from
+ * color_hue_regions, so besides some scaling for the saturation and value no
+ * further calculations are needed.
+ *
+ * @param hsv Pointer to the HSV color to convert
+ * @param color Pointer to color struct where converted values will be put
+ *
+ * @see color_hsv_t
+ * @see color_hue_regions
+ * @see color_rgb2hsv()
+ */
+void color_hsv2rgb(const color_hsv_t* hsv, color_rgb_t* color)
+{
+
+    color_hue_t hue = hsv->hue;
+
+    if (hue >= COLOR_HUE_MAX) {
 
-        return COLOR_HUE_STEPS - 1;
+        hue -= COLOR_HUE_MAX;
 
-    } else if (hue < ((COLOR_HUE_MAX * 4) / 6)) {
+    }
 
-        return (((COLOR_HUE_MAX * 4) / 6) - 1 - hue)
-                    * ((COLOR_HUE_STEPS * 6) / COLOR_HUE_MAX);
+    uint8_t region = hue / COLOR_HUE_STEPS;
+    uint8_t position = hue % COLOR_HUE_STEPS;
 
-    } else {
+    if (region & 1) {
 
-        return 0;
+        position = (COLOR_HUE_STEPS - 1) - position;
 
     }
 
+    uint8_t* channels = (uint8_t*)color;
+    uint8_t max = hsv->value;
+    uint8_t min = color_scale(max, 255 - hsv->saturation);
+
+    channels[pgm_read_byte(&color_hue_regions[region].max)] = max;
+    channels[pgm_read_byte(&color_hue_regions[region].mid)] =
+        min + color_scale(max - min, position);
+    channels[pgm_read_byte(&color_hue_regions[region].min)] = min;
+
 }
 
 /**
@@ -99,7 +187,7 @@ static uint8_t color_hue_waveform(color_hue_t hue)
  *
  * The hue is interpreted as color_hue_t and ranges from 0 up to COLOR_HUE_MAX.
  * This calculations will always consider the brightness and saturation to be
- * 1. Internally it makes heavily use of color_hue_waveform().
+ * 1.
  *
  * @param h The hue value to convert, ranges from 0 up to COLOR_HUE_MAX
  * @param color Pointer to color struct where converted values will be put
@@ -107,29 +195,83 @@ static uint8_t color_hue_waveform(color_hue_t hue)
  * @see color_hue_t
  * @see color_rgb_t
  * @see COLOR_HUE_MAX
- * @see color_hue_waveform()
+ * @see color_hsv2rgb()
  */
 void color_hue2rgb(color_hue_t h, color_rgb_t* color)
 {
 
-    uint16_t barg = (((uint16_t)h) + 2 * COLOR_HUE_MAX / 3);
-    uint16_t rarg = (((uint16_t)h) + COLOR_HUE_MAX / 3);
+    color_hsv_t hsv = {h, 255, 255};
+
+    color_hsv2rgb(&hsv, color);
 
-    if (barg >= COLOR_HUE_MAX) {
+}
+
+/**
+ * @brief Converts a RGB color into its HSV values
+ *
+ * This is the inverse of color_hsv2rgb(). The hue region is determined by
+ * looking for the entry within color_hue_regions matching the order of the
+ * channels, so only a single division is needed for the position within the
+ * region (and another one for the saturation). Gray colors are given a hue
+ * of zero.
+ *
+ * @param color Pointer to the RGB color to convert
+ * @param hsv Pointer to HSV color struct where converted values will be put
+ *
+ * @see color_hsv_t
+ * @see color_hue_regions
+ * @see color_hsv2rgb()
+ */
+void color_rgb2hsv(const color_rgb_t* color, color_hsv_t* hsv)
+{
 
-        barg -= COLOR_HUE_MAX;
+    const uint8_t* channels = (const uint8_t*)color;
+    uint8_t region = 0;
+
+    for (uint8_t i = 0; i < 6; i++) {
+
+        uint8_t max = channels[pgm_read_byte(&color_hue_regions[i].max)];
+        uint8_t mid = channels[pgm_read_byte(&color_hue_regions[i].mid)];
+        uint8_t min = channels[pgm_read_byte(&color_hue_regions[i].min)];
+
+        if (max >= mid && mid >= min) {
+
+            region = i;
+
+            break;
+
+        }
 
     }
 
-    if (rarg >= COLOR_HUE_MAX) {
+    uint8_t max = channels[pgm_read_byte(&color_hue_regions[region].max)];
+    uint8_t mid = channels[pgm_read_byte(&color_hue_regions[region].mid)];
+    uint8_t min = channels[pgm_read_byte(&color_hue_regions[region].min)];
+    uint8_t delta = max - min;
+
+    hsv->value = max;
+
+    if (delta == 0) {
+
+        hsv->hue = 0;
+        hsv->saturation = 0;
+
+        return;
+
+    }
+
+    hsv->saturation = ((uint16_t)delta * 255 + (max / 2)) / max;
+
+    uint8_t position = ((uint16_t)(mid - min) * (COLOR_HUE_STEPS - 1)
+        + (delta / 2)) / delta;
+
+    if (region & 1) {
 
-        rarg -= COLOR_HUE_MAX;
+        position = (COLOR_HUE_STEPS - 1) - position;
 
     }
 
-    color->green = color_hue_waveform(h);
-    color->blue = color_hue_waveform((color_hue_t)barg);
-    color->red = color_hue_waveform((color_hue_t)rarg);
+    hsv->hue = (color_hue_t)region * COLOR_HUE_STEPS + position;
 
 }
 
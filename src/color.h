@@ -23,9 +23,12 @@
  * @brief Header containing functions for various color animations
  *
  * These functions are based upon the hue of the color. Hue is a main property
- * of a color. Take a look at [1] for more details about it.
+ * of a color. Take a look at [1] for more details about it. Colors can also be
+ * described by their hue, saturation and value (HSV, see [2]) and converted
+ * from and to RGB.
  *
  * [1]: https://en.wikipedia.org/wiki/Hue
+ * [2]: https://en.wikipedia.org/wiki/HSL_and_HSV
  *
  * @see color.c
  */
@@ -97,8 +100,42 @@ typedef struct {
 
 } color_rgb_t;
 
+/**
+ * @brief Type definition for a HSV color
+ *
+ * This describes a color by its hue, saturation and value (brightness), see
+ * [1]. It can be converted from and to color_rgb_t.
+ *
+ * [1]: https://en.wikipedia.org/wiki/HSL_and_HSV
+ *
+ * @see color_hsv2rgb()
+ * @see color_rgb2hsv()
+ */
+typedef struct {
+
+    /**
+     * @brief The hue of the color, ranges from 0 up to COLOR_HUE_MAX
+     */
+    color_hue_t hue;
+
+    /**
+     * @brief The saturation of the color, 0 = gray, 255 = fully saturated
+     */
+    uint8_t saturation;
+
+    /**
+     * @brief The value of the color, 0 = black, 255 = full brightness
+     */
+    uint8_t value;
+
+} color_hsv_t;
+
 extern void color_hue2rgb(color_hue_t h, color_rgb_t* color);
 
+extern void color_hsv2rgb(const color_hsv_t* hsv, color_rgb_t* color);
+
+extern void color_rgb2hsv(const color_rgb_t* color, color_hsv_t* hsv);
+
 extern uint8_t color_pulse_waveform(uint8_t step);
 
 #endif /* _WC_COLOR_H_ */
@@ -122,6 +122,21 @@
  */
 #define ENABLE_DCF_SUPPORT 1
 
+/**
+ * @brief Defines whether support for the IR remote control should be included
+ *
+ * If set to 0, IRMP is left out entirely, along with the "training" mode for
+ * the remote control, which is otherwise entered for a couple of seconds
+ * after each reset. The Wordclock can then only be controlled via the UART
+ * protocol (see uart_protocol.h), which saves a lot of program space. The
+ * timer ISR is executed with 1 kHz instead of 10 kHz in this case (see
+ * F_INTERRUPT).
+ *
+ * @see ir.h
+ * @see user_command_handle()
+ */
+#define ENABLE_IR_SUPPORT 1
+
 /**
  * @brief Defines whether support for Ambilight should be included
  *
@@ -163,6 +178,20 @@
  */
 #define ENABLE_AUXPOWER_SUPPORT 1
 
+/**
+ * @brief Defines whether support for a motion sensor should be included
+ *
+ * If set to 1, the firmware will be built with support for a motion sensor
+ * (e.g. a PIR module), which turns the display off once nobody has been around
+ * for a while and back on as soon as motion is detected.
+ *
+ * @note The sensor is connected to the pin otherwise used for the Bluetooth
+ * transceiver, so `ENABLE_BLUETOOTH_SUPPORT` needs to be disabled.
+ *
+ * @see presence.h
+ */
+#define ENABLE_PRESENCE_SUPPORT 0
+
 /**
  * @brief Defines whether unused user command should be included
  *
@@ -191,6 +220,51 @@
  */
 #define ENABLE_USER_AUTOSAVE 1
 
+/**
+ * @brief Defines whether the time should be shown as early as possible
+ *
+ * By default the indicator blinks for USER_STARTUP_WAIT_IR_TRAIN_S after
+ * each reset, waiting for an IR command to enter the training mode, and the
+ * time is only shown afterwards. If set to 1, the time is shown right away
+ * instead: The RTC is read as soon as interrupts are enabled, and the first
+ * time is shown without any animation. The training mode can still be
+ * entered within the same interval, in which case its display takes over.
+ *
+ * The time it took to show the first time can be retrieved using the UART
+ * protocol (command `bt`) in either case.
+ *
+ * @see user_get_boot_time()
+ * @see USER_STARTUP_WAIT_IR_TRAIN_S
+ */
+#define ENABLE_FAST_BOOT 0
+
+/**
+ * @brief Defines whether runtime state should survive resets
+ *
+ * If set to 1, a snapshot of the datetime, the filtered LDR value and the
+ * "power" state is kept within the `.noinit` section and updated once a
+ * second. After a reset caused by the watchdog or a brown-out, the snapshot
+ * is restored if its checksum is intact, so the time is shown right away
+ * and the brightness doesn't start over from a single measurement.
+ *
+ * @see restart_restore()
+ */
+#define ENABLE_WARM_RESTART 1
+
+/**
+ * @brief Defines whether health counters should be kept
+ *
+ * If set to 1, failures that are otherwise recovered from silently (e.g.
+ * data lost by the UART, failed transfers on the I2C bus, failures of the
+ * RTC and preferences that couldn't be written) are counted, and the number
+ * of iterations of the main loop per second is sampled. The counters are
+ * kept within the battery backed SRAM of the RTC and can be retrieved using
+ * the UART protocol (command `hg`).
+ *
+ * @see health.h
+ */
+#define ENABLE_HEALTH_COUNTERS 1
+
 /**
  * @brief Defines whether support for the UART protocol should be included
  *
@@ -203,6 +277,69 @@
  */
 #define ENABLE_UART_PROTOCOL 1
 
+/**
+ * @brief Defines whether the binary mode of the UART protocol is included
+ *
+ * If set to 1, the UART protocol can be switched into a binary mode at
+ * runtime (command `b`). In this mode commands are exchanged as
+ * length-prefixed frames protected by a CRC-8 checksum, which carry the
+ * arguments as raw bytes. This reduces the amount of data to be transmitted
+ * and avoids any string handling.
+ *
+ * @note This only has an effect when ENABLE_UART_PROTOCOL is set to 1.
+ *
+ * @see ENABLE_UART_PROTOCOL
+ * @see uart_protocol.h
+ */
+#define ENABLE_UART_PROTOCOL_BINARY 1
+
+/**
+ * @brief Defines whether telemetry records can be subscribed to
+ *
+ * If set to 1, the host can subscribe to a set of values (command `su`),
+ * which are then pushed periodically by the Wordclock itself, so there is no
+ * need to poll each of them one command at a time.
+ *
+ * @note This only has an effect when ENABLE_UART_PROTOCOL is set to 1.
+ *
+ * @see ENABLE_UART_PROTOCOL
+ * @see uart_protocol_telemetry_handle()
+ */
+#define ENABLE_UART_PROTOCOL_TELEMETRY 1
+
+/**
+ * @brief Defines whether preferences can be transferred as a whole
+ *
+ * If set to 1, the color presets, the user preferences or all of the
+ * preferences can be read and written in chunks (commands `xg`, `xr`, `xw` and
+ * `xc`), protected by a CRC-16 over the whole block. Blocks being written are
+ * staged within a buffer of the size of prefs_t, which is only applied once
+ * the checksum matches.
+ *
+ * @note This only has an effect when ENABLE_UART_PROTOCOL is set to 1.
+ *
+ * @see ENABLE_UART_PROTOCOL
+ * @see prefs_t
+ */
+#define ENABLE_UART_PROTOCOL_TRANSFER 1
+
+/**
+ * @brief Defines whether time beacons can be exchanged with other clocks
+ *
+ * If set to 1, a clock can be told to put out its time once every couple of
+ * seconds (command `tx`), aligned to the boundary of its seconds. Other
+ * clocks listening on the same serial link, e.g. via paired Bluetooth
+ * modules, take this time over (command `tb`) and compensate for the latency
+ * of the transmission, so multiple clocks within a room tick in unison.
+ *
+ * @note This only has an effect when ENABLE_UART_PROTOCOL is set to 1.
+ *
+ * @see ENABLE_UART_PROTOCOL
+ * @see uart_protocol_beacon_handle()
+ * @see datetime_sync()
+ */
+#define ENABLE_UART_PROTOCOL_BEACON 1
+
 /**
  * @brief Defines whether support for memory debugging should be included
  *
@@ -214,6 +351,21 @@
  */
 #define ENABLE_DEBUG_MEMCHECK 0
 
+/**
+ * @brief Defines whether support for profiling ISRs should be included
+ *
+ * If set to 1, the firmware will be built with support for measuring the
+ * execution time of the various ISRs. For each of them the minimum, maximum
+ * and average amount of CPU cycles as well as the number of overruns is
+ * recorded, which can be retrieved using the UART protocol.
+ *
+ * @note This adds some overhead to each ISR and should only be enabled for
+ * debugging purposes.
+ *
+ * @see profile.h
+ */
+#define ENABLE_DEBUG_ISR_PROFILE 0
+
 /**
  * @brief Defines whether the main module should output logging information
  *
@@ -242,7 +394,10 @@
  * This affects `ldr.c` and controls whether debug information about measured
  * values from the LDR should be output.
  *
+ * This makes use of the log buffer (see log.h).
+ *
  * @see ldr.c
+ * @see log.h
  */
 #define LOG_LDR 0
 
@@ -270,7 +425,10 @@
  * This affects `display_wc.c` and controls whether debug information about any
  * changes to the display state should be output.
  *
+ * This makes use of the log buffer (see log.h).
+ *
  * @see display_wc.c
+ * @see log.h
  */
 #define LOG_DISPLAY_STATE 0
 
@@ -342,7 +500,10 @@
  * This affects `dcf77.c` and controls whether various debug information about
  * the current state of the DCF77 module should be output.
  *
+ * This makes use of the log buffer (see log.h).
+ *
  * @see dcf77.c
+ * @see log.h
  */
 #define LOG_DCF77 0
 
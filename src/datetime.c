@@ -26,6 +26,9 @@
  * second. {@link #datetime_handle()} needs to be invoked on a quasi
  * regular basis to re-read the time from the {@link i2c_rtc.h RTC} module.
  * This approach guarantees accuracy without stressing the I2C bus too much.
+ * Alternatively the software clock can be driven by the square wave put out
+ * by the RTC (DATETIME_USE_RTC_SQW), in which case the RTC only needs to be
+ * read once.
  *
  * An internal copy of a {@link datetime_t} struct is always held available,
  * and can be retrieved with {@link #datetime_get()}.
@@ -37,12 +40,50 @@
  * @see datetime.h
  */
 
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
 #include "config.h"
 #include "datetime.h"
 #include "dcf77.h"
+#include "display.h"
+#include "event.h"
+#include "health.h"
 #include "i2c_rtc.h"
+#include "ports.h"
+#include "preferences.h"
+#include "timer.h"
 #include "user.h"
 
+#if (DATETIME_USE_RTC_SQW == 1)
+
+    #if (ENABLE_AUXPOWER_SUPPORT == 1)
+
+        #error "The square wave input occupies the pin of USER_AUXPOWER"
+
+    #endif /* (ENABLE_AUXPOWER_SUPPORT == 1) */
+
+    #if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+        #error "DATETIME_USE_RTC_SQW can't be used along with ENABLE_UART_PROTOCOL_BEACON"
+
+    #endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+    /**
+     * @brief Port and pin the SQW/OUT pin of the RTC is connected to
+     *
+     * This needs to be INT0, which is the pin otherwise used by
+     * USER_AUXPOWER. SQW/OUT is an open drain output, so the internal
+     * pull-up is enabled.
+     *
+     * @see ports.h
+     * @see DATETIME_USE_RTC_SQW
+     */
+    #define DATETIME_SQW_INPUT PORTD, 2
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
+
 /**
  * @brief Used to keep track of seconds in software
  *
@@ -79,6 +120,54 @@ static volatile uint8_t soft_seconds;
  */
 static datetime_t datetime;
 
+/**
+ * @brief Indicates whether the date and time information is known to be valid
+ *
+ * This is set during the initialization when the RTC has kept running, and
+ * whenever a new datetime has been set successfully.
+ *
+ * @see datetime_is_valid()
+ * @see datetime_init()
+ * @see datetime_set()
+ */
+static bool datetime_valid;
+
+/**
+ * @brief Indicates whether the result of the pending read should be discarded
+ *
+ * This is set when a new datetime is set while a read of the RTC is still
+ * pending, as the result would contain the old date and time.
+ *
+ * @see datetime_set()
+ * @see datetime_handle()
+ */
+static bool datetime_read_discard;
+
+/**
+ * @brief Value of timer_get_ms() when the software clock has ticked last
+ *
+ * @see datetime_ISR()
+ * @see datetime_get_subsecond_ms()
+ */
+static volatile uint16_t datetime_tick_ms;
+
+/**
+ * @brief Date the number of days within datetime_epoch_days belongs to
+ *
+ * Only the members YY, MM and DD are used. The year is initialized with an
+ * invalid value, so the first conversion is always performed.
+ *
+ * @see datetime_get_epoch()
+ */
+static datetime_t datetime_epoch_date = {.YY = 0xff};
+
+/**
+ * @brief Number of days since 2000-01-01 of datetime_epoch_date
+ *
+ * @see datetime_get_epoch()
+ */
+static uint16_t datetime_epoch_days;
+
 /**
  * @brief Checks whether the given year is a leap year
  *
@@ -140,14 +229,563 @@ static uint8_t get_number_of_days_in_month(uint8_t month, uint8_t year)
 
 }
 
+/**
+ * @brief Number of days within the year before the beginning of each month
+ *
+ * This doesn't take leap years into account.
+ *
+ * @see datetime_get_days()
+ */
+static const uint16_t datetime_days_before_month[12] PROGMEM = {
+
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+
+};
+
+/**
+ * @brief Returns the number of days since 2000-01-01 for the given date
+ *
+ * Leap years are determined the same way as by is_leap_year(), so days are
+ * counted consistently with the calendar of the software clock.
+ *
+ * @param dt Datetime to convert, only the date is taken into account
+ *
+ * @return Number of days since 2000-01-01
+ *
+ * @see is_leap_year()
+ * @see datetime_days_before_month
+ */
+static uint16_t datetime_get_days(const datetime_t* dt)
+{
+
+    uint16_t days = (uint16_t)dt->YY * 365 + dt->DD - 1
+        + pgm_read_word(&datetime_days_before_month[dt->MM - 1]);
+
+    if (dt->YY > 0) {
+
+        days += (dt->YY - 1) / 4;
+
+    }
+
+    if (dt->MM > 2 && is_leap_year(dt->YY)) {
+
+        days++;
+
+    }
+
+    return days;
+
+}
+
+/**
+ * @brief Returns the number of seconds since the beginning of the day
+ *
+ * @param dt Datetime to convert
+ *
+ * @return Number of seconds since midnight
+ */
+static uint32_t datetime_get_seconds_of_day(const datetime_t* dt)
+{
+
+    return (uint32_t)dt->hh * 3600 + dt->mm * 60 + dt->ss;
+
+}
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+    /**
+     * @brief Offset (in ms) the software clock is kept behind the reference
+     * after having been synchronized
+     *
+     * The RTC starts counting the current second from scratch when it is
+     * written. Without this offset the software clock would tick at the very
+     * same moment the RTC advances, so the reads started after a tick might
+     * still return the previous second.
+     *
+     * @see datetime_sync()
+     */
+    #define DATETIME_SYNC_GUARD_MS 20
+
+    /**
+     * @brief Deviation (in ms) from the reference that is tolerated
+     *
+     * Time beacons indicating a smaller deviation are ignored, so the clocks
+     * are not realigned with every beacon due to the jitter of the link.
+     *
+     * @see datetime_sync()
+     */
+    #define DATETIME_SYNC_TOLERANCE_MS 50
+
+    /**
+     * @brief Indicates whether a synchronization is waiting for the next tick
+     *
+     * @see datetime_sync()
+     * @see datetime_handle_sync()
+     */
+    static bool datetime_sync_pending;
+
+    /**
+     * @brief Value of soft_seconds when the synchronization has been started
+     *
+     * @see datetime_sync()
+     * @see datetime_handle_sync()
+     */
+    static uint8_t datetime_sync_seconds;
+
+    /**
+     * @brief Datetime to be set with the next tick of the software clock
+     *
+     * @see datetime_sync()
+     * @see datetime_handle_sync()
+     */
+    static datetime_t datetime_sync_target;
+
+    /**
+     * @brief Converts seconds since 2000-01-01 into a datetime
+     *
+     * This is the inverse of datetime_get_epoch(), and uses the same calendar
+     * as the software clock (see is_leap_year()). The weekday, however, is
+     * determined by the actual calendar, in which 2000-01-01 was a Saturday.
+     *
+     * @param epoch Seconds since 2000-01-01 00:00:00
+     * @param dt Pointer to datetime the result is put in
+     *
+     * @see datetime_get_epoch()
+     * @see get_number_of_days_in_month()
+     */
+    static void datetime_from_epoch(uint32_t epoch, datetime_t* dt)
+    {
+
+        uint16_t days = epoch / 86400;
+        uint32_t seconds = epoch % 86400;
+
+        dt->hh = seconds / 3600;
+        dt->mm = (seconds / 60) % 60;
+        dt->ss = seconds % 60;
+
+        // The actual calendar knows of 2000-02-29
+        dt->WD = ((days + (days >= 59 ? 1 : 0) + 5) % 7) + 1;
+
+        dt->YY = 0;
+
+        while (days >= (is_leap_year(dt->YY) ? 366 : 365)) {
+
+            days -= is_leap_year(dt->YY) ? 366 : 365;
+            dt->YY++;
+
+        }
+
+        dt->MM = 1;
+
+        while (days >= get_number_of_days_in_month(dt->MM, dt->YY)) {
+
+            days -= get_number_of_days_in_month(dt->MM, dt->YY);
+            dt->MM++;
+
+        }
+
+        dt->DD = days + 1;
+
+    }
+
+    /**
+     * @brief Takes over the datetime of a pending synchronization
+     *
+     * Once the software clock has ticked after datetime_sync(), which
+     * happens at the boundary of the reference's second, the new datetime is
+     * set and the software clock is delayed by DATETIME_SYNC_GUARD_MS
+     * relative to the RTC, which has just been restarted by the write.
+     *
+     * @see datetime_sync()
+     * @see datetime_handle()
+     */
+    static void datetime_handle_sync()
+    {
+
+        if (!datetime_sync_pending || soft_seconds == datetime_sync_seconds) {
+
+            return;
+
+        }
+
+        datetime_sync_pending = false;
+
+        if (datetime_set(&datetime_sync_target)) {
+
+            uint8_t sreg = SREG;
+            cli();
+            timer_align_1hz(1000 + DATETIME_SYNC_GUARD_MS - (timer_get_ms() - datetime_tick_ms));
+            SREG = sreg;
+
+        }
+
+    }
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+#if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+    /**
+     * @brief Interval in seconds the RTC is read once the software clock is
+     * disciplined
+     *
+     * @see DATETIME_DISCIPLINE_SOFT_CLOCK
+     * @see datetime_handle_disciplined()
+     */
+    #define DATETIME_READ_INTERVAL_DISCIPLINED 60
+
+    /**
+     * @brief Minimum length in seconds of an interval to measure the drift
+     *
+     * As both, the RTC and the software clock, only have a resolution of one
+     * second, this defines the resolution of a single measurement, e.g. an
+     * interval of one hour results in a resolution of roughly 280 ppm.
+     *
+     * @see datetime_measure_drift()
+     */
+    #define DATETIME_DRIFT_INTERVAL 3600
+
+    /**
+     * @brief Number of measurements needed for the drift to be learned
+     *
+     * @see datetime_prefs_t::samples
+     */
+    #define DATETIME_DRIFT_SAMPLES 3
+
+    /**
+     * @brief Number of measurements after which the drift is saved again
+     *
+     * Once the drift has been learned, it is only written back to the
+     * persistent storage after this many further measurements, which
+     * corresponds to about once a day.
+     *
+     * @see datetime_measure_drift()
+     */
+    #define DATETIME_DRIFT_SAVE_INTERVAL 24
+
+    /**
+     * @brief Counter of ticks of the software clock
+     *
+     * This is incremented by datetime_ISR() once a second and never adjusted,
+     * so it represents the uncorrected software clock.
+     *
+     * @see datetime_ISR()
+     */
+    static volatile uint16_t soft_ticks;
+
+    /**
+     * @brief Drift correction applied by datetime_ISR()
+     *
+     * This is a copy of datetime_prefs_t::drift, which can be accessed from
+     * within the ISR. It is only set once the drift has been learned.
+     *
+     * @see datetime_apply_drift()
+     */
+    static volatile int16_t soft_drift;
+
+    /**
+     * @brief Value of soft_ticks during the last read of the RTC
+     *
+     * @see datetime_handle_disciplined()
+     */
+    static uint16_t read_ticks;
+
+    /**
+     * @brief Value of soft_ticks at the beginning of the current measurement
+     *
+     * @see datetime_measure_drift()
+     */
+    static uint16_t drift_ticks;
+
+    /**
+     * @brief Time of the RTC in seconds of the day at the beginning of the
+     * current measurement
+     *
+     * @see datetime_measure_drift()
+     */
+    static uint32_t drift_seconds;
+
+    /**
+     * @brief Maximum step in seconds of the RTC the measurement of the drift
+     * is carried on across
+     *
+     * Setting a new datetime makes the RTC jump. Small steps, e.g. the hourly
+     * corrections by DCF77, are accounted for in drift_seconds, so that the
+     * drift is still learned when the interval in between is shorter than
+     * DATETIME_DRIFT_INTERVAL. Anything bigger than that starts a new
+     * measurement.
+     *
+     * @see datetime_step_drift()
+     */
+    #define DATETIME_DRIFT_MAX_STEP 60
+
+    /**
+     * @brief Indicates whether a measurement of the drift is in progress
+     *
+     * This is cleared whenever a new datetime is set that differs by more
+     * than DATETIME_DRIFT_MAX_STEP seconds, as the RTC jumps in this case.
+     *
+     * @see datetime_measure_drift()
+     * @see datetime_step_drift()
+     */
+    static bool drift_valid;
+
+    /**
+     * @brief Macro for easy access to datetime_prefs_t
+     *
+     * @see datetime_prefs_t
+     */
+    #define drift_prefs (preferences_get()->datetime_prefs)
+
+    /**
+     * @brief Returns whether the drift of the software clock has been learned
+     *
+     * @return True if the software clock is disciplined, false otherwise
+     *
+     * @see datetime_prefs_t::samples
+     */
+    static inline bool datetime_is_disciplined()
+    {
+
+        return drift_prefs.samples >= DATETIME_DRIFT_SAMPLES;
+
+    }
+
+    /**
+     * @brief Hands the learned drift over to datetime_ISR()
+     *
+     * @see soft_drift
+     */
+    static void datetime_apply_drift()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+        soft_drift = datetime_is_disciplined() ? drift_prefs.drift : 0;
+        SREG = sreg;
+
+    }
+
+    /**
+     * @brief Measures the drift of the software clock against the RTC
+     *
+     * This is called after each read of the RTC and compares the elapsed
+     * time of the RTC against the uncorrected software clock (soft_ticks).
+     * Once at least DATETIME_DRIFT_INTERVAL seconds have passed, the result
+     * is merged into datetime_prefs_t::drift by means of an exponential
+     * moving average and a new measurement is started.
+     *
+     * @see DATETIME_DRIFT_INTERVAL
+     * @see datetime_prefs_t
+     */
+    static void datetime_measure_drift()
+    {
+
+        static uint8_t unsaved;
+
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t ticks = soft_ticks;
+        SREG = sreg;
+
+        uint32_t seconds = datetime_get_seconds_of_day(&datetime);
+
+        read_ticks = ticks;
+
+        if (!drift_valid) {
+
+            drift_ticks = ticks;
+            drift_seconds = seconds;
+            drift_valid = true;
+
+            return;
+
+        }
+
+        uint16_t elapsed = ticks - drift_ticks;
+
+        if (elapsed < DATETIME_DRIFT_INTERVAL) {
+
+            return;
+
+        }
+
+        int32_t rtc_elapsed = seconds - drift_seconds;
+
+        if (rtc_elapsed < 0) {
+
+            rtc_elapsed += 24UL * 3600;
+
+        }
+
+        int32_t drift = ((rtc_elapsed - elapsed) * 65536) / elapsed;
+
+        if (drift > INT16_MAX) {
+
+            drift = INT16_MAX;
+
+        } else if (drift < INT16_MIN) {
+
+            drift = INT16_MIN;
+
+        }
+
+        if (drift_prefs.samples == 0) {
+
+            drift_prefs.drift = drift;
+
+        } else {
+
+            drift_prefs.drift += (drift - drift_prefs.drift) / 4;
+
+        }
+
+        if (drift_prefs.samples < DATETIME_DRIFT_SAMPLES) {
+
+            drift_prefs.samples++;
+            unsaved = DATETIME_DRIFT_SAVE_INTERVAL;
+
+        }
+
+        if (++unsaved >= DATETIME_DRIFT_SAVE_INTERVAL) {
+
+            preferences_save();
+            unsaved = 0;
+
+        }
+
+        datetime_apply_drift();
+
+        drift_ticks = ticks;
+        drift_seconds = seconds;
+
+    }
+
+    /**
+     * @brief Carries the measurement of the drift on across a new datetime
+     *
+     * This needs to be called before the new datetime is taken over. The step
+     * of the RTC is determined against the current datetime and added to
+     * drift_seconds, so the elapsed time of the RTC is not affected by it.
+     * Steps bigger than DATETIME_DRIFT_MAX_STEP discard the measurement.
+     *
+     * @param dt The new datetime
+     *
+     * @see DATETIME_DRIFT_MAX_STEP
+     * @see datetime_set()
+     */
+    static void datetime_step_drift(const datetime_t* dt)
+    {
+
+        if (!drift_valid || !datetime_valid) {
+
+            drift_valid = false;
+
+            return;
+
+        }
+
+        int32_t step = (int32_t)datetime_get_seconds_of_day(dt)
+            - (int32_t)datetime_get_seconds_of_day(&datetime);
+
+        if (step >= 12L * 3600) {
+
+            step -= 24L * 3600;
+
+        } else if (step < -12L * 3600) {
+
+            step += 24L * 3600;
+
+        }
+
+        if ((step > DATETIME_DRIFT_MAX_STEP)
+              || (step < -DATETIME_DRIFT_MAX_STEP)) {
+
+            drift_valid = false;
+
+            return;
+
+        }
+
+        int32_t seconds = drift_seconds + step;
+
+        if (seconds < 0) {
+
+            seconds += 24L * 3600;
+
+        } else if (seconds >= 24L * 3600) {
+
+            seconds -= 24L * 3600;
+
+        }
+
+        drift_seconds = seconds;
+
+    }
+
+#endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
+#if ((DATETIME_DISCIPLINE_SOFT_CLOCK == 1) || (DATETIME_USE_RTC_SQW == 1))
+
+    /**
+     * @brief Advances the given datetime by one minute
+     *
+     * @param dt Datetime to advance
+     *
+     * @see get_number_of_days_in_month()
+     */
+    static void datetime_add_minute(datetime_t* dt)
+    {
+
+        if (++dt->mm < 60) {
+
+            return;
+
+        }
+
+        dt->mm = 0;
+
+        if (++dt->hh < 24) {
+
+            return;
+
+        }
+
+        dt->hh = 0;
+        dt->WD = (dt->WD % 7) + 1;
+
+        if (++dt->DD <= get_number_of_days_in_month(dt->MM, dt->YY)) {
+
+            return;
+
+        }
+
+        dt->DD = 1;
+
+        if (++dt->MM <= 12) {
+
+            return;
+
+        }
+
+        dt->MM = 1;
+        dt->YY = (dt->YY + 1) % 100;
+
+    }
+
+#endif /* ((DATETIME_DISCIPLINE_SOFT_CLOCK == 1) || (DATETIME_USE_RTC_SQW == 1)) */
+
 /**
  * @brief Initializes the datetime module
  *
  * This initializes the datetime module by setting up the
  * {@link i2c_rtc.h RTC} module to be able to read the datetime from the RTC
- * later on.
+ * later on. The datetime is considered to be valid when the clock of the RTC
+ * has not been halted.
  *
  * @see i2c_rtc_init()
+ * @see i2c_rtc_was_halted()
+ * @see datetime_valid
  */
 void datetime_init()
 {
@@ -156,11 +794,34 @@ void datetime_init()
 
     if (!i2c_rtc_init(&i2c_rtc_error)) {
 
-        // TODO Log
-        //log_main("RTC init failed\n");
+        health_count(HEALTH_RTC_ERRORS);
+
+    } else {
+
+        datetime_valid = !i2c_rtc_was_halted();
 
     }
 
+    #if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+        datetime_apply_drift();
+
+    #endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
+    #if (DATETIME_USE_RTC_SQW == 1)
+
+        DDR(DATETIME_SQW_INPUT) &= ~_BV(BIT(DATETIME_SQW_INPUT));
+        PORT(DATETIME_SQW_INPUT) |= _BV(BIT(DATETIME_SQW_INPUT));
+
+        /*
+         * The registers of the RTC are updated with the falling edge
+         */
+        EICRA = (EICRA & ~(_BV(ISC01) | _BV(ISC00))) | _BV(ISC01);
+        EIFR = _BV(INTF0);
+        EIMSK |= _BV(INT0);
+
+    #endif /* (DATETIME_USE_RTC_SQW == 1) */
+
 }
 
 /**
@@ -228,6 +889,154 @@ bool datetime_validate(const datetime_t* datetime) {
 
 }
 
+#if ((DATETIME_DISCIPLINE_SOFT_CLOCK == 1) || (DATETIME_USE_RTC_SQW == 1))
+
+    /**
+     * @brief Updates the datetime based upon the software clock alone
+     *
+     * The software clock advances the minutes on its own, once its seconds
+     * have reached 60.
+     *
+     * @see datetime_add_minute()
+     * @see datetime_handle()
+     */
+    static void datetime_advance_soft_clock()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+
+        uint8_t seconds = soft_seconds;
+
+        if (seconds >= 60) {
+
+            seconds -= 60;
+            soft_seconds = seconds;
+
+        }
+
+        SREG = sreg;
+
+        if (seconds < datetime.ss) {
+
+            datetime_add_minute(&datetime);
+
+        }
+
+        datetime.ss = seconds;
+
+    }
+
+#endif /* ((DATETIME_DISCIPLINE_SOFT_CLOCK == 1) || (DATETIME_USE_RTC_SQW == 1)) */
+
+#if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+    /**
+     * @brief Updates the datetime based upon the disciplined software clock
+     *
+     * The software clock advances the minutes on its own. A read of the RTC
+     * is only started every DATETIME_READ_INTERVAL_DISCIPLINED seconds, in
+     * which case the software clock is set to its time once the read has
+     * been completed.
+     *
+     * @see DATETIME_READ_INTERVAL_DISCIPLINED
+     * @see datetime_advance_soft_clock()
+     * @see datetime_handle()
+     */
+    static void datetime_handle_disciplined()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t ticks = soft_ticks;
+        SREG = sreg;
+
+        datetime_advance_soft_clock();
+
+        if ((uint16_t)(ticks - read_ticks) >= DATETIME_READ_INTERVAL_DISCIPLINED) {
+
+            i2c_rtc_read_start();
+
+        }
+
+    }
+
+#endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
+/**
+ * @brief Checks for new minutes and/or hours and acts accordingly
+ *
+ * The new time is pushed out whenever a new minute has begun. Furthermore
+ * the DCF77 decoding is (re)enabled once a new hour begins. During the last
+ * second of a minute the display is prepared for the next one, so it changes
+ * over right when datetime_ISR() rolls the seconds over.
+ *
+ * @see user_setNewTime()
+ * @see user_armNewTime()
+ * @see dcf77_enable()
+ */
+static void datetime_handle_transitions()
+{
+
+    static uint8_t last_hour = 0xff;
+    static uint8_t last_minute = 0xff;
+    static uint8_t armed_minute = 0xff;
+
+    /*
+     * Check whether new minute has begun
+     */
+    if (last_minute != datetime.mm) {
+
+        // TODO: Set time directly without using user module
+        user_setNewTime(&datetime);
+        last_minute = datetime.mm;
+
+        /*
+         * Check whether new hour has begun
+         */
+        if (last_hour != datetime.hh) {
+
+            #if (ENABLE_DCF_SUPPORT == 1)
+
+                dcf77_enable();
+
+            #endif
+
+            last_hour = datetime.hh;
+
+        }
+
+    }
+
+    /*
+     * Prepare the display for the next minute during its last second, the
+     * display only depends upon the time itself
+     */
+    if (datetime.ss == 59 && armed_minute != datetime.mm) {
+
+        datetime_t next = datetime;
+
+        next.ss = 0;
+
+        if (++next.mm == 60) {
+
+            next.mm = 0;
+
+            if (++next.hh == 24) {
+
+                next.hh = 0;
+
+            }
+
+        }
+
+        user_armNewTime(&next);
+        armed_minute = datetime.mm;
+
+    }
+
+}
+
 /**
  * @brief Handles the synchronization between the RTC and the software clock
  *
@@ -245,107 +1054,185 @@ bool datetime_validate(const datetime_t* datetime) {
  *   software clock runs too fast, so that the software clock is updated less
  *   often.
  *
+ * Once the drift of the software clock has been learned (see
+ * DATETIME_DISCIPLINE_SOFT_CLOCK), the software clock keeps track of the
+ * transitions to new minutes on its own instead, and the RTC is only read
+ * every DATETIME_READ_INTERVAL_DISCIPLINED seconds.
+ *
+ * The RTC is read in the background (see i2c_rtc_read_start()), so this
+ * never waits for the I2C bus. The result is taken over the next time this
+ * function is called after the read has been completed. In the meantime
+ * the software clock is used.
+ *
  * This function also (re)enables the DCF77 decoding once a new hour begins.
  *
  * @see READ_DATETIME_INTERVAL
  * @see soft_seconds
- * @see i2c_rtc_read()
- * @see dcf77_enable()
+ * @see i2c_rtc_read_start()
+ * @see i2c_rtc_read_get()
+ * @see datetime_handle_transitions()
  */
 void datetime_handle()
 {
 
-    static uint8_t last_hour = 0xff;
-    static uint8_t last_minute = 0xff;
     static uint8_t last_seconds = 0xff;
 
     static uint8_t next_read_seconds = 0;
 
+    #if (DATETIME_USE_RTC_SQW == 1)
+
+        static bool rtc_read = false;
+
+    #endif /* (DATETIME_USE_RTC_SQW == 1) */
+
     uint8_t softclock_too_fast_seconds = 0;
 
-    uint8_t rtc;
+    datetime_t rtc;
+
+    #if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+        datetime_handle_sync();
+
+    #endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+    /*
+     * Check whether a read of the RTC has been completed in the meantime
+     */
+    i2c_master_transfer_state_t state = i2c_rtc_read_get(&rtc);
 
-    if (last_seconds != soft_seconds) {
+    if (state == I2C_MASTER_TRANSFER_QUEUED
+            || state == I2C_MASTER_TRANSFER_BUSY) {
+
+        return;
+
+    }
+
+    if (datetime_read_discard && state != I2C_MASTER_TRANSFER_IDLE) {
+
+        datetime_read_discard = false;
+        state = I2C_MASTER_TRANSFER_IDLE;
+
+    }
+
+    if (state == I2C_MASTER_TRANSFER_DONE) {
+
+        datetime = rtc;
+
+        #if (DATETIME_USE_RTC_SQW == 1)
+
+            rtc_read = true;
+
+        #endif /* (DATETIME_USE_RTC_SQW == 1) */
+
+        #if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+            datetime_measure_drift();
+
+        #endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
+        datetime_handle_transitions();
+
+        /*
+         * Check whether software clock is running too fast
+         */
+        if (last_seconds != 0xff && soft_seconds > datetime.ss) {
+
+            softclock_too_fast_seconds = soft_seconds - datetime.ss;
+
+        }
+
+        last_seconds = soft_seconds = datetime.ss;
 
         /*
-         * Check if RTC should be (re)read again
+         * Set next time the RTC should be (re)read
          */
-        if (soft_seconds >= next_read_seconds) {
+        if (softclock_too_fast_seconds > 0) {
 
-            rtc = i2c_rtc_read(&datetime);
+            next_read_seconds = soft_seconds + READ_DATETIME_INTERVAL
+                  - softclock_too_fast_seconds;
 
         } else {
 
-            datetime.ss = soft_seconds;
-            rtc = true;
+            next_read_seconds = soft_seconds + READ_DATETIME_INTERVAL;
 
         }
 
-        if (rtc) {
+        if (next_read_seconds >= 60) {
 
-            /*
-             * Check whether new minute has begun
-             */
-            if (last_minute != datetime.mm) {
+            next_read_seconds = 0;
 
-                // TODO: Set time directly without using user module
-                user_setNewTime(&datetime);
-                last_minute = datetime.mm;
+        }
 
-                /*
-                 * Check whether new hour has begun
-                 */
-                if (last_hour != datetime.hh) {
+        return;
 
-                    #if (ENABLE_DCF_SUPPORT == 1)
+    }
 
-                        dcf77_enable();
+    if (last_seconds == soft_seconds) {
 
-                    #endif
+        return;
 
-                    last_hour = datetime.hh;
+    }
 
-                }
+    #if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
 
-            }
+        /*
+         * The very first time the RTC is read in any case
+         */
+        if (last_seconds != 0xff && datetime_is_disciplined()) {
 
-            /*
-             * Check whether software clock is running too fast
-             */
-            if (last_seconds != 0xff && soft_seconds > datetime.ss) {
+            datetime_handle_disciplined();
+            datetime_handle_transitions();
 
-                softclock_too_fast_seconds = soft_seconds - datetime.ss;
+            last_seconds = soft_seconds;
 
-            }
+            return;
 
-            last_seconds = soft_seconds = datetime.ss;
+        }
 
-            /*
-             * Set next time the RTC should be (re)read
-             */
-            if (softclock_too_fast_seconds > 0) {
+    #endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
 
-                next_read_seconds = soft_seconds + READ_DATETIME_INTERVAL
-                      - softclock_too_fast_seconds;
+    #if (DATETIME_USE_RTC_SQW == 1)
 
-            } else {
+        /*
+         * The software clock is locked to the RTC, so it only needs to be
+         * read until it has succeeded once
+         */
+        if (rtc_read) {
 
-                next_read_seconds = soft_seconds + READ_DATETIME_INTERVAL;
+            datetime_advance_soft_clock();
+            datetime_handle_transitions();
 
-            }
+            last_seconds = soft_seconds;
 
-            if (next_read_seconds >= 60) {
+            return;
 
-                next_read_seconds = 0;
+        }
 
-            }
+    #endif /* (DATETIME_USE_RTC_SQW == 1) */
 
-        } else {
+    if (state == I2C_MASTER_TRANSFER_FAILED) {
 
-            // TODO Log
-            //log_main("RTC error\n");
+        health_count(HEALTH_RTC_ERRORS);
 
-        }
+    /*
+     * Check if RTC should be (re)read again, the result is taken over once
+     * the read has been completed
+     */
+    } else if (soft_seconds >= next_read_seconds && i2c_rtc_read_start()) {
+
+        return;
+
+    }
+
+    datetime.ss = soft_seconds;
+    datetime_handle_transitions();
+
+    last_seconds = soft_seconds;
+    next_read_seconds = soft_seconds + READ_DATETIME_INTERVAL;
+
+    if (next_read_seconds >= 60) {
+
+        next_read_seconds = 0;
 
     }
 
@@ -379,15 +1266,33 @@ bool datetime_set(datetime_t* dt)
 
         if (status) {
 
+            /*
+             * A read of the RTC that is still pending would return the old
+             * date and time
+             */
+            datetime_t rtc;
+            i2c_master_transfer_state_t state = i2c_rtc_read_get(&rtc);
+
+            datetime_read_discard = (state == I2C_MASTER_TRANSFER_QUEUED)
+                || (state == I2C_MASTER_TRANSFER_BUSY);
+
+            #if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+                datetime_step_drift(dt);
+
+            #endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
             datetime = *dt;
+            datetime_valid = true;
             soft_seconds = dt->ss;
+
             user_setNewTime(dt);
 
             return true;
 
         } else {
 
-            // TODO Log unable to write to RTC
+            health_count(HEALTH_RTC_ERRORS);
 
         }
 
@@ -402,6 +1307,106 @@ bool datetime_set(datetime_t* dt)
 
 }
 
+#if (ENABLE_WARM_RESTART == 1)
+
+/**
+ * @brief Restores the datetime after a warm restart
+ *
+ * In contrast to datetime_set() the RTC is not written, as it has kept
+ * running anyway. The datetime is shown right away, and corrected by the
+ * first read of the RTC, which is started with the next tick of the software
+ * clock.
+ *
+ * @param dt The datetime from before the reset, needs to be valid
+ *
+ * @see restart_restore()
+ * @see user_setNewTime()
+ */
+void datetime_restore(const datetime_t* dt)
+{
+
+    datetime = *dt;
+    datetime_valid = true;
+    soft_seconds = dt->ss;
+
+    user_setNewTime(dt);
+
+}
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+/**
+ * @brief Synchronizes the software clock with an external reference
+ *
+ * This is given the datetime of the reference (as seconds since 2000-01-01,
+ * see datetime_get_epoch()) along with the time that has passed since the
+ * reference entered this second. If the deviation of the software clock is
+ * within DATETIME_SYNC_TOLERANCE_MS, nothing is changed at all. Otherwise
+ * the next tick of the software clock is moved to the next boundary of the
+ * reference's second (see timer_align_1hz()), where the datetime is taken
+ * over by means of datetime_set() (see datetime_handle_sync()).
+ *
+ * @param epoch Seconds since 2000-01-01 00:00:00 of the reference
+ * @param age_ms Milliseconds the reference has already spent within this
+ * second, including the latency of the transmission
+ *
+ * @return True if the datetime is valid, false otherwise
+ *
+ * @see uart_protocol_beacon_handle()
+ * @see DATETIME_SYNC_GUARD_MS
+ */
+bool datetime_sync(uint32_t epoch, uint16_t age_ms)
+{
+
+    epoch += age_ms / 1000;
+    age_ms %= 1000;
+
+    datetime_t dt;
+
+    datetime_from_epoch(epoch, &dt);
+
+    if (!datetime_validate(&dt)) {
+
+        return false;
+
+    }
+
+    if (datetime_valid && !datetime_sync_pending) {
+
+        int32_t seconds = datetime_get_epoch() - epoch;
+
+        if (seconds >= -1 && seconds <= 1) {
+
+            int16_t offset = seconds * 1000 + datetime_get_subsecond_ms()
+                + DATETIME_SYNC_GUARD_MS - age_ms;
+
+            if (offset >= -DATETIME_SYNC_TOLERANCE_MS && offset <= DATETIME_SYNC_TOLERANCE_MS) {
+
+                return true;
+
+            }
+
+        }
+
+    }
+
+    datetime_from_epoch(epoch + 1, &datetime_sync_target);
+
+    uint8_t sreg = SREG;
+    cli();
+    timer_align_1hz(1000 - age_ms);
+    datetime_sync_seconds = soft_seconds;
+    datetime_sync_pending = true;
+    SREG = sreg;
+
+    return true;
+
+}
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
 /**
  * @brief Returns a reference to the date and time information used internally
  *
@@ -419,19 +1424,156 @@ const datetime_t* datetime_get()
 
 }
 
+/**
+ * @brief Returns the current date and time as seconds since 2000-01-01
+ *
+ * This is derived from the same information as returned by datetime_get().
+ * The conversion of the date into days is cached and only performed again
+ * once the date has changed, so usually this only takes a couple of
+ * multiplications. It is meant for calculations spanning multiple days,
+ * e.g. comparing timestamps, without dealing with the calendar.
+ *
+ * @return Seconds since 2000-01-01 00:00:00
+ *
+ * @see datetime_get_days()
+ * @see datetime_epoch_days
+ * @see datetime_get_subsecond_ms()
+ */
+uint32_t datetime_get_epoch()
+{
+
+    if (datetime.DD != datetime_epoch_date.DD
+            || datetime.MM != datetime_epoch_date.MM
+            || datetime.YY != datetime_epoch_date.YY) {
+
+        datetime_epoch_date = datetime;
+        datetime_epoch_days = datetime_get_days(&datetime);
+
+    }
+
+    return (uint32_t)datetime_epoch_days * 86400 + datetime_get_seconds_of_day(&datetime);
+
+}
+
+/**
+ * @brief Returns the milliseconds within the current second
+ *
+ * This is the time that has passed since the software clock has ticked last
+ * (see datetime_ISR()), which makes it possible to tell points in time apart
+ * that lie within the same second. It is limited to 999.
+ *
+ * @return Milliseconds since the last tick of the software clock
+ *
+ * @see datetime_tick_ms
+ * @see datetime_get_epoch()
+ */
+uint16_t datetime_get_subsecond_ms()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t ms = timer_get_ms() - datetime_tick_ms;
+    SREG = sreg;
+
+    if (ms > 999) {
+
+        ms = 999;
+
+    }
+
+    return ms;
+
+}
+
+/**
+ * @brief Returns whether the date and time information is known to be valid
+ *
+ * The information returned by datetime_get() is meaningless unless this
+ * returns true, e.g. after the RTC has lost its power.
+ *
+ * @return True if the datetime is valid, false otherwise
+ *
+ * @see datetime_valid
+ */
+bool datetime_is_valid()
+{
+
+    return datetime_valid;
+
+}
+
 /**
  * @brief ISR of the datetime module
  *
  * This is expected to be executed once a second and simply increments
  * {@link #soft_seconds} by one. The date and time information itself is
  * then updated by {@link #datetime_handle()} asynchronically in the
- * background.
+ * background, which is triggered by posting `EVENT_DATETIME`.
+ *
+ * If the software clock is disciplined, the learned drift is accumulated and
+ * a second is inserted and/or skipped whenever the accumulated drift
+ * reaches a full second.
+ *
+ * The time of the tick is kept in datetime_tick_ms, see
+ * datetime_get_subsecond_ms(). Once the seconds roll over to a new minute,
+ * a display frame armed for it is handed over right away.
  *
  * @see datetime_handle()
+ * @see display_commitArmedFrame()
+ * @see DATETIME_DISCIPLINE_SOFT_CLOCK
  */
 void datetime_ISR()
 {
 
+    datetime_tick_ms = timer_get_ms();
     soft_seconds++;
 
+    #if (DATETIME_DISCIPLINE_SOFT_CLOCK == 1)
+
+        static int32_t drift_accumulator;
+
+        soft_ticks++;
+        drift_accumulator += soft_drift;
+
+        if (drift_accumulator >= 65536) {
+
+            drift_accumulator -= 65536;
+            soft_seconds++;
+
+        } else if (drift_accumulator <= -65536) {
+
+            drift_accumulator += 65536;
+            soft_seconds--;
+
+        }
+
+    #endif /* (DATETIME_DISCIPLINE_SOFT_CLOCK == 1) */
+
+    if (soft_seconds >= 60) {
+
+        display_commitArmedFrame();
+
+    }
+
+    event_post(EVENT_DATETIME);
+
+}
+
+#if (DATETIME_USE_RTC_SQW == 1)
+
+/**
+ * @brief Handler for the falling edges of the square wave put out by the RTC
+ *
+ * This drives the software clock instead of the timer, see
+ * DATETIME_USE_RTC_SQW.
+ *
+ * @see datetime_ISR()
+ */
+ISR(INT0_vect)
+{
+
+    datetime_ISR();
+
 }
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
@@ -95,6 +95,96 @@ typedef struct
 
 } datetime_t;
 
+/**
+ * @brief Defines whether the software clock is driven by the RTC itself
+ *
+ * When enabled, the RTC puts out a square wave of 1 Hz on its SQW/OUT pin,
+ * which needs to be connected to INT0 (see DATETIME_SQW_INPUT). The software
+ * clock then advances with each falling edge of it, i.e. whenever the RTC
+ * updates its registers, instead of being derived from the timer. As it
+ * stays locked to the RTC, the RTC is only read once after a reset, and the
+ * software clock keeps track of minutes, hours and days on its own.
+ *
+ * @note INT0 is the pin otherwise used by USER_AUXPOWER, so
+ * `ENABLE_AUXPOWER_SUPPORT` needs to be disabled. The software clock can't be
+ * aligned to time beacons in this case either, so
+ * `ENABLE_UART_PROTOCOL_BEACON` needs to be disabled, too.
+ *
+ * @see datetime_ISR()
+ * @see datetime_handle()
+ */
+#define DATETIME_USE_RTC_SQW 0
+
+/**
+ * @brief Defines whether the software clock should be disciplined
+ *
+ * When enabled, the drift of the software clock (see datetime_ISR()) against
+ * the RTC is measured continuously and stored persistently (see
+ * datetime_prefs_t). Once it has been learned, the software clock is
+ * corrected accordingly and keeps track of minutes, hours and days on its
+ * own, so the RTC only needs to be read every
+ * DATETIME_READ_INTERVAL_DISCIPLINED seconds.
+ *
+ * @note There is no drift to learn when the software clock is driven by the
+ * RTC (DATETIME_USE_RTC_SQW), so this is disabled in this case.
+ *
+ * @see datetime_prefs_t
+ * @see datetime_handle()
+ */
+#if (DATETIME_USE_RTC_SQW == 1)
+
+    #define DATETIME_DISCIPLINE_SOFT_CLOCK 0
+
+#else
+
+    #define DATETIME_DISCIPLINE_SOFT_CLOCK 1
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
+
+/**
+ * @brief Data of the datetime module that is stored persistently in EEPROM
+ *
+ * The default values are defined in DATETIMEEEPROMPARAMS_DEFAULT.
+ *
+ * @see DATETIMEEEPROMPARAMS_DEFAULT
+ * @see prefs_t::datetime_prefs
+ */
+typedef struct {
+
+    /**
+     * @brief Drift of the software clock against the RTC
+     *
+     * This is the amount of time the software clock needs to be corrected by
+     * each second in units of 1/65536 s, i.e. a positive value indicates that
+     * the software clock is running too slow.
+     */
+    int16_t drift;
+
+    /**
+     * @brief Number of measurements the drift is based on
+     *
+     * This saturates at DATETIME_DRIFT_SAMPLES, at which point the drift is
+     * considered to be learned.
+     *
+     * @see DATETIME_DRIFT_SAMPLES
+     */
+    uint8_t samples;
+
+} datetime_prefs_t;
+
+/**
+ * @brief Default values of this module that should be stored persistently
+ *
+ * The drift has not been measured yet.
+ *
+ * @see datetime_prefs_t
+ * @see preferences.h
+ */
+#define DATETIMEEEPROMPARAMS_DEFAULT { \
+    0, \
+    0, \
+}
+
 extern void datetime_init();
 
 extern bool datetime_validate(const datetime_t* datetime);
@@ -102,8 +192,21 @@ extern bool datetime_validate(const datetime_t* datetime);
 extern void datetime_handle();
 
 extern bool datetime_set(datetime_t* dt);
+extern bool datetime_sync(uint32_t epoch, uint16_t age_ms);
 extern const datetime_t* datetime_get();
 
+extern bool datetime_is_valid();
+
+extern uint32_t datetime_get_epoch();
+
+extern uint16_t datetime_get_subsecond_ms();
+
 extern void datetime_ISR();
 
+#if (ENABLE_WARM_RESTART == 1)
+
+    extern void datetime_restore(const datetime_t* dt);
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
 #endif /* _WC_DATETIME_H_ */
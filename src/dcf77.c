@@ -33,6 +33,12 @@
  * pull up resistor of the microcontroller is needed. For further details take
  * a look at dcf77_check_receiver_type().
  *
+ * The signal is either polled by dcf77_ISR() or, when
+ * DCF77_USE_EDGE_TIMESTAMPS is enabled, decoded by timestamping the edges of
+ * the input pin within `ISR(DCF_INPUT_PCINT_vect)`. In both cases the length
+ * of the pause is stored in DCF_Struct::PauseCounter and analyzed by
+ * dcf77_check().
+ *
  * [1]: https://en.wikipedia.org/wiki/DCF77
  * [2]: https://en.wikipedia.org/wiki/DCF77#Time_code_interpretation
  *
@@ -41,14 +47,15 @@
 
 #include <inttypes.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <stdbool.h>
-#include <stdio.h>
 
 #include "config.h"
 #include "dcf77.h"
-#include "format.h"
-#include "uart.h"
+#include "event.h"
+#include "log.h"
 #include "ports.h"
+#include "timer.h"
 
 /*
  * Only compile the following if DCF77 functionality is enabled
@@ -68,7 +75,7 @@
      *
      * @see LOG_DCF77
      */
-    #define log_dcf77(x) uart_puts_P(x)
+    #define log_dcf77(x) log_text_P(x)
 
 #else
 
@@ -178,6 +185,9 @@ static inline bool getFlag(FLAGS flag)
 /**
  * @brief Sets the value for an individual flag
  *
+ * Setting the CHECK flag also posts `EVENT_DCF77`, so the main loop will
+ * invoke `dcf77_get_datetime()`.
+ *
  * @see FLAGS
  * @see getFlag()
  * @see clearFlag()
@@ -187,6 +197,12 @@ static inline void setFlag(FLAGS flag)
 
     DCF_FLAG |= _BV(flag);
 
+    if (flag == CHECK) {
+
+        event_post(EVENT_DCF77);
+
+    }
+
 }
 
 /**
@@ -210,6 +226,34 @@ static inline void clearFlag(FLAGS flag)
  */
 #define DCF_INPUT PORTB, 7
 
+#if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+    /**
+     * @brief Pin change mask register of the DCF77 receiver connection
+     *
+     * @note This needs to match the port defined in DCF_INPUT. The bit
+     * within the register is the same as the one within the port.
+     *
+     * @see DCF_INPUT
+     */
+    #define DCF_INPUT_PCMSK PCMSK0
+
+    /**
+     * @brief Pin change interrupt enable bit of the DCF77 receiver connection
+     *
+     * @see DCF_INPUT
+     */
+    #define DCF_INPUT_PCIE PCIE0
+
+    /**
+     * @brief Pin change interrupt vector of the DCF77 receiver connection
+     *
+     * @see DCF_INPUT
+     */
+    #define DCF_INPUT_PCINT_vect PCINT0_vect
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
 /**
  * @brief Port and pin of where to output the DCF77 signal
  *
@@ -231,7 +275,7 @@ static inline void clearFlag(FLAGS flag)
  * These variables are needed in order to successfully decode the DCF77 time
  * signal. They are combined in a struct.
  */
-volatile typedef struct {
+typedef volatile struct {
 
     /**
      * @brief Counter for the pause length
@@ -375,24 +419,48 @@ static DCF_Struct DCF;
 static bool enable_dcf77_ISR;
 
 /**
- * @brief Counter keeping track of the amount of low pulses received
- *
- * This is used during the initialization phase where the type of the receiver
- * is determined.
+ * @brief Statistics about the reception of the DCF77 signal
  *
- * @see dcf77_check_receiver_type()
+ * @see dcf77_get_stats()
+ * @see dcf77_reset_stats()
  */
-static uint8_t count_low;
+static dcf77_stats_t dcf77_stats;
 
 /**
- * @brief Counter keeping track of the amount of high pulses received
+ * @brief Number of seconds since the decoding has been enabled
  *
- * This is used during the initialization phase where the type of the receiver
- * is determined.
+ * This is incremented by dcf77_stats_ISR() while the decoding is enabled and
+ * taken over into dcf77_stats_t::sync_duration once the time has been
+ * synchronized successfully.
  *
- * @see dcf77_check_receiver_type()
+ * @see dcf77_stats_ISR()
+ * @see dcf77_enable()
  */
-static uint8_t count_high;
+static volatile uint16_t dcf77_attempt_duration;
+
+#if (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT)
+
+    /**
+     * @brief Counter keeping track of the amount of low pulses received
+     *
+     * This is used during the initialization phase where the type of the
+     * receiver is determined.
+     *
+     * @see dcf77_check_receiver_type()
+     */
+    static uint8_t count_low;
+
+    /**
+     * @brief Counter keeping track of the amount of high pulses received
+     *
+     * This is used during the initialization phase where the type of the
+     * receiver is determined.
+     *
+     * @see dcf77_check_receiver_type()
+     */
+    static uint8_t count_high;
+
+#endif /* (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT) */
 
 /**
  * @brief Used for converting received data from BCD to its decimal
@@ -411,7 +479,180 @@ static uint8_t count_high;
  *
  * @see DCF_Struct::BCDShifter
  */
-const static uint8_t BcdWeights[] = {1, 2, 4, 8, 10, 20, 40, 80};
+static const uint8_t BcdWeights[] = {1, 2, 4, 8, 10, 20, 40, 80};
+
+#if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+    /**
+     * @brief Timestamp of the last edge on the input pin
+     *
+     * @see timer_get_ms()
+     * @see ISR(DCF_INPUT_PCINT_vect)
+     */
+    static uint16_t edge_time;
+
+    /**
+     * @brief Timestamp of the beginning of the current pause
+     *
+     * This is only valid when edge_pause_valid is set.
+     *
+     * @see edge_pause_valid
+     * @see dcf77_edge_transition()
+     */
+    static uint16_t edge_pause_start;
+
+    /**
+     * @brief Level of the signal since the last edge
+     *
+     * This is the (normalized) value returned by dcf77_get_signal(), i.e. it
+     * is true during a pause and false during a pulse.
+     *
+     * @see dcf77_get_signal()
+     */
+    static bool edge_level;
+
+    /**
+     * @brief Level of the signal with glitches filtered out
+     *
+     * @see DCF77_EDGE_GLITCH_MS
+     * @see dcf77_edge_transition()
+     */
+    static bool edge_stable_level;
+
+    /**
+     * @brief Indicates whether edge_pause_start contains a valid timestamp
+     *
+     * This is cleared whenever the decoding is (re)started, so that the first
+     * pause, which has been caught somewhere in between, won't be analyzed.
+     *
+     * @see edge_pause_start
+     */
+    static bool edge_pause_valid;
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+/**
+ * @brief Returns the current level of the DCF77 signal
+ *
+ * This reads in the input pin and negates it in case of an active low
+ * receiver, so that the result is independent of the receiver type. When the
+ * receiver type is known at build time, this boils down to a single read of
+ * the pin.
+ *
+ * @return True during a pause, false during a pulse
+ *
+ * @see FLAGS::HIGH_ACTIVE
+ * @see DCF77_RECEIVER_TYPE
+ */
+static inline bool dcf77_get_signal()
+{
+
+    bool dcf_signal = (PIN(DCF_INPUT) & _BV(BIT(DCF_INPUT)));
+
+    #if (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_HIGH_ACTIVE)
+
+        return dcf_signal;
+
+    #elif (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_LOW_ACTIVE)
+
+        return !dcf_signal;
+
+    #else
+
+        if (getFlag(HIGH_ACTIVE)) {
+
+            return dcf_signal;
+
+        }
+
+        return !dcf_signal;
+
+    #endif /* (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_HIGH_ACTIVE) */
+
+}
+
+#if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+    /**
+     * @brief Resets the state of the edge based decoding
+     *
+     * This takes over the current level of the signal and discards any
+     * pause that might still be in progress. It needs to be called
+     * whenever the decoding is (re)started.
+     *
+     * @see dcf77_enable()
+     * @see ISR(DCF_INPUT_PCINT_vect)
+     */
+    static void dcf77_edge_reset()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+
+        edge_time = timer_get_ms();
+        edge_level = dcf77_get_signal();
+        edge_stable_level = edge_level;
+        edge_pause_valid = false;
+
+        SREG = sreg;
+
+    }
+
+    /**
+     * @brief Handles a transition of the glitch filtered signal
+     *
+     * Once a pause is over, its length is converted into units of 10 ms and
+     * stored within DCF_Struct::PauseCounter, so it can be analyzed by
+     * dcf77_check() just like in case of the polled decoding.
+     *
+     * @param level The new level of the signal, see dcf77_get_signal()
+     * @param time Timestamp at which the new level has been entered
+     *
+     * @see ISR(DCF_INPUT_PCINT_vect)
+     * @see dcf77_check()
+     */
+    static void dcf77_edge_transition(bool level, uint16_t time)
+    {
+
+        if (level) {
+
+            edge_pause_start = time;
+            edge_pause_valid = true;
+
+            return;
+
+        }
+
+        if (edge_pause_valid) {
+
+            uint16_t length = ((uint16_t)(time - edge_pause_start) + 5) / 10;
+
+            DCF.PauseCounter = (length > UINT8_MAX) ? UINT8_MAX : length;
+            setFlag(CHECK);
+
+        }
+
+    }
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+/**
+ * @brief Increments a counter of dcf77_stats without letting it overflow
+ *
+ * @param counter Pointer to the counter to increment
+ *
+ * @see dcf77_stats
+ */
+static inline void dcf77_stats_inc(uint16_t* counter)
+{
+
+    if (*counter != UINT16_MAX) {
+
+        (*counter)++;
+
+    }
+
+}
 
 /**
  * @brief Enables the DCF77 reception
@@ -426,6 +667,22 @@ const static uint8_t BcdWeights[] = {1, 2, 4, 8, 10, 20, 40, 80};
 void dcf77_enable()
 {
 
+    if (!enable_dcf77_ISR) {
+
+        dcf77_attempt_duration = 0;
+
+    }
+
+    #if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+        if (getFlag(DEFINED)) {
+
+            dcf77_edge_reset();
+
+        }
+
+    #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
     enable_dcf77_ISR = true;
 
 }
@@ -461,7 +718,7 @@ void dcf77_disable()
 static void dcf77_reset()
 {
 
-    log_dcf77("DCF77 Reset\n");
+    log_dcf77("DCF77 Reset");
 
     DCF.Parity = 0;
     DCF.PauseCounter = 0;
@@ -479,248 +736,288 @@ static void dcf77_reset()
 
 }
 
-/**
- * @brief Determines what kind of receiver is connected to the microcontroller
- *
- * This function detects the kind of receiver connected to the microcontroller,
- * which includes the detection of whether the module is active high or low and
- * whether the internal pull up resistor is needed or not.
- *
- * This works by trying out all possible combinations and looking whether
- * transitions on the DCF77 pin occur.
- *
- * This function is only used during the initialization phase. Once the type of
- * the receiver has been determined, it won't change during runtime anymore.
- *
- * @see FLAGS
- */
-static void dcf77_check_receiver_type()
-{
+#if (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT)
 
-    /*
-     * Keeps track of how often this method was already called without enabling
-     * and/or disabling the pull up resistor
-     */
-    static uint8_t count_pass;
-
-    /*
-     * Keeps track of how often the pull up resistor was switched on and/or off
+    /**
+     * @brief Determines what kind of receiver is connected to the microcontroller
+     *
+     * This function detects the kind of receiver connected to the microcontroller,
+     * which includes the detection of whether the module is active high or low and
+     * whether the internal pull up resistor is needed or not.
+     *
+     * This works by trying out all possible combinations and looking whether
+     * transitions on the DCF77 pin occur.
+     *
+     * This function is only used during the initialization phase. Once the type of
+     * the receiver has been determined, it won't change during runtime anymore.
+     *
+     * @see FLAGS
      */
-    static uint8_t count_switch;
-
-    /*
-    * Check whether one second has passed
-    */
-    if (count_low + count_high >= 100) {
-
-        #if (LOG_DCF77 == 1)
-
-            char log_text[8];
-
-            sprintf_P(log_text, fmt_unsigned_decimal, count_low);
-            uart_puts(log_text);
-            uart_puts(" ");
+    static void dcf77_check_receiver_type()
+    {
 
-            sprintf_P(log_text, fmt_unsigned_decimal, count_high);
-            uart_puts(log_text);
-            uart_puts(" ");
+        /*
+         * Keeps track of how often this method was already called without enabling
+         * and/or disabling the pull up resistor
+         */
+        static uint8_t count_pass;
 
-            sprintf_P(log_text, fmt_unsigned_decimal, count_high + count_low);
-            uart_puts(log_text);
-            uart_puts(" ");
+        /*
+         * Keeps track of how often the pull up resistor was switched on and/or off
+         */
+        static uint8_t count_switch;
 
-            sprintf_P(log_text, fmt_unsigned_decimal, count_pass);
-            uart_puts(log_text);
-            uart_puts(" ");
+        /*
+        * Check whether one second has passed
+        */
+        if (count_low + count_high >= 100) {
 
-            sprintf_P(log_text, fmt_unsigned_decimal, count_switch);
-            uart_puts(log_text);
-            uart_puts("\n");
+            #if (LOG_DCF77 == 1)
 
-        #endif
+                log_put(LOG_EVENT_DCF77_DETECT, count_low, count_high, count_pass);
 
-        /*
-         * Check if at least one of both counters is low
-         */
-        if ((count_low == 0) || (count_high == 0)) {
+            #endif
 
-            /**
-             * Check whether this was already tried 20 times
+            /*
+             * Check if at least one of both counters is low
              */
-            if (++count_pass == 20) {
+            if ((count_low == 0) || (count_high == 0)) {
 
-                /*
-                 * Reset counter for keeping track of how often this function
-                 * was called with the same setting for the pull up resistor
+                /**
+                 * Check whether this was already tried 20 times
                  */
-                count_pass = 0;
-
-                /*
-                 * Increase the counter for keeping track of how often the
-                 * setting for the pull up resistor has been changed, as we
-                 * are going to change it immediately.
-                 */
-                count_switch++;
-
-                /*
-                 * Check whether the pull up resistor is activated right now
-                 */
-                if ((PIN(DCF_INPUT) & _BV(BIT(DCF_INPUT)))) {
+                if (++count_pass == 20) {
 
                     /*
-                     * Deactivate pull up resistor
+                     * Reset counter for keeping track of how often this function
+                     * was called with the same setting for the pull up resistor
                      */
-                    PORT(DCF_INPUT) &= ~_BV(BIT(DCF_INPUT));
+                    count_pass = 0;
 
                     /*
-                     * Output logging information regarding the change
+                     * Increase the counter for keeping track of how often the
+                     * setting for the pull up resistor has been changed, as we
+                     * are going to change it immediately.
                      */
-                    log_dcf77(" Pull-UP deactivated\n");
-
-                } else {
+                    count_switch++;
 
                     /*
-                     * Activate pull up resistor
+                     * Check whether the pull up resistor is activated right now
                      */
-                    PORT(DCF_INPUT) |= _BV(BIT(DCF_INPUT));
+                    if ((PIN(DCF_INPUT) & _BV(BIT(DCF_INPUT)))) {
 
-                    /*
-                     * Output logging information regarding the change
-                     */
-                    log_dcf77(" Pull-UP activated\n");
+                        /*
+                         * Deactivate pull up resistor
+                         */
+                        PORT(DCF_INPUT) &= ~_BV(BIT(DCF_INPUT));
 
-                }
+                        /*
+                         * Output logging information regarding the change
+                         */
+                        log_dcf77("Pull-UP deactivated");
 
-                /*
-                 * Check whether setting for the pull up resistor has been
-                 * changed 30 times already. If the receiver hasn't
-                 * been detected by now, it probably isn't available.
-                 */
-                if (count_switch == 30) {
+                    } else {
 
-                    /*
-                     * Activate pull up resistor just in case
-                     */
-                    PORT(DCF_INPUT) |= _BV(BIT(DCF_INPUT));
+                        /*
+                         * Activate pull up resistor
+                         */
+                        PORT(DCF_INPUT) |= _BV(BIT(DCF_INPUT));
 
-                    /*
-                     * Set and/or clear appropriate flags
-                     */
-                    setFlag(DEFINED);
-                    clearFlag(AVAILABLE);
+                        /*
+                         * Output logging information regarding the change
+                         */
+                        log_dcf77("Pull-UP activated");
+
+                    }
 
                     /*
-                     * Output logging information
+                     * Check whether setting for the pull up resistor has been
+                     * changed 30 times already. If the receiver hasn't
+                     * been detected by now, it probably isn't available.
                      */
-                    log_dcf77("\nNo DCF77 Module detected!\n");
+                    if (count_switch == 30) {
 
-                }
+                        /*
+                         * Activate pull up resistor just in case
+                         */
+                        PORT(DCF_INPUT) |= _BV(BIT(DCF_INPUT));
 
-            }
+                        /*
+                         * Set and/or clear appropriate flags
+                         */
+                        setFlag(DEFINED);
+                        clearFlag(AVAILABLE);
 
-        } else {
+                        /*
+                         * Output logging information
+                         */
+                        log_dcf77("No DCF77 Module detected!");
 
-            /*
-             * Both count_low and count_high have values different from 0,
-             * which means that there probably is a receiver available
-             */
+                    }
 
-            /*
-             * Check whether there were 30 changes without a change of the
-             * setting for the pull up resistor
-             */
-            if (++count_pass == 30) {
+                }
+
+            } else {
 
                 /*
-                 * Module successfully detected, set appropriate flags
+                 * Both count_low and count_high have values different from 0,
+                 * which means that there probably is a receiver available
                  */
-                setFlag(DEFINED);
-                setFlag(AVAILABLE);
 
                 /*
-                 * If logging for this module is enabled the type of the
-                 * receiver detected should be output
+                 * Check whether there were 30 changes without a change of the
+                 * setting for the pull up resistor
                  */
-                #if (LOG_DCF77 == 1)
+                if (++count_pass == 30) {
 
-                    if (getFlag(HIGH_ACTIVE)) {
+                    /*
+                     * Module successfully detected, set appropriate flags
+                     */
+                    setFlag(DEFINED);
+                    setFlag(AVAILABLE);
 
-                        log_dcf77("\nHigh active DCF77 Module detected!\n");
+                    /*
+                     * If logging for this module is enabled the type of the
+                     * receiver detected should be output
+                     */
+                    #if (LOG_DCF77 == 1)
 
-                    } else {
+                        if (getFlag(HIGH_ACTIVE)) {
 
-                        log_dcf77("\nLow active DCF77 Module detected!\n");
+                            log_dcf77("High active DCF77 Module detected!");
 
-                    }
+                        } else {
 
-                #endif
+                            log_dcf77("Low active DCF77 Module detected!");
 
-                return;
+                        }
 
-            }
+                    #endif
 
-            /*
-             * Check which of both counter values is larger, which is an indicator
-             * for the type of the receiver, as one of both should be significantly
-             * larger than the other.
-             *
-             * Remember: The pulse length is 100 ms and/or 200 ms, but the
-             * pause between two pulses is at least 800 ms long.
-             */
-            if (count_low > count_high) {
+                    return;
+
+                }
 
                 /*
-                 * Check whether the current presumed type of the receiver is
-                 * active high.
+                 * Check which of both counter values is larger, which is an indicator
+                 * for the type of the receiver, as one of both should be significantly
+                 * larger than the other.
+                 *
+                 * Remember: The pulse length is 100 ms and/or 200 ms, but the
+                 * pause between two pulses is at least 800 ms long.
                  */
-                if (getFlag(HIGH_ACTIVE)) {
+                if (count_low > count_high) {
 
                     /*
-                     * We would expect count_high to be bigger in case of an
-                     * active high receiver, therefore we reset the pass
-                     * counter and presume an active low module for the next
-                     * passes.
+                     * Check whether the current presumed type of the receiver is
+                     * active high.
                      */
-                    count_pass = 0;
-                    clearFlag(HIGH_ACTIVE);
+                    if (getFlag(HIGH_ACTIVE)) {
 
-                }
+                        /*
+                         * We would expect count_high to be bigger in case of an
+                         * active high receiver, therefore we reset the pass
+                         * counter and presume an active low module for the next
+                         * passes.
+                         */
+                        count_pass = 0;
+                        clearFlag(HIGH_ACTIVE);
 
-            /*
-             * count_low is smaller (and/or equal) to count_high
-             */
-            } else {
+                    }
 
                 /*
-                 * Check whether the current presumed type of the receiver is
-                 * active low
+                 * count_low is smaller (and/or equal) to count_high
                  */
-                if (!(getFlag(HIGH_ACTIVE))) {
+                } else {
 
                     /*
-                     * We would expect count_low to be bigger in case of an
-                     * active low receiver, therefore we reset the pass counter
-                     * and presume an active low receiver for the next passes.
+                     * Check whether the current presumed type of the receiver is
+                     * active low
                      */
-                    count_pass = 0;
-                    setFlag(HIGH_ACTIVE);
+                    if (!(getFlag(HIGH_ACTIVE))) {
+
+                        /*
+                         * We would expect count_low to be bigger in case of an
+                         * active low receiver, therefore we reset the pass counter
+                         * and presume an active low receiver for the next passes.
+                         */
+                        count_pass = 0;
+                        setFlag(HIGH_ACTIVE);
+
+                    }
 
                 }
 
             }
 
+            /*
+             * Reset both counters, the high and/or low detection will be reached
+             * directly the next time this function is called
+             */
+            count_low = 0;
+            count_high = 0;
+
         }
 
-        /*
-         * Reset both counters, the high and/or low detection will be reached
-         * directly the next time this function is called
-         */
-        count_low = 0;
-        count_high = 0;
+    }
+
+#endif /* (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT) */
+
+#if (DCF77_FAST_SYNC == 1)
+
+    /**
+     * @brief Checks whether the received time frame is plausible
+     *
+     * The time frame is plausible if it is valid on its own, the current date
+     * and time is known to be valid and the received date equals the current
+     * date. Furthermore the received time may only deviate by up to
+     * DCF77_FAST_SYNC_WINDOW minutes from the current time.
+     *
+     * @return True if the time frame is plausible, false otherwise
+     *
+     * @see DCF77_FAST_SYNC
+     * @see datetime_is_valid()
+     * @see datetime_get()
+     */
+    static bool dcf77_is_plausible()
+    {
+
+        if (!datetime_is_valid()) {
+
+            return false;
+
+        }
+
+        datetime_t dt = {
+
+            .YY = DCF.NewTime[5],
+            .MM = DCF.NewTime[4],
+            .DD = DCF.NewTime[2],
+            .WD = DCF.NewTime[3],
+            .hh = DCF.NewTime[1],
+            .mm = DCF.NewTime[0],
+            .ss = 0,
+
+        };
+
+        const datetime_t* now = datetime_get();
+
+        if (!datetime_validate(&dt) || dt.YY != now->YY || dt.MM != now->MM
+                || dt.DD != now->DD) {
+
+            return false;
+
+        }
+
+        int16_t deviation = (dt.hh * 60 + dt.mm) - (now->hh * 60 + now->mm);
+
+        return (deviation >= -DCF77_FAST_SYNC_WINDOW)
+                && (deviation <= DCF77_FAST_SYNC_WINDOW);
 
     }
 
-}
+#endif /* (DCF77_FAST_SYNC == 1) */
+
 /**
  * @brief Analyzes the received information
  *
@@ -730,6 +1027,10 @@ static void dcf77_check_receiver_type()
  * invalid parity bits. If the received time frame was valid true is returned,
  * otherwise it will return false.
  *
+ * Usually two consecutive valid time frames are needed. With DCF77_FAST_SYNC
+ * enabled, a single one is enough when it is plausible, see
+ * dcf77_is_plausible().
+ *
  * @return True if valid time frame was received, false otherwise
  *
  * @see DCF_Struct
@@ -745,19 +1046,44 @@ static bool dcf77_check()
 
         if (DCF.PauseCounter > 0) {
 
-            char log_text[8];
-
             /*
-             * Output the length of the last pause
+             * Log the length of the last pause
              */
-            sprintf_P(log_text, fmt_unsigned_decimal, DCF.PauseCounter);
-            uart_puts(log_text);
-            uart_puts(" ");
+            log_put(LOG_EVENT_DCF77_PAUSE, DCF.PauseCounter, 0, 0);
 
         }
 
     #endif
 
+    /*
+     * Keep track of the measured pause length
+     */
+    if (DCF.PauseCounter > 0) {
+
+        e_dcf77Pause pause = DCF77_PAUSE_INVALID;
+
+        if (DCF.PauseCounter <= 6) {
+
+            pause = DCF77_PAUSE_SPIKE;
+
+        } else if ((DCF.PauseCounter >= 70) && (DCF.PauseCounter <= 86)) {
+
+            pause = DCF77_PAUSE_ONE;
+
+        } else if ((DCF.PauseCounter >= 87) && (DCF.PauseCounter <= 95)) {
+
+            pause = DCF77_PAUSE_ZERO;
+
+        } else if (DCF.PauseCounter >= 170) {
+
+            pause = DCF77_PAUSE_MINUTE;
+
+        }
+
+        dcf77_stats_inc(&dcf77_stats.pauses[pause]);
+
+    }
+
    /*
     * Check whether pause length is smaller or equal to 60 ms, which is
     * considered to be some sort of a spike.
@@ -773,9 +1099,19 @@ static bool dcf77_check()
 
     }
 
+    /*
+     * Pauses that neither encode a bit nor mark a new minute are just as
+     * invalid as a minute mark at the wrong position. They need to reset the
+     * decoding, too, otherwise the counter would be carried over into the
+     * next pause.
+     */
     if (((DCF.PauseCounter >= 170) && (DCF.BitCounter != 58))
+          || (DCF.PauseCounter < 70)
+          || ((DCF.PauseCounter > 95) && (DCF.PauseCounter < 170))
           || (DCF.BitCounter >= 59)) {
 
+        dcf77_stats_inc(&dcf77_stats.resets);
+
         /*
          * Reset the internal state of this module
          */
@@ -810,7 +1146,7 @@ static bool dcf77_check()
     /*
      * Check whether 0 or 1 have been received.
      */
-    if ((DCF.PauseCounter >= 78) && (DCF.PauseCounter <= 95)) {
+    if ((DCF.PauseCounter >= 70) && (DCF.PauseCounter <= 95)) {
 
         /*
          * Check if 1 has been received
@@ -851,6 +1187,8 @@ static bool dcf77_check()
         if (((DCF.BitCounter == 28) || (DCF.BitCounter == 35))
                 && (DCF.Parity % 2 != 0)) {
 
+            dcf77_stats_inc(&dcf77_stats.parity_errors);
+
             dcf77_reset();
 
             return false;
@@ -922,6 +1260,8 @@ static bool dcf77_check()
          */
         if ((DCF.BitCounter != 58) || (DCF.Parity % 2 != 0)) {
 
+            dcf77_stats_inc(&dcf77_stats.parity_errors);
+
             /*
              * Reset the internal state of this module
              */
@@ -931,6 +1271,23 @@ static bool dcf77_check()
 
         }
 
+        dcf77_stats_inc(&dcf77_stats.frames);
+
+        #if (DCF77_FAST_SYNC == 1)
+
+            if (dcf77_is_plausible()) {
+
+                /*
+                 * Output some log information
+                 */
+                log_dcf77("DCF77 plausible");
+
+                return true;
+
+            }
+
+        #endif /* (DCF77_FAST_SYNC == 1) */
+
         uint8_t NewTime;
 
         NewTime = DCF.NewTime[0] + DCF.NewTime[1] * 60;
@@ -940,7 +1297,7 @@ static bool dcf77_check()
             /*
              * Output some log information
              */
-            log_dcf77(" 2nd DCF77 correct\n");
+            log_dcf77("2nd DCF77 correct");
 
             return true;
 
@@ -949,7 +1306,7 @@ static bool dcf77_check()
             /*
              * Output some log information
              */
-            log_dcf77(" 1st DCF77 correct\n");
+            log_dcf77("1st DCF77 correct");
 
             /*
              * Take over the NewTime as OldTime for the next iteration
@@ -979,6 +1336,10 @@ static bool dcf77_check()
  * are set and/or cleared to trigger further initilization tasks, such as the
  * detection of the receiver type.
  *
+ * When the receiver type is known at build time (DCF77_RECEIVER_TYPE), the
+ * input pin is set up accordingly right away.
+ *
+ * @see DCF77_RECEIVER_TYPE
  * @see dcf77_check_receiver_type()
  * @see FLAGS
  */
@@ -997,11 +1358,38 @@ void dcf77_init()
     DDR(DCF_OUTPUT) |=  _BV(BIT(DCF_OUTPUT));
     PORT(DCF_OUTPUT) &= ~_BV(BIT(DCF_OUTPUT));
 
-    /*
-     * Set and/or clear various flags
-     */
-    clearFlag(DEFINED);
-    setFlag(AVAILABLE);
+    #if (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT)
+
+        /*
+         * Set and/or clear various flags
+         */
+        clearFlag(DEFINED);
+        setFlag(AVAILABLE);
+
+    #else
+
+        #if (DCF77_RECEIVER_PULL_UP == 1)
+
+            PORT(DCF_INPUT) |= _BV(BIT(DCF_INPUT));
+
+        #endif /* (DCF77_RECEIVER_PULL_UP == 1) */
+
+        /*
+         * The receiver type is known, so there is nothing to detect
+         */
+        setFlag(DEFINED);
+        setFlag(AVAILABLE);
+
+        #if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+            dcf77_edge_reset();
+
+            DCF_INPUT_PCMSK |= _BV(BIT(DCF_INPUT));
+            PCICR |= _BV(DCF_INPUT_PCIE);
+
+        #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+    #endif /* (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT) */
 
     /*
      * Reset this module using dcf77_reset
@@ -1015,6 +1403,70 @@ void dcf77_init()
 
 }
 
+#if (DCF77_USE_EDGE_TIMESTAMPS == 0)
+
+    /**
+     * @brief Counts the pause length of the polled signal
+     *
+     * This is invoked by dcf77_ISR() every 10 ms once the receiver type is
+     * known. While the reception is enabled, it increases the pause counter
+     * during a pause and sets the CHECK flag during a pulse, so that the
+     * signal will be analyzed by dcf77_check(). Furthermore it sets the output
+     * pin according to the input pin.
+     *
+     * @see dcf77_ISR()
+     * @see dcf77_check()
+     */
+    static inline void dcf77_poll()
+    {
+
+        /*
+         * Check whether DCF receiving is currently enabled
+         */
+        if (enable_dcf77_ISR) {
+
+            /*
+             * Check if signal is high
+             */
+            if (dcf77_get_signal()) {
+
+                /*
+                 * Increase pause counter
+                 */
+                DCF.PauseCounter++;
+
+                /*
+                 * Disable DCF77 output
+                 */
+                PORT(DCF_OUTPUT) &= ~_BV(BIT(DCF_OUTPUT));
+
+            } else {
+
+                /*
+                 * DCF signal is low
+                 */
+
+                /*
+                 * Set check flag to indicate that the signal
+                 * can be analyzed
+                 */
+                setFlag(CHECK);
+
+                /*
+                 * Enable DCF output
+                 */
+                PORT(DCF_OUTPUT) |= _BV(BIT(DCF_OUTPUT));
+
+            }
+
+        }
+
+    }
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 0) */
+
+#if (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT)
+
 /**
  * @brief ISR counting the pause length between two pulses
  *
@@ -1028,9 +1480,15 @@ void dcf77_init()
  *
  * Furthermore it sets the output pin according to the input pin.
  *
+ * When DCF77_USE_EDGE_TIMESTAMPS is enabled, this is only used to determine
+ * the receiver type. Afterwards the decoding is done within
+ * `ISR(DCF_INPUT_PCINT_vect)` and this returns immediately.
+ *
  * @see dcf77_check()
+ * @see dcf77_poll()
  * @see FLAGS
  * @see INTERRUPT_100HZ
+ * @see DCF77_USE_EDGE_TIMESTAMPS
  */
 void dcf77_ISR()
 {
@@ -1064,71 +1522,152 @@ void dcf77_ISR()
              */
             dcf77_check_receiver_type();
 
+            #if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+                /*
+                 * Hand over to the pin change interrupt once the receiver
+                 * has been detected successfully
+                 */
+                if (getFlag(DEFINED) && getFlag(AVAILABLE)) {
+
+                    dcf77_edge_reset();
+
+                    DCF_INPUT_PCMSK |= _BV(BIT(DCF_INPUT));
+                    PCICR |= _BV(DCF_INPUT_PCIE);
+
+                }
+
+            #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
         } else {
 
             /*
-             * Receiver type has already been determined
+             * Receiver type has already been determined. When decoding by
+             * timestamping edges there is nothing left to do here.
              */
+            #if (DCF77_USE_EDGE_TIMESTAMPS == 0)
 
-            /*
-             * Check whether DCF receiving is currently enabled
-             */
-            if (enable_dcf77_ISR) {
+                dcf77_poll();
 
-                uint8_t dcf_signal;
+            #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 0) */
 
-                /*
-                 * Check which type of receiver is used and negate the input
-                 * pin if necessary. Apply this value to dcf_signal.
-                 */
-                if (getFlag(HIGH_ACTIVE)) {
+        }
 
-                    dcf_signal = (PIN(DCF_INPUT) & _BV(BIT(DCF_INPUT)));
+    }
 
-                } else {
+}
 
-                    dcf_signal = !(PIN(DCF_INPUT) & _BV(BIT(DCF_INPUT)));
+#elif (DCF77_USE_EDGE_TIMESTAMPS == 0)
 
-                }
+/**
+ * @brief ISR counting the pause length between two pulses
+ *
+ * This ISR needs to be called every 10 ms. This is achieved by including it
+ * into the macro INTERRUPT_100HZ. As the receiver type is known at build time
+ * (DCF77_RECEIVER_TYPE), there is nothing to detect and the pin is polled
+ * right away.
+ *
+ * @see dcf77_poll()
+ * @see INTERRUPT_100HZ
+ * @see DCF77_RECEIVER_TYPE
+ */
+void dcf77_ISR()
+{
 
-                /*
-                 * Check if signal is high
-                 */
-                if (dcf_signal) {
+    dcf77_poll();
 
-                    /*
-                     * Increase pause counter
-                     */
-                    DCF.PauseCounter++;
+}
 
-                    /*
-                     * Disable DCF77 output
-                     */
-                    PORT(DCF_OUTPUT) &= ~_BV(BIT(DCF_OUTPUT));
+#endif /* (DCF77_RECEIVER_TYPE == DCF77_RECEIVER_DETECT) */
 
-                } else {
+#if (DCF77_USE_EDGE_TIMESTAMPS == 1)
 
-                    /*
-                     * DCF signal is low
-                     */
+    /**
+     * @brief Pin change handler of the DCF77 input pin (ISR)
+     *
+     * This is executed on every edge of the DCF77 signal, once the receiver
+     * type has been determined by dcf77_ISR(). The edges are timestamped by
+     * means of timer_get_ms().
+     *
+     * A level is only considered to be valid once it has lasted for at
+     * least DCF77_EDGE_GLITCH_MS, which can only be known once the next
+     * edge occurs. Therefore the transitions are handed over to
+     * dcf77_edge_transition() with a delay of one edge, but with the
+     * timestamp of the original edge.
+     *
+     * Furthermore it sets the output pin according to the input pin.
+     *
+     * @see DCF77_USE_EDGE_TIMESTAMPS
+     * @see DCF77_EDGE_GLITCH_MS
+     * @see dcf77_edge_transition()
+     */
+    ISR(DCF_INPUT_PCINT_vect)
+    {
 
-                    /*
-                     * Set check flag to indicate that the signal
-                     * can be analyzed
-                     */
-                    setFlag(CHECK);
+        if (!enable_dcf77_ISR) {
 
-                    /*
-                     * Enable DCF output
-                     */
-                    PORT(DCF_OUTPUT) |= _BV(BIT(DCF_OUTPUT));
+            return;
 
-                }
+        }
 
-            }
+        uint16_t now = timer_get_ms();
+        bool level = dcf77_get_signal();
+
+        if (level) {
+
+            PORT(DCF_OUTPUT) &= ~_BV(BIT(DCF_OUTPUT));
+
+        } else {
+
+            PORT(DCF_OUTPUT) |= _BV(BIT(DCF_OUTPUT));
+
+        }
+
+        /*
+         * Ignore changes of other pins sharing this interrupt as well as
+         * glitches too short to be seen
+         */
+        if (level == edge_level) {
+
+            return;
+
+        }
+
+        /*
+         * Check whether the level before this edge was stable long enough to
+         * be considered valid
+         */
+        if (((uint16_t)(now - edge_time) >= DCF77_EDGE_GLITCH_MS)
+                && (edge_level != edge_stable_level)) {
+
+            edge_stable_level = edge_level;
+            dcf77_edge_transition(edge_stable_level, edge_time);
 
         }
 
+        edge_level = level;
+        edge_time = now;
+
+    }
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+/**
+ * @brief Keeps track of the time the current synchronization attempt takes
+ *
+ * This needs to be called once a second. This is achieved by including it
+ * into the macro INTERRUPT_1HZ.
+ *
+ * @see dcf77_attempt_duration
+ * @see INTERRUPT_1HZ
+ */
+void dcf77_stats_ISR()
+{
+
+    if (enable_dcf77_ISR && dcf77_attempt_duration != UINT16_MAX) {
+
+        dcf77_attempt_duration++;
+
     }
 
 }
@@ -1172,6 +1711,17 @@ bool dcf77_get_datetime(datetime_t * dt)
             dt->MM = DCF.NewTime[4];
             dt->YY = DCF.NewTime[5];
 
+            /*
+             * Keep track of this synchronization
+             */
+            dcf77_stats_inc(&dcf77_stats.syncs);
+            dcf77_stats.last_sync = *dt;
+
+            uint8_t sreg = SREG;
+            cli();
+            dcf77_stats.sync_duration = dcf77_attempt_duration;
+            SREG = sreg;
+
             /*
              * Reset this module
              */
@@ -1205,4 +1755,38 @@ bool dcf77_get_datetime(datetime_t * dt)
 
 }
 
+/**
+ * @brief Retrieves the statistics about the reception of the DCF77 signal
+ *
+ * @param stats Pointer to buffer where the statistics should be stored
+ *
+ * @see dcf77_stats_t
+ * @see dcf77_reset_stats()
+ */
+void dcf77_get_stats(dcf77_stats_t* stats)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    *stats = dcf77_stats;
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Resets the statistics about the reception of the DCF77 signal
+ *
+ * @see dcf77_stats_t
+ * @see dcf77_get_stats()
+ */
+void dcf77_reset_stats()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    dcf77_stats = (dcf77_stats_t){0};
+    SREG = sreg;
+
+}
+
 #endif /* (ENABLE_DCF_SUPPORT == 1) */
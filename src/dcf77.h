@@ -49,22 +49,253 @@
 #define _WC_DCF77_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "config.h"
 #include "datetime.h"
 
+/**
+ * @brief Defines whether the signal should be decoded by timestamping edges
+ *
+ * By default the input pin is polled by dcf77_ISR() every 10 ms and the
+ * length of the pause between two pulses is counted in units of 10 ms. When
+ * this is enabled, the pin change interrupt of the input pin is used instead.
+ * Each edge is timestamped by means of timer_get_ms(), so the durations are
+ * measured with a resolution of 1 ms. Short glitches are filtered out, see
+ * DCF77_EDGE_GLITCH_MS.
+ *
+ * dcf77_ISR() is then only needed until the receiver type has been
+ * determined, after which it returns immediately.
+ *
+ * This can also be set on the command line of the compiler, which the replay
+ * within test/host makes use of to cover both ways of decoding.
+ *
+ * @see DCF77_EDGE_GLITCH_MS
+ * @see dcf77_ISR()
+ * @see timer_get_ms()
+ */
+#ifndef DCF77_USE_EDGE_TIMESTAMPS
+
+    #define DCF77_USE_EDGE_TIMESTAMPS 0
+
+#endif
+
+/**
+ * @brief Minimum duration in ms for a level to be considered valid
+ *
+ * When decoding by timestamping edges (DCF77_USE_EDGE_TIMESTAMPS), any level
+ * on the input pin that lasts for a shorter amount of time is considered to
+ * be a glitch and is ignored, i.e. it is merged with the surrounding level.
+ *
+ * @see DCF77_USE_EDGE_TIMESTAMPS
+ */
+#define DCF77_EDGE_GLITCH_MS 30
+
+/**
+ * @brief Defines whether a single time frame is accepted when plausible
+ *
+ * By default two consecutive valid time frames are needed before the
+ * received date and time is taken over. When this is enabled, a single valid
+ * time frame is already accepted when the date matches the current date
+ * and the time lies within DCF77_FAST_SYNC_WINDOW of the current time.
+ *
+ * When the current date and time is not valid (see datetime_is_valid()) or
+ * the time frame is not plausible, two consecutive time frames are still
+ * needed.
+ *
+ * @see DCF77_FAST_SYNC_WINDOW
+ * @see datetime_is_valid()
+ */
+#define DCF77_FAST_SYNC 1
+
+/**
+ * @brief Maximum deviation in minutes for a time frame to be plausible
+ *
+ * @see DCF77_FAST_SYNC
+ */
+#define DCF77_FAST_SYNC_WINDOW 5
+
+/**
+ * @brief Value of DCF77_RECEIVER_TYPE to detect the receiver type at runtime
+ *
+ * @see DCF77_RECEIVER_TYPE
+ */
+#define DCF77_RECEIVER_DETECT 0
+
+/**
+ * @brief Value of DCF77_RECEIVER_TYPE for an active high receiver
+ *
+ * The output of an active high receiver is high during a pulse and low during
+ * the pause.
+ *
+ * @see DCF77_RECEIVER_TYPE
+ */
+#define DCF77_RECEIVER_HIGH_ACTIVE 1
+
+/**
+ * @brief Value of DCF77_RECEIVER_TYPE for an active low receiver
+ *
+ * The output of an active low receiver is low during a pulse and high during
+ * the pause. This is the case for most receivers.
+ *
+ * @see DCF77_RECEIVER_TYPE
+ */
+#define DCF77_RECEIVER_LOW_ACTIVE 2
+
+/**
+ * @brief Type of the DCF77 receiver in use
+ *
+ * By default (DCF77_RECEIVER_DETECT) the type of the receiver, along with
+ * whether it needs the internal pull up resistor, is determined at runtime
+ * by watching the input pin for some time after each reset, see
+ * dcf77_check_receiver_type().
+ *
+ * When the receiver is known at build time, it can be set to either
+ * DCF77_RECEIVER_HIGH_ACTIVE or DCF77_RECEIVER_LOW_ACTIVE instead. The
+ * detection is then left out completely and the input pin is read without
+ * any further checks, so the reception starts right away.
+ *
+ * @see DCF77_RECEIVER_PULL_UP
+ */
+#define DCF77_RECEIVER_TYPE DCF77_RECEIVER_DETECT
+
+/**
+ * @brief Defines whether the internal pull up resistor should be enabled
+ *
+ * This is only used when the receiver type is known at build time, otherwise
+ * it is determined at runtime along with the type itself. Receivers with an
+ * open collector output need it to be enabled.
+ *
+ * @see DCF77_RECEIVER_TYPE
+ */
+#define DCF77_RECEIVER_PULL_UP 1
+
 #if (ENABLE_DCF_SUPPORT == 1)
 
+/**
+ * @brief Classes of pause lengths kept track of within dcf77_stats_t
+ *
+ * @see dcf77_stats_t::pauses
+ */
+typedef enum {
+
+    /**
+     * @brief Pause of up to 60 ms, which is considered to be a spike
+     */
+    DCF77_PAUSE_SPIKE,
+
+    /**
+     * @brief Pause of 700 ms up to 860 ms, i.e. after a 1 was received
+     */
+    DCF77_PAUSE_ONE,
+
+    /**
+     * @brief Pause of 870 ms up to 950 ms, i.e. after a 0 was received
+     */
+    DCF77_PAUSE_ZERO,
+
+    /**
+     * @brief Pause of at least 1700 ms, i.e. the start of a new minute
+     */
+    DCF77_PAUSE_MINUTE,
+
+    /**
+     * @brief Pause of any other length
+     */
+    DCF77_PAUSE_INVALID,
+
+    DCF77_PAUSE_COUNT
+
+} e_dcf77Pause;
+
+/**
+ * @brief Statistics about the reception of the DCF77 signal
+ *
+ * All of the counters saturate at `UINT16_MAX` and are only reset by
+ * dcf77_reset_stats().
+ *
+ * @see dcf77_get_stats()
+ * @see dcf77_reset_stats()
+ */
+typedef struct {
+
+    /**
+     * @brief Number of complete time frames with valid parity received
+     */
+    uint16_t frames;
+
+    /**
+     * @brief Number of time frames discarded because of invalid parity
+     */
+    uint16_t parity_errors;
+
+    /**
+     * @brief Number of time frames discarded because of invalid timings
+     *
+     * This is the case when a new minute starts before all bits have been
+     * received or no new minute starts after the last bit.
+     */
+    uint16_t resets;
+
+    /**
+     * @brief Number of successful synchronizations
+     */
+    uint16_t syncs;
+
+    /**
+     * @brief Histogram of the measured pause lengths
+     *
+     * @see e_dcf77Pause
+     */
+    uint16_t pauses[DCF77_PAUSE_COUNT];
+
+    /**
+     * @brief Time in seconds the last successful synchronization took
+     *
+     * This is measured from the point in time the decoding was enabled by
+     * dcf77_enable() up until the time frame was accepted.
+     */
+    uint16_t sync_duration;
+
+    /**
+     * @brief Date and time of the last successful synchronization
+     *
+     * This is only valid when dcf77_stats_t::syncs is not zero.
+     */
+    datetime_t last_sync;
+
+} dcf77_stats_t;
+
 extern void dcf77_init();
 
 extern void dcf77_enable();
 
 extern void dcf77_disable();
 
-extern void dcf77_ISR();
+#if (DCF77_RECEIVER_TYPE != DCF77_RECEIVER_DETECT && DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+    /**
+     * @brief Empty macro, as there is nothing left to poll in this case
+     *
+     * @see DCF77_RECEIVER_TYPE
+     * @see DCF77_USE_EDGE_TIMESTAMPS
+     */
+    #define dcf77_ISR()
+
+#else
+
+    extern void dcf77_ISR();
+
+#endif /* (DCF77_RECEIVER_TYPE != DCF77_RECEIVER_DETECT && DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+extern void dcf77_stats_ISR();
 
 extern bool dcf77_get_datetime(datetime_t* dt);
 
+extern void dcf77_get_stats(dcf77_stats_t* stats);
+
+extern void dcf77_reset_stats();
+
 #else
 
 /**
@@ -78,6 +309,14 @@ extern bool dcf77_get_datetime(datetime_t* dt);
  */
 #define dcf77_ISR()
 
+/**
+ * @brief Empty macro in case DCF77 functionality is disabled
+ *
+ * @see ENABLE_DCF_SUPPORT
+ * @see INTERRUPT_1HZ
+ */
+#define dcf77_stats_ISR()
+
 #endif /* (ENABLE_DCF_SUPPORT == 1) */
 
 #endif /* _WC_DCF77_H_ */
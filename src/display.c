@@ -45,6 +45,23 @@
 #include "user.h"
 #include "uart.h"
 #include "pwm.h"
+#include "memcheck.h"
+#include "preferences.h"
+#include "profile.h"
+#include "prng.h"
+#include "timer.h"
+
+#if (DISPLAY_INTENSITY_BITS > 4) || (DISPLAY_INTENSITY_BITS > DISPLAY_SCAN_FRAMES_MAX)
+
+    #error "DISPLAY_INTENSITY_BITS is too big"
+
+#endif
+
+#if ((DISPLAY_INTENSITY_TICKS << (DISPLAY_INTENSITY_BITS - 1)) > UINT8_MAX)
+
+    #error "DISPLAY_INTENSITY_TICKS is too big"
+
+#endif
 
 /**
  * @brief Amount of steps the fading should take
@@ -53,32 +70,52 @@
  * increasing the amount of steps will make the fading itself look smoother,
  * however the amount of steps is limited by the timer frequency
  * (DISPLAY_TIMER_FREQUENCY) and the proposed fade time itself
- * (DISPLAY_FADE_TIME_MS). The default value for this option is 20, which
- * seems to be a good tradeoff with the factors mentioned above in mind.
+ * (DISPLAY_FADE_TIME_MS). As the steps are spaced perceptually
+ * (display_fade_schedule), 16 steps look at least as smooth as the 20 linear
+ * steps used previously.
+ *
+ * @note This must match the size of display_fade_schedule.
  *
  * @see DISPLAY_FADE_PERIOD
  * @see DISPLAY_FADE_PERIOD_ANIM
+ * @see display_fade_schedule
  * @see g_curFadeStep
- * @see g_curFadeStepTimer
- * @see g_curFadeStepCounter
  */
-#define DISPLAY_FADE_STEPS 20
+#define DISPLAY_FADE_STEPS 16
 
 /**
- * @brief Length of a single fading step
+ * @brief Length of a single fade cycle in ticks of the display timer
  *
- * This defines the length of a single fading step (DISPLAY_FADE_STEPS).
+ * During the fading the old and the new state are output alternatingly
+ * within cycles of this length. The ratio between both of them is defined
+ * by display_fade_schedule.
+ *
+ * @note For performance reasons this needs to be a power of two.
+ *
+ * @see display_fade_schedule
+ * @see g_curFadeCounter
+ */
+#define DISPLAY_FADE_CYCLE 32
+
+/**
+ * @brief Number of fade cycles a single fading step takes
+ *
+ * This defines the length of a single fading step (DISPLAY_FADE_STEPS) in
+ * units of DISPLAY_FADE_CYCLE. It is calculated at compile time, so the ISR
+ * itself doesn't need to perform any divisions.
  *
  * @see DISPLAY_TIMER_FREQUENCY
  * @see DISPLAY_FADE_TIME_MS
  * @see DISPLAY_FADE_STEPS
+ * @see DISPLAY_FADE_CYCLE
  * @see g_curFadeStepTimer
  */
 #define DISPLAY_FADE_PERIOD \
-    ((uint16_t)(((((uint32_t)DISPLAY_TIMER_FREQUENCY) * DISPLAY_FADE_TIME_MS) / 1000) / DISPLAY_FADE_STEPS))
+    ((uint8_t)((((((uint32_t)DISPLAY_TIMER_FREQUENCY) * DISPLAY_FADE_TIME_MS) / 1000) \
+    / (DISPLAY_FADE_CYCLE * DISPLAY_FADE_STEPS)) ?: 1))
 
 /**
- * @brief Length of a single fading step when autoOff enabled
+ * @brief Number of fade cycles a single fading step takes with autoOff enabled
  *
  * This defines the length of a single fading step (DISPLAY_FADE_STEPS) when
  * the autoOff feature (useAutoOffAnimation) is enabled.
@@ -86,73 +123,265 @@
  * @see DISPLAY_TIMER_FREQUENCY
  * @see DISPLAY_FADE_TIME_ANIM_MS
  * @see DISPLAY_FADE_STEPS
+ * @see DISPLAY_FADE_CYCLE
  * @see useAutoOffAnimation
  * @see g_curFadeStepTimer
  */
 #define DISPLAY_FADE_PERIOD_ANIM \
-    ((uint16_t)(((((uint32_t)DISPLAY_TIMER_FREQUENCY) * DISPLAY_FADE_TIME_ANIM_MS) / 1000) / DISPLAY_FADE_STEPS))
+    ((uint8_t)((((((uint32_t)DISPLAY_TIMER_FREQUENCY) * DISPLAY_FADE_TIME_ANIM_MS) / 1000) \
+    / (DISPLAY_FADE_CYCLE * DISPLAY_FADE_STEPS)) ?: 1))
 
 /**
- * @brief Global variable containing the old display state
+ * @brief Perceptual fade schedule
+ *
+ * This contains the amount of ticks within each fade cycle
+ * (DISPLAY_FADE_CYCLE) the new state is being output for every single fade
+ * step. For the rest of the cycle the old state is being output. The values
+ * follow a gamma curve (gamma = 2.2) to fit the logarithmic nature of the
+ * human eye, i.e. they were calculated with:
  *
- * This variable is mainly used by the appropriate ISR (DISPLAY_TIMER_OVF_vect)
- * and allows the ISR to implement a fading between the old and the new
- * (current) state.
+ * `max(1, round(DISPLAY_FADE_CYCLE * (i / DISPLAY_FADE_STEPS) ^ 2.2))`
  *
+ * with i ranging from 1 to DISPLAY_FADE_STEPS.
+ *
+ * @see DISPLAY_FADE_STEPS
+ * @see DISPLAY_FADE_CYCLE
  * @see ISR(DISPLAY_TIMER_OVF_vect)
- * @see g_curDispState
  */
-static display_state_t g_oldDispState;
+static const uint8_t display_fade_schedule[DISPLAY_FADE_STEPS] PROGMEM =
+    {1, 1, 1, 2, 2, 4, 5, 7, 9, 11, 14, 17, 20, 24, 28, 32};
+
+/**
+ * @brief Ways a display frame can be changed over to
+ *
+ * @see display_frame_t::mode
+ */
+typedef enum {
+
+    /**
+     * @brief The new state is output directly, possibly with blinking words
+     *
+     * @see display_setDisplayState()
+     */
+    DISPLAY_FRAME_SET = 0,
+
+    /**
+     * @brief The display is faded over from the old to the new state
+     *
+     * @see display_fadeDisplayState()
+     */
+    DISPLAY_FRAME_FADE,
+
+    /**
+     * @brief The keyframes of an animation are played back
+     *
+     * @see display_animateDisplayState()
+     */
+    DISPLAY_FRAME_ANIMATE,
+
+    /**
+     * @brief The sub-frames of the frame are scanned out repeatedly
+     *
+     * @see display_setScanFrames()
+     * @see display_setIntensityState()
+     */
+    DISPLAY_FRAME_SCAN
+
+} e_displayFrameMode;
 
 /**
- * @brief Global variable containing the current display state
+ * @brief Everything the ISR (DISPLAY_TIMER_OVF_vect) needs to output a frame
  *
- * This variable is mainly used by the appropriate ISR (DISPLAY_TIMER_OVF_vect)
- * and allows the ISR to either output the current display state directly
- * and/or fade between the old (g_oldDispState) and the new display state.
- * Furthermore the blinking effect (g_blinkState) is applied on top of this
- * state, too.
+ * The state of the display is made up of several multi-byte variables, which
+ * can't be written atomically on an 8 bit microcontroller. Therefore there
+ * are two of these (g_dispFrames): The front frame is read by the ISR only,
+ * while the back frame is filled in by the display functions. Once it is
+ * complete, g_dispFramePending is set and the ISR swaps both frames the next
+ * time it is executed. This way the ISR never sees a partially written frame,
+ * without the need to disable any interrupts.
  *
- * @see ISR(DISPLAY_TIMER_OVF_vect)
- * @see g_blinkState
- * @see g_oldDispState
+ * @see g_dispFrames
+ * @see display_beginFrame()
+ * @see display_commitFrame()
+ */
+typedef struct {
+
+    /**
+     * @brief The current display state
+     *
+     * This is output directly and/or faded (and/or animated) to from the old
+     * state. The blinking effect (blink) is applied on top of this state.
+     */
+    display_state_t cur;
+
+    /**
+     * @brief The old display state, which is faded and/or animated from
+     */
+    display_state_t old;
+
+    /**
+     * @brief Words that should be blinking
+     *
+     * Only words that are enabled at all (cur) can be blinking. The blinking
+     * itself is performed by display_blinkStep().
+     */
+    display_state_t blink;
+
+    /**
+     * @brief Sub-frames to be scanned out in DISPLAY_FRAME_SCAN
+     */
+    display_state_t scanFrames[DISPLAY_SCAN_FRAMES_MAX];
+
+    /**
+     * @brief Number of display timer ticks each sub-frame is output for
+     */
+    uint8_t scanTicks[DISPLAY_SCAN_FRAMES_MAX];
+
+    /**
+     * @brief Number of valid sub-frames within scanFrames
+     */
+    uint8_t scanCount;
+
+    /**
+     * @brief How the frame is changed over to, see e_displayFrameMode
+     */
+    uint8_t mode;
+
+    /**
+     * @brief Reload value for g_curFadeStepTimer in DISPLAY_FRAME_FADE
+     *
+     * This is either DISPLAY_FADE_PERIOD_ANIM - 1 or DISPLAY_FADE_PERIOD - 1
+     * depending upon the value of useAutoOffAnimation.
+     */
+    uint8_t fadeReload;
+
+    /**
+     * @brief First keyframe of the animation in DISPLAY_FRAME_ANIMATE
+     *
+     * @see display_animations
+     */
+    const uint8_t* animation;
+
+} display_frame_t;
+
+/**
+ * @brief The front and the back frame
+ *
+ * @see display_frame_t
+ * @see g_dispFrameFront
  */
-static display_state_t g_curDispState;
+static display_frame_t g_dispFrames[2];
 
 /**
- * @brief Global variable containing words that should be blinking
+ * @brief Index of the front frame within g_dispFrames
  *
- * This contains words that should be blinking rather than being displayed
- * statically. Only words that are currently enabled at all (g_curDispState)
- * can be blinking. The blinking itself is performed by display_blinkStep().
+ * This is only changed by the ISR (DISPLAY_TIMER_OVF_vect), the other one
+ * is the back frame.
+ *
+ * @see g_dispFrames
+ */
+static volatile uint8_t g_dispFrameFront;
+
+/**
+ * @brief Flag indicating that the back frame is complete
+ *
+ * This is set by display_commitFrame() and cleared by the ISR once it has
+ * swapped the frames. display_beginFrame() clears it, too, so the ISR won't
+ * swap in the back frame while it is being written.
+ *
+ * @see display_beginFrame()
+ * @see display_commitFrame()
+ */
+static volatile uint8_t g_dispFramePending;
+
+/**
+ * @brief Flag indicating that the back frame is armed
+ *
+ * An armed frame is complete, but is only handed over to the ISR by
+ * display_commitArmedFrame(), i.e. with the next transition to a new minute.
+ * Any other change of the display withdraws it (see display_beginFrame()).
+ *
+ * @see display_armDisplayState()
+ * @see display_commitArmedFrame()
+ */
+static volatile uint8_t g_dispFrameArmed;
+
+/**
+ * @brief Flag indicating that the armed frame has been handed over
+ *
+ * This remains set until the display is changed the next time, so it can be
+ * told whether the display is already changing over to g_dispArmedState.
+ *
+ * @see display_commitArmedFrame()
+ * @see display_isArmedStateShown()
+ */
+static volatile uint8_t g_dispFrameArmedFired;
+
+/**
+ * @brief State the armed frame changes over to
+ *
+ * @see display_armDisplayState()
+ */
+static display_state_t g_dispArmedState;
+
+/**
+ * @brief Flag indicating that the frame being filled in is to be armed
+ *
+ * While this is set, display_commitFrame() only arms the back frame instead
+ * of handing it over to the ISR.
+ *
+ * @see display_armDisplayState()
+ */
+static bool g_dispFrameArming;
+
+/**
+ * @brief Phase of the blinking effect
+ *
+ * This is toggled by display_blinkStep(). While it is set, the blinking words
+ * (display_frame_t::blink) are disabled by the ISR.
  *
- * @see ISR(DISPLAY_TIMER_OVF_vect)
  * @see display_blinkStep()
- * @see g_curDispState
  */
-static display_state_t g_blinkState;
+static volatile uint8_t g_blinkPhase;
 
 /**
- * @brief Global variable keeping track of the status within a single fade step
+ * @brief Global variable containing the ticks left until the output toggles
  *
- * The fading between two states consists of a predefined amount of steps
- * (DISPLAY_FADE_STEPS). Within each of these steps this variable is
- * compared against the current fade step (g_curFadeStep). When it is bigger
- * than the current fade step g_curFadeStep, the new display state
- * (g_curDispState) will be output, otherwise the old one will be output
- * (g_oldDispState). This counter will then be decremented by one. When
- * reaching 0, it will be reset to DISPLAY_FADE_STEPS - 1, which marks the
- * current fade step as completed, and enables the next fading step to be
- * processed. This makes sure that in the beginning of the fading the old
- * state will be being output more often, whereas towards the end of the
- * fading the new state is being output more often.
+ * At the beginning of each fade cycle (DISPLAY_FADE_CYCLE) the new display
+ * state (display_frame_t::cur) is output. After g_curFadeDuty ticks the old
+ * state (display_frame_t::old) is output for the rest of the cycle. Whenever
+ * the output is toggled, the amount of ticks until the next toggle is put in
+ * here, so the ISR only needs to decrement this in between, see
+ * display_fadeToggle().
  *
- * @see DISPLAY_FADE_STEPS
- * @see g_curFadeStep
- * @see ISR(DISPLAY_TIMER_OVF_vect)
+ * @see DISPLAY_FADE_CYCLE
+ * @see g_curFadeDuty
+ * @see display_fadeToggle()
  */
 static uint8_t g_curFadeCounter;
 
+/**
+ * @brief Global variable indicating that the old state is currently output
+ *
+ * This tells display_fadeToggle() whether the next toggle switches to the old
+ * state or begins a new fade cycle.
+ *
+ * @see display_fadeToggle()
+ */
+static bool g_curFadeShowsOld;
+
+/**
+ * @brief Global variable containing the duty cycle of the current fade step
+ *
+ * This is the amount of ticks within the current fade cycle the new state
+ * is output for. It is retrieved from display_fade_schedule whenever a new
+ * fade step is entered.
+ *
+ * @see display_fade_schedule
+ * @see g_curFadeCounter
+ */
+static uint8_t g_curFadeDuty;
+
 /**
  * @brief Global variable keeping track of the current step of the fading
  *
@@ -160,7 +389,7 @@ static uint8_t g_curFadeCounter;
  * (DISPLAY_FADE_STEPS). This variable is used mainly within the appropriate
  * ISR (DISPLAY_TIMER_OVF_vect). It should be noted that this variable
  * actually counts backwards, e.g. it usually gets initialized with
- * DISPLAY_FADE_STEPS - 1 and will be decremented by 1 with each step until it
+ * DISPLAY_FADE_STEPS and will be decremented by 1 with each step until it
  * reaches 0, which marks the end of the fading.
  *
  * @see DISPLAY_FADE_STEPS
@@ -173,15 +402,291 @@ static uint8_t g_curFadeStep;
  *
  * This is used within the appropriate ISR to determine when the current fade
  * step is actually over, and therefore g_curFadeStep needs to be decremented
- * by one. It will then be reset to either
- * (DISPLAY_FADE_PERIOD_ANIM / DISPLAY_FADE_STEPS) - 1 or
- * (DISPLAY_FADE_PERIOD / DISPLAY_FADE_STEPS) - 1 depending upon the value of
- * useAutoOffAnimation.
+ * by one. It is decremented once per fade cycle and will then be reset to
+ * display_frame_t::fadeReload.
  *
  * @see ISR(DISPLAY_TIMER_OVF_vect)
- * @see useAutoOffAnimation
+ * @see display_frame_t::fadeReload
+ */
+static uint8_t g_curFadeStepTimer;
+
+/**
+ * @brief Keyframe operation: Outputs the new state and ends the animation
+ *
+ * @see DISPLAY_KEYFRAME()
+ */
+#define DISPLAY_KF_END 0
+
+/**
+ * @brief Keyframe operation: Outputs the old state
+ *
+ * @see DISPLAY_KEYFRAME()
+ */
+#define DISPLAY_KF_OLD 1
+
+/**
+ * @brief Keyframe operation: Outputs nothing at all
+ *
+ * @see DISPLAY_KEYFRAME()
+ */
+#define DISPLAY_KF_OFF 2
+
+/**
+ * @brief Keyframe operation: Outputs positions 0 up to arg of the new state
+ * and the remaining positions of the old state
+ *
+ * @see DISPLAY_KEYFRAME()
+ */
+#define DISPLAY_KF_WIPE 3
+
+/**
+ * @brief Keyframe operation: Outputs the old state with arg of the words not
+ * contained within the new state removed
+ *
+ * @see DISPLAY_KEYFRAME()
+ * @see display_lowestBits()
+ */
+#define DISPLAY_KF_HIDE 4
+
+/**
+ * @brief Keyframe operation: Outputs the words contained within both states
+ * along with arg of the words only contained within the new state
+ *
+ * @see DISPLAY_KEYFRAME()
+ * @see display_lowestBits()
+ */
+#define DISPLAY_KF_REVEAL 5
+
+/**
+ * @brief Keyframe operation: Outputs a random mix of both states
+ *
+ * The argument defines the share of the new state: 0 for roughly 1/4, 1 for
+ * 1/2 and 2 for 3/4.
+ *
+ * @see DISPLAY_KEYFRAME()
+ * @see prng_rand()
+ */
+#define DISPLAY_KF_SPARKLE 6
+
+/**
+ * @brief Encodes a single keyframe of an animation
+ *
+ * Each keyframe takes up two bytes within flash: The operation to be
+ * performed (upper three bits) along with its argument (lower five bits), and
+ * the amount of time the result is output for in multiples of
+ * DISPLAY_ANIMATION_TICKS.
+ *
+ * @param op Operation to be performed, e.g. DISPLAY_KF_WIPE
+ * @param arg Argument of the operation, range 0 to 31
+ * @param hold Hold time of the keyframe, range 1 to 255
+ *
+ * @see display_animationStep()
+ */
+#define DISPLAY_KEYFRAME(op, arg, hold) (((op) << 5) | (arg)), (hold)
+
+/**
+ * @brief Keyframes of DISPLAY_ANIMATION_WIPE
+ *
+ * @see e_displayAnimation
+ */
+static const uint8_t display_anim_wipe[] PROGMEM = {
+
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 1, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 3, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 5, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 7, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 9, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 11, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 13, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 15, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 17, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 19, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 21, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 23, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 25, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 27, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_WIPE, 29, 4),
+    DISPLAY_KEYFRAME(DISPLAY_KF_END, 0, 0),
+
+};
+
+/**
+ * @brief Keyframes of DISPLAY_ANIMATION_REVEAL
+ *
+ * Up to six words are removed and added one by one, which is enough for any
+ * time on all of the supported frontpanels.
+ *
+ * @see e_displayAnimation
+ */
+static const uint8_t display_anim_reveal[] PROGMEM = {
+
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 1, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 2, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 3, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 4, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 5, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_HIDE, 6, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_REVEAL, 1, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_REVEAL, 2, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_REVEAL, 3, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_REVEAL, 4, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_REVEAL, 5, 10),
+    DISPLAY_KEYFRAME(DISPLAY_KF_END, 0, 0),
+
+};
+
+/**
+ * @brief Keyframes of DISPLAY_ANIMATION_SPARKLE
+ *
+ * @see e_displayAnimation
+ */
+static const uint8_t display_anim_sparkle[] PROGMEM = {
+
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 0, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 0, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 0, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 0, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 1, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 1, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 1, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 1, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 2, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 2, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 2, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_SPARKLE, 2, 8),
+    DISPLAY_KEYFRAME(DISPLAY_KF_END, 0, 0),
+
+};
+
+/**
+ * @brief Keyframes of all animations played back by the ISR
+ *
+ * This is indexed by e_displayAnimation minus one, as DISPLAY_ANIMATION_FADE
+ * is not implemented by means of keyframes.
+ *
+ * @see e_displayAnimation
+ * @see display_animateDisplayState()
+ */
+static const uint8_t* const display_animations[DISPLAY_ANIMATION_COUNT - 1] PROGMEM = {
+
+    display_anim_wipe,
+    display_anim_reveal,
+    display_anim_sparkle,
+
+};
+
+/**
+ * @brief Pointer to the next keyframe of the animation being played back
+ *
+ * This points into flash and is NULL while no animation is being played
+ * back. It is set up by the ISR whenever it swaps in a new frame.
+ *
+ * @see display_animations
+ * @see display_animationStep()
+ */
+static const uint8_t* g_animKeyframe;
+
+/**
+ * @brief Ticks left until the next keyframe is played back
+ *
+ * @see DISPLAY_ANIMATION_TICKS
+ * @see g_animKeyframe
+ */
+static uint16_t g_animHold;
+
+/**
+ * @brief Number of sub-frames of the front frame to be scanned out
+ *
+ * The scan-out is only active as long as this is not zero. It is set up by
+ * the ISR whenever it swaps in a new frame.
+ *
+ * @see display_frame_t::scanFrames
+ */
+static uint8_t g_scanFrameCount;
+
+/**
+ * @brief Index of the next sub-frame to be output
+ *
+ * @see display_frame_t::scanFrames
+ */
+static uint8_t g_scanFrameIdx;
+
+/**
+ * @brief Ticks left until the next sub-frame is output
+ *
+ * @see DISPLAY_SCAN_TICKS
+ */
+static uint8_t g_scanTickCounter;
+
+/**
+ * @brief Compiler barrier
+ *
+ * This makes sure that the compiler won't move any accesses to the back
+ * frame across the updates of g_dispFramePending.
+ *
+ * @see display_beginFrame()
+ * @see display_commitFrame()
+ */
+#define DISPLAY_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+/**
+ * @brief Returns the back frame, so that it can be filled in
+ *
+ * This withdraws a frame that has been committed, but not yet swapped in by
+ * the ISR (DISPLAY_TIMER_OVF_vect). Afterwards the ISR won't swap the frames
+ * until display_commitFrame() is invoked, so the back frame can be written
+ * safely, and the front frame (g_dispFrameFront) won't change in the
+ * meantime.
+ *
+ * @return Pointer to the back frame
+ *
+ * @see display_commitFrame()
+ * @see g_dispFramePending
+ */
+static display_frame_t* display_beginFrame()
+{
+
+    // The armed frame needs to be withdrawn first, see display_commitArmedFrame()
+    g_dispFrameArmed = false;
+    DISPLAY_BARRIER();
+    g_dispFramePending = false;
+    g_dispFrameArmedFired = false;
+    DISPLAY_BARRIER();
+
+    return &g_dispFrames[g_dispFrameFront ^ 1];
+
+}
+
+/**
+ * @brief Hands the back frame over to the ISR
+ *
+ * The frames are swapped by the ISR (DISPLAY_TIMER_OVF_vect) the next time
+ * it is executed, which is enabled here. While g_dispFrameArming is set, the
+ * back frame is only armed instead.
+ *
+ * @see display_beginFrame()
+ * @see g_dispFramePending
+ * @see g_dispFrameArmed
+ * @see DISPLAY_TIMER_ENABLE_INT()
  */
-static uint16_t g_curFadeStepTimer;
+static void display_commitFrame()
+{
+
+    DISPLAY_BARRIER();
+
+    if (g_dispFrameArming) {
+
+        g_dispFrameArmed = true;
+
+        return;
+
+    }
+
+    g_dispFramePending = true;
+
+    DISPLAY_TIMER_ENABLE_INT();
+
+}
 
 /**
  * @brief Outputs the given state to display
@@ -191,28 +696,40 @@ static uint16_t g_curFadeStepTimer;
  *
  * The first parameter (i_showStates) defines which words should be shown at
  * all. The second parameter (i_blinkstates) defines, which of the shown
- * words should blink. The blink interval is defined in DISPLAY_BLINK_INT_MS.
- * Only words that are set to be shown, can actually blink.
+ * words should blink. The blink interval is defined in
+ * DISPLAY_BLINK_INT_100MS. Only words that are set to be shown, can actually
+ * blink.
  *
- * Internally this function basically just sets up some variables and
- * enables the appropriate ISR (DISPLAY_TIMER_OVF_vect), which is then doing
- * the actual work. The blinking is performed by display_blinkStep().
+ * Internally this function basically just fills in the back frame and hands
+ * it over to the appropriate ISR (DISPLAY_TIMER_OVF_vect), which is then
+ * doing the actual work. The blinking is performed by display_blinkStep(),
+ * which is executed by TIMER_DISPLAY_BLINK.
  *
  * @param i_showStates Defines which words should be shown
  * @param i_blinkstates Defines which of the shown words should blink
  *
  * @see ISR(DISPLAY_TIMER_OVF_vect)
  * @see display_blinkStep()
- * @see DISPLAY_TIMER_ENABLE_INT()
+ * @see TIMER_DISPLAY_BLINK
+ * @see display_commitFrame()
  */
 void display_setDisplayState(display_state_t i_showStates, display_state_t i_blinkstates)
 {
 
-    g_blinkState = i_blinkstates & i_showStates;
-    g_curDispState = i_showStates;
-    g_curFadeStep = 0;
+    display_frame_t* frame = display_beginFrame();
 
-    DISPLAY_TIMER_ENABLE_INT();
+    frame->mode = DISPLAY_FRAME_SET;
+    frame->cur = i_showStates;
+    frame->blink = i_blinkstates & i_showStates;
+
+    display_commitFrame();
+
+    if (frame->blink && !timer_is_armed(TIMER_DISPLAY_BLINK)) {
+
+        timer_start(TIMER_DISPLAY_BLINK, TIMER_100MS | TIMER_PERIODIC,
+            DISPLAY_BLINK_INT_100MS, display_blinkStep);
+
+    }
 
 }
 
@@ -222,154 +739,782 @@ void display_setDisplayState(display_state_t i_showStates, display_state_t i_bli
  * This function fades over from the old display state to the new one, which
  * makes it look smoother than a direct output (display_setDisplayState()).
  *
- * Internally this function basically just sets up some variables and
- * enables the appropriate ISR (DISPLAY_TIMER_OVF_vect), which is then doing
- * the actual work.
+ * Internally this function basically just fills in the back frame and hands
+ * it over to the appropriate ISR (DISPLAY_TIMER_OVF_vect), which is then
+ * doing the actual work.
  *
  * @param i_showStates The new state that should be shown on the display
  *
  * @see ISR(DISPLAY_TIMER_OVF_vect)
- * @see DISPLAY_TIMER_ENABLE_INT()
+ * @see display_commitFrame()
  */
 void display_fadeDisplayState(display_state_t i_showStates)
 {
 
-    g_blinkState = 0;
-    g_oldDispState = g_curDispState;
-    g_curDispState = i_showStates;
-    g_curFadeStep = DISPLAY_FADE_STEPS - 1;
+    display_frame_t* frame = display_beginFrame();
+
+    frame->mode = DISPLAY_FRAME_FADE;
+    frame->old = g_dispFrames[g_dispFrameFront].cur;
+    frame->cur = i_showStates;
+    frame->blink = 0;
 
     if (useAutoOffAnimation) {
 
-        g_curFadeStepTimer = (DISPLAY_FADE_PERIOD_ANIM / DISPLAY_FADE_STEPS) - 1;
+        frame->fadeReload = DISPLAY_FADE_PERIOD_ANIM - 1;
 
     } else {
 
-        g_curFadeStepTimer = (DISPLAY_FADE_PERIOD / DISPLAY_FADE_STEPS) - 1;
+        frame->fadeReload = DISPLAY_FADE_PERIOD - 1;
 
     }
 
-    g_curFadeCounter = DISPLAY_FADE_STEPS - 1;
-
-    DISPLAY_TIMER_ENABLE_INT();
+    display_commitFrame();
 
 }
 
 /**
- * @brief Outputs the set up state to the display - possibly with a fading
+ * @brief Hands the given frame over to the ISR for it to be scanned out
  *
- * This ISR is doing the actual in regards to outputting the previously set up
- * display state (g_curDispState) and/or fading between the old
- * (g_oldDispState) and the new (g_curDispState) display state. It is executed
- * at a regular basis whenever the appropriate Timer/Counter will overflow
- * (DISPLAY_TIMER_OVF_vect). The frequency this ISR will be called with is
- * defined in DISPLAY_TIMER_FREQUENCY.
+ * The sub-frames of the frame (display_frame_t::scanFrames and
+ * display_frame_t::scanTicks) need to be filled in beforehand.
  *
- * It will check whether there are still fade steps left to be processed and
- * will output the appropriate data (new and/or old display state). Once the
- * actual work has been done (e.g. fading is complete and/or new display state
- * has been output), it will disable this interrupt, so it won't keep the
- * microcontroller busy.
+ * @param frame The back frame as returned by display_beginFrame()
+ * @param count Number of valid sub-frames within the frame
  *
- * @see g_curDispState
- * @see g_oldDispState
- * @see DISPLAY_TIMER_FREQUENCY
- * @see DISPLAY_TIMER_OVF_vect
- * @see g_curFadeStep
- * @see g_curFadeCounter
- * @see g_curFadeStepTimer
- * @see DISPLAY_TIMER_DISABLE_INT()
+ * @see display_setScanFrames()
+ * @see display_setIntensityState()
  */
-ISR(DISPLAY_TIMER_OVF_vect)
+static void display_commitScanOut(display_frame_t* frame, uint8_t count)
 {
 
-    if (g_curFadeStep > 0) {
-
-        if (g_curFadeCounter >= g_curFadeStep) {
+    frame->mode = DISPLAY_FRAME_SCAN;
+    frame->cur = 0;
+    frame->blink = 0;
+    frame->scanCount = count;
 
-            display_outputData(g_curDispState);
+    display_commitFrame();
 
-        } else {
-
-            display_outputData(g_oldDispState);
+}
 
-        }
+/**
+ * @brief Scans out the given sub-frames repeatedly
+ *
+ * This copies the given sub-frames into the back frame
+ * (display_frame_t::scanFrames). The appropriate ISR (DISPLAY_TIMER_OVF_vect)
+ * then outputs them one after another in an endless loop, each of them for
+ * DISPLAY_SCAN_TICKS ticks of the display timer. This makes it possible to
+ * output multiplexed patterns, e.g. to make more LEDs appear to be enabled at
+ * once than the drivers can actually source, without any involvement of the
+ * caller.
+ *
+ * The scan-out is stopped by the next invocation of display_setDisplayState()
+ * and/or display_fadeDisplayState(). A subsequent fading will start from a
+ * dark display.
+ *
+ * @param frames Pointer to the sub-frames to be scanned out
+ * @param count Number of sub-frames, at most DISPLAY_SCAN_FRAMES_MAX
+ *
+ * @see display_frame_t::scanFrames
+ * @see DISPLAY_SCAN_FRAMES_MAX
+ * @see DISPLAY_SCAN_TICKS
+ * @see ISR(DISPLAY_TIMER_OVF_vect)
+ */
+void display_setScanFrames(const display_state_t* frames, uint8_t count)
+{
 
-        if (g_curFadeCounter) {
+    if (count > DISPLAY_SCAN_FRAMES_MAX) {
 
-            g_curFadeCounter--;
+        count = DISPLAY_SCAN_FRAMES_MAX;
 
-        } else {
+    }
 
-            g_curFadeCounter = DISPLAY_FADE_STEPS - 1;
+    display_frame_t* frame = display_beginFrame();
 
-            if (g_curFadeStepTimer) {
+    for (uint8_t i = 0; i < count; i++) {
 
-                g_curFadeStepTimer--;
+        frame->scanFrames[i] = frames[i];
+        frame->scanTicks[i] = DISPLAY_SCAN_TICKS;
 
-            } else {
+    }
 
-                if (useAutoOffAnimation) {
+    display_commitScanOut(frame, count);
 
-                    g_curFadeStepTimer = (DISPLAY_FADE_PERIOD_ANIM / DISPLAY_FADE_STEPS) - 1;
+}
 
-                } else {
+/**
+ * @brief Sets the intensity of the given words within an intensity state
+ *
+ * @param o_state The intensity state to be manipulated
+ * @param i_words The words whose intensity should be set
+ * @param level The intensity to set, range 0 to DISPLAY_INTENSITY_MAX
+ *
+ * @see display_intensity_state_t
+ * @see display_setIntensityState()
+ */
+void display_setIntensity(display_intensity_state_t* o_state, display_state_t i_words, uint8_t level)
+{
 
-                    g_curFadeStepTimer = (DISPLAY_FADE_PERIOD / DISPLAY_FADE_STEPS) - 1;
+    level &= DISPLAY_INTENSITY_MAX;
 
-                }
+    for (uint8_t i = 0; i < sizeof(o_state->levels); i++) {
 
-                g_curFadeStep--;
+        if (i_words & 1) {
 
-            }
+            o_state->levels[i] = (o_state->levels[i] & 0xf0) | level;
 
         }
 
-    } else {
+        if (i_words & 2) {
 
-        display_outputData(g_curDispState);
+            o_state->levels[i] = (o_state->levels[i] & 0x0f) | (level << 4);
 
-        DISPLAY_TIMER_DISABLE_INT();
+        }
+
+        i_words >>= 2;
 
     }
 
 }
 
 /**
- * @brief Performs the blinking effect
+ * @brief Outputs the given intensity state by means of binary code modulation
  *
- * This implements the blinking effect for chosen words (g_blinkState) of the
- * display. This function is called by a timer ISR on a regular basis
- * (INTERRUPT_10HZ). The blinking interval of the words itself is defined by
- * DISPLAY_BLINK_INT_100MS. However it will only be half as big, as with each
- * execution of this function the bit pattern will be flipped and it takes two
- * flips to get back to the original state again.
+ * The intensity state is split up into one bit plane per bit of the
+ * intensity (DISPLAY_INTENSITY_BITS), which are then scanned out by the
+ * appropriate ISR (DISPLAY_TIMER_OVF_vect). The bit plane of the least
+ * significant bit is output for DISPLAY_INTENSITY_TICKS, each following one
+ * for twice as long as the previous one. This way each word is enabled for
+ * a share of the period proportional to its intensity, while the display
+ * only needs to be updated once per bit plane.
  *
- * The blinking effect will only be performed when there actually are any words
- * that should be blinking (g_blinkState != 0) and when no fading is currently
- * going on (g_curFadeStep != 0).
+ * Just like with display_setScanFrames() the output is stopped by the next
+ * invocation of display_setDisplayState() and/or display_fadeDisplayState().
  *
- * @see g_blinkState
- * @see INTERRUPT_10HZ
- * @see DISPLAY_BLINK_INT_100MS
+ * @param i_state The intensity state to be output
+ *
+ * @see display_intensity_state_t
+ * @see display_setIntensity()
+ * @see DISPLAY_INTENSITY_TICKS
+ * @see ISR(DISPLAY_TIMER_OVF_vect)
  */
-void display_blinkStep()
+void display_setIntensityState(const display_intensity_state_t* i_state)
+{
+
+    display_frame_t* frame = display_beginFrame();
+    display_state_t* planes = frame->scanFrames;
+
+    for (uint8_t bit = 0; bit < DISPLAY_INTENSITY_BITS; bit++) {
+
+        planes[bit] = 0;
+        frame->scanTicks[bit] = DISPLAY_INTENSITY_TICKS << bit;
+
+    }
+
+    for (uint8_t i = 0; i < sizeof(i_state->levels); i++) {
+
+        uint8_t levels = i_state->levels[i];
+
+        for (uint8_t bit = 0; bit < DISPLAY_INTENSITY_BITS; bit++) {
+
+            if (levels & _BV(bit)) {
+
+                planes[bit] |= (display_state_t)1 << (2 * i);
+
+            }
+
+            if (levels & _BV(bit + 4)) {
+
+                planes[bit] |= (display_state_t)1 << (2 * i + 1);
+
+            }
+
+        }
+
+    }
+
+    display_commitScanOut(frame, DISPLAY_INTENSITY_BITS);
+
+}
+
+/**
+ * @brief Changes over to the given state using the chosen animation
+ *
+ * This changes over from the current display state to the given one by
+ * means of the animation chosen within display_prefs_t::animation. For
+ * DISPLAY_ANIMATION_FADE (and any unknown value) this is the same as
+ * display_fadeDisplayState(). Otherwise the appropriate keyframes are played
+ * back from flash by the ISR (DISPLAY_TIMER_OVF_vect), see
+ * display_animationStep().
+ *
+ * @param i_showStates The new state that should be shown on the display
+ *
+ * @see e_displayAnimation
+ * @see display_prefs_t::animation
+ * @see display_animations
+ * @see display_fadeDisplayState()
+ */
+void display_animateDisplayState(display_state_t i_showStates)
+{
+
+    uint8_t animation = g_display_prefs->animation;
+
+    if (animation == DISPLAY_ANIMATION_FADE || animation >= DISPLAY_ANIMATION_COUNT) {
+
+        display_fadeDisplayState(i_showStates);
+
+        return;
+
+    }
+
+    display_frame_t* frame = display_beginFrame();
+
+    frame->mode = DISPLAY_FRAME_ANIMATE;
+    frame->old = g_dispFrames[g_dispFrameFront].cur;
+    frame->cur = i_showStates;
+    frame->blink = 0;
+    frame->animation = (const uint8_t*)pgm_read_word(&display_animations[animation - 1]);
+
+    display_commitFrame();
+
+}
+
+/**
+ * @brief Prepares the change over to the given state for the next minute
+ *
+ * This fills in the back frame just like display_animateDisplayState(), but
+ * doesn't hand it over to the ISR yet. This is done by
+ * display_commitArmedFrame() once the next minute begins, so the animation
+ * starts right at the boundary, no matter how long it takes the main loop
+ * to notice the new minute. Any other change of the display in the meantime
+ * withdraws the armed frame.
+ *
+ * @param i_showStates The state that should be shown with the next minute
+ *
+ * @return True if the frame has been armed, false if another frame is still
+ * waiting to be swapped in
+ *
+ * @see display_commitArmedFrame()
+ * @see display_isArmedStateShown()
+ * @see display_armNewTime()
+ */
+bool display_armDisplayState(display_state_t i_showStates)
+{
+
+    if (g_dispFramePending) {
+
+        return false;
+
+    }
+
+    g_dispArmedState = i_showStates;
+
+    g_dispFrameArming = true;
+    display_animateDisplayState(i_showStates);
+    g_dispFrameArming = false;
+
+    return true;
+
+}
+
+/**
+ * @brief Hands the armed frame over to the ISR
+ *
+ * This is invoked by datetime_ISR() once the seconds roll over to a new
+ * minute. Nothing happens unless a frame has been armed by
+ * display_armDisplayState().
+ *
+ * @note This is executed from within an ISR.
+ *
+ * @see display_armDisplayState()
+ * @see g_dispFrameArmed
+ */
+void display_commitArmedFrame()
+{
+
+    if (!g_dispFrameArmed) {
+
+        return;
+
+    }
+
+    g_dispFrameArmed = false;
+    g_dispFrameArmedFired = true;
+    g_dispFramePending = true;
+
+    DISPLAY_TIMER_ENABLE_INT();
+
+}
+
+/**
+ * @brief Returns whether the display is already changing over to the given
+ * state by means of the armed frame
+ *
+ * @param i_showStates The state to check for
+ *
+ * @return True if the armed frame has been handed over and changes over to
+ * the given state, false otherwise
+ *
+ * @see display_armDisplayState()
+ * @see display_fadeNewTime()
+ */
+bool display_isArmedStateShown(display_state_t i_showStates)
+{
+
+    return g_dispFrameArmedFired && g_dispArmedState == i_showStates;
+
+}
+
+/**
+ * @brief Returns the lowest n bits set within the given state
+ *
+ * @param state The state to take the bits from
+ * @param n Number of bits to return at most
+ *
+ * @return State containing the lowest n bits set within the given state
+ *
+ * @see DISPLAY_KF_HIDE
+ * @see DISPLAY_KF_REVEAL
+ */
+static display_state_t display_lowestBits(display_state_t state, uint8_t n)
+{
+
+    display_state_t result = 0;
+
+    while (n-- && state) {
+
+        display_state_t lowest = state & -state;
+
+        result |= lowest;
+        state &= ~lowest;
+
+    }
+
+    return result;
+
+}
+
+/**
+ * @brief Random state with roughly the given share of bits being set
+ *
+ * @param share 0 for roughly 1/4, 1 for 1/2 and 2 for 3/4
+ *
+ * @return Random state
+ *
+ * @see DISPLAY_KF_SPARKLE
+ * @see prng_fill()
+ */
+static display_state_t display_randomState(uint8_t share)
 {
 
-    if (g_blinkState && (g_curFadeStep == 0)) {
+    display_state_t result = 0;
+    uint8_t r[2 * sizeof(display_state_t)];
+
+    prng_fill(r, sizeof(r));
 
-        static uint8_t s_blinkPrescale = DISPLAY_BLINK_INT_100MS;
+    for (uint8_t i = 0; i < sizeof(display_state_t); i++) {
 
-        if (!(--s_blinkPrescale)) {
+        uint8_t x = r[i];
 
-            g_curDispState ^= g_blinkState;
+        if (share == 0) {
 
-            display_outputData(g_curDispState);
+            x &= r[i + sizeof(display_state_t)];
 
-            s_blinkPrescale = DISPLAY_BLINK_INT_100MS;
+        } else if (share == 2) {
+
+            x |= r[i + sizeof(display_state_t)];
 
         }
 
+        result = (result << 8) | x;
+
+    }
+
+    return result;
+
+}
+
+/**
+ * @brief Plays back the next keyframe of the current animation
+ *
+ * This reads the next keyframe from flash (g_animKeyframe), calculates the
+ * state described by it from the old (display_frame_t::old) and the new
+ * (display_frame_t::cur) state of the given frame and outputs it. Once
+ * DISPLAY_KF_END is reached, the new state is output and the animation is
+ * over.
+ *
+ * @param frame The front frame
+ *
+ * @see DISPLAY_KEYFRAME()
+ * @see ISR(DISPLAY_TIMER_OVF_vect)
+ */
+static void display_animationStep(const display_frame_t* frame)
+{
+
+    uint8_t opArg = pgm_read_byte(g_animKeyframe);
+    uint8_t hold = pgm_read_byte(g_animKeyframe + 1);
+    uint8_t arg = opArg & 0x1f;
+
+    display_state_t oldState = frame->old;
+    display_state_t newState = frame->cur;
+    display_state_t common = oldState & newState;
+    display_state_t state;
+
+    switch (opArg >> 5) {
+
+        case DISPLAY_KF_OLD:
+
+            state = oldState;
+
+            break;
+
+        case DISPLAY_KF_OFF:
+
+            state = 0;
+
+            break;
+
+        case DISPLAY_KF_WIPE:
+
+        {
+
+            display_state_t mask = ((display_state_t)2 << arg) - 1;
+            state = (newState & mask) | (oldState & ~mask);
+
+            break;
+
+        }
+
+        case DISPLAY_KF_HIDE:
+
+            state = oldState & ~display_lowestBits(oldState & ~newState, arg);
+
+            break;
+
+        case DISPLAY_KF_REVEAL:
+
+            state = common | display_lowestBits(newState & ~oldState, arg);
+
+            break;
+
+        case DISPLAY_KF_SPARKLE:
+
+        {
+
+            display_state_t mask = display_randomState(arg);
+            state = (newState & mask) | (oldState & ~mask);
+
+            break;
+
+        }
+
+        default:
+
+            g_animKeyframe = NULL;
+            display_outputData(newState);
+            DISPLAY_TIMER_DISABLE_INT();
+
+            return;
+
+    }
+
+    display_outputData(state);
+
+    g_animKeyframe += 2;
+    g_animHold = (uint16_t)hold * DISPLAY_ANIMATION_TICKS - 1;
+
+}
+
+/**
+ * @brief Swaps in the back frame once it has been committed
+ *
+ * This is invoked by the ISR (DISPLAY_TIMER_OVF_vect) only. It makes the back
+ * frame the front frame and sets up the variables used to change over to it
+ * depending upon its mode (display_frame_t::mode).
+ *
+ * @return Pointer to the new front frame
+ *
+ * @see display_commitFrame()
+ * @see e_displayFrameMode
+ */
+static const display_frame_t* display_swapFrame()
+{
+
+    uint8_t front = g_dispFrameFront ^ 1;
+    const display_frame_t* frame = &g_dispFrames[front];
+
+    g_dispFrameFront = front;
+    g_dispFramePending = false;
+
+    g_blinkPhase = false;
+    g_scanFrameCount = 0;
+    g_animKeyframe = NULL;
+    g_curFadeStep = 0;
+
+    switch (frame->mode) {
+
+        case DISPLAY_FRAME_FADE:
+
+            /*
+             * The first toggle ends a cycle that never began, so the step
+             * timer needs to be one more than usual
+             */
+            g_curFadeStepTimer = frame->fadeReload + 1;
+            g_curFadeDuty = pgm_read_byte(&display_fade_schedule[0]);
+            g_curFadeShowsOld = true;
+            g_curFadeCounter = 0;
+            g_curFadeStep = DISPLAY_FADE_STEPS;
+
+            break;
+
+        case DISPLAY_FRAME_ANIMATE:
+
+            g_animKeyframe = frame->animation;
+            g_animHold = 0;
+
+            break;
+
+        case DISPLAY_FRAME_SCAN:
+
+            g_scanFrameIdx = 0;
+            g_scanTickCounter = 0;
+            g_scanFrameCount = frame->scanCount;
+
+            break;
+
+    }
+
+    return frame;
+
+}
+
+/**
+ * @brief Toggles the output during the fading
+ *
+ * This is invoked by the ISR (DISPLAY_TIMER_OVF_vect) whenever
+ * g_curFadeCounter has run out. Within the current cycle it switches over
+ * to the old state once the new one has been output for g_curFadeDuty
+ * ticks. Otherwise the cycle is over, so the fade step is advanced, the new
+ * state is output again and the next cycle begins. Once the last step is
+ * over, the new state is left on the display and the ISR is disabled.
+ *
+ * As g_curFadeCounter is set to the distance to the next toggle each time,
+ * this is only invoked twice per cycle, regardless of the length of the
+ * cycle. The display is only updated when the output actually changes, so
+ * cycles consisting of the new state only don't cause any updates at all.
+ *
+ * @param frame The front frame
+ *
+ * @see g_curFadeCounter
+ * @see g_curFadeShowsOld
+ * @see display_fade_schedule
+ */
+static void display_fadeToggle(const display_frame_t* frame)
+{
+
+    if (!g_curFadeShowsOld && g_curFadeDuty < DISPLAY_FADE_CYCLE) {
+
+        display_outputData(frame->old);
+
+        g_curFadeShowsOld = true;
+        g_curFadeCounter = DISPLAY_FADE_CYCLE - g_curFadeDuty - 1;
+
+        return;
+
+    }
+
+    if (g_curFadeStepTimer) {
+
+        g_curFadeStepTimer--;
+
+    } else {
+
+        g_curFadeStepTimer = frame->fadeReload;
+        g_curFadeStep--;
+
+        if (g_curFadeStep) {
+
+            g_curFadeDuty = pgm_read_byte(
+                &display_fade_schedule[DISPLAY_FADE_STEPS - g_curFadeStep]);
+
+        } else {
+
+            DISPLAY_TIMER_DISABLE_INT();
+
+        }
+
+    }
+
+    /*
+     * With a duty cycle of DISPLAY_FADE_CYCLE the new state is still shown
+     */
+    if (g_curFadeShowsOld) {
+
+        display_outputData(frame->cur);
+
+    }
+
+    g_curFadeShowsOld = false;
+    g_curFadeCounter = g_curFadeDuty - 1;
+
+}
+
+/**
+ * @brief Outputs the set up state to the display - possibly with a fading
+ *
+ * This ISR is doing the actual in regards to outputting the previously set up
+ * display state (display_frame_t::cur) and/or fading between the old
+ * (display_frame_t::old) and the new (display_frame_t::cur) display state of
+ * the front frame. It is executed at a regular basis whenever the appropriate
+ * Timer/Counter will overflow (DISPLAY_TIMER_OVF_vect). The frequency this
+ * ISR will be called with is defined in DISPLAY_TIMER_FREQUENCY.
+ *
+ * Whenever a new frame has been committed (g_dispFramePending), it is swapped
+ * in first, see display_swapFrame(). As this is the only place the front
+ * frame is changed, the ISR always works on a consistent frame.
+ *
+ * It will check whether there are still fade steps left to be processed and
+ * will output the appropriate data (new and/or old display state). The ratio
+ * between both states is looked up from display_fade_schedule, and the
+ * display is only updated when the state to be shown actually changes, i.e.
+ * twice per fade cycle (DISPLAY_FADE_CYCLE), see display_fadeToggle(). In
+ * between only g_curFadeCounter is decremented. Once the actual work has been
+ * done (e.g. fading is complete and/or new display state has been output), it
+ * will disable this interrupt, so it won't keep the microcontroller busy.
+ * The blinking words are left out while g_blinkPhase is set.
+ *
+ * While the scan-out is active (g_scanFrameCount), it outputs the sub-frames
+ * of the front frame (display_frame_t::scanFrames) one after another instead,
+ * each of them for the amount of ticks defined in display_frame_t::scanTicks,
+ * and stays enabled. This is also used for the binary code modulation, see
+ * display_setIntensityState(). While an animation is being played back
+ * (g_animKeyframe), the keyframes are handled by display_animationStep().
+ *
+ * @see display_frame_t
+ * @see display_swapFrame()
+ * @see DISPLAY_TIMER_FREQUENCY
+ * @see DISPLAY_TIMER_OVF_vect
+ * @see g_curFadeStep
+ * @see g_curFadeCounter
+ * @see display_fadeToggle()
+ * @see DISPLAY_TIMER_DISABLE_INT()
+ */
+ISR(DISPLAY_TIMER_OVF_vect)
+{
+
+    PROFILE_ISR_ENTER();
+    MEMCHECK_ISR_ENTER(PROFILE_ISR_DISPLAY);
+
+    const display_frame_t* frame;
+
+    if (g_dispFramePending) {
+
+        frame = display_swapFrame();
+
+    } else {
+
+        frame = &g_dispFrames[g_dispFrameFront];
+
+    }
+
+    if (g_scanFrameCount) {
+
+        if (g_scanTickCounter == 0) {
+
+            display_outputData(frame->scanFrames[g_scanFrameIdx]);
+            g_scanTickCounter = frame->scanTicks[g_scanFrameIdx];
+
+            if (++g_scanFrameIdx >= g_scanFrameCount) {
+
+                g_scanFrameIdx = 0;
+
+            }
+
+        }
+
+        g_scanTickCounter--;
+
+    } else if (g_animKeyframe) {
+
+        if (g_animHold) {
+
+            g_animHold--;
+
+        } else {
+
+            display_animationStep(frame);
+
+        }
+
+    } else if (g_curFadeStep > 0) {
+
+        if (g_curFadeCounter) {
+
+            g_curFadeCounter--;
+
+        } else {
+
+            display_fadeToggle(frame);
+
+        }
+
+    } else {
+
+        if (g_blinkPhase) {
+
+            display_outputData(frame->cur ^ frame->blink);
+
+        } else {
+
+            display_outputData(frame->cur);
+
+        }
+
+        DISPLAY_TIMER_DISABLE_INT();
+
+    }
+
+    PROFILE_ISR_EXIT(PROFILE_ISR_DISPLAY,
+        DISPLAY_TIMER_INTERRUPT_FLAG_REGISTER & _BV(DISPLAY_TIMER_INTERRUPT_FLAG));
+
+}
+
+/**
+ * @brief Performs the blinking effect
+ *
+ * This implements the blinking effect for chosen words (display_frame_t::blink)
+ * of the display. It is executed from within the timer ISR whenever
+ * TIMER_DISPLAY_BLINK has expired, which is started by
+ * display_setDisplayState() with an interval of DISPLAY_BLINK_INT_100MS. The
+ * blinking interval of the words itself will be twice as big, as with each
+ * execution of this function the phase (g_blinkPhase) will be flipped and it
+ * takes two flips to get back to the original state again.
+ *
+ * This doesn't touch the display state itself. It only flips the phase and
+ * enables the ISR (DISPLAY_TIMER_OVF_vect), which then outputs the front
+ * frame accordingly.
+ *
+ * Once there are no longer any words that should be blinking
+ * (display_frame_t::blink == 0), the timer is stopped. No blinking is
+ * performed while fading is going on, as fading frames never contain any
+ * blinking words.
+ *
+ * @see g_blinkPhase
+ * @see TIMER_DISPLAY_BLINK
+ * @see DISPLAY_BLINK_INT_100MS
+ */
+void display_blinkStep()
+{
+
+    if (!g_dispFrames[g_dispFrameFront].blink) {
+
+        timer_stop(TIMER_DISPLAY_BLINK);
+
+    } else {
+
+        g_blinkPhase = !g_blinkPhase;
+
+        DISPLAY_TIMER_ENABLE_INT();
+
     }
 
 }
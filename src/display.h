@@ -53,11 +53,11 @@
  * as this defines how often the bit pattern should be flipped and it takes two
  * flips to get back to the original state again. The blinking effect itself is
  * implemented by display_blinkStep(). Words that should blink in the current
- * state are stored within g_blinkState.
+ * state are stored within display_frame_t::blink.
  *
  * The default value for this option is 7 (700 ms).
  *
- * @see g_blinkState
+ * @see display_frame_t::blink
  * @see display_blinkStep()
  */
 #define DISPLAY_BLINK_INT_100MS 7
@@ -95,6 +95,37 @@
  */
 #define DISPLAY_FADE_TIME_ANIM_MS 1000
 
+/**
+ * @brief Maximum number of sub-frames within the scan-out frame buffer
+ *
+ * @see display_setScanFrames()
+ */
+#define DISPLAY_SCAN_FRAMES_MAX 8
+
+/**
+ * @brief Number of display timer ticks each sub-frame is output for
+ *
+ * With the default value of 4 each sub-frame is output for roughly 1 ms
+ * (DISPLAY_TIMER_FREQUENCY / 4).
+ *
+ * @see DISPLAY_TIMER_FREQUENCY
+ * @see display_setScanFrames()
+ */
+#define DISPLAY_SCAN_TICKS 4
+
+/**
+ * @brief Number of display timer ticks a single unit of keyframe hold time
+ * takes
+ *
+ * The hold times of the keyframes of animations (see e_displayAnimation) are
+ * given in multiples of this. With the default value of 16 this is roughly
+ * 4 ms.
+ *
+ * @see DISPLAY_TIMER_FREQUENCY
+ * @see display_animateDisplayState()
+ */
+#define DISPLAY_ANIMATION_TICKS 16
+
 /**
  * @brief Overflow interrupt vector of the Timer/Counter involved
  *
@@ -145,6 +176,30 @@
  */
 #define DISPLAY_TIMER_INTERRUPT_ENABLE TOIE2
 
+/**
+ * @brief Interrupt flag register of the Timer/Counter involved
+ *
+ * This macro stores the interrupt flag register of the Timer/Counter
+ * responsible for the display module. It is used to detect overruns of
+ * DISPLAY_TIMER_OVF_vect, see ENABLE_DEBUG_ISR_PROFILE.
+ *
+ * @note When actually changing this, make sure to also change and/or check
+ * DISPLAY_TIMER_OVF_vect and DISPLAY_TIMER_INTERRUPT_FLAG.
+ *
+ * @see DISPLAY_TIMER_INTERRUPT_FLAG
+ */
+#define DISPLAY_TIMER_INTERRUPT_FLAG_REGISTER TIFR2
+
+/**
+ * @brief Overflow flag bit of the Timer/Counter involved
+ *
+ * @note When actually changing this, make sure to also change and/or check
+ * DISPLAY_TIMER_OVF_vect and DISPLAY_TIMER_INTERRUPT_FLAG_REGISTER.
+ *
+ * @see DISPLAY_TIMER_INTERRUPT_FLAG_REGISTER
+ */
+#define DISPLAY_TIMER_INTERRUPT_FLAG TOV2
+
 /**
  * @brief Macro used to enable the involved Timer/Counter interrupt
  *
@@ -187,6 +242,97 @@
  */
 #define DISPLAY_TIMER_FREQUENCY 3906
 
+/**
+ * @brief Controls whether time states are looked up from a table in flash
+ *
+ * If set to 1, a table is generated at compile time from the layout of the
+ * frontpanel (see display_wc.h), which contains the display state for each
+ * mode, hour and five minute "block". This table is stored in program space
+ * and display_getTimeState() only needs to look up the appropriate entry
+ * (apart from the phrase "it is" and the minute LEDs, which are still applied
+ * at runtime). This makes the
+ * conversion from time to display state fast and deterministic, at the cost
+ * of some program space (576 bytes per mode).
+ *
+ * If set to 0, the display state will be calculated at runtime.
+ *
+ * @see display_getTimeState()
+ * @see DISPLAY_TIME_STATES_MODE()
+ */
+#define DISPLAY_USE_TIME_STATE_TABLE 0
+
+/**
+ * @brief Helper for defining an array from a list macro
+ *
+ * Language specific data is defined by list macros of the form
+ * `LIST(X, i)`, which invoke `X(i, n, v)` for each entry, where n is the
+ * index and v the value of the entry. Passing this macro as X expands the
+ * list into a comma separated initializer.
+ *
+ * @see DISPLAY_LIST_SELECT()
+ */
+#define DISPLAY_LIST_ENTRY(i, n, v) (v),
+
+/**
+ * @brief Helper for selecting an entry from a list macro at compile time
+ *
+ * Passing this macro as X to a list macro (see DISPLAY_LIST_ENTRY()) expands
+ * to a chain of conditional expressions, which selects the entry with index
+ * i. The chain needs to be terminated with a default value, e.g.
+ * `(LIST(DISPLAY_LIST_SELECT, i) 0)`. As long as i is a constant expression
+ * the result is a constant expression, too.
+ *
+ * @see DISPLAY_LIST_ENTRY()
+ */
+#define DISPLAY_LIST_SELECT(i, n, v) ((i) == (n)) ? (v) :
+
+#if (DISPLAY_USE_TIME_STATE_TABLE == 1)
+
+    /**
+     * @brief Expands to the time states of a single hour
+     *
+     * This expands to an initializer containing the display states for all
+     * twelve five minute "blocks" of the given hour by invoking ts with the
+     * appropriate parameters.
+     *
+     * @param ts Language specific macro of the form `ts(mode, hour, block)`
+     * @param m Mode
+     * @param h Hour (0 - 11)
+     *
+     * @see DISPLAY_TIME_STATES_MODE()
+     */
+    #define DISPLAY_TIME_STATES_HOUR(ts, m, h) { \
+        ts(m, h, 0), ts(m, h, 1), ts(m, h, 2), ts(m, h, 3), \
+        ts(m, h, 4), ts(m, h, 5), ts(m, h, 6), ts(m, h, 7), \
+        ts(m, h, 8), ts(m, h, 9), ts(m, h, 10), ts(m, h, 11) \
+    }
+
+    /**
+     * @brief Expands to the time states of a single mode
+     *
+     * This expands to an initializer containing the display states for all
+     * twelve hours of the given mode, see DISPLAY_TIME_STATES_HOUR(). The
+     * result can be used to initialize an array of type
+     * `display_state_t [12][12]`, which is indexed by hour and five minute
+     * "block".
+     *
+     * @param ts Language specific macro of the form `ts(mode, hour, block)`
+     * @param m Mode
+     *
+     * @see DISPLAY_USE_TIME_STATE_TABLE
+     * @see DISPLAY_TIME_STATES_HOUR()
+     */
+    #define DISPLAY_TIME_STATES_MODE(ts, m) { \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 0), DISPLAY_TIME_STATES_HOUR(ts, m, 1), \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 2), DISPLAY_TIME_STATES_HOUR(ts, m, 3), \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 4), DISPLAY_TIME_STATES_HOUR(ts, m, 5), \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 6), DISPLAY_TIME_STATES_HOUR(ts, m, 7), \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 8), DISPLAY_TIME_STATES_HOUR(ts, m, 9), \
+        DISPLAY_TIME_STATES_HOUR(ts, m, 10), DISPLAY_TIME_STATES_HOUR(ts, m, 11) \
+    }
+
+#endif /* (DISPLAY_USE_TIME_STATE_TABLE == 1) */
+
 /**
  * @brief Allowing access to global instance of display_prefs backed by EEPROM
  *
@@ -206,6 +352,91 @@
  */
 typedef uint32_t display_state_t;
 
+/**
+ * @brief Number of bits of the intensity of a single word
+ *
+ * @see display_intensity_state_t
+ */
+#define DISPLAY_INTENSITY_BITS 4
+
+/**
+ * @brief Intensity of a word being fully enabled
+ *
+ * @see display_intensity_state_t
+ */
+#define DISPLAY_INTENSITY_MAX ((1 << DISPLAY_INTENSITY_BITS) - 1)
+
+/**
+ * @brief Number of display timer ticks the least significant bit plane is
+ * output for
+ *
+ * The bit plane of each higher bit is output twice as long as the previous
+ * one, so a whole period takes DISPLAY_INTENSITY_MAX times this value. With
+ * the default value of 1 this is roughly 260 Hz.
+ *
+ * @see DISPLAY_TIMER_FREQUENCY
+ * @see display_setIntensityState()
+ */
+#define DISPLAY_INTENSITY_TICKS 1
+
+/**
+ * @brief Type definition for storing a display state with intensities
+ *
+ * In contrast to display_state_t each word has an intensity
+ * (DISPLAY_INTENSITY_BITS) rather than just being enabled and/or disabled.
+ * Two words are packed into each byte, the word with the even position
+ * within the lower nibble. It should be manipulated using
+ * display_setIntensity() only.
+ *
+ * @see display_setIntensity()
+ * @see display_setIntensityState()
+ */
+typedef struct {
+
+    uint8_t levels[sizeof(display_state_t) * 8 / 2];
+
+} display_intensity_state_t;
+
+/**
+ * @brief Animations available for changing over to a new time
+ *
+ * Except for DISPLAY_ANIMATION_FADE, which is implemented by
+ * display_fadeDisplayState(), these are sequences of keyframes stored in
+ * flash, which are played back by the ISR of the display module.
+ *
+ * @see display_prefs_t::animation
+ * @see display_animateDisplayState()
+ */
+typedef enum {
+
+    /**
+     * @brief Crossfade between the old and the new time
+     *
+     * @see display_fadeDisplayState()
+     */
+    DISPLAY_ANIMATION_FADE,
+
+    /**
+     * @brief The new time is wiped in position by position
+     */
+    DISPLAY_ANIMATION_WIPE,
+
+    /**
+     * @brief Words disappear one by one, then the new ones appear one by one
+     */
+    DISPLAY_ANIMATION_REVEAL,
+
+    /**
+     * @brief Random words of the new time flicker in
+     *
+     * @see prng_rand()
+     */
+    DISPLAY_ANIMATION_SPARKLE,
+
+    DISPLAY_ANIMATION_COUNT
+
+} e_displayAnimation;
+
 /**
  * @brief Data of the display module that should be stored persistently in EEPROM
  *
@@ -244,6 +475,20 @@ extern void display_setDisplayState(display_state_t i_showStates, display_state_
 
 extern void display_fadeDisplayState(display_state_t i_showStates);
 
+extern void display_setScanFrames(const display_state_t* frames, uint8_t count);
+
+extern void display_setIntensity(display_intensity_state_t* o_state, display_state_t i_words, uint8_t level);
+
+extern void display_setIntensityState(const display_intensity_state_t* i_state);
+
+extern void display_animateDisplayState(display_state_t i_showStates);
+
+extern bool display_armDisplayState(display_state_t i_showStates);
+
+extern void display_commitArmedFrame();
+
+extern bool display_isArmedStateShown(display_state_t i_showStates);
+
 extern void display_blinkStep();
 
 extern void display_autoOffAnimStep1Hz(bool animPreview);
@@ -266,9 +511,9 @@ static inline display_state_t display_getIndicatorMask();
  * with the clock while setting the time itself. In case of the Wordclock it
  * makes sense to use the phrase "clock" for that purpose.
  *
- * This is effectively implemented in the language specific files, as it
- * is depending upon the way the LEDs are connected to the frontpanel, see
- * e_displayWordPos.
+ * This is effectively implemented in display_wc.h by means of
+ * DISPLAY_NUMBERS_LIST, as it is depending upon the way the LEDs are
+ * connected to the frontpanel, see e_displayWordPos.
  *
  * @return A display state with activated indicators
  */
@@ -347,21 +592,52 @@ static inline void display_setNewTime(const datetime_t* i_newDateTime)
 }
 
 /**
- * @brief Sets a new time to be shown on the display by fading out the old one
+ * @brief Sets a new time to be shown on the display by animating the change
  *
  * This function should be called on each time change, at least one to two
- * times per minute.
+ * times per minute. The animation used is the one chosen within
+ * display_prefs_t::animation, which defaults to a crossfade. Nothing is done
+ * if the change over to this time has already been started at the boundary
+ * of the minute, see display_armNewTime().
  *
  * @param i_newDateTime The new time that should be shown on the display
  *
  * @see datetime_t
- * @see display_fadeDisplayState()
+ * @see display_animateDisplayState()
+ * @see display_isArmedStateShown()
  * @see display_getTimeState()
  */
 static inline void display_fadeNewTime(const datetime_t* i_newDateTime)
 {
 
-    display_fadeDisplayState(display_getTimeState(i_newDateTime));
+    display_state_t state = display_getTimeState(i_newDateTime);
+
+    if (!display_isArmedStateShown(state)) {
+
+        display_animateDisplayState(state);
+
+    }
+
+}
+
+/**
+ * @brief Prepares the change over to the time of the next minute
+ *
+ * This should be called during the last second of a minute with the time of
+ * the next minute. The change over is then started by the ISR of the
+ * datetime module right at the boundary of the minute.
+ *
+ * @param i_newDateTime The time that should be shown with the next minute
+ *
+ * @return True if the change over has been prepared, false otherwise
+ *
+ * @see display_armDisplayState()
+ * @see display_fadeNewTime()
+ */
+static inline bool display_armNewTime(const datetime_t* i_newDateTime)
+{
+
+    return display_armDisplayState(display_getTimeState(i_newDateTime));
 
 }
 
@@ -25,23 +25,209 @@
  * This file contains implementation of things specific to the display type
  * "Wordclock". However it is language independent and generic to all
  * languages defined for this type of display. Among other things this file
- * contains the initialization routine as well as a routine to output data to
- * the display.
+ * contains the initialization routine, a routine to output data to the
+ * display as well as display_getTimeState(), which is driven by the layout
+ * described within the language specific header (see display_wc.h).
  *
  * @note This file should be left untouched if making adaptations to other
  * languages. Language specific things reside in their own files, e.g.
- * display_wc_[language].h/c.
+ * display_wc_[language].h.
  *
  * @see display_wc.h
  */
 
+#include <inttypes.h>
+#include <stdbool.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
 #include <avr/pgmspace.h>
 
 #include "config.h"
 #include "display.h"
 #include "shift.h"
-#include "uart.h"
+#include "log.h"
 #include "ports.h"
+#include "preferences.h"
+#include "prng.h"
+
+/**
+ * @brief Minute definitions of the frontpanel
+ *
+ * @see DISPLAY_MIN_DATA_LIST
+ * @see display_getTimeState()
+ */
+static const uint16_t s_minData[] PROGMEM = {
+
+    DISPLAY_MIN_DATA_LIST(DISPLAY_LIST_ENTRY, 0)
+
+};
+
+/**
+ * @brief Start indexes for each "block" within s_minData
+ *
+ * @see DISPLAY_MIN_START_IND_LIST
+ * @see display_getTimeState()
+ */
+static const uint8_t s_minStartInd[13] PROGMEM = {
+
+    DISPLAY_MIN_START_IND_LIST(DISPLAY_LIST_ENTRY, 0)
+
+};
+
+/**
+ * @brief Position of the sub indexes for each "block" within s_modes
+ *
+ * @see DISPLAY_MODE_SHIFT_MASK_LIST
+ * @see display_getTimeState()
+ */
+static const uint8_t s_modeShiftMask[12] PROGMEM = {
+
+    DISPLAY_MODE_SHIFT_MASK_LIST(DISPLAY_LIST_ENTRY, 0)
+
+};
+
+/**
+ * @brief Variants chosen for each "block" in each of the modes
+ *
+ * @see DISPLAY_MODES_LIST
+ * @see display_getTimeState()
+ */
+static const uint16_t s_modes[DISPLAY_MODE_COUNT] PROGMEM = {
+
+    DISPLAY_MODES_LIST(DISPLAY_LIST_ENTRY, 0)
+
+};
+
+/**
+ * @brief Hour words for each number from one to twelve
+ *
+ * @see DISPLAY_NUMBERS_LIST
+ * @see display_getNumberDisplayState()
+ */
+const uint16_t s_numbers[12] PROGMEM = {
+
+    DISPLAY_NUMBERS_LIST(DISPLAY_LIST_ENTRY, 0)
+
+};
+
+#if (DISPLAY_USE_TIME_STATE_TABLE == 1)
+
+    /**
+     * @brief Index within s_minData for the given mode bitset and "block"
+     *
+     * This is the compile time equivalent to the calculation performed
+     * within display_getTimeState(), see s_modes and s_modeShiftMask.
+     *
+     * @param v Mode bitset (see DISPLAY_MODES_LIST)
+     * @param k Five minute "block" (0 - 11)
+     */
+    #define _TS_IND(v, k) \
+        ((DISPLAY_MIN_START_IND_LIST(DISPLAY_LIST_SELECT, k) 0) \
+        + (((v) >> ((DISPLAY_MODE_SHIFT_MASK_LIST(DISPLAY_LIST_SELECT, k) 0) & 0x0f)) \
+        & ((DISPLAY_MODE_SHIFT_MASK_LIST(DISPLAY_LIST_SELECT, k) 0) >> 4)))
+
+    /**
+     * @brief Generates the enumerator for a single mode and "block"
+     *
+     * For each mode and five minute "block" the entry within s_minData is
+     * selected once, so the table itself can be built up from these
+     * constants.
+     *
+     * @param m Mode (see DISPLAY_MODES_LIST)
+     * @param v Mode bitset (see DISPLAY_MODES_LIST)
+     * @param k Five minute "block" (0 - 11)
+     */
+    #define _TS_ENUM(m, v, k) \
+        _TS_ENT_##m##_##k = (DISPLAY_MIN_DATA_LIST(DISPLAY_LIST_SELECT, _TS_IND(v, k)) 0),
+
+    /**
+     * @brief Generates the enumerators for all "blocks" of a single mode
+     *
+     * This is expected to be passed to DISPLAY_MODES_LIST.
+     *
+     * @see _TS_ENUM()
+     */
+    #define _TS_ENUM_MODE(i, m, v) \
+        _TS_ENUM(m, v, 0) _TS_ENUM(m, v, 1) _TS_ENUM(m, v, 2) _TS_ENUM(m, v, 3) \
+        _TS_ENUM(m, v, 4) _TS_ENUM(m, v, 5) _TS_ENUM(m, v, 6) _TS_ENUM(m, v, 7) \
+        _TS_ENUM(m, v, 8) _TS_ENUM(m, v, 9) _TS_ENUM(m, v, 10) _TS_ENUM(m, v, 11)
+
+    /**
+     * @brief Entries of s_minData for each mode and "block"
+     *
+     * @see _TS_ENUM()
+     */
+    enum {
+
+        DISPLAY_MODES_LIST(_TS_ENUM_MODE, 0)
+
+    };
+
+    /**
+     * @brief Hour (0 - 11) to be displayed for the given mode, hour and block
+     *
+     * @param m Mode (see DISPLAY_MODES_LIST)
+     * @param h Hour (0 - 11)
+     * @param k Five minute "block" (0 - 11)
+     */
+    #define _TS_HOUR(m, h, k) (((h) + (_TS_ENT_##m##_##k >> 8)) % 12)
+
+    /**
+     * @brief Display state for the given mode, hour and "block"
+     *
+     * This is the compile time equivalent to display_getTimeState()
+     * without the phrase "it is" and the minute LEDs.
+     *
+     * @param m Mode (see DISPLAY_MODES_LIST)
+     * @param h Hour (0 - 11)
+     * @param k Five minute "block" (0 - 11)
+     *
+     * @see DISPLAY_TIME_STATES_MODE()
+     */
+    #define _TS(m, h, k) \
+        (((((k) == 0) ? ((display_state_t)1 << DWP_clock) : 0) \
+        | (((display_state_t)(_TS_ENT_##m##_##k & 0xff)) << DWP_MIN_FIRST) \
+        | (((display_state_t)(DISPLAY_NUMBERS_LIST(DISPLAY_LIST_SELECT, \
+            _TS_HOUR(m, h, k)) 0)) << DWP_HOUR_BEGIN)) \
+        & ~(((_TS_HOUR(m, h, k) == 1) && ((k) == 0)) ? DISPLAY_ONE_O_CLOCK_MASK : 0))
+
+    /**
+     * @brief Generates the time states of a single mode
+     *
+     * This is expected to be passed to DISPLAY_MODES_LIST.
+     *
+     * @see DISPLAY_TIME_STATES_MODE()
+     */
+    #define _TS_MODE(i, m, v) DISPLAY_TIME_STATES_MODE(_TS, m),
+
+    /**
+     * @brief Display states for each mode, hour and five minute "block"
+     *
+     * This table is generated at compile time and stored in program
+     * space. It covers all modes except for the "jester mode", which is
+     * random by definition and therefore still calculated at runtime.
+     *
+     * @see DISPLAY_USE_TIME_STATE_TABLE
+     * @see _TS()
+     * @see display_getTimeState()
+     */
+    static const display_state_t s_timeStates[DISPLAY_MODE_COUNT][12][12] PROGMEM = {
+
+        DISPLAY_MODES_LIST(_TS_MODE, 0)
+
+    };
+
+    /*
+     * Undefine helper macros as they are no longer needed
+     */
+    #undef _TS_MODE
+    #undef _TS
+    #undef _TS_HOUR
+    #undef _TS_ENUM_MODE
+    #undef _TS_ENUM
+    #undef _TS_IND
+
+#endif /* (DISPLAY_USE_TIME_STATE_TABLE == 1) */
 
 /**
  * @brief Initializes the display module
@@ -71,80 +257,163 @@ void display_init()
 }
 
 /**
- * @brief Outputs a display state
+ * @brief Bits of a display state that are output via the shift registers
  *
- * This will output a given display state, which involves enabling and/or
- * disabling the minute LEDs and shifting out the bit pattern. When logging
- * for this particular module is enabled (LOG_DISPLAY_STATE), some debugging
- * information will be output via UART.
+ * Everything below the minute LEDs is controlled via the shift registers.
  *
- * @param state The DisplayState that should be output
+ * @see DWP_MIN_LEDS_BEGIN
+ * @see display_outputData()
+ */
+#define DISPLAY_SR_MASK \
+    (((display_state_t)1 << DWP_MIN_LEDS_BEGIN) - 1)
+
+/**
+ * @brief Display state that has been output most recently
  *
- * @see shift24_output()
+ * This matches the state set up by display_init() initially.
  *
- * @note The display module should be enabled before this function can be
- * used.
+ * @see display_outputData()
  */
-void display_outputData(display_state_t state)
+static display_state_t display_lastOutput;
+
+/**
+ * @brief Accumulates the mask and value of a minute LED for a given port
+ *
+ * This is a helper for display_outputMinutePort() and only contributes to
+ * the mask and value when the line of the minute LED is part of the port.
+ *
+ * @param pin Port and pin definition of the minute LED, e.g. DISPLAY_MIN1
+ * @param pos Position of the minute LED within the display state
+ */
+#define DISPLAY_MIN_PORT_BITS(pin, pos) \
+    if (&PORT(pin) == port) { \
+        mask |= _BV(BIT(pin)); \
+        if (state & ((display_state_t)1 << (pos))) { \
+            value |= _BV(BIT(pin)); \
+        } \
+    }
+
+/**
+ * @brief Updates all of the minute LEDs attached to the given port at once
+ *
+ * The port is compared to the port of each minute LED, which the compiler
+ * resolves at compile time, so this boils down to a single masked write for
+ * ports shared by multiple minute LEDs. Ports with a single minute LED are
+ * updated with the usual set and clear instructions instead, which leave the
+ * other lines of the port alone without disabling interrupts.
+ *
+ * @param port The port to update, e.g. &PORT(DISPLAY_MIN1)
+ * @param state The display state to output
+ *
+ * @see display_outputData()
+ */
+static inline __attribute__((always_inline)) void display_outputMinutePort(
+        volatile uint8_t* port, display_state_t state)
 {
 
-    shift24_output(state);
+    uint8_t mask = 0;
+    uint8_t value = 0;
 
-    if (state & ((display_state_t)1 << DWP_min1)) {
+    DISPLAY_MIN_PORT_BITS(DISPLAY_MIN1, DWP_min1);
+    DISPLAY_MIN_PORT_BITS(DISPLAY_MIN2, DWP_min2);
+    DISPLAY_MIN_PORT_BITS(DISPLAY_MIN3, DWP_min3);
+    DISPLAY_MIN_PORT_BITS(DISPLAY_MIN4, DWP_min4);
 
-        PORT(DISPLAY_MIN1) |= _BV(BIT(DISPLAY_MIN1));
+    if ((mask & (mask - 1)) == 0) {
 
-    } else {
+        if (value) {
 
-        PORT(DISPLAY_MIN1) &= ~(_BV(BIT(DISPLAY_MIN1)));
+            *port |= mask;
 
-    }
+        } else {
 
-    if (state & ((display_state_t)1 << DWP_min2)) {
+            *port &= ~mask;
 
-        PORT(DISPLAY_MIN2) |= _BV(BIT(DISPLAY_MIN2));
+        }
 
     } else {
 
-        PORT(DISPLAY_MIN2) &= ~(_BV(BIT(DISPLAY_MIN2)));
+        uint8_t sreg = SREG;
+        cli();
 
-    }
+        *port = (*port & ~mask) | value;
 
-    if (state & ((display_state_t)1 << DWP_min3)) {
+        SREG = sreg;
 
-        PORT(DISPLAY_MIN3) |= _BV(BIT(DISPLAY_MIN3));
+    }
 
-    } else {
+}
 
-        PORT(DISPLAY_MIN3) &= ~(_BV(BIT(DISPLAY_MIN3)));
+#undef DISPLAY_MIN_PORT_BITS
 
-    }
+/**
+ * @brief Outputs a display state
+ *
+ * This will output a given display state, which involves enabling and/or
+ * disabling the minute LEDs and shifting out the bit pattern. Only those
+ * parts that differ from the previously output state are actually written
+ * to the hardware: The shift registers are daisy chained, so the bit pattern
+ * is shifted out as a whole, but only if any of its bits have changed. The
+ * minute LEDs are only touched when any of them have changed, with all of
+ * the LEDs sharing a port being updated at once (see
+ * display_outputMinutePort()). This way most of the blink and animation
+ * frames only take a couple of I/O instructions.
+ *
+ * When logging for this particular module is enabled (LOG_DISPLAY_STATE), the
+ * display state is put into the log buffer (see log_put()).
+ *
+ * @param state The DisplayState that should be output
+ *
+ * @see shift24_output()
+ * @see display_lastOutput
+ *
+ * @note The display module should be enabled before this function can be
+ * used. It is not reentrant, so it should only be invoked from a single
+ * context, which is usually the display timer.
+ */
+void display_outputData(display_state_t state)
+{
 
-    if (state & ((display_state_t)1 << DWP_min4)) {
+    display_state_t changed = state ^ display_lastOutput;
 
-        PORT(DISPLAY_MIN4) |= _BV(BIT(DISPLAY_MIN4));
+    display_lastOutput = state;
 
-    } else {
+    if (changed & DISPLAY_SR_MASK) {
 
-        PORT(DISPLAY_MIN4) &= ~(_BV(BIT(DISPLAY_MIN4)));
+        shift24_output(state);
 
     }
 
-    #if (LOG_DISPLAY_STATE == 1)
+    if (changed & ~DISPLAY_SR_MASK) {
+
+        display_outputMinutePort(&PORT(DISPLAY_MIN1), state);
+
+        if (&PORT(DISPLAY_MIN2) != &PORT(DISPLAY_MIN1)) {
 
-        uint8_t i;
+            display_outputMinutePort(&PORT(DISPLAY_MIN2), state);
 
-        uart_puts_P("Disp: ");
+        }
+
+        if (&PORT(DISPLAY_MIN3) != &PORT(DISPLAY_MIN1)
+                && &PORT(DISPLAY_MIN3) != &PORT(DISPLAY_MIN2)) {
+
+            display_outputMinutePort(&PORT(DISPLAY_MIN3), state);
 
-        for (i = 0; i < 32; i++) {
+        }
 
-            uart_putc('0' + (state & 1));
+        if (&PORT(DISPLAY_MIN4) != &PORT(DISPLAY_MIN1)
+                && &PORT(DISPLAY_MIN4) != &PORT(DISPLAY_MIN2)
+                && &PORT(DISPLAY_MIN4) != &PORT(DISPLAY_MIN3)) {
 
-            state >>= 1;
+            display_outputMinutePort(&PORT(DISPLAY_MIN4), state);
 
         }
 
-        uart_putc('\n');
+    }
+
+    #if (LOG_DISPLAY_STATE == 1)
+
+        log_put(LOG_EVENT_DISPLAY_STATE, state >> 16, state & 0xffff, 0);
 
     #endif
 
@@ -192,3 +461,201 @@ void display_autoOffAnimStep1Hz(bool animPreview)
     }
 
 }
+
+/**
+ * @brief Returns whether the "jester mode" should be activated or not
+ *
+ * This returns a value indicating whether or not the "jester mode" should
+ * be activated based upon two factors:
+ *
+ * - The "jester mode" was added (see DISPLAY_ADD_JESTER_MODE) and is the
+ *  currently chosen mode, which comes right after the modes defined within
+ *  DISPLAY_MODES_LIST.
+ *
+ * - The software was compiled with support for DCF77 (ENABLE_DCF_SUPPORT)
+ *  and the current date is April 1st while the software was compiled with
+ * DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL set to 1.
+ *
+ * One of these conditions must be met for this function to return true.
+ * Otherwise it will return false, which means that the "jester mode"
+ * should not be enabled.
+ *
+ * @param i_dateTime The current datetime
+ * @param i_langmode The currently chosen mode
+ *
+ * @return True if the "jester mode" should be activated, otherwise false
+ *
+ * @see DISPLAY_ADD_JESTER_MODE
+ * @see DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL
+ * @see ENABLE_DCF_SUPPORT
+ */
+static bool isJesterModeActive(const datetime_t* i_dateTime, uint8_t i_langmode)
+{
+
+    #if (DISPLAY_ADD_JESTER_MODE == 1)
+
+        #if ((ENABLE_DCF_SUPPORT == 1) && (DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL == 1))
+
+            return (i_langmode == DISPLAY_MODE_COUNT) || (i_dateTime->MM == 4  && i_dateTime->DD == 1);
+
+        #else
+
+            return (i_langmode == DISPLAY_MODE_COUNT);
+
+        #endif
+
+    #else
+
+        #if ((ENABLE_DCF_SUPPORT == 1) && (DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL == 1))
+
+            return (i_dateTime->MM == 4  && i_dateTime->DD == 1);
+
+        #else
+
+            return false;
+
+        #endif
+
+    #endif
+
+}
+
+/**
+ * @brief Returns the display state for the given time
+ *
+ * This is the same for all languages, as the frontpanel itself is described
+ * by the tables derived from the language specific header (see
+ * display_wc.h): The index of the sub index (variant) for the current five
+ * minute "block" is looked up from s_modes and s_modeShiftMask and added to
+ * the start index of this "block" within s_minData. The entry found there
+ * contains the minute words along with the amount the hour needs to be
+ * incremented by.
+ *
+ * @see display.h
+ */
+display_state_t display_getTimeState(const datetime_t* i_newDateTime)
+{
+
+    uint8_t hour = i_newDateTime->hh;
+    const uint8_t minutes = i_newDateTime->mm / 5;
+    const uint8_t minuteLeds = i_newDateTime->mm % 5;
+    uint8_t minuteLedSubState = 0;
+    uint8_t langMode = 0;
+    bool jesterMode;
+    display_state_t leds;
+
+    #if (DISPLAY_DEACTIVATABLE_ITIS == 1)
+
+        leds = 0;
+        langMode = g_display_prefs->mode / 2;
+
+        if (((g_display_prefs->mode & 1) == 0) || ((DISPLAY_ITIS_BLOCKS >> minutes) & 1)) {
+
+            leds |= ((display_state_t)1 << DWP_itis);
+
+        }
+
+    #else
+
+        leds = ((display_state_t)1 << DWP_itis);
+
+        #if ((DISPLAY_MODE_COUNT + DISPLAY_ADD_JESTER_MODE) > 1)
+
+            langMode = g_display_prefs->mode;
+
+        #endif
+
+    #endif
+
+    jesterMode = isJesterModeActive(i_newDateTime, langMode);
+
+    #if (DISPLAY_USE_TIME_STATE_TABLE == 1)
+
+        if (!jesterMode) {
+
+            leds |= pgm_read_dword(&s_timeStates[langMode][hour % 12][minutes]);
+            leds |= ((display_state_t)((1 << minuteLeds) - 1)) << DWP_MIN_LEDS_BEGIN;
+
+            return leds;
+
+        }
+
+    #endif
+
+    if (minutes == 0) {
+
+        leds |= ((display_state_t)1 << DWP_clock);
+
+    }
+
+    uint8_t subInd;
+    uint8_t ind = pgm_read_byte(&s_minStartInd[minutes]);
+    uint16_t entry;
+
+    if (jesterMode) {
+
+        subInd = prng_rand() % (pgm_read_byte(&s_minStartInd[minutes + 1]) - ind);
+
+    } else {
+
+        const uint16_t mode = pgm_read_word(&s_modes[langMode]);
+        const uint8_t shiftMask = pgm_read_byte(&s_modeShiftMask[minutes]);
+
+        subInd = (mode >> (shiftMask & 0x0f)) & (shiftMask >> 4);
+
+    }
+
+    entry = pgm_read_word(&s_minData[ind + subInd]);
+
+    leds |= ((display_state_t)(entry & 0xff)) << DWP_MIN_FIRST;
+    hour += entry >> 8;
+
+    if (jesterMode) {
+
+        uint8_t r = prng_rand() % 4;
+
+        if (minuteLeds <= 2) {
+
+            minuteLedSubState |= (1 << r);
+
+            if (minuteLeds == 2) {
+
+                uint8_t r2 = prng_rand() % 3;
+                r2 = r2 < r ? r2 : r2 + 1;
+
+                minuteLedSubState |= (1 << r2);
+
+            }
+
+
+        } else {
+
+            minuteLedSubState = 0xf;
+
+            if (minuteLeds == 3) {
+
+                minuteLedSubState &= ~(1 << r);
+
+            }
+
+        }
+
+    } else {
+
+        minuteLedSubState = (1 << minuteLeds) - 1;
+
+    }
+
+    leds |= ((display_state_t)minuteLedSubState) << DWP_MIN_LEDS_BEGIN;
+
+    leds |= display_getNumberDisplayState(hour);
+
+    if (((hour % 12) == 1) && (minutes == 0)) {
+
+        leds &= ~DISPLAY_ONE_O_CLOCK_MASK;
+
+    }
+
+    return leds;
+
+}
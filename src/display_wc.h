@@ -31,7 +31,7 @@
  *
  * @note This file should be left untouched if making adaptations to other
  * languages. Language specific things reside in their own files, e.g.
- * display_wc_[language].h/c.
+ * display_wc_[language].h.
  *
  * @see display.h
  * @see display_wc.c
@@ -40,8 +40,82 @@
 #ifndef _WC_DISPLAY_WC_H_
 #define _WC_DISPLAY_WC_H_
 
+#include <avr/pgmspace.h>
+
+/**
+ * @brief Sets a single minute word within an entry of DISPLAY_MIN_DATA_LIST
+ *
+ * The minute words are expected to be placed one after the other within
+ * e_displayWordPos, starting at DWP_MIN_FIRST. Multiple words can be set by
+ * "or"-ing them together.
+ *
+ * @param x Minute word (see e_displayWordPos)
+ *
+ * @see DISPLAY_MIN_ENTRY()
+ * @see DWP_MIN_FIRST
+ */
+#define DISPLAY_MIN_BIT(x) (1 << ((x) - DWP_MIN_FIRST))
+
+/**
+ * @brief Defines a single entry of DISPLAY_MIN_DATA_LIST
+ *
+ * The least significant byte contains the minute words, the upper byte the
+ * amount the hour needs to be incremented by for the time to be correct, e.g.
+ * "viertel vor neun" (quarter to nine) for "8:45".
+ *
+ * @param words Minute words, see DISPLAY_MIN_BIT()
+ * @param inc Amount the hour needs to be incremented by (0 - 2)
+ *
+ * @see DISPLAY_MIN_DATA_LIST
+ */
+#define DISPLAY_MIN_ENTRY(words, inc) (((inc) << 8) | (words))
+
+/**
+ * @brief Defines a single entry of DISPLAY_MODE_SHIFT_MASK_LIST
+ *
+ * The resulting byte is basically "halved". The lower nibble represents a bit
+ * offset within the entries of DISPLAY_MODES_LIST, whereas the higher nibble
+ * represents the mask of the variants encoded at this offset.
+ *
+ * @param numBits Number of bits (0 - 4), higher nibble of resulting byte
+ * @param bitOffset Bit offset, lower nibble of the resulting byte
+ *
+ * @see DISPLAY_MODE_SHIFT_MASK_LIST
+ */
+#define DISPLAY_MASK_SHIFT(numBits, bitOffset) \
+    ((((1 << (numBits)) - 1) << 4) | (bitOffset))
+
+/**
+ * @brief Sets a single hour word within an entry of DISPLAY_NUMBERS_LIST
+ *
+ * @param x Hour word (see e_displayWordPos)
+ *
+ * @see DISPLAY_NUMBERS_LIST
+ * @see DWP_HOUR_BEGIN
+ */
+#define DISPLAY_NUMBER_BIT(x) ((uint16_t)1 << ((x) - DWP_HOUR_BEGIN))
+
 /*
- * Check which language has been selected and include appropriate header file
+ * Check which language has been selected and include appropriate header file.
+ * Apart from the enumeration e_displayWordPos these headers describe the
+ * layout of the frontpanel by the following definitions, which are turned
+ * into tables in program space by display_wc.c:
+ *
+ * - DISPLAY_MIN_DATA_LIST: Minute words for each way to display a five
+ *   minute "block", along with the hour increment (see DISPLAY_MIN_ENTRY())
+ * - DISPLAY_MIN_START_IND_LIST: Index of the first entry within
+ *   DISPLAY_MIN_DATA_LIST for each "block", followed by the number of entries
+ * - DISPLAY_MODE_SHIFT_MASK_LIST: Position of the variant for each "block"
+ *   within the entries of DISPLAY_MODES_LIST (see DISPLAY_MASK_SHIFT())
+ * - DISPLAY_MODES_LIST: Variant chosen for each "block" in each mode
+ * - DISPLAY_NUMBERS_LIST: Hour words for each number (see
+ *   DISPLAY_NUMBER_BIT())
+ * - DISPLAY_MODE_COUNT: Number of entries within DISPLAY_MODES_LIST
+ * - DISPLAY_ITIS_BLOCKS: "Blocks" showing the phrase "it is" regardless of
+ *   the mode chosen (see DISPLAY_DEACTIVATABLE_ITIS)
+ * - DISPLAY_ONE_O_CLOCK_MASK: Words to disable for "one o'clock"
+ *
+ * This way adding a language only involves data, but no code.
  */
 #if (WC_DISP_ENG == 1)
 
@@ -115,4 +189,17 @@ static inline display_state_t display_getIndicatorMask()
 
 }
 
+/**
+ * @see display.h
+ */
+static inline display_state_t display_getNumberDisplayState(uint8_t number)
+{
+
+    extern const uint16_t s_numbers[12] PROGMEM;
+    number = number % 12;
+
+    return ((display_state_t)pgm_read_word(&s_numbers[number])) << DWP_HOUR_BEGIN;
+
+}
+
 #endif /* _WC_DISPLAY_WC_H_ */
@@ -30,7 +30,7 @@
  * the display module. Only things specific to the English language should be
  * put inside this file.
  *
- * @see display_wc_eng.c
+ * @see display_wc.c
  */
 
 #ifndef _WC_DISPLAY_ENG_H_
@@ -165,6 +165,138 @@ enum e_displayWordPos
  */
 #define DWP_MIN_LEDS_BEGIN DWP_min1
 
+/**
+ * @brief Controls whether the "Jester mode" should be added
+ *
+ * The "Jester mode" is not supported by this frontpanel, see
+ * display_wc_ger3.h for details.
+ */
+#define DISPLAY_ADD_JESTER_MODE 0
+
+/**
+ * @brief Controls whether the "Jester mode" should be activated on April 1st
+ *
+ * @see DISPLAY_ADD_JESTER_MODE
+ */
+#define DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL 0
+
+/**
+ * @brief Number of modes defined within DISPLAY_MODES_LIST
+ *
+ * There is only a single way to display the time. The modes within
+ * e_WcEngModes only affect the phrase "it is".
+ */
+#define DISPLAY_MODE_COUNT 1
+
+/**
+ * @brief Five minute "blocks" displaying the phrase "it is" anyway
+ *
+ * Each bit represents one five minute "block". The phrase is shown for "x
+ * O'CLOCK" even if the mode chosen disables it, see
+ * DISPLAY_DEACTIVATABLE_ITIS.
+ */
+#define DISPLAY_ITIS_BLOCKS (1 << 0)
+
+/**
+ * @brief Words to be disabled for "one o'clock"
+ *
+ * There is no need for this in English.
+ */
+#define DISPLAY_ONE_O_CLOCK_MASK 0
+
+/**
+ * @brief Contains the minute definitions for displaying a time
+ *
+ * There is exactly one entry for each of the five minute "blocks" (0, 5, 10,
+ * 15, 20, 25, 30, 35, 40, 45, 50, 55). From "twenty-five to" (35) onwards the
+ * time is displayed relative to the next hour.
+ *
+ * @see DISPLAY_MIN_ENTRY()
+ */
+#define DISPLAY_MIN_DATA_LIST(X, i) \
+    X(i, 0, DISPLAY_MIN_ENTRY(0, 0)) \
+    X(i, 1, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fiveMin) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 2, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_tenMin) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 3, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_quarter) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 4, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_twenty) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 5, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_twenty) | DISPLAY_MIN_BIT(DWP_fiveMin) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 6, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_half) | DISPLAY_MIN_BIT(DWP_past), 0)) \
+    X(i, 7, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_twenty) | DISPLAY_MIN_BIT(DWP_fiveMin) | DISPLAY_MIN_BIT(DWP_to), 1)) \
+    X(i, 8, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_twenty) | DISPLAY_MIN_BIT(DWP_to), 1)) \
+    X(i, 9, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_quarter) | DISPLAY_MIN_BIT(DWP_to), 1)) \
+    X(i, 10, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_tenMin) | DISPLAY_MIN_BIT(DWP_to), 1)) \
+    X(i, 11, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fiveMin) | DISPLAY_MIN_BIT(DWP_to), 1))
+
+/**
+ * @brief Defines the start indexes for each "block" within
+ * DISPLAY_MIN_DATA_LIST
+ *
+ * @see DISPLAY_MIN_DATA_LIST
+ */
+#define DISPLAY_MIN_START_IND_LIST(X, i) \
+    X(i, 0, 0) \
+    X(i, 1, 1) \
+    X(i, 2, 2) \
+    X(i, 3, 3) \
+    X(i, 4, 4) \
+    X(i, 5, 5) \
+    X(i, 6, 6) \
+    X(i, 7, 7) \
+    X(i, 8, 8) \
+    X(i, 9, 9) \
+    X(i, 10, 10) \
+    X(i, 11, 11) \
+    X(i, 12, 12)
+
+/**
+ * @brief Defines the position of sub indexes for each 5 minute time "block"
+ *
+ * There are no variants at all.
+ *
+ * @see DISPLAY_MASK_SHIFT()
+ */
+#define DISPLAY_MODE_SHIFT_MASK_LIST(X, i) \
+    X(i, 0, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 1, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 2, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 3, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 4, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 5, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 6, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 7, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 8, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 9, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 10, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 11, DISPLAY_MASK_SHIFT(0, 0))
+
+/**
+ * @brief The only mode implemented by this module
+ *
+ * @see DISPLAY_MODE_COUNT
+ */
+#define DISPLAY_MODES_LIST(X, i) \
+    X(i, 0, 0)
+
+/**
+ * @brief Definition of the hour words for each number from one to twelve
+ *
+ * @see DISPLAY_NUMBER_BIT()
+ * @see display_getNumberDisplayState()
+ */
+#define DISPLAY_NUMBERS_LIST(X, i) \
+    X(i, 0, (DISPLAY_NUMBER_BIT(DWP_twelve))) \
+    X(i, 1, (DISPLAY_NUMBER_BIT(DWP_one))) \
+    X(i, 2, (DISPLAY_NUMBER_BIT(DWP_two))) \
+    X(i, 3, (DISPLAY_NUMBER_BIT(DWP_three))) \
+    X(i, 4, (DISPLAY_NUMBER_BIT(DWP_four))) \
+    X(i, 5, (DISPLAY_NUMBER_BIT(DWP_five))) \
+    X(i, 6, (DISPLAY_NUMBER_BIT(DWP_six))) \
+    X(i, 7, (DISPLAY_NUMBER_BIT(DWP_seven))) \
+    X(i, 8, (DISPLAY_NUMBER_BIT(DWP_eight))) \
+    X(i, 9, (DISPLAY_NUMBER_BIT(DWP_nine))) \
+    X(i, 10, (DISPLAY_NUMBER_BIT(DWP_ten))) \
+    X(i, 11, (DISPLAY_NUMBER_BIT(DWP_eleven)))
+
 /*
  * Check whether this code actually has to be compiled
  */
@@ -209,6 +341,17 @@ enum e_displayWordPos
          */
         e_WcEngModes mode;
 
+        /**
+         * @brief Chosen animation for time transitions
+         *
+         * This contains the animation used to change over to a new time, which
+         * is a value from e_displayAnimation.
+         *
+         * @see e_displayAnimation
+         * @see display_animateDisplayState()
+         */
+        uint8_t animation;
+
     };
 
     /**
@@ -225,7 +368,8 @@ enum e_displayWordPos
      */
     #define DISPLAYEEPROMPARAMS_DEFAULT { \
     \
-        (e_WcEngModes)0 \
+        (e_WcEngModes)0, \
+        DISPLAY_ANIMATION_FADE \
     \
     }
 
@@ -259,28 +403,37 @@ enum e_displayWordPos
 #else
 
     /**
-    * @brief Containing a dummy parameter to be stored persistently
+    * @brief Containing the parameters of this module to be stored persistently
     *
-    * This is needed to have this struct available even when the appropriate
-    * functionality should not be compiled (DISPLAY_DEACTIVATABLE_ITIS).
+    * There is no mode to be chosen when the appropriate functionality is not
+    * compiled (DISPLAY_DEACTIVATABLE_ITIS).
     *
     * @see DISPLAY_DEACTIVATABLE_ITIS
     */
     struct display_prefs_t {
 
-        uint8_t dummy;
+        /**
+         * @brief Chosen animation for time transitions
+         *
+         * This contains the animation used to change over to a new time, which
+         * is a value from e_displayAnimation.
+         *
+         * @see e_displayAnimation
+         * @see display_animateDisplayState()
+         */
+        uint8_t animation;
 
     };
 
     /**
-    * @brief Default settings of this module for the dummy parameter
+    * @brief Default settings of this module
     *
     * @see display_prefs_t
     * @see preferences.h
     */
     #define DISPLAYEEPROMPARAMS_DEFAULT { \
     \
-        0 \
+        DISPLAY_ANIMATION_FADE \
     \
     }
 
@@ -375,22 +528,4 @@ static inline display_state_t display_getTimeSetIndicatorMask()
 
 }
 
-/**
- * @see display.h
- */
-static inline display_state_t display_getNumberDisplayState(uint8_t number)
-{
-
-    number = number % 12;
-
-    if (number == 0) {
-
-        number = 12;
-
-    }
-
-    return ((display_state_t)1 << (number + DWP_HOUR_BEGIN - 1));
-
-}
-
 #endif /* _WC_DISPLAY_ENG_H_ */
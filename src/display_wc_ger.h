@@ -81,7 +81,7 @@
  * the display module. Only things specific to the German language should be
  * put inside this file.
  *
- * @see display_wc_ger.c
+ * @see display_wc.c
  */
 
 #ifndef _WC_DISPLAY_GER_H_
@@ -187,13 +187,12 @@ enum e_displayWordPos
  * @brief First item within e_displayWordPos representing an hour
  *
  * This is expected to "point" at the first item within e_displayWordPost which
- * represents an hour (1 to 12). The items within this group itself are
- * expected to be ordered ascendingly, so various operations regarding this can
- * be implemented more efficiently.
+ * represents a word regarding the hour (1 to 12). This is the "s" of "eins"
+ * (one), which is followed by the hours itself in ascending order.
  *
  * @see e_displayWordPos
  */
-#define DWP_HOUR_BEGIN DWP_one
+#define DWP_HOUR_BEGIN DWP_s
 
 /**
  * @brief Last item within e_displayWordPost connected to the shift registers
@@ -239,6 +238,151 @@ typedef enum {
 
 } e_WcGerModes;
 
+/**
+ * @brief Controls whether the "Jester mode" should be added
+ *
+ * The "Jester mode" is not supported by this frontpanel, see
+ * display_wc_ger3.h for details.
+ */
+#define DISPLAY_ADD_JESTER_MODE 0
+
+/**
+ * @brief Controls whether the "Jester mode" should be activated on April 1st
+ *
+ * @see DISPLAY_ADD_JESTER_MODE
+ */
+#define DISPLAY_USE_JESTER_MODE_ON_1ST_APRIL 0
+
+/**
+ * @brief Number of modes defined within DISPLAY_MODES_LIST
+ *
+ * @see e_WcGerModes
+ */
+#define DISPLAY_MODE_COUNT 2
+
+/**
+ * @brief Five minute "blocks" displaying the phrase "Es ist" (it is) anyway
+ *
+ * Each bit represents one five minute "block". The phrase is shown for "x
+ * UHR" (x O'CLOCK) and "HALB x" (HALF x) even if the mode chosen disables it,
+ * see DISPLAY_DEACTIVATABLE_ITIS.
+ */
+#define DISPLAY_ITIS_BLOCKS ((1 << 0) | (1 << 6))
+
+/**
+ * @brief Words to be disabled for "EIN UHR" (one o'clock)
+ *
+ * @see DISPLAY_NUMBERS_LIST
+ */
+#define DISPLAY_ONE_O_CLOCK_MASK ((display_state_t)1 << DWP_s)
+
+/**
+ * @brief Contains the minute definitions for displaying a time
+ *
+ * There is one entry for each of the five minute "blocks" (0, 5, 10, 15, 20,
+ * 25, 30, 35, 40, 45, 50, 55). The only exceptions are "viertel nach"
+ * (quarter past) vs. "viertel" (quarter) and "viertel vor" (quarter to) vs.
+ * "dreiviertel" (three-quarters), which are used in the "Wessi" and "Ossi"
+ * mode respectively.
+ *
+ * @see DISPLAY_MIN_ENTRY()
+ * @see DISPLAY_MIN_START_IND_LIST
+ */
+#define DISPLAY_MIN_DATA_LIST(X, i) \
+    X(i, 0, DISPLAY_MIN_ENTRY(0, 0)) \
+    X(i, 1, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 2, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 3, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 4, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel), 1)) \
+    X(i, 5, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_halb) | DISPLAY_MIN_BIT(DWP_vorMin), 1)) \
+    X(i, 6, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_halb) | DISPLAY_MIN_BIT(DWP_vorMin), 1)) \
+    X(i, 7, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 8, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_halb) | DISPLAY_MIN_BIT(DWP_nach), 1)) \
+    X(i, 9, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_halb) | DISPLAY_MIN_BIT(DWP_nach), 1)) \
+    X(i, 10, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_vorHour), 1)) \
+    X(i, 11, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_dreiHour), 1)) \
+    X(i, 12, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_vorMin), 1)) \
+    X(i, 13, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_vorHour), 1))
+
+/**
+ * @brief Defines the start indexes for each "block" within
+ * DISPLAY_MIN_DATA_LIST
+ *
+ * @see DISPLAY_MIN_DATA_LIST
+ */
+#define DISPLAY_MIN_START_IND_LIST(X, i) \
+    X(i, 0, 0) \
+    X(i, 1, 1) \
+    X(i, 2, 2) \
+    X(i, 3, 3) \
+    X(i, 4, 5) \
+    X(i, 5, 6) \
+    X(i, 6, 7) \
+    X(i, 7, 8) \
+    X(i, 8, 9) \
+    X(i, 9, 10) \
+    X(i, 10, 12) \
+    X(i, 11, 13) \
+    X(i, 12, 14)
+
+/**
+ * @brief Defines the position of sub indexes for each 5 minute time "block"
+ *
+ * Only the "blocks" for 15 and 45 come in two variants.
+ *
+ * @see DISPLAY_MASK_SHIFT()
+ * @see DISPLAY_MODES_LIST
+ */
+#define DISPLAY_MODE_SHIFT_MASK_LIST(X, i) \
+    X(i, 0, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 1, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 2, DISPLAY_MASK_SHIFT(0, 0)) \
+    X(i, 3, DISPLAY_MASK_SHIFT(1, 0)) \
+    X(i, 4, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 5, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 6, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 7, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 8, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 9, DISPLAY_MASK_SHIFT(1, 1)) \
+    X(i, 10, DISPLAY_MASK_SHIFT(0, 2)) \
+    X(i, 11, DISPLAY_MASK_SHIFT(0, 2))
+
+/**
+ * @brief Different modes that are implemented by this module
+ *
+ * Bit 0 selects "viertel" (quarter) instead of "viertel nach" (quarter past),
+ * bit 1 selects "dreiviertel" (three-quarters) instead of "viertel vor"
+ * (quarter to).
+ *
+ * @see e_WcGerModes
+ * @see DISPLAY_MODE_SHIFT_MASK_LIST
+ */
+#define DISPLAY_MODES_LIST(X, i) \
+    X(i, tm_wessi, 0) \
+    X(i, tm_ossi, ((1 << 0) | (1 << 1)))
+
+/**
+ * @brief Definition of the hour words for each number from one to twelve
+ *
+ * @note The number one is defined as "eins", see DISPLAY_ONE_O_CLOCK_MASK.
+ *
+ * @see DISPLAY_NUMBER_BIT()
+ * @see display_getNumberDisplayState()
+ */
+#define DISPLAY_NUMBERS_LIST(X, i) \
+    X(i, 0, (DISPLAY_NUMBER_BIT(DWP_twelve))) \
+    X(i, 1, (DISPLAY_NUMBER_BIT(DWP_one) | DISPLAY_NUMBER_BIT(DWP_s))) \
+    X(i, 2, (DISPLAY_NUMBER_BIT(DWP_two))) \
+    X(i, 3, (DISPLAY_NUMBER_BIT(DWP_three))) \
+    X(i, 4, (DISPLAY_NUMBER_BIT(DWP_four))) \
+    X(i, 5, (DISPLAY_NUMBER_BIT(DWP_five))) \
+    X(i, 6, (DISPLAY_NUMBER_BIT(DWP_six))) \
+    X(i, 7, (DISPLAY_NUMBER_BIT(DWP_seven))) \
+    X(i, 8, (DISPLAY_NUMBER_BIT(DWP_eight))) \
+    X(i, 9, (DISPLAY_NUMBER_BIT(DWP_nine))) \
+    X(i, 10, (DISPLAY_NUMBER_BIT(DWP_ten))) \
+    X(i, 11, (DISPLAY_NUMBER_BIT(DWP_eleven)))
+
 /**
  * @brief Containing the parameters of this module to be stored persistently
  *
@@ -257,6 +401,17 @@ struct display_prefs_t {
      */
     e_WcGerModes mode;
 
+    /**
+     * @brief Chosen animation for time transitions
+     *
+     * This contains the animation used to change over to a new time, which
+     * is a value from e_displayAnimation.
+     *
+     * @see e_displayAnimation
+     * @see display_animateDisplayState()
+     */
+    uint8_t animation;
+
 };
 
 /**
@@ -273,7 +428,8 @@ struct display_prefs_t {
  */
 #define DISPLAYEEPROMPARAMS_DEFAULT { \
 \
-    (e_WcGerModes)0 \
+    (e_WcGerModes)0, \
+    DISPLAY_ANIMATION_FADE \
 \
 }
 
@@ -388,26 +544,4 @@ static inline display_state_t display_getTimeSetIndicatorMask()
 
 }
 
-/**
- * @see display.h
- */
-static inline display_state_t display_getNumberDisplayState(uint8_t number)
-{
-
-    display_state_t res;
-
-    number = number % 12;
-
-    if (number == 0) {
-
-        number = 12;
-
-    }
-
-    res = ((display_state_t)1 << (number + DWP_HOUR_BEGIN - 1));
-
-    return (number == 1) ? res | ((display_state_t)1 << DWP_s) : res;
-
-}
-
 #endif /* _WC_DISPLAY_GER_H_ */
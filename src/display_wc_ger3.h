@@ -110,7 +110,7 @@
  * the display module. Only things specific to the German language should be
  * put inside this file.
  *
- * @see display_wc_ger3.c
+ * @see display_wc.c
  */
 
 #ifndef _WC_DISPLAY_GER3_H_
@@ -286,6 +286,263 @@ typedef enum {
 
 } e_WcGerModes;
 
+/**
+ * @brief Number of modes defined within DISPLAY_MODES_LIST
+ *
+ * The "Jester mode" is not part of DISPLAY_MODES_LIST, as it chooses one of
+ * the variants by chance each time.
+ *
+ * @see e_WcGerModes
+ * @see DISPLAY_MODES_LIST
+ */
+#define DISPLAY_MODE_COUNT 4
+
+/**
+ * @brief Five minute "blocks" displaying the phrase "Es ist" (it is) anyway
+ *
+ * Each bit represents one five minute "block". The phrase is shown for "x
+ * UHR" (x O'CLOCK) and "HALB x" (HALF x) even if the mode chosen disables it,
+ * see DISPLAY_DEACTIVATABLE_ITIS.
+ */
+#define DISPLAY_ITIS_BLOCKS ((1 << 0) | (1 << 6))
+
+/**
+ * @brief Words to be disabled for "EIN UHR" (one o'clock)
+ *
+ * The number one is defined as "eins" within DISPLAY_NUMBERS_LIST, however
+ * it needs to be "ein" when followed by "UHR" (o'clock).
+ */
+#define DISPLAY_ONE_O_CLOCK_MASK ((display_state_t)1 << DWP_s)
+
+/**
+ * @brief Contains the minute definitions for displaying a time
+ *
+ * This contains the minute part of a display state with all the possible
+ * ways to display a correct time along with the amount the hour needs to be
+ * incremented by, see DISPLAY_MIN_ENTRY(). Note that not all combinations
+ * make necessarily sense.
+ *
+ * There are only eight different LED "minute groups", refer to
+ * e_displayWordPos for details:
+ *
+ * - DWP_fuenfMin
+ * - DWP_zehnMin
+ * - DWP_zwanzigMin
+ * - DWP_dreiMin
+ * - DWP_viertel
+ * - DWP_nach
+ * - DWP_vor
+ * - DWP_halb
+ *
+ * By combining these in various ways all different times throughout the
+ * hour can be displayed in all the different modes.
+ *
+ * This in part defines multiple ways of displaying the same time, e.g.
+ * "viertel vor" (quarter to) as well as "dreiviertel" (three-quarter).
+ * DISPLAY_MIN_START_IND_LIST defines where definitions for each five minute
+ * "block" can be found within this table.
+ *
+ * Most of the entries relative to the next hour increment it by one, e.g.
+ * "8:45" can be displayed as "viertel vor neun" (quarter to nine). Only
+ * "dreiviertel vor halb" ("three-quarters to half") increments it by two,
+ * e.g. "8:45" can be displayed as "dreiviertel vor halb zehn" ("three
+ * quarters to half ten").
+ *
+ * @note If making adaptations to this, you probably need to change
+ * DISPLAY_MIN_START_IND_LIST, too.
+ *
+ * @see DISPLAY_MIN_ENTRY()
+ * @see DISPLAY_MIN_START_IND_LIST
+ */
+#define DISPLAY_MIN_DATA_LIST(X, i) \
+    X(i, 0, DISPLAY_MIN_ENTRY(0, 0)) \
+    X(i, 1, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 2, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 3, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 4, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zwanzigMin) | DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 5, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 6, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel), 1)) \
+    X(i, 7, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 8, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_dreiMin) | DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_vor), 1)) \
+    X(i, 9, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_dreiMin) | DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_nach) | DISPLAY_MIN_BIT(DWP_halb), 0)) \
+    X(i, 10, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 11, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zwanzigMin) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 12, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 13, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 14, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 15, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_halb) | DISPLAY_MIN_BIT(DWP_nach), 1)) \
+    X(i, 16, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_nach) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 17, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_nach) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 18, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zwanzigMin) | DISPLAY_MIN_BIT(DWP_vor), 1)) \
+    X(i, 19, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_vor), 1)) \
+    X(i, 20, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_dreiMin) | DISPLAY_MIN_BIT(DWP_viertel), 1)) \
+    X(i, 21, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_dreiMin) | DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_nach), 0)) \
+    X(i, 22, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_nach) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 23, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_dreiMin) | DISPLAY_MIN_BIT(DWP_viertel) | DISPLAY_MIN_BIT(DWP_vor) | DISPLAY_MIN_BIT(DWP_halb), 2)) \
+    X(i, 24, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zehnMin) | DISPLAY_MIN_BIT(DWP_vor), 1)) \
+    X(i, 25, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_zwanzigMin) | DISPLAY_MIN_BIT(DWP_nach) | DISPLAY_MIN_BIT(DWP_halb), 1)) \
+    X(i, 26, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_fuenfMin) | DISPLAY_MIN_BIT(DWP_vor), 1)) \
+    X(i, 27, DISPLAY_MIN_ENTRY(DISPLAY_MIN_BIT(DWP_vor), 1))
+
+/**
+ * @brief Defines the start indexes for each "block" within
+ * DISPLAY_MIN_DATA_LIST
+ *
+ * This defines the index within DISPLAY_MIN_DATA_LIST, where a new five
+ * minute time "block" starts, one for each block (0, 5, 10, 15, 20, 25, 30,
+ * 35, 40, 45, 55), followed by the number of entries within
+ * DISPLAY_MIN_DATA_LIST. The "gaps", e.g. between 5 and 10, basically mean
+ * that there are five possible ways to display "viertel nach" (quarter past).
+ *
+ * @see DISPLAY_MIN_DATA_LIST
+ */
+#define DISPLAY_MIN_START_IND_LIST(X, i) \
+    X(i, 0, 0) \
+    X(i, 1, 2) \
+    X(i, 2, 3) \
+    X(i, 3, 5) \
+    X(i, 4, 10) \
+    X(i, 5, 12) \
+    X(i, 6, 14) \
+    X(i, 7, 16) \
+    X(i, 8, 17) \
+    X(i, 9, 19) \
+    X(i, 10, 24) \
+    X(i, 11, 26) \
+    X(i, 12, 28)
+
+/**
+ * @brief Defines the position of sub indexes for each 5 minute time "block"
+ *
+ * There are exactly twelve entries expected, one for each "block" (0, 5, 10,
+ * 15, 20, 25, 30, 35, 40, 45, 55). The number of bits needed for an entry is
+ * determined by the number of variants, e.g. five variants need three bits
+ * (2 ^ 3 = 8). The offset of an entry is the number of bits used by all
+ * previous entries combined.
+ *
+ * @see DISPLAY_MASK_SHIFT()
+ * @see DISPLAY_MODES_LIST
+ */
+#define DISPLAY_MODE_SHIFT_MASK_LIST(X, i) \
+    X(i, 0, DISPLAY_MASK_SHIFT(1, 0)) \
+    X(i, 1, DISPLAY_MASK_SHIFT(0, 1)) \
+    X(i, 2, DISPLAY_MASK_SHIFT(1, 1)) \
+    X(i, 3, DISPLAY_MASK_SHIFT(3, 2)) \
+    X(i, 4, DISPLAY_MASK_SHIFT(1, 5)) \
+    X(i, 5, DISPLAY_MASK_SHIFT(1, 6)) \
+    X(i, 6, DISPLAY_MASK_SHIFT(1, 7)) \
+    X(i, 7, DISPLAY_MASK_SHIFT(0, 8)) \
+    X(i, 8, DISPLAY_MASK_SHIFT(1, 8)) \
+    X(i, 9, DISPLAY_MASK_SHIFT(3, 9)) \
+    X(i, 10, DISPLAY_MASK_SHIFT(1, 12)) \
+    X(i, 11, DISPLAY_MASK_SHIFT(1, 13))
+
+/**
+ * @brief Used to define bitsets representing the different modes
+ *
+ * It expects 12 parameters: One for each five minute block (0, 5, 10, 15,
+ * 20, 25, 30, 35, 40, 45, 50, 55) starting with the one for 0. Each
+ * parameter defines which sub index (variant) should actually be chosen
+ * for this specific five minute "block" from within DISPLAY_MIN_DATA_LIST.
+ *
+ * The range for each parameter depends upon the number of bits that are
+ * used to encode this five minute "block", see DISPLAY_MODE_SHIFT_MASK_LIST.
+ * The five minute "blocks" for 15 and 45 are each three bits wide, the ones
+ * for 5 and 35 are not encoded at all, as there is only one variant for each
+ * of them. All of the other "blocks" are exactly one bit wide.
+ *
+ * @see DISPLAY_MODE_SHIFT_MASK_LIST
+ * @see DISPLAY_MODES_LIST
+ */
+#define _SELECT_MODE(i0, i5, i10, i15, i20, i25, i30, i35, i40, i45, i50, i55) \
+    (i0 | (i10 << 1) | (i15 << 2) | (i20 << 5) | (i25 << 6)  | (i30 << 7) | (i40 << 8) | (i45 << 9) | (i50 << 12) | (i55 << 13))
+
+/**
+ * @brief Different modes that are implemented by this module
+ *
+ * The bit pattern for each of these modes looks like this:
+ *
+ * \verbatim
+ * Bit number | Number of bits | Minutes | Variants
+ *
+ * 1    1   0       x UHR (x O'CLOCK)
+ *                  NACH x UHR (PAST x O'CLOCK)
+ *
+ * 2    1   10      ZEHN NACH x (TEN PAST x)
+ *                  ZWANZIG VOR HALB x+1 (TWENTY TO HALF x+1)
+ *
+ * 3    3   15      VIERTEL NACH x (QUARTER PAST x)
+ *                  VIERTEL x+1 (QUARTER x+1)
+ *                  VIERTEL VOR HALB x+1 (QUARTER TO HALF x+1)
+ *                  DREIVIERTEL VOR x+1 (THREE QUARTERS TO x+1)
+ *                  DREIVIERTEL NACH HALB x (THREE QUARTERS PAST HALF x)
+ *
+ * 6    1   20      ZEHN VOR HALB x+1 (TEN TO HALF x+1)
+ *                  ZWANZIG NACH x (TWENTY PAST x)
+ *
+ * 7    1   25      FÜNF VOR HALB x+1 (FIVE TO HALF x+1)
+ *                  VOR HALB x+1 (TO HALF x+1)
+ *
+ * 8    1   30      HALB x+1 (HALF x+1)
+ *                  NACH HALB x+1 (PAST HALF x+1)
+ *
+ * 9    1   40      ZEHN NACH HALB x+1 (TEN PAST HALF x+1)
+ *                  ZWANZIG VOR x+1 (TWENTY TO x+1)
+ *
+ * 10   3   45      VIERTEL VOR x+1 (QUARTER TO x+1)
+ *                  DREIVIERTEL x+1 (THREE QUARTER x+1)
+ *                  DREIVIERTEL NACH x (THREE QUARTERS PAST x)
+ *                  VIERTEL NACH HALB x+1 (QUARTER PAST HALF x+1)
+ *                  DREIVIERTEL VOR HALB x+2 (THREE QUARTERS TO HALF x+2)
+ *
+ * 13   1   50      ZEHN VOR x+1 (TEN TO x+1)
+ *                  ZWANZIG NACH HALB x+1 (TWENTY PAST HALF x+1)
+ *
+ * 14   1   55      FÜNF VOR x+1 (FIVE TO x+1)
+ *                  VOR x+1 (TO x+1)
+ * \endverbatim
+ *
+ * Notice that "FÜNF NACH" (FIVE PAST) as well as "FÜNF NACH HALB" (FIVE
+ * PAST HALF) are not encoded here, as there are no options for these two
+ * five minute "blocks".
+ *
+ * @see e_WcGerModes
+ * @see _SELECT_MODE()
+ */
+#define DISPLAY_MODES_LIST(X, i) \
+    X(i, 0, _SELECT_MODE(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)) \
+    X(i, 1, _SELECT_MODE(0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0)) \
+    X(i, 2, _SELECT_MODE(0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0)) \
+    X(i, 3, _SELECT_MODE(0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0))
+
+/**
+ * @brief Definition of the hour words for each number from one to twelve
+ *
+ * This is used to display the current hour as part of the current time as
+ * well as to show only the number to give the user some feedback, see
+ * display_getNumberDisplayState().
+ *
+ * @note The number one is defined as "eins". Depending upon the context it
+ * is used in, it might be the case that "ein" is actually needed, see
+ * DISPLAY_ONE_O_CLOCK_MASK.
+ *
+ * @see DISPLAY_NUMBER_BIT()
+ * @see display_getNumberDisplayState()
+ */
+#define DISPLAY_NUMBERS_LIST(X, i) \
+    X(i, 0, (DISPLAY_NUMBER_BIT(DWP_zwoelf))) \
+    X(i, 1, (DISPLAY_NUMBER_BIT(DWP_ei) | DISPLAY_NUMBER_BIT(DWP_n) | DISPLAY_NUMBER_BIT(DWP_s))) \
+    X(i, 2, (DISPLAY_NUMBER_BIT(DWP_zw) | DISPLAY_NUMBER_BIT(DWP_ei))) \
+    X(i, 3, (DISPLAY_NUMBER_BIT(DWP_drei))) \
+    X(i, 4, (DISPLAY_NUMBER_BIT(DWP_vier))) \
+    X(i, 5, (DISPLAY_NUMBER_BIT(DWP_fuenf))) \
+    X(i, 6, (DISPLAY_NUMBER_BIT(DWP_sechs))) \
+    X(i, 7, (DISPLAY_NUMBER_BIT(DWP_s) | DISPLAY_NUMBER_BIT(DWP_ieben))) \
+    X(i, 8, (DISPLAY_NUMBER_BIT(DWP_acht))) \
+    X(i, 9, (DISPLAY_NUMBER_BIT(DWP_neun))) \
+    X(i, 10, (DISPLAY_NUMBER_BIT(DWP_zehn))) \
+    X(i, 11, (DISPLAY_NUMBER_BIT(DWP_elf)))
+
 /**
  * @brief Containing the parameters of this module to be stored persistently
  *
@@ -297,6 +554,17 @@ struct display_prefs_t {
 
     e_WcGerModes mode;
 
+    /**
+     * @brief Chosen animation for time transitions
+     *
+     * This contains the animation used to change over to a new time, which
+     * is a value from e_displayAnimation.
+     *
+     * @see e_displayAnimation
+     * @see display_animateDisplayState()
+     */
+    uint8_t animation;
+
 };
 
 /**
@@ -313,7 +581,8 @@ struct display_prefs_t {
  */
 #define DISPLAYEEPROMPARAMS_DEFAULT { \
 \
-    (e_WcGerModes)0 \
+    (e_WcGerModes)0, \
+    DISPLAY_ANIMATION_FADE \
 \
 }
 
@@ -428,17 +697,4 @@ static inline display_state_t display_getTimeSetIndicatorMask()
 
 }
 
-/**
- * @see display.h
- */
-static inline display_state_t display_getNumberDisplayState(uint8_t number)
-{
-
-    extern const uint16_t s_numbers[12];
-    number = number % 12;
-
-    return ((display_state_t)(s_numbers[number])) << DWP_HOUR_BEGIN;
-
-}
-
 #endif /* _WC_DISPLAY_GER3_H_ */
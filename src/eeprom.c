@@ -21,10 +21,12 @@
  * @file eeprom.c
  * @brief Implementation of module allowing for read and write access to EEPROM
  *
- * This implements the functionality declared in {@link eeprom.h}. For now it
- * is essentially only a wrapper around `<avr/eeprom.h>`.
+ * This implements the functionality declared in {@link eeprom.h}. Reading
+ * and blocking writes are essentially only a wrapper around `<avr/eeprom.h>`.
  *
- * @todo Implement interrupt driven approach using functionality {@link fifo.h}
+ * Asynchronous writes are handled by `ISR(EE_READY_vect)`, which is executed
+ * whenever the EEPROM is ready to accept the next byte. Only a single write
+ * request can be pending at any given time (`eeprom_request`).
  *
  * For details about how the EEPROM works in detail and how to access it from
  * within the program, refer to [1] and/or [2].
@@ -36,9 +38,56 @@
  */
 
 #include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
 
 #include "eeprom.h"
 
+/**
+ * @brief Describes a write request processed by `ISR(EE_READY_vect)`
+ *
+ * @see eeprom_put_block_async()
+ * @see eeprom_request
+ */
+typedef struct {
+
+    /**
+     * @brief Source where to read data from (within SRAM)
+     */
+    const uint8_t* src;
+
+    /**
+     * @brief Destination where to put data to (within EEPROM)
+     */
+    uint8_t* dst;
+
+    /**
+     * @brief Dirty map describing which blocks should be written
+     *
+     * @see EEPROM_DIRTY_BLOCK_SIZE
+     */
+    const uint8_t* dirty;
+
+    /**
+     * @brief Length of data
+     */
+    size_t length;
+
+    /**
+     * @brief Index of the next byte to be processed
+     */
+    size_t index;
+
+} eeprom_request_t;
+
+/**
+ * @brief The write request currently being processed
+ *
+ * @see eeprom_put_block_async()
+ * @see ISR(EE_READY_vect)
+ */
+static volatile eeprom_request_t eeprom_request;
+
 /**
  * @brief Reads in a block with given length from EEPROM
  *
@@ -55,6 +104,8 @@
 void eeprom_get_block(void* dst, const void* src, size_t length)
 {
 
+    while (eeprom_is_busy());
+
     return eeprom_read_block(dst, src, length);
 
 }
@@ -66,6 +117,8 @@ void eeprom_get_block(void* dst, const void* src, size_t length)
  * puts it into the EEPROM location pointed to by dst. The length of the block
  * is described by length.
  *
+ * @note This blocks until all of the data has been written.
+ *
  * @param src Source where to read data from (within SRAM)
  * @param dst Destination where to put data to (within EEPROM)
  * @param length Length of data
@@ -75,6 +128,182 @@ void eeprom_get_block(void* dst, const void* src, size_t length)
 void eeprom_put_block(const void* src, void* dst, size_t length)
 {
 
+    while (eeprom_is_busy());
+
     eeprom_update_block(src, dst, length);
 
 }
+
+/**
+ * @brief Generates a dirty map by comparing data in SRAM with the EEPROM
+ *
+ * This compares the data pointed to by src with the content of the EEPROM
+ * pointed to by dst. For each block (`EEPROM_DIRTY_BLOCK_SIZE`) that differs
+ * the appropriate bit within dirty is set, all other bits are cleared.
+ *
+ * @note Reading from the EEPROM is fast compared to writing, so this is much
+ * cheaper than writing all of the data unconditionally.
+ *
+ * @param src Source where to read data from (within SRAM)
+ * @param dst Location of the data to compare against (within EEPROM)
+ * @param length Length of data
+ * @param dirty Dirty map, needs to be `EEPROM_DIRTY_MAP_SIZE(length)` bytes
+ *
+ * @return True if at least one block differs, false otherwise
+ *
+ * @see EEPROM_DIRTY_BLOCK_SIZE
+ * @see EEPROM_DIRTY_MAP_SIZE()
+ */
+bool eeprom_get_dirty_map(const void* src, const void* dst, size_t length,
+    uint8_t* dirty)
+{
+
+    const uint8_t* s = src;
+    const uint8_t* d = dst;
+    bool changed = false;
+
+    while (eeprom_is_busy());
+
+    for (size_t i = 0; i < EEPROM_DIRTY_MAP_SIZE(length); i++) {
+
+        dirty[i] = 0;
+
+    }
+
+    for (size_t i = 0; i < length; i++) {
+
+        if (s[i] != eeprom_read_byte(&d[i])) {
+
+            size_t block = i / EEPROM_DIRTY_BLOCK_SIZE;
+
+            dirty[block / 8] |= _BV(block % 8);
+            changed = true;
+
+        }
+
+    }
+
+    return changed;
+
+}
+
+/**
+ * @brief Puts a block of data to the EEPROM in the background
+ *
+ * This queues a write request, which will be processed by
+ * `ISR(EE_READY_vect)`. Only the blocks marked within dirty will be written.
+ * Within these blocks only bytes that actually differ from the content of the
+ * EEPROM are written.
+ *
+ * @warning The data pointed to by src and dirty is accessed by the ISR
+ * directly, so it must stay valid until the request has been completed.
+ *
+ * @param src Source where to read data from (within SRAM)
+ * @param dst Destination where to put data to (within EEPROM)
+ * @param length Length of data
+ * @param dirty Dirty map, see `eeprom_get_dirty_map()`
+ *
+ * @return True if the request was queued, false if another one is pending
+ *
+ * @see eeprom_is_busy()
+ * @see ISR(EE_READY_vect)
+ */
+bool eeprom_put_block_async(const void* src, void* dst, size_t length,
+    const uint8_t* dirty)
+{
+
+    if (eeprom_is_busy()) {
+
+        return false;
+
+    }
+
+    eeprom_request.src = src;
+    eeprom_request.dst = dst;
+    eeprom_request.dirty = dirty;
+    eeprom_request.length = length;
+    eeprom_request.index = 0;
+
+    /*
+     * EERIE: EEPROM ready interrupt enable
+     */
+    EECR |= _BV(EERIE);
+
+    return true;
+
+}
+
+/**
+ * @brief Returns whether a write request is currently being processed
+ *
+ * This can be used to poll for the completion of a request queued by
+ * `eeprom_put_block_async()`.
+ *
+ * @return True if a request is still being processed, false otherwise
+ *
+ * @see eeprom_put_block_async()
+ */
+bool eeprom_is_busy()
+{
+
+    return EECR & _BV(EERIE);
+
+}
+
+/**
+ * @brief Writes the next byte of the current write request
+ *
+ * This is executed whenever the EEPROM is ready to accept new data. It
+ * skips over blocks not marked as dirty, as well as bytes that are already
+ * up to date, and starts writing the next byte that actually differs. Once
+ * the end of the request has been reached, the interrupt is disabled again.
+ *
+ * @see eeprom_request
+ * @see eeprom_put_block_async()
+ */
+ISR(EE_READY_vect)
+{
+
+    size_t index = eeprom_request.index;
+
+    while (index < eeprom_request.length) {
+
+        size_t block = index / EEPROM_DIRTY_BLOCK_SIZE;
+
+        if (!(eeprom_request.dirty[block / 8] & _BV(block % 8))) {
+
+            index = (block + 1) * EEPROM_DIRTY_BLOCK_SIZE;
+
+            continue;
+
+        }
+
+        uint8_t data = eeprom_request.src[index];
+
+        EEAR = (uint16_t)(&eeprom_request.dst[index]);
+        EECR |= _BV(EERE);
+
+        index++;
+
+        if (EEDR != data) {
+
+            EEDR = data;
+
+            /*
+             * EEMPE: EEPROM master write enable
+             * EEPE: EEPROM write enable (needs to be set within 4 cycles)
+             */
+            EECR |= _BV(EEMPE);
+            EECR |= _BV(EEPE);
+
+            eeprom_request.index = index;
+
+            return;
+
+        }
+
+    }
+
+    EECR &= ~_BV(EERIE);
+
+}
@@ -24,15 +24,53 @@
  * This module allows to read from and write to the EEPROM coming along with
  * the AVR microcontroller in use.
  *
+ * Besides the blocking functions there is also an interrupt driven approach
+ * for writing data to the EEPROM (`eeprom_put_block_async()`). It only
+ * writes those blocks of data, which are marked within a dirty map. This map
+ * can be generated using `eeprom_get_dirty_map()`. Whether the write request
+ * has been completed can be polled using `eeprom_is_busy()`.
+ *
  * @see eeprom.c
  */
 
 #ifndef _WC_EEPROM_H_
 #define _WC_EEPROM_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+/**
+ * @brief Number of bytes covered by a single bit within a dirty map
+ *
+ * Data is written in blocks of this size by `eeprom_put_block_async()`.
+ * Smaller values allow for more fine grained tracking, but require more
+ * memory for the dirty map itself.
+ *
+ * @see EEPROM_DIRTY_MAP_SIZE()
+ * @see eeprom_get_dirty_map()
+ */
+#define EEPROM_DIRTY_BLOCK_SIZE 4
+
+/**
+ * @brief Calculates the size of a dirty map for data with the given length
+ *
+ * @param length Length of the data the dirty map should cover
+ *
+ * @return Size of the dirty map in bytes
+ *
+ * @see EEPROM_DIRTY_BLOCK_SIZE
+ */
+#define EEPROM_DIRTY_MAP_SIZE(length) \
+    (((length) + (8 * EEPROM_DIRTY_BLOCK_SIZE) - 1) / (8 * EEPROM_DIRTY_BLOCK_SIZE))
+
 void eeprom_get_block(void* dst, const void* src, size_t length);
 void eeprom_put_block(const void* src, void* dst, size_t length);
 
+bool eeprom_get_dirty_map(const void* src, const void* dst, size_t length,
+    uint8_t* dirty);
+bool eeprom_put_block_async(const void* src, void* dst, size_t length,
+    const uint8_t* dirty);
+bool eeprom_is_busy();
+
 #endif /* _WC_EEPROM_H_ */
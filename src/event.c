@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file event.c
+ * @brief Implementation of the header declared in event.h
+ *
+ * The microcontroller is only put to sleep with interrupts being disabled
+ * beforehand, so no event posted in between checking for pending events and
+ * entering the sleep mode can get lost: The instruction following `sei` is
+ * always executed before any pending interrupt is serviced, see [1], p. 15.
+ *
+ * [1]: http://www.atmel.com/images/doc2545.pdf
+ *
+ * @see event.h
+ */
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "event.h"
+
+volatile uint16_t event_pending;
+
+/**
+ * @brief Retrieves and clears all of the pending events
+ *
+ * If no events are pending, this waits until at least one event is posted.
+ * If `EVENT_USE_IDLE_SLEEP` is enabled, the microcontroller is put into
+ * `SLEEP_MODE_IDLE` meanwhile.
+ *
+ * @note Interrupts are enabled once this returns.
+ *
+ * @return Bitfield of the pending events
+ *
+ * @see event_t
+ * @see event_post()
+ * @see EVENT_USE_IDLE_SLEEP
+ */
+uint16_t event_get()
+{
+
+    uint16_t events;
+
+    cli();
+
+    while (!(events = event_pending)) {
+
+        #if (EVENT_USE_IDLE_SLEEP == 1)
+
+            set_sleep_mode(SLEEP_MODE_IDLE);
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+
+        #else
+
+            sei();
+
+        #endif /* (EVENT_USE_IDLE_SLEEP == 1) */
+
+        cli();
+
+    }
+
+    event_pending = 0;
+    sei();
+
+    return events;
+
+}
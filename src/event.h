@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file event.h
+ * @brief Header for posting events to be handled by the main loop
+ *
+ * Modules post events (usually from within their ISRs) by means of
+ * `event_post()` whenever there is something to be done by their handler
+ * within the main loop. The main loop retrieves the pending events by means of
+ * `event_get()` and only dispatches the handlers the events are meant for.
+ * While no events are pending, the microcontroller is put to sleep.
+ *
+ * @see event.c
+ */
+
+#ifndef _WC_EVENT_H_
+#define _WC_EVENT_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/**
+ * @brief Controls whether the microcontroller sleeps while no events are
+ * pending
+ *
+ * If enabled, `SLEEP_MODE_IDLE` is entered, which halts the CPU, while all of
+ * the peripherals and their interrupts keep working. Any interrupt wakes the
+ * CPU up again.
+ *
+ * @see event_get()
+ */
+#define EVENT_USE_IDLE_SLEEP 1
+
+/**
+ * @brief Enumeration of all the events that can be posted
+ *
+ * Each event is represented by a single bit within `event_pending`. Posting
+ * the same event multiple times before it is handled has no further effect.
+ *
+ * @see event_post()
+ * @see event_get()
+ */
+typedef enum {
+
+    /**
+     * @brief Deferred work of the timer is pending
+     *
+     * Posted by `ISR(TIMER1_CAPT_vect)` at least ten times a second.
+     *
+     * @see timer_handle()
+     */
+    EVENT_TIMER,
+
+    /**
+     * @brief The measured brightness has changed
+     *
+     * Posted by `ISR(ADC_vect)`.
+     *
+     * @see brightness_handle()
+     */
+    EVENT_BRIGHTNESS,
+
+    /**
+     * @brief The software clock has ticked
+     *
+     * Posted by `datetime_ISR()` once a second.
+     *
+     * @see datetime_handle()
+     */
+    EVENT_DATETIME,
+
+    /**
+     * @brief A transfer on the I2C bus has been completed
+     *
+     * Posted by `ISR(TWI_vect)` and/or when a transfer has been aborted.
+     *
+     * @see i2c_rtc_handle()
+     * @see datetime_handle()
+     */
+    EVENT_I2C,
+
+    /**
+     * @brief An IR frame has been received
+     *
+     * Posted by `ISR(TIMER1_CAPT_vect)` once IRMP has detected a frame. With
+     * IR_USE_EDGE_CAPTURE enabled, this is posted on every edge of the IR
+     * input instead, and by ir_handle() once it has detected a frame.
+     *
+     * @see handle_ir_code()
+     * @see ir_handle()
+     */
+    EVENT_IR,
+
+    /**
+     * @brief A measurement of the LDR is pending
+     *
+     * This is only used in conjunction with `LDR_USE_NOISE_REDUCTION_SLEEP`.
+     *
+     * @see ldr_handle()
+     */
+    EVENT_LDR,
+
+    /**
+     * @brief A character has been received via UART
+     *
+     * Posted by `ISR(USART_RX_vect)`.
+     *
+     * @see uart_protocol_handle()
+     */
+    EVENT_UART,
+
+    /**
+     * @brief The DCF77 signal can be analyzed
+     *
+     * Posted whenever the DCF77 module sets its CHECK flag.
+     *
+     * @see dcf77_get_datetime()
+     */
+    EVENT_DCF77,
+
+    /**
+     * @brief The motion sensor has detected motion
+     *
+     * Posted by `ISR(PRESENCE_INPUT_PCINT_vect)`. This is only used in
+     * conjunction with `ENABLE_PRESENCE_SUPPORT`.
+     *
+     * @see user_presence_detected()
+     */
+    EVENT_PRESENCE,
+
+} event_t;
+
+/**
+ * @brief Bitfield containing the events not yet handled
+ *
+ * @note This should only be accessed by means of `event_post()` and
+ * `event_get()`.
+ *
+ * @see event_t
+ */
+extern volatile uint16_t event_pending;
+
+/**
+ * @brief Posts the given event
+ *
+ * This can be called from within ISRs as well as from within the main loop.
+ * The main loop will dispatch the appropriate handler with its next
+ * iteration.
+ *
+ * @param event The event to post
+ *
+ * @see event_t
+ * @see event_get()
+ */
+static inline void event_post(event_t event)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    event_pending |= _BV(event);
+    SREG = sreg;
+
+}
+
+extern uint16_t event_get();
+
+#endif /* _WC_EVENT_H_ */
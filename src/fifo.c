@@ -21,11 +21,9 @@
  * @file fifo.c
  * @brief Implementation of functions declared in the header fifo.h
  *
- * This implements all the functionality declared in the header file fifo.h.
- *
- * It is based upon [1] with some minor adaptations.
- *
- * [1]: http://www.rn-wissen.de/index.php/FIFO_mit_avr-gcc
+ * This implements the functionality declared in the header file fifo.h, which
+ * is not defined inline there, i.e. the initialization and the functions
+ * operating on whole blocks of data.
  *
  * @see fifo.h
  */
@@ -43,113 +41,135 @@
  * @param buffer Pointer to buffer in memory for holding the actual data
  * @param size The number of bytes the FIFO should manage
  *
+ * @warning size needs to be a power of two, see FIFO_SIZE_VALID().
+ *
  * @see fifo_t
  */
 void fifo_init(fifo_t* fifo, uint8_t* buffer, uint8_t size)
 {
 
-    fifo->count = 0;
-    fifo->pread = buffer;
-    fifo->pwrite = buffer;
-    fifo->read2end = size;
-    fifo->write2end = size;
-    fifo->size = size;
+    fifo->buffer = buffer;
+    fifo->mask = size - 1;
+    fifo->head = 0;
+    fifo->tail = 0;
 
 }
 
 /**
- * @brief Puts a single byte of data into the FIFO
- *
- * This puts a single byte of data (data) into the FIFO defined by fifo.
+ * @brief Puts a block of data into the FIFO
  *
- * First of all it makes sure that there is actually place left within the
- * buffer. It makes sure that all of the organizational data is updated
- * correctly and disables the global interrupt flag for a brief period of
- * time to prevent any interactions with interrupts.
+ * This copies as much of the given data into the FIFO as there is space
+ * left. The head index is only updated once for the whole block.
  *
- * It returns true when the element could successfully be put into the FIFO,
- * otherwise it will return false, which is an indicator for the FIFO being
- * full.
+ * @note This must only be called by the producer.
  *
  * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
- * @param data The actual data to be put into the FIFO
+ * @param data Pointer to the data to put into the FIFO
+ * @param length Number of bytes to put into the FIFO
+ * @param progmem True if data is stored in program space, false otherwise
  *
- * @return True if data has been put into FIFO, false otherwise
+ * @return Number of bytes actually put into the FIFO
  *
- * @see fifo_t)
+ * @see fifo_put_n()
+ * @see fifo_put_n_p()
  */
-bool fifo_put(fifo_t* fifo, uint8_t data)
+static inline uint8_t _inline_fifo_put_n(fifo_t* fifo, const uint8_t* data, uint8_t length, bool progmem)
 {
 
-    if (fifo->count >= fifo->size) {
+    uint8_t head = fifo->head;
+    uint8_t free = fifo_free(fifo);
 
-        return false;
+    if (length > free) {
 
-    }
+        length = free;
 
-    uint8_t* pwrite = fifo->pwrite;
+    }
 
-    *(pwrite++) = data;
+    for (uint8_t i = 0; i < length; i++) {
 
-    uint8_t write2end = fifo->write2end;
+        fifo->buffer[head++ & fifo->mask] = progmem ? pgm_read_byte(data++) : *(data++);
 
-    if (--write2end == 0) {
+    }
 
-        write2end = fifo->size;
-        pwrite -= write2end;
+    FIFO_BARRIER();
+    fifo->head = head;
 
-    }
+    return length;
 
-    fifo->write2end = write2end;
-    fifo->pwrite = pwrite;
+}
 
-    uint8_t sreg = SREG;
-    cli();
-    fifo->count++;
-    SREG = sreg;
+/**
+ * @brief Puts a block of data into the FIFO
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ * @param data Pointer to the data to put into the FIFO
+ * @param length Number of bytes to put into the FIFO
+ *
+ * @return Number of bytes actually put into the FIFO
+ *
+ * @see _inline_fifo_put_n()
+ */
+uint8_t fifo_put_n(fifo_t* fifo, const uint8_t* data, uint8_t length)
+{
 
-    return true;
+    return _inline_fifo_put_n(fifo, data, length, false);
 
 }
 
 /**
- * @brief Retrieves next byte from the FIFO
- *
- * This retrieves the next byte from the FIFO and returns it. It simply returns
- * the byte pointed to by fifo_t::pread and makes sure that all of the
- * organizational data is updated correctly. It also disables the global
- * interrupt flag for a brief period of time to prevent any interactions with
- * interrupts.
- * *
+ * @brief Puts a block of data stored in program space into the FIFO
+ *
  * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ * @param data Pointer to the data (in program space) to put into the FIFO
+ * @param length Number of bytes to put into the FIFO
  *
- * @return Actual data retrieved from the FIFO.
+ * @return Number of bytes actually put into the FIFO
  *
- * @see fifo_t
+ * @see _inline_fifo_put_n()
  */
-static inline uint8_t _inline_fifo_get(fifo_t* fifo)
+uint8_t fifo_put_n_p(fifo_t* fifo, const uint8_t* data, uint8_t length)
 {
 
-    uint8_t *pread = fifo->pread;
-    uint8_t data = *(pread++);
-    uint8_t read2end = fifo->read2end;
+    return _inline_fifo_put_n(fifo, data, length, true);
 
-    if (--read2end == 0) {
+}
 
-        read2end = fifo->size;
-        pread -= read2end;
+/**
+ * @brief Retrieves a block of data from the FIFO
+ *
+ * This copies up to length bytes from the FIFO to the given location. The
+ * tail index is only updated once for the whole block.
+ *
+ * @note This must only be called by the consumer.
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ * @param data Pointer to location where retrieved data will be put
+ * @param length Maximum number of bytes to retrieve
+ *
+ * @return Number of bytes actually retrieved from the FIFO
+ */
+uint8_t fifo_get_n(fifo_t* fifo, uint8_t* data, uint8_t length)
+{
+
+    uint8_t tail = fifo->tail;
+    uint8_t count = fifo_count(fifo);
+
+    if (length > count) {
+
+        length = count;
 
     }
 
-    fifo->pread = pread;
-    fifo->read2end = read2end;
+    for (uint8_t i = 0; i < length; i++) {
 
-    uint8_t sreg = SREG;
-    cli();
-    fifo->count--;
-    SREG = sreg;
+        *(data++) = fifo->buffer[tail++ & fifo->mask];
 
-    return data;
+    }
+
+    FIFO_BARRIER();
+    fifo->tail = tail;
+
+    return length;
 
 }
 
@@ -159,8 +179,6 @@ static inline uint8_t _inline_fifo_get(fifo_t* fifo)
  * This retrieves the next byte from the FIFO and returns it. When the FIFO is
  * currently empty, it busy waits until there is actually something to return.
  *
- * Internally it makes use of _inline_fifo_get().
- *
  * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
  *
  * @return Actual data retrieved from the FIFO.
@@ -174,41 +192,10 @@ static inline uint8_t _inline_fifo_get(fifo_t* fifo)
 uint8_t fifo_get_wait(fifo_t* fifo)
 {
 
-    while (!fifo->count);
-
-    return _inline_fifo_get(fifo);
-
-}
-
-/**
- * @brief Retrieves next byte from the FIFO - if available
- *
- * This retrieves the next byte from the FIFO and returns it and puts it at the
- * location pointed to by the parameter `data` and returns true. If there is
- * nothing left in the FIFO to retrieve the function simply returns false.
- *
- * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
- * @param data Pointer to location where retrieved data will be put
- *
- * @return Indicates whether something was retrieved from the FIFO
- *
- * @warning Make sure to check the return value, which indicates whether or not
- * something has been retrieved.
- *
- * @see fifo_get_wait()
- * @see fifo_t
- */
-bool fifo_get_nowait(fifo_t* fifo, uint8_t* data)
-{
-
-    if (!fifo->count) {
+    uint8_t data;
 
-        return false;
+    while (!fifo_get_nowait(fifo, &data));
 
-    }
-
-    *data = _inline_fifo_get(fifo);
-
-    return true;
+    return data;
 
 }
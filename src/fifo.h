@@ -24,6 +24,19 @@
  * This header declares all functions and type definitions needed for a FIFO
  * implementation. This FIFO operates only with single bytes (8 bit).
  *
+ * The FIFO is implemented as a ring buffer meant to be used by exactly one
+ * producer and exactly one consumer, e.g. an ISR and the main loop. The
+ * producer only ever modifies fifo_t::head, whereas the consumer only ever
+ * modifies fifo_t::tail. As both of them are 8 bit wide, they can be read and
+ * written atomically, so there is no need to disable interrupts at all.
+ *
+ * Both indexes are running freely and are only masked when accessing the
+ * buffer, so the number of elements is simply their difference. This requires
+ * the size of the buffer to be a power of two.
+ *
+ * The functions used on a per byte basis are defined inline here, so they
+ * compile down to a few instructions, which is especially important for ISRs.
+ *
  * For more information about how a FIFO is supposed to work, refer to [1].
  *
  * [1]: https://en.wikipedia.org/wiki/FIFO
@@ -35,10 +48,40 @@
 #define _WC_FIFO_H_
 
 #include <avr/io.h>
-#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 
 #include <stdbool.h>
 
+/**
+ * @brief Maximum size of a FIFO
+ *
+ * The number of elements is calculated as difference between two 8 bit
+ * indexes, so the size can't be bigger than this.
+ *
+ * @see fifo_init()
+ */
+#define FIFO_SIZE_MAX 128
+
+/**
+ * @brief Checks whether the given size is valid for a FIFO
+ *
+ * The size needs to be a power of two and must not be bigger than
+ * FIFO_SIZE_MAX. This can be used in combination with a static assertion.
+ *
+ * @see FIFO_SIZE_MAX
+ */
+#define FIFO_SIZE_VALID(size) \
+    ((size) > 0 && (size) <= FIFO_SIZE_MAX && ((size) & ((size) - 1)) == 0)
+
+/**
+ * @brief Compiler barrier
+ *
+ * This makes sure that the compiler won't reorder the access to the buffer
+ * and the update of the appropriate index, so the other side will never see
+ * an index before the data has actually been written and/or read.
+ */
+#define FIFO_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
 /**
  * @brief Typedef for variables holding the organizational data of a FIFO
  *
@@ -49,43 +92,137 @@ typedef struct
 {
 
     /**
-     * @brief Number of elements currently stored in the FIFO
+     * @brief Pointer to the buffer holding the actual data
      */
-    uint8_t volatile count;
+    uint8_t* buffer;
 
     /**
-     * @brief Size of the buffer holding the actual data
+     * @brief Mask to apply to the indexes (size of buffer - 1)
      */
-    uint8_t size;
+    uint8_t mask;
 
     /**
-     * @brief Pointer to location where to read from
+     * @brief Index of location to write to next, only modified by producer
      */
-    uint8_t *pread;
+    uint8_t volatile head;
 
     /**
-     * @brief Pointer to location where to write to
+     * @brief Index of location to read from next, only modified by consumer
      */
-    uint8_t *pwrite;
-
-    /**
-     * @brief Number of elements for read pointer to overflow
-     */
-    uint8_t read2end;
-
-    /**
-     * @brief Number of elements for write pointer to overflow
-     */
-    uint8_t write2end;
+    uint8_t volatile tail;
 
 } fifo_t;
 
 extern void fifo_init(fifo_t* fifo, uint8_t* buffer, uint8_t size);
 
-extern bool fifo_put(fifo_t* fifo, uint8_t data);
+extern uint8_t fifo_put_n(fifo_t* fifo, const uint8_t* data, uint8_t length);
+
+extern uint8_t fifo_put_n_p(fifo_t* fifo, const uint8_t* data, uint8_t length);
+
+extern uint8_t fifo_get_n(fifo_t* fifo, uint8_t* data, uint8_t length);
 
 extern uint8_t fifo_get_wait(fifo_t* fifo);
 
-extern bool fifo_get_nowait(fifo_t* fifo, uint8_t* data);
+/**
+ * @brief Returns the number of elements currently stored in the FIFO
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ *
+ * @return Number of elements within the FIFO
+ */
+static inline uint8_t fifo_count(const fifo_t* fifo)
+{
+
+    return fifo->head - fifo->tail;
+
+}
+
+/**
+ * @brief Returns the number of bytes that can currently be put into the FIFO
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ *
+ * @return Number of bytes left within the FIFO
+ */
+static inline uint8_t fifo_free(const fifo_t* fifo)
+{
+
+    return fifo->mask + 1 - fifo_count(fifo);
+
+}
+
+/**
+ * @brief Puts a single byte of data into the FIFO
+ *
+ * It returns true when the element could successfully be put into the FIFO,
+ * otherwise it will return false, which is an indicator for the FIFO being
+ * full.
+ *
+ * @note This must only be called by the producer.
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ * @param data The actual data to be put into the FIFO
+ *
+ * @return True if data has been put into FIFO, false otherwise
+ *
+ * @see fifo_t
+ */
+static inline bool fifo_put(fifo_t* fifo, uint8_t data)
+{
+
+    uint8_t head = fifo->head;
+
+    if ((uint8_t)(head - fifo->tail) > fifo->mask) {
+
+        return false;
+
+    }
+
+    fifo->buffer[head & fifo->mask] = data;
+    FIFO_BARRIER();
+    fifo->head = head + 1;
+
+    return true;
+
+}
+
+/**
+ * @brief Retrieves next byte from the FIFO - if available
+ *
+ * This retrieves the next byte from the FIFO, puts it at the location pointed
+ * to by the parameter `data` and returns true. If there is nothing left in
+ * the FIFO to retrieve the function simply returns false.
+ *
+ * @note This must only be called by the consumer.
+ *
+ * @param fifo Pointer to the organizational data for the FIFO of type fifo_t
+ * @param data Pointer to location where retrieved data will be put
+ *
+ * @return Indicates whether something was retrieved from the FIFO
+ *
+ * @warning Make sure to check the return value, which indicates whether or not
+ * something has been retrieved.
+ *
+ * @see fifo_get_wait()
+ * @see fifo_t
+ */
+static inline bool fifo_get_nowait(fifo_t* fifo, uint8_t* data)
+{
+
+    uint8_t tail = fifo->tail;
+
+    if (fifo->head == tail) {
+
+        return false;
+
+    }
+
+    *data = fifo->buffer[tail & fifo->mask];
+    FIFO_BARRIER();
+    fifo->tail = tail + 1;
+
+    return true;
+
+}
 
 #endif /* _WC_FIFO_H_ */
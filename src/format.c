@@ -19,34 +19,215 @@
 
 /**
  * @file format.c
- * @brief Definitions of formats declared in format.h
+ * @brief Implementation of the header declared in format.h
  *
- * This contains the actual definitions of formats specified within format.h.
+ * Hexadecimal digits are looked up nibble by nibble within a table. As the
+ * AVR has no instruction for divisions, decimals are built up by repeatedly
+ * subtracting the powers of ten instead, which takes at most 9 iterations per
+ * digit.
  *
  * @see format.h
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
 #include "format.h"
 
 /**
- * @brief Format string describing an unsigned decimal of variable length
+ * @brief Lookup table for the digits of hexadecimals
+ *
+ * @see format_nibble()
  */
-char const fmt_output_unsigned_decimal[] PROGMEM = "%u";
+static const char format_hex_digits[16] PROGMEM = "0123456789abcdef";
 
 /**
- * @brief Format string describing a (unsigned) hexadecimal of variable length
+ * @brief Powers of ten used to build up decimals
+ *
+ * @see format_dec()
  */
-char const fmt_output_hex[] PROGMEM = "%x";
+static const uint16_t format_powers_of_ten[] PROGMEM = {10000, 1000, 100, 10};
 
 /**
- * @brief Format string used for outputting a single byte as hex
+ * @brief Returns the hexadecimal digit of the given nibble
  *
- * This puts out a single byte as hex. The length will always be two
- * characters (padded with `0`).
+ * @param nibble Value in the range of 0 to 15
+ *
+ * @return Character representing the given nibble
+ *
+ * @see format_hex_digits
  */
-char const fmt_output_byte_as_hex[] PROGMEM = "%02x";
+static inline char format_nibble(uint8_t nibble)
+{
+
+    return pgm_read_byte(&format_hex_digits[nibble & 0x0f]);
+
+}
 
 /**
- * @brief Format string used for scanning in a single byte as hex
+ * @brief Puts the hexadecimal representation of a byte into the given string
+ *
+ * The representation always consists of two digits (padded with `0`).
+ *
+ * @param str Location to put the representation (three bytes) in
+ * @param value Value to convert
+ *
+ * @return Pointer to the null terminator
  */
-char const fmt_input_byte_as_hex[] PROGMEM = "%hhx";
+char* format_hex8(char* str, uint8_t value)
+{
+
+    *str++ = format_nibble(value >> 4);
+    *str++ = format_nibble(value);
+    *str = '\0';
+
+    return str;
+
+}
+
+/**
+ * @brief Puts the hexadecimal representation of a word into the given string
+ *
+ * The representation always consists of four digits (padded with `0`).
+ *
+ * @param str Location to put the representation (five bytes) in
+ * @param value Value to convert
+ *
+ * @return Pointer to the null terminator
+ */
+char* format_hex16(char* str, uint16_t value)
+{
+
+    return format_hex8(format_hex8(str, value >> 8), value);
+
+}
+
+/**
+ * @brief Puts the hexadecimal representation of a word into the given string
+ *
+ * In contrast to format_hex16() leading zeros are omitted.
+ *
+ * @param str Location to put the representation (up to five bytes) in
+ * @param value Value to convert
+ *
+ * @return Pointer to the null terminator
+ */
+char* format_hex(char* str, uint16_t value)
+{
+
+    int8_t shift = 12;
+
+    while (shift > 0 && !(value >> shift)) {
+
+        shift -= 4;
+
+    }
+
+    for (; shift >= 0; shift -= 4) {
+
+        *str++ = format_nibble(value >> shift);
+
+    }
+
+    *str = '\0';
+
+    return str;
+
+}
+
+/**
+ * @brief Puts the decimal representation of a word into the given string
+ *
+ * Leading zeros are omitted.
+ *
+ * @param str Location to put the representation (up to
+ * FORMAT_DEC_MAX_LENGTH bytes) in
+ * @param value Value to convert
+ *
+ * @return Pointer to the null terminator
+ *
+ * @see format_powers_of_ten
+ */
+char* format_dec(char* str, uint16_t value)
+{
+
+    bool leading = true;
+
+    for (uint8_t i = 0; i < sizeof(format_powers_of_ten) / sizeof(format_powers_of_ten[0]); i++) {
+
+        uint16_t power = pgm_read_word(&format_powers_of_ten[i]);
+        char digit = '0';
+
+        while (value >= power) {
+
+            value -= power;
+            digit++;
+
+        }
+
+        if (digit != '0' || !leading) {
+
+            *str++ = digit;
+            leading = false;
+
+        }
+
+    }
+
+    *str++ = '0' + value;
+    *str = '\0';
+
+    return str;
+
+}
+
+/**
+ * @brief Parses the hexadecimal representation of a byte
+ *
+ * The string needs to consist of exactly two hexadecimal digits (either upper
+ * or lower case) and nothing else.
+ *
+ * @param str String to parse
+ * @param value Pointer to variable the result is put in
+ *
+ * @return True if the string could be parsed, false otherwise
+ */
+bool format_parse_hex8(const char* str, uint8_t* value)
+{
+
+    uint8_t result = 0;
+
+    for (uint8_t i = 0; i < 2; i++) {
+
+        char c = str[i];
+
+        if (c >= '0' && c <= '9') {
+
+            c -= '0';
+
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+
+            c = (c | 0x20) - 'a' + 10;
+
+        } else {
+
+            return false;
+
+        }
+
+        result = (result << 4) | c;
+
+    }
+
+    if (str[2] != '\0') {
+
+        return false;
+
+    }
+
+    *value = result;
+
+    return true;
+
+}
@@ -19,15 +19,18 @@
 
 /**
  * @file format.h
- * @brief Format string specifier for the whole project
+ * @brief Conversion of numbers from and to their textual representation
  *
- * This module specifies various format strings (mainly meant to be used by the
- * printf() and scanf() function family, which can be used throughout the whole
- * project. Defining these formats globally makes sure that they are only
- * included once, saving on program space.
+ * This module provides fixed-function routines to convert numbers into their
+ * hexadecimal and decimal representation and vice versa. They are meant to be
+ * used instead of the printf() and scanf() function family, which would pull
+ * in the rather large implementations of vfprintf() and vfscanf() and take
+ * hundreds of cycles for each number.
  *
- * This file contains only the declarations to make the variables accessible
- * for other modules. The actual definitions can be found within format.c.
+ * The output functions write the digits to the given location followed by a
+ * null terminator and return a pointer to the terminator, so multiple
+ * numbers can be put one after another easily. The caller needs to make sure
+ * that there is enough space.
  *
  * @see format.c
  */
@@ -35,12 +38,23 @@
 #ifndef _WC_FORMAT_H_
 #define _WC_FORMAT_H_
 
-#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-extern char const fmt_output_unsigned_decimal[] PROGMEM;
-extern char const fmt_output_hex[] PROGMEM;
-extern char const fmt_output_byte_as_hex[] PROGMEM;
+/**
+ * @brief Maximum number of characters needed for a decimal of 16 bit
+ *
+ * This includes the null terminator.
+ *
+ * @see format_dec()
+ */
+#define FORMAT_DEC_MAX_LENGTH 6
+
+extern char* format_hex8(char* str, uint8_t value);
+extern char* format_hex16(char* str, uint16_t value);
+extern char* format_hex(char* str, uint16_t value);
+extern char* format_dec(char* str, uint16_t value);
 
-extern char const fmt_input_byte_as_hex[] PROGMEM;
+extern bool format_parse_hex8(const char* str, uint8_t* value);
 
 #endif /* _WC_FORMAT_H_ */
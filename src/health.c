@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file health.c
+ * @brief Implementation of the header declared in health.h
+ *
+ * The counters are kept within the RAM and written to the SRAM of the RTC
+ * by means of its cache (see I2C_RTC_SRAM_CACHE) every
+ * HEALTH_PERSIST_INTERVAL_S seconds. Failures can be counted from within
+ * ISRs, so the counters are only accessed with interrupts disabled.
+ *
+ * @see health.h
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+
+#include "config.h"
+#include "health.h"
+#include "i2c_rtc.h"
+
+#if (ENABLE_HEALTH_COUNTERS == 1)
+
+#if (I2C_RTC_SRAM_CACHE == 0)
+
+    #error "Health counters need I2C_RTC_SRAM_CACHE to be enabled"
+
+#endif /* (I2C_RTC_SRAM_CACHE == 0) */
+
+/**
+ * @brief Location of the record within the SRAM of the RTC
+ *
+ * @see health_record_t
+ */
+#define HEALTH_SRAM_ADDRESS I2C_RTC_SRAM_START
+
+/**
+ * @brief Record kept within the SRAM of the RTC
+ *
+ * Only the number of counters actually stored (see count) is covered by the
+ * CRC, so records written by a version of the firmware with fewer counters
+ * can be carried over.
+ *
+ * @see HEALTH_SRAM_ADDRESS
+ * @see health_get_crc()
+ */
+typedef struct {
+
+    /**
+     * @brief CRC over the members below
+     *
+     * @see health_get_crc()
+     */
+    uint16_t crc;
+
+    /**
+     * @brief Number of counters stored within this record
+     */
+    uint8_t count;
+
+    /**
+     * @brief See health_t::loop_rate_max
+     */
+    uint16_t loop_rate_max;
+
+    /**
+     * @brief See health_t::counters
+     */
+    uint16_t counters[HEALTH_COUNTER_COUNT];
+
+} health_record_t;
+
+/**
+ * @brief Current health of the firmware
+ *
+ * @see health_get()
+ */
+static volatile health_t health;
+
+/**
+ * @brief Iterations of the main loop during the current second
+ *
+ * @see health_loop()
+ * @see health_isr1Hz()
+ */
+static uint16_t health_loop_count;
+
+/**
+ * @brief Seconds since the counters have been written to the RTC
+ *
+ * @see HEALTH_PERSIST_INTERVAL_S
+ */
+static uint8_t health_seconds;
+
+/**
+ * @brief Calculates the CRC of the given record
+ *
+ * @param record Record to calculate the CRC for
+ *
+ * @return CRC over everything but health_record_t::crc itself, taking into
+ * account only health_record_t::count counters
+ *
+ * @see health_record_t::crc
+ */
+static uint16_t health_get_crc(const health_record_t* record)
+{
+
+    const uint8_t* ptr = &record->count;
+    uint8_t length = offsetof(health_record_t, counters)
+        - offsetof(health_record_t, count) + record->count * sizeof(uint16_t);
+    uint16_t crc = 0xffff;
+
+    while (length--) {
+
+        crc = _crc16_update(crc, *ptr++);
+
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Writes the counters to the SRAM of the RTC
+ *
+ * This happens in the background, and only bytes that have changed since
+ * the last time are actually transferred.
+ *
+ * @see i2c_rtc_sram_cache_set()
+ */
+static void health_persist()
+{
+
+    health_record_t record;
+
+    record.count = HEALTH_COUNTER_COUNT;
+
+    uint8_t sreg = SREG;
+    cli();
+
+    record.loop_rate_max = health.loop_rate_max;
+
+    for (uint8_t i = 0; i < HEALTH_COUNTER_COUNT; i++) {
+
+        record.counters[i] = health.counters[i];
+
+    }
+
+    SREG = sreg;
+
+    record.crc = health_get_crc(&record);
+
+    i2c_rtc_sram_cache_set(HEALTH_SRAM_ADDRESS, &record, sizeof(record));
+
+}
+
+/**
+ * @brief Initializes the health counters
+ *
+ * This picks up the counters kept by the RTC, as long as the record is
+ * intact. Failures that have already been counted during the initialization
+ * of the RTC are added on top of them.
+ *
+ * @note This needs to be invoked once the RTC has been initialized, see
+ * datetime_init().
+ *
+ * @see health_record_t
+ */
+void health_init()
+{
+
+    health_record_t record;
+
+    if (!i2c_rtc_sram_cache_get(HEALTH_SRAM_ADDRESS, &record, sizeof(record))
+            || record.count > HEALTH_COUNTER_COUNT
+            || record.crc != health_get_crc(&record)) {
+
+        return;
+
+    }
+
+    health.loop_rate_max = record.loop_rate_max;
+
+    for (uint8_t i = 0; i < record.count; i++) {
+
+        uint16_t counter = health.counters[i] + record.counters[i];
+
+        // Saturate in case of an overflow
+        health.counters[i] = counter < record.counters[i] ? UINT16_MAX : counter;
+
+    }
+
+}
+
+/**
+ * @brief Counts a single failure
+ *
+ * This can also be called from within an ISR.
+ *
+ * @param counter The counter to increment
+ *
+ * @see health_counter_t
+ */
+void health_count(health_counter_t counter)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+
+    if (health.counters[counter] != UINT16_MAX) {
+
+        health.counters[counter]++;
+
+    }
+
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Counts a single iteration of the main loop
+ *
+ * This needs to be invoked with each iteration of the main loop.
+ *
+ * @see health_loop_count
+ */
+void health_loop()
+{
+
+    if (health_loop_count != UINT16_MAX) {
+
+        health_loop_count++;
+
+    }
+
+}
+
+/**
+ * @brief Samples the rate of the main loop
+ *
+ * This is executed within `INTERRUPT_1HZ_DEFERRED`, i.e. from within the
+ * main loop. Every HEALTH_PERSIST_INTERVAL_S seconds the counters are
+ * written to the RTC.
+ *
+ * @see INTERRUPT_1HZ_DEFERRED
+ * @see health_persist()
+ */
+void health_isr1Hz()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+
+    health.loop_rate = health_loop_count;
+
+    if (health_loop_count > health.loop_rate_max) {
+
+        health.loop_rate_max = health_loop_count;
+
+    }
+
+    SREG = sreg;
+
+    health_loop_count = 0;
+
+    if (++health_seconds >= HEALTH_PERSIST_INTERVAL_S) {
+
+        health_seconds = 0;
+        health_persist();
+
+    }
+
+}
+
+/**
+ * @brief Retrieves the current health of the firmware
+ *
+ * @param o_health Pointer to memory the health will be copied to
+ *
+ * @see health_t
+ */
+void health_get(health_t* o_health)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    memcpy(o_health, (const void*)&health, sizeof(health_t));
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Resets all of the counters
+ *
+ * The counters kept by the RTC are cleared right away, too.
+ *
+ * @see health_persist()
+ */
+void health_reset()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    memset((void*)&health, 0, sizeof(health_t));
+    SREG = sreg;
+
+    health_seconds = 0;
+    health_persist();
+
+}
+
+#endif /* (ENABLE_HEALTH_COUNTERS == 1) */
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file health.h
+ * @brief Header for keeping track of the health of the firmware at runtime
+ *
+ * Various failures are not fatal and are recovered from silently, e.g. data
+ * lost by the UART, failed transfers on the I2C bus or preferences that
+ * couldn't be written. This module counts these failures, along with the
+ * number of iterations of the main loop per second. The counters are kept
+ * within the battery backed SRAM of the RTC, so they survive resets and
+ * even a loss of power, and can be retrieved via the UART protocol. This
+ * makes it possible to spot a degradation of clocks that have been running
+ * for a long time.
+ *
+ * @see health.c
+ * @see ENABLE_HEALTH_COUNTERS
+ */
+
+#ifndef _WC_HEALTH_H_
+#define _WC_HEALTH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+/**
+ * @brief Interval in which the counters are written to the RTC (in seconds)
+ *
+ * Only those bytes that have actually changed are written, so this mostly
+ * limits the traffic on the I2C bus while failures keep occurring.
+ *
+ * @see health_isr1Hz()
+ */
+#define HEALTH_PERSIST_INTERVAL_S 60
+
+/**
+ * @brief Failures that are counted
+ *
+ * @note New counters need to be appended, so the counters kept by the RTC
+ * can be carried over by a new version of the firmware.
+ *
+ * @see health_count()
+ */
+typedef enum {
+
+    /**
+     * @brief Bytes lost during reception via UART
+     *
+     * This includes both, bytes that didn't fit into the FIFO and data
+     * overruns reported by the hardware.
+     *
+     * @see ISR(USART_RX_vect)
+     */
+    HEALTH_UART_RX_DROPS,
+
+    /**
+     * @brief Data that couldn't be put into the transmission FIFO in time
+     *
+     * @see UART_TX_TIMEOUT_MS
+     */
+    HEALTH_UART_TX_DROPS,
+
+    /**
+     * @brief Transfers on the I2C bus that have failed
+     *
+     * @see I2C_MASTER_TRANSFER_FAILED
+     */
+    HEALTH_I2C_ERRORS,
+
+    /**
+     * @brief Failures to initialize, read and/or write the RTC
+     *
+     * @see datetime_handle()
+     * @see datetime_set()
+     */
+    HEALTH_RTC_ERRORS,
+
+    /**
+     * @brief Records of the preferences that couldn't be verified after
+     * being written to the EEPROM
+     *
+     * @see preferences_handle()
+     */
+    HEALTH_PREFS_ERRORS,
+
+    HEALTH_COUNTER_COUNT
+
+} health_counter_t;
+
+/**
+ * @brief Health of the firmware as reported by health_get()
+ *
+ * All of the counters saturate at `UINT16_MAX`.
+ *
+ * @see health_get()
+ */
+typedef struct {
+
+    /**
+     * @brief Iterations of the main loop during the last second
+     */
+    uint16_t loop_rate;
+
+    /**
+     * @brief Highest number of iterations of the main loop within a second
+     */
+    uint16_t loop_rate_max;
+
+    /**
+     * @brief Failures counted so far
+     *
+     * @see health_counter_t
+     */
+    uint16_t counters[HEALTH_COUNTER_COUNT];
+
+} health_t;
+
+#if (ENABLE_HEALTH_COUNTERS == 1)
+
+    extern void health_init();
+
+    extern void health_count(health_counter_t counter);
+
+    extern void health_loop();
+
+    extern void health_isr1Hz();
+
+    extern void health_get(health_t* o_health);
+
+    extern void health_reset();
+
+#else
+
+    /**
+     * @brief Empty macro in case health counters are disabled
+     *
+     * @see ENABLE_HEALTH_COUNTERS
+     */
+    #define health_init()
+
+    /**
+     * @brief Empty macro in case health counters are disabled
+     *
+     * @see ENABLE_HEALTH_COUNTERS
+     */
+    #define health_count(counter)
+
+    /**
+     * @brief Empty macro in case health counters are disabled
+     *
+     * @see ENABLE_HEALTH_COUNTERS
+     */
+    #define health_loop()
+
+    /**
+     * @brief Empty macro in case health counters are disabled
+     *
+     * @see ENABLE_HEALTH_COUNTERS
+     */
+    #define health_isr1Hz()
+
+#endif /* (ENABLE_HEALTH_COUNTERS == 1) */
+
+#endif /* _WC_HEALTH_H_ */
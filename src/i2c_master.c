@@ -28,6 +28,12 @@
  *
  * For details about the hardware unit itself, refer to [3].
  *
+ * The transaction engine keeps the transfers submitted by i2c_master_submit()
+ * in a singly linked queue. The transfer at its head is driven by
+ * `ISR(TWI_vect)` one step at a time. Whenever a transfer has been completed,
+ * the next one is started right away by generating a stop condition followed
+ * by a start condition.
+ *
  * [1]: https://en.wikipedia.org/wiki/I%C2%B2C
  * [2]: http://www.nxp.com/documents/user_manual/UM10204.pdf
  * [3]: http://www.atmel.com/images/doc2545.pdf
@@ -36,11 +42,16 @@
  */
 
 #include <inttypes.h>
+#include <stddef.h>
+#include <avr/interrupt.h>
 #include <util/twi.h>
 #include <util/delay.h>
 
+#include "event.h"
+#include "health.h"
 #include "i2c_master.h"
 #include "ports.h"
+#include "timer.h"
 
 /**
  * @brief Loop waiting for the current transmission to be completed
@@ -124,6 +135,37 @@
 
 #endif
 
+/**
+ * @brief First transfer within the queue, which is currently being executed
+ *
+ * @see i2c_master_submit()
+ */
+static i2c_master_transfer_t* volatile i2c_queue_head;
+
+/**
+ * @brief Last transfer within the queue
+ *
+ * This is only valid as long as i2c_queue_head is not NULL.
+ *
+ * @see i2c_master_submit()
+ */
+static i2c_master_transfer_t* i2c_queue_tail;
+
+/**
+ * @brief Index of the next byte to transfer within the current transfer
+ *
+ * @see i2c_master_step()
+ */
+static uint8_t i2c_queue_index;
+
+/**
+ * @brief Timestamp at which the current transfer has been started
+ *
+ * @see timer_get_ms()
+ * @see i2c_master_handle()
+ */
+static uint16_t i2c_queue_started;
+
 /**
  * @brief Resets the I2C bus
  *
@@ -272,6 +314,341 @@ bool i2c_master_init(i2c_master_error_t* error)
 
 }
 
+/**
+ * @brief Starts the transfer at the head of the queue
+ *
+ * @param stop Whether a stop condition needs to be generated beforehand
+ *
+ * @see i2c_queue_head
+ */
+static void i2c_master_begin(bool stop)
+{
+
+    i2c_queue_head->state = I2C_MASTER_TRANSFER_BUSY;
+    i2c_queue_index = 0;
+    i2c_queue_started = timer_get_ms();
+
+    TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE)
+        | (stop ? _BV(TWSTO) : 0);
+
+}
+
+/**
+ * @brief Completes the transfer at the head of the queue
+ *
+ * This sets the state of the transfer, posts `EVENT_I2C`, invokes its
+ * callback and starts the next transfer within the queue. If the queue is
+ * empty, the bus is released. Failed transfers are counted by the health
+ * counters (see HEALTH_I2C_ERRORS).
+ *
+ * @param state State the transfer has ended up in
+ * @param status Status of the I2C hardware unit
+ *
+ * @see i2c_master_transfer_t::callback
+ */
+static void i2c_master_complete(i2c_master_transfer_state_t state, uint8_t status)
+{
+
+    i2c_master_transfer_t* transfer = i2c_queue_head;
+
+    i2c_queue_head = transfer->next;
+    transfer->status = status;
+    transfer->state = state;
+    event_post(EVENT_I2C);
+
+    if (state == I2C_MASTER_TRANSFER_FAILED) {
+
+        health_count(HEALTH_I2C_ERRORS);
+
+    }
+
+    if (transfer->callback) {
+
+        transfer->callback(transfer);
+
+    }
+
+    if (i2c_queue_head) {
+
+        i2c_master_begin(true);
+
+    } else {
+
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+
+    }
+
+}
+
+/**
+ * @brief Performs the next step of the transfer at the head of the queue
+ *
+ * This is invoked whenever the I2C hardware unit has finished its current
+ * operation and evaluates its status in order to figure out what to do next.
+ * Any unexpected status causes the transfer to fail.
+ *
+ * @see ISR(TWI_vect)
+ */
+static void i2c_master_step()
+{
+
+    i2c_master_transfer_t* transfer = i2c_queue_head;
+    uint8_t twcr = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+
+    switch (TW_STATUS) {
+
+        case TW_START:
+
+            TWDR = transfer->address + TW_WRITE;
+
+            break;
+
+        case TW_REP_START:
+
+            TWDR = transfer->address + TW_READ;
+
+            break;
+
+        case TW_MT_SLA_ACK:
+
+            TWDR = transfer->reg;
+
+            break;
+
+        case TW_MT_DATA_ACK:
+
+            if (transfer->read) {
+
+                twcr |= _BV(TWSTA);
+
+            } else if (i2c_queue_index < transfer->length) {
+
+                TWDR = transfer->data[i2c_queue_index++];
+
+            } else {
+
+                i2c_master_complete(I2C_MASTER_TRANSFER_DONE, TW_STATUS);
+
+                return;
+
+            }
+
+            break;
+
+        case TW_MR_SLA_ACK:
+
+            if (transfer->length > 1) {
+
+                twcr |= _BV(TWEA);
+
+            }
+
+            break;
+
+        case TW_MR_DATA_ACK:
+
+            transfer->data[i2c_queue_index++] = TWDR;
+
+            if (i2c_queue_index < transfer->length - 1) {
+
+                twcr |= _BV(TWEA);
+
+            }
+
+            break;
+
+        case TW_MR_DATA_NACK:
+
+            transfer->data[i2c_queue_index++] = TWDR;
+            i2c_master_complete(I2C_MASTER_TRANSFER_DONE, TW_STATUS);
+
+            return;
+
+        default:
+
+            i2c_master_complete(I2C_MASTER_TRANSFER_FAILED, TW_STATUS);
+
+            return;
+
+    }
+
+    TWCR = twcr;
+
+}
+
+/**
+ * @brief Aborts the transfer at the head of the queue
+ *
+ * The I2C hardware unit is disabled and the bus is reset by means of
+ * i2c_reset(). The transfer fails with the status `TW_NO_INFO`, and the next
+ * transfer within the queue is started.
+ *
+ * @see i2c_reset()
+ * @see I2C_MASTER_TIMEOUT_MS
+ */
+static void i2c_master_abort()
+{
+
+    i2c_master_error_t error;
+
+    TWCR = 0;
+    i2c_reset(&error);
+
+    uint8_t sreg = SREG;
+    cli();
+
+    if (i2c_queue_head) {
+
+        TWCR = _BV(TWEN);
+        i2c_master_complete(I2C_MASTER_TRANSFER_FAILED, TW_NO_INFO);
+
+    }
+
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Queues a transfer to be executed in the background
+ *
+ * The transfer is appended to the queue and will be executed once all of the
+ * previously submitted transfers have been completed. Its progress can be
+ * tracked by means of i2c_master_transfer_t::state and/or
+ * i2c_master_transfer_t::callback.
+ *
+ * @note The bus needs to be initialized by i2c_master_init() beforehand.
+ *
+ * @param transfer Pointer to the descriptor of the transfer
+ *
+ * @return True if the transfer has been queued, false if it is already queued
+ *
+ * @see i2c_master_transfer_t
+ * @see i2c_master_wait()
+ */
+bool i2c_master_submit(i2c_master_transfer_t* transfer)
+{
+
+    if (transfer->state == I2C_MASTER_TRANSFER_QUEUED
+            || transfer->state == I2C_MASTER_TRANSFER_BUSY) {
+
+        return false;
+
+    }
+
+    transfer->state = I2C_MASTER_TRANSFER_QUEUED;
+    transfer->next = NULL;
+
+    uint8_t sreg = SREG;
+    cli();
+
+    if (i2c_queue_head) {
+
+        i2c_queue_tail->next = transfer;
+        i2c_queue_tail = transfer;
+
+    } else {
+
+        i2c_queue_head = i2c_queue_tail = transfer;
+        i2c_master_begin(false);
+
+    }
+
+    SREG = sreg;
+
+    return true;
+
+}
+
+/**
+ * @brief Waits for a queued transfer to be completed
+ *
+ * This busy waits until the given transfer has been completed. It also works
+ * with interrupts being disabled, e.g. during the initialization, in which
+ * case the I2C hardware unit is polled instead. Transfers taking longer than
+ * I2C_MASTER_TIMEOUT_MS are aborted.
+ *
+ * @param transfer Pointer to the descriptor of the transfer
+ *
+ * @return True if the transfer has been completed successfully
+ *
+ * @see i2c_master_submit()
+ * @see i2c_master_abort()
+ */
+bool i2c_master_wait(i2c_master_transfer_t* transfer)
+{
+
+    uint16_t timeout = I2C_MASTER_TIMEOUT_MS * 10;
+
+    while (transfer->state == I2C_MASTER_TRANSFER_QUEUED
+            || transfer->state == I2C_MASTER_TRANSFER_BUSY) {
+
+        if (!(SREG & _BV(SREG_I)) && (TWCR & _BV(TWINT))) {
+
+            i2c_master_step();
+
+            continue;
+
+        }
+
+        if (--timeout == 0) {
+
+            i2c_master_abort();
+            timeout = I2C_MASTER_TIMEOUT_MS * 10;
+
+        }
+
+        _delay_us(100);
+
+    }
+
+    return transfer->state == I2C_MASTER_TRANSFER_DONE;
+
+}
+
+/**
+ * @brief Checks whether the current transfer has timed out
+ *
+ * This needs to be called on a regular basis from within the main loop. If
+ * the transfer at the head of the queue has been running for longer than
+ * I2C_MASTER_TIMEOUT_MS, it is aborted by means of i2c_master_abort().
+ *
+ * @see I2C_MASTER_TIMEOUT_MS
+ * @see i2c_master_abort()
+ */
+void i2c_master_handle()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+
+    bool timeout = i2c_queue_head
+        && (uint16_t)(timer_get_ms() - i2c_queue_started) >= I2C_MASTER_TIMEOUT_MS;
+
+    SREG = sreg;
+
+    if (timeout) {
+
+        i2c_master_abort();
+
+    }
+
+}
+
+/**
+ * @brief TWI interrupt handler (ISR)
+ *
+ * This is executed whenever the I2C hardware unit has finished its current
+ * operation while a queued transfer is being executed.
+ *
+ * @see i2c_master_step()
+ */
+ISR(TWI_vect)
+{
+
+    i2c_master_step();
+
+}
+
 /**
  * @brief Starts an I2C transfer by generating a start condition
  *
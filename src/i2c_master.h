@@ -27,6 +27,12 @@
  * implements the I2C master mode in both directions - transmission and
  * reception.
  *
+ * Beside the functions that busy wait for each step of a transfer, there is
+ * also an interrupt driven transaction engine. Transfers are described by
+ * i2c_master_transfer_t, queued by i2c_master_submit() and executed in the
+ * background by `ISR(TWI_vect)`. Their completion can either be polled for
+ * or signaled by means of a callback.
+ *
  * This library was originally based upon a library named
  * "I2C Master Interface" from Peter Fleury, see [1].
  *
@@ -39,6 +45,7 @@
 #define _WC_I2C_MASTER_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @brief Clock frequency of the I2C bus
@@ -94,8 +101,140 @@ typedef enum {
 
 } i2c_master_error_t;
 
+/**
+ * @brief Maximum amount of time a queued transfer is allowed to take (in ms)
+ *
+ * Once a transfer takes longer than this, it is aborted and the bus is reset.
+ *
+ * @see i2c_master_handle()
+ * @see i2c_master_wait()
+ */
+#define I2C_MASTER_TIMEOUT_MS 20
+
+/**
+ * @brief States of a transfer queued by i2c_master_submit()
+ *
+ * @see i2c_master_transfer_t::state
+ */
+typedef enum {
+
+    /**
+     * @brief Transfer has not been queued (yet)
+     */
+    I2C_MASTER_TRANSFER_IDLE,
+
+    /**
+     * @brief Transfer is waiting for previous transfers to be completed
+     */
+    I2C_MASTER_TRANSFER_QUEUED,
+
+    /**
+     * @brief Transfer is currently being executed
+     */
+    I2C_MASTER_TRANSFER_BUSY,
+
+    /**
+     * @brief Transfer has been completed successfully
+     */
+    I2C_MASTER_TRANSFER_DONE,
+
+    /**
+     * @brief Transfer has failed
+     *
+     * The status of the I2C hardware unit at the time of the failure can be
+     * found in i2c_master_transfer_t::status.
+     */
+    I2C_MASTER_TRANSFER_FAILED,
+
+} i2c_master_transfer_state_t;
+
+typedef struct i2c_master_transfer i2c_master_transfer_t;
+
+/**
+ * @brief Type of callback invoked once a queued transfer has been completed
+ *
+ * @warning This is invoked from within `ISR(TWI_vect)`, so it should be kept
+ * as short as possible.
+ *
+ * @see i2c_master_transfer_t::callback
+ */
+typedef void (*i2c_master_transfer_callback_t)(i2c_master_transfer_t* transfer);
+
+/**
+ * @brief Descriptor of a transfer executed by the transaction engine
+ *
+ * Each transfer first writes the register address to the device. For write
+ * transfers the data is written right afterwards. For read transfers a
+ * repeated start condition is generated and the data is read back.
+ *
+ * @note The descriptor along with its data buffer needs to remain valid
+ * until the transfer has been completed.
+ *
+ * @see i2c_master_submit()
+ */
+struct i2c_master_transfer {
+
+    /**
+     * @brief Address of the device (without the R/W bit)
+     */
+    uint8_t address;
+
+    /**
+     * @brief Register address within the device to start at
+     */
+    uint8_t reg;
+
+    /**
+     * @brief Indicates whether data should be read (true) or written (false)
+     */
+    bool read;
+
+    /**
+     * @brief Buffer holding the data to write and/or receiving the data read
+     */
+    uint8_t* data;
+
+    /**
+     * @brief Number of bytes to transfer
+     *
+     * This needs to be at least 1 for read transfers.
+     */
+    uint8_t length;
+
+    /**
+     * @brief Function to invoke once the transfer has been completed
+     *
+     * This can be set to NULL if no callback is needed.
+     */
+    i2c_master_transfer_callback_t callback;
+
+    /**
+     * @brief Current state of this transfer
+     */
+    volatile i2c_master_transfer_state_t state;
+
+    /**
+     * @brief Status of the I2C hardware unit in case of a failure
+     *
+     * This is set to `TW_NO_INFO` if the transfer has timed out.
+     */
+    uint8_t status;
+
+    /**
+     * @brief Next transfer within the queue, used internally
+     */
+    i2c_master_transfer_t* next;
+
+};
+
 extern bool i2c_master_init(i2c_master_error_t* error);
 
+extern bool i2c_master_submit(i2c_master_transfer_t* transfer);
+
+extern bool i2c_master_wait(i2c_master_transfer_t* transfer);
+
+extern void i2c_master_handle();
+
 extern bool i2c_master_start(uint8_t address, uint8_t* status);
 
 extern void i2c_master_start_wait(uint8_t address);
@@ -26,7 +26,16 @@
  * [I2C][2] bus. This module implements functions, which can then be used to
  * access the DS1307.
  *
- * Internally it makes use of `i2c_master.h` quite heavily.
+ * Internally it makes use of `i2c_master.h` quite heavily. All accesses are
+ * performed by the transaction engine of `i2c_master.h`, so a missing and/or
+ * unresponsive RTC cannot stall the main loop. Reading and writing the date
+ * and time are non-blocking, see i2c_rtc_read_start() and i2c_rtc_write().
+ *
+ * In order to keep the traffic on the bus to a minimum, reads usually only
+ * transfer the seconds and minutes (see I2C_RTC_MINIMAL_READS). The general
+ * purpose SRAM of the RTC can be accessed by means of a write-through cache
+ * (see I2C_RTC_SRAM_CACHE), so modules can cheaply keep volatile data there
+ * instead of wearing out the EEPROM.
  *
  * Refer to [3] for any details about the DS1307 itself.
  *
@@ -38,6 +47,8 @@
  * @see i2c_master.h
  */
 
+#include <stddef.h>
+#include <string.h>
 #include <util/twi.h>
 
 #include "base.h"
@@ -81,6 +92,19 @@ static bool i2c_rtc_initialized = false;
  */
 static uint8_t i2c_rtc_status;
 
+/**
+ * @brief Indicates whether the clock of the RTC was halted during
+ * initialization
+ *
+ * The CH bit is set by the DS1307 itself when power has been applied without
+ * a backup battery being present. In this case the date and time kept by the
+ * RTC are meaningless.
+ *
+ * @see i2c_rtc_init()
+ * @see i2c_rtc_was_halted()
+ */
+static bool i2c_rtc_halted = false;
+
 /**
  * @brief DS1307 Output control
  *
@@ -133,21 +157,41 @@ static uint8_t i2c_rtc_status;
  *  X    X    1               0     1
  * \endcode
  *
+ * A square wave of 1 Hz is put out when the software clock is driven by it
+ * (DATETIME_USE_RTC_SQW).
+ *
  * @see CTRL_REG_RS0
  * @see CTRL_REG
+ * @see DATETIME_USE_RTC_SQW
  */
-#define CTRL_REG_RS1 1
+#if (DATETIME_USE_RTC_SQW == 1)
+
+    #define CTRL_REG_RS1 0
+
+#else
+
+    #define CTRL_REG_RS1 1
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
 
 /**
  * @brief DS1307 Rate Select (RS0)
  *
  * Refer to `CTRL_REG_RS0` for details about the meaning of this bit.
  *
- * @see CTRL_REG_RS0
+ * @see CTRL_REG_RS1
  * @see CTRL_REG
  *
  */
-#define CTRL_REG_RS0 1
+#if (DATETIME_USE_RTC_SQW == 1)
+
+    #define CTRL_REG_RS0 0
+
+#else
+
+    #define CTRL_REG_RS0 1
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
 
 /**
  * @brief Holds the actual value for the control register
@@ -162,7 +206,7 @@ static uint8_t i2c_rtc_status;
  * @see i2c_rtc_init()
  */
 #define CTRL_REG \
-    (CTRL_REG_RS0 | CTRL_REG_RS0 << 1 | CTRL_REG_SQWE << 4 | CTRL_REG_OUT << 7)
+    (CTRL_REG_RS0 | CTRL_REG_RS1 << 1 | CTRL_REG_SQWE << 4 | CTRL_REG_OUT << 7)
 
 /**
  * @brief Returns the status of the last operation on the I2C bus
@@ -179,6 +223,124 @@ uint8_t i2c_rtc_get_status()
 
 }
 
+/**
+ * @brief Returns whether the clock of the RTC was halted during initialization
+ *
+ * If this returns true, the date and time read from the RTC are not valid
+ * until they have been set once again.
+ *
+ * @return True if the clock was halted, false otherwise
+ *
+ * @see i2c_rtc_halted
+ */
+bool i2c_rtc_was_halted()
+{
+
+    return i2c_rtc_halted;
+
+}
+
+/**
+ * @brief Buffer holding the registers of the last read of the date and time
+ *
+ * @see i2c_rtc_read_transfer
+ */
+static uint8_t i2c_rtc_read_buffer[7];
+
+/**
+ * @brief Transfer used to read the date and time from the RTC
+ *
+ * @see i2c_rtc_read_start()
+ * @see i2c_rtc_read_get()
+ */
+static i2c_master_transfer_t i2c_rtc_read_transfer = {
+
+    .address = I2C_RTC_DEV_ADDR,
+    .reg = 0x00,
+    .read = true,
+    .data = i2c_rtc_read_buffer,
+    .length = sizeof(i2c_rtc_read_buffer),
+
+};
+
+/**
+ * @brief Buffer holding the registers to be written to the RTC
+ *
+ * @see i2c_rtc_write_transfer
+ */
+static uint8_t i2c_rtc_write_buffer[7];
+
+/**
+ * @brief Transfer used to write the date and time to the RTC
+ *
+ * @see i2c_rtc_write()
+ */
+static i2c_master_transfer_t i2c_rtc_write_transfer = {
+
+    .address = I2C_RTC_DEV_ADDR,
+    .reg = 0x00,
+    .read = false,
+    .data = i2c_rtc_write_buffer,
+    .length = sizeof(i2c_rtc_write_buffer),
+
+};
+
+#if (I2C_RTC_MINIMAL_READS == 1)
+
+    /**
+     * @brief Number of registers transferred by a minimal read
+     *
+     * Only the seconds and minutes registers are read.
+     *
+     * @see I2C_RTC_MINIMAL_READS
+     */
+    #define I2C_RTC_MINIMAL_READ_LENGTH 2
+
+    /**
+     * @brief Date and time of the last read
+     *
+     * The date and hour contained herein are only updated by full reads,
+     * while minimal reads only update the seconds and minutes.
+     *
+     * @see i2c_rtc_cache_valid
+     * @see i2c_rtc_read_get()
+     */
+    static datetime_t i2c_rtc_cache;
+
+    /**
+     * @brief Indicates whether the date and hour of i2c_rtc_cache can be used
+     *
+     * As long as this is false, reads are full reads.
+     *
+     * @see i2c_rtc_read_start()
+     */
+    static bool i2c_rtc_cache_valid = false;
+
+    /**
+     * @brief Indicates whether the pending read has been overtaken by a write
+     *
+     * Such a read returns the date and time from before the write, so its
+     * result must not end up in the cache.
+     *
+     * @see i2c_rtc_write()
+     * @see i2c_rtc_read_get()
+     */
+    static bool i2c_rtc_cache_stale = false;
+
+#endif /* (I2C_RTC_MINIMAL_READS == 1) */
+
+/**
+ * @brief Transfer used to access the SRAM of the RTC
+ *
+ * @see i2c_rtc_sram_write()
+ * @see i2c_rtc_sram_read()
+ */
+static i2c_master_transfer_t i2c_rtc_sram_transfer = {
+
+    .address = I2C_RTC_DEV_ADDR,
+
+};
+
 /**
  * @brief Writes the given datetime to the RTC
  *
@@ -186,11 +348,15 @@ uint8_t i2c_rtc_get_status()
  * internally the values need to be converted before they are actually written
  * to the appropriate registers.
  *
+ * The write is only queued and performed in the background, so this returns
+ * right away. Its result can be retrieved by i2c_rtc_write_get_state().
+ * Reads queued afterwards will already return the new date and time.
+ *
  * @param datetime Pointer to memory holding the datetime to be written to RTC
  *
- * @return Result of the operation, true if successful, false otherwise
+ * @return True if the write has been queued, false otherwise
  *
- * @see i2c_rtc_sram_write()
+ * @see i2c_master_submit()
  * @see itobcd()
  * @see datetime_t
  */
@@ -203,126 +369,310 @@ bool i2c_rtc_write(const datetime_t* datetime)
 
     }
 
-    uint8_t rtcbuf[7];
+    if (i2c_rtc_write_transfer.state == I2C_MASTER_TRANSFER_QUEUED
+            || i2c_rtc_write_transfer.state == I2C_MASTER_TRANSFER_BUSY) {
 
-    rtcbuf[0] = itobcd(datetime->ss);
-    rtcbuf[1] = itobcd(datetime->mm);
-    rtcbuf[2] = itobcd(datetime->hh);
-    rtcbuf[3] = itobcd(datetime->WD);
-    rtcbuf[4] = itobcd(datetime->DD);
-    rtcbuf[5] = itobcd(datetime->MM);
-    rtcbuf[6] = itobcd(datetime->YY);
+        return false;
 
-    if (i2c_rtc_sram_write(0x00, rtcbuf, 7)) {
+    }
 
-        return true;
+    i2c_rtc_write_buffer[0] = itobcd(datetime->ss);
+    i2c_rtc_write_buffer[1] = itobcd(datetime->mm);
+    i2c_rtc_write_buffer[2] = itobcd(datetime->hh);
+    i2c_rtc_write_buffer[3] = itobcd(datetime->WD);
+    i2c_rtc_write_buffer[4] = itobcd(datetime->DD);
+    i2c_rtc_write_buffer[5] = itobcd(datetime->MM);
+    i2c_rtc_write_buffer[6] = itobcd(datetime->YY);
+
+    #if (I2C_RTC_MINIMAL_READS == 1)
+
+        i2c_rtc_cache_valid = false;
+        i2c_rtc_cache_stale = i2c_rtc_read_transfer.state != I2C_MASTER_TRANSFER_IDLE;
+
+    #endif /* (I2C_RTC_MINIMAL_READS == 1) */
+
+    return i2c_master_submit(&i2c_rtc_write_transfer);
+
+}
+
+/**
+ * @brief Returns the state of the last write issued by i2c_rtc_write()
+ *
+ * @return State of the write
+ *
+ * @see i2c_rtc_write()
+ */
+i2c_master_transfer_state_t i2c_rtc_write_get_state()
+{
+
+    return i2c_rtc_write_transfer.state;
+
+}
+
+/**
+ * @brief Starts to read the datetime from the RTC
+ *
+ * The read is only queued and performed in the background, so this returns
+ * right away. The result needs to be retrieved by i2c_rtc_read_get().
+ *
+ * If the date and hour of the last read are still known to be valid, only
+ * the seconds and minutes are read.
+ *
+ * @return True if the read has been queued, false otherwise
+ *
+ * @see i2c_rtc_read_get()
+ * @see i2c_master_submit()
+ * @see I2C_RTC_MINIMAL_READS
+ */
+bool i2c_rtc_read_start()
+{
+
+    if (!i2c_rtc_initialized) {
+
+        return false;
 
     }
 
-    return false;
+    #if (I2C_RTC_MINIMAL_READS == 1)
+
+        if (i2c_rtc_read_transfer.state != I2C_MASTER_TRANSFER_QUEUED
+                && i2c_rtc_read_transfer.state != I2C_MASTER_TRANSFER_BUSY) {
+
+            i2c_rtc_read_transfer.length = i2c_rtc_cache_valid
+                ? I2C_RTC_MINIMAL_READ_LENGTH : sizeof(i2c_rtc_read_buffer);
+
+        }
+
+    #endif /* (I2C_RTC_MINIMAL_READS == 1) */
+
+    return i2c_master_submit(&i2c_rtc_read_transfer);
 
 }
 
 /**
- * @brief Reads the datetime from the RTC
+ * @brief Retrieves the result of a read started by i2c_rtc_read_start()
  *
- * This reads the current date and time from the RTC and puts it into the given
- * buffer. As the RTC works with BCD internally the values need to converted to
- * its appropriate binary representation before they are written to the buffer.
+ * Once the read has been completed successfully, the date and time are
+ * converted from BCD and put into the given buffer. Afterwards the state is
+ * reset to `I2C_MASTER_TRANSFER_IDLE`, so each result is only returned once.
+ * In case of a failure the status can be retrieved by i2c_rtc_get_status().
+ *
+ * If a minimal read reveals that the minutes have rolled over, a full read is
+ * started right away and its state is returned instead, i.e. the caller needs
+ * to retry later on.
  *
  * @param datetime Pointer to buffer in memory for storing the read datetime
  *
- * @return Result of the operation, true if successful, false otherwise
+ * @return State of the read
  *
+ * @see i2c_rtc_read_start()
  * @see bcdtoi()
- * @see i2c_rtc_sram_read()
  * @see datetime_t
  */
-bool i2c_rtc_read(datetime_t* datetime)
+i2c_master_transfer_state_t i2c_rtc_read_get(datetime_t* datetime)
 {
 
-    uint8_t rtcbuf[7];
-    bool rtc = false;
+    i2c_master_transfer_state_t state = i2c_rtc_read_transfer.state;
 
-    if (i2c_rtc_initialized) {
+    if (state == I2C_MASTER_TRANSFER_DONE) {
 
-        if (i2c_rtc_sram_read(0x00, rtcbuf, 7)) {
+        #if (I2C_RTC_MINIMAL_READS == 1)
 
-            datetime->YY = bcdtoi(rtcbuf[6]);
-            datetime->MM = bcdtoi(rtcbuf[5]);
-            datetime->DD = bcdtoi(rtcbuf[4]);
-            datetime->WD = bcdtoi(rtcbuf[3]);
-            datetime->hh = bcdtoi(rtcbuf[2]);
-            datetime->mm = bcdtoi(rtcbuf[1]);
-            datetime->ss = bcdtoi(rtcbuf[0]);
+            if (i2c_rtc_read_transfer.length == I2C_RTC_MINIMAL_READ_LENGTH) {
 
-            rtc = true;
+                uint8_t mm = bcdtoi(i2c_rtc_read_buffer[1]);
+                uint8_t ss = bcdtoi(i2c_rtc_read_buffer[0]);
 
-        }
+                /*
+                 * The minutes can only go backwards when the hour has changed,
+                 * in which case the date and hour need to be read again
+                 */
+                if (mm < i2c_rtc_cache.mm
+                        || (mm == i2c_rtc_cache.mm && ss < i2c_rtc_cache.ss)) {
+
+                    i2c_rtc_cache_valid = false;
+                    i2c_rtc_read_transfer.state = I2C_MASTER_TRANSFER_IDLE;
+                    i2c_rtc_read_start();
+
+                    return i2c_rtc_read_transfer.state;
+
+                }
+
+                i2c_rtc_cache.mm = mm;
+                i2c_rtc_cache.ss = ss;
+
+            } else {
+
+                i2c_rtc_cache.YY = bcdtoi(i2c_rtc_read_buffer[6]);
+                i2c_rtc_cache.MM = bcdtoi(i2c_rtc_read_buffer[5]);
+                i2c_rtc_cache.DD = bcdtoi(i2c_rtc_read_buffer[4]);
+                i2c_rtc_cache.WD = bcdtoi(i2c_rtc_read_buffer[3]);
+                i2c_rtc_cache.hh = bcdtoi(i2c_rtc_read_buffer[2]);
+                i2c_rtc_cache.mm = bcdtoi(i2c_rtc_read_buffer[1]);
+                i2c_rtc_cache.ss = bcdtoi(i2c_rtc_read_buffer[0]);
+                i2c_rtc_cache_valid = !i2c_rtc_cache_stale;
+
+            }
+
+            i2c_rtc_cache_stale = false;
+            *datetime = i2c_rtc_cache;
+
+        #else
+
+            datetime->YY = bcdtoi(i2c_rtc_read_buffer[6]);
+            datetime->MM = bcdtoi(i2c_rtc_read_buffer[5]);
+            datetime->DD = bcdtoi(i2c_rtc_read_buffer[4]);
+            datetime->WD = bcdtoi(i2c_rtc_read_buffer[3]);
+            datetime->hh = bcdtoi(i2c_rtc_read_buffer[2]);
+            datetime->mm = bcdtoi(i2c_rtc_read_buffer[1]);
+            datetime->ss = bcdtoi(i2c_rtc_read_buffer[0]);
+
+        #endif /* (I2C_RTC_MINIMAL_READS == 1) */
+
+    } else if (state == I2C_MASTER_TRANSFER_FAILED) {
+
+        i2c_rtc_status = i2c_rtc_read_transfer.status;
+
+        #if (I2C_RTC_MINIMAL_READS == 1)
+
+            i2c_rtc_cache_valid = false;
+            i2c_rtc_cache_stale = false;
+
+        #endif /* (I2C_RTC_MINIMAL_READS == 1) */
+
+    } else {
+
+        return state;
 
     }
 
-    return rtc;
+    i2c_rtc_read_transfer.state = I2C_MASTER_TRANSFER_IDLE;
+
+    return state;
 
 }
 
 /**
- * @brief Writes data to the SRAM of the RTC
+ * @brief Reads the datetime from the RTC
  *
- * This writes the data pointed to by `data` into the SRAM of the RTC. The
- * length of the data is specified by `length`. `address` specifies the
- * starting point within the SRAM of the RTC.
+ * This reads the current date and time from the RTC and puts it into the given
+ * buffer. As the RTC works with BCD internally the values need to converted to
+ * its appropriate binary representation before they are written to the buffer.
  *
- * The return value indicates whether the operation was performed successfully.
+ * In opposition to i2c_rtc_read_start() this waits for the read to be
+ * completed, including a full read that might be required after a minimal
+ * one.
  *
- * @note Only addresses ranging from 0x8 to 0x3f are meant to be used for
- * general purposes, as the lower 7 bytes contain the date and time itself.
+ * @param datetime Pointer to buffer in memory for storing the read datetime
+ *
+ * @return Result of the operation, true if successful, false otherwise
+ *
+ * @see i2c_rtc_read_start()
+ * @see i2c_rtc_read_get()
+ * @see i2c_master_wait()
+ */
+bool i2c_rtc_read(datetime_t* datetime)
+{
+
+    if (!i2c_rtc_read_start()) {
+
+        return false;
+
+    }
+
+    i2c_master_transfer_state_t state;
+
+    do {
+
+        i2c_master_wait(&i2c_rtc_read_transfer);
+        state = i2c_rtc_read_get(datetime);
+
+    } while (state == I2C_MASTER_TRANSFER_QUEUED
+            || state == I2C_MASTER_TRANSFER_BUSY);
+
+    return state == I2C_MASTER_TRANSFER_DONE;
+
+}
+
+/**
+ * @brief Performs a transfer on the SRAM of the RTC and waits for it
  *
  * @param address Starting location in SRAM of the RTC
- * @param data Pointer to buffer in memory containing the actual data
- * @param length Length of the data to be written
+ * @param data Pointer to buffer in memory containing and/or receiving the data
+ * @param length Length of the data
+ * @param read True for reading, false for writing
  *
  * @return Result of the operation, true if successful, false otherwise
  *
- * @see i2c_master_write()
+ * @see i2c_rtc_sram_transfer
+ * @see i2c_master_wait()
  */
-bool i2c_rtc_sram_write(uint8_t address, void* data, uint8_t length)
+static bool i2c_rtc_sram_transfer_wait(uint8_t address, void* data, uint8_t length, bool read)
 {
 
-    uint8_t* value = data;
-    bool rtc = false;
+    if (!i2c_rtc_initialized || !length || (address + length > 64)) {
 
-    if (i2c_rtc_initialized) {
+        return false;
 
-        if (length && (address + length <= 64)) {
+    }
 
-            i2c_master_start_wait(I2C_RTC_DEV_ADDR + TW_WRITE);
+    #if (I2C_RTC_MINIMAL_READS == 1)
 
-            if (i2c_master_write(address, &i2c_rtc_status)) {
+        if (!read && address < I2C_RTC_SRAM_START) {
 
-                rtc = true;
+            i2c_rtc_cache_valid = false;
 
-                while (length--) {
+        }
 
-                    if (!i2c_master_write(*value++, &i2c_rtc_status)) {
+    #endif /* (I2C_RTC_MINIMAL_READS == 1) */
 
-                        rtc = false;
+    i2c_rtc_sram_transfer.reg = address;
+    i2c_rtc_sram_transfer.read = read;
+    i2c_rtc_sram_transfer.data = data;
+    i2c_rtc_sram_transfer.length = length;
 
-                        break;
+    if (!i2c_master_submit(&i2c_rtc_sram_transfer)) {
 
-                    }
+        return false;
 
-                }
+    }
 
-            }
+    if (!i2c_master_wait(&i2c_rtc_sram_transfer)) {
 
-            i2c_master_stop();
+        i2c_rtc_status = i2c_rtc_sram_transfer.status;
 
-        }
+        return false;
 
     }
 
-    return rtc;
+    return true;
+
+}
+
+/**
+ * @brief Writes data to the SRAM of the RTC
+ *
+ * This writes the data pointed to by `data` into the SRAM of the RTC. The
+ * length of the data is specified by `length`. `address` specifies the
+ * starting point within the SRAM of the RTC.
+ *
+ * The return value indicates whether the operation was performed successfully.
+ *
+ * @note Only addresses ranging from 0x8 to 0x3f are meant to be used for
+ * general purposes, as the lower 7 bytes contain the date and time itself.
+ *
+ * @param address Starting location in SRAM of the RTC
+ * @param data Pointer to buffer in memory containing the actual data
+ * @param length Length of the data to be written
+ *
+ * @return Result of the operation, true if successful, false otherwise
+ *
+ * @see i2c_rtc_sram_transfer_wait()
+ */
+bool i2c_rtc_sram_write(uint8_t address, void* data, uint8_t length)
+{
+
+    return i2c_rtc_sram_transfer_wait(address, data, length, false);
 
 }
 
@@ -347,48 +697,223 @@ bool i2c_rtc_sram_write(uint8_t address, void* data, uint8_t length)
  *
  * @return Result of the operation, true if successful, false otherwise
  *
- * @see i2c_master_read_ack()
- * @see i2c_master_read_nak()
+ * @see i2c_rtc_sram_transfer_wait()
  */
 bool i2c_rtc_sram_read(uint8_t address, void* data, uint8_t length)
 {
 
-    uint8_t* value = data;
-    bool rtc = false;
+    return i2c_rtc_sram_transfer_wait(address, data, length, true);
+
+}
+
+#if (I2C_RTC_SRAM_CACHE == 1)
+
+    /**
+     * @brief Copy of the general purpose SRAM of the RTC
+     *
+     * @see i2c_rtc_sram_cache_valid
+     */
+    static uint8_t i2c_rtc_sram_cache[I2C_RTC_SRAM_SIZE];
+
+    /**
+     * @brief Indicates whether the SRAM could be read during initialization
+     *
+     * @see i2c_rtc_init()
+     */
+    static bool i2c_rtc_sram_cache_valid = false;
+
+    /**
+     * @brief Offset of the first byte within the cache not yet written back
+     *
+     * @see i2c_rtc_sram_cache_dirty_end
+     */
+    static uint8_t i2c_rtc_sram_cache_dirty_start = I2C_RTC_SRAM_SIZE;
+
+    /**
+     * @brief Offset behind the last byte within the cache not yet written back
+     *
+     * The cache is clean if this is not greater than
+     * i2c_rtc_sram_cache_dirty_start.
+     *
+     * @see i2c_rtc_sram_cache_dirty_start
+     */
+    static uint8_t i2c_rtc_sram_cache_dirty_end = 0;
+
+    /**
+     * @brief Transfer used to write the cache back to the SRAM of the RTC
+     *
+     * @see i2c_rtc_sram_cache_flush()
+     */
+    static i2c_master_transfer_t i2c_rtc_sram_cache_transfer = {
+
+        .address = I2C_RTC_DEV_ADDR,
+        .read = false,
+
+    };
+
+    /**
+     * @brief Marks the given range of the cache as not yet written back
+     *
+     * @param start Offset of the first byte within the cache
+     * @param end Offset behind the last byte within the cache
+     */
+    static void i2c_rtc_sram_cache_dirty(uint8_t start, uint8_t end)
+    {
+
+        if (start < i2c_rtc_sram_cache_dirty_start) {
+
+            i2c_rtc_sram_cache_dirty_start = start;
 
-    if (i2c_rtc_initialized) {
+        }
 
-        if (length && (address + length <= 64)) {
+        if (end > i2c_rtc_sram_cache_dirty_end) {
 
-            i2c_master_start_wait(I2C_RTC_DEV_ADDR + TW_WRITE);
+            i2c_rtc_sram_cache_dirty_end = end;
 
-            if (i2c_master_write(address, &i2c_rtc_status)) {
+        }
 
-                if (i2c_master_rep_start(I2C_RTC_DEV_ADDR + TW_READ, &i2c_rtc_status)) {
+    }
 
-                    rtc = true;
+    /**
+     * @brief Writes back the dirty range of the cache in the background
+     *
+     * Nothing is done while a previous write back is still in progress. If it
+     * has failed, its range is marked as dirty once again, but only retried
+     * with the next change of the cache, so a missing RTC does not keep the
+     * bus busy.
+     *
+     * @see i2c_rtc_sram_cache_transfer
+     * @see i2c_rtc_handle()
+     */
+    static void i2c_rtc_sram_cache_flush()
+    {
 
-                    while (--length) {
+        i2c_master_transfer_t* transfer = &i2c_rtc_sram_cache_transfer;
 
-                        *value++ = i2c_master_read_ack();
+        if (transfer->state == I2C_MASTER_TRANSFER_QUEUED
+                || transfer->state == I2C_MASTER_TRANSFER_BUSY) {
 
-                    }
+            return;
 
-                    *value++ = i2c_master_read_nak();
+        }
 
-                }
+        if (transfer->state == I2C_MASTER_TRANSFER_FAILED) {
 
-            }
+            uint8_t start = transfer->reg - I2C_RTC_SRAM_START;
 
-            i2c_master_stop();
+            i2c_rtc_status = transfer->status;
+            transfer->state = I2C_MASTER_TRANSFER_IDLE;
+            i2c_rtc_sram_cache_dirty(start, start + transfer->length);
 
         }
 
+        if (i2c_rtc_sram_cache_dirty_end <= i2c_rtc_sram_cache_dirty_start) {
+
+            return;
+
+        }
+
+        transfer->reg = I2C_RTC_SRAM_START + i2c_rtc_sram_cache_dirty_start;
+        transfer->data = &i2c_rtc_sram_cache[i2c_rtc_sram_cache_dirty_start];
+        transfer->length = i2c_rtc_sram_cache_dirty_end - i2c_rtc_sram_cache_dirty_start;
+
+        i2c_rtc_sram_cache_dirty_start = I2C_RTC_SRAM_SIZE;
+        i2c_rtc_sram_cache_dirty_end = 0;
+
+        i2c_master_submit(transfer);
+
     }
 
-    return rtc;
+    /**
+     * @brief Checks whether the given range is part of the cached SRAM
+     *
+     * @param address Starting location in SRAM of the RTC
+     * @param length Length of the data
+     *
+     * @return True if the range can be accessed via the cache
+     */
+    static bool i2c_rtc_sram_cache_contains(uint8_t address, uint8_t length)
+    {
+
+        return i2c_rtc_sram_cache_valid && length
+            && address >= I2C_RTC_SRAM_START
+            && address + length <= I2C_RTC_SRAM_START + I2C_RTC_SRAM_SIZE;
 
-}
+    }
+
+    /**
+     * @brief Reads data from the SRAM of the RTC by means of the cache
+     *
+     * This works just like i2c_rtc_sram_read(), but is served from the RAM
+     * and doesn't access the bus at all.
+     *
+     * @note Only the general purpose SRAM (I2C_RTC_SRAM_START onwards) is
+     * cached. Changes made by i2c_rtc_sram_write() are not visible here.
+     *
+     * @param address Starting location in SRAM of the RTC
+     * @param data Pointer to buffer in memory for holding the data
+     * @param length Length of the data to be read
+     *
+     * @return True if the data could be read, false otherwise
+     *
+     * @see i2c_rtc_sram_cache_set()
+     */
+    bool i2c_rtc_sram_cache_get(uint8_t address, void* data, uint8_t length)
+    {
+
+        if (!i2c_rtc_sram_cache_contains(address, length)) {
+
+            return false;
+
+        }
+
+        memcpy(data, &i2c_rtc_sram_cache[address - I2C_RTC_SRAM_START], length);
+
+        return true;
+
+    }
+
+    /**
+     * @brief Writes data to the SRAM of the RTC by means of the cache
+     *
+     * The cache is updated right away, while the data is written through to
+     * the RTC in the background. Bytes that haven't changed are not written
+     * at all, so this can be called as often as needed.
+     *
+     * @param address Starting location in SRAM of the RTC
+     * @param data Pointer to buffer in memory containing the actual data
+     * @param length Length of the data to be written
+     *
+     * @return True if the cache has been updated, false otherwise
+     *
+     * @see i2c_rtc_sram_cache_get()
+     * @see i2c_rtc_sram_cache_flush()
+     */
+    bool i2c_rtc_sram_cache_set(uint8_t address, const void* data, uint8_t length)
+    {
+
+        if (!i2c_rtc_sram_cache_contains(address, length)) {
+
+            return false;
+
+        }
+
+        uint8_t start = address - I2C_RTC_SRAM_START;
+
+        if (memcmp(&i2c_rtc_sram_cache[start], data, length) != 0) {
+
+            memcpy(&i2c_rtc_sram_cache[start], data, length);
+            i2c_rtc_sram_cache_dirty(start, start + length);
+
+        }
+
+        i2c_rtc_sram_cache_flush();
+
+        return true;
+
+    }
+
+#endif /* (I2C_RTC_SRAM_CACHE == 1) */
 
 /**
  * @brief Initializes this module along with the RTC itself
@@ -396,6 +921,8 @@ bool i2c_rtc_sram_read(uint8_t address, void* data, uint8_t length)
  * This initializes the module by writing the defined options into the control
  * register of the RTC. It makes also sure that the CH bit (bit 7 of register
  * 0) is set to 0, so the **clock** of the RTC is **not** being halted.
+ * Whether the clock was halted beforehand can be queried by
+ * `i2c_rtc_was_halted()`.
  *
  * If the initialization could be performed successfully, this function will
  * return true. Otherwise false will be returned and the appropriate error
@@ -429,6 +956,7 @@ bool i2c_rtc_init(i2c_master_error_t* error)
 
                 if (seconds & _BV(7)) {
 
+                    i2c_rtc_halted = true;
                     seconds &= ~_BV(7);
                     i2c_rtc_sram_write(0x00, &seconds, 1);
 
@@ -436,6 +964,13 @@ bool i2c_rtc_init(i2c_master_error_t* error)
 
             }
 
+            #if (I2C_RTC_SRAM_CACHE == 1)
+
+                i2c_rtc_sram_cache_valid = i2c_rtc_sram_read(I2C_RTC_SRAM_START,
+                    i2c_rtc_sram_cache, I2C_RTC_SRAM_SIZE);
+
+            #endif /* (I2C_RTC_SRAM_CACHE == 1) */
+
             return true;
 
 
@@ -450,3 +985,27 @@ bool i2c_rtc_init(i2c_master_error_t* error)
     return false;
 
 }
+
+/**
+ * @brief Handles background tasks of this module
+ *
+ * This writes back changes to the SRAM cache that have been made while a
+ * previous write back was still in progress. It is expected to be called
+ * regularly from within the main loop.
+ *
+ * @see i2c_rtc_sram_cache_flush()
+ */
+void i2c_rtc_handle()
+{
+
+    #if (I2C_RTC_SRAM_CACHE == 1)
+
+        if (i2c_rtc_sram_cache_transfer.state != I2C_MASTER_TRANSFER_FAILED) {
+
+            i2c_rtc_sram_cache_flush();
+
+        }
+
+    #endif /* (I2C_RTC_SRAM_CACHE == 1) */
+
+}
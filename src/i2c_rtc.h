@@ -38,16 +38,79 @@
 #include "datetime.h"
 #include "i2c_master.h"
 
+/**
+ * @brief Controls whether only the seconds and minutes are read if possible
+ *
+ * If enabled, the date and time of the last full read are cached and
+ * subsequent reads only transfer the seconds and minutes registers. A full
+ * read is only performed once the minutes roll over into the next hour, after
+ * the date and time have been written and/or after a failed read.
+ *
+ * @note This assumes that the RTC is read at least once per hour, which the
+ * {@link datetime.h datetime} module does anyway.
+ *
+ * @see i2c_rtc_read_start()
+ * @see i2c_rtc_read_get()
+ */
+#define I2C_RTC_MINIMAL_READS 1
+
+/**
+ * @brief Controls whether the SRAM of the RTC is cached within the RAM
+ *
+ * If enabled, the general purpose SRAM of the RTC is read once during the
+ * initialization and kept within the RAM afterwards. Reads are then served
+ * from the cache directly, while writes are passed through to the RTC in the
+ * background.
+ *
+ * @see i2c_rtc_sram_cache_get()
+ * @see i2c_rtc_sram_cache_set()
+ */
+#define I2C_RTC_SRAM_CACHE 1
+
+/**
+ * @brief First address of the general purpose SRAM of the RTC
+ *
+ * The addresses below contain the date and time and the control register.
+ *
+ * @see I2C_RTC_SRAM_SIZE
+ */
+#define I2C_RTC_SRAM_START 0x08
+
+/**
+ * @brief Size of the general purpose SRAM of the RTC (in bytes)
+ *
+ * @see I2C_RTC_SRAM_START
+ */
+#define I2C_RTC_SRAM_SIZE 56
+
 extern uint8_t i2c_rtc_get_status();
 
+extern bool i2c_rtc_was_halted();
+
 extern bool i2c_rtc_write(const datetime_t* datetime);
 
+extern i2c_master_transfer_state_t i2c_rtc_write_get_state();
+
+extern bool i2c_rtc_read_start();
+
+extern i2c_master_transfer_state_t i2c_rtc_read_get(datetime_t* datetime);
+
 extern bool i2c_rtc_read(datetime_t* datetime);
 
 extern bool i2c_rtc_sram_write(uint8_t address, void* data, uint8_t length);
 
 extern bool i2c_rtc_sram_read(uint8_t address, void* data, uint8_t length);
 
+#if (I2C_RTC_SRAM_CACHE == 1)
+
+    extern bool i2c_rtc_sram_cache_get(uint8_t address, void* data, uint8_t length);
+
+    extern bool i2c_rtc_sram_cache_set(uint8_t address, const void* data, uint8_t length);
+
+#endif /* (I2C_RTC_SRAM_CACHE == 1) */
+
 extern bool i2c_rtc_init(i2c_master_error_t* error);
 
+extern void i2c_rtc_handle();
+
 #endif /* _WC_I2C_RTC_H_ */
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ir.c
+ * @brief Implementation of the header declared in ir.h
+ *
+ * Each edge on the IR input is stored within ir_edges along with the level
+ * entered. ir_handle() then calls irmp_ISR() once for every 100 us the
+ * previous level has lasted, with irmp_external_input set accordingly. To
+ * IRMP this looks exactly the same as sampling the input in real time, only
+ * delayed by the latency of the main loop.
+ *
+ * The level currently in progress is replayed up to the current point in
+ * time on every invocation of ir_handle(), which is done ten times a second
+ * via `EVENT_TIMER`. This way IRMP gets to see the timeout at the end of a
+ * frame, although no further edge occurs.
+ *
+ * @see ir.h
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "ir.h"
+#include "dcf77.h"
+#include "event.h"
+#include "timer.h"
+
+#if (IR_USE_EDGE_CAPTURE == 1)
+
+#if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+    #error "IR_USE_EDGE_CAPTURE can't be used along with DCF77_USE_EDGE_TIMESTAMPS"
+
+#endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+/**
+ * @brief Pin change mask register of the IR input
+ *
+ * @note This needs to match the port defined by IRMP_PORT_LETTER, see
+ * irmpconfig.h. The bit within the register is the same as IRMP_BIT.
+ */
+#define IR_INPUT_PCMSK PCMSK0
+
+/**
+ * @brief Pin change interrupt enable bit of the IR input
+ *
+ * @see IR_INPUT_PCMSK
+ */
+#define IR_INPUT_PCIE PCIE0
+
+/**
+ * @brief Pin change interrupt vector of the IR input
+ *
+ * @see IR_INPUT_PCMSK
+ */
+#define IR_INPUT_PCINT_vect PCINT0_vect
+
+/**
+ * @brief Mask of the timestamps stored within ir_edges
+ *
+ * The least significant bit of each entry is occupied by the level, so only
+ * 15 bits of the timestamp are left, which wraps around after roughly three
+ * seconds. This is sufficient, as no level is replayed for longer than
+ * IR_MAX_LEVEL_TICKS anyway.
+ *
+ * @see ir_edges
+ */
+#define IR_TIME_MASK 0x7fff
+
+#if ((IR_EDGE_BUFFER_SIZE & (IR_EDGE_BUFFER_SIZE - 1)) != 0)
+
+    #error "IR_EDGE_BUFFER_SIZE needs to be a power of two"
+
+#endif
+
+#if (IR_MAX_LEVEL_TICKS > (IR_TIME_MASK / 2))
+
+    #error "IR_MAX_LEVEL_TICKS is too big"
+
+#endif
+
+/**
+ * @brief Edges recorded by `ISR(IR_INPUT_PCINT_vect)`
+ *
+ * Each entry contains the timestamp of the edge (see timer_get_100us())
+ * shifted to the left by one, with the level entered stored within the
+ * least significant bit.
+ *
+ * @see ir_edges_head
+ * @see ir_edges_tail
+ */
+static volatile uint16_t ir_edges[IR_EDGE_BUFFER_SIZE];
+
+/**
+ * @brief Index of the next entry to be written by the ISR
+ *
+ * @see ir_edges
+ */
+static volatile uint8_t ir_edges_head;
+
+/**
+ * @brief Index of the next entry to be replayed by ir_handle()
+ *
+ * @see ir_edges
+ */
+static volatile uint8_t ir_edges_tail;
+
+/**
+ * @brief Level of the input as seen by the ISR
+ *
+ * This is used to ignore changes of other pins sharing the same pin change
+ * interrupt.
+ *
+ * @see ISR(IR_INPUT_PCINT_vect)
+ */
+static uint8_t ir_input_level = 1;
+
+/**
+ * @brief Level currently being replayed into IRMP
+ *
+ * @see ir_replay()
+ */
+static uint8_t ir_level = 1;
+
+/**
+ * @brief Timestamp of the beginning of the level currently being replayed
+ *
+ * @see ir_replay()
+ */
+static uint16_t ir_level_start;
+
+/**
+ * @brief Number of ticks of the current level already replayed into IRMP
+ *
+ * @see ir_replay()
+ */
+static uint16_t ir_level_replayed;
+
+/**
+ * @brief Replays the current level into IRMP up to the given point in time
+ *
+ * This calls irmp_ISR() for every 100 us that have passed since the beginning
+ * of the current level and that haven't been replayed yet. Levels are
+ * truncated to IR_MAX_LEVEL_TICKS.
+ *
+ * The replay is stopped as soon as IRMP has detected a frame, as it ignores
+ * its input until the frame has been retrieved by irmp_get_data().
+ *
+ * @param until Timestamp up to which the level should be replayed
+ *
+ * @return True if a frame has been detected, false otherwise
+ *
+ * @see ir_level
+ * @see ir_level_start
+ * @see ir_level_replayed
+ */
+static bool ir_replay(uint16_t until)
+{
+
+    uint16_t length = (until - ir_level_start) & IR_TIME_MASK;
+
+    if (length > IR_MAX_LEVEL_TICKS) {
+
+        length = IR_MAX_LEVEL_TICKS;
+
+    }
+
+    irmp_external_input = ir_level;
+
+    while (ir_level_replayed < length) {
+
+        ir_level_replayed++;
+
+        if (irmp_ISR()) {
+
+            return true;
+
+        }
+
+    }
+
+    return false;
+
+}
+
+/**
+ * @brief Initializes the edge capturing of the IR input
+ *
+ * This enables the pin change interrupt of the IR input. irmp_init() needs to
+ * be called beforehand in order to configure the pin itself.
+ *
+ * @see ISR(IR_INPUT_PCINT_vect)
+ */
+void ir_init()
+{
+
+    ir_input_level = input(IRMP_PIN) ? 1 : 0;
+    ir_level = ir_input_level;
+    ir_level_start = timer_get_100us();
+
+    IR_INPUT_PCMSK |= _BV(IRMP_BIT);
+    PCICR |= _BV(IR_INPUT_PCIE);
+
+}
+
+/**
+ * @brief Replays the recorded edges into IRMP
+ *
+ * All of the edges recorded so far are replayed one after another, followed
+ * by the level currently in progress up to now. Once a frame has been
+ * detected, `EVENT_IR` is posted and this returns early, so the frame can be
+ * retrieved before the remaining edges are replayed.
+ *
+ * This needs to be called whenever `EVENT_IR` has been posted, and on a
+ * regular basis, see `EVENT_TIMER`.
+ *
+ * @see ir_replay()
+ * @see handle_ir_code()
+ */
+void ir_handle()
+{
+
+    while (true) {
+
+        uint8_t sreg = SREG;
+        cli();
+
+        if (ir_edges_tail == ir_edges_head) {
+
+            /*
+             * Interrupts are still disabled, so no edge can occur before now
+             */
+            uint16_t now = timer_get_100us();
+            SREG = sreg;
+
+            if (ir_replay(now)) {
+
+                event_post(EVENT_IR);
+
+            }
+
+            return;
+
+        }
+
+        uint16_t edge = ir_edges[ir_edges_tail];
+        SREG = sreg;
+
+        if (ir_replay(edge >> 1)) {
+
+            event_post(EVENT_IR);
+
+            return;
+
+        }
+
+        ir_level = edge & 1;
+        ir_level_start = edge >> 1;
+        ir_level_replayed = 0;
+
+        ir_edges_tail = (ir_edges_tail + 1) & (IR_EDGE_BUFFER_SIZE - 1);
+
+    }
+
+}
+
+/**
+ * @brief Pin change handler of the IR input (ISR)
+ *
+ * This timestamps each edge on the IR input by means of timer_get_100us()
+ * and puts it into ir_edges. When the buffer is full, the edge is dropped.
+ * As the level is stored along with each edge, this only distorts the
+ * current frame.
+ *
+ * @see ir_edges
+ * @see ir_handle()
+ */
+ISR(IR_INPUT_PCINT_vect)
+{
+
+    uint8_t level = input(IRMP_PIN) ? 1 : 0;
+
+    /*
+     * Ignore changes of other pins sharing this interrupt
+     */
+    if (level == ir_input_level) {
+
+        return;
+
+    }
+
+    ir_input_level = level;
+
+    uint8_t next = (ir_edges_head + 1) & (IR_EDGE_BUFFER_SIZE - 1);
+
+    if (next != ir_edges_tail) {
+
+        ir_edges[ir_edges_head] = (timer_get_100us() << 1) | level;
+        ir_edges_head = next;
+
+    }
+
+    event_post(EVENT_IR);
+
+}
+
+#endif /* (IR_USE_EDGE_CAPTURE == 1) */
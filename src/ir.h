@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ir.h
+ * @brief Header for receiving IR frames by timestamping edges
+ *
+ * By default the IR input is sampled by irmp_ISR() 10000 times a second from
+ * within `ISR(TIMER1_CAPT_vect)`. When IR_USE_EDGE_CAPTURE is enabled, the
+ * pin change interrupt of the input is used instead: Each edge is
+ * timestamped with a resolution of 100 us (timer_get_100us()) and put into a
+ * small buffer. ir_handle() then replays the recorded levels into IRMP from
+ * within the main loop, so the timer only needs to run at 1 kHz.
+ *
+ * @see ir.c
+ * @see timer_get_100us()
+ */
+
+#ifndef _WC_IR_H_
+#define _WC_IR_H_
+
+#include <stdint.h>
+
+#include "config.h"
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+    #include "IRMP/irmp.h"
+
+    /**
+     * @brief Defines whether IR frames are received by timestamping edges
+     *
+     * This is controlled by IRMP_USE_EXTERNAL_INPUT (see irmpconfig.h), as
+     * IRMP itself needs to be built differently in this case.
+     *
+     * @warning The pin change interrupt is shared with the DCF77 input, so
+     * this can't be enabled together with DCF77_USE_EDGE_TIMESTAMPS.
+     *
+     * @see IRMP_USE_EXTERNAL_INPUT
+     * @see ir_handle()
+     */
+    #define IR_USE_EDGE_CAPTURE IRMP_USE_EXTERNAL_INPUT
+
+#else
+
+    /**
+     * @brief Edges are never captured without support for the IR remote
+     *
+     * @see ENABLE_IR_SUPPORT
+     */
+    #define IR_USE_EDGE_CAPTURE 0
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
+
+/**
+ * @brief Number of edges that can be buffered until ir_handle() is invoked
+ *
+ * A single NEC frame consists of 68 edges, however the buffer is emptied
+ * by ir_handle() right after each edge in general, so it only needs to cover
+ * the latency of the main loop.
+ *
+ * @note This needs to be a power of two.
+ */
+#define IR_EDGE_BUFFER_SIZE 32
+
+/**
+ * @brief Maximum amount of ticks a single level is replayed for
+ *
+ * Levels lasting longer are truncated. This needs to be longer than any of
+ * the timeouts within IRMP (the longest one being IRMP_KEY_REPETITION_LEN
+ * with 150 ms), so IRMP can't tell the difference. It also bounds the time
+ * spent within ir_handle() after the last edge of a frame.
+ */
+#define IR_MAX_LEVEL_TICKS 2000
+
+#if (IR_USE_EDGE_CAPTURE == 1)
+
+    extern void ir_init();
+
+    extern void ir_handle();
+
+#else
+
+    /**
+     * @brief Empty macro in case edge capturing is disabled
+     *
+     * @see IR_USE_EDGE_CAPTURE
+     */
+    #define ir_init()
+
+    /**
+     * @brief Empty macro in case edge capturing is disabled
+     *
+     * @see IR_USE_EDGE_CAPTURE
+     */
+    #define ir_handle()
+
+#endif /* (IR_USE_EDGE_CAPTURE == 1) */
+
+#endif /* _WC_IR_H_ */
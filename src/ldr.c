@@ -41,45 +41,63 @@
 #include <util/delay.h>
 #include <avr/pgmspace.h>
 #include <avr/interrupt.h>
-#include <stdio.h>
+#include <avr/sleep.h>
 
 #include "config.h"
-#include "format.h"
-#include "uart.h"
+#include "event.h"
 #include "ldr.h"
+#include "log.h"
+#include "memcheck.h"
+#include "prng.h"
+#include "profile.h"
 
 /**
- * @brief Stores the last measurements taken
+ * @brief Number of conversions still to be performed for the current
+ * measurement
  *
- * This effectively acts as a low pass filter, as the brightness calculated by
- * `ldr_get_brightness()` will be the mean value of the values stored in this
- * array.
+ * A value of zero means that there is no measurement in progress.
  *
- * This array is actually organized as a [ring buffer][1].
- *
- * [1]: https://en.wikipedia.org/wiki/Circular_buffer
+ * @see LDR_OVERSAMPLING
+ * @see ldr_start_measurement()
+ * @see ISR(ADC_vect)
+ */
+static volatile uint8_t ldr_conversions;
+
+/**
+ * @brief Sum of the conversions of the current measurement
  *
- * @see MEASUREMENTS_ARRAY_SIZE
- * @see ldr_get_brightness()
- * @see ldr_ISR()
+ * @see ISR(ADC_vect)
  */
-static volatile uint8_t measurements[MEASUREMENTS_ARRAY_SIZE];
+static uint16_t ldr_sum;
 
 /**
- * @brief Contains the sum of all elements in the measurements array
+ * @brief Filtered value of the measurements
  *
- * Although this is redundant and could be calculated by simply adding up the
- * values in measurements itself, it speeds things up when it comes down to
- * actually returning the "current" brightness with `ldr_get_brightness()`.
+ * This is a fixed point number with 8 fractional bits, which keeps the
+ * exponential moving average precise even for small weights.
  *
- * @note: Consider that the datatype must be able to store values at least as
- * big as MEASUREMENTS_ARRAY_SIZE * 255.
+ * @see ldr_filter()
+ */
+static uint16_t ldr_filtered;
+
+/**
+ * @brief The value returned by `ldr_get_brightness()` (before inversion)
+ *
+ * This only follows `ldr_filtered` once it differs by more than
+ * `LDR_HYSTERESIS`.
  *
- * @see measurements
+ * @see ldr_filter()
  * @see ldr_get_brightness()
+ */
+static volatile uint8_t ldr_value;
+
+/**
+ * @brief Number of measurements still to be taken at the fast rate
+ *
+ * @see LDR_FAST_MEASUREMENTS
  * @see ldr_ISR()
  */
-static volatile uint16_t curr_sum;
+static uint8_t ldr_fast;
 
 /**
  * @brief Initializes this module
@@ -91,10 +109,14 @@ static volatile uint16_t curr_sum;
  * the internal state, it activates the ADC interrupt, which will handle the
  * measurements from then on.
  *
+ * Some more conversions are taken to seed the PRNG, see
+ * LDR_ENTROPY_SAMPLES.
+ *
  * If the logging for this module is activated (`LOG_LDR`), it will also
- * output the value of the first measurement.
+ * log the value of the first measurement.
  *
- * @see curr_sum
+ * @see ldr_filtered
+ * @see prng_add_entropy()
  * @see LOG_LDR
  * @see ISR(ADC_vect)
  */
@@ -125,23 +147,26 @@ void ldr_init()
 
     result = ADCH;
 
-    for (uint8_t i = 0; i < MEASUREMENTS_ARRAY_SIZE; i++) {
+    ldr_filtered = (uint16_t)result << 8;
+    ldr_value = result;
 
-        measurements[i] = result;
+    /*
+     * Feed the least significant bits of some more conversions into the
+     * PRNG, as they are mostly noise
+     */
+    for (uint8_t i = 0; i < LDR_ENTROPY_SAMPLES; i++) {
 
-    }
+        ADCSRA |= _BV(ADSC);
 
-    curr_sum = result;
-    curr_sum *= MEASUREMENTS_ARRAY_SIZE;
+        while (ADCSRA & _BV(ADSC));
 
-    #if (LOG_LDR == 1)
+        prng_add_entropy(ADCL ^ ADCH);
+
+    }
 
-        char buff[5];
+    #if (LOG_LDR == 1)
 
-        sprintf_P(buff, fmt_unsigned_decimal, result);
-        uart_puts_P("LDR init: ");
-        uart_puts(buff);
-        uart_putc('\n');
+        log_put(LOG_EVENT_LDR, result, 0, 0);
 
     #endif
 
@@ -155,64 +180,269 @@ void ldr_init()
 /**
  * @brief Returns the "current" brightness
  *
- * This function returns the "current" brightness. "Current" means that it
- * is actually the mean of all of the last taken measurements.
+ * This function returns the "current" brightness, which is the filtered
+ * value of the last measurements.
  *
  * @return Current brightness, 0 = dark, 255 = bright
  *
  * @see ldr_init()
- * @see MEASUREMENTS_ARRAY_SIZE
+ * @see ldr_value
  */
 uint8_t ldr_get_brightness()
 {
 
-    return  255 - (curr_sum / MEASUREMENTS_ARRAY_SIZE);
+    return 255 - ldr_value;
+
+}
+
+#if (ENABLE_WARM_RESTART == 1)
+
+    /**
+     * @brief Returns the filtered value of the measurements
+     *
+     * @return Filtered value, see ldr_filtered
+     *
+     * @see ldr_restore()
+     */
+    uint16_t ldr_get_filtered()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t filtered = ldr_filtered;
+        SREG = sreg;
+
+        return filtered;
+
+    }
+
+    /**
+     * @brief Restores the filtered value after a warm restart
+     *
+     * This replaces the single measurement taken by `ldr_init()`, so the
+     * filter continues where it has left off before the reset.
+     *
+     * @param filtered Filtered value, as returned by ldr_get_filtered()
+     *
+     * @see restart_restore()
+     */
+    void ldr_restore(uint16_t filtered)
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+        ldr_filtered = filtered;
+        ldr_value = (filtered + 0x80) >> 8;
+        SREG = sreg;
+
+    }
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
+/**
+ * @brief Starts a new measurement
+ *
+ * Unless ADC noise reduction sleep mode is used, the first conversion is
+ * started right away, while the others are started by `ISR(ADC_vect)`.
+ * Otherwise the conversions are performed by `ldr_handle()`.
+ *
+ * @see ldr_conversions
+ * @see LDR_USE_NOISE_REDUCTION_SLEEP
+ */
+static void ldr_start_measurement()
+{
+
+    if (ldr_conversions) {
+
+        return;
+
+    }
+
+    ldr_sum = 0;
+    ldr_conversions = LDR_OVERSAMPLING;
+
+    #if (LDR_USE_NOISE_REDUCTION_SLEEP == 0)
+
+        /*
+         * ADSC: ADC start conversion
+         */
+        ADCSRA |= _BV(ADSC);
+
+    #else
+
+        event_post(EVENT_LDR);
+
+    #endif /* (LDR_USE_NOISE_REDUCTION_SLEEP == 0) */
+
+}
+
+/**
+ * @brief Starts new measurements at the appropriate rate
+ *
+ * This is executed within `INTERRUPT_10HZ`. While the ambient light is stable
+ * a measurement is started only every tenth invocation, i.e. once a second.
+ * After a change has been detected, a measurement is started with each
+ * invocation for the next `LDR_FAST_MEASUREMENTS` measurements.
+ *
+ * @note The module has to be initialized first using `ldr_init()`.
+ *
+ * @see ldr_init()
+ * @see INTERRUPT_10HZ
+ * @see ldr_start_measurement()
+ */
+void ldr_ISR()
+{
+
+    static uint8_t counter = 0;
+
+    if (ldr_fast || ++counter >= 10) {
+
+        counter = 0;
+        ldr_start_measurement();
+
+    }
+
+}
+
+#if (LDR_USE_NOISE_REDUCTION_SLEEP == 1)
+
+    /**
+     * @brief Performs the conversions of pending measurements
+     *
+     * This enters ADC noise reduction sleep mode for each conversion, which
+     * starts the conversion right away. The CPU is woken up again by
+     * `ISR(ADC_vect)` once the conversion is completed.
+     *
+     * This is expected to be called regularly from within the main loop.
+     *
+     * @see LDR_USE_NOISE_REDUCTION_SLEEP
+     * @see ldr_conversions
+     */
+    void ldr_handle()
+    {
+
+        if (!ldr_conversions) {
+
+            return;
+
+        }
+
+        set_sleep_mode(SLEEP_MODE_ADC);
+
+        while (ldr_conversions) {
+
+            sleep_mode();
+
+        }
+
+        set_sleep_mode(SLEEP_MODE_IDLE);
+
+    }
+
+#endif /* (LDR_USE_NOISE_REDUCTION_SLEEP == 1) */
+
+/**
+ * @brief Feeds a measurement into the filter
+ *
+ * The filter is an exponential moving average, whose weight depends on
+ * whether a change of the ambient light has been detected. The resulting
+ * value is only passed on to `ldr_value` once it differs by more than
+ * `LDR_HYSTERESIS`, in which case `EVENT_BRIGHTNESS` is posted.
+ *
+ * @param measurement The value of the measurement
+ *
+ * @see ldr_filtered
+ * @see ldr_fast
+ * @see LDR_CHANGE_THRESHOLD
+ */
+static void ldr_filter(uint8_t measurement)
+{
+
+    uint8_t current = (ldr_filtered + 0x80) >> 8;
+    uint8_t delta = measurement > current ? measurement - current : current - measurement;
+
+    if (delta >= LDR_CHANGE_THRESHOLD) {
+
+        ldr_fast = LDR_FAST_MEASUREMENTS;
+
+    } else if (ldr_fast) {
+
+        ldr_fast--;
+
+    }
+
+    int32_t error = ((int32_t)measurement << 8) - ldr_filtered;
+
+    ldr_filtered += error >> (ldr_fast ? LDR_FILTER_SHIFT_FAST : LDR_FILTER_SHIFT_SLOW);
+
+    current = (ldr_filtered + 0x80) >> 8;
+    delta = current > ldr_value ? current - ldr_value : ldr_value - current;
+
+    if (delta > LDR_HYSTERESIS) {
+
+        ldr_value = current;
+        event_post(EVENT_BRIGHTNESS);
+
+    }
 
 }
 
 /**
- * @brief Processes the last taken measurement
+ * @brief Processes the last completed conversion
  *
- * This ISR will be executed once a new conversion has been completed. The
- * conversion itself is started using `ldr_ADC()`.
+ * This ISR will be executed once a conversion has been completed. The
+ * measurement itself is started using `ldr_start_measurement()`.
  *
- * It will read out the value from the ADC measurement started in the last
- * cycle and put it into `measurements`. It will then also recalculate the new
- * value for `curr_sum`.
+ * The result of the conversion is added to `ldr_sum`. Unless this was the
+ * last conversion of the measurement, the next conversion is started.
+ * Otherwise the average is fed into the filter.
  *
- * If logging is enabled (`LOG_LDR`) it will also output the value of the ADC
- * measurement.
+ * If logging is enabled (`LOG_LDR`) the value of each measurement is also put
+ * into the log buffer (see log_put()).
  *
- * @see ldr_ADC()
- * @see measurements
- * @see curr_sum
+ * @see ldr_start_measurement()
+ * @see ldr_conversions
+ * @see ldr_filter()
  * @see LOG_LDR
- * @see MEASUREMENTS_ARRAY_SIZE
+ * @see LDR_OVERSAMPLING
  */
 ISR(ADC_vect)
 {
 
-    static uint8_t curr_index = 0;
+    PROFILE_ISR_ENTER();
+    MEMCHECK_ISR_ENTER(PROFILE_ISR_ADC);
 
-    uint8_t measurement = ADCH;
+    if (ldr_conversions) {
 
-    #if (LOG_LDR == 1)
+        ldr_sum += ADCH;
 
-        char buff[5];
+        if (--ldr_conversions) {
 
-        sprintf_P(buff, fmt_unsigned_decimal, measurement);
-        uart_puts_P("LDR: ");
-        uart_puts(buff);
-        uart_putc('\n');
+            #if (LDR_USE_NOISE_REDUCTION_SLEEP == 0)
 
-    #endif
+                /*
+                 * ADSC: ADC start conversion
+                 */
+                ADCSRA |= _BV(ADSC);
+
+            #endif /* (LDR_USE_NOISE_REDUCTION_SLEEP == 0) */
 
-    curr_sum -= measurements[curr_index];
-    measurements[curr_index] = measurement;
-    curr_sum += measurement;
+        } else {
 
-    curr_index++;
+            uint8_t measurement = ldr_sum >> LDR_OVERSAMPLING_SHIFT;
+
+            #if (LOG_LDR == 1)
+
+                log_put(LOG_EVENT_LDR, measurement, 0, 0);
+
+            #endif
+
+            ldr_filter(measurement);
+
+        }
+
+    }
 
-    curr_index %= MEASUREMENTS_ARRAY_SIZE;
+    PROFILE_ISR_EXIT(PROFILE_ISR_ADC, false);
 
 }
@@ -24,8 +24,10 @@
  * @brief Header file allowing to access brightness measurements from the LDR
  *
  * This module handles the access to the brightness measured by the LDR sensor.
- * The returned brightness is the mean value of the last n measurements,
- * where n = `MEASUREMENTS_ARRAY_SIZE`.
+ * Each measurement is made up of multiple ADC conversions, which are then
+ * filtered by an exponential moving average with hysteresis. Measurements are
+ * taken once a second as long as the ambient light is stable, and ten times a
+ * second when it is changing, so the brightness follows changes quickly.
  *
  * It is used to provide ambient light influenced behavior, e.g. increasing the
  * brightness of the LEDs involved when the light in the room the Wordclock is
@@ -40,42 +42,116 @@
 #include <avr/io.h>
 
 /**
- * @brief Number of measurements taken account for calculating the brightness
+ * @brief Number of ADC conversions making up a single measurement
  *
- * The brightness calculated by `ldr_get_brightness()` will be the mean value
- * of the values stored in an array of this size, which effectively acts as a
- * low pass filter.
+ * The conversions are averaged in order to reduce noise.
  *
- * @note For performance reasons this should be a multiple of two.
+ * @note This needs to be a power of two.
  *
- * @see ldr_get_brightness()
+ * @see LDR_OVERSAMPLING_SHIFT
  */
-#define MEASUREMENTS_ARRAY_SIZE 16
+#define LDR_OVERSAMPLING 4
 
-extern void ldr_init();
+/**
+ * @brief Binary logarithm of `LDR_OVERSAMPLING`
+ *
+ * @see LDR_OVERSAMPLING
+ */
+#define LDR_OVERSAMPLING_SHIFT 2
 
-extern uint8_t ldr_get_brightness();
+/**
+ * @brief Number of ADC conversions fed into the PRNG during initialization
+ *
+ * Each conversion takes about 52 us, so this delays the initialization by
+ * less than a millisecond.
+ *
+ * @see ldr_init()
+ * @see prng_add_entropy()
+ */
+#define LDR_ENTROPY_SAMPLES 16
 
 /**
- * @brief Starts a new ADC conversion
+ * @brief Controls whether conversions are performed in ADC noise reduction
+ * sleep mode
  *
- * This is executed within `INTERRUPT_1HZ` to start a new ADC measurement each
- * second. However, before this can be used the module has to initialized first
- * using `ldr_init()`.
+ * This halts the CPU during the conversions in order to minimize their noise.
+ * The conversions are then performed from within the main loop by
+ * `ldr_handle()`.
  *
- * The measurement itself is being processed by the ISR `ISR(ADC_vect)`.
+ * @note This also halts the I/O clock, i.e. the timers, the PWM and the UART
+ * stop for about 50 us per conversion. This causes a visible flicker and can
+ * corrupt received characters, so it is disabled by default.
  *
- * @see ldr_init()
- * @see INTERRUPT_1HZ
- * @see ISR(ADC_vect)
+ * @see ldr_handle()
  */
-void inline ldr_ADC() {
+#define LDR_USE_NOISE_REDUCTION_SLEEP 0
+
+/**
+ * @brief Difference between a measurement and the filtered value considered
+ * to be a change of the ambient light
+ *
+ * Once a change has been detected, measurements are taken ten times a second
+ * and the filter reacts faster.
+ *
+ * @see LDR_FAST_MEASUREMENTS
+ */
+#define LDR_CHANGE_THRESHOLD 8
+
+/**
+ * @brief Number of measurements taken at the fast rate after a change
+ *
+ * Once this number of measurements in a row has not detected a change, the
+ * sampling returns back to the slow rate of one measurement per second.
+ *
+ * @see LDR_CHANGE_THRESHOLD
+ */
+#define LDR_FAST_MEASUREMENTS 20
+
+/**
+ * @brief Weight of a measurement for the filter while the light is stable
+ *
+ * Each measurement is weighted with 1 / 2^n, i.e. with the default of 3 the
+ * filter averages roughly over the last 8 measurements.
+ *
+ * @see LDR_FILTER_SHIFT_FAST
+ */
+#define LDR_FILTER_SHIFT_SLOW 3
+
+/**
+ * @brief Weight of a measurement for the filter while the light is changing
+ *
+ * @see LDR_FILTER_SHIFT_SLOW
+ */
+#define LDR_FILTER_SHIFT_FAST 1
+
+/**
+ * @brief Change of the filtered value needed for the brightness to be updated
+ *
+ * This prevents the brightness from toggling between two adjacent values due
+ * to noise.
+ *
+ * @see ldr_get_brightness()
+ */
+#define LDR_HYSTERESIS 2
+
+extern void ldr_init();
+
+extern uint8_t ldr_get_brightness();
+
+extern void ldr_ISR();
+
+#if (ENABLE_WARM_RESTART == 1)
+
+    extern uint16_t ldr_get_filtered();
+
+    extern void ldr_restore(uint16_t filtered);
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
+#if (LDR_USE_NOISE_REDUCTION_SLEEP == 1)
 
-    /*
-     * ADSC: ADC start conversion
-     */
-    ADCSRA |= _BV(ADSC);
+    extern void ldr_handle();
 
-}
+#endif /* (LDR_USE_NOISE_REDUCTION_SLEEP == 1) */
 
 #endif /* _WC_LDR_H_ */
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file log.c
+ * @brief Implementation of the header declared in log.h
+ *
+ * Each record is put out as a single line, consisting of the timestamp in
+ * milliseconds (see timer_get_ms()) followed by the prefix of the event and
+ * its arguments. The line is put into the transmission FIFO piece by piece,
+ * without building it up in memory first.
+ *
+ * @see log.h
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "format.h"
+#include "log.h"
+#include "timer.h"
+#include "uart.h"
+
+#if (LOG_USE_BUFFER == 1)
+
+#if ((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) != 0)
+
+    #error "LOG_BUFFER_SIZE needs to be a power of two"
+
+#endif
+
+/**
+ * @brief Maximum length of a single line put out by log_handle()
+ *
+ * Records are only put out when there is at least this much space left
+ * within the transmission FIFO, so lines never get truncated. This needs to
+ * be smaller than the size of the FIFO (UART_BUFFER_SIZE_OUT).
+ *
+ * @see log_handle()
+ */
+#define LOG_LINE_LENGTH 48
+
+/**
+ * @brief Flag within log_layouts indicating arguments put out as hex
+ *
+ * @see log_layouts
+ */
+#define LOG_LAYOUT_HEX 0x80
+
+/**
+ * @brief A single record as stored within the log buffer
+ *
+ * @see log_buffer
+ */
+typedef struct {
+
+    /**
+     * @brief The event logged, see log_event_t
+     */
+    uint8_t event;
+
+    /**
+     * @brief Timestamp of the record as returned by timer_get_ms()
+     */
+    uint16_t time;
+
+    /**
+     * @brief Arguments of the record, their meaning depends on the event
+     */
+    uint16_t args[3];
+
+} log_record_t;
+
+/**
+ * @brief Prefixes put out for each of the events
+ *
+ * These need to be in the same order as the events within log_event_t. The
+ * prefix of LOG_EVENT_TEXT is taken from the first argument of the record
+ * instead.
+ *
+ * @see log_layouts
+ */
+static const char log_prefix_ldr[] PROGMEM = "LDR:";
+static const char log_prefix_dcf77_pause[] PROGMEM = "DCF77 pause:";
+static const char log_prefix_dcf77_detect[] PROGMEM = "DCF77 detect:";
+static const char log_prefix_display_state[] PROGMEM = "Disp:";
+
+/**
+ * @brief Table of prefixes indexed by the event
+ *
+ * @see log_event_t
+ */
+static PGM_P const log_prefixes[LOG_EVENT_COUNT] PROGMEM = {
+
+    NULL,
+    log_prefix_ldr,
+    log_prefix_dcf77_pause,
+    log_prefix_dcf77_detect,
+    log_prefix_display_state,
+
+};
+
+/**
+ * @brief Number of arguments put out for each of the events
+ *
+ * Arguments are put out in decimal, unless LOG_LAYOUT_HEX is set, in which
+ * case they are put out as hex with four digits each.
+ *
+ * @see log_event_t
+ * @see LOG_LAYOUT_HEX
+ */
+static const uint8_t log_layouts[LOG_EVENT_COUNT] PROGMEM = {
+
+    0,
+    1,
+    1,
+    3,
+    2 | LOG_LAYOUT_HEX,
+
+};
+
+/**
+ * @brief Ring buffer holding the records not yet put out
+ *
+ * @see log_head
+ * @see log_tail
+ */
+static log_record_t log_buffer[LOG_BUFFER_SIZE];
+
+/**
+ * @brief Index of the next record to be written by log_put()
+ *
+ * @see log_buffer
+ */
+static volatile uint8_t log_head;
+
+/**
+ * @brief Index of the next record to be put out by log_handle()
+ *
+ * @see log_buffer
+ */
+static volatile uint8_t log_tail;
+
+/**
+ * @brief Number of records dropped since the last report
+ *
+ * @see log_put()
+ * @see log_handle()
+ */
+static volatile uint8_t log_dropped;
+
+/**
+ * @brief Stores a new record within the log buffer
+ *
+ * This doesn't format anything and can therefore be called from within ISRs.
+ * When the buffer is full, the record is dropped and only counted.
+ *
+ * @param event The event to log
+ * @param arg0 First argument of the record
+ * @param arg1 Second argument of the record
+ * @param arg2 Third argument of the record
+ *
+ * @see log_buffer
+ * @see log_dropped
+ */
+void log_put(log_event_t event, uint16_t arg0, uint16_t arg1, uint16_t arg2)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+
+    uint8_t next = (log_head + 1) & (LOG_BUFFER_SIZE - 1);
+
+    if (next == log_tail) {
+
+        if (log_dropped < UINT8_MAX) {
+
+            log_dropped++;
+
+        }
+
+    } else {
+
+        log_record_t* record = &log_buffer[log_head];
+
+        record->event = event;
+        record->time = timer_get_ms();
+        record->args[0] = arg0;
+        record->args[1] = arg1;
+        record->args[2] = arg2;
+
+        log_head = next;
+
+    }
+
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Formats and puts out the records of the log buffer
+ *
+ * This puts out as many records as fit into the transmission FIFO, the
+ * remaining ones are put out the next time. If records have been dropped
+ * in the meantime, their number is reported once the buffer is empty.
+ *
+ * This needs to be called on a regular basis, see `EVENT_TIMER`.
+ *
+ * @see log_buffer
+ * @see log_prefixes
+ * @see log_layouts
+ */
+void log_handle()
+{
+
+    char number[FORMAT_DEC_MAX_LENGTH];
+
+    while (uart_free() >= LOG_LINE_LENGTH) {
+
+        if (log_tail == log_head) {
+
+            uint8_t sreg = SREG;
+            cli();
+            uint8_t dropped = log_dropped;
+            log_dropped = 0;
+            SREG = sreg;
+
+            if (dropped) {
+
+                format_dec(number, dropped);
+                uart_puts_P("Log: ");
+                uart_puts(number);
+                uart_puts_P(" dropped\n");
+
+            }
+
+            return;
+
+        }
+
+        /*
+         * The record can't be overwritten by log_put() until log_tail has
+         * been advanced
+         */
+        const log_record_t* record = &log_buffer[log_tail];
+
+        format_dec(number, record->time);
+        uart_puts(number);
+        uart_putc(' ');
+
+        if (record->event == LOG_EVENT_TEXT) {
+
+            uart_puts_p((PGM_P)record->args[0]);
+
+        } else if (record->event < LOG_EVENT_COUNT) {
+
+            uart_puts_p((PGM_P)pgm_read_word(&log_prefixes[record->event]));
+
+            uint8_t layout = pgm_read_byte(&log_layouts[record->event]);
+
+            for (uint8_t i = 0; i < (layout & ~LOG_LAYOUT_HEX); i++) {
+
+                if (layout & LOG_LAYOUT_HEX) {
+
+                    format_hex16(number, record->args[i]);
+
+                } else {
+
+                    format_dec(number, record->args[i]);
+
+                }
+
+                uart_putc(' ');
+                uart_puts(number);
+
+            }
+
+        }
+
+        uart_putc('\n');
+
+        log_tail = (log_tail + 1) & (LOG_BUFFER_SIZE - 1);
+
+    }
+
+}
+
+#endif /* (LOG_USE_BUFFER == 1) */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file log.h
+ * @brief Header for logging from within ISRs without formatting any output
+ *
+ * Formatting messages and putting them out via UART takes way too long to be
+ * done from within an ISR, and the transmission FIFO fills up quickly.
+ * Instead log_put() only stores a small binary record (event, timestamp and
+ * up to three arguments) within a ring buffer, which takes just a few cycles.
+ * log_handle() formats the records from within the main loop and puts them
+ * out as fast as the UART can keep up with. Therefore the logging of modules
+ * making use of it (LOG_LDR, LOG_DCF77 and LOG_DISPLAY_STATE) can be enabled
+ * without affecting the timing of the ISRs.
+ *
+ * Records that don't fit into the buffer are dropped. Their number is put out
+ * along with the next records, so it is obvious that something is missing.
+ *
+ * The buffer is only compiled in when at least one of the modules making use
+ * of it has its logging enabled (see LOG_USE_BUFFER).
+ *
+ * @see log.c
+ */
+
+#ifndef _WC_LOG_H_
+#define _WC_LOG_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "config.h"
+
+/**
+ * @brief Defines whether the log buffer is needed within this build
+ *
+ * @see LOG_LDR
+ * @see LOG_DCF77
+ * @see LOG_DISPLAY_STATE
+ */
+#define LOG_USE_BUFFER ((LOG_LDR == 1) || (LOG_DCF77 == 1) || (LOG_DISPLAY_STATE == 1))
+
+/**
+ * @brief Number of records that can be buffered until log_handle() is invoked
+ *
+ * Each record occupies nine bytes.
+ *
+ * @note This needs to be a power of two.
+ *
+ * @see log_record_t
+ */
+#define LOG_BUFFER_SIZE 16
+
+/**
+ * @brief Events that can be logged
+ *
+ * Each of these comes with its own prefix and layout, see log_prefixes.
+ *
+ * @see log_put()
+ */
+typedef enum {
+
+    /**
+     * @brief Fixed message stored in program space
+     *
+     * The first argument is a pointer to the message, see log_text_P().
+     */
+    LOG_EVENT_TEXT,
+
+    /**
+     * @brief Measurement of the LDR (value)
+     */
+    LOG_EVENT_LDR,
+
+    /**
+     * @brief Length of a pause of the DCF77 signal (length in 10 ms)
+     */
+    LOG_EVENT_DCF77_PAUSE,
+
+    /**
+     * @brief A second of the DCF77 receiver detection has passed (samples
+     * low, samples high, passes)
+     */
+    LOG_EVENT_DCF77_DETECT,
+
+    /**
+     * @brief A display state has been output (high word, low word)
+     */
+    LOG_EVENT_DISPLAY_STATE,
+
+    LOG_EVENT_COUNT
+
+} log_event_t;
+
+#if (LOG_USE_BUFFER == 1)
+
+    extern void log_put(log_event_t event, uint16_t arg0, uint16_t arg1, uint16_t arg2);
+
+    extern void log_handle();
+
+#else
+
+    /**
+     * @brief Empty macro in case the log buffer is not needed
+     *
+     * @see LOG_USE_BUFFER
+     */
+    #define log_put(event, arg0, arg1, arg2)
+
+    /**
+     * @brief Empty macro in case the log buffer is not needed
+     *
+     * @see LOG_USE_BUFFER
+     */
+    #define log_handle()
+
+#endif /* (LOG_USE_BUFFER == 1) */
+
+/**
+ * @brief Logs a fixed message
+ *
+ * This puts the given string into program space automatically and only
+ * stores a pointer to it within the log buffer.
+ *
+ * @see LOG_EVENT_TEXT
+ */
+#define log_text_P(str) log_put(LOG_EVENT_TEXT, (uint16_t)PSTR(str), 0, 0)
+
+#endif /* _WC_LOG_H_ */
@@ -35,15 +35,23 @@
 #include <avr/interrupt.h>
 #include <avr/wdt.h>
 
-#include <IRMP/irmp.h>
-
 #include "brightness.h"
 #include "config.h"
 #include "datetime.h"
 #include "dcf77.h"
 #include "display.h"
+#include "event.h"
+#include "health.h"
+#include "i2c_master.h"
+#include "i2c_rtc.h"
+#include "ir.h"
 #include "ldr.h"
+#include "log.h"
+#include "memcheck.h"
+#include "prng.h"
+#include "presence.h"
 #include "pwm.h"
+#include "restart.h"
 #include "timer.h"
 #include "user.h"
 #include "uart.h"
@@ -60,6 +68,7 @@
 * module.
 *
 * @see reset_mcusr()
+* @see restart_restore()
 */
 static uint8_t mcusr __attribute__ ((section(".noinit")));
 
@@ -97,7 +106,8 @@ static uint8_t mcusr __attribute__ ((section(".noinit")));
  *
  * This is the main entry point where execution will start. It initializes the
  * hardware and enters an infinite loop handling any upcoming events not yet
- * covered.
+ * covered. Only the handlers of modules that have posted an event are
+ * invoked, and the microcontroller sleeps while there is nothing to be done.
  *
  * @note This function makes use of the attribute "OS_main". For details
  * refer to [1].
@@ -114,6 +124,7 @@ __attribute__((OS_main)) int main()
     log_main("Init...\n");
 
     preferences_init();
+    prng_init();
 
     #if (ENABLE_DCF_SUPPORT == 1)
 
@@ -123,43 +134,156 @@ __attribute__((OS_main)) int main()
 
     display_init();
     datetime_init();
+    health_init();
     ldr_init();
     pwm_init();
-    irmp_init();
+
+    #if (ENABLE_IR_SUPPORT == 1)
+
+        irmp_init();
+
+    #endif /* (ENABLE_IR_SUPPORT == 1) */
+
     timer_init();
+    ir_init();
+    presence_init();
     user_init();
 
     sei();
 
     pwm_on();
 
+    /*
+     * Pick up where the firmware has left off in case of a warm restart
+     */
+    if (restart_restore(mcusr)) {
+
+        log_main("Warm restart\n");
+
+    }
+
+    #if (ENABLE_FAST_BOOT == 1)
+
+        /*
+         * Read the RTC right away instead of waiting for the first tick of
+         * the software clock
+         */
+        event_post(EVENT_DATETIME);
+
+    #endif /* (ENABLE_FAST_BOOT == 1) */
+
     log_main("Init finished\n");
 
+    /*
+     * Apply the brightness measured during the initialization
+     */
+    event_post(EVENT_BRIGHTNESS);
+
     while (1) {
 
-        brightness_handle();
-        datetime_handle();
-        handle_ir_code();
+        uint16_t events = event_get();
+
+        health_loop();
+
+        if (events & _BV(EVENT_TIMER)) {
+
+            timer_handle();
+            i2c_master_handle();
+            memcheck_handle();
+            preferences_handle();
+            ir_handle();
+            uart_protocol_telemetry_handle();
+            log_handle();
+
+        }
+
+        if (events & _BV(EVENT_BRIGHTNESS)) {
+
+            brightness_handle();
+
+        }
+
+        if (events & _BV(EVENT_I2C)) {
+
+            i2c_rtc_handle();
+
+        }
+
+        if (events & (_BV(EVENT_DATETIME) | _BV(EVENT_I2C))) {
+
+            datetime_handle();
+            uart_protocol_beacon_handle();
+            restart_handle();
+
+        }
+
+        #if (ENABLE_IR_SUPPORT == 1)
+
+            if (events & _BV(EVENT_IR)) {
+
+                handle_ir_code();
+                ir_handle();
+
+            }
+
+        #endif /* (ENABLE_IR_SUPPORT == 1) */
+
+        #if (LDR_USE_NOISE_REDUCTION_SLEEP == 1)
+
+            if (events & _BV(EVENT_LDR)) {
+
+                ldr_handle();
+
+            }
+
+        #endif /* (LDR_USE_NOISE_REDUCTION_SLEEP == 1) */
 
         #if (ENABLE_UART_PROTOCOL == 1)
 
-            uart_protocol_handle();
+            if (events & _BV(EVENT_UART)) {
+
+                uart_protocol_handle();
+
+                /*
+                 * Only a single command is processed at once
+                 */
+                if (uart_available()) {
+
+                    event_post(EVENT_UART);
+
+                }
+
+            }
 
         #endif /* (ENABLE_UART_PROTOCOL == 1) */
 
         #if (ENABLE_DCF_SUPPORT == 1)
 
-            datetime_t dt;
+            if (events & _BV(EVENT_DCF77)) {
+
+                datetime_t dt;
+
+                // TODO: Make sure dcf77_getDateTime() validates its result
+                if (dcf77_get_datetime(&dt)) {
 
-            // TODO: Make sure dcf77_getDateTime() validates its result
-            if (dcf77_get_datetime(&dt)) {
+                    datetime_set(&dt);
 
-                datetime_set(&dt);
+                }
 
             }
 
         #endif
 
+        #if (ENABLE_PRESENCE_SUPPORT == 1)
+
+            if (events & _BV(EVENT_PRESENCE)) {
+
+                user_presence_detected();
+
+            }
+
+        #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
     }
 
 }
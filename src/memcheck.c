@@ -34,6 +34,7 @@
  * @see memcheck.h
  */
 
+#include <avr/interrupt.h>
 #include <avr/io.h>
 
 #include "memcheck.h"
@@ -109,6 +110,139 @@ size_t memcheck_get_current(void)
 
 }
 
+#if (ENABLE_DEBUG_MEMCHECK == 1)
+
+    /**
+     * @brief Lowest value of the stack pointer on entry of each ISR
+     *
+     * @see MEMCHECK_ISR_ENTER()
+     */
+    uint16_t memcheck_isr_sp[PROFILE_ISR_COUNT] = {
+
+        [0 ... PROFILE_ISR_COUNT - 1] = RAMEND
+
+    };
+
+    /**
+     * @brief Maximum stack depth detected by memcheck_handle() so far
+     *
+     * @see memcheck_handle()
+     * @see memcheck_get_max_depth()
+     */
+    static size_t memcheck_max_depth;
+
+    /**
+     * @brief Indicates whether the canary was found to be overwritten
+     *
+     * Once set this is never reset again, so that even a single incident can
+     * be detected later on.
+     *
+     * @see MEMCHECK_CANARY_SIZE
+     * @see memcheck_handle()
+     */
+    static bool memcheck_canary_broken;
+
+    /**
+     * @brief Retrieves the maximum stack depth the given ISR was entered with
+     *
+     * The depth is given in bytes, counted from the end of the SRAM (`RAMEND`)
+     * and is sampled by MEMCHECK_ISR_ENTER().
+     *
+     * @param isr ISR to retrieve the depth for
+     * @param o_depth Pointer to store the depth at
+     *
+     * @return True if the depth could be retrieved, false if isr is invalid
+     *
+     * @see MEMCHECK_ISR_ENTER()
+     */
+    bool memcheck_get_isr_depth(e_profileIsr isr, uint16_t* o_depth)
+    {
+
+        if (isr >= PROFILE_ISR_COUNT) {
+
+            return false;
+
+        }
+
+        uint8_t sreg = SREG;
+        cli();
+        *o_depth = RAMEND - memcheck_isr_sp[isr];
+        SREG = sreg;
+
+        return true;
+
+    }
+
+    /**
+     * @brief Returns the maximum stack depth detected so far
+     *
+     * This is the high-water mark as determined by memcheck_handle() and is
+     * given in bytes, counted from the end of the SRAM (`RAMEND`).
+     *
+     * @return Maximum stack depth in bytes
+     *
+     * @see memcheck_handle()
+     */
+    size_t memcheck_get_max_depth(void)
+    {
+
+        return memcheck_max_depth;
+
+    }
+
+    /**
+     * @brief Returns whether the canary has always been found to be intact
+     *
+     * @return False if the stack has ever reached the canary, true otherwise
+     *
+     * @see MEMCHECK_CANARY_SIZE
+     * @see memcheck_handle()
+     */
+    bool memcheck_canary_intact(void)
+    {
+
+        return !memcheck_canary_broken;
+
+    }
+
+    /**
+     * @brief Updates the stack high-water mark and checks the canary
+     *
+     * This is expected to be called regularly from within the main loop. It
+     * checks whether the bit pattern within the first MEMCHECK_CANARY_SIZE
+     * bytes above the static data is still intact and updates the maximum
+     * stack depth based upon memcheck_get_unused().
+     *
+     * @see MEMCHECK_CANARY_SIZE
+     * @see memcheck_get_max_depth()
+     * @see memcheck_canary_intact()
+     */
+    void memcheck_handle(void)
+    {
+
+        const unsigned char* p = &__heap_start;
+
+        for (uint8_t i = 0; i < MEMCHECK_CANARY_SIZE; i++) {
+
+            if (p[i] != MEMCHECK_MASK) {
+
+                memcheck_canary_broken = true;
+
+            }
+
+        }
+
+        size_t depth = (RAMEND + 1 - (size_t)&__heap_start) - memcheck_get_unused();
+
+        if (depth > memcheck_max_depth) {
+
+            memcheck_max_depth = depth;
+
+        }
+
+    }
+
+#endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
 
 void __attribute__ ((naked, used, section(".init3"))) memcheck_init(void);
 
@@ -24,15 +24,98 @@
  * This module allows to check the memory usage during runtime. It can be used
  * to measure the maximum stack depth to get data about the claimed resources.
  *
+ * When ENABLE_DEBUG_MEMCHECK is set to 1, the stack pointer is additionally
+ * sampled on entry of each ISR (MEMCHECK_ISR_ENTER()), so it can be told
+ * which of them are entered with the deepest stack, and a canary at the
+ * bottom of the stack is checked from within the main loop
+ * (memcheck_handle()).
+ *
  * @see memcheck.c
  */
 
 #ifndef _WC_MEMCHECK_H_
 #define _WC_MEMCHECK_H_
 
+#include <stdbool.h>
 #include <stdlib.h>
+#include <avr/io.h>
+
+#include "config.h"
+#include "profile.h"
+
+/**
+ * @brief Number of bytes at the bottom of the stack used as canary
+ *
+ * These bytes are located directly above the static data (`__heap_start`).
+ * When the stack ever reaches down into this region, it is very likely to
+ * corrupt the static data soon. This is checked for regularly by
+ * memcheck_handle().
+ *
+ * @see memcheck_handle()
+ * @see memcheck_canary_intact()
+ */
+#define MEMCHECK_CANARY_SIZE 8
 
 extern size_t memcheck_get_unused(void);
 extern size_t memcheck_get_current(void);
 
+#if (ENABLE_DEBUG_MEMCHECK == 1)
+
+    /**
+     * @brief Lowest value of the stack pointer on entry of each ISR
+     *
+     * This is not meant to be accessed directly, use MEMCHECK_ISR_ENTER() and
+     * memcheck_get_isr_depth() instead.
+     *
+     * @see MEMCHECK_ISR_ENTER()
+     * @see memcheck_get_isr_depth()
+     */
+    extern uint16_t memcheck_isr_sp[PROFILE_ISR_COUNT];
+
+    /**
+     * @brief Samples the stack pointer on entry of an ISR
+     *
+     * This should be placed at the very beginning of the ISR, right after
+     * PROFILE_ISR_ENTER(). It keeps track of the lowest value of the stack
+     * pointer seen so far for the given ISR, i.e. the maximum stack depth the
+     * ISR was entered with. This is inlined on purpose, so that the stack
+     * pointer is not skewed by an additional function call.
+     *
+     * @param isr ISR to record the stack pointer for, see e_profileIsr
+     *
+     * @see memcheck_get_isr_depth()
+     */
+    #define MEMCHECK_ISR_ENTER(isr) \
+        do { \
+            if (SP < memcheck_isr_sp[(isr)]) { \
+                memcheck_isr_sp[(isr)] = SP; \
+            } \
+        } while (0)
+
+    extern bool memcheck_get_isr_depth(e_profileIsr isr, uint16_t* o_depth);
+
+    extern size_t memcheck_get_max_depth(void);
+
+    extern bool memcheck_canary_intact(void);
+
+    extern void memcheck_handle(void);
+
+#else
+
+    /**
+     * @brief Empty macro in case memory debugging is disabled
+     *
+     * @see ENABLE_DEBUG_MEMCHECK
+     */
+    #define MEMCHECK_ISR_ENTER(isr)
+
+    /**
+     * @brief Empty macro in case memory debugging is disabled
+     *
+     * @see ENABLE_DEBUG_MEMCHECK
+     */
+    #define memcheck_handle()
+
+#endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
+
 #endif  /* _WC_MEMCHECK_H_ */
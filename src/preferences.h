@@ -29,6 +29,11 @@
  * access to the actual data, so in other storage backends could be used in
  * different circumstances.
  *
+ * The EEPROM backend stores the preferences as a journal of records, see
+ * PREFERENCES_JOURNAL_SLOT_SIZE. Each save appends a new record, so that
+ * writes are spread across the whole EEPROM and an interrupted save leaves
+ * the previous record intact.
+ *
  * @see preferences_eeprom.c
  */
 
@@ -39,10 +44,28 @@
 #include <stdlib.h>
 
 #include "user.h"
+#include "datetime.h"
 #include "display.h"
 #include "pwm.h"
 #include "version.h"
 
+/**
+ * @brief Size of a single slot within the EEPROM journal
+ *
+ * The EEPROM is divided into slots of this size, each of which can hold a
+ * single record consisting of a small header along with prefs_t. Saves are
+ * written to the slot following the one holding the newest record, so each
+ * cell is only written once every `(E2END + 1) / PREFERENCES_JOURNAL_SLOT_SIZE`
+ * saves.
+ *
+ * Smaller values provide better wear leveling, but leave less room for
+ * prefs_t to grow. The slot layout needs to stay the same across firmware
+ * updates, so existing records can be migrated.
+ *
+ * @see preferences_eeprom.c
+ */
+#define PREFERENCES_JOURNAL_SLOT_SIZE 256
+
 /**
  * @brief Preferences to be stored persistently and globally accessible
  *
@@ -74,6 +97,11 @@ typedef struct {
      */
     pwm_prefs_t pwm_prefs;
 
+    /**
+     * @see datetime_prefs_t
+     */
+    datetime_prefs_t datetime_prefs;
+
     /**
      * @brief Version number
      *
@@ -103,5 +131,7 @@ void preferences_init();
 
 prefs_t* preferences_get();
 bool preferences_save();
+bool preferences_save_completed();
+void preferences_handle();
 
 #endif /* _WC_PREFERENCES_H_ */
@@ -29,7 +29,24 @@
  * invoked in order for the data to be written to the EEPROM coming along with
  * the microcontroller in use.
  *
+ * The EEPROM is organized as a journal (see {@link #prefs_journal}): Each save
+ * writes a new record into the slot following the one holding the newest
+ * record. A record consists of a header (prefs_header_t) followed by the
+ * preferences themselves. The header contains a sequence number, which is
+ * used to find the newest record during initialization, and a CRC, which is
+ * written only after the rest of the record has been written. A save that is
+ * interrupted, e.g. by a loss of power, therefore leaves behind an invalid
+ * record, and the previous one is used instead.
+ *
+ * The header also contains the size of each of the structures making up
+ * prefs_t. This allows records written by older versions of the firmware to
+ * be migrated structure by structure: Members appended to the end of a
+ * structure are initialized with their default values, while all of the
+ * other members are carried over.
+ *
  * The EEPROM is accessed by the functionality provided by {@link eeprom.h}.
+ * Saving is done in the background, and only those bytes that differ from
+ * the previous content of the slot are actually written.
  *
  * @see eeprom.h
  * @see preferences.h
@@ -37,21 +54,115 @@
 
 #include <avr/eeprom.h>
 #include <avr/pgmspace.h>
+#include <util/crc16.h>
 
-#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "eeprom.h"
 #include "format.h"
+#include "health.h"
 #include "preferences.h"
 #include "uart.h"
 #include "version.h"
 
 /**
- * @brief Represents the preferences within EEPROM
+ * @brief Number of structures prefs_t consists of
  *
- * @see prefs_t
+ * @see prefs_section_sizes
+ */
+#define PREFS_SECTION_COUNT 4
+
+/**
+ * @brief Size of the members following the structures within prefs_t
+ *
+ * @see prefs_t::version
+ * @see prefs_t::prefs_size
+ */
+#define PREFS_TRAILER_SIZE (sizeof(version_t) + sizeof(size_t))
+
+/**
+ * @brief Number of slots within the EEPROM journal
+ *
+ * @see PREFERENCES_JOURNAL_SLOT_SIZE
+ */
+#define PREFS_JOURNAL_SLOTS ((E2END + 1) / PREFERENCES_JOURNAL_SLOT_SIZE)
+
+/**
+ * @brief Value indicating that no slot is referenced
+ *
+ * @see prefs_slot
+ * @see prefs_pending_slot
+ */
+#define PREFS_NO_SLOT 0xff
+
+#if (PREFS_JOURNAL_SLOTS < 2 || PREFS_JOURNAL_SLOTS > 16)
+
+    #error "PREFERENCES_JOURNAL_SLOT_SIZE needs to result in 2 to 16 slots"
+
+#endif
+
+/**
+ * @brief Header of each record within the EEPROM journal
+ *
+ * @see prefs_journal
+ */
+typedef struct {
+
+    /**
+     * @brief CRC of the remainder of the record
+     *
+     * This covers the header, starting with prefs_header_t::sequence, as well
+     * as the preferences. It is written last and thereby commits the record.
+     *
+     * @see prefs_get_crc()
+     */
+    uint16_t crc;
+
+    /**
+     * @brief Sequence number of the record
+     *
+     * This is incremented with each save, the record with the highest
+     * sequence number is the newest one. Comparisons take wrap arounds into
+     * account.
+     */
+    uint16_t sequence;
+
+    /**
+     * @brief Size of each of the structures making up prefs_t
+     *
+     * @see prefs_section_sizes
+     */
+    uint8_t sizes[PREFS_SECTION_COUNT];
+
+} prefs_header_t;
+
+/**
+ * @brief A record as it is written into a slot of the EEPROM journal
+ *
+ * @see prefs_journal
+ */
+typedef struct {
+
+    prefs_header_t header;
+    prefs_t prefs;
+
+} prefs_record_t;
+
+_Static_assert(sizeof(prefs_record_t) <= PREFERENCES_JOURNAL_SLOT_SIZE,
+    "prefs_t doesn't fit into PREFERENCES_JOURNAL_SLOT_SIZE");
+
+/**
+ * @brief Represents the journal of preferences within EEPROM
+ *
+ * This covers the whole EEPROM. The first slot starts at the same location
+ * the preferences were stored at by older versions of the firmware, which
+ * wrote them in place.
+ *
+ * @see PREFERENCES_JOURNAL_SLOT_SIZE
+ * @see prefs_header_t
  */
-static prefs_t prefs_eeprom EEMEM;
+static uint8_t prefs_journal[PREFS_JOURNAL_SLOTS][PREFERENCES_JOURNAL_SLOT_SIZE] EEMEM;
 
 /**
  * @brief Default settings for preferences
@@ -68,47 +179,412 @@ static const prefs_t prefs_default PROGMEM = {
     USEREEPROMPARAMS_DEFAULT,
     DISPLAYEEPROMPARAMS_DEFAULT,
     PWMEEPROMPARAMS_DEFAULT,
+    DATETIMEEEPROMPARAMS_DEFAULT,
     VERSION,
     sizeof(prefs_t),
 
 };
 
 /**
- * @brief Copy of preferences hold in SRAM
+ * @brief Size of each of the structures making up prefs_t
  *
- * This is holding all of the {@link #prefs_t preferences} in SRAM. It is
- * backed by the content of the EEPROM and can be accessed globally using
- * {@link #preferences_get()}. Note though that changes made this variable
- * are not automatically written back to the EEPROM, but a
- * {@link #preferences_save() save} operation must be invoked.
+ * This needs to list the structures in the same order they are declared in
+ * within prefs_t.
  *
- * @see prefs_t
+ * @see prefs_header_t::sizes
+ */
+static const uint8_t prefs_section_sizes[PREFS_SECTION_COUNT] PROGMEM = {
+
+    sizeof(user_prefs_t),
+    sizeof(display_prefs_t),
+    sizeof(pwm_prefs_t),
+    sizeof(datetime_prefs_t),
+
+};
+
+/**
+ * @brief Record hold in SRAM
+ *
+ * The preferences within this record are backed by the content of the EEPROM
+ * and can be accessed globally using {@link #preferences_get()}. Note though
+ * that changes made to them are not automatically written back to the
+ * EEPROM, but a {@link #preferences_save() save} operation must be invoked.
+ *
+ * The header holds the sequence number of the newest record along with the
+ * sizes of the current layout. Its CRC is only used as a source while
+ * committing a record.
+ *
+ * @see prefs_record_t
+ */
+static prefs_record_t prefs_record;
+
+/**
+ * @brief Slot holding the newest record
+ *
+ * This is PREFS_NO_SLOT when there is no valid record at all.
+ *
+ * @see preferences_init()
+ * @see preferences_handle()
+ */
+static uint8_t prefs_slot = PREFS_NO_SLOT;
+
+/**
+ * @brief Indicates whether the newest record contains the current preferences
+ *
+ * This is false whenever the preferences have not been read from the newest
+ * record as is, e.g. due to a migration, so the next save will write a new
+ * record even if nothing has been changed in the meantime.
+ *
+ * @see preferences_save()
+ */
+static bool prefs_slot_is_current;
+
+/**
+ * @brief Slot currently being written, and not yet committed
+ *
+ * This is PREFS_NO_SLOT when there is no save in progress.
+ *
+ * @see preferences_save()
+ * @see preferences_handle()
+ */
+static uint8_t prefs_pending_slot = PREFS_NO_SLOT;
+
+/**
+ * @brief Indicates whether the record for prefs_pending_slot has been queued
+ *
+ * Queuing fails whenever the EEPROM is still busy with another request. The
+ * save is kept pending in this case and retried by preferences_handle().
+ *
+ * @see prefs_queue()
+ */
+static bool prefs_pending_queued;
+
+/**
+ * @brief CRC of the preferences in SRAM at the time the record was queued
+ *
+ * This tells a record that couldn't be verified due to preferences changed
+ * while it was being written apart from an actual failure of the EEPROM.
+ *
+ * @see prefs_get_sram_crc()
+ * @see preferences_handle()
+ */
+static uint16_t prefs_pending_crc;
+
+/**
+ * @brief Dirty map of the record currently being written
+ *
+ * This marks the blocks of the record that differ from the content of the
+ * slot it is written to. It is generated by {@link #preferences_save()} and
+ * used by the EEPROM module to write only those blocks that have actually
+ * changed.
+ *
+ * @see eeprom_get_dirty_map()
+ * @see eeprom_put_block_async()
+ */
+static uint8_t prefs_dirty[EEPROM_DIRTY_MAP_SIZE(sizeof(prefs_record_t))];
+
+/**
+ * @brief Dirty map used when committing a record
+ *
+ * The CRC is smaller than a single block, which is always written.
+ *
+ * @see preferences_handle()
+ */
+static const uint8_t prefs_crc_dirty = 0x01;
+
+/**
+ * @brief Returns the number of bytes within a record covered by its CRC
+ *
+ * @param sizes Sizes of the structures, see prefs_header_t::sizes
+ *
+ * @return Number of bytes starting at prefs_header_t::sequence
+ *
+ * @see prefs_header_t::crc
+ */
+static uint16_t prefs_get_crc_length(const uint8_t* sizes)
+{
+
+    uint16_t length = sizeof(prefs_header_t) - offsetof(prefs_header_t, sequence)
+        + PREFS_TRAILER_SIZE;
+
+    for (uint8_t i = 0; i < PREFS_SECTION_COUNT; i++) {
+
+        length += sizes[i];
+
+    }
+
+    return length;
+
+}
+
+/**
+ * @brief Calculates the CRC of the record within the given slot
+ *
+ * The data is read from the EEPROM itself, so the CRC covers exactly what
+ * has been written, even if the preferences in SRAM were changed in the
+ * meantime.
+ *
+ * @param slot Slot to calculate the CRC for
+ * @param length Number of bytes to cover, see prefs_get_crc_length()
+ *
+ * @return CRC to be stored within prefs_header_t::crc
+ */
+static uint16_t prefs_get_crc(uint8_t slot, uint16_t length)
+{
+
+    const uint8_t* ptr = &prefs_journal[slot][offsetof(prefs_header_t, sequence)];
+    uint16_t crc = 0xffff;
+
+    while (length--) {
+
+        crc = _crc16_update(crc, eeprom_read_byte(ptr++));
+
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Calculates the CRC of the record within SRAM
+ *
+ * @param length Number of bytes to cover starting at prefs_header_t::sequence
+ *
+ * @return CRC of the given part of prefs_record
+ *
+ * @see prefs_pending_crc
+ */
+static uint16_t prefs_get_sram_crc(size_t length)
+{
+
+    const uint8_t* ptr = (const uint8_t*)(&prefs_record) + offsetof(prefs_header_t, sequence);
+    uint16_t crc = 0xffff;
+
+    while (length--) {
+
+        crc = _crc16_update(crc, *ptr++);
+
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Queues the write of the record into prefs_pending_slot
+ *
+ * Only those blocks that differ from the content of the slot are written.
+ * If the EEPROM is still busy, nothing is queued and prefs_pending_queued
+ * remains false, so this is retried by preferences_handle().
+ *
+ * @see prefs_pending_queued
+ * @see eeprom_put_block_async()
+ */
+static void prefs_queue()
+{
+
+    const uint8_t* src = (const uint8_t*)(&prefs_record) + offsetof(prefs_header_t, sequence);
+    uint8_t* dst = &prefs_journal[prefs_pending_slot][offsetof(prefs_header_t, sequence)];
+    size_t length = sizeof(prefs_record_t) - offsetof(prefs_header_t, sequence);
+
+    eeprom_get_dirty_map(src, dst, length, prefs_dirty);
+    prefs_pending_crc = prefs_get_sram_crc(length);
+    prefs_pending_queued = eeprom_put_block_async(src, dst, length, prefs_dirty);
+
+}
+
+/**
+ * @brief Looks for the newest valid record within the journal
+ *
+ * The slot with the highest sequence number is checked first. Only if its
+ * CRC doesn't match, the next older one is checked, and so on. Erased slots
+ * are rejected, as their sizes wouldn't fit into a slot.
+ *
+ * @param o_header Pointer to store the header of the record at
+ *
+ * @return Slot containing the newest valid record, PREFS_NO_SLOT if none
+ */
+static uint8_t prefs_find_newest(prefs_header_t* o_header)
+{
+
+    uint16_t rejected = 0;
+
+    while (true) {
+
+        uint8_t newest = PREFS_NO_SLOT;
+        uint16_t newest_sequence = 0;
+
+        for (uint8_t slot = 0; slot < PREFS_JOURNAL_SLOTS; slot++) {
+
+            if (rejected & _BV(slot)) {
+
+                continue;
+
+            }
+
+            uint16_t sequence;
+
+            eeprom_get_block(&sequence,
+                &prefs_journal[slot][offsetof(prefs_header_t, sequence)],
+                sizeof(sequence));
+
+            if (newest == PREFS_NO_SLOT
+                    || (int16_t)(sequence - newest_sequence) > 0) {
+
+                newest = slot;
+                newest_sequence = sequence;
+
+            }
+
+        }
+
+        if (newest == PREFS_NO_SLOT) {
+
+            return PREFS_NO_SLOT;
+
+        }
+
+        eeprom_get_block(o_header, prefs_journal[newest], sizeof(prefs_header_t));
+
+        uint16_t length = prefs_get_crc_length(o_header->sizes);
+
+        if (length <= PREFERENCES_JOURNAL_SLOT_SIZE - offsetof(prefs_header_t, sequence)
+                && prefs_get_crc(newest, length) == o_header->crc) {
+
+            return newest;
+
+        }
+
+        rejected |= _BV(newest);
+
+    }
+
+}
+
+/**
+ * @brief Reads in the preferences from the given record
+ *
+ * When the sizes of the structures within the record match the current
+ * layout, the preferences are read as is. Otherwise the default values are
+ * used as a base, and each structure is carried over from the record up to
+ * the smaller of both sizes.
+ *
+ * @note This relies on prefs_t not containing any padding, which is the case
+ * for AVR targets.
+ *
+ * @param slot Slot containing the record
+ * @param header Header of the record
+ *
+ * @return False if the record was invalidated, see _factory_reset()
  */
-static prefs_t prefs;
+static bool prefs_load(uint8_t slot, const prefs_header_t* header)
+{
+
+    const uint8_t* src = &prefs_journal[slot][sizeof(prefs_header_t)];
+    uint16_t offset = 0;
+    version_t version;
+
+    for (uint8_t i = 0; i < PREFS_SECTION_COUNT; i++) {
+
+        offset += header->sizes[i];
+
+    }
+
+    eeprom_get_block(&version, src + offset, sizeof(version));
+
+    if (version == 0) {
+
+        return false;
+
+    }
+
+    if (memcmp(header->sizes, prefs_record.header.sizes, PREFS_SECTION_COUNT) == 0) {
+
+        eeprom_get_block(&prefs_record.prefs, src, sizeof(prefs_t));
+        prefs_slot_is_current = (version == VERSION);
+
+    } else {
+
+        uint8_t* dst = (uint8_t*)(&prefs_record.prefs);
+
+        memcpy_P(dst, &prefs_default, sizeof(prefs_t));
+
+        for (uint8_t i = 0; i < PREFS_SECTION_COUNT; i++) {
+
+            uint8_t size = prefs_record.header.sizes[i];
+
+            eeprom_get_block(dst, src, (header->sizes[i] < size) ? header->sizes[i] : size);
+
+            dst += size;
+            src += header->sizes[i];
+
+        }
+
+        prefs_slot_is_current = false;
+
+    }
+
+    prefs_record.prefs.version = VERSION;
+    prefs_record.prefs.prefs_size = sizeof(prefs_t);
+
+    return true;
+
+}
 
 /**
  * @brief Initializes this module
  *
  * This has to be called **before** any other functions of this module can be
- * used. It reads in the contents from the EEPROM into {@link #prefs SRAM} and
- * performs a basic integrity check consisting of:
+ * used. It looks for the newest valid record within the journal and reads it
+ * into {@link #prefs_record SRAM}, migrating it if necessary.
+ *
+ * When there is no valid record, the location used by older versions of the
+ * firmware is checked, which consists of:
  *
  * - Comparison of software version stored in EEPROM against VERSION
  * - Comparison of struct size stored in EEPROM against prefs_t::prefs_size
  *
- * When this check fails, the {@link #prefs_default default values} are used.
- * Otherwise the data from the EEPROM is considered to be valid and will end
- * up being used.
+ * When this check fails, or when the newest record was invalidated, the
+ * {@link #prefs_default default values} are used.
  *
+ * @see prefs_find_newest()
+ * @see prefs_load()
  * @see prefs_t::version
  * @see prefs_t::prefs_size
  */
 void preferences_init()
 {
 
-    eeprom_get_block(&prefs, &prefs_eeprom, sizeof(prefs_t));
+    prefs_header_t header;
+    bool valid;
+
+    memcpy_P(prefs_record.header.sizes, prefs_section_sizes, PREFS_SECTION_COUNT);
+
+    prefs_slot = prefs_find_newest(&header);
 
-    if ((prefs.version != VERSION) || (prefs.prefs_size != sizeof(prefs_t))) {
+    if (prefs_slot != PREFS_NO_SLOT) {
+
+        #if (LOG_PREFERENCES_INIT == 1)
+
+            uart_puts_P("Using record: ");
+            uart_putc('0' + prefs_slot);
+            uart_putc('\n');
+
+        #endif
+
+        prefs_record.header.sequence = header.sequence;
+        valid = prefs_load(prefs_slot, &header);
+
+    } else {
+
+        eeprom_get_block(&prefs_record.prefs, prefs_journal, sizeof(prefs_t));
+
+        valid = (prefs_record.prefs.version == VERSION)
+            && (prefs_record.prefs.prefs_size == sizeof(prefs_t));
+
+    }
+
+    if (!valid) {
 
         #if (LOG_PREFERENCES_INIT == 1)
 
@@ -116,7 +592,8 @@ void preferences_init()
 
         #endif
 
-        memcpy_P(&prefs, &prefs_default, sizeof(prefs_t));
+        memcpy_P(&prefs_record.prefs, &prefs_default, sizeof(prefs_t));
+        prefs_slot_is_current = false;
 
     }
 
@@ -124,13 +601,13 @@ void preferences_init()
 
         uart_puts_P("EEPROM: ");
 
-        uint8_t* ptr = (uint8_t*)(&prefs);
+        uint8_t* ptr = (uint8_t*)(&prefs_record.prefs);
 
         for (uint16_t i = 0; i < sizeof(prefs_t); i++) {
 
             char buf[3];
 
-            sprintf_P(buf, fmt_hex, *ptr++);
+            format_hex8(buf, *ptr++);
             uart_puts(buf);
 
         }
@@ -143,33 +620,45 @@ void preferences_init()
 /**
  * @brief Returns pointer to copy of the preferences hold in SRAM
  *
- * This returns a pointer to the {@link #prefs workign copy} of the
+ * This returns a pointer to the {@link #prefs_record working copy} of the
  * {@link #prefs_t preferences} hold in SRAM. It can be used to access and
  * manipulate the preferences. Once data has been changed,
  * {@link preferences_save()} needs to be invoked in order to write the changes
  * to EEPROM.
  *
- * @return Reference to prefs
+ * @return Reference to the preferences within prefs_record
  *
- * @see prefs
+ * @see prefs_record
  * @see preferences_save()
  */
 prefs_t* preferences_get()
 {
 
-    return &prefs;
+    return &prefs_record.prefs;
 
 }
 
 /**
  * @brief Saves manipulated preferences by writing it back to the EEPROM
  *
- * This initiates the writeback to the EEPROM. Essentially it is only a wrapper
- * around {@link eeprom_put_block()}.
+ * This initiates the writeback to the EEPROM. Unless the preferences are
+ * identical to the newest record, a new record is written into the next
+ * slot. Only those parts of the slot that actually differ are written (see
+ * {@link #prefs_dirty}). This is done asynchronously, so this returns long
+ * before the data has actually been written. The record is committed by
+ * preferences_handle() afterwards. {@link #preferences_save_completed()} can
+ * be used to poll for the completion.
  *
- * @return True if preferences were saved successfully, false otherwise
+ * @note In case a previous writeback is still in progress, this waits for it
+ * to be completed first. If the EEPROM is busy otherwise, the writeback is
+ * kept pending and started by preferences_handle() later on.
  *
- * @see prefs
+ * @return True, as the writeback is always initiated
+ *
+ * @see prefs_record
+ * @see prefs_dirty
+ * @see preferences_handle()
+ * @see preferences_save_completed()
  */
 bool preferences_save()
 {
@@ -180,9 +669,125 @@ bool preferences_save()
 
     #endif
 
-    eeprom_put_block(&prefs, &prefs_eeprom, sizeof(prefs_t));
+    while (!preferences_save_completed());
+
+    if (prefs_slot != PREFS_NO_SLOT && prefs_slot_is_current
+            && !eeprom_get_dirty_map(&prefs_record.prefs,
+            &prefs_journal[prefs_slot][sizeof(prefs_header_t)], sizeof(prefs_t),
+            prefs_dirty)) {
+
+        return true;
+
+    }
+
+    uint8_t slot = 0;
+
+    if (prefs_slot != PREFS_NO_SLOT && prefs_slot + 1 < PREFS_JOURNAL_SLOTS) {
+
+        slot = prefs_slot + 1;
+
+    }
+
+    prefs_record.header.sequence++;
+
+    prefs_pending_slot = slot;
+    prefs_queue();
 
-    // TODO: Check whether data was actually written successfully
     return true;
 
 }
+
+/**
+ * @brief Returns whether the last writeback has been completed
+ *
+ * This also commits the record written by the last writeback, if that
+ * hasn't happened yet, so it can be polled directly.
+ *
+ * @return True if there is no writeback in progress, false otherwise
+ *
+ * @see preferences_save()
+ * @see preferences_handle()
+ */
+bool preferences_save_completed()
+{
+
+    preferences_handle();
+
+    return (prefs_pending_slot == PREFS_NO_SLOT) && !eeprom_is_busy();
+
+}
+
+/**
+ * @brief Commits the record written by the last writeback
+ *
+ * A record that couldn't be queued by preferences_save(), as the EEPROM was
+ * busy, is queued from here. Once it has been written completely, it is read
+ * back and compared against the preferences. If it matches, its CRC is
+ * calculated from the content of the EEPROM and written into its header in
+ * the background. From then on the record is considered to be the newest
+ * one.
+ *
+ * If the preferences were changed while the record was being written, the
+ * differing blocks are written once again. Otherwise the record is left
+ * uncommitted, so the previous one remains in use, and the failure is
+ * counted (see HEALTH_PREFS_ERRORS). The next save will write a new record.
+ *
+ * This needs to be called on a regular basis, see `EVENT_TIMER`.
+ *
+ * @see prefs_queue()
+ * @see prefs_get_crc()
+ * @see prefs_pending_slot
+ */
+void preferences_handle()
+{
+
+    if (prefs_pending_slot == PREFS_NO_SLOT || eeprom_is_busy()) {
+
+        return;
+
+    }
+
+    if (!prefs_pending_queued) {
+
+        prefs_queue();
+
+        return;
+
+    }
+
+    uint8_t slot = prefs_pending_slot;
+
+    const uint8_t* src = (const uint8_t*)(&prefs_record) + offsetof(prefs_header_t, sequence);
+    const uint8_t* dst = &prefs_journal[slot][offsetof(prefs_header_t, sequence)];
+    size_t length = sizeof(prefs_record_t) - offsetof(prefs_header_t, sequence);
+
+    // Verify the record before it is committed
+    if (eeprom_get_dirty_map(src, dst, length, prefs_dirty)) {
+
+        if (prefs_get_sram_crc(length) != prefs_pending_crc) {
+
+            prefs_queue();
+
+            return;
+
+        }
+
+        prefs_pending_slot = PREFS_NO_SLOT;
+        health_count(HEALTH_PREFS_ERRORS);
+
+        return;
+
+    }
+
+    prefs_pending_slot = PREFS_NO_SLOT;
+
+    prefs_record.header.crc = prefs_get_crc(slot,
+        prefs_get_crc_length(prefs_record.header.sizes));
+
+    eeprom_put_block_async(&prefs_record.header.crc, prefs_journal[slot],
+        sizeof(prefs_record.header.crc), &prefs_crc_dirty);
+
+    prefs_slot = slot;
+    prefs_slot_is_current = true;
+
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file presence.c
+ * @brief Implementation of the header declared in presence.h
+ *
+ * The pin change interrupt of the input is used, so motion is noticed right
+ * away, even while the microcontroller is sleeping. Only the edges entering
+ * PRESENCE_ACTIVE_LEVEL post `EVENT_PRESENCE`, the level itself is polled by
+ * the user module once a second by means of presence_is_active().
+ *
+ * @see presence.h
+ */
+
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "event.h"
+#include "ports.h"
+#include "presence.h"
+
+#if (ENABLE_PRESENCE_SUPPORT == 1)
+
+#if (ENABLE_BLUETOOTH_SUPPORT == 1)
+
+    #error "The presence input occupies the pin of USER_BLUETOOTH"
+
+#endif /* (ENABLE_BLUETOOTH_SUPPORT == 1) */
+
+/**
+ * @brief Port and pin of the motion sensor connection
+ *
+ * This is the pin otherwise used by USER_BLUETOOTH, as port B and D are
+ * fully occupied and the pin change interrupt of port B is already shared
+ * between the IR and DCF77 inputs.
+ *
+ * @see ports.h
+ */
+#define PRESENCE_INPUT PORTC, 1
+
+/**
+ * @brief Pin change mask register of the motion sensor connection
+ *
+ * @note This needs to match the port defined in PRESENCE_INPUT. The bit
+ * within the register is the same as the one within the port.
+ *
+ * @see PRESENCE_INPUT
+ */
+#define PRESENCE_INPUT_PCMSK PCMSK1
+
+/**
+ * @brief Pin change interrupt enable bit of the motion sensor connection
+ *
+ * @see PRESENCE_INPUT
+ */
+#define PRESENCE_INPUT_PCIE PCIE1
+
+/**
+ * @brief Pin change interrupt vector of the motion sensor connection
+ *
+ * @see PRESENCE_INPUT
+ */
+#define PRESENCE_INPUT_PCINT_vect PCINT1_vect
+
+/**
+ * @brief Initializes this module
+ *
+ * This configures the pin as input without pull-up, as the sensor drives it
+ * actively, and enables the pin change interrupt.
+ *
+ * @see ISR(PRESENCE_INPUT_PCINT_vect)
+ */
+void presence_init()
+{
+
+    DDR(PRESENCE_INPUT) &= ~_BV(BIT(PRESENCE_INPUT));
+    PORT(PRESENCE_INPUT) &= ~_BV(BIT(PRESENCE_INPUT));
+
+    PRESENCE_INPUT_PCMSK |= _BV(BIT(PRESENCE_INPUT));
+    PCICR |= _BV(PRESENCE_INPUT_PCIE);
+
+}
+
+/**
+ * @brief Returns whether the sensor currently detects motion
+ *
+ * @return True if the input is at PRESENCE_ACTIVE_LEVEL, false otherwise
+ *
+ * @see PRESENCE_ACTIVE_LEVEL
+ */
+bool presence_is_active()
+{
+
+    return ((PIN(PRESENCE_INPUT) & _BV(BIT(PRESENCE_INPUT))) ? 1 : 0) == PRESENCE_ACTIVE_LEVEL;
+
+}
+
+/**
+ * @brief Interrupt service routine posting `EVENT_PRESENCE` on motion
+ *
+ * This is executed on both edges of the input, but only the edge entering
+ * PRESENCE_ACTIVE_LEVEL is of interest.
+ *
+ * @see presence_is_active()
+ * @see user_presence_detected()
+ */
+ISR(PRESENCE_INPUT_PCINT_vect)
+{
+
+    if (presence_is_active()) {
+
+        event_post(EVENT_PRESENCE);
+
+    }
+
+}
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
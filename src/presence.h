@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file presence.h
+ * @brief Header for detecting presence by means of a motion sensor
+ *
+ * A motion sensor (e.g. a PIR module with a digital output) is connected to
+ * PRESENCE_INPUT. Each time it detects motion, `EVENT_PRESENCE` is posted from
+ * within the pin change interrupt, so the display can be turned back on right
+ * away. The user module turns the display off once no motion has been
+ * detected for the timeout configured in user_prefs_t::presenceTimeout.
+ *
+ * @see presence.c
+ * @see user_presence_detected()
+ */
+
+#ifndef _WC_PRESENCE_H_
+#define _WC_PRESENCE_H_
+
+#include <stdbool.h>
+
+#include "config.h"
+
+/**
+ * @brief Level of the input while the sensor detects motion
+ *
+ * Most PIR modules drive their output high for a couple of seconds once
+ * motion has been detected.
+ *
+ * @see presence_is_active()
+ */
+#define PRESENCE_ACTIVE_LEVEL 1
+
+/**
+ * @brief Default timeout in minutes before the display is turned off
+ *
+ * A value of zero disables the timeout, so the display is never turned off
+ * due to the absence of motion.
+ *
+ * @see user_prefs_t::presenceTimeout
+ */
+#define PRESENCE_TIMEOUT_DEFAULT_MIN 15
+
+#if (ENABLE_PRESENCE_SUPPORT == 1)
+
+    extern void presence_init();
+
+    extern bool presence_is_active();
+
+#else
+
+    /**
+     * @brief Empty macro in case presence support is disabled
+     *
+     * @see ENABLE_PRESENCE_SUPPORT
+     */
+    #define presence_init()
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
+#endif /* _WC_PRESENCE_H_ */
@@ -22,16 +22,20 @@
  * @file prng.c
  * @brief Implementation of the header declared in prng.h
  *
- * This module is based upon a concept known as Linear congruential generator,
- * refer to [1] for details. It is based upon Simon Küppers code posted at [2].
- * However, the posted version contains a bug in regards to the multiplier that
- * renders it quite useless. This implementation fixes it by using a different
- * multiplier, which is justified by [3]. The periodicity of this PRNG is 256,
- * which is exactly the width of the data types used internally.
+ * This module is based upon the xorshift generators described by George
+ * Marsaglia, refer to [1] for details. It makes use of the 32 bit variant
+ * with the shift triple (13, 17, 5), which has a period of 2^32 - 1. Unlike
+ * the linear congruential generator used previously, the low bits don't have
+ * a shorter period than the high ones, so each of the four bytes of a
+ * generated word can be used.
  *
- * [1]: https://en.wikipedia.org/wiki/Linear_congruential_generator
- * [2]: http://www.mikrocontroller.net/topic/112114#998347
- * [3]: https://www.mikrocontroller.net/topic/112114#998667
+ * The state itself is put into the `.noinit` section, so it is neither lost
+ * across a watchdog and/or external reset, nor initialized with a constant
+ * value after powering up. prng_init() additionally folds some more of the
+ * uninitialized SRAM into it, while the LDR module contributes the noise of
+ * some ADC conversions by means of prng_add_entropy().
+ *
+ * [1]: https://www.jstatsoft.org/v08/i14/paper
  *
  * @see prng.h
  */
@@ -39,73 +43,154 @@
 #include "prng.h"
 
 /**
- * @brief Multiplier used for calculating the next random number
+ * @brief Number of bytes of uninitialized SRAM folded into the state
  *
- * @see PRNG_INCREMENT
- * @see prng_rand()
+ * @see prng_noinit
+ * @see prng_init()
  */
-#define PRNG_MULTIPLIER 17
+#define PRNG_NOINIT_SIZE 16
 
 /**
- * @brief Summand used for calculating the next random number
+ * @brief Uninitialized SRAM used as source of entropy after powering up
  *
- * @see PRNG_MULTIPLIER
- * @see prng_rand()
+ * The content of SRAM is more or less random after powering up. This is
+ * never written to, it is only read once by prng_init().
+ *
+ * @see prng_init()
  */
-#define PRNG_INCREMENT 37
+static uint8_t prng_noinit[PRNG_NOINIT_SIZE] __attribute__ ((section(".noinit")));
 
 /**
- * @brief Last generated random number and/or seed value
+ * @brief Current state of the generator
  *
- * This contains either the last random number generated by `prng_rand()`
- * and/or the seed value set by `prng_set_seed()`.
+ * This is never allowed to become zero, as the generator would only be
+ * returning zeros from then on.
  *
- * In either case it is used as the basis for the next random number requested
- * by `prng_rand()`.
+ * @see prng_next()
+ * @see prng_init()
+ */
+static uint32_t prng_state __attribute__ ((section(".noinit")));
+
+/**
+ * @brief Advances the state of the generator
  *
- * @see prng_set_seed()
- * @see prng_rand()
+ * @return The new state, all of its bytes can be used as random numbers
+ *
+ * @see prng_state
  */
-static uint8_t seed = 1;
+static uint32_t prng_next()
+{
+
+    uint32_t x = prng_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    prng_state = x;
+
+    return x;
+
+}
 
 /**
- * @brief Sets the seed value
+ * @brief Mixes the given value into the state
  *
- * This sets the seed value, which the next requested random number will be
- * based upon.
+ * This can be invoked any number of times with values that are (at least
+ * partially) random, e.g. the least significant bits of an ADC conversion.
+ * The state is advanced afterwards, so equal values don't cancel each other
+ * out.
  *
- * @param value The seed value you want to set
+ * @warning This is not meant to be invoked from within an ISR, as the state
+ * is not accessed atomically.
  *
- * @see seed
- * @see prng_rand()
+ * @param value The value to mix into the state
+ *
+ * @see prng_state
+ * @see ldr_init()
  */
-void prng_set_seed(uint8_t value)
+void prng_add_entropy(uint8_t value)
 {
 
-    seed = value;
+    prng_state = (prng_state << 8 | prng_state >> 24) ^ value;
+
+    if (prng_state == 0) {
+
+        prng_state = 1;
+
+    }
+
+    prng_next();
 
 }
 
 /**
- * @brief Returns a pseudo random number
+ * @brief Initializes this module
  *
- * The pseudo random number is generated by a simple calculation based upon
- * the current value of `seed`, `PRNG_MULTIPLIER` and `PRNG_INCREMENT`.
+ * This folds the uninitialized SRAM (see prng_noinit) into the state, which
+ * itself is not initialized either. It has to be called **once** before any
+ * other function of this module, in particular before prng_add_entropy() is
+ * invoked by other modules during their initialization.
  *
- * @note The modulo 256 operation is done implicitly as the data type is
- * uint8_t.
+ * @see prng_noinit
+ * @see prng_add_entropy()
+ */
+void prng_init()
+{
+
+    for (uint8_t i = 0; i < PRNG_NOINIT_SIZE; i++) {
+
+        prng_add_entropy(prng_noinit[i]);
+
+    }
+
+}
+
+/**
+ * @brief Returns a pseudo random number
+ *
+ * This advances the state of the generator and returns its least
+ * significant byte. When many numbers are needed at once, prng_fill() is
+ * cheaper, as it makes use of all bytes of the state.
  *
  * @return The next pseudo random number
  *
- * @see seed
- * @see PRNG_MULTIPLIER
- * @see PRNG_INCREMENT
+ * @see prng_next()
+ * @see prng_fill()
  */
 uint8_t prng_rand()
 {
 
-    seed = (seed * PRNG_MULTIPLIER) + PRNG_INCREMENT;
+    return prng_next();
+
+}
+
+/**
+ * @brief Fills the given buffer with pseudo random numbers
+ *
+ * The generator is advanced once for every four bytes, so this is about four
+ * times as fast as invoking prng_rand() for each of them.
+ *
+ * @param buffer Pointer to the buffer to fill
+ * @param count Number of bytes to put into the buffer
+ *
+ * @see prng_next()
+ * @see prng_rand()
+ */
+void prng_fill(uint8_t* buffer, uint8_t count)
+{
+
+    while (count) {
+
+        uint32_t x = prng_next();
+
+        for (uint8_t i = 0; i < sizeof(x) && count; i++, count--) {
+
+            *buffer++ = x;
+            x >>= 8;
+
+        }
 
-    return seed;
+    }
 
 }
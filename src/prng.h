@@ -27,6 +27,10 @@
  * smaller, as it doesn't fulfill the requirements of `<stdlib.h>` and is
  * restricted to `uint8_t`.
  *
+ * The generator is seeded from the uninitialized SRAM (`.noinit`) as well as
+ * the noise of the ADC, so clocks don't play identical sequences after each
+ * boot. prng_fill() can be used to draw many numbers at once.
+ *
  * @see prng.c
  */
 
@@ -35,8 +39,12 @@
 
 #include <stdint.h>
 
-extern void prng_set_seed(uint8_t value);
+extern void prng_init();
+
+extern void prng_add_entropy(uint8_t value);
 
 extern uint8_t prng_rand();
 
+extern void prng_fill(uint8_t* buffer, uint8_t count);
+
 #endif /* _WC_PRNG_H_ */
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file profile.c
+ * @brief Implementation of the header declared in profile.h
+ *
+ * The measurements are stored within profile_data and updated from within
+ * the ISRs themselves, i.e. with interrupts disabled. Reading and resetting
+ * the data from within the main loop is done atomically.
+ *
+ * @see profile.h
+ */
+
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "profile.h"
+
+#if (ENABLE_DEBUG_ISR_PROFILE == 1)
+
+    /**
+     * @brief Shift applied to the average of the measurements
+     *
+     * The average is stored with this amount of fractional bits, which also
+     * determines its weight (1 / 2^n).
+     *
+     * @see profile_record()
+     */
+    #define PROFILE_MEAN_SHIFT 4
+
+    /**
+     * @brief Data collected for each of the ISRs
+     *
+     * The `mean` member is stored with PROFILE_MEAN_SHIFT fractional bits here.
+     *
+     * @see e_profileIsr
+     * @see profile_record()
+     */
+    static profile_t profile_data[PROFILE_ISR_COUNT];
+
+    /**
+     * @brief Records a single measurement for the given ISR
+     *
+     * This is not meant to be called directly, use PROFILE_ISR_EXIT() instead.
+     *
+     * The counter of Timer/Counter1 wraps around once it reaches `ICR1`, which is
+     * taken into account when calculating the duration.
+     *
+     * @param isr ISR to record the measurement for
+     * @param entry Value of `TCNT1` when entering the ISR
+     * @param exit Value of `TCNT1` when leaving the ISR
+     * @param overrun True if an overrun was detected, false otherwise
+     *
+     * @see PROFILE_ISR_EXIT()
+     */
+    void profile_record(e_profileIsr isr, uint16_t entry, uint16_t exit, bool overrun)
+    {
+
+        profile_t* profile = &profile_data[isr];
+        uint16_t duration = exit - entry;
+
+        if (exit < entry) {
+
+            duration += ICR1 + 1;
+
+        }
+
+        if (profile->min == 0 || duration < profile->min) {
+
+            profile->min = duration;
+
+        }
+
+        if (duration > profile->max) {
+
+            profile->max = duration;
+
+        }
+
+        profile->mean += duration - (profile->mean >> PROFILE_MEAN_SHIFT);
+
+        if (overrun && profile->overruns != UINT16_MAX) {
+
+            profile->overruns++;
+
+        }
+
+    }
+
+    /**
+     * @brief Retrieves the data collected for the given ISR
+     *
+     * @param isr ISR to retrieve the data for
+     * @param o_profile Pointer to store the data at
+     *
+     * @return True if the data could be retrieved, false if isr is invalid
+     */
+    bool profile_get(e_profileIsr isr, profile_t* o_profile)
+    {
+
+        if (isr >= PROFILE_ISR_COUNT) {
+
+            return false;
+
+        }
+
+        uint8_t sreg = SREG;
+        cli();
+        *o_profile = profile_data[isr];
+        SREG = sreg;
+
+        o_profile->mean >>= PROFILE_MEAN_SHIFT;
+
+        return true;
+
+    }
+
+    /**
+     * @brief Resets the data collected for all ISRs
+     */
+    void profile_reset()
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+
+        for (uint8_t i = 0; i < PROFILE_ISR_COUNT; i++) {
+
+            profile_data[i] = (profile_t){0, 0, 0, 0};
+
+        }
+
+        SREG = sreg;
+
+    }
+
+#endif /* (ENABLE_DEBUG_ISR_PROFILE == 1) */
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file profile.h
+ * @brief Provides means to measure the execution time of ISRs
+ *
+ * This module allows to measure how long the various ISRs take to execute.
+ * The counter of Timer/Counter1 (`TCNT1`), which is running at F_CPU, is used
+ * as timestamp, so the measured durations are actual CPU cycles.
+ *
+ * Each ISR to be profiled needs to invoke PROFILE_ISR_ENTER() at the very
+ * beginning and PROFILE_ISR_EXIT() at the very end. The collected data can be
+ * retrieved by means of profile_get().
+ *
+ * This module is only available when ENABLE_DEBUG_ISR_PROFILE is set to 1.
+ * Otherwise the macros mentioned above will expand to nothing, so there is no
+ * overhead at all.
+ *
+ * @note As Timer/Counter1 is reset with a frequency of F_INTERRUPT (see
+ * timer.c) durations longer than one timer period (100 us, or 1 ms with
+ * IR_USE_EDGE_CAPTURE enabled) cannot be measured correctly. This should,
+ * however, never happen anyway.
+ *
+ * @see ENABLE_DEBUG_ISR_PROFILE
+ * @see profile.c
+ */
+
+#ifndef _WC_PROFILE_H_
+#define _WC_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "config.h"
+
+/**
+ * @brief Enumeration of all ISRs that can be profiled
+ *
+ * @see profile_get()
+ */
+typedef enum {
+
+    PROFILE_ISR_TIMER,
+    PROFILE_ISR_DISPLAY,
+    PROFILE_ISR_ADC,
+    PROFILE_ISR_USART_RX,
+    PROFILE_ISR_USART_UDRE,
+
+    PROFILE_ISR_COUNT
+
+} e_profileIsr;
+
+/**
+ * @brief Data collected for a single ISR
+ *
+ * All durations are given in CPU cycles.
+ *
+ * @see profile_get()
+ */
+typedef struct {
+
+    /**
+     * @brief Shortest execution time measured so far
+     */
+    uint16_t min;
+
+    /**
+     * @brief Longest execution time measured so far
+     */
+    uint16_t max;
+
+    /**
+     * @brief Average execution time
+     *
+     * This is an exponential moving average with a weight of 1/16 for each
+     * new measurement.
+     */
+    uint16_t mean;
+
+    /**
+     * @brief Number of overruns
+     *
+     * An overrun is detected when the interrupt condition of the ISR was
+     * triggered once again before it could finish, e.g. when the timer has
+     * already reached the next tick. This saturates at `UINT16_MAX`.
+     */
+    uint16_t overruns;
+
+} profile_t;
+
+#if (ENABLE_DEBUG_ISR_PROFILE == 1)
+
+    /**
+     * @brief Marks the entry of an ISR
+     *
+     * This takes a timestamp and should be placed at the very beginning of
+     * the ISR to be profiled.
+     *
+     * @see PROFILE_ISR_EXIT()
+     */
+    #define PROFILE_ISR_ENTER() const uint16_t _profile_entry = TCNT1
+
+    /**
+     * @brief Marks the exit of an ISR
+     *
+     * This takes another timestamp and records the duration since
+     * PROFILE_ISR_ENTER() for the given ISR.
+     *
+     * @param isr ISR to record the measurement for, see e_profileIsr
+     * @param overrun Expression that evaluates to true in case of an overrun
+     *
+     * @see PROFILE_ISR_ENTER()
+     * @see profile_record()
+     */
+    #define PROFILE_ISR_EXIT(isr, overrun) \
+        profile_record((isr), _profile_entry, TCNT1, (overrun))
+
+    extern void profile_record(e_profileIsr isr, uint16_t entry, uint16_t exit, bool overrun);
+
+    extern bool profile_get(e_profileIsr isr, profile_t* o_profile);
+
+    extern void profile_reset();
+
+#else
+
+    #define PROFILE_ISR_ENTER()
+    #define PROFILE_ISR_EXIT(isr, overrun)
+
+#endif /* (ENABLE_DEBUG_ISR_PROFILE == 1) */
+
+#endif /* _WC_PROFILE_H_ */
@@ -43,8 +43,8 @@
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/pgmspace.h>
+#include <avr/interrupt.h>
 #include <stdbool.h>
-#include <stdio.h>
 #include "preferences.h"
 
 #include "uart.h"
@@ -74,7 +74,101 @@
  */
 #define PWM_BLUE PORTD, 3
 
-#if (MAX_PWM_STEPS == 32)
+#if (PWM_DITHER == 1)
+
+    #if (PWM_DITHER_BITS < 1) || (PWM_DITHER_BITS > 4)
+
+        #error "PWM_DITHER_BITS needs to be between 1 and 4"
+
+    #endif
+
+    /**
+     * @brief Type of brightness values including the fractional bits
+     *
+     * @see PWM_LEVEL_SHIFT
+     */
+    typedef uint16_t pwm_level_t;
+
+    /**
+     * @brief Number of fractional bits of pwm_level_t
+     *
+     * @see PWM_DITHER_BITS
+     */
+    #define PWM_LEVEL_SHIFT PWM_DITHER_BITS
+
+#else
+
+    /**
+     * @copydoc pwm_level_t
+     */
+    typedef uint8_t pwm_level_t;
+
+    /**
+     * @copydoc PWM_LEVEL_SHIFT
+     */
+    #define PWM_LEVEL_SHIFT 0
+
+#endif /* (PWM_DITHER == 1) */
+
+/**
+ * @brief Mask of the fractional bits of pwm_level_t
+ *
+ * @see PWM_LEVEL_SHIFT
+ */
+#define PWM_LEVEL_FRACTION_MASK (_BV(PWM_LEVEL_SHIFT) - 1)
+
+#if (PWM_DITHER == 1)
+
+    #if (MAX_PWM_STEPS == 32)
+
+        /**
+         * @brief Table containing predefined values used to generate PWM signal
+         *
+         * This table contains 32 values with four fractional bits, which are
+         * spaced logarithmically from 1 to 255, so each step is about 20 %
+         * brighter than the previous one all the way down.
+         *
+         * @see PWM_DITHER
+         * @see pwm_read_table()
+         */
+        const uint16_t pwm_table[MAX_PWM_STEPS] PROGMEM =
+            {16, 19, 23, 27, 33, 39, 47, 56, 67, 80, 96, 114, 137, 163, 195,
+            234, 279, 334, 399, 478, 571, 683, 817, 976, 1167, 1396, 1669,
+            1996, 2387, 2854, 3412, 4080};
+
+    #elif (MAX_PWM_STEPS == 64)
+
+        /**
+         * @copydoc pwm_table
+         *
+         * Contains 64 predefined values, each step being about 9 % brighter
+         * than the previous one.
+         */
+        const uint16_t pwm_table[MAX_PWM_STEPS] PROGMEM =
+            {16, 17, 19, 21, 23, 25, 27, 30, 32, 35, 39, 42, 46, 50, 55, 60,
+            65, 71, 78, 85, 93, 101, 111, 121, 132, 144, 158, 172, 188, 205,
+            224, 245, 267, 292, 318, 348, 380, 414, 453, 494, 540, 589, 643,
+            703, 767, 838, 915, 999, 1091, 1191, 1300, 1420, 1550, 1693, 1849,
+            2019, 2204, 2407, 2628, 2870, 3134, 3422, 3736, 4080};
+
+    #else
+
+        #error Unknown PWM step size
+
+    #endif
+
+    /**
+     * @brief Reads the given entry of pwm_table as pwm_level_t
+     *
+     * The table is given with four fractional bits, so superfluous ones are
+     * dropped.
+     *
+     * @see pwm_table
+     */
+    #define pwm_read_table(idx) \
+        (pgm_read_word(&pwm_table[idx]) >> (4 - PWM_DITHER_BITS))
+
+#elif (MAX_PWM_STEPS == 32)
 
     /**
      * @brief Table containing predefined values used to generate PWM signal
@@ -110,6 +204,49 @@
 
 #endif
 
+#if (PWM_DITHER == 0)
+
+    /**
+     * @copydoc pwm_read_table
+     */
+    #define pwm_read_table(idx) pgm_read_byte(&pwm_table[idx])
+
+#endif /* (PWM_DITHER == 0) */
+
+#if (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_GAMMA == 1)
+
+    /**
+     * @brief Table mapping the channels of a color to gamma corrected values
+     *
+     * The values are calculated by `255 * (i / 255) ^ 2.2`.
+     *
+     * @see PWM_COLOR_GAMMA
+     * @see pwm_scale()
+     */
+    const uint8_t pwm_gamma_table[256] PROGMEM = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2,
+        2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5,
+        5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9,
+        9, 9, 10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14,
+        15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 22,
+        22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29, 30, 30,
+        31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 39, 39, 40, 41,
+        42, 43, 43, 44, 45, 46, 47, 48, 49, 49, 50, 51, 52, 53,
+        54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67,
+        68, 69, 70, 71, 73, 74, 75, 76, 77, 78, 79, 81, 82, 83,
+        84, 85, 87, 88, 89, 90, 91, 93, 94, 95, 97, 98, 99, 100,
+        102, 103, 105, 106, 107, 109, 110, 111, 113, 114, 116, 117, 119, 120,
+        121, 123, 124, 126, 127, 129, 130, 132, 133, 135, 137, 138, 140, 141,
+        143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161, 163, 165,
+        166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+        192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217,
+        219, 221, 223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246,
+        248, 251, 253, 255
+    };
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_GAMMA == 1) */
+
 /**
  * @brief Indicates whether the PWM generation is currently turned on
  *
@@ -142,11 +279,27 @@ static uint8_t base_pwm_idx;
  * is also possible to lock the brightness to a specific value using
  * `pwm_lock_brightness_val()`.
  *
+ * If `PWM_RAMP` is enabled, this is moved towards `brightness_pwm_target` by
+ * `pwm_ISR()`. If `PWM_DITHER` is enabled, this includes the fractional bits
+ * (see `PWM_LEVEL_SHIFT`), so it needs to be accessed atomically.
+ *
  * @see pwm_table
  * @see base_pwm_idx
  * @see offset_pwm_idx
  */
-static uint8_t brightness_pwm_val;
+static volatile pwm_level_t brightness_pwm_val;
+
+#if (PWM_RAMP == 1)
+
+    /**
+     * @brief Brightness value the ramp is currently heading for
+     *
+     * @see brightness_pwm_val
+     * @see pwm_ISR()
+     */
+    static volatile pwm_level_t brightness_pwm_target;
+
+#endif /* (PWM_RAMP == 1) */
 
 /**
  * @brief Indicates whether brightness is currently locked
@@ -198,6 +351,54 @@ static bool brightness_lock;
  */
 static uint8_t base_ldr_idx;
 
+#if (PWM_AUTO_LEARN == 1)
+
+    #if ((24 % PWM_AUTO_LEARN_SLOTS) != 0)
+
+        #error "PWM_AUTO_LEARN_SLOTS needs to be a divisor of 24"
+
+    #endif
+
+    /**
+     * @brief Slot of the day currently in effect
+     *
+     * This is `PWM_AUTO_LEARN_SLOTS` until the time has been set by
+     * `pwm_set_hour()` for the first time.
+     *
+     * @see pwm_set_hour()
+     */
+    static uint8_t pwm_learn_slot = PWM_AUTO_LEARN_SLOTS;
+
+    /**
+     * @brief Returns the learned offset of the current slot
+     *
+     * @see pwm_prefs_t::learnedOffset
+     * @see pwm_learn_slot
+     */
+    static int8_t pwm_learned_offset()
+    {
+
+        if (pwm_learn_slot < PWM_AUTO_LEARN_SLOTS) {
+
+            return preferences_get()->pwm_prefs.learnedOffset[pwm_learn_slot];
+
+        }
+
+        return 0;
+
+    }
+
+#else
+
+    /**
+     * @brief Replacement in case corrections are not learned
+     *
+     * @see PWM_AUTO_LEARN
+     */
+    #define pwm_learned_offset() 0
+
+#endif /* (PWM_AUTO_LEARN == 1) */
+
 #if (ENABLE_RGB_SUPPORT == 1)
 
     /**
@@ -213,16 +414,331 @@ static uint8_t base_ldr_idx;
      */
     static color_rgb_t pwm_color;
 
+    /**
+     * @brief Number of channels driven by the PWM signal
+     */
+    #define PWM_CHANNELS 3
+
+#else
+
+    /**
+     * @copydoc PWM_CHANNELS
+     */
+    #define PWM_CHANNELS 1
+
 #endif /* (ENABLE_RGB_SUPPORT == 1) */
 
+#if (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1)
+
+    /**
+     * @brief Color the current fade is heading for
+     *
+     * This is the color most recently passed to `pwm_set_color()` or
+     * `pwm_fade_color()`, which is what `pwm_get_color()` returns, even while
+     * `pwm_color` is still on its way.
+     *
+     * @see pwm_fade_color()
+     * @see pwm_get_color()
+     */
+    static color_rgb_t pwm_color_target;
+
+    /**
+     * @brief Current value of each channel while fading (8.8 fixed point)
+     *
+     * The integer part is what is stored within `pwm_color`.
+     *
+     * @see pwm_fade_step()
+     */
+    static uint16_t pwm_fade_value[3];
+
+    /**
+     * @brief Increment of each channel per step (8.8 fixed point)
+     *
+     * @see pwm_fade_step()
+     */
+    static int16_t pwm_fade_increment[3];
+
+    /**
+     * @brief Number of steps left until the fade is completed
+     *
+     * Zero means that there is no fade in progress.
+     *
+     * @see pwm_fade_step()
+     */
+    static volatile uint8_t pwm_fade_steps;
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1) */
+
+#if (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1)
+
+    /**
+     * @brief Values for the OCR registers to be applied with the next BOTTOM
+     *
+     * The values are calculated by `pwm_apply()` and written to the registers
+     * by `ISR(TIMER0_OVF_vect)`, in the order red (OCR0A), green (OCR0B) and
+     * blue (OCR2B).
+     *
+     * @see pwm_apply()
+     * @see ISR(TIMER0_OVF_vect)
+     */
+    static volatile uint8_t pwm_ocr[PWM_CHANNELS];
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1) */
+
+#if (PWM_DITHER == 1)
+
+    /**
+     * @brief Fractional part of the values within pwm_ocr
+     *
+     * @see pwm_ocr
+     * @see pwm_dither()
+     */
+    static volatile uint8_t pwm_fraction[PWM_CHANNELS];
+
+    /**
+     * @brief Accumulated fraction of each channel not yet output
+     *
+     * This is only accessed by `ISR(TIMER0_OVF_vect)`.
+     *
+     * @see pwm_dither()
+     */
+    static uint8_t pwm_dither_error[PWM_CHANNELS];
+
+    /**
+     * @brief Returns the OCR value of the given channel for the next period
+     *
+     * The fraction of the channel is accumulated with each period. Whenever
+     * the accumulated error exceeds a whole step, the next higher duty cycle
+     * is output for a single period and the step is subtracted again. This
+     * way the fraction is met on average and the error is spread as evenly
+     * as possible, e.g. a fraction of 1/2 alternates with every period.
+     *
+     * @param channel The channel, index within pwm_ocr
+     *
+     * @return The value to write into the appropriate OCR register
+     *
+     * @see pwm_fraction
+     * @see pwm_dither_error
+     */
+    static inline uint8_t pwm_dither(uint8_t channel)
+    {
+
+        uint8_t ocr = pwm_ocr[channel];
+        uint8_t error = pwm_dither_error[channel] + pwm_fraction[channel];
+
+        if (error & _BV(PWM_LEVEL_SHIFT)) {
+
+            error &= PWM_LEVEL_FRACTION_MASK;
+
+            /*
+             * The registers are used in inverting mode
+             */
+            ocr--;
+
+        }
+
+        pwm_dither_error[channel] = error;
+
+        return ocr;
+
+    }
+
+#endif /* (PWM_DITHER == 1) */
+
+#if (ENABLE_RGB_SUPPORT == 1)
+
+    /**
+     * @brief Scales a channel of a color by the current brightness
+     *
+     * This is equivalent to `(brightness_pwm_val + 1) * value / 256`, but only
+     * involves a single 8 bit multiplication. If `PWM_COLOR_GAMMA` is enabled,
+     * the value is gamma corrected beforehand by means of `pwm_gamma_table`.
+     * If `PWM_DITHER` is enabled, the fractional bits are kept.
+     *
+     * @param value Value of the channel, range 0 to 255
+     *
+     * @return Scaled value of the channel, range 0 to 255 (with
+     * `PWM_LEVEL_SHIFT` fractional bits)
+     *
+     * @see brightness_pwm_val
+     */
+    static inline pwm_level_t pwm_scale(uint8_t value)
+    {
+
+        #if (PWM_COLOR_GAMMA == 1)
+
+            value = pgm_read_byte(&pwm_gamma_table[value]);
+
+        #endif /* (PWM_COLOR_GAMMA == 1) */
+
+        #if (PWM_DITHER == 1)
+
+            return ((uint32_t)brightness_pwm_val * value
+                + ((uint16_t)value << PWM_LEVEL_SHIFT)) >> 8;
+
+        #else
+
+            return ((uint16_t)brightness_pwm_val * value + value) >> 8;
+
+        #endif /* (PWM_DITHER == 1) */
+
+    }
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+#if (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1)
+
+    /**
+     * @brief Sets up the value of a single channel for the next BOTTOM
+     *
+     * @param channel The channel, index within pwm_ocr
+     * @param level The duty cycle, range 0 to 255 (with `PWM_LEVEL_SHIFT`
+     * fractional bits)
+     *
+     * @see pwm_ocr
+     * @see pwm_fraction
+     */
+    static inline void pwm_set_channel(uint8_t channel, pwm_level_t level)
+    {
+
+        pwm_ocr[channel] = 255 - (level >> PWM_LEVEL_SHIFT);
+
+        #if (PWM_DITHER == 1)
+
+            pwm_fraction[channel] = level & PWM_LEVEL_FRACTION_MASK;
+
+        #endif /* (PWM_DITHER == 1) */
+
+    }
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1) */
+
+/**
+ * @brief Applies the current brightness and color to the output
+ *
+ * In Fast PWM mode the OCR registers are double buffered by the hardware, so
+ * new values only take effect at BOTTOM, i.e. once the current PWM cycle has
+ * been completed. With a single channel, the value is written directly.
+ *
+ * With RGB support the values of all channels are calculated into `pwm_ocr`
+ * and written by `ISR(TIMER0_OVF_vect)` right after the next BOTTOM. As both
+ * timers are run in phase (see `pwm_init()`), all channels then take effect
+ * together at the following BOTTOM, so no torn colors are shown. The same
+ * applies when `PWM_DITHER` is enabled, in which case the interrupt keeps
+ * running as long as there is any fraction to dither.
+ *
+ * @see brightness_pwm_val
+ * @see pwm_color
+ * @see pwm_ocr
+ */
+static void pwm_apply()
+{
+
+    #if (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1)
+
+        uint8_t sreg = SREG;
+        cli();
+
+        #if (ENABLE_RGB_SUPPORT == 1)
+
+            pwm_set_channel(0, pwm_scale(pwm_color.red));
+            pwm_set_channel(1, pwm_scale(pwm_color.green));
+            pwm_set_channel(2, pwm_scale(pwm_color.blue));
+
+        #else
+
+            pwm_set_channel(0, brightness_pwm_val);
+
+        #endif
+
+        /*
+         * Make sure a stale overflow flag doesn't trigger the ISR mid-cycle
+         */
+        if (!(TIMSK0 & _BV(TOIE0))) {
+
+            TIFR0 = _BV(TOV0);
+            TIMSK0 |= _BV(TOIE0);
+
+        }
+
+        SREG = sreg;
+
+    #else
+
+        OCR0A = 255 - brightness_pwm_val;
+
+    #endif
+
+}
+
+#if (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1)
+
+    /**
+     * @brief Writes the pending values to the OCR registers
+     *
+     * This is executed right after BOTTOM of Timer/Counter0 whenever new values
+     * have been calculated by `pwm_apply()`. The interrupt disables itself
+     * afterwards, so it doesn't keep the microcontroller busy.
+     *
+     * If `PWM_DITHER` is enabled, the interrupt is only disabled once none of
+     * the channels has a fraction left (see `pwm_dither()`). Otherwise it is
+     * executed with every PWM period, alternating between the adjacent values.
+     *
+     * @see pwm_apply()
+     * @see pwm_ocr
+     */
+    ISR(TIMER0_OVF_vect)
+    {
+
+        #if (PWM_DITHER == 1)
+
+            OCR0A = pwm_dither(0);
+
+            #if (ENABLE_RGB_SUPPORT == 1)
+
+                OCR0B = pwm_dither(1);
+                OCR2B = pwm_dither(2);
+
+                if (pwm_fraction[0] | pwm_fraction[1] | pwm_fraction[2]) {
+
+                    return;
+
+                }
+
+            #else
+
+                if (pwm_fraction[0]) {
+
+                    return;
+
+                }
+
+            #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+        #else
+
+            OCR0A = pwm_ocr[0];
+            OCR0B = pwm_ocr[1];
+            OCR2B = pwm_ocr[2];
+
+        #endif /* (PWM_DITHER == 1) */
+
+        TIMSK0 &= ~_BV(TOIE0);
+
+    }
+
+#endif /* (ENABLE_RGB_SUPPORT == 1) || (PWM_DITHER == 1) */
+
 /**
  * @brief Sets brightness to a value value within pwm_table
  *
  * The brightness will be set to a value of `pwm_table` pointed to by
- * `base_pwm_idx + offset_pwm_idx`. After the value for the brightness has been
- * retrieved, it is stored within `brightness_pwm_val` and applied - either
- * by directly writing to the appropriate OCR register in case of
- * `ENABLE_RGB_SUPPORT` == 0, or by invoking `pwm_set_color()`.
+ * `base_pwm_idx + offset_pwm_idx`, plus the offset learned for the current
+ * time of day if `PWM_AUTO_LEARN` is enabled. After the value for the
+ * brightness has been retrieved, it is stored within `brightness_pwm_val`
+ * and applied by invoking `pwm_apply()`. If `PWM_RAMP` is enabled, it is
+ * stored within `brightness_pwm_target` instead, so `pwm_ISR()` can ramp
+ * towards it.
  *
  * @note This will only work if the brightness is currently not being locked.
  *
@@ -230,14 +746,15 @@ static uint8_t base_ldr_idx;
  * @see offset_pwm_idx
  * @see pwm_table
  * @see brightness_pwm_val
- * @see pwm_set_color()
+ * @see pwm_apply()
  */
 static void pwm_accommodate_brightness()
 {
 
     if (!brightness_lock) {
 
-        int8_t pwm_idx = ((int8_t)base_pwm_idx) + offset_pwm_idx;
+        int8_t pwm_idx = ((int8_t)base_pwm_idx) + pwm_learned_offset()
+            + offset_pwm_idx;
 
         if (pwm_idx < 0) {
 
@@ -249,19 +766,25 @@ static void pwm_accommodate_brightness()
 
         }
 
-        brightness_pwm_val = pgm_read_byte(&pwm_table[pwm_idx]);
+        pwm_level_t level = pwm_read_table(pwm_idx);
+        uint8_t sreg = SREG;
+        cli();
 
-    }
+        #if (PWM_RAMP == 1)
 
-    #if (ENABLE_RGB_SUPPORT == 1)
+            brightness_pwm_target = level;
 
-        pwm_set_color(pwm_color);
+        #else
 
-    #else
+            brightness_pwm_val = level;
 
-        OCR0A = 255 - brightness_pwm_val;
+        #endif /* (PWM_RAMP == 1) */
 
-    #endif
+        SREG = sreg;
+
+    }
+
+    pwm_apply();
 
 }
 
@@ -298,6 +821,11 @@ void pwm_init()
          * Prescaler: 8
          */
         TCCR2A = _BV(WGM21) | _BV(WGM20);
+
+        /*
+         * Halt the prescalers, so both timers can be started in phase
+         */
+        GTCCR = _BV(TSM) | _BV(PSRASY) | _BV(PSRSYNC);
         TCCR2B = _BV(CS21);
 
     #endif
@@ -311,6 +839,14 @@ void pwm_init()
     TCCR0A = _BV(WGM01) | _BV(WGM00);
     TCCR0B = _BV(CS01);
 
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        TCNT0 = 0;
+        TCNT2 = 0;
+        GTCCR = 0;
+
+    #endif
+
 }
 
 /**
@@ -380,6 +916,15 @@ void pwm_off()
 
     #endif
 
+    #if (PWM_DITHER == 1)
+
+        /*
+         * Stop dithering, pwm_on() sets up the registers again anyway
+         */
+        TIMSK0 &= ~_BV(TOIE0);
+
+    #endif /* (PWM_DITHER == 1) */
+
     pwm_is_on = false;
 
 }
@@ -398,6 +943,26 @@ bool pwm_is_enabled()
 
 }
 
+/**
+ * @brief Returns the brightness value currently used for the PWM signal
+ *
+ * @return Current brightness value without any fractional bits, see
+ * brightness_pwm_val
+ *
+ * @see brightness_pwm_val
+ */
+uint8_t pwm_get_brightness()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    pwm_level_t val = brightness_pwm_val;
+    SREG = sreg;
+
+    return val >> PWM_LEVEL_SHIFT;
+
+}
+
 #if (ENABLE_RGB_SUPPORT == 1)
 
     /**
@@ -414,21 +979,143 @@ bool pwm_is_enabled()
     void pwm_set_color(color_rgb_t color)
     {
 
-        uint16_t brightnessFactor = ((uint16_t)brightness_pwm_val) + 1;
+        #if (PWM_COLOR_FADE == 1)
+
+            uint8_t sreg = SREG;
+            cli();
+
+            pwm_fade_steps = 0;
+            pwm_color_target = color;
+            pwm_color = color;
+
+            SREG = sreg;
 
-        pwm_color = color;
+        #else
 
-        OCR0A = 255 - ((brightnessFactor * color.red) / 256);
-        OCR0B = 255 - ((brightnessFactor * color.green) / 256);
-        OCR2B = 255 - ((brightnessFactor * color.blue) / 256);
+            pwm_color = color;
+
+        #endif /* (PWM_COLOR_FADE == 1) */
+
+        pwm_apply();
 
     }
 
+    #if (PWM_COLOR_FADE == 1)
+
+        /**
+         * @brief Fades the output towards the given RGB color
+         *
+         * This sets up the increment of each channel, so that all of them
+         * reach the given color after the given number of steps, and leaves
+         * the rest to `pwm_ISR()`. A fade that is still in progress is picked
+         * up from where it currently is.
+         *
+         * @param color The color to fade to
+         * @param steps Duration of the fade in steps of 10 ms, values below
+         * two apply the color right away
+         *
+         * @see PWM_COLOR_FADE
+         * @see PWM_COLOR_FADE_STEPS
+         * @see pwm_fade_step()
+         */
+        void pwm_fade_color(color_rgb_t color, uint8_t steps)
+        {
+
+            if (steps < 2) {
+
+                pwm_set_color(color);
+
+                return;
+
+            }
+
+            const uint8_t* target = (const uint8_t*)&color;
+            int16_t increment[3];
+
+            for (uint8_t i = 0; i < 3; i++) {
+
+                int16_t distance = (int16_t)target[i]
+                    - ((const uint8_t*)&pwm_color)[i];
+
+                /*
+                 * At least two steps, so this fits into 16 bits
+                 */
+                increment[i] = ((int32_t)distance << 8) / steps;
+
+            }
+
+            uint8_t sreg = SREG;
+            cli();
+
+            const uint8_t* current = (const uint8_t*)&pwm_color;
+
+            for (uint8_t i = 0; i < 3; i++) {
+
+                // Start in the middle of the current value for rounding
+                pwm_fade_value[i] = ((uint16_t)current[i] << 8) | 0x80;
+                pwm_fade_increment[i] = increment[i];
+
+            }
+
+            pwm_color_target = color;
+            pwm_fade_steps = steps;
+
+            SREG = sreg;
+
+        }
+
+        /**
+         * @brief Performs a single step of the color fade
+         *
+         * This adds the increment of each channel to its current value and
+         * takes over the integer part into `pwm_color`. With the last step the
+         * target color is taken over as is, so rounding errors don't
+         * accumulate.
+         *
+         * @return True if `pwm_color` has been changed, false otherwise
+         *
+         * @see pwm_fade_color()
+         * @see pwm_ISR()
+         */
+        static inline bool pwm_fade_step()
+        {
+
+            if (!pwm_fade_steps) {
+
+                return false;
+
+            }
+
+            if (--pwm_fade_steps == 0) {
+
+                pwm_color = pwm_color_target;
+
+                return true;
+
+            }
+
+            uint8_t* channels = (uint8_t*)&pwm_color;
+
+            for (uint8_t i = 0; i < 3; i++) {
+
+                pwm_fade_value[i] += pwm_fade_increment[i];
+                channels[i] = pwm_fade_value[i] >> 8;
+
+            }
+
+            return true;
+
+        }
+
+    #endif /* (PWM_COLOR_FADE == 1) */
+
     /**
      * @brief Returns the RGB color currently being used
      *
      * This returns a pointer to `pwm_color`, which holds the color currently
-     * being used.
+     * being used. If `PWM_COLOR_FADE` is enabled, the color a fade is heading
+     * for is returned instead, so it can be read back right after it has
+     * been set.
      *
      * @return color Pointer to pwm_color
      *
@@ -437,7 +1124,15 @@ bool pwm_is_enabled()
     const color_rgb_t* pwm_get_color()
     {
 
-        return &pwm_color;
+        #if (PWM_COLOR_FADE == 1)
+
+            return &pwm_color_target;
+
+        #else
+
+            return &pwm_color;
+
+        #endif /* (PWM_COLOR_FADE == 1) */
 
     }
 
@@ -490,7 +1185,8 @@ void pwm_set_base_brightness(uint8_t base_brightness)
 void pwm_increase_brightness()
 {
 
-    if (pwm_is_on && (base_pwm_idx + offset_pwm_idx + 1 < MAX_PWM_STEPS)) {
+    if (pwm_is_on && (base_pwm_idx + pwm_learned_offset() + offset_pwm_idx + 1
+            < MAX_PWM_STEPS)) {
 
         offset_pwm_idx++;
         pwm_accommodate_brightness();
@@ -515,7 +1211,7 @@ void pwm_increase_brightness()
 void pwm_decrease_brightness()
 {
 
-    if (pwm_is_on && (base_pwm_idx + offset_pwm_idx > 0)) {
+    if (pwm_is_on && (base_pwm_idx + pwm_learned_offset() + offset_pwm_idx > 0)) {
 
         offset_pwm_idx--;
         pwm_accommodate_brightness();
@@ -529,6 +1225,7 @@ void pwm_decrease_brightness()
  *
  * This locks the brightness to the given value, making sure it can't be
  * changed anymore until the lock is released using `pwm_release_brightness()`.
+ * The value is applied right away without being ramped.
  *
  * @param val The value you want to lock the brightness to, range 0 to 255
  *
@@ -538,8 +1235,20 @@ void pwm_decrease_brightness()
 void pwm_lock_brightness_val(uint8_t val)
 {
 
+    uint8_t sreg = SREG;
+    cli();
+
     brightness_lock = true;
-    brightness_pwm_val = val;
+    brightness_pwm_val = (pwm_level_t)val << PWM_LEVEL_SHIFT;
+
+    #if (PWM_RAMP == 1)
+
+        brightness_pwm_target = brightness_pwm_val;
+
+    #endif /* (PWM_RAMP == 1) */
+
+    SREG = sreg;
+
     pwm_accommodate_brightness();
 
 }
@@ -562,6 +1271,94 @@ void pwm_release_brightness()
 
 }
 
+#if (PWM_RAMP == 1)
+
+    /**
+     * @brief Performs a single step of the brightness ramp
+     *
+     * This moves `brightness_pwm_val` towards `brightness_pwm_target` with
+     * the slew rate defined by `PWM_RAMP_SHIFT`. Nothing is done once the
+     * target has been reached.
+     *
+     * @return True if `brightness_pwm_val` has been changed, false otherwise
+     *
+     * @see PWM_RAMP
+     * @see pwm_ISR()
+     */
+    static inline bool pwm_ramp_step()
+    {
+
+        pwm_level_t val = brightness_pwm_val;
+        pwm_level_t target = brightness_pwm_target;
+        pwm_level_t step;
+
+        if (val == target) {
+
+            return false;
+
+        }
+
+        if (val < target) {
+
+            step = (target - val) >> PWM_RAMP_SHIFT;
+            val += step ? step : 1;
+
+        } else {
+
+            step = (val - target) >> PWM_RAMP_SHIFT;
+            val -= step ? step : 1;
+
+        }
+
+        brightness_pwm_val = val;
+
+        return true;
+
+    }
+
+#endif /* (PWM_RAMP == 1) */
+
+#if (PWM_RAMP == 1) \
+        || ((ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1))
+
+    /**
+     * @brief Performs a single step of the brightness ramp and color fade
+     *
+     * This is executed within `INTERRUPT_100HZ`. The output is only updated
+     * by `pwm_apply()` when any of them has actually changed something.
+     *
+     * @see pwm_ramp_step()
+     * @see pwm_fade_step()
+     * @see INTERRUPT_100HZ
+     * @see pwm_apply()
+     */
+    void pwm_ISR()
+    {
+
+        bool changed = false;
+
+        #if (PWM_RAMP == 1)
+
+            changed |= pwm_ramp_step();
+
+        #endif /* (PWM_RAMP == 1) */
+
+        #if (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1)
+
+            changed |= pwm_fade_step();
+
+        #endif /* (ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1) */
+
+        if (changed) {
+
+            pwm_apply();
+
+        }
+
+    }
+
+#endif /* (PWM_RAMP == 1) || ((ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1)) */
+
 #if (LOG_LDR2PWM == 1)
 
     /**
@@ -583,7 +1380,7 @@ void pwm_release_brightness()
 
         for (uint8_t i = 0; i < LDR2PWM_COUNT; i++) {
 
-            sprintf_P(buf, fmt_unsigned_decimal, g_ldrBrightness2pwmStep[i]);
+            format_dec(buf, g_ldrBrightness2pwmStep[i]);
             uart_puts(buf);
 
         }
@@ -676,12 +1473,115 @@ void pwm_release_brightness()
 
 #endif
 
+/**
+ * @brief Lowest set bit within each nibble
+ *
+ * @see pwm_occupancy_lowest()
+ */
+static const uint8_t pwm_nibble_lowest[16] PROGMEM = {
+
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+
+};
+
+/**
+ * @brief Highest set bit within each nibble
+ *
+ * @see pwm_occupancy_highest()
+ */
+static const uint8_t pwm_nibble_highest[16] PROGMEM = {
+
+    0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+
+};
+
+/**
+ * @brief Returns the position of the lowest bit set within the given mask
+ *
+ * This skips over empty bytes first and then looks up the remaining nibble
+ * within `pwm_nibble_lowest`, so it takes at most `sizeof(LDR2PWM_OCC_TYPE)`
+ * steps instead of one for each bit.
+ *
+ * @note The mask must not be zero.
+ *
+ * @param mask Mask to look at, usually part of g_occupancy
+ *
+ * @return Position of the lowest bit set
+ *
+ * @see pwm_nibble_lowest
+ */
+static uint8_t pwm_occupancy_lowest(LDR2PWM_OCC_TYPE mask)
+{
+
+    uint8_t pos = 0;
+
+    while (!((uint8_t)mask)) {
+
+        mask >>= 8;
+        pos += 8;
+
+    }
+
+    if (!(mask & 0x0f)) {
+
+        mask >>= 4;
+        pos += 4;
+
+    }
+
+    return pos + pgm_read_byte(&pwm_nibble_lowest[mask & 0x0f]);
+
+}
+
+/**
+ * @brief Returns the position of the highest bit set within the given mask
+ *
+ * This works just like `pwm_occupancy_lowest()`, but with
+ * `pwm_nibble_highest`.
+ *
+ * @note The mask must not be zero.
+ *
+ * @param mask Mask to look at, usually part of g_occupancy
+ *
+ * @return Position of the highest bit set
+ *
+ * @see pwm_nibble_highest
+ */
+static uint8_t pwm_occupancy_highest(LDR2PWM_OCC_TYPE mask)
+{
+
+    uint8_t pos = 0;
+
+    while (mask >> 8) {
+
+        mask >>= 8;
+        pos += 8;
+
+    }
+
+    if (mask >> 4) {
+
+        mask >>= 4;
+        pos += 4;
+
+    }
+
+    return pos + pgm_read_byte(&pwm_nibble_highest[mask]);
+
+}
+
 /**
  * @brief Gets the left and right boundary for the given index and value
  *
- * This iterates over g_occupancy (multiple times) and determines the leftmost
- * and rightmost bits and writes their position to `left` and/or `right`
- * appropriately.
+ * This determines the nearest points defined by the user (see g_occupancy)
+ * to the left and right of the given index and writes their position to
+ * `left` and/or `right` appropriately. Points that would break the
+ * monotonicity of the curve with the new value are dropped and the next
+ * one is looked up instead.
+ *
+ * Both the first and the last point are always set, so the masks looked at
+ * are never empty. Each lookup takes a constant amount of time, see
+ * `pwm_occupancy_lowest()` and `pwm_occupancy_highest()`.
  *
  * @param ind Index
  * @param val Value
@@ -695,16 +1595,10 @@ static void getBounds(uint8_t ind, uint8_t val, uint8_t* left, uint8_t* right)
 
         if (ind > 0) {
 
-            LDR2PWM_OCC_TYPE mask = ((LDR2PWM_OCC_TYPE)1) << (ind - 1);
-
-            *left = ind - 1;
-
-            while (!(mask & g_occupancy)) {
-
-                mask >>= 1;
-                --(*left);
+            LDR2PWM_OCC_TYPE below =
+                g_occupancy & ((((LDR2PWM_OCC_TYPE)1) << ind) - 1);
 
-            }
+            *left = pwm_occupancy_highest(below);
 
         } else {
 
@@ -734,16 +1628,10 @@ static void getBounds(uint8_t ind, uint8_t val, uint8_t* left, uint8_t* right)
 
         if (ind < LDR2PWM_COUNT - 1) {
 
-            LDR2PWM_OCC_TYPE mask = ((LDR2PWM_OCC_TYPE)1) << (ind + 1);
-
-            *right = ind + 1;
+            LDR2PWM_OCC_TYPE above =
+                g_occupancy & ~((((LDR2PWM_OCC_TYPE)1) << (ind + 1)) - 1);
 
-            while (!(mask & g_occupancy)) {
-
-                mask <<= 1;
-                ++(*right);
-
-            }
+            *right = pwm_occupancy_lowest(above);
 
         } else {
 
@@ -901,11 +1789,15 @@ void pwm_modifyLdrBrightness2pwmStep()
 
     if (offset_pwm_idx) {
 
-        uint8_t val = base_pwm_idx + offset_pwm_idx;
+        int8_t val = ((int8_t)base_pwm_idx) + offset_pwm_idx;
+
+        if (val < 0) {
 
-        if (val >= MAX_PWM_STEPS) {
+            val = 0;
 
-            val = MAX_PWM_STEPS;
+        } else if (val >= MAX_PWM_STEPS) {
+
+            val = MAX_PWM_STEPS - 1;
 
         }
 
@@ -917,3 +1809,72 @@ void pwm_modifyLdrBrightness2pwmStep()
     }
 
 }
+
+#if (PWM_AUTO_LEARN == 1)
+
+    /**
+     * @brief Sets the hour of the day for learning corrections
+     *
+     * This is expected to be invoked with the current time on a regular
+     * basis, e.g. each minute. Once a new slot of the day begins, half of the
+     * correction the user made during the previous slot (`offset_pwm_idx`),
+     * but at least a single step, is added to the learned offset of the
+     * previous slot, the correction is dropped and the learned offset of the
+     * new slot is applied.
+     *
+     * @param hour Current hour, range 0 - 23
+     *
+     * @return True if the preferences have been changed and should be saved
+     *
+     * @see PWM_AUTO_LEARN
+     * @see pwm_prefs_t::learnedOffset
+     * @see pwm_accommodate_brightness()
+     */
+    bool pwm_set_hour(uint8_t hour)
+    {
+
+        uint8_t slot = hour / (24 / PWM_AUTO_LEARN_SLOTS);
+        bool changed = false;
+
+        if (slot == pwm_learn_slot || slot >= PWM_AUTO_LEARN_SLOTS) {
+
+            return false;
+
+        }
+
+        /*
+         * A correction present right after a reset can't be attributed to any
+         * slot, so it is left alone.
+         */
+        if (pwm_learn_slot < PWM_AUTO_LEARN_SLOTS && offset_pwm_idx) {
+
+            int8_t* learned =
+                &preferences_get()->pwm_prefs.learnedOffset[pwm_learn_slot];
+            int8_t delta = offset_pwm_idx;
+
+            delta = (delta + ((delta > 0) ? 1 : -1)) / 2;
+            *learned += delta;
+
+            if (*learned >= MAX_PWM_STEPS) {
+
+                *learned = MAX_PWM_STEPS - 1;
+
+            } else if (*learned <= -MAX_PWM_STEPS) {
+
+                *learned = -(MAX_PWM_STEPS - 1);
+
+            }
+
+            offset_pwm_idx = 0;
+            changed = true;
+
+        }
+
+        pwm_learn_slot = slot;
+        pwm_accommodate_brightness();
+
+        return changed;
+
+    }
+
+#endif /* (PWM_AUTO_LEARN == 1) */
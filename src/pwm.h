@@ -65,6 +65,127 @@
  */
 #define LDR2PWM_COUNT 32
 
+/**
+ * @brief Controls whether changes of the brightness are ramped
+ *
+ * If enabled, changes of the brightness are not applied right away, but the
+ * brightness is moved towards its new value from within `INTERRUPT_100HZ`,
+ * which results in smooth transitions.
+ *
+ * @see PWM_RAMP_SHIFT
+ * @see pwm_ISR()
+ */
+#define PWM_RAMP 1
+
+/**
+ * @brief Slew rate of the brightness ramp
+ *
+ * With each step of the ramp (i.e. every 10 ms) the brightness is moved by
+ * 1 / 2^n of the remaining difference, but at least by one. As the steps
+ * within `pwm_table` grow with the brightness, this results in transitions
+ * that appear to be even. With the default of 3 a transition from the minimum
+ * to the maximum brightness takes about half a second.
+ *
+ * @see PWM_RAMP
+ */
+#define PWM_RAMP_SHIFT 3
+
+/**
+ * @brief Controls whether changes of the color can be faded
+ *
+ * If enabled, colors passed to `pwm_fade_color()` are not applied right away,
+ * but each channel is interpolated towards its new value from within
+ * `INTERRUPT_100HZ`. The channels are kept as 8.8 fixed point numbers and
+ * moved by a constant increment each step, so all of them arrive at the
+ * same time, regardless of their distance. Otherwise `pwm_fade_color()`
+ * simply applies the color right away.
+ *
+ * @see PWM_COLOR_FADE_STEPS
+ * @see pwm_fade_color()
+ */
+#define PWM_COLOR_FADE 1
+
+/**
+ * @brief Default duration of a color fade
+ *
+ * This is given in steps of 10 ms, so the default of 50 results in fades
+ * that take half a second. It is used when switching presets and writing
+ * colors via the UART protocol.
+ *
+ * @see PWM_COLOR_FADE
+ * @see pwm_fade_color()
+ */
+#define PWM_COLOR_FADE_STEPS 50
+
+/**
+ * @brief Controls whether the brightness is dithered over multiple PWM periods
+ *
+ * The OCR registers only provide 8 bits, so the lowest brightness steps differ
+ * by 100 %, 50 %, 33 % and so on, which is clearly visible at night. If
+ * enabled, the brightness is kept with `PWM_DITHER_BITS` additional
+ * fractional bits and `ISR(TIMER0_OVF_vect)` alternates between the two
+ * adjacent OCR values from one PWM period to the next, so that the fraction
+ * is met on average. The frequency of the PWM signal itself is not changed.
+ *
+ * `pwm_table` is replaced by one with finer (logarithmically spaced) steps in
+ * this case.
+ *
+ * @note While a fraction is being dithered, the overflow interrupt is
+ * executed once every PWM period (about 3.9 kHz).
+ *
+ * @see PWM_DITHER_BITS
+ * @see pwm_table
+ */
+#define PWM_DITHER 0
+
+/**
+ * @brief Number of fractional bits of the brightness when dithering
+ *
+ * With the default of 4 the effective resolution is 12 bits, and the pattern
+ * repeats after at most 16 PWM periods (about 4 ms). Valid values range from
+ * 1 to 4.
+ *
+ * @see PWM_DITHER
+ */
+#define PWM_DITHER_BITS 4
+
+/**
+ * @brief Controls whether the channels of colors are gamma corrected
+ *
+ * If enabled, each channel of the color set by `pwm_set_color()` is mapped
+ * by a lookup table (gamma = 2.2) before it is scaled by the brightness, so
+ * mixed colors appear as expected by the human eye. This is disabled by
+ * default, so existing color presets keep their appearance.
+ *
+ * @see pwm_gamma_table
+ */
+#define PWM_COLOR_GAMMA 0
+
+/**
+ * @brief Controls whether user corrections of the brightness are learned
+ *
+ * If enabled, the day is divided into `PWM_AUTO_LEARN_SLOTS` slots, each of
+ * which has its own offset to the brightness given by the curve. Whenever a
+ * slot is left while the user has corrected the brightness (see
+ * `pwm_increase_brightness()` and `pwm_decrease_brightness()`), half of the
+ * correction is taken over into the offset of this slot and the correction
+ * itself is dropped. This way corrections repeated day by day, e.g. dimming
+ * the clock each evening, are eventually no longer necessary.
+ *
+ * @see pwm_prefs_t::learnedOffset
+ * @see pwm_set_hour()
+ */
+#define PWM_AUTO_LEARN 0
+
+/**
+ * @brief Number of slots the day is divided into for learning corrections
+ *
+ * @note This needs to be a divisor of 24.
+ *
+ * @see PWM_AUTO_LEARN
+ */
+#define PWM_AUTO_LEARN_SLOTS 6
+
 /**
  * @brief Data type for various user defined values
  *
@@ -101,6 +222,13 @@ typedef struct {
      */
     LDR2PWM_OCC_TYPE occupancy;
 
+    /**
+     * @brief Learned offsets to the brightness for each slot of the day
+     *
+     * @see PWM_AUTO_LEARN
+     */
+    int8_t learnedOffset[PWM_AUTO_LEARN_SLOTS];
+
 } pwm_prefs_t;
 
 /**
@@ -119,7 +247,8 @@ typedef struct {
     0, \
     {5, 6, 7, 8, 8, 9, 10, 11, 12, 13, 13, 14, 15, 16, 17, 18, \
     18, 19, 20, 21, 22, 23, 23, 24, 25, 26, 27, 28, 28, 29, 30, 31}, \
-    ((LDR2PWM_OCC_TYPE)1) | (((LDR2PWM_OCC_TYPE)1) << (LDR2PWM_COUNT - 1)) \
+    ((LDR2PWM_OCC_TYPE)1) | (((LDR2PWM_OCC_TYPE)1) << (LDR2PWM_COUNT - 1)), \
+    {0} \
 }
 
 extern void pwm_init();
@@ -130,12 +259,29 @@ extern void pwm_off();
 
 extern bool pwm_is_enabled();
 
+extern uint8_t pwm_get_brightness();
+
 #if (ENABLE_RGB_SUPPORT == 1)
 
     extern void pwm_set_color(color_rgb_t color);
 
     extern const color_rgb_t* pwm_get_color();
 
+    #if (PWM_COLOR_FADE == 1)
+
+        extern void pwm_fade_color(color_rgb_t color, uint8_t steps);
+
+    #else
+
+        /**
+         * @brief Replacement applying the color right away
+         *
+         * @see PWM_COLOR_FADE
+         */
+        #define pwm_fade_color(color, steps) pwm_set_color(color)
+
+    #endif /* (PWM_COLOR_FADE == 1) */
+
 #endif
 
 extern void pwm_set_base_brightness(uint8_t base_brightness);
@@ -150,4 +296,38 @@ extern void pwm_release_brightness();
 
 extern void pwm_modifyLdrBrightness2pwmStep();
 
+#if (PWM_AUTO_LEARN == 1)
+
+    extern bool pwm_set_hour(uint8_t hour);
+
+#else
+
+    /**
+     * @brief Empty replacement in case corrections are not learned
+     *
+     * @see PWM_AUTO_LEARN
+     */
+    #define pwm_set_hour(hour) false
+
+#endif /* (PWM_AUTO_LEARN == 1) */
+
+#if (PWM_RAMP == 1) \
+        || ((ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1))
+
+    extern void pwm_ISR();
+
+#else
+
+    /**
+     * @brief Empty replacement in case neither the brightness is ramped nor
+     * colors are faded
+     *
+     * @see PWM_RAMP
+     * @see PWM_COLOR_FADE
+     * @see INTERRUPT_100HZ
+     */
+    #define pwm_ISR()
+
+#endif /* (PWM_RAMP == 1) || ((ENABLE_RGB_SUPPORT == 1) && (PWM_COLOR_FADE == 1)) */
+
 #endif /* _WC_PWM_H_ */
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file restart.c
+ * @brief Implementation of the header declared in restart.h
+ *
+ * The snapshot is updated from within the main loop once the datetime has
+ * moved on to the next second. Its CRC is invalidated as soon as it has been
+ * restored, so a fault caused by the restored state itself can't lead to an
+ * endless loop of warm restarts.
+ *
+ * @see restart.h
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <util/crc16.h>
+
+#include "config.h"
+#include "datetime.h"
+#include "ldr.h"
+#include "restart.h"
+#include "user.h"
+
+#if (ENABLE_WARM_RESTART == 1)
+
+/**
+ * @brief Reset causes a snapshot is restored after
+ *
+ * Power-on and external resets start over from scratch, as the contents of
+ * the SRAM can't be relied upon and the user might want to do exactly that,
+ * respectively.
+ *
+ * @see restart_restore()
+ */
+#define RESTART_WARM_CAUSES (_BV(WDRF) | _BV(BORF))
+
+/**
+ * @brief Runtime state kept across warm restarts
+ *
+ * @see restart_snapshot
+ */
+typedef struct {
+
+    /**
+     * @brief Datetime at the time of the snapshot
+     *
+     * @see datetime_restore()
+     */
+    datetime_t datetime;
+
+    /**
+     * @brief Filtered value of the LDR measurements
+     *
+     * @see ldr_restore()
+     */
+    uint16_t ldr_filtered;
+
+    /**
+     * @brief "Power" state of the user module
+     *
+     * @see user_restore_power_state()
+     */
+    uint8_t power_state;
+
+    /**
+     * @brief CRC over all of the members above
+     *
+     * @see restart_get_crc()
+     */
+    uint16_t crc;
+
+} restart_snapshot_t;
+
+/**
+ * @brief Snapshot of the runtime state
+ *
+ * @note To prevent this variable from being cleared by any initialization
+ * routines, it is put into the `.noinit` section.
+ *
+ * @see restart_handle()
+ * @see restart_restore()
+ */
+static restart_snapshot_t restart_snapshot __attribute__ ((section(".noinit")));
+
+/**
+ * @brief Calculates the CRC of the snapshot
+ *
+ * @return CRC over everything but restart_snapshot_t::crc itself
+ *
+ * @see restart_snapshot_t::crc
+ */
+static uint16_t restart_get_crc()
+{
+
+    const uint8_t* ptr = (const uint8_t*)&restart_snapshot;
+    uint16_t crc = 0xffff;
+
+    for (uint8_t i = 0; i < offsetof(restart_snapshot_t, crc); i++) {
+
+        crc = _crc16_update(crc, *ptr++);
+
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Restores the snapshot after a warm restart
+ *
+ * This needs to be invoked once all of the modules have been initialized
+ * and interrupts have been enabled. The snapshot is only restored if the
+ * reset has been caused by the watchdog or a brown-out (see
+ * RESTART_WARM_CAUSES) and its CRC matches. The filtered LDR value and the
+ * "power" state are restored before the datetime, so the time is shown
+ * right away with the proper brightness, or not at all.
+ *
+ * @param mcusr Content of the MCU status register at the time of the reset
+ *
+ * @return True if the snapshot has been restored, false otherwise
+ *
+ * @see ldr_restore()
+ * @see user_restore_power_state()
+ * @see datetime_restore()
+ */
+bool restart_restore(uint8_t mcusr)
+{
+
+    if (!(mcusr & RESTART_WARM_CAUSES)
+            || restart_snapshot.crc != restart_get_crc()
+            || !datetime_validate(&restart_snapshot.datetime)) {
+
+        return false;
+
+    }
+
+    restart_snapshot.crc = ~restart_snapshot.crc;
+
+    ldr_restore(restart_snapshot.ldr_filtered);
+    user_restore_power_state(restart_snapshot.power_state);
+    datetime_restore(&restart_snapshot.datetime);
+
+    return true;
+
+}
+
+/**
+ * @brief Updates the snapshot
+ *
+ * This needs to be invoked whenever the datetime might have changed. The
+ * snapshot is only updated once per second and as long as the datetime is
+ * valid, so only a couple of bytes need to be run through the CRC.
+ *
+ * @see restart_snapshot
+ */
+void restart_handle()
+{
+
+    const datetime_t* datetime = datetime_get();
+
+    if (!datetime_is_valid() || datetime->ss == restart_snapshot.datetime.ss) {
+
+        return;
+
+    }
+
+    restart_snapshot.datetime = *datetime;
+    restart_snapshot.ldr_filtered = ldr_get_filtered();
+    restart_snapshot.power_state = user_get_power_state();
+    restart_snapshot.crc = restart_get_crc();
+
+}
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
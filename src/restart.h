@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file restart.h
+ * @brief Header for keeping runtime state across warm restarts
+ *
+ * The contents of the SRAM are retained by resets, as long as the supply
+ * voltage doesn't drop too far. A snapshot of the runtime state is therefore
+ * kept within the `.noinit` section, so it is not cleared by the startup
+ * code. After a reset caused by the watchdog or a brown-out the snapshot is
+ * restored, provided that its CRC is still intact. This way a fault goes by
+ * almost unnoticed, instead of the display staying dark until the time has
+ * been read and the brightness starting over from a single measurement.
+ *
+ * @see restart.c
+ * @see ENABLE_WARM_RESTART
+ */
+
+#ifndef _WC_RESTART_H_
+#define _WC_RESTART_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#if (ENABLE_WARM_RESTART == 1)
+
+    extern bool restart_restore(uint8_t mcusr);
+
+    extern void restart_handle();
+
+#else
+
+    /**
+     * @brief Replacement in case warm restarts are disabled
+     *
+     * @see ENABLE_WARM_RESTART
+     */
+    #define restart_restore(mcusr) false
+
+    /**
+     * @brief Empty macro in case warm restarts are disabled
+     *
+     * @see ENABLE_WARM_RESTART
+     */
+    #define restart_handle()
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
+#endif /* _WC_RESTART_H_ */
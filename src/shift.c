@@ -26,12 +26,19 @@
  * in `shift.h`. For details about the protocol and/or the hardware itself,
  * refer to [1], p. 163, table 19-1.
  *
+ * The transmission itself is interrupt driven (`ISR(SPI_STC_vect)`). There is
+ * a frame currently being transmitted as well as a pending one, which will be
+ * transmitted once the current one has been completed. Newer frames replace
+ * the pending one, so frames that have been superseded are never output.
+ *
  * [1]: http://www.atmel.com/images/doc2545.pdf
  *
  * @see shift.c
  */
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
 
 #include "shift.h"
 
@@ -73,6 +80,72 @@
  */
 #define SHIFT_SR_SPI_SCK 5
 
+/**
+ * @brief Remaining bytes of the frame currently being transmitted
+ *
+ * The most significant byte is transmitted directly by `shift24_start()`, so
+ * only the two remaining bytes need to be buffered here.
+ *
+ * @see shift24_start()
+ * @see ISR(SPI_STC_vect)
+ */
+static uint8_t shift24_frame[2];
+
+/**
+ * @brief Index of the next byte within `shift24_frame` to be transmitted
+ *
+ * @see shift24_frame
+ */
+static uint8_t shift24_index;
+
+/**
+ * @brief Indicates whether a frame is currently being transmitted
+ *
+ * @see shift24_output()
+ * @see ISR(SPI_STC_vect)
+ */
+static volatile bool shift24_busy;
+
+/**
+ * @brief Frame to be transmitted once the current one has been completed
+ *
+ * @see shift24_pending_valid
+ * @see shift24_output()
+ */
+static uint32_t shift24_pending;
+
+/**
+ * @brief Indicates whether `shift24_pending` contains a valid frame
+ *
+ * @see shift24_pending
+ */
+static bool shift24_pending_valid;
+
+/**
+ * @brief Starts the transmission of the given frame
+ *
+ * The two least significant bytes are buffered within `shift24_frame`, the
+ * most significant byte is written to the SPI data register directly. The
+ * rest of the frame is transmitted by `ISR(SPI_STC_vect)`.
+ *
+ * @note This must only be called with interrupts disabled.
+ *
+ * @param data Data to be output
+ *
+ * @see ISR(SPI_STC_vect)
+ */
+static void shift24_start(uint32_t data)
+{
+
+    shift24_frame[0] = (uint8_t)(data >> 8);
+    shift24_frame[1] = (uint8_t)(data);
+    shift24_index = 0;
+    shift24_busy = true;
+
+    SPDR = (uint8_t)(data >> 16);
+
+}
+
 /**
  * @brief Initializes this module
  *
@@ -92,10 +165,11 @@ void shift24_init() {
 
     /*
      * SPE: Enable SPI hardware
+     * SPIE: Enable SPI interrupt
      * MSTR: Select SPI master mode
      * CPOL: SCK is high when idle
      */
-    SPCR = _BV(SPE) | _BV(MSTR) | _BV(CPOL);
+    SPCR = _BV(SPE) | _BV(SPIE) | _BV(MSTR) | _BV(CPOL);
 
     /*
      * SPI2X: Double SPI speed
@@ -109,10 +183,12 @@ void shift24_init() {
 /**
  * @brief Outputs the given data over the Serial Peripheral Interface (SPI)
  *
- * This function outputs the given data by splitting it into blocks of eight
- * bits and writing it into the appropriate register of the SPI module. After
- * all of the bits have been output the RCLK line is toggled, so that the
- * shift registers will apply the new values.
+ * This function posts the given data to be output and returns immediately.
+ * When the SPI is currently idle, the transmission is started right away.
+ * Otherwise the data is stored as pending frame, replacing any other frame
+ * that might still be pending. The actual transmission as well as toggling
+ * the RCLK line, so that the shift registers will apply the new values, is
+ * performed by `ISR(SPI_STC_vect)`.
  *
  * @note Although the argument accepts 32 bits (uint32_t), only the 24 least
  * significant bits will actually be output.
@@ -120,23 +196,63 @@ void shift24_init() {
  * @param data Data to be output
  *
  * @see shift24_init()
+ * @see ISR(SPI_STC_vect)
  */
 void shift24_output(uint32_t data) {
 
-    uint8_t u0 = (uint8_t)(data);
-    uint8_t u1 = (uint8_t)(data >> 8);
-    uint8_t u2 = (uint8_t)(data >> 16);
+    uint8_t sreg = SREG;
+    cli();
+
+    if (shift24_busy) {
+
+        shift24_pending = data;
+        shift24_pending_valid = true;
+
+    } else {
 
-    SPDR = u2;
-    while (!(SPSR & (_BV(SPIF))));
+        shift24_start(data);
 
-    SPDR = u1;
-    while (!(SPSR & (_BV(SPIF))));
+    }
 
-    SPDR = u0;
-    while (!(SPSR & (_BV(SPIF))));
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Transmits the next byte of the current frame
+ *
+ * This is executed whenever a single byte has been transmitted completely. It
+ * transmits the next byte of the current frame (`shift24_frame`). Once all of
+ * the bytes have been transmitted, the RCLK line is toggled to latch the
+ * frame and the pending frame (if any) is started.
+ *
+ * @see shift24_frame
+ * @see shift24_pending
+ * @see shift24_start()
+ */
+ISR(SPI_STC_vect)
+{
+
+    if (shift24_index < sizeof(shift24_frame)) {
+
+        SPDR = shift24_frame[shift24_index++];
+
+        return;
+
+    }
 
     SHIFT_SR_SPI_PORT &= ~(_BV(SHIFT_SR_SPI_RCLK));
     SHIFT_SR_SPI_PORT |=  (_BV(SHIFT_SR_SPI_RCLK));
 
+    if (shift24_pending_valid) {
+
+        shift24_pending_valid = false;
+        shift24_start(shift24_pending);
+
+    } else {
+
+        shift24_busy = false;
+
+    }
+
 }
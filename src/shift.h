@@ -25,7 +25,8 @@
  * This module is used to output data to the shift registers. It makes use of
  * the SPI hardware interface of the AVR microcontroller itself. The module
  * needs to be initialized `using shift24_init()`. Afterwards data can be
- * output by using `shift24_output()`.
+ * output by using `shift24_output()`, which doesn't block, but only posts
+ * the data to be transmitted in the background.
  *
  * @see shift.c
  */
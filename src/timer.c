@@ -29,6 +29,25 @@
  *
  * Functions, which need to be called on a regular basis can simply be added
  * to the appropriate macro, that is `INTERRUPT_10000HZ` up to `INTERRUPT_1M`.
+ * With IR_USE_EDGE_CAPTURE enabled the timer runs at 1 kHz only and
+ * `INTERRUPT_10000HZ` doesn't exist.
+ *
+ * Modules that need to wait for a certain amount of time should rather make
+ * use of the software timers (`timer_start()`), which are only counted down
+ * while they are armed. Their callbacks can be executed from within the ISR
+ * or, with `TIMER_DEFERRED`, from within the main loop.
+ *
+ * Functions that take comparatively long to execute (e.g. writing to the
+ * EEPROM) should rather be added to the deferred macros, that is
+ * `INTERRUPT_10HZ_DEFERRED` up to `INTERRUPT_1M_DEFERRED`. The ISR only marks
+ * them as pending, and they will be executed from within the main loop by
+ * `timer_handle()`. This keeps the execution time of the ISR itself short and
+ * bounded, so that time critical functions (e.g. `irmp_ISR()`) are not
+ * delayed.
+ *
+ * With `TIMER_NESTED_INTERRUPTS` enabled only the stages of 1 kHz and above
+ * are executed with interrupts disabled. `INTERRUPT_100HZ` and the stages
+ * below it can be interrupted, so they don't delay other ISRs either.
  *
  * [1]: http://www.atmel.com/images/doc2545.pdf
  *
@@ -37,6 +56,7 @@
  */
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <avr/io.h>
 #include <util/delay.h>
 #include <avr/pgmspace.h>
@@ -44,50 +64,295 @@
 
 #include "config.h"
 #include "timer.h"
+#include "datetime.h"
 #include "dcf77.h"
-#include "IRMP/irmp.h"
+#include "event.h"
+#include "health.h"
+#include "ir.h"
 #include "ldr.h"
+#include "pwm.h"
 #include "user.h"
 #include "display.h"
 #include "uart.h"
 #include "preferences.h"
+#include "memcheck.h"
+#include "profile.h"
+
+#if (ENABLE_IR_SUPPORT == 0) || (IR_USE_EDGE_CAPTURE == 1)
+
+    /**
+     * @brief Defines how often the timer ISR itself is executed
+     *
+     * The IR input is not polled in this case, as there either is no IR
+     * support at all, or its edges are timestamped by the IR module and
+     * replayed into IRMP from within the main loop (see ir_handle()).
+     * Therefore the 10 kHz stage is not needed at all.
+     *
+     * @see ISR(TIMER1_CAPT_vect)
+     * @see ENABLE_IR_SUPPORT
+     * @see IR_USE_EDGE_CAPTURE
+     */
+    #define F_INTERRUPT 1000
+
+#else
+
+    /**
+     * @brief Defines how often the timer ISR itself is executed
+     *
+     * @see ISR(TIMER1_CAPT_vect)
+     */
+    #define F_INTERRUPT 10000
+
+    /**
+     * @brief List of functions that should be called 10000 times a second
+     *
+     * irmp_ISR() is skipped entirely while the IR input is idle (see
+     * irmp_is_idle()), which is the case most of the time. This saves the
+     * rather expensive call into the IRMP state machine on almost every tick.
+     */
+    #define INTERRUPT_10000HZ { if (!irmp_is_idle() && irmp_ISR()) { event_post(EVENT_IR); } }
+
+#endif /* (ENABLE_IR_SUPPORT == 0) || (IR_USE_EDGE_CAPTURE == 1) */
+
+/**
+ * @brief List of functions that should be called 1000 times a second
+ */
+#define INTERRUPT_1000HZ { }
+
+/**
+ * @brief List of functions that should be called 100 times a second
+ */
+#define INTERRUPT_100HZ { dcf77_ISR(); pwm_ISR(); }
+
+/**
+ * @brief List of functions that should be called 10 times a second
+ */
+#define INTERRUPT_10HZ { ldr_ISR(); }
+
+#if (DATETIME_USE_RTC_SQW == 1)
+
+    /**
+     * @brief List of functions that should be called once a second
+     *
+     * The software clock is driven by the RTC itself in this case, see
+     * DATETIME_USE_RTC_SQW.
+     */
+    #define INTERRUPT_1HZ { dcf77_stats_ISR(); }
+
+#else
+
+    /**
+     * @brief List of functions that should be called once a second
+     */
+    #define INTERRUPT_1HZ { datetime_ISR(); dcf77_stats_ISR(); }
+
+#endif /* (DATETIME_USE_RTC_SQW == 1) */
 
 /**
- * @brief Defines how often the timer ISR itself is executed
+ * @brief List of functions that should be called once a minute
+ */
+#define INTERRUPT_1M { }
+
+/**
+ * @brief List of functions that should be called 10 times a second from
+ * within the main loop
  *
- * @see ISR(TIMER1_CAPT_vect)
+ * @see timer_handle()
  */
-#define F_INTERRUPT 10000
+#define INTERRUPT_10HZ_DEFERRED { }
 
 /**
- * @brief List of functions that should be called 10000 times a second
+ * @brief List of functions that should be called once a second from within
+ * the main loop
+ *
+ * @see timer_handle()
  */
-#define INTERRUPT_10000HZ { irmp_ISR(); }
+#define INTERRUPT_1HZ_DEFERRED { user_isr1Hz(); health_isr1Hz(); }
 
 /**
- * @brief List of functions that should be called 1000 times a second
+ * @brief List of functions that should be called once a minute from within
+ * the main loop
+ *
+ * @see timer_handle()
  */
-#define INTERRUPT_1000HZ { user_isr1000Hz(); }
+#define INTERRUPT_1M_DEFERRED { }
 
 /**
- * @brief List of functions that should be called 100 times a second
+ * @brief Bit within `timer_pending` indicating that `INTERRUPT_10HZ_DEFERRED`
+ * is pending
+ *
+ * @see timer_pending
  */
-#define INTERRUPT_100HZ { dcf77_ISR(); user_isr100Hz(); }
+#define TIMER_PENDING_10HZ 0
 
 /**
- * @brief List of functions that should be called 10 times a second
+ * @brief Bit within `timer_pending` indicating that `INTERRUPT_1HZ_DEFERRED`
+ * is pending
+ *
+ * @see timer_pending
  */
-#define INTERRUPT_10HZ { user_isr10Hz(); display_blinkStep(); }
+#define TIMER_PENDING_1HZ 1
 
 /**
- * @brief List of functions that should be called once a second
+ * @brief Bit within `timer_pending` indicating that `INTERRUPT_1M_DEFERRED`
+ * is pending
+ *
+ * @see timer_pending
  */
-#define INTERRUPT_1HZ { datetime_ISR(); ldr_ADC(); user_isr1Hz(); }
+#define TIMER_PENDING_1M 2
 
 /**
- * @brief List of functions that should be called once a minute
+ * @brief Bitfield containing the deferred work not yet executed
+ *
+ * The bits are set by `ISR(TIMER1_CAPT_vect)` and cleared by `timer_handle()`
+ * once the appropriate functions have been executed.
+ *
+ * @note If the main loop doesn't manage to call `timer_handle()` in time, the
+ * same work item will be executed only once, although it has been marked as
+ * pending multiple times.
+ *
+ * @see TIMER_PENDING_10HZ
+ * @see TIMER_PENDING_1HZ
+ * @see TIMER_PENDING_1M
+ * @see timer_handle()
  */
-#define INTERRUPT_1M { }
+static volatile uint8_t timer_pending;
+
+/**
+ * @brief Free running millisecond counter
+ *
+ * This is incremented once every millisecond by `timer_tick()` and starts at
+ * zero once interrupts are enabled, so it represents the uptime. It wraps
+ * around after roughly 49 days. Timestamps of short intervals only need its
+ * lower 16 bits, see `timer_get_ms()`.
+ *
+ * @see timer_get_ms()
+ * @see timer_get_uptime_ms()
+ */
+static volatile uint32_t timer_ms;
+
+#if (TIMER_COUNT > 8)
+
+    #error "There can be eight software timers at most"
+
+#endif
+
+/**
+ * @brief Software timers currently armed for each of the resolutions
+ *
+ * Each bit represents a timer (see timer_id_t). Stages of the tick cascade
+ * without any armed timer only need to check for this mask to be zero.
+ *
+ * @see timer_wheel_step()
+ */
+static volatile uint8_t timer_armed[TIMER_RESOLUTION_COUNT];
+
+/**
+ * @brief Software timers that have expired, but whose deferred callbacks
+ * have not been executed yet
+ *
+ * @see TIMER_DEFERRED
+ * @see timer_handle()
+ */
+static volatile uint8_t timer_expired;
+
+/**
+ * @brief Software timers with deferred callbacks
+ *
+ * @see TIMER_DEFERRED
+ */
+static uint8_t timer_deferred;
+
+/**
+ * @brief Periodic software timers
+ *
+ * @see TIMER_PERIODIC
+ */
+static uint8_t timer_periodic;
+
+/**
+ * @brief Remaining ticks of each software timer until it expires
+ *
+ * @see timer_wheel_step()
+ */
+static uint8_t timer_remaining[TIMER_COUNT];
+
+/**
+ * @brief Ticks each software timer has been started with
+ *
+ * This is used to restart periodic timers.
+ *
+ * @see TIMER_PERIODIC
+ */
+static uint8_t timer_period[TIMER_COUNT];
+
+/**
+ * @brief Callbacks of each software timer
+ *
+ * @see timer_callback_t
+ */
+static timer_callback_t timer_callbacks[TIMER_COUNT];
+
+#if (F_INTERRUPT == 10000)
+
+    /**
+     * @brief Ticks of the ISR within the current millisecond
+     *
+     * @see timer_tick()
+     */
+    static uint8_t timer_thousands_counter;
+
+#endif /* (F_INTERRUPT == 10000) */
+
+/**
+ * @brief Milliseconds within the current stage of 10 ms
+ *
+ * @see timer_tick()
+ * @see timer_align_1hz()
+ */
+static uint8_t timer_hundreds_counter;
+
+/**
+ * @brief Stages of 10 ms within the current stage of 100 ms
+ *
+ * @see timer_tick()
+ * @see timer_align_1hz()
+ */
+static uint8_t timer_tenths_counter;
+
+/**
+ * @brief Stages of 100 ms within the current second
+ *
+ * @see timer_tick()
+ * @see timer_align_1hz()
+ */
+static uint8_t timer_seconds_counter;
+
+#if (TIMER_NESTED_INTERRUPTS == 1)
+
+    /**
+     * @brief Stages of 10 ms that are due, but have not been executed yet
+     *
+     * This is incremented by `ISR(TIMER1_CAPT_vect)` whenever a stage of
+     * 10 ms is reached and decremented once `timer_tick_slow()` is about to
+     * be executed for it.
+     *
+     * @see timer_run_slow()
+     */
+    static volatile uint8_t timer_slow_pending;
+
+    /**
+     * @brief Indicates whether `timer_tick_slow()` is currently being
+     * executed
+     *
+     * This guards against nested executions of the slower stages, which
+     * could otherwise pile up on the stack.
+     *
+     * @see timer_run_slow()
+     */
+    static bool timer_slow_running;
+
+#endif /* (TIMER_NESTED_INTERRUPTS == 1) */
 
 /**
  * @brief Initializes the timer
@@ -115,78 +380,553 @@ void timer_init()
 }
 
 /**
- * @brief Timer/Counter1 compare handler (ISR)
+ * @brief Starts the given software timer
  *
- * This function is called with the frequency defined by F_INTERRUPT. It
- * divides this frequency down into various smaller frequencies and executes
- * the appropriate functions sequentially.
+ * The timer expires once the given amount of ticks of the given resolution
+ * has passed. As the ticks are counted with the tick cascade, the first
+ * tick might come early, i.e. the timer expires after at least `ticks - 1`
+ * and at most `ticks` full ticks. If the timer is already armed, it is
+ * restarted.
  *
- * @note The timer needs to be initialized before this ISR will be executed.
+ * This can also be called from within an ISR, including the callbacks of
+ * timers themselves.
  *
- * @warning You should make sure that the defined functions are short enough
- * to guarantee correct timings. Otherwise some interrupts could be missed,
- * which obviously would mess things up.
+ * @param id The timer to start
+ * @param flags Resolution (timer_resolution_t) combined with TIMER_PERIODIC
+ * and/or TIMER_DEFERRED
+ * @param ticks Number of ticks until the timer expires, zero is treated as
+ * one
+ * @param callback Function to execute once the timer has expired, might be
+ * NULL when only timer_is_armed() is of interest
  *
- * @see timer_init()
- * @see F_INTERRUPT
- * @see INTERRUPT_10000HZ
- * @see INTERRUPT_1000HZ
- * @see INTERRUPT_100HZ
- * @see INTERRUPT_10HZ
+ * @see timer_resolution_t
+ * @see TIMER_PERIODIC
+ * @see TIMER_DEFERRED
+ * @see timer_stop()
+ */
+void timer_start(timer_id_t id, uint8_t flags, uint8_t ticks, timer_callback_t callback)
+{
+
+    uint8_t mask = _BV(id);
+
+    if (!ticks) {
+
+        ticks = 1;
+
+    }
+
+    uint8_t sreg = SREG;
+    cli();
+
+    for (uint8_t i = 0; i < TIMER_RESOLUTION_COUNT; i++) {
+
+        timer_armed[i] &= ~mask;
+
+    }
+
+    timer_expired &= ~mask;
+    timer_remaining[id] = ticks;
+    timer_period[id] = ticks;
+    timer_callbacks[id] = callback;
+
+    if (flags & TIMER_PERIODIC) {
+
+        timer_periodic |= mask;
+
+    } else {
+
+        timer_periodic &= ~mask;
+
+    }
+
+    if (flags & TIMER_DEFERRED) {
+
+        timer_deferred |= mask;
+
+    } else {
+
+        timer_deferred &= ~mask;
+
+    }
+
+    timer_armed[flags & TIMER_RESOLUTION_MASK] |= mask;
+
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Stops the given software timer
+ *
+ * A deferred callback that is still pending is dropped, too.
+ *
+ * @param id The timer to stop
+ *
+ * @see timer_start()
+ */
+void timer_stop(timer_id_t id)
+{
+
+    uint8_t mask = ~_BV(id);
+
+    uint8_t sreg = SREG;
+    cli();
+
+    for (uint8_t i = 0; i < TIMER_RESOLUTION_COUNT; i++) {
+
+        timer_armed[i] &= mask;
+
+    }
+
+    timer_expired &= mask;
+
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Returns whether the given software timer is armed
+ *
+ * One-shot timers are no longer armed once they have expired, periodic
+ * timers remain armed until they are stopped.
+ *
+ * @param id The timer to check
+ *
+ * @return True if the timer is armed, false otherwise
+ *
+ * @see timer_start()
+ * @see timer_stop()
+ */
+bool timer_is_armed(timer_id_t id)
+{
+
+    uint8_t armed = 0;
+
+    uint8_t sreg = SREG;
+    cli();
+
+    for (uint8_t i = 0; i < TIMER_RESOLUTION_COUNT; i++) {
+
+        armed |= timer_armed[i];
+
+    }
+
+    SREG = sreg;
+
+    return armed & _BV(id);
+
+}
+
+/**
+ * @brief Counts down the software timers armed for the given resolution
+ *
+ * This is invoked by `timer_tick()` whenever the appropriate stage of the
+ * tick cascade is reached and there is at least one timer armed for it.
+ * Expired one-shot timers are disarmed before their callback is executed, so
+ * the callback can restart them.
+ *
+ * The bookkeeping of each timer is done with interrupts disabled, as the
+ * slower stages can be interrupted by the next tick (see
+ * `TIMER_NESTED_INTERRUPTS`), whose callbacks might start and/or stop
+ * timers of any resolution. The callbacks themselves are executed with
+ * interrupts as they were.
+ *
+ * @param resolution The resolution whose tick has passed
+ *
+ * @see timer_armed
+ * @see timer_tick()
+ */
+static void timer_wheel_step(timer_resolution_t resolution)
+{
+
+    uint8_t armed = timer_armed[resolution];
+
+    for (uint8_t id = 0; armed; id++, armed >>= 1) {
+
+        if (!(armed & 1)) {
+
+            continue;
+
+        }
+
+        uint8_t mask = _BV(id);
+        timer_callback_t callback = NULL;
+
+        uint8_t sreg = SREG;
+        cli();
+
+        // Might have been stopped or restarted in the meantime
+        if ((timer_armed[resolution] & mask) && !--timer_remaining[id]) {
+
+            if (timer_periodic & mask) {
+
+                timer_remaining[id] = timer_period[id];
+
+            } else {
+
+                timer_armed[resolution] &= ~mask;
+
+            }
+
+            if (timer_deferred & mask) {
+
+                timer_expired |= mask;
+
+            } else {
+
+                callback = timer_callbacks[id];
+
+            }
+
+        }
+
+        SREG = sreg;
+
+        if (callback) {
+
+            callback();
+
+        }
+
+    }
+
+}
+
+/**
+ * @brief Executes the deferred work marked as pending by the ISR
+ *
+ * This retrieves and clears the pending work items (`timer_pending`) and
+ * executes the appropriate functions. The order is the same as it would have
+ * been within the ISR itself, that is the 10 Hz functions are executed before
+ * the 1 Hz functions, etc. Afterwards the callbacks of expired deferred
+ * software timers (`timer_expired`) are executed.
+ *
+ * @note This needs to be called on a regular basis from within the main loop.
+ *
+ * @see timer_pending
+ * @see timer_expired
+ * @see INTERRUPT_10HZ_DEFERRED
+ * @see INTERRUPT_1HZ_DEFERRED
+ * @see INTERRUPT_1M_DEFERRED
+ */
+void timer_handle()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t pending = timer_pending;
+    timer_pending = 0;
+    SREG = sreg;
+
+    if (pending & _BV(TIMER_PENDING_10HZ)) {
+
+        INTERRUPT_10HZ_DEFERRED;
+
+    }
+
+    if (pending & _BV(TIMER_PENDING_1HZ)) {
+
+        INTERRUPT_1HZ_DEFERRED;
+
+    }
+
+    if (pending & _BV(TIMER_PENDING_1M)) {
+
+        INTERRUPT_1M_DEFERRED;
+
+    }
+
+    sreg = SREG;
+    cli();
+    uint8_t expired = timer_expired;
+    timer_expired = 0;
+    SREG = sreg;
+
+    for (uint8_t id = 0; expired; id++, expired >>= 1) {
+
+        if ((expired & 1) && timer_callbacks[id]) {
+
+            timer_callbacks[id]();
+
+        }
+
+    }
+
+}
+
+/**
+ * @brief Returns the current value of the millisecond counter
+ *
+ * The value itself is of no particular meaning, but the difference between
+ * two values returned by this function gives the amount of milliseconds that
+ * have passed in between. Intervals of up to 65535 ms can be measured this
+ * way, as long as the subtraction is performed with unsigned 16 bit integers.
+ *
+ * This can also be called from within an ISR.
+ *
+ * @return Current value of the millisecond counter
+ *
+ * @see timer_ms
+ */
+uint16_t timer_get_ms()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t ms = timer_ms;
+    SREG = sreg;
+
+    return ms;
+
+}
+
+/**
+ * @brief Returns the time that has passed since the timer has been started
+ *
+ * Unlike timer_get_ms() this is monotonic for roughly 49 days, so it can be
+ * used to measure durations spanning multiple minutes and/or hours, e.g. for
+ * timestamps within statistics.
+ *
+ * This can also be called from within an ISR.
+ *
+ * @return Uptime in milliseconds
+ *
+ * @see timer_ms
+ */
+uint32_t timer_get_uptime_ms()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t ms = timer_ms;
+    SREG = sreg;
+
+    return ms;
+
+}
+
+/**
+ * @brief Moves the next execution of `INTERRUPT_1HZ` to the given point in
+ * time
+ *
+ * This sets up the counters of the tick cascade as if the appropriate amount
+ * of time had passed since the last execution of `INTERRUPT_1HZ`. It is used
+ * to align the software clock with an external reference, see
+ * datetime_sync(). The 100 Hz and 10 Hz stages are shifted along with it, so
+ * a single one of their periods might be shortened and/or extended, the
+ * millisecond counter itself is not touched at all.
+ *
+ * This can also be called from within an ISR.
+ *
+ * @param ms Milliseconds until `INTERRUPT_1HZ` is executed the next time,
+ * ranges from 1 to 1999, i.e. a second can be extended by almost another one
+ *
+ * @see timer_tick()
  * @see INTERRUPT_1HZ
- * @see INTERRUPT_1M
  */
-ISR(TIMER1_CAPT_vect)
+void timer_align_1hz(uint16_t ms)
 {
 
-    static uint8_t thousands_counter;
-    static uint8_t hundreds_counter;
-    static uint8_t tenths_counter;
-    static uint8_t seconds_counter;
-    static uint8_t minutes_counter;
+    if (!ms) {
 
-    INTERRUPT_10000HZ;
+        ms = 1;
 
-    if (++thousands_counter != 10) {
+    } else if (ms > 1999) {
 
-        return;
+        ms = 1999;
 
     }
 
-    thousands_counter = 0;
+    // Ticks needed before the one reaching all of the stages
+    ms--;
+
+    uint8_t sreg = SREG;
+    cli();
+
+    #if (F_INTERRUPT == 10000)
+
+        timer_thousands_counter = 0;
+
+    #endif /* (F_INTERRUPT == 10000) */
+
+    timer_hundreds_counter = 9 - (ms % 10);
+    timer_tenths_counter = 9 - ((ms / 10) % 10);
+
+    // Wraps around for seconds longer than a second
+    timer_seconds_counter = 10 - (ms / 100 + 1);
+
+    SREG = sreg;
+
+}
+
+#if (IR_USE_EDGE_CAPTURE == 1)
+
+/**
+ * @brief Returns the current time with a resolution of 100 us
+ *
+ * This combines the millisecond counter with the current value of
+ * Timer/Counter1. A tick that has already happened, but has not been handled
+ * by `ISR(TIMER1_CAPT_vect)` yet, is taken into account. Just like with
+ * timer_get_ms() only the difference between two values is of any meaning.
+ *
+ * This can also be called from within an ISR.
+ *
+ * @return Current time in units of 100 us
+ *
+ * @see timer_ms
+ * @see ir_handle()
+ */
+uint16_t timer_get_100us()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+
+    uint16_t ms = timer_ms;
+    uint16_t count = TCNT1;
+
+    if ((TIFR1 & _BV(ICF1)) && count < (ICR1 / 2)) {
+
+        ms++;
+
+    }
+
+    SREG = sreg;
+
+    return (ms * 10) + (count / (F_CPU / 10000));
+
+}
+
+#endif /* (IR_USE_EDGE_CAPTURE == 1) */
+
+/**
+ * @brief Divides the timer frequency down and executes the fast stages
+ *
+ * This is invoked by `ISR(TIMER1_CAPT_vect)` with the frequency defined by
+ * F_INTERRUPT and always executed with interrupts disabled. It executes
+ * `INTERRUPT_10000HZ` and `INTERRUPT_1000HZ`, counts the milliseconds and
+ * the software timers with a resolution of 1 ms. Everything below is up to
+ * `timer_tick_slow()`, which needs to be executed once this returns true.
+ *
+ * @return True if a stage of 10 ms has been reached, false otherwise
+ *
+ * @see ISR(TIMER1_CAPT_vect)
+ * @see INTERRUPT_10000HZ
+ * @see INTERRUPT_1000HZ
+ * @see timer_ms
+ * @see timer_wheel_step()
+ * @see timer_tick_slow()
+ */
+static inline bool timer_tick()
+{
+
+    #if (F_INTERRUPT == 10000)
+
+        INTERRUPT_10000HZ;
+
+        if (++timer_thousands_counter != 10) {
+
+            return false;
+
+        }
+
+        timer_thousands_counter = 0;
+
+    #endif /* (F_INTERRUPT == 10000) */
+
+    timer_ms++;
 
     INTERRUPT_1000HZ;
 
-    if (++hundreds_counter != 10) {
+    if (timer_armed[TIMER_1MS]) {
 
-        return;
+        timer_wheel_step(TIMER_1MS);
+
+    }
+
+    if (++timer_hundreds_counter != 10) {
+
+        return false;
 
     }
 
-    hundreds_counter = 0;
+    timer_hundreds_counter = 0;
+
+    return true;
+
+}
+
+/**
+ * @brief Divides the frequency of 100 Hz down and executes the slow stages
+ *
+ * This is executed every 10 ms once `timer_tick()` has reached the
+ * appropriate stage. It divides this frequency down into various smaller
+ * frequencies and executes the appropriate functions sequentially. Deferred
+ * work is only marked as pending within `timer_pending` and executed later on
+ * by `timer_handle()`, which is triggered by posting `EVENT_TIMER`. Armed
+ * software timers are counted down with the stage of their resolution.
+ *
+ * With `TIMER_NESTED_INTERRUPTS` enabled this is executed with interrupts
+ * enabled, but never in a nested way (see `timer_run_slow()`).
+ *
+ * @see timer_tick()
+ * @see INTERRUPT_100HZ
+ * @see INTERRUPT_10HZ
+ * @see INTERRUPT_1HZ
+ * @see INTERRUPT_1M
+ * @see timer_pending
+ * @see timer_wheel_step()
+ */
+static void timer_tick_slow()
+{
+
+    static uint8_t minutes_counter;
 
     INTERRUPT_100HZ;
 
-    if (++tenths_counter != 10) {
+    if (timer_armed[TIMER_10MS]) {
+
+        timer_wheel_step(TIMER_10MS);
+
+    }
+
+    if (++timer_tenths_counter != 10) {
 
         return;
 
     }
 
-    tenths_counter = 0;
+    timer_tenths_counter = 0;
 
     INTERRUPT_10HZ;
 
-    if (++seconds_counter != 10) {
+    if (timer_armed[TIMER_100MS]) {
+
+        timer_wheel_step(TIMER_100MS);
+
+    }
+
+    timer_pending |= _BV(TIMER_PENDING_10HZ);
+    event_post(EVENT_TIMER);
+
+    if (++timer_seconds_counter != 10) {
 
         return;
 
     }
 
-    seconds_counter = 0;
+    timer_seconds_counter = 0;
 
     INTERRUPT_1HZ;
 
+    if (timer_armed[TIMER_1S]) {
+
+        timer_wheel_step(TIMER_1S);
+
+    }
+
+    timer_pending |= _BV(TIMER_PENDING_1HZ);
+
     minutes_counter++;
 
     if (minutes_counter != 60) {
@@ -198,5 +938,116 @@ ISR(TIMER1_CAPT_vect)
     minutes_counter = 0;
 
     INTERRUPT_1M;
+    timer_pending |= _BV(TIMER_PENDING_1M);
+
+}
+
+#if (TIMER_NESTED_INTERRUPTS == 1)
+
+    /**
+     * @brief Executes the slow stages with interrupts enabled
+     *
+     * This is invoked by `ISR(TIMER1_CAPT_vect)` with interrupts disabled
+     * whenever a stage of 10 ms has been reached. Interrupts are enabled
+     * while `timer_tick_slow()` is being executed, so the next tick of the
+     * timer might interrupt it. In this case the nested invocation only
+     * marks its stage as pending (`timer_slow_pending`) and returns right
+     * away, while the outer invocation executes it once it has finished
+     * with the current one. The stack therefore grows by a single nested
+     * execution of the fast stages at most, and the order of the stages is
+     * preserved.
+     *
+     * Interrupts are disabled again once this returns.
+     *
+     * @see TIMER_NESTED_INTERRUPTS
+     * @see timer_slow_pending
+     * @see timer_slow_running
+     * @see timer_tick_slow()
+     */
+    static inline void timer_run_slow()
+    {
+
+        timer_slow_pending++;
+
+        if (timer_slow_running) {
+
+            return;
+
+        }
+
+        timer_slow_running = true;
+
+        do {
+
+            timer_slow_pending--;
+
+            sei();
+            timer_tick_slow();
+            cli();
+
+        } while (timer_slow_pending);
+
+        timer_slow_running = false;
+
+    }
+
+#else
+
+    /**
+     * @brief Executes the slow stages right away
+     *
+     * Interrupts remain disabled in this case.
+     *
+     * @see TIMER_NESTED_INTERRUPTS
+     * @see timer_tick_slow()
+     */
+    #define timer_run_slow() timer_tick_slow()
+
+#endif /* (TIMER_NESTED_INTERRUPTS == 1) */
+
+/**
+ * @brief Timer/Counter1 compare handler (ISR)
+ *
+ * This function is called with the frequency defined by F_INTERRUPT. The
+ * actual work is done by `timer_tick()` and, every 10 ms, by
+ * `timer_run_slow()`. An overrun is recorded by the profiler (see
+ * ENABLE_DEBUG_ISR_PROFILE) once the next tick has already been triggered
+ * before the previous one has finished. With `TIMER_NESTED_INTERRUPTS`
+ * enabled, the measured durations include whatever interrupted the slow
+ * stages.
+ *
+ * @note The timer needs to be initialized before this ISR will be executed.
+ *
+ * @warning You should make sure that the defined functions are short enough
+ * to guarantee correct timings. Otherwise some interrupts could be missed,
+ * which obviously would mess things up. This applies to `INTERRUPT_10000HZ`
+ * and `INTERRUPT_1000HZ` in particular, as they can never be interrupted.
+ *
+ * @see timer_init()
+ * @see F_INTERRUPT
+ * @see INTERRUPT_10000HZ
+ * @see INTERRUPT_1000HZ
+ * @see INTERRUPT_100HZ
+ * @see INTERRUPT_10HZ
+ * @see INTERRUPT_1HZ
+ * @see INTERRUPT_1M
+ * @see timer_pending
+ * @see timer_handle()
+ * @see timer_tick()
+ * @see timer_run_slow()
+ */
+ISR(TIMER1_CAPT_vect)
+{
+
+    PROFILE_ISR_ENTER();
+    MEMCHECK_ISR_ENTER(PROFILE_ISR_TIMER);
+
+    if (timer_tick()) {
+
+        timer_run_slow();
+
+    }
+
+    PROFILE_ISR_EXIT(PROFILE_ISR_TIMER, TIFR1 & _BV(ICF1));
 
 }
@@ -27,6 +27,14 @@
  * functions previously defined on a regular basis.
  *
  * In order to initialize this module `timer_init()` needs to be called once.
+ * Functions that are not time critical are executed from within the main
+ * loop, which needs to call `timer_handle()` on a regular basis.
+ *
+ * On top of that it provides software timers (`timer_start()`) with a
+ * resolution of 1 ms up to 1 s, which execute a callback once they have
+ * expired. Only timers that are currently armed are counted down, so modules
+ * don't need to maintain counters of their own, which would be decremented
+ * with every tick.
  *
  * @see timer.c
  */
@@ -34,6 +42,178 @@
 #ifndef _WC_TIMER_H_
 #define _WC_TIMER_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+/**
+ * @brief Resolutions software timers can be started with
+ *
+ * Each resolution corresponds to a stage of the tick cascade within
+ * `timer_tick()` and `timer_tick_slow()`. The remaining ticks of a software
+ * timer are only counted down when the appropriate stage is reached.
+ *
+ * @see timer_start()
+ */
+typedef enum {
+
+    TIMER_1MS,
+    TIMER_10MS,
+    TIMER_100MS,
+    TIMER_1S,
+
+    TIMER_RESOLUTION_COUNT
+
+} timer_resolution_t;
+
+/**
+ * @brief Mask for the resolution within the flags passed to `timer_start()`
+ *
+ * @see timer_resolution_t
+ */
+#define TIMER_RESOLUTION_MASK 0x03
+
+/**
+ * @brief Flag for `timer_start()` indicating a periodic timer
+ *
+ * Periodic timers are restarted with the same amount of ticks once they have
+ * expired, otherwise they are stopped.
+ */
+#define TIMER_PERIODIC 0x04
+
+/**
+ * @brief Flag for `timer_start()` indicating that the callback is deferred
+ *
+ * Callbacks of deferred timers are not executed from within the ISR, but
+ * from within the main loop by `timer_handle()`, i.e. with a latency of up to
+ * 100 ms. Without this flag callbacks are executed from within
+ * `ISR(TIMER1_CAPT_vect)` and need to be short.
+ *
+ * @see timer_handle()
+ */
+#define TIMER_DEFERRED 0x08
+
+/**
+ * @brief Controls whether the slower stages of the tick cascade can be
+ * interrupted
+ *
+ * AVRs have no interrupt priorities, so other interrupts (e.g. incoming
+ * data via UART) would otherwise be blocked while `INTERRUPT_100HZ` and the
+ * stages below it are being executed. If enabled, only the stages of 1 kHz
+ * and above are executed with interrupts disabled. The slower stages
+ * re-enable them, so other interrupts and even the next tick of the timer
+ * itself can be handled in between. Ticks of 10 ms that are due while the
+ * slower stages are still running are not executed in a nested way, but
+ * right afterwards.
+ *
+ * Functions within the slower stages (and callbacks of software timers with
+ * resolutions of 10 ms and above) therefore need to protect data shared
+ * with other ISRs, just like the main loop does.
+ *
+ * @see ISR(TIMER1_CAPT_vect)
+ * @see timer_tick_slow()
+ */
+#define TIMER_NESTED_INTERRUPTS 1
+
+/**
+ * @brief Enumeration of all the software timers
+ *
+ * Each timer is represented by a single bit within the masks of the timer
+ * module, so there can be eight timers at most. A timer can only be started
+ * once at a time, starting it again restarts it.
+ *
+ * @see timer_start()
+ */
+typedef enum {
+
+    /**
+     * @brief Next step of the "pulse" mode
+     *
+     * @see PulseState_step()
+     */
+    TIMER_USER_PULSE,
+
+    /**
+     * @brief Delay in the recognition of repeated key presses
+     *
+     * @see USER_KEY_PRESS_DELAY_100MS
+     */
+    TIMER_USER_KEY,
+
+    /**
+     * @brief Duration a number is being shown
+     *
+     * @see USER_NORMAL_SHOW_NUMBER_DELAY_100MS
+     */
+    TIMER_USER_SHOW_NUMBER,
+
+    /**
+     * @brief Next step of the "demo" mode
+     *
+     * @see USER_DEMO_CHANGE_INT_100MS
+     */
+    TIMER_USER_DEMO,
+
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        /**
+         * @brief Next step of the "hue fading" mode
+         *
+         * @see user_prefs_t::hueChangeInterval
+         */
+        TIMER_USER_HUE,
+
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+    /**
+     * @brief Delay before saving changed preferences to the EEPROM
+     *
+     * @see USER_DELAY_BEFORE_SAVE_EEPROM_S
+     */
+    TIMER_USER_SAVE,
+
+    /**
+     * @brief Delay before checking whether to autoOff after a reset
+     *
+     * @see USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S
+     */
+    TIMER_USER_AUTO_OFF,
+
+    /**
+     * @brief Blinking of words on the display
+     *
+     * @see DISPLAY_BLINK_INT_100MS
+     */
+    TIMER_DISPLAY_BLINK,
+
+    TIMER_COUNT
+
+} timer_id_t;
+
+/**
+ * @brief Type of the callbacks executed once a software timer has expired
+ *
+ * @see timer_start()
+ */
+typedef void (*timer_callback_t)();
+
 extern void timer_init();
 
+extern void timer_handle();
+
+extern uint16_t timer_get_ms();
+
+extern uint32_t timer_get_uptime_ms();
+
+extern uint16_t timer_get_100us();
+
+extern void timer_align_1hz(uint16_t ms);
+
+extern void timer_start(timer_id_t id, uint8_t flags, uint8_t ticks, timer_callback_t callback);
+
+extern void timer_stop(timer_id_t id);
+
+extern bool timer_is_armed(timer_id_t id);
+
 #endif /* _WC_TIMER_H_ */
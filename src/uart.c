@@ -36,9 +36,16 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/delay.h>
+
+#include <string.h>
 
 #include "uart.h"
+#include "event.h"
 #include "fifo.h"
+#include "health.h"
+#include "memcheck.h"
+#include "profile.h"
 
 /**
  * @brief The baud rate used for the serial communication
@@ -54,6 +61,12 @@
 
 #include <util/setbaud.h>
 
+#if !FIFO_SIZE_VALID(UART_BUFFER_SIZE_IN) || !FIFO_SIZE_VALID(UART_BUFFER_SIZE_OUT)
+
+    #error "UART buffer sizes need to be a power of two (see FIFO_SIZE_VALID())"
+
+#endif
+
 
 /**
  * @brief Buffer used for incoming data
@@ -93,6 +106,136 @@ static uint8_t uart_buffer_out[UART_BUFFER_SIZE_OUT];
  */
 fifo_t uart_fifo_out;
 
+/**
+ * @brief Statistics about the data received
+ *
+ * @see uart_get_stats()
+ * @see uart_reset_stats()
+ */
+static uart_stats_t uart_stats;
+
+#if (UART_FLOW_CONTROL == 1)
+
+    #if (UART_FLOW_CONTROL_HIGH_WATERMARK <= UART_FLOW_CONTROL_LOW_WATERMARK)
+
+        #error "UART_FLOW_CONTROL_HIGH_WATERMARK needs to be above UART_FLOW_CONTROL_LOW_WATERMARK"
+
+    #endif
+
+    /**
+     * @brief Indicates whether flow control is currently applied
+     *
+     * @see uart_set_flow_control()
+     */
+    static volatile bool uart_flow_control_enabled = true;
+
+    /**
+     * @brief Indicates whether XOFF has been sent, but XON has not yet
+     *
+     * This is only set by ISR(USART_RX_vect) and only cleared from outside of
+     * it with interrupts disabled.
+     *
+     * @see uart_flow_control_resume()
+     */
+    static volatile bool uart_flow_control_stopped;
+
+    /**
+     * @brief Flow control character to put out next, zero if there is none
+     *
+     * @see uart_flow_control_send()
+     * @see ISR(USART_UDRE_vect)
+     */
+    static volatile uint8_t uart_flow_control_pending;
+
+    /**
+     * @brief Puts out the given flow control character
+     *
+     * The character is put out by ISR(USART_UDRE_vect) ahead of the data
+     * within the transmit buffer. It replaces any character that hasn't been
+     * put out yet.
+     *
+     * @note This needs to be invoked with interrupts disabled.
+     *
+     * @param c Flow control character, i.e. UART_FLOW_CONTROL_XON or
+     * UART_FLOW_CONTROL_XOFF
+     *
+     * @see uart_flow_control_pending
+     */
+    static void uart_flow_control_send(uint8_t c)
+    {
+
+        uart_flow_control_pending = c;
+        UCSR0B |= _BV(UDRIE0);
+
+    }
+
+    /**
+     * @brief Sends XON once the receive buffer has been drained sufficiently
+     *
+     * This needs to be invoked whenever something has been retrieved from
+     * the receive buffer.
+     *
+     * @see UART_FLOW_CONTROL_LOW_WATERMARK
+     */
+    static void uart_flow_control_resume()
+    {
+
+        if (uart_flow_control_stopped
+                && fifo_count(&uart_fifo_in) <= UART_FLOW_CONTROL_LOW_WATERMARK) {
+
+            uint8_t sreg = SREG;
+            cli();
+
+            uart_flow_control_stopped = false;
+            uart_flow_control_send(UART_FLOW_CONTROL_XON);
+
+            SREG = sreg;
+
+        }
+
+    }
+
+    /**
+     * @brief Enables or disables flow control at runtime
+     *
+     * This can be used whenever the data being exchanged may contain the
+     * flow control characters themselves, e.g. binary frames. When disabling
+     * it while the host is paused, XON is sent right away.
+     *
+     * @param enable True to apply flow control, false otherwise
+     *
+     * @see uart_flow_control_enabled
+     */
+    void uart_set_flow_control(bool enable)
+    {
+
+        uint8_t sreg = SREG;
+        cli();
+
+        uart_flow_control_enabled = enable;
+
+        if (!enable && uart_flow_control_stopped) {
+
+            uart_flow_control_stopped = false;
+            uart_flow_control_send(UART_FLOW_CONTROL_XON);
+
+        }
+
+        SREG = sreg;
+
+    }
+
+#else
+
+    /**
+     * @brief Empty macro in case flow control is disabled
+     *
+     * @see UART_FLOW_CONTROL
+     */
+    #define uart_flow_control_resume()
+
+#endif /* (UART_FLOW_CONTROL == 1) */
+
 /**
  * @brief Initializes the UART hardware
  *
@@ -125,7 +268,7 @@ void uart_init()
 
     #if (USE_2X)
 
-        UCSR0A |= _BV(U2X);
+        UCSR0A |= _BV(U2X0);
 
     #endif
 
@@ -142,16 +285,97 @@ void uart_init()
  * This ISR processes all of the data coming in via UART. It simply puts the
  * received data into the appropriate buffer (uart_fifo_in).
  *
- * @note As the return value of {@link fifo_put()} is ignored, data might
- * be lost once the appropriate FIFO is full.
+ * Data that doesn't fit into the FIFO anymore is lost. This, along with
+ * data overruns reported by the hardware, is kept track of within
+ * uart_stats and the health counters (see HEALTH_UART_RX_DROPS). With
+ * UART_FLOW_CONTROL enabled, the host is asked to pause before the FIFO is
+ * actually full.
  *
  * @see fifo_put()
  * @see uart_fifo_in
+ * @see uart_stats
  */
 ISR(USART_RX_vect)
 {
 
-    fifo_put(&uart_fifo_in, UDR0);
+    PROFILE_ISR_ENTER();
+    MEMCHECK_ISR_ENTER(PROFILE_ISR_USART_RX);
+
+    // Status needs to be read before the data register
+    uint8_t status = UCSR0A;
+
+    if (status & _BV(DOR0)) {
+
+        if (uart_stats.overruns < UINT16_MAX) {
+
+            uart_stats.overruns++;
+
+        }
+
+        health_count(HEALTH_UART_RX_DROPS);
+
+    }
+
+    if (!fifo_put(&uart_fifo_in, UDR0)) {
+
+        if (uart_stats.dropped < UINT16_MAX) {
+
+            uart_stats.dropped++;
+
+        }
+
+        health_count(HEALTH_UART_RX_DROPS);
+
+    }
+
+    #if (UART_FLOW_CONTROL == 1)
+
+        if (uart_flow_control_enabled && !uart_flow_control_stopped
+                && fifo_count(&uart_fifo_in) >= UART_FLOW_CONTROL_HIGH_WATERMARK) {
+
+            uart_flow_control_stopped = true;
+            uart_flow_control_send(UART_FLOW_CONTROL_XOFF);
+
+        }
+
+    #endif /* (UART_FLOW_CONTROL == 1) */
+
+    event_post(EVENT_UART);
+
+    PROFILE_ISR_EXIT(PROFILE_ISR_USART_RX, status & _BV(DOR0));
+
+}
+
+/**
+ * @brief Retrieves the next byte to transmit - if available
+ *
+ * Pending flow control characters take precedence over the data within the
+ * transmission FIFO.
+ *
+ * @param data Pointer to location where the byte will be put
+ *
+ * @return True if there is something to transmit, false otherwise
+ *
+ * @see uart_fifo_out
+ * @see uart_flow_control_pending
+ */
+static inline bool uart_get_next_byte(uint8_t* data)
+{
+
+    #if (UART_FLOW_CONTROL == 1)
+
+        if (uart_flow_control_pending) {
+
+            *data = uart_flow_control_pending;
+            uart_flow_control_pending = 0;
+
+            return true;
+
+        }
+
+    #endif /* (UART_FLOW_CONTROL == 1) */
+
+    return fifo_get_nowait(&uart_fifo_out, data);
 
 }
 
@@ -164,16 +388,18 @@ ISR(USART_RX_vect)
  * case.
  *
  * @see uart_fifo_out
- * @see fifo_get_nowait()
+ * @see uart_get_next_byte()
  */
 ISR(USART_UDRE_vect)
 {
 
-    if (uart_fifo_out.count > 0) {
+    PROFILE_ISR_ENTER();
+    MEMCHECK_ISR_ENTER(PROFILE_ISR_USART_UDRE);
+
+    uint8_t data;
 
-        uint8_t data;
+    if (uart_get_next_byte(&data)) {
 
-        fifo_get_nowait(&uart_fifo_out, &data);
         UDR0 = data;
 
     } else {
@@ -181,6 +407,137 @@ ISR(USART_UDRE_vect)
         UCSR0B &= ~_BV(UDRIE0);
 
     }
+
+    PROFILE_ISR_EXIT(PROFILE_ISR_USART_UDRE, false);
+
+}
+
+/**
+ * @brief Waits for space within the transmission FIFO
+ *
+ * This busy waits for up to UART_TX_TIMEOUT_MS for the transmission FIFO to
+ * have some space left. It returns immediately when there already is some
+ * space, when no timeout has been configured and/or when interrupts are
+ * disabled, as the FIFO could not be emptied in this case anyway.
+ *
+ * @return True if there is space left within the FIFO, false otherwise
+ *
+ * @see UART_TX_TIMEOUT_MS
+ * @see uart_fifo_out
+ */
+static bool uart_wait_for_space()
+{
+
+    #if (UART_TX_TIMEOUT_MS > 0)
+
+        if (SREG & _BV(SREG_I)) {
+
+            for (uint16_t i = 0; i < UART_TX_TIMEOUT_MS * 10; i++) {
+
+                if (fifo_free(&uart_fifo_out)) {
+
+                    return true;
+
+                }
+
+                _delay_us(100);
+
+            }
+
+        }
+
+    #endif
+
+    return fifo_free(&uart_fifo_out) != 0;
+
+}
+
+/**
+ * @brief Transmits a block of data
+ *
+ * This puts as much of the given data into the transmission FIFO as there is
+ * space left and enables the UART data register empty interrupt once for each
+ * chunk. In case the whole block fits into the FIFO, space for it is reserved
+ * with a single operation. Otherwise it waits for more space to become
+ * available (see UART_TX_TIMEOUT_MS).
+ *
+ * @param data Pointer to the data to transmit
+ * @param length Number of bytes to transmit
+ * @param progmem True if data is stored in program space, false otherwise
+ *
+ * @return True if the whole block was put into the FIFO, false otherwise
+ *
+ * @see uart_wait_for_space()
+ * @see fifo_put_n()
+ * @see fifo_put_n_p()
+ */
+static bool _uart_put_block(const uint8_t* data, size_t length, bool progmem)
+{
+
+    while (length) {
+
+        if (!uart_wait_for_space()) {
+
+            health_count(HEALTH_UART_TX_DROPS);
+
+            return false;
+
+        }
+
+        uint8_t chunk = length > UINT8_MAX ? UINT8_MAX : length;
+
+        if (progmem) {
+
+            chunk = fifo_put_n_p(&uart_fifo_out, data, chunk);
+
+        } else {
+
+            chunk = fifo_put_n(&uart_fifo_out, data, chunk);
+
+        }
+
+        UCSR0B |= _BV(UDRIE0);
+
+        data += chunk;
+        length -= chunk;
+
+    }
+
+    return true;
+
+}
+
+/**
+ * @brief Transmits a block of data
+ *
+ * @param data Pointer to the data to transmit
+ * @param length Number of bytes to transmit
+ *
+ * @return True if the whole block was put into the FIFO, false otherwise
+ *
+ * @see _uart_put_block()
+ */
+bool uart_put_block(const void* data, size_t length)
+{
+
+    return _uart_put_block(data, length, false);
+
+}
+
+/**
+ * @brief Transmits a complete string stored in program memory as block
+ *
+ * @param str Pointer to string stored in program memory to transmit
+ *
+ * @return True if the whole string was put into the FIFO, false otherwise
+ *
+ * @see _uart_put_block()
+ */
+bool uart_puts_p_block(PGM_P str)
+{
+
+    return _uart_put_block((const uint8_t*)str, strlen_P(str), true);
+
 }
 
 /**
@@ -206,14 +563,23 @@ ISR(USART_UDRE_vect)
  *
  * @see uart_fifo_out
  * @see ISR(USART_UDRE_vect)
+ * @see UART_TX_TIMEOUT_MS
  */
 bool uart_putc(char c)
 {
 
+    uart_wait_for_space();
+
     bool result = fifo_put(&uart_fifo_out, c);
 
     UCSR0B |= _BV(UDRIE0);
 
+    if (!result) {
+
+        health_count(HEALTH_UART_TX_DROPS);
+
+    }
+
     return result;
 
 }
@@ -239,7 +605,43 @@ bool uart_putc(char c)
 bool uart_getc_nowait(char* c)
 {
 
-    return fifo_get_nowait(&uart_fifo_in, (uint8_t*)c);
+    bool result = fifo_get_nowait(&uart_fifo_in, (uint8_t*)c);
+
+    uart_flow_control_resume();
+
+    return result;
+
+}
+
+/**
+ * @brief Returns whether there are received bytes not yet retrieved
+ *
+ * @return True if at least one byte is available, false otherwise
+ *
+ * @see uart_fifo_in
+ * @see uart_getc_nowait()
+ */
+bool uart_available()
+{
+
+    return fifo_count(&uart_fifo_in) != 0;
+
+}
+
+/**
+ * @brief Returns the number of bytes that can be transmitted without waiting
+ *
+ * This can be used to put out messages only when they fit into the
+ * transmission FIFO as a whole.
+ *
+ * @return Number of bytes left within the transmission FIFO
+ *
+ * @see uart_fifo_out
+ */
+uint8_t uart_free()
+{
+
+    return fifo_free(&uart_fifo_out);
 
 }
 
@@ -262,7 +664,45 @@ bool uart_getc_nowait(char* c)
 char uart_getc_wait()
 {
 
-    return fifo_get_wait(&uart_fifo_in);
+    char c = fifo_get_wait(&uart_fifo_in);
+
+    uart_flow_control_resume();
+
+    return c;
+
+}
+
+/**
+ * @brief Retrieves the statistics about the data received
+ *
+ * @param stats Pointer to buffer where the statistics should be stored
+ *
+ * @see uart_stats_t
+ * @see uart_reset_stats()
+ */
+void uart_get_stats(uart_stats_t* stats)
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    *stats = uart_stats;
+    SREG = sreg;
+
+}
+
+/**
+ * @brief Resets the statistics about the data received
+ *
+ * @see uart_stats_t
+ * @see uart_get_stats()
+ */
+void uart_reset_stats()
+{
+
+    uint8_t sreg = SREG;
+    cli();
+    uart_stats = (uart_stats_t){0};
+    SREG = sreg;
 
 }
 
@@ -270,21 +710,17 @@ char uart_getc_wait()
  * @brief Transmits a complete string
  *
  * This functions transmits a complete string. The string needs to be null
- * terminated. Internally it makes use of uart_putc(), so each character will
- * be processed individually.
+ * terminated. Internally it makes use of uart_put_block(), so the string is
+ * processed as a whole.
  *
  * @param s Pointer to string to transmit
  *
- * @see uart_putc()
+ * @see uart_put_block()
  */
 void uart_puts(const char* str)
 {
 
-    while (*str) {
-
-        uart_putc(*str++);
-
-    }
+    uart_put_block(str, strlen(str));
 
 }
 
@@ -293,27 +729,19 @@ void uart_puts(const char* str)
  *
  * This functions transmits a complete string stored in program memory. The
  * string needs to be null terminated. Internally it makes use of
- * pgm_read_byte() to retrieve the data and uart_putc(), so each character will
- * be processed individually.
+ * uart_puts_p_block(), so the string is processed as a whole.
  *
  * @param s Pointer to string stored in program memory to transmit
  *
  * uart_puts_P() can be used to put strings into program space quite easily.
  *
  * @see uart_puts_P()
- * @see uart_putc()
- * @see pgm_read_byte()
+ * @see uart_puts_p_block()
  */
 void uart_puts_p(PGM_P str)
 {
 
-    char c;
-
-    while ((c = pgm_read_byte(str++)) != '\0') {
-
-        uart_putc(c);
-
-    }
+    uart_puts_p_block(str);
 
 }
 
@@ -38,34 +38,163 @@
 #include <avr/pgmspace.h>
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
- * @brief The baud rate used for the serial communication
+ * @brief Selects the high speed profile for the serial communication
  *
- * The value should be considered carefully as it directly influences the
- * resulting error rate, which is even more important when no real crystal is
- * being used. Refer to the datasheet for details [1], p. 195ff, table 20-9.
+ * If set to 1, a higher baud rate (UART_BAUD) along with bigger buffers
+ * (UART_BUFFER_SIZE_IN, UART_BUFFER_SIZE_OUT) will be used. This is useful
+ * whenever a lot of data needs to be transmitted, e.g. when debugging
+ * output is enabled (LOG_PREFERENCES_INIT, etc.). Otherwise the default
+ * settings (9600 baud) will be used.
  *
- * [1]: http://www.atmel.com/images/doc2545.pdf
+ * @note `<util/setbaud.h>` will enable the double speed mode (`USE_2X`)
+ * whenever necessary to stay within the tolerated error rate.
  *
  * @see UART_BAUD
- * @see uart_init()
+ * @see UART_BUFFER_SIZE_IN
+ * @see UART_BUFFER_SIZE_OUT
  */
-#define UART_BAUD 9600
+#define UART_HIGH_SPEED_PROFILE 0
+
+#if (UART_HIGH_SPEED_PROFILE == 1)
+
+    /**
+     * @brief The baud rate used for the serial communication
+     *
+     * The value should be considered carefully as it directly influences the
+     * resulting error rate, which is even more important when no real crystal
+     * is being used. Refer to the datasheet for details [1], p. 195ff, table
+     * 20-9.
+     *
+     * [1]: http://www.atmel.com/images/doc2545.pdf
+     *
+     * @see UART_HIGH_SPEED_PROFILE
+     * @see uart_init()
+     */
+    #define UART_BAUD 38400
+
+    /**
+     * @brief Defines the size of uart_buffer_in
+     *
+     * @note This needs to be a power of two, see FIFO_SIZE_VALID().
+     *
+     * @see uart_buffer_in
+     */
+    #define UART_BUFFER_SIZE_IN 64
+
+    /**
+     * @brief Defines the size of uart_buffer_out
+     *
+     * @note This needs to be a power of two, see FIFO_SIZE_VALID().
+     *
+     * @see uart_buffer_out
+     */
+    #define UART_BUFFER_SIZE_OUT 128
+
+#else
+
+    #define UART_BAUD 9600
+    #define UART_BUFFER_SIZE_IN 32
+    #define UART_BUFFER_SIZE_OUT 64
+
+#endif /* (UART_HIGH_SPEED_PROFILE == 1) */
+
+/**
+ * @brief Time in milliseconds to wait for space within the transmit buffer
+ *
+ * If set to 0, data that doesn't fit into the transmit buffer is dropped
+ * immediately. Otherwise the transmitting functions (uart_putc(),
+ * uart_put_block(), etc.) will block for up to this amount of time whenever
+ * the buffer is full, waiting for the ISR to make room. The timeout applies
+ * each time no progress is made, so long transmissions will get through
+ * intact, as long as the data is actually being transmitted.
+ *
+ * @note When interrupts are disabled, the functions will never block, as the
+ * buffer can't be emptied in this case anyway.
+ *
+ * @see uart_put_block()
+ */
+#define UART_TX_TIMEOUT_MS 0
+
+/**
+ * @brief Enables software flow control (XON/XOFF) for incoming data
+ *
+ * If set to 1, XOFF (UART_FLOW_CONTROL_XOFF) is sent once the receive buffer
+ * has been filled up to UART_FLOW_CONTROL_HIGH_WATERMARK, and XON
+ * (UART_FLOW_CONTROL_XON) once it has been drained down to
+ * UART_FLOW_CONTROL_LOW_WATERMARK again. Both characters are put out ahead
+ * of anything else waiting within the transmit buffer. This allows hosts
+ * with their software flow control (`IXOFF`) enabled to send commands back
+ * to back without waiting for the responses.
+ *
+ * @note Hardware flow control (RTS/CTS) is not supported, as there are no
+ * pins left for it.
+ *
+ * @note Flow control is only applied to incoming data. Any XON/XOFF sent by
+ * the host is treated as ordinary data.
+ *
+ * @see uart_set_flow_control()
+ */
+#define UART_FLOW_CONTROL 0
+
+/**
+ * @brief Character sent to resume the transmission of the host
+ *
+ * @see UART_FLOW_CONTROL
+ */
+#define UART_FLOW_CONTROL_XON 0x11
 
 /**
- * @brief Defines the size of uart_buffer_in
+ * @brief Character sent to pause the transmission of the host
  *
- * @see uart_buffer_in
+ * @see UART_FLOW_CONTROL
  */
-#define UART_BUFFER_SIZE_IN 32
+#define UART_FLOW_CONTROL_XOFF 0x13
 
 /**
- * @brief Defines the size of uart_buffer_out
+ * @brief Number of bytes within the receive buffer triggering XOFF
  *
- * @see uart_buffer_out
+ * The space left above this needs to take up the bytes the host is sending
+ * before it reacts to XOFF.
+ *
+ * @see UART_FLOW_CONTROL
+ */
+#define UART_FLOW_CONTROL_HIGH_WATERMARK (UART_BUFFER_SIZE_IN * 3 / 4)
+
+/**
+ * @brief Number of bytes within the receive buffer triggering XON
+ *
+ * @see UART_FLOW_CONTROL
+ */
+#define UART_FLOW_CONTROL_LOW_WATERMARK (UART_BUFFER_SIZE_IN / 4)
+
+/**
+ * @brief Statistics about the data received
+ *
+ * All of the counters saturate at their maximum value.
+ *
+ * @see uart_get_stats()
+ * @see uart_reset_stats()
  */
-#define UART_BUFFER_SIZE_OUT 64
+typedef struct {
+
+    /**
+     * @brief Number of bytes dropped because the receive buffer was full
+     */
+    uint16_t dropped;
+
+    /**
+     * @brief Number of data overruns detected by the hardware
+     *
+     * Each of these means that at least one byte was lost before the ISR
+     * could retrieve it.
+     */
+    uint16_t overruns;
+
+} uart_stats_t;
 
 extern void uart_init();
 
@@ -75,10 +204,37 @@ extern char uart_getc_wait();
 
 extern bool uart_getc_nowait(char* c);
 
+extern bool uart_available();
+
+extern uint8_t uart_free();
+
 extern void uart_puts(const char* str);
 
 extern void uart_puts_p(PGM_P str);
 
+extern bool uart_put_block(const void* data, size_t length);
+
+extern bool uart_puts_p_block(PGM_P str);
+
+extern void uart_get_stats(uart_stats_t* stats);
+
+extern void uart_reset_stats();
+
+#if (UART_FLOW_CONTROL == 1)
+
+    extern void uart_set_flow_control(bool enable);
+
+#else
+
+    /**
+     * @brief Empty macro in case flow control is disabled
+     *
+     * @see UART_FLOW_CONTROL
+     */
+    #define uart_set_flow_control(enable)
+
+#endif /* (UART_FLOW_CONTROL == 1) */
+
 /**
  * @brief Macro used to automatically put a string constant into program memory
  *
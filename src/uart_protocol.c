@@ -27,6 +27,11 @@
  * character has been detected. Callback functions process each command
  * individually.
  *
+ * If ENABLE_UART_PROTOCOL_BINARY is set, the protocol can be switched into
+ * a binary mode, in which commands are received as frames (see
+ * uart_protocol_handle_frame()). The callbacks are the same in both modes,
+ * only the input and output helpers behave differently.
+ *
  * @see uart_protocol.h
  * @see uart.h
  */
@@ -36,12 +41,16 @@
 #include <avr/wdt.h>
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <string.h>
-#include <stdio.h>
+#include <util/crc16.h>
 
 #include "config.h"
 #include "datetime.h"
+#include "dcf77.h"
+#include "display.h"
 #include "format.h"
+#include "health.h"
 #include "ldr.h"
 #include "memcheck.h"
 #include "uart.h"
@@ -50,8 +59,150 @@
 #include "user_command.h"
 #include "pwm.h"
 #include "preferences.h"
+#include "profile.h"
 #include "version.h"
 
+#if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+    /**
+     * @brief Status of a frame indicating success
+     *
+     * @see uart_protocol_frame_begin()
+     */
+    #define UART_PROTOCOL_FRAME_STATUS_OK 0x00
+
+    /**
+     * @brief Status of a frame indicating an error
+     *
+     * @see uart_protocol_frame_begin()
+     */
+    #define UART_PROTOCOL_FRAME_STATUS_ERROR 0x01
+
+    /**
+     * @brief Status of a frame containing a telemetry record
+     *
+     * @see uart_protocol_telemetry_handle()
+     */
+    #define UART_PROTOCOL_FRAME_STATUS_TELEMETRY 0x02
+
+    /**
+     * @brief Indicates whether the binary mode is currently active
+     *
+     * @see _binary_mode()
+     */
+    static bool uart_protocol_binary_mode = false;
+
+    /**
+     * @brief CRC-8 of the frame currently being output
+     *
+     * @see uart_protocol_frame_putc()
+     */
+    static uint8_t uart_protocol_frame_crc;
+
+    /**
+     * @brief Outputs a single byte of a frame
+     *
+     * The byte is also taken into account for the checksum of the frame.
+     *
+     * @param c Byte to output
+     *
+     * @see uart_protocol_frame_crc
+     */
+    static void uart_protocol_frame_putc(uint8_t c)
+    {
+
+        uart_protocol_frame_crc = _crc8_ccitt_update(uart_protocol_frame_crc, c);
+        uart_putc(c);
+
+    }
+
+    /**
+     * @brief Starts a new frame
+     *
+     * A frame consists of its length (status plus payload), the status, the
+     * payload and the CRC-8 of everything preceding it. After invoking this
+     * exactly length bytes of payload need to be put out by means of
+     * uart_protocol_frame_putc() before finishing the frame with
+     * uart_protocol_frame_end().
+     *
+     * @param length Length of the payload
+     * @param status Status of the response, e.g. UART_PROTOCOL_FRAME_STATUS_OK
+     *
+     * @see uart_protocol_frame_putc()
+     * @see uart_protocol_frame_end()
+     */
+    static void uart_protocol_frame_begin(uint8_t length, uint8_t status)
+    {
+
+        uart_flush_output();
+
+        uart_protocol_frame_crc = 0;
+        uart_protocol_frame_putc(length + 1);
+        uart_protocol_frame_putc(status);
+
+    }
+
+    /**
+     * @brief Finishes the frame by putting out its checksum
+     *
+     * @see uart_protocol_frame_begin()
+     */
+    static void uart_protocol_frame_end()
+    {
+
+        uart_putc(uart_protocol_frame_crc);
+
+    }
+
+#endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
+/**
+ * @brief Request ID of the command currently being processed
+ *
+ * This contains the two hex digits following
+ * #UART_PROTOCOL_REQUEST_ID_PREFIX, or is empty when the command hasn't been
+ * preceded by a request ID.
+ *
+ * @see uart_protocol_tokenize_command_buffer()
+ * @see uart_protocol_output_prefix()
+ */
+static char uart_protocol_request_id[3];
+
+/**
+ * @brief Number of lines discarded, because they exceeded the command buffer
+ *
+ * This saturates at its maximum value.
+ *
+ * @see uart_protocol_handle()
+ * @see UART_PROTOCOL_COMMAND_BUFFER_SIZE
+ */
+static uint16_t uart_protocol_oversize_lines;
+
+/**
+ * @brief Outputs the beginning of a response
+ *
+ * This puts out #UART_PROTOCOL_OUTPUT_PREFIX followed by the request ID of
+ * the current command, if there is one.
+ *
+ * @see UART_PROTOCOL_OUTPUT_PREFIX
+ * @see uart_protocol_request_id
+ */
+static void uart_protocol_output_prefix()
+{
+
+    uart_flush_output();
+
+    uart_puts_P(UART_PROTOCOL_OUTPUT_PREFIX);
+
+    if (uart_protocol_request_id[0] != '\0') {
+
+        uart_putc(UART_PROTOCOL_REQUEST_ID_PREFIX);
+        uart_puts(uart_protocol_request_id);
+        uart_putc(' ');
+
+    }
+
+}
 
 /**
  * @brief Outputs a message in the correct format
@@ -59,15 +210,33 @@
  * This outputs the given message in the correct format (enclosed by
  * #UART_PROTOCOL_OUTPUT_PREFIX and #UART_PROTOCOL_OUTPUT_EOL).
  *
- * @see UART_PROTOCOL_OUTPUT_PREFIX
+ * @see uart_protocol_output_prefix()
  * @see UART_PROTOCOL_OUTPUT_EOL
  */
 static void uart_protocol_output(const char* message)
 {
 
-    uart_flush_output();
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
 
-    uart_puts_P(UART_PROTOCOL_OUTPUT_PREFIX);
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(strlen(message), UART_PROTOCOL_FRAME_STATUS_OK);
+
+            while (*message) {
+
+                uart_protocol_frame_putc(*message++);
+
+            }
+
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif
+
+    uart_protocol_output_prefix();
     uart_puts(message);
     uart_puts_P(UART_PROTOCOL_OUTPUT_EOL);
 
@@ -79,16 +248,36 @@ static void uart_protocol_output(const char* message)
  * This outputs the given message from program space in the correct format
  * (enclosed by #UART_PROTOCOL_OUTPUT_PREFIX and #UART_PROTOCOL_OUTPUT_EOL).
  *
- * @see UART_PROTOCOL_OUTPUT_PREFIX
+ * @see uart_protocol_output_prefix()
  * @see UART_PROTOCOL_OUTPUT_EOL
  * @see uart_protocol_output_P()
  */
 static void uart_protocol_output_p(PGM_P message)
 {
 
-    uart_flush_output();
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
 
-    uart_puts_P(UART_PROTOCOL_OUTPUT_PREFIX);
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(strlen_P(message), UART_PROTOCOL_FRAME_STATUS_OK);
+
+            char c;
+
+            while ((c = pgm_read_byte(message++))) {
+
+                uart_protocol_frame_putc(c);
+
+            }
+
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif
+
+    uart_protocol_output_prefix();
     uart_puts_p(message);
     uart_puts_P(UART_PROTOCOL_OUTPUT_EOL);
 
@@ -113,6 +302,19 @@ static void uart_protocol_output_p(PGM_P message)
 static void uart_protocol_ok()
 {
 
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(0, UART_PROTOCOL_FRAME_STATUS_OK);
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif
+
     uart_protocol_output_P("OK");
 
 }
@@ -125,6 +327,19 @@ static void uart_protocol_ok()
 static void uart_protocol_error()
 {
 
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(0, UART_PROTOCOL_FRAME_STATUS_ERROR);
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif
+
     uart_protocol_output_P("ERROR");
 
 }
@@ -138,11 +353,13 @@ static void uart_protocol_error()
  * @param argc Number of arguments
  * @param ... Actual arguments to convert and output
  *
- * @see uint8ToHexStr()
+ * @see format_hex8()
  * @see uart_protocol_output()
  *
  * @note This is a variadic function based upon `<stdarg.h>`. The number of
  * arguments varies and is described by the first argument.
+ *
+ * @note In binary mode the arguments are put out as raw bytes.
  */
 static void uart_protocol_output_args_hex(uint8_t argc, ...)
 {
@@ -150,12 +367,33 @@ static void uart_protocol_output_args_hex(uint8_t argc, ...)
     va_list va;
     va_start(va, argc);
 
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(argc, UART_PROTOCOL_FRAME_STATUS_OK);
+
+            for (uint8_t i = 0; i < argc; i++) {
+
+                uart_protocol_frame_putc((uint8_t)va_arg(va, int));
+
+            }
+
+            uart_protocol_frame_end();
+            va_end(va);
+
+            return;
+
+        }
+
+    #endif
+
     // Three bytes per character (2 byte hex representation + space/terminator)
     char str[argc * 3];
 
     for (uint8_t i = 0; i < argc; i++) {
 
-        sprintf_P(&str[i * 3], fmt_output_byte_as_hex, (uint8_t)va_arg(va, int));
+        format_hex8(&str[i * 3], (uint8_t)va_arg(va, int));
 
         if (i == argc - 1) {
 
@@ -177,6 +415,80 @@ static void uart_protocol_output_args_hex(uint8_t argc, ...)
 
 }
 
+/**
+ * @brief Puts out the hex representation of the given words and bytes
+ *
+ * The words are put out with 4 digits each, followed by the bytes with 2
+ * digits each, all of them separated by a space.
+ *
+ * @param words Words to put out
+ * @param word_count Number of words
+ * @param bytes Bytes to put out after the words, may be NULL
+ * @param byte_count Number of bytes
+ *
+ * @see format_hex16()
+ * @see uart_protocol_output()
+ *
+ * @note In binary mode the words (most significant byte first) and bytes are
+ * put out as raw bytes, just like uart_protocol_output_args_hex() does.
+ */
+static void uart_protocol_output_words(const uint16_t* words, uint8_t word_count,
+    const uint8_t* bytes, uint8_t byte_count)
+{
+
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(word_count * 2 + byte_count, UART_PROTOCOL_FRAME_STATUS_OK);
+
+            for (uint8_t i = 0; i < word_count; i++) {
+
+                uart_protocol_frame_putc(words[i] >> 8);
+                uart_protocol_frame_putc(words[i]);
+
+            }
+
+            for (uint8_t i = 0; i < byte_count; i++) {
+
+                uart_protocol_frame_putc(bytes[i]);
+
+            }
+
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif
+
+    // Five bytes per word and three bytes per byte (hex + space/terminator)
+    char str[word_count * 5 + byte_count * 3];
+    char* p = str;
+
+    for (uint8_t i = 0; i < word_count; i++) {
+
+        format_hex16(p, words[i]);
+        p[4] = ' ';
+        p += 5;
+
+    }
+
+    for (uint8_t i = 0; i < byte_count; i++) {
+
+        format_hex8(p, bytes[i]);
+        p[2] = ' ';
+        p += 3;
+
+    }
+
+    str[sizeof(str) - 1] = '\0';
+
+    uart_protocol_output(str);
+
+}
+
 /**
  * @brief Reads in hex representations from strings
  *
@@ -192,7 +504,7 @@ static void uart_protocol_output_args_hex(uint8_t argc, ...)
  *
  * @return True if data could be parsed completely, false otherwise
  *
- * @see hexStrToUint8()
+ * @see format_parse_hex8()
  *
  * @note This is a variadic function based upon `<stdarg.h>`. The number of
  * arguments varies and is described by the first argument.
@@ -200,6 +512,9 @@ static void uart_protocol_output_args_hex(uint8_t argc, ...)
  * @note The first parameter describes the number of variables to parse. As
  * there is a string pointer for each variable, there are actually twice as
  * many arguments expected.
+ *
+ * @note In binary mode each string contains the raw byte, which is simply
+ * copied over.
  */
 static bool uart_protocol_input_args_hex(uint8_t argc, ...)
 {
@@ -212,11 +527,23 @@ static bool uart_protocol_input_args_hex(uint8_t argc, ...)
     for (uint8_t i = 0; i < argc; i++) {
 
         // Get next string and variable to put content in
-        char* str = (char*)va_arg(va, int);
-        uint8_t* var = (uint8_t*)va_arg(va, int);
+        char* str = va_arg(va, char*);
+        uint8_t* var = va_arg(va, uint8_t*);
+
+        #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+            if (uart_protocol_binary_mode) {
+
+                *var = *str;
+
+                continue;
+
+            }
+
+        #endif
 
         // Leave loop immediately in case of an error
-        if (strlen(str) != 2 || sscanf_P(str, fmt_input_byte_as_hex, var) != 1) {
+        if (!format_parse_hex8(str, var)) {
 
             result = false;
 
@@ -239,9 +566,12 @@ static bool uart_protocol_input_args_hex(uint8_t argc, ...)
  * the null terminator, making the possible command length effectively one
  * character smaller than defined here.
  *
+ * @note This also needs to fit the request ID (see
+ * #UART_PROTOCOL_REQUEST_ID_PREFIX) in front of the longest command.
+ *
  * @see uart_protocol_command_buffer
  */
-#define UART_PROTOCOL_COMMAND_BUFFER_SIZE 16
+#define UART_PROTOCOL_COMMAND_BUFFER_SIZE 22
 
 /**
  * Maximum length of a command (without arguments)
@@ -270,7 +600,7 @@ static bool uart_protocol_input_args_hex(uint8_t argc, ...)
  * @see uart_protocol_tokenize_command_buffer()
  * @see uart_protocol_handle()
  */
-#define UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS 5
+#define UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS 6
 
 /**
  * @brief The actual command buffer
@@ -310,7 +640,7 @@ typedef void (*uart_protocol_command_callback_t)(uint8_t argc, char* argv[]);
  * @see uart_protocol_command_callback_t
  * @see uart_protocol_ok()
  * @see uart_protocol_error()
- * @see handle_user_command()
+ * @see user_command_handle()
  * @see user_command_t
  */
 static void _ir_user_command(uint8_t argc, char* argv[])
@@ -413,7 +743,7 @@ static void _ir_user_command(uint8_t argc, char* argv[])
 
             if (argv[1][0] == user_command_assignments[i].command) {
 
-                handle_user_command(user_command_assignments[i].user_command);
+                user_command_handle(user_command_assignments[i].user_command);
                 uart_protocol_ok();
 
                 return;
@@ -446,6 +776,26 @@ static void _version(uint8_t argc, char* argv[])
 
 }
 
+/**
+ * @brief Puts out the time it took to show the time after the last reset
+ *
+ * This puts out the hex representation (4 digits) of the milliseconds
+ * reported by user_get_boot_time(). `ffff` indicates that the time hasn't
+ * been shown yet.
+ *
+ * @see uart_protocol_command_callback_t
+ * @see user_get_boot_time()
+ * @see ENABLE_FAST_BOOT
+ */
+static void _boot_time(uint8_t argc, char* argv[])
+{
+
+    const uint16_t ms = user_get_boot_time();
+
+    uart_protocol_output_words(&ms, 1, NULL, 0);
+
+}
+
 /**
  * @brief Puts out a keepalive message to the user
  *
@@ -463,6 +813,33 @@ static void _keepalive(uint8_t argc, char* argv[])
 
 }
 
+#if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+    /**
+     * @brief Toggles the binary mode
+     *
+     * This confirms the command in the mode currently active and switches
+     * over to the other mode afterwards, i.e. when sent in ASCII mode the
+     * binary mode will be activated and vice versa.
+     *
+     * Flow control (see UART_FLOW_CONTROL) is suspended in binary mode, as
+     * the frames might contain the flow control characters themselves.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_binary_mode
+     * @see uart_protocol_ok()
+     */
+    static void _binary_mode(uint8_t argc, char* argv[])
+    {
+
+        uart_protocol_ok();
+        uart_protocol_binary_mode = !uart_protocol_binary_mode;
+        uart_set_flow_control(!uart_protocol_binary_mode);
+
+    }
+
+#endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
 /**
  * @brief Resets the microcontroller
  *
@@ -503,6 +880,8 @@ static void _factory_reset(uint8_t argc, char* argv[])
     preferences_get()->version = 0;
     preferences_save();
 
+    while (!preferences_save_completed());
+
     _reset(0, NULL);
 
 }
@@ -552,16 +931,16 @@ static void _color_read(uint8_t argc, char* argv[])
  *
  * This sets the RGB values currently being used by the PWM module to generate
  * its signal. It retrieves the hex representation of the value for each
- * channel (red, green, blue) from the command buffer and applies them
- * appropriately. When something is wrong with the arguments nothing is
- * actually applied and an error message will be output.
+ * channel (red, green, blue) from the command buffer and fades over to them
+ * (see PWM_COLOR_FADE_STEPS). When something is wrong with the arguments
+ * nothing is actually applied and an error message will be output.
  *
  * @see uart_protocol_command_callback_t
  * @see uart_protocol_command_buffer
  * @see uart_protocol_error()
  * @see uart_protocol_ok()
  * @see uart_protocol_input_args_hex()
- * @see pwm_set_color()
+ * @see pwm_fade_color()
  *
  * @todo Not real 8 bits, but 2^8-1?
  * @todo Let the user set 00 00 00? Disable?
@@ -580,7 +959,7 @@ static void _color_write(uint8_t argc, char* argv[])
 
     }
 
-    pwm_set_color(color);
+    pwm_fade_color(color, PWM_COLOR_FADE_STEPS);
     uart_protocol_ok();
 
 }
@@ -631,9 +1010,10 @@ static void _preset_active(uint8_t argc, char* argv[])
  *
  * @see uart_protocol_command_callback_t
  * @see uart_protocol_command_buffer
- * @see hexStrToUint8()
+ * @see format_parse_hex8()
  * @see user_prefs_t::curColorProfile
  * @see pwm_set_color()
+ * @see user_save_delayed()
  */
 static void _preset_set(uint8_t argc, char* argv[])
 {
@@ -644,7 +1024,7 @@ static void _preset_set(uint8_t argc, char* argv[])
             && preset < UI_COLOR_PRESET_COUNT) {
 
         (&(preferences_get()->user_prefs))->curColorProfile = preset;
-        preferences_save();
+        user_save_delayed();
 
         if (user_get_current_menu_state() == MS_normalMode) {
 
@@ -707,6 +1087,7 @@ static void _preset_read(uint8_t argc, char* argv[])
  * @see uart_protocol_input_args_hex()
  * @see user_prefs_t::colorPresets
  * @see uart_protocol_ok()
+ * @see user_save_delayed()
  */
 static void _preset_write(uint8_t argc, char* argv[])
 {
@@ -724,7 +1105,7 @@ static void _preset_write(uint8_t argc, char* argv[])
     }
 
     (&(preferences_get()->user_prefs))->colorPresets[preset] = color;
-    preferences_save();
+    user_save_delayed();
 
     if (preset == (&(preferences_get()->user_prefs))->curColorProfile) {
 
@@ -881,51 +1262,932 @@ static void _date_set(uint8_t argc, char* argv[])
 
 }
 
-#if (ENABLE_DEBUG_MEMCHECK == 1)
+/**
+ * @brief Selects the animation used for time transitions
+ *
+ * This sets the animation (see e_displayAnimation) used whenever a new time is
+ * shown, saves it to the preferences and previews it by animating the current
+ * time from a blank display. An error is output if the given animation is
+ * invalid.
+ *
+ * @see uart_protocol_command_callback_t
+ * @see uart_protocol_input_args_hex()
+ * @see display_prefs_t::animation
+ * @see display_animateDisplayState()
+ * @see user_save_delayed()
+ */
+static void _display_transition(uint8_t argc, char* argv[])
+{
+
+    uint8_t animation;
+
+    if (uart_protocol_input_args_hex(1, argv[1], &animation)
+            && animation < DISPLAY_ANIMATION_COUNT) {
+
+        g_display_prefs->animation = animation;
+        user_save_delayed();
+
+        display_setDisplayState(0, 0);
+        display_animateDisplayState(display_getTimeState(datetime_get()));
+
+        uart_protocol_ok();
+
+        return;
+
+    }
+
+    uart_protocol_error();
+
+}
+
+#if (ENABLE_PRESENCE_SUPPORT == 1)
 
     /**
-     * @brief Outputs the unused memory
+     * @brief Puts out the timeout of the motion sensor
      *
-     * This retrieves the unused amount of memory as reported by
-     * memcheck_get_unused(), converts it to hex, and puts it out.
+     * This puts out the hex representation of the minutes without motion
+     * before the display is turned off, zero meaning that it is never turned
+     * off.
      *
      * @see uart_protocol_command_callback_t
-     * @see memcheck_get_unused()
-     * @see uart_protocol_output()
+     * @see user_prefs_t::presenceTimeout
+     * @see uart_protocol_output_args_hex()
      */
-    static void _memory_unused(uint8_t argc, char* argv[])
+    static void _occupancy_get(uint8_t argc, char* argv[])
     {
 
-        unsigned short unused = memcheck_get_unused();
-        char buffer[5];
-        sprintf_P(buffer, fmt_hex, unused);
-        uart_protocol_output(buffer);
+        uart_protocol_output_args_hex(1, (&(preferences_get()->user_prefs))->presenceTimeout);
 
     }
 
     /**
-     * @brief Outputs the currently unused memory
+     * @brief Sets the timeout of the motion sensor
      *
-     * This retrieves the currently unused amount of memory as reported by
-     * memcheck_get_current(), converts it to hex, and puts it out.
+     * This expects the minutes without motion before the display is turned
+     * off as argument (zero disables this) and saves them to the
+     * preferences.
      *
      * @see uart_protocol_command_callback_t
-     * @see memcheck_get_current()
-     * @see uart_protocol_output()
+     * @see uart_protocol_input_args_hex()
+     * @see user_prefs_t::presenceTimeout
+     * @see user_save_delayed()
      */
-    static void _memory_current(uint8_t argc, char* argv[])
+    static void _occupancy_set(uint8_t argc, char* argv[])
     {
 
-        unsigned short unused = memcheck_get_current();
-        char buffer[5];
-        sprintf_P(buffer, fmt_hex, unused);
-        uart_protocol_output(buffer);
+        uint8_t timeout;
 
-    }
+        if (!uart_protocol_input_args_hex(1, argv[1], &timeout)) {
 
-#endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
+            uart_protocol_error();
 
-/**
+            return;
+
+        }
+
+        (&(preferences_get()->user_prefs))->presenceTimeout = timeout;
+        user_save_delayed();
+
+        uart_protocol_ok();
+
+    }
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
+#if (ENABLE_DEBUG_MEMCHECK == 1)
+
+    /**
+     * @brief Outputs the unused memory
+     *
+     * This retrieves the unused amount of memory as reported by
+     * memcheck_get_unused(), converts it to hex, and puts it out.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see memcheck_get_unused()
+     * @see uart_protocol_output_words()
+     */
+    static void _memory_unused(uint8_t argc, char* argv[])
+    {
+
+        const uint16_t unused = memcheck_get_unused();
+
+        uart_protocol_output_words(&unused, 1, NULL, 0);
+
+    }
+
+    /**
+     * @brief Outputs the currently unused memory
+     *
+     * This retrieves the currently unused amount of memory as reported by
+     * memcheck_get_current(), converts it to hex, and puts it out.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see memcheck_get_current()
+     * @see uart_protocol_output_words()
+     */
+    static void _memory_current(uint8_t argc, char* argv[])
+    {
+
+        const uint16_t unused = memcheck_get_current();
+
+        uart_protocol_output_words(&unused, 1, NULL, 0);
+
+    }
+
+    /**
+     * @brief Outputs statistics about the stack usage
+     *
+     * This puts out the maximum stack depth each of the ISRs (see
+     * e_profileIsr) was entered with as reported by memcheck_get_isr_depth(),
+     * followed by the maximum stack depth detected so far
+     * (memcheck_get_max_depth()) and whether the canary has been overwritten
+     * (1) or not (0). Each of these values is output as a hex representation
+     * with 4 digits.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see memcheck_get_isr_depth()
+     * @see memcheck_get_max_depth()
+     * @see memcheck_canary_intact()
+     * @see uart_protocol_output_words()
+     */
+    static void _memory_stack(uint8_t argc, char* argv[])
+    {
+
+        uint16_t values[PROFILE_ISR_COUNT + 2];
+
+        for (uint8_t i = 0; i < PROFILE_ISR_COUNT; i++) {
+
+            memcheck_get_isr_depth(i, &values[i]);
+
+        }
+
+        values[PROFILE_ISR_COUNT] = memcheck_get_max_depth();
+        values[PROFILE_ISR_COUNT + 1] = !memcheck_canary_intact();
+
+        uart_protocol_output_words(values, sizeof(values) / sizeof(values[0]), NULL, 0);
+
+    }
+
+#endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
+
+#if (ENABLE_DEBUG_ISR_PROFILE == 1)
+
+    /**
+     * @brief Outputs the profiling data of the given ISR
+     *
+     * This retrieves the data collected by the profiler for the given ISR
+     * (see e_profileIsr) and puts out the minimum, maximum and average
+     * execution time (in CPU cycles) along with the number of overruns. Each
+     * of these values is output as a hex representation with 4 digits.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_input_args_hex()
+     * @see profile_get()
+     * @see uart_protocol_output_words()
+     */
+    static void _isr_profile_get(uint8_t argc, char* argv[])
+    {
+
+        uint8_t isr;
+        profile_t profile;
+
+        if (uart_protocol_input_args_hex(1, argv[1], &isr)
+                && profile_get(isr, &profile)) {
+
+            const uint16_t values[] = {profile.min, profile.max, profile.mean,
+                profile.overruns};
+
+            uart_protocol_output_words(values, sizeof(values) / sizeof(values[0]), NULL, 0);
+
+            return;
+
+        }
+
+        uart_protocol_error();
+
+    }
+
+    /**
+     * @brief Resets the profiling data of all ISRs
+     *
+     * @see uart_protocol_command_callback_t
+     * @see profile_reset()
+     * @see uart_protocol_ok()
+     */
+    static void _isr_profile_clear(uint8_t argc, char* argv[])
+    {
+
+        profile_reset();
+        uart_protocol_ok();
+
+    }
+
+#endif /* (ENABLE_DEBUG_ISR_PROFILE == 1) */
+
+#if (ENABLE_DCF_SUPPORT == 1)
+
+    /**
+     * @brief Outputs the statistics about the reception of the DCF77 signal
+     *
+     * This retrieves the statistics as reported by dcf77_get_stats() and puts
+     * out the counters along with the duration of the last synchronization
+     * (each as a hex representation with 4 digits), followed by the date and
+     * time of the last synchronization (each as a hex representation with 2
+     * digits).
+     *
+     * @see uart_protocol_command_callback_t
+     * @see dcf77_get_stats()
+     * @see uart_protocol_output_words()
+     */
+    static void _sync_stats_get(uint8_t argc, char* argv[])
+    {
+
+        dcf77_stats_t stats;
+
+        dcf77_get_stats(&stats);
+
+        const uint16_t words[] = {stats.frames, stats.parity_errors,
+            stats.resets, stats.syncs, stats.pauses[DCF77_PAUSE_SPIKE],
+            stats.pauses[DCF77_PAUSE_ONE], stats.pauses[DCF77_PAUSE_ZERO],
+            stats.pauses[DCF77_PAUSE_MINUTE], stats.pauses[DCF77_PAUSE_INVALID],
+            stats.sync_duration};
+
+        const uint8_t bytes[] = {stats.last_sync.DD, stats.last_sync.MM,
+            stats.last_sync.YY, stats.last_sync.hh, stats.last_sync.mm};
+
+        uart_protocol_output_words(words, sizeof(words) / sizeof(words[0]), bytes,
+            sizeof(bytes));
+
+    }
+
+    /**
+     * @brief Resets the statistics about the reception of the DCF77 signal
+     *
+     * @see uart_protocol_command_callback_t
+     * @see dcf77_reset_stats()
+     * @see uart_protocol_ok()
+     */
+    static void _sync_stats_clear(uint8_t argc, char* argv[])
+    {
+
+        dcf77_reset_stats();
+        uart_protocol_ok();
+
+    }
+
+#endif /* (ENABLE_DCF_SUPPORT == 1) */
+
+/**
+ * @brief Puts out statistics about the data received via UART
+ *
+ * This puts out the number of bytes dropped (see uart_stats_t::dropped), the
+ * number of data overruns (see uart_stats_t::overruns) and the number of
+ * lines rejected for exceeding the command buffer (see
+ * #uart_protocol_oversize_lines), each as a hex representation with 4
+ * digits.
+ *
+ * @see uart_protocol_command_callback_t
+ * @see uart_get_stats()
+ * @see uart_protocol_output_words()
+ */
+static void _uart_stats_get(uint8_t argc, char* argv[])
+{
+
+    uart_stats_t stats;
+
+    uart_get_stats(&stats);
+
+    const uint16_t words[] = {stats.dropped, stats.overruns,
+        uart_protocol_oversize_lines};
+
+    uart_protocol_output_words(words, sizeof(words) / sizeof(words[0]), NULL, 0);
+
+}
+
+/**
+ * @brief Resets the statistics about the data received via UART
+ *
+ * @see uart_protocol_command_callback_t
+ * @see uart_reset_stats()
+ * @see uart_protocol_ok()
+ */
+static void _uart_stats_clear(uint8_t argc, char* argv[])
+{
+
+    uart_reset_stats();
+    uart_protocol_oversize_lines = 0;
+    uart_protocol_ok();
+
+}
+
+#if (ENABLE_HEALTH_COUNTERS == 1)
+
+    /**
+     * @brief Puts out the health counters
+     *
+     * This retrieves the health as reported by health_get() and puts out the
+     * rate of the main loop, its maximum and all of the counters, each as a
+     * hex representation with 4 digits.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see health_get()
+     * @see uart_protocol_output_words()
+     */
+    static void _health_get(uint8_t argc, char* argv[])
+    {
+
+        health_t health;
+
+        health_get(&health);
+
+        const uint16_t words[] = {health.loop_rate, health.loop_rate_max,
+            health.counters[HEALTH_UART_RX_DROPS],
+            health.counters[HEALTH_UART_TX_DROPS],
+            health.counters[HEALTH_I2C_ERRORS],
+            health.counters[HEALTH_RTC_ERRORS],
+            health.counters[HEALTH_PREFS_ERRORS]};
+
+        uart_protocol_output_words(words, sizeof(words) / sizeof(words[0]), NULL, 0);
+
+    }
+
+    /**
+     * @brief Resets the health counters
+     *
+     * @see uart_protocol_command_callback_t
+     * @see health_reset()
+     * @see uart_protocol_ok()
+     */
+    static void _health_clear(uint8_t argc, char* argv[])
+    {
+
+        health_reset();
+        uart_protocol_ok();
+
+    }
+
+#endif /* (ENABLE_HEALTH_COUNTERS == 1) */
+
+#if (ENABLE_UART_PROTOCOL_TELEMETRY == 1)
+
+    /**
+     * @brief Channels that can be subscribed to
+     *
+     * Each channel is represented by a single bit within the mask passed to
+     * the command `su`. The values of the channels are put out in the order
+     * defined here.
+     *
+     * @see _subscribe()
+     * @see uart_protocol_telemetry_handle()
+     */
+    typedef enum {
+
+        UART_PROTOCOL_TELEMETRY_LDR = 0,
+        UART_PROTOCOL_TELEMETRY_PWM,
+        UART_PROTOCOL_TELEMETRY_TIME,
+        UART_PROTOCOL_TELEMETRY_COLOR,
+        UART_PROTOCOL_TELEMETRY_DCF77,
+        UART_PROTOCOL_TELEMETRY_POWER,
+
+        UART_PROTOCOL_TELEMETRY_COUNT
+
+    } e_uart_protocol_telemetry_channel;
+
+    /**
+     * @brief Mask of the channels available within this build
+     *
+     * @see e_uart_protocol_telemetry_channel
+     */
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        #if (ENABLE_DCF_SUPPORT == 1)
+
+            #define UART_PROTOCOL_TELEMETRY_AVAILABLE 0x3f
+
+        #else
+
+            #define UART_PROTOCOL_TELEMETRY_AVAILABLE 0x2f
+
+        #endif /* (ENABLE_DCF_SUPPORT == 1) */
+
+    #else
+
+        #if (ENABLE_DCF_SUPPORT == 1)
+
+            #define UART_PROTOCOL_TELEMETRY_AVAILABLE 0x37
+
+        #else
+
+            #define UART_PROTOCOL_TELEMETRY_AVAILABLE 0x27
+
+        #endif /* (ENABLE_DCF_SUPPORT == 1) */
+
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+    /**
+     * @brief Maximum length of a telemetry record
+     *
+     * This is made up of the mask itself, LDR (1), PWM (1), time (3), color (3),
+     * DCF77 (4) and power (1).
+     *
+     * @see uart_protocol_telemetry_handle()
+     */
+    #define UART_PROTOCOL_TELEMETRY_MAX_LENGTH 14
+
+    /**
+     * @brief Channels currently subscribed to
+     *
+     * @see e_uart_protocol_telemetry_channel
+     */
+    static uint8_t uart_protocol_telemetry_channels;
+
+    /**
+     * @brief Interval between two telemetry records in 100 ms
+     *
+     * A value of zero disables the telemetry records altogether.
+     */
+    static uint8_t uart_protocol_telemetry_interval;
+
+    /**
+     * @brief Number of 100 ms periods passed since the last record
+     *
+     * @see uart_protocol_telemetry_handle()
+     */
+    static uint8_t uart_protocol_telemetry_ticks;
+
+    /**
+     * @brief Subscribes to the given telemetry channels
+     *
+     * This expects the mask of the channels (see
+     * e_uart_protocol_telemetry_channel) and the interval in 100 ms as
+     * arguments. Channels not available within this build are ignored, the
+     * mask actually applied is put out. An interval of zero and/or an empty
+     * mask stop the telemetry records. The first record follows right away.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_telemetry_handle()
+     */
+    static void _subscribe(uint8_t argc, char* argv[])
+    {
+
+        uint8_t channels;
+        uint8_t interval;
+
+        if (!uart_protocol_input_args_hex(2, argv[1], &channels, argv[2], &interval)) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        uart_protocol_telemetry_channels = channels & UART_PROTOCOL_TELEMETRY_AVAILABLE;
+        uart_protocol_telemetry_interval = interval;
+        uart_protocol_telemetry_ticks = interval - 1;
+
+        uart_protocol_output_args_hex(1, uart_protocol_telemetry_channels);
+
+    }
+
+#endif /* (ENABLE_UART_PROTOCOL_TELEMETRY == 1) */
+
+#if (ENABLE_UART_PROTOCOL_TRANSFER == 1)
+
+    /**
+     * @brief Blocks of the preferences that can be transferred
+     *
+     * @see uart_protocol_transfer_block()
+     */
+    typedef enum {
+
+        UART_PROTOCOL_TRANSFER_PRESETS = 0,
+        UART_PROTOCOL_TRANSFER_USER,
+        UART_PROTOCOL_TRANSFER_ALL
+
+    } e_uart_protocol_transfer_block;
+
+    /**
+     * @brief Number of bytes transferred by a single write command
+     *
+     * This is limited by the size of the command buffer, as the offset and
+     * the data need to fit in there as hex representation.
+     *
+     * @see UART_PROTOCOL_COMMAND_BUFFER_SIZE
+     * @see _transfer_write()
+     */
+    #define UART_PROTOCOL_TRANSFER_WRITE_CHUNK 3
+
+    /**
+     * @brief Number of bytes put out by a single read command
+     *
+     * @see _transfer_read()
+     */
+    #define UART_PROTOCOL_TRANSFER_READ_CHUNK 4
+
+    /**
+     * @brief Buffer the block currently being written is staged in
+     *
+     * This is filled by _transfer_write() and only applied to the actual
+     * preferences by _transfer_commit() once its checksum has been verified,
+     * so an interrupted transfer leaves the preferences untouched.
+     *
+     * @see _transfer_write()
+     * @see _transfer_commit()
+     */
+    static uint8_t uart_protocol_transfer_buffer[sizeof(prefs_t)];
+
+    /**
+     * @brief Returns the location and size of the given block
+     *
+     * @param block Block to look up, see e_uart_protocol_transfer_block
+     * @param size Pointer to variable the size of the block is put in
+     *
+     * @return Pointer to the block within the preferences, NULL if the block
+     * is not available within this build
+     *
+     * @see e_uart_protocol_transfer_block
+     */
+    static uint8_t* uart_protocol_transfer_block(uint8_t block, uint8_t* size)
+    {
+
+        prefs_t* prefs = preferences_get();
+
+        switch (block) {
+
+            #if (ENABLE_RGB_SUPPORT == 1)
+
+                case UART_PROTOCOL_TRANSFER_PRESETS:
+
+                    *size = sizeof(prefs->user_prefs.colorPresets);
+
+                    return (uint8_t*)prefs->user_prefs.colorPresets;
+
+            #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+            case UART_PROTOCOL_TRANSFER_USER:
+
+                *size = sizeof(prefs->user_prefs);
+
+                return (uint8_t*)&prefs->user_prefs;
+
+            case UART_PROTOCOL_TRANSFER_ALL:
+
+                *size = sizeof(prefs_t);
+
+                return (uint8_t*)prefs;
+
+        }
+
+        return NULL;
+
+    }
+
+    /**
+     * @brief Calculates the checksum used for transfers
+     *
+     * This is the CRC-16 (polynomial 0xa001, initial value 0xffff), which is
+     * also used for the records within the EEPROM.
+     *
+     * @param data Data to calculate the checksum of
+     * @param size Number of bytes
+     *
+     * @return Checksum of the given data
+     */
+    static uint16_t uart_protocol_transfer_crc(const uint8_t* data, uint8_t size)
+    {
+
+        uint16_t crc = 0xffff;
+
+        while (size--) {
+
+            crc = _crc16_update(crc, *data++);
+
+        }
+
+        return crc;
+
+    }
+
+    /**
+     * @brief Puts out the size and checksum of the given block
+     *
+     * This expects the block (see e_uart_protocol_transfer_block) as argument
+     * and puts out its size along with the CRC-16 of its current content
+     * (high byte first). This can be used to verify the chunks read by means
+     * of _transfer_read(), and to determine the number of chunks to write.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_transfer_crc()
+     */
+    static void _transfer_get(uint8_t argc, char* argv[])
+    {
+
+        uint8_t block;
+        uint8_t size;
+        uint8_t* data;
+
+        if (!uart_protocol_input_args_hex(1, argv[1], &block)
+                || !(data = uart_protocol_transfer_block(block, &size))) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        uint16_t crc = uart_protocol_transfer_crc(data, size);
+
+        uart_protocol_output_args_hex(3, size, crc >> 8, crc & 0xff);
+
+    }
+
+    /**
+     * @brief Puts out a chunk of the given block
+     *
+     * This expects the block (see e_uart_protocol_transfer_block) and the
+     * offset within it as arguments and puts out the
+     * UART_PROTOCOL_TRANSFER_READ_CHUNK bytes found at this offset. Bytes
+     * beyond the end of the block are put out as zero.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see _transfer_get()
+     */
+    static void _transfer_read(uint8_t argc, char* argv[])
+    {
+
+        uint8_t block;
+        uint8_t offset;
+        uint8_t size;
+        uint8_t* data;
+
+        if (!uart_protocol_input_args_hex(2, argv[1], &block, argv[2], &offset)
+                || !(data = uart_protocol_transfer_block(block, &size))
+                || offset >= size) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        uint8_t chunk[UART_PROTOCOL_TRANSFER_READ_CHUNK] = {0};
+
+        for (uint8_t i = 0; i < UART_PROTOCOL_TRANSFER_READ_CHUNK && offset + i < size; i++) {
+
+            chunk[i] = data[offset + i];
+
+        }
+
+        uart_protocol_output_args_hex(4, chunk[0], chunk[1], chunk[2], chunk[3]);
+
+    }
+
+    /**
+     * @brief Writes a chunk of data into the staging buffer
+     *
+     * This expects the offset within the block along with
+     * UART_PROTOCOL_TRANSFER_WRITE_CHUNK bytes as arguments, which are put
+     * into uart_protocol_transfer_buffer. Bytes beyond the end of the buffer
+     * are ignored. The preferences themselves are not touched until
+     * _transfer_commit() is invoked.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_transfer_buffer
+     */
+    static void _transfer_write(uint8_t argc, char* argv[])
+    {
+
+        uint8_t offset;
+        uint8_t chunk[UART_PROTOCOL_TRANSFER_WRITE_CHUNK];
+
+        if (!uart_protocol_input_args_hex(4, argv[1], &offset, argv[2], &chunk[0],
+                argv[3], &chunk[1], argv[4], &chunk[2])
+                || offset >= sizeof(uart_protocol_transfer_buffer)) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        for (uint8_t i = 0; i < UART_PROTOCOL_TRANSFER_WRITE_CHUNK
+                && offset + i < sizeof(uart_protocol_transfer_buffer); i++) {
+
+            uart_protocol_transfer_buffer[offset + i] = chunk[i];
+
+        }
+
+        uart_protocol_ok();
+
+    }
+
+    /**
+     * @brief Applies the staged data to the given block
+     *
+     * This expects the block (see e_uart_protocol_transfer_block) along with
+     * the CRC-16 of its new content (high byte first) as arguments. If the
+     * checksum over the beginning of uart_protocol_transfer_buffer matches,
+     * it is copied into the preferences, which are written back to the EEPROM
+     * after the usual delay (see user_save_delayed()). When transferring all
+     * of the preferences, the version and size contained within the data need
+     * to match the ones of this firmware.
+     *
+     * Changes to the color presets are applied immediately when in
+     * #MS_normalMode, changes to the IR command codes immediately and changes
+     * to the on/off times with the next minute,
+     * everything else takes effect once the appropriate module reads its
+     * settings the next time, e.g. after a reset.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_transfer_crc()
+     * @see user_save_delayed()
+     * @see user_ir_codes_changed()
+     */
+    static void _transfer_commit(uint8_t argc, char* argv[])
+    {
+
+        uint8_t block;
+        uint8_t crc_high;
+        uint8_t crc_low;
+        uint8_t size;
+        uint8_t* data;
+
+        if (!uart_protocol_input_args_hex(3, argv[1], &block, argv[2], &crc_high,
+                argv[3], &crc_low)
+                || !(data = uart_protocol_transfer_block(block, &size))
+                || uart_protocol_transfer_crc(uart_protocol_transfer_buffer, size)
+                != ((crc_high << 8) | crc_low)) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        if (block == UART_PROTOCOL_TRANSFER_ALL) {
+
+            const prefs_t* prefs = (const prefs_t*)uart_protocol_transfer_buffer;
+
+            if (prefs->version != VERSION || prefs->prefs_size != sizeof(prefs_t)) {
+
+                uart_protocol_error();
+
+                return;
+
+            }
+
+        }
+
+        memcpy(data, uart_protocol_transfer_buffer, size);
+        user_save_delayed();
+        user_on_off_times_changed();
+
+        #if (ENABLE_IR_SUPPORT == 1)
+
+            user_ir_codes_changed();
+
+        #endif /* (ENABLE_IR_SUPPORT == 1) */
+
+        #if (ENABLE_RGB_SUPPORT == 1)
+
+            if (user_get_current_menu_state() == MS_normalMode) {
+
+                uint8_t preset = (&(preferences_get()->user_prefs))->curColorProfile;
+
+                addState(MS_normalMode, &preset);
+
+            }
+
+        #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+        uart_protocol_ok();
+
+    }
+
+#endif /* (ENABLE_UART_PROTOCOL_TRANSFER == 1) */
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+    /**
+     * @brief Maximum interval between two time beacons in seconds
+     *
+     * @see _time_beacon_transmit()
+     */
+    #define UART_PROTOCOL_BEACON_INTERVAL_MAX 60
+
+    /**
+     * @brief Latency of the link in ms on top of the transmission itself
+     *
+     * Bridges like Bluetooth modules buffer the data for a couple of
+     * milliseconds before passing it on, which can be compensated for here.
+     *
+     * @see _time_beacon()
+     */
+    #define UART_PROTOCOL_BEACON_LINK_DELAY_MS 0
+
+    /**
+     * @brief Time in ms it takes to transmit a time beacon
+     *
+     * A beacon consists of 18 characters (including the EOL marker). Each of
+     * them takes ten bits on the line (start, eight data bits and stop).
+     *
+     * @see UART_BAUD
+     * @see uart_protocol_beacon_handle()
+     */
+    #define UART_PROTOCOL_BEACON_LINE_MS ((18UL * 10 * 1000 + UART_BAUD / 2) / UART_BAUD)
+
+    /**
+     * @brief Beacons are only put out within this many ms of a new second
+     *
+     * Later on the datetime might already lag behind the software clock,
+     * see uart_protocol_beacon_handle().
+     */
+    #define UART_PROTOCOL_BEACON_MAX_AGE_MS 500
+
+    /**
+     * @brief Interval between two time beacons in seconds
+     *
+     * A value of zero disables the time beacons, i.e. this clock acts as a
+     * follower and takes over the beacons received.
+     *
+     * @see _time_beacon_transmit()
+     * @see uart_protocol_beacon_handle()
+     */
+    static uint8_t uart_protocol_beacon_interval;
+
+    /**
+     * @brief Takes over the time of another clock
+     *
+     * This expects the datetime of the other clock as seconds since
+     * 2000-01-01 (see datetime_get_epoch(), four bytes, high byte first)
+     * along with the time it has already spent within this second in units
+     * of 4 ms as arguments. The time it took to transmit the beacon (see
+     * UART_PROTOCOL_BEACON_LINE_MS and UART_PROTOCOL_BEACON_LINK_DELAY_MS) is
+     * added and the result is passed over to datetime_sync().
+     *
+     * Beacons are ignored while this clock puts out beacons on its own.
+     *
+     * @note This never puts out anything, not even an error. Otherwise the
+     * clocks would keep on answering each other, as the output of one clock
+     * is the input of the other one.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_beacon_handle()
+     * @see datetime_sync()
+     */
+    static void _time_beacon(uint8_t argc, char* argv[])
+    {
+
+        uint8_t epoch[4];
+        uint8_t age;
+
+        if (uart_protocol_beacon_interval
+                || !uart_protocol_input_args_hex(5, argv[1], &epoch[0], argv[2], &epoch[1],
+                argv[3], &epoch[2], argv[4], &epoch[3], argv[5], &age)) {
+
+            return;
+
+        }
+
+        datetime_sync(((uint32_t)epoch[0] << 24) | ((uint32_t)epoch[1] << 16)
+            | ((uint16_t)epoch[2] << 8) | epoch[3],
+            age * 4 + UART_PROTOCOL_BEACON_LINE_MS + UART_PROTOCOL_BEACON_LINK_DELAY_MS);
+
+    }
+
+    /**
+     * @brief Sets the interval time beacons are put out with
+     *
+     * This expects the interval in seconds as argument, where zero stops the
+     * beacons. Intervals larger than UART_PROTOCOL_BEACON_INTERVAL_MAX are
+     * considered to be an error. The interval actually applied is put out.
+     *
+     * @see uart_protocol_command_callback_t
+     * @see uart_protocol_beacon_handle()
+     */
+    static void _time_beacon_transmit(uint8_t argc, char* argv[])
+    {
+
+        uint8_t interval;
+
+        if (!uart_protocol_input_args_hex(1, argv[1], &interval)
+                || interval > UART_PROTOCOL_BEACON_INTERVAL_MAX) {
+
+            uart_protocol_error();
+
+            return;
+
+        }
+
+        uart_protocol_beacon_interval = interval;
+
+        uart_protocol_output_args_hex(1, uart_protocol_beacon_interval);
+
+    }
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+/**
  * @brief Defines the type of each entry within #uart_protocol_commands
  *
  * @see uart_protocol_commands
@@ -940,6 +2202,16 @@ typedef struct
      */
     char command[UART_PROTOCOL_COMMAND_MAX_LENGTH];
 
+    /**
+     * @brief Opcode identifying this command in binary mode
+     *
+     * @note These need to be unique and should not be changed once assigned,
+     * as they are part of the protocol, see `doc/UART_PROTOCOL.md`.
+     *
+     * @see ENABLE_UART_PROTOCOL_BINARY
+     */
+    uint8_t opcode;
+
     /**
      * @brief Number of arguments
      *
@@ -961,59 +2233,233 @@ typedef struct
      */
     uart_protocol_command_callback_t callback;
 
-} uart_protocol_command_t;
+} uart_protocol_command_t;
+
+/**
+ * @brief Definition of all available commands
+ *
+ * This defines all of the commands that can be detected along with the
+ * appropriate callback function.
+ *
+ * @warning This table is accessed by means of a binary search (see
+ * uart_protocol_find_command()), so the entries need to be sorted in
+ * ascending order by both, their command (as compared by `strcmp()`) and
+ * their opcode. Entries that are only compiled in with certain options do not
+ * break this, as long as they are placed at the appropriate position. This
+ * is verified by the host tests (see test/host/protocol.c).
+ *
+ * @see uart_protocol_command_t
+ * @see uart_protocol_find_command()
+ * @see uart_protocol_handle()
+ */
+static const uart_protocol_command_t uart_protocol_commands[] PROGMEM = {
+
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        {"b", 0x00, 0, _binary_mode},
+
+    #endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
+    {"bt", 0x01, 0, _boot_time},
+
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        {"cr", 0x10, 0, _color_read},
+        {"cw", 0x11, 3, _color_write},
+
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+    {"dg", 0x18, 0, _date_get},
+    {"ds", 0x19, 4, _date_set},
+    {"dt", 0x1a, 1, _display_transition},
+
+    {"f", 0x20, 0, _factory_reset},
+
+    #if (ENABLE_HEALTH_COUNTERS == 1)
+
+        {"hc", 0x24, 0, _health_clear},
+        {"hg", 0x25, 0, _health_get},
+
+    #endif /* (ENABLE_HEALTH_COUNTERS == 1) */
+
+    {"i", 0x28, 1, _ir_user_command},
+
+    #if (ENABLE_DEBUG_ISR_PROFILE == 1)
+
+        {"ic", 0x2c, 0, _isr_profile_clear},
+        {"ig", 0x2d, 1, _isr_profile_get},
+
+    #endif /* (ENABLE_DEBUG_ISR_PROFILE == 1) */
+
+    {"k", 0x30, 0, _keepalive},
+
+    {"lb", 0x38, 0, _ldr_brightness},
+
+    #if (ENABLE_DEBUG_MEMCHECK == 1)
+
+        {"mc", 0x40, 0, _memory_current},
+        {"ms", 0x41, 0, _memory_stack},
+        {"mu", 0x42, 0, _memory_unused},
+
+    #endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
+
+    #if (ENABLE_PRESENCE_SUPPORT == 1)
+
+        {"og", 0x44, 0, _occupancy_get},
+        {"os", 0x45, 1, _occupancy_set},
+
+    #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        {"pa", 0x48, 0, _preset_active},
+        {"pn", 0x49, 0, _preset_number},
+        {"pr", 0x4a, 1, _preset_read},
+        {"ps", 0x4b, 1, _preset_set},
+        {"pw", 0x4c, 4, _preset_write},
+
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+    {"r", 0x50, 0, _reset},
+
+    #if (ENABLE_DCF_SUPPORT == 1)
+
+        {"sc", 0x54, 0, _sync_stats_clear},
+        {"sg", 0x55, 0, _sync_stats_get},
+
+    #endif /* (ENABLE_DCF_SUPPORT == 1) */
+
+    #if (ENABLE_UART_PROTOCOL_TELEMETRY == 1)
+
+        {"su", 0x56, 2, _subscribe},
+
+    #endif /* (ENABLE_UART_PROTOCOL_TELEMETRY == 1) */
+
+    #if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+        {"tb", 0x57, 5, _time_beacon},
+
+    #endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+    {"tg", 0x58, 0, _time_get},
+    {"ts", 0x59, 3, _time_set},
+
+    #if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+        {"tx", 0x5a, 1, _time_beacon_transmit},
+
+    #endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
+    {"uc", 0x5c, 0, _uart_stats_clear},
+    {"ug", 0x5d, 0, _uart_stats_get},
+
+    {"v", 0x60, 0, _version},
+
+    #if (ENABLE_UART_PROTOCOL_TRANSFER == 1)
+
+        {"xc", 0x68, 3, _transfer_commit},
+        {"xg", 0x69, 1, _transfer_get},
+        {"xr", 0x6a, 2, _transfer_read},
+        {"xw", 0x6b, 4, _transfer_write},
+
+    #endif /* (ENABLE_UART_PROTOCOL_TRANSFER == 1) */
+
+};
+
+/**
+ * @brief Number of entries within #uart_protocol_commands
+ */
+#define UART_PROTOCOL_COMMANDS_COUNT \
+    (sizeof(uart_protocol_commands) / sizeof(uart_protocol_command_t))
+
+/**
+ * @brief Looks up a command within #uart_protocol_commands
+ *
+ * This performs a binary search over #uart_protocol_commands, so the amount
+ * of comparisons needed only grows logarithmically with the number of
+ * commands. The command can either be looked up by its name (ASCII mode) or
+ * by its opcode (binary mode).
+ *
+ * @param command Name of command to look up, NULL to look up by opcode
+ * @param opcode Opcode to look up, only used if command is NULL
+ *
+ * @return Pointer to the entry (in program space), NULL if not found
+ *
+ * @see uart_protocol_commands
+ */
+static const uart_protocol_command_t* uart_protocol_find_command(const char* command, uint8_t opcode)
+{
+
+    uint8_t low = 0;
+    uint8_t high = UART_PROTOCOL_COMMANDS_COUNT;
+
+    while (low < high) {
+
+        uint8_t mid = (low + high) / 2;
+        const uart_protocol_command_t* entry = &uart_protocol_commands[mid];
+        int compare;
+
+        if (command) {
+
+            compare = strncmp_P(command, entry->command, UART_PROTOCOL_COMMAND_BUFFER_SIZE);
+
+        } else {
+
+            compare = (int)opcode - (int)pgm_read_byte(&(entry->opcode));
+
+        }
+
+        if (compare == 0) {
 
-/**
- * @brief Definition of all available commands
- *
- * This defines all of the commands that can be detected along with the
- * appropriate callback function.
- *
- * @note Keep in mind that this table is accessed iteratively, so it might make
- * sense to order the entries appropriately.
- *
- * @see uart_protocol_command_t
- * @see uart_protocol_handle()
- */
-static const uart_protocol_command_t uart_protocol_commands[] PROGMEM = {
+            return entry;
 
-    {"i", 1, _ir_user_command},
+        }
 
-    {"v", 0, _version},
+        if (compare < 0) {
 
-    {"k", 0, _keepalive},
+            high = mid;
 
-    {"r", 0, _reset},
-    {"f", 0, _factory_reset},
+        } else {
 
-    {"lb", 0, _ldr_brightness},
+            low = mid + 1;
 
-    #if (ENABLE_RGB_SUPPORT == 1)
+        }
 
-        {"cr", 0, _color_read},
-        {"cw", 3, _color_write},
+    }
 
-        {"pn", 0, _preset_number},
-        {"pa", 0, _preset_active},
-        {"ps", 1, _preset_set},
-        {"pr", 1, _preset_read},
-        {"pw", 4, _preset_write},
+    return NULL;
 
-    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+}
+
+/**
+ * @brief Executes the callback of the given command
+ *
+ * The callback is only executed when the number of arguments matches the one
+ * defined for the command.
+ *
+ * @param entry Pointer to entry within #uart_protocol_commands, may be NULL
+ * @param argc Number of arguments (including the command itself)
+ * @param argv Arguments (the first one is the command itself)
+ *
+ * @return True if the callback has been executed, false otherwise
+ *
+ * @see uart_protocol_find_command()
+ */
+static bool uart_protocol_execute(const uart_protocol_command_t* entry, uint8_t argc, char* argv[])
+{
 
-    {"tg", 0, _time_get},
-    {"ts", 3, _time_set},
-    {"dg", 0, _date_get},
-    {"ds", 4, _date_set},
+    if (entry && (argc - 1) == (uint8_t)pgm_read_byte(&(entry->arguments))) {
 
-    #if (ENABLE_DEBUG_MEMCHECK == 1)
+        uart_protocol_command_callback_t callback = pgm_read_word(&(entry->callback));
+        callback(argc, argv);
 
-        {"mu", 0, _memory_unused},
-        {"mc", 0, _memory_current},
+        return true;
 
-    #endif /* (ENABLE_DEBUG_MEMCHECK == 1) */
+    }
 
-};
+    return false;
+
+}
 
 /**
  * @brief Tokenizes the command buffer
@@ -1022,6 +2468,12 @@ static const uart_protocol_command_t uart_protocol_commands[] PROGMEM = {
  * delimiter and returns an array of char pointers to the beginning of each
  * token. The first pointer within this array points to the command itself.
  *
+ * A leading request ID (see #UART_PROTOCOL_REQUEST_ID_PREFIX) is not counted
+ * as a token, but taken over into #uart_protocol_request_id. If it is
+ * invalid, or if there are more tokens than
+ * #UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS, no tokens are returned at all, so
+ * that surplus arguments are not silently dropped.
+ *
  * @param argv Pointer to char array for storing the found char pointers
  *
  * @return The number of tokens found (including the command itself)
@@ -1035,7 +2487,29 @@ static uint8_t uart_protocol_tokenize_command_buffer(char* argv[])
     uint8_t argc = 0;
     char *token = strtok(uart_protocol_command_buffer, " ");
 
-    while (token != NULL && argc < UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS) {
+    if (token != NULL && token[0] == UART_PROTOCOL_REQUEST_ID_PREFIX) {
+
+        uint8_t id;
+
+        if (!format_parse_hex8(&token[1], &id) || token[3] != '\0') {
+
+            return 0;
+
+        }
+
+        strcpy(uart_protocol_request_id, &token[1]);
+        token = strtok(NULL, " ");
+
+    }
+
+    while (token != NULL) {
+
+        // More tokens than any command can take
+        if (argc == UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS) {
+
+            return 0;
+
+        }
 
         argv[argc++] = token;
         token = strtok(NULL, " ");
@@ -1046,6 +2520,112 @@ static uint8_t uart_protocol_tokenize_command_buffer(char* argv[])
 
 }
 
+#if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+    /**
+     * @brief Processes a single byte received in binary mode
+     *
+     * In binary mode commands are received as frames, which are made up of
+     * the following bytes:
+     *
+     * - Length: Number of bytes following (opcode and arguments), without
+     *   the checksum
+     * - Opcode: Identifies the command, see uart_protocol_command_t::opcode
+     * - Arguments: One raw byte for each argument
+     * - Checksum: CRC-8 (polynomial 0x07, initial value 0) of all the bytes
+     *   preceding it
+     *
+     * The frame is collected within #uart_protocol_command_buffer. Once it is
+     * complete and its checksum is valid, the appropriate callback is
+     * executed. The arguments are handed over as strings containing a single
+     * raw byte each, so that the callbacks can be shared with the ASCII mode.
+     *
+     * A length of zero is ignored and can be used to resynchronize, frames
+     * that are too long and/or have an invalid checksum are answered with an
+     * error.
+     *
+     * @param c Byte received
+     *
+     * @return True if a frame has been processed, false otherwise
+     *
+     * @see uart_protocol_command_buffer
+     * @see uart_protocol_commands
+     * @see uart_protocol_handle()
+     */
+    static bool uart_protocol_handle_frame(uint8_t c)
+    {
+
+        static uint8_t frame_index = 0;
+
+        uint8_t* frame = (uint8_t*)uart_protocol_command_buffer;
+
+        if (frame_index == 0) {
+
+            if (c == 0) {
+
+                return false;
+
+            }
+
+            if (c > UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS) {
+
+                uart_protocol_error();
+
+                return true;
+
+            }
+
+        }
+
+        frame[frame_index++] = c;
+
+        // Length, opcode + arguments and checksum
+        if (frame_index < frame[0] + 2) {
+
+            return false;
+
+        }
+
+        frame_index = 0;
+
+        uint8_t crc = 0;
+
+        for (uint8_t i = 0; i <= frame[0]; i++) {
+
+            crc = _crc8_ccitt_update(crc, frame[i]);
+
+        }
+
+        if (crc == frame[frame[0] + 1]) {
+
+            char args[UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS][2];
+            char* argv[UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS];
+            uint8_t argc = frame[0];
+
+            for (uint8_t i = 0; i < argc; i++) {
+
+                args[i][0] = frame[i + 1];
+                args[i][1] = '\0';
+                argv[i] = args[i];
+
+            }
+
+            if (uart_protocol_execute(uart_protocol_find_command(NULL, frame[1]), argc, argv)) {
+
+                return true;
+
+            }
+
+        }
+
+        uart_protocol_error();
+
+        return true;
+
+    }
+
+#endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
 /**
  * @brief Processes the UART protocol
  *
@@ -1055,11 +2635,15 @@ static uint8_t uart_protocol_tokenize_command_buffer(char* argv[])
  * command is tokenized and the appropriate callback function will be executed.
  *
  * If the command could not be detected successfully an error message will be
- * output.
+ * output. The same goes for lines not fitting into the command buffer, which
+ * are rejected as a whole and counted (see #uart_protocol_oversize_lines).
  *
  * If logging is enabled (#LOG_UART_PROTOCOL) some debugging information will
  * be output, too.
  *
+ * In binary mode the received data is handed over to
+ * uart_protocol_handle_frame() instead.
+ *
  * @warning This function should be called on a regular basis. It is not time
  * critical at all, but once the incoming buffer is full, data might be lost.
  *
@@ -1073,11 +2657,28 @@ void uart_protocol_handle()
 {
 
     static uint8_t buffer_index = 0;
+    static bool buffer_overflow = false;
 
     char c;
 
     while (uart_getc_nowait(&c)) {
 
+        #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+            if (uart_protocol_binary_mode) {
+
+                if (uart_protocol_handle_frame(c)) {
+
+                    return;
+
+                }
+
+                continue;
+
+            }
+
+        #endif
+
         // Check whether EOL was received, triggering the command detection
         if (c == UART_PROTOCOL_INPUT_EOL) {
 
@@ -1085,6 +2686,9 @@ void uart_protocol_handle()
             uart_protocol_command_buffer[buffer_index] = '\0';
             buffer_index = 0;
 
+            bool overflow = buffer_overflow;
+            buffer_overflow = false;
+
             #if (LOG_UART_PROTOCOL == 1)
 
                 uart_puts_P("Command: ");
@@ -1098,29 +2702,28 @@ void uart_protocol_handle()
 
             argc = uart_protocol_tokenize_command_buffer(argv);
 
-            // Check whether at least a single command was detected
-            if (argc != 0) {
-
-                uint8_t j = sizeof(uart_protocol_commands) / sizeof(uart_protocol_command_t);
-
-                for (uint8_t i = 0; i < j; i++) {
+            /*
+             * Lines exceeding the buffer are rejected as a whole, so the
+             * request ID at their beginning can still be put out
+             */
+            if (overflow) {
 
-                    bool compare = strncmp_P(argv[0], uart_protocol_commands[i].command, UART_PROTOCOL_COMMAND_BUFFER_SIZE);
+                if (uart_protocol_oversize_lines < UINT16_MAX) {
 
-                    if (compare == 0 && (argc - 1) == (uint8_t)pgm_read_byte(&(uart_protocol_commands[i].arguments))) {
+                    uart_protocol_oversize_lines++;
 
-                        uart_protocol_command_callback_t callback = pgm_read_word(&(uart_protocol_commands[i].callback));
-                        callback(argc, argv);
+                }
 
-                        return;
+                uart_protocol_error();
 
-                    }
+            } else if (argc == 0
+                    || !uart_protocol_execute(uart_protocol_find_command(argv[0], 0), argc, argv)) {
 
-                }
+                uart_protocol_error();
 
             }
 
-            uart_protocol_error();
+            uart_protocol_request_id[0] = '\0';
 
             return;
 
@@ -1131,9 +2734,9 @@ void uart_protocol_handle()
 
             #if (LOG_UART_PROTOCOL == 1)
 
-                char str[3];
+                char str[FORMAT_DEC_MAX_LENGTH];
 
-                sprintf_P(str, fmt_output_unsigned_decimal, buffer_index);
+                format_dec(str, buffer_index);
 
                 uart_puts_P("Buffer index: ");
                 uart_puts(str);
@@ -1148,8 +2751,240 @@ void uart_protocol_handle()
             // Put character into buffer
             uart_protocol_command_buffer[buffer_index++] = c;
 
+        } else {
+
+            buffer_overflow = true;
+
+        }
+
+    }
+
+}
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_TELEMETRY == 1))
+
+/**
+ * @brief Pushes telemetry records to the host
+ *
+ * Once the interval set by the command `su` has passed, this puts out a
+ * record with the values of all channels subscribed to, preceded by the mask
+ * of these channels. In ASCII mode the record is made up of the hex
+ * representation of each byte, prefixed by UART_PROTOCOL_TELEMETRY_PREFIX.
+ * In binary mode it is sent as a frame with the status
+ * UART_PROTOCOL_FRAME_STATUS_TELEMETRY.
+ *
+ * This needs to be called ten times a second, see `EVENT_TIMER`.
+ *
+ * @see _subscribe()
+ * @see e_uart_protocol_telemetry_channel
+ */
+void uart_protocol_telemetry_handle()
+{
+
+    if (!uart_protocol_telemetry_interval || !uart_protocol_telemetry_channels) {
+
+        return;
+
+    }
+
+    if (++uart_protocol_telemetry_ticks < uart_protocol_telemetry_interval) {
+
+        return;
+
+    }
+
+    uart_protocol_telemetry_ticks = 0;
+
+    const uint8_t channels = uart_protocol_telemetry_channels;
+    uint8_t record[UART_PROTOCOL_TELEMETRY_MAX_LENGTH];
+    uint8_t length = 0;
+
+    record[length++] = channels;
+
+    if (channels & _BV(UART_PROTOCOL_TELEMETRY_LDR)) {
+
+        record[length++] = ldr_get_brightness();
+
+    }
+
+    if (channels & _BV(UART_PROTOCOL_TELEMETRY_PWM)) {
+
+        record[length++] = pwm_get_brightness();
+
+    }
+
+    if (channels & _BV(UART_PROTOCOL_TELEMETRY_TIME)) {
+
+        const datetime_t* datetime = datetime_get();
+
+        record[length++] = datetime->hh;
+        record[length++] = datetime->mm;
+        record[length++] = datetime->ss;
+
+    }
+
+    #if (ENABLE_RGB_SUPPORT == 1)
+
+        if (channels & _BV(UART_PROTOCOL_TELEMETRY_COLOR)) {
+
+            const color_rgb_t* color = pwm_get_color();
+
+            record[length++] = color->red;
+            record[length++] = color->green;
+            record[length++] = color->blue;
+
+        }
+
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
+
+    #if (ENABLE_DCF_SUPPORT == 1)
+
+        if (channels & _BV(UART_PROTOCOL_TELEMETRY_DCF77)) {
+
+            dcf77_stats_t stats;
+
+            dcf77_get_stats(&stats);
+
+            record[length++] = stats.frames >> 8;
+            record[length++] = stats.frames;
+            record[length++] = stats.syncs >> 8;
+            record[length++] = stats.syncs;
+
+        }
+
+    #endif /* (ENABLE_DCF_SUPPORT == 1) */
+
+    if (channels & _BV(UART_PROTOCOL_TELEMETRY_POWER)) {
+
+        record[length++] = pwm_is_enabled();
+
+    }
+
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            uart_protocol_frame_begin(length, UART_PROTOCOL_FRAME_STATUS_TELEMETRY);
+
+            for (uint8_t i = 0; i < length; i++) {
+
+                uart_protocol_frame_putc(record[i]);
+
+            }
+
+            uart_protocol_frame_end();
+
+            return;
+
+        }
+
+    #endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
+    // Three bytes per byte (2 byte hex representation + space/terminator)
+    char str[UART_PROTOCOL_TELEMETRY_MAX_LENGTH * 3];
+
+    for (uint8_t i = 0; i < length; i++) {
+
+        format_hex8(&str[i * 3], record[i]);
+        str[i * 3 + 2] = ' ';
+
+    }
+
+    str[length * 3 - 1] = '\0';
+
+    uart_flush_output();
+
+    uart_puts_P(UART_PROTOCOL_TELEMETRY_PREFIX);
+    uart_puts(str);
+    uart_puts_P(UART_PROTOCOL_OUTPUT_EOL);
+
+}
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_TELEMETRY == 1)) */
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+/**
+ * @brief Puts out time beacons for other clocks
+ *
+ * Once a new second has begun whose number is a multiple of the interval set
+ * by the command `tx`, this puts out a beacon in the form of the command
+ * `tb`, so other clocks listening on the same link take the time over (see
+ * _time_beacon()). It contains the datetime as seconds since 2000-01-01 and
+ * the time that has already passed within this second, which is determined
+ * right before the transmission starts.
+ *
+ * Nothing is put out while the datetime is not valid and/or in binary mode.
+ *
+ * This needs to be called whenever the datetime might have changed, i.e.
+ * right after datetime_handle().
+ *
+ * @see _time_beacon_transmit()
+ * @see datetime_get_epoch()
+ * @see datetime_get_subsecond_ms()
+ */
+void uart_protocol_beacon_handle()
+{
+
+    static uint8_t last_seconds = 0xff;
+
+    const datetime_t* datetime = datetime_get();
+
+    if (datetime->ss == last_seconds) {
+
+        return;
+
+    }
+
+    last_seconds = datetime->ss;
+
+    if (!uart_protocol_beacon_interval
+            || (datetime->ss % uart_protocol_beacon_interval)
+            || !datetime_is_valid()) {
+
+        return;
+
+    }
+
+    #if (ENABLE_UART_PROTOCOL_BINARY == 1)
+
+        if (uart_protocol_binary_mode) {
+
+            return;
+
         }
 
+    #endif /* (ENABLE_UART_PROTOCOL_BINARY == 1) */
+
+    uart_flush_output();
+
+    uint16_t age = datetime_get_subsecond_ms();
+
+    if (age >= UART_PROTOCOL_BEACON_MAX_AGE_MS) {
+
+        return;
+
+    }
+
+    uint32_t epoch = datetime_get_epoch();
+
+    // Three bytes per byte (2 byte hex representation + space/terminator)
+    char str[5 * 3];
+
+    for (uint8_t i = 0; i < 4; i++) {
+
+        format_hex8(&str[i * 3], epoch >> (24 - i * 8));
+        str[i * 3 + 2] = ' ';
+
     }
 
+    format_hex8(&str[4 * 3], age / 4);
+    str[4 * 3 + 2] = '\0';
+
+    uart_puts_P("tb ");
+    uart_puts(str);
+    uart_putc(UART_PROTOCOL_INPUT_EOL);
+
 }
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
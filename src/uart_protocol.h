@@ -31,6 +31,8 @@
 #ifndef _WC_UART_PROTOCOL_H_
 #define _WC_UART_PROTOCOL_H_
 
+#include "config.h"
+
 /**
  * @brief Prefix for any output generated by this module
  *
@@ -62,6 +64,59 @@
  */
 #define UART_PROTOCOL_INPUT_EOL '\r'
 
+/**
+ * @brief Prefix of the optional request ID preceding a command
+ *
+ * A command can be preceded by this character immediately followed by two
+ * hex digits and a space, e.g. `#2a v`. The request ID is then put out along
+ * with the response, so hosts can send multiple commands without waiting and
+ * match up the responses afterwards.
+ *
+ * @note Keep in mind that this needs to be a single character, so enclose it
+ * by single quotes.
+ */
+#define UART_PROTOCOL_REQUEST_ID_PREFIX '#'
+
+/**
+ * @brief Prefix for telemetry records pushed by this module
+ *
+ * This differs from UART_PROTOCOL_OUTPUT_PREFIX, so telemetry records can't
+ * be confused with responses to commands.
+ *
+ * @see ENABLE_UART_PROTOCOL_TELEMETRY
+ */
+#define UART_PROTOCOL_TELEMETRY_PREFIX "!"
+
 extern void uart_protocol_handle();
 
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_TELEMETRY == 1))
+
+    extern void uart_protocol_telemetry_handle();
+
+#else
+
+    /**
+     * @brief Empty macro in case telemetry records are disabled
+     *
+     * @see ENABLE_UART_PROTOCOL_TELEMETRY
+     */
+    #define uart_protocol_telemetry_handle()
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_TELEMETRY == 1)) */
+
+#if ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1))
+
+    extern void uart_protocol_beacon_handle();
+
+#else
+
+    /**
+     * @brief Empty macro in case time beacons are disabled
+     *
+     * @see ENABLE_UART_PROTOCOL_BEACON
+     */
+    #define uart_protocol_beacon_handle()
+
+#endif /* ((ENABLE_UART_PROTOCOL == 1) && (ENABLE_UART_PROTOCOL_BEACON == 1)) */
+
 #endif /* _WC_UART_PROTOCOL_H_ */
@@ -32,10 +32,13 @@
  * @see usermodes.c
  */
 
+#include <string.h>
+#include <util/delay.h>
+
 #include "config.h"
 #include "format.h"
 #include "user.h"
-#include "IRMP/irmp.h"
+#include "ir.h"
 #include "pwm.h"
 #include "display.h"
 #include "dcf77.h"
@@ -44,6 +47,8 @@
 #include "uart.h"
 #include "color.h"
 #include "ports.h"
+#include "presence.h"
+#include "timer.h"
 
 /**
  * @brief Port and pin definition of the line in control of the Ambilight
@@ -133,19 +138,45 @@ static uint8_t g_currentIdxs[MS_COUNT];
  */
 static int8_t g_topOfStack;
 
+#if (ENABLE_IR_SUPPORT == 1)
+
 /**
- * @brief Counter used to implement a recognition delay after pressing a key
+ * @brief User command of the key currently being held down
  *
- * This is used to implement the delay in recognition between two key presses.
- * This counter will be assigned the value of USER_KEY_PRESS_DELAY_100MS.
- * handle_ir_code() won't process any other key press until this counter
- * reaches zero. The decrementation itself is done in user_isr10Hz().
+ * This is used to tell whether a repeated IR frame belongs to the same key
+ * as the previous one.
  *
- * @see USER_KEY_PRESS_DELAY_100MS
  * @see handle_ir_code()
- * @see user_isr10Hz()
+ * @see g_keyRepeatCount
  */
-static uint8_t g_keyDelay;
+static user_command_t g_keyRepeatCommand = UC_COMMAND_COUNT;
+
+/**
+ * @brief Number of repeated IR frames received for the key being held down
+ *
+ * This saturates at UINT8_MAX and is reset with every new key press. It
+ * determines the amount of steps executed per frame for keys that support
+ * acceleration.
+ *
+ * @see USER_KEY_REPEAT_ACCEL_FRAMES
+ * @see handle_ir_code()
+ */
+static uint8_t g_keyRepeatCount;
+
+/**
+ * @brief User commands sorted by their IR command code
+ *
+ * This contains the indices of user_prefs_t::irCommandCodes in ascending
+ * order of their command code, so lookupIrCommand() can perform a binary
+ * search. The order of commands with the same code is retained, so the
+ * lowest one is found, just like with a linear search.
+ *
+ * @see buildIrCommandIndex()
+ * @see lookupIrCommand()
+ */
+static uint8_t g_irCommandIndex[UC_COMMAND_COUNT];
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
 
 /**
  * @brief Enumeration of the different "off" states
@@ -189,6 +220,13 @@ static uint8_t g_keyDelay;
  * override_on  IROnOff     user_off
  * \endcode
  *
+ * With ENABLE_PRESENCE_SUPPORT enabled, normal_on and override_on are left
+ * for idle_off (user_power_state_t::UPS_IDLE_OFF) once no motion has been
+ * detected for user_prefs_t::presenceTimeout minutes. Any motion and/or user
+ * command returns to the previous state. The on/off times are still applied
+ * to the previous state meanwhile, so the display returns to the state it
+ * would be in without the motion sensor.
+ *
  * @note Be careful with changes and/or adaptations to the ordering of these
  * items, as some functions rely on it.
  *
@@ -241,6 +279,19 @@ typedef enum {
      */
     UPS_MANUAL_OFF,
 
+    /**
+     * @brief Represents the state when the display was turned off due to
+     * the absence of motion
+     *
+     * This will be assigned to user_power_state whenever no motion has been
+     * detected for user_prefs_t::presenceTimeout minutes while the display
+     * was on. The previous state is kept within g_powerStateBeforeIdle.
+     *
+     * @see ENABLE_PRESENCE_SUPPORT
+     * @see g_powerStateBeforeIdle
+     */
+    UPS_IDLE_OFF,
+
 } user_power_state_t;
 
 /**
@@ -254,6 +305,27 @@ typedef enum {
  */
 static user_power_state_t user_power_state;
 
+#if (ENABLE_PRESENCE_SUPPORT == 1)
+
+    /**
+     * @brief State to return to once motion is detected again
+     *
+     * @see user_power_state_t::UPS_IDLE_OFF
+     * @see user_presence_detected()
+     */
+    static user_power_state_t g_powerStateBeforeIdle;
+
+    /**
+     * @brief Number of seconds no motion has been detected while the display
+     * was on
+     *
+     * @see user_isr1Hz()
+     * @see user_prefs_t::presenceTimeout
+     */
+    static uint16_t g_idleSeconds;
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
 #if (ENABLE_AMBILIGHT_SUPPORT == 1)
 
     /**
@@ -283,37 +355,91 @@ static user_power_state_t user_power_state;
 static bool g_animPreview = false;
 
 /**
- * @brief Counter implementing the delay before saving to EEPROM
+ * @brief Time it took to show the time for the first time after a reset
  *
- * This counter is used to implement the delay defined in
- * USER_DELAY_BEFORE_SAVE_EEPROM_S. The value itself is reset within
- * handle_user_command() once a new command has been received. It is increased
- * once a second within user_isr1Hz(). Once it reaches its threshold the
- * writeback to the EEPROM is initiated.
+ * This is given in milliseconds as returned by timer_get_ms(), which starts
+ * counting once interrupts are enabled. The initialization before that point
+ * is therefore not part of it. It remains `UINT16_MAX` until the time has
+ * actually been shown.
  *
- * @see handle_user_command()
- * @see USER_DELAY_BEFORE_SAVE_EEPROM_S
- * @see user_isr1Hz()
- * @see preferences.h
+ * @see user_setNewTime()
+ * @see user_get_boot_time()
  */
-static uint8_t g_eepromSaveDelay;
+static uint16_t g_bootTimeMs = UINT16_MAX;
 
 /**
- * @brief Counter implementing the delay before checking whether to autoOff
+ * @brief Number of minutes within a single day
  *
- * This counter is used to implement the delay defined in
- * USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S. The value itself is reset within
- * handle_ir_code() once a new command has been received. It is increased
- * once a second within user_isr1Hz(). Once it reaches its threshold a check
- * for the autoOff feature is initiated and processed appropriately.
+ * @see user_onoff_locate()
+ */
+#define USER_MINUTES_PER_DAY (24 * 60)
+
+/**
+ * @brief Value of user_onoff_last when there is no previous check
+ *
+ * @see user_onoff_last
+ */
+#define USER_ONOFF_INVALID UINT16_MAX
+
+/**
+ * @brief Boundaries of all on/off (autoOff) times in ascending order
+ *
+ * These are given in minutes since midnight and are built by
+ * user_onoff_sort() from user_prefs_t::onOffTimes.
+ *
+ * @see user_onoff_off_mask
+ * @see user_onoff_sort()
+ */
+static uint16_t user_onoff_boundaries[UI_ONOFFTIMES_COUNT];
+
+/**
+ * @brief Whether the display is off between two adjacent boundaries
+ *
+ * Bit k is set when the display should be off from user_onoff_boundaries[k]
+ * until the following boundary (wrapping around at midnight).
+ *
+ * @see user_onoff_boundaries
+ */
+static uint8_t user_onoff_off_mask;
+
+#if (UI_ONOFFTIMES_COUNT > 8)
+
+    #error "user_onoff_off_mask can't hold more than four on/off times"
+
+#endif
+
+/**
+ * @brief Indicates whether user_onoff_boundaries is up to date
+ *
+ * @see user_on_off_times_changed()
+ */
+static bool user_onoff_sorted = false;
+
+/**
+ * @brief Minute of the day the display state changes the next time
  *
- * @see handle_ir_code()
- * @see USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S
- * @see user_isr1Hz()
- * @see user_setNewTime()
  * @see checkActivation()
+ * @see user_onoff_locate()
  */
-static uint8_t g_checkIfAutoOffDelay;
+static uint16_t user_onoff_next;
+
+/**
+ * @brief Minute of the day checkActivation() was invoked for the last time
+ *
+ * Any other value than the minute following this one means that the time
+ * has been set (e.g. by datetime_set() or the DCF77 decoder), so the schedule
+ * is looked up again.
+ *
+ * @see checkActivation()
+ */
+static uint16_t user_onoff_last = USER_ONOFF_INVALID;
+
+/**
+ * @brief Whether the current time lies within any on/off (autoOff) range
+ *
+ * @see user_onoff_locate()
+ */
+static bool user_onoff_off;
 
 /**
  * @brief Allowing access to global instance of user_prefs backed by EEPROM
@@ -324,9 +450,17 @@ static uint8_t g_checkIfAutoOffDelay;
 
 static void dispInternalTime(const datetime_t* i_time, display_state_t blinkmask);
 
-static bool checkActivation();
+static bool checkActivation(const datetime_t* i_time);
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+    static void buildIrCommandIndex();
+
+    static void user_start_key_delay();
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
 
-static bool curTimeIsBetween(uint8_t h1, uint8_t m1, uint8_t h2, uint8_t m2);
+static void user_restart_delays();
 
 #if (LOG_USER_STATE == 1)
 
@@ -439,17 +573,17 @@ static bool curTimeIsBetween(uint8_t h1, uint8_t m1, uint8_t h2, uint8_t m2);
      * using UART. Other attributes of datetime_t will simply be ignored.
      *
      * @see datetime_t
-     * @see uint8ToStrLessOneHundred()
+     * @see format_dec()
      */
     void putTime(const datetime_t* time)
     {
 
         char txt[8];
 
-        sprintf_P(txt, fmt_output_unsigned_decimal, time->hh);
+        format_dec(txt, time->hh);
         uart_puts(txt);
         uart_putc(':');
-        sprintf_P(txt, fmt_output_unsigned_decimal, time->mm);
+        format_dec(txt, time->mm);
         uart_puts(txt);
         uart_putc('\n');
 
@@ -490,6 +624,8 @@ static bool curTimeIsBetween(uint8_t h1, uint8_t m1, uint8_t h2, uint8_t m2);
  *
  * Regardless of whether or not the given state was already put on the stack
  * beforehand, it will execute UserState_enter() with the given parameter.
+ * When there is not enough storage left for the data of the state (see
+ * UserState_allocate()), the state won't be entered at all.
  *
  * @param mode The state to add
  * @param param Any parameter for the given state, might also be NULL
@@ -497,6 +633,7 @@ static bool curTimeIsBetween(uint8_t h1, uint8_t m1, uint8_t h2, uint8_t m2);
  * @see g_stateStack
  * @see g_topOfStack
  * @see g_currentIdxs
+ * @see UserState_allocate()
  * @see UserState_enter()
  */
 void addState(menu_state_t mode, const void* param)
@@ -506,6 +643,14 @@ void addState(menu_state_t mode, const void* param)
 
     if ((g_topOfStack == 0) || (user_get_current_menu_state() != mode)) {
 
+        if (!UserState_allocate(mode)) {
+
+            log_state("ERROR: no storage left for state\n");
+
+            return;
+
+        }
+
         g_stateStack[g_topOfStack] = mode;
         g_currentIdxs[mode] = g_topOfStack;
         ++g_topOfStack;
@@ -613,9 +758,9 @@ bool leaveSubState(int8_t indexOfStateToLeave)
 
         {
 
-            char buff[5];
+            char buff[FORMAT_DEC_MAX_LENGTH];
 
-            sprintf_P(buff, fmt_output_unsigned_decimal, g_stateStack[i]);
+            format_dec(buff, g_stateStack[i]);
             uart_puts(buff);
             uart_putc(':');
             uart_putc(canLeave ? 'y' : 'n');
@@ -705,21 +850,40 @@ menu_state_t user_get_current_menu_state()
  *
  * This handles the given user command (user_command_t) either by processing
  * it directly, or by passing it over to the actual handler using
- * UserState_HandleUserCommand().
+ * UserState_HandleUserCommand(). This is the single entry point for user
+ * commands regardless of their source, i.e. the IR remote control (see
+ * handle_ir_code()) as well as the UART protocol (command "i"), so further
+ * sources only need to invoke this.
  *
- * g_eepromSaveDelay and g_checkIfAutoOffDelay get reset every time this
- * function is called to make sure the appropriate functionality works as
- * intended.
+ * The delay before saving to the EEPROM and the one before checking whether
+ * to autoOff get restarted every time this function is called to make sure
+ * the appropriate functionality works as intended.
  *
  * @param user_command The user command that should be handled
  *
  * @see UserState_HandleUserCommand()
- * @see g_eepromSaveDelay
- * @see g_checkIfAutoOffDelay
+ * @see user_restart_delays()
  */
-void handle_user_command(user_command_t user_command)
+void user_command_handle(user_command_t user_command)
 {
 
+    #if (ENABLE_PRESENCE_SUPPORT == 1)
+
+        /*
+         * The first command only turns the display back on
+         */
+        if (user_power_state == UPS_IDLE_OFF) {
+
+            user_presence_detected();
+
+            return;
+
+        }
+
+        g_idleSeconds = 0;
+
+    #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
     if (UC_ONOFF == user_command) {
 
         log_state("OF\n");
@@ -906,8 +1070,88 @@ void handle_user_command(user_command_t user_command)
 
     }
 
-    g_eepromSaveDelay = 0;
-    g_checkIfAutoOffDelay = 0;
+    user_restart_delays();
+
+}
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+/**
+ * @brief Builds the index used to look up IR command codes
+ *
+ * This sorts the user commands by their IR command code into
+ * g_irCommandIndex. It needs to be invoked whenever
+ * user_prefs_t::irCommandCodes has changed, i.e. during the initialization,
+ * once the training of the IR remote control has been finished and when the
+ * codes have been changed otherwise (see user_ir_codes_changed()).
+ *
+ * An insertion sort is used, which is stable and more than fast enough for
+ * the small amount of commands.
+ *
+ * @see g_irCommandIndex
+ * @see TrainIrState_handleIR()
+ * @see user_ir_codes_changed()
+ */
+static void buildIrCommandIndex()
+{
+
+    for (uint8_t i = 0; i < UC_COMMAND_COUNT; i++) {
+
+        uint8_t j = i;
+        uint16_t code = g_params->irCommandCodes[i];
+
+        while (j > 0 && g_params->irCommandCodes[g_irCommandIndex[j - 1]] > code) {
+
+            g_irCommandIndex[j] = g_irCommandIndex[j - 1];
+            j--;
+
+        }
+
+        g_irCommandIndex[j] = i;
+
+    }
+
+}
+
+/**
+ * @brief Looks up the user command assigned to the given IR command code
+ *
+ * @param code IR command code as decoded by IRMP
+ *
+ * @return The appropriate user command, UC_COMMAND_COUNT if there is none
+ *
+ * @see g_irCommandIndex
+ */
+static user_command_t lookupIrCommand(uint16_t code)
+{
+
+    uint8_t low = 0;
+    uint8_t high = UC_COMMAND_COUNT;
+
+    while (low < high) {
+
+        uint8_t mid = (low + high) / 2;
+
+        if (g_params->irCommandCodes[g_irCommandIndex[mid]] < code) {
+
+            low = mid + 1;
+
+        } else {
+
+            high = mid;
+
+        }
+
+    }
+
+    if (low < UC_COMMAND_COUNT
+        && g_params->irCommandCodes[g_irCommandIndex[low]] == code) {
+
+        return (user_command_t)g_irCommandIndex[low];
+
+    }
+
+    return UC_COMMAND_COUNT;
 
 }
 
@@ -915,20 +1159,30 @@ void handle_user_command(user_command_t user_command)
  * @brief Processes any received IR commands
  *
  * This function handles any IR commands received by IRMP. It will check
- * whether a command was decoded successfully using irmp_get_data() and
- * implements a key press delay before any other key press can be recognized.
+ * whether a command was decoded successfully using irmp_get_data().
  *
  * If currently in training state it will dispatch the handling to
- * TrainIrState_handleIR(). Otherwise it will find the correct user command
- * (user_command_t) for the received code and pass it to handle_user_command().
+ * TrainIrState_handleIR(), ignoring the repeated frames of a key being held
+ * down. Otherwise it will look up the correct user command (user_command_t)
+ * for the received code and pass it to user_command_handle().
+ *
+ * A new key press is always handled right away. Repeated frames (see
+ * IRMP_FLAG_REPETITION) of a key being held down are only handled once the
+ * key press delay has run out. For UC_UP, UC_DOWN, UC_BRIGHTNESS_UP and
+ * UC_BRIGHTNESS_DOWN each repeated frame is handled from then on, with
+ * UC_UP and UC_DOWN additionally being accelerated, see
+ * USER_KEY_REPEAT_ACCEL_FRAMES. Any other key is repeated with the key press
+ * delay in between.
  *
  * @note To make sure not to loose any events, this function should be called
  * on a quasi-regular basis.
  *
  * @see irmp_get_data()
- * @see g_keyDelay
+ * @see TIMER_USER_KEY
+ * @see g_keyRepeatCount
+ * @see lookupIrCommand()
  * @see TrainIrState_handleIR()
- * @see handle_user_command()
+ * @see user_command_handle()
  */
 void handle_ir_code()
 {
@@ -937,11 +1191,7 @@ void handle_ir_code()
 
     if (irmp_get_data(&ir_data)) {
 
-        if (g_keyDelay) {
-
-            return;
-
-        }
+        bool repetition = ir_data.flags & IRMP_FLAG_REPETITION;
 
         #if (LOG_USER_IR_CMD == 1)
 
@@ -950,11 +1200,11 @@ void handle_ir_code()
             char text[20];
 
             uart_puts_P("IR-cmd: ");
-            sprintf_P(text, fmt_hex, ir_data.protocol);
+            format_hex(text, ir_data.protocol);
             uart_puts(text);
-            sprintf_P(text, fmt_hex, ir_data.address);
+            format_hex(text, ir_data.address);
             uart_puts(text);
-            sprintf_P(text, fmt_hex, ir_data.command);
+            format_hex(text, ir_data.command);
             uart_puts(text);
             uart_putc('\n');
 
@@ -962,30 +1212,65 @@ void handle_ir_code()
 
         #endif
 
-        g_keyDelay = USER_KEY_PRESS_DELAY_100MS;
-
         if (user_get_current_menu_state() == MS_irTrain) {
 
+            if (repetition || timer_is_armed(TIMER_USER_KEY)) {
+
+                return;
+
+            }
+
+            user_start_key_delay();
             TrainIrState_handleIR(&ir_data);
 
-        } else {
+            return;
 
-            uint8_t ir_code = 0;
+        }
 
-            if (g_params->irAddress != ir_data.address) {
+        if (g_params->irAddress != ir_data.address) {
 
-                return;
+            return;
+
+        }
+
+        user_command_t command = lookupIrCommand(ir_data.command);
+        uint8_t steps = 1;
+
+        if (!repetition || command != g_keyRepeatCommand) {
+
+            g_keyRepeatCommand = command;
+            g_keyRepeatCount = 0;
+            user_start_key_delay();
+
+        } else if (timer_is_armed(TIMER_USER_KEY)) {
+
+            return;
+
+        } else if (command == UC_UP || command == UC_DOWN) {
+
+            if (g_keyRepeatCount != UINT8_MAX) {
+
+                g_keyRepeatCount++;
 
             }
 
-            while ((ir_code < UC_COMMAND_COUNT)
-                && (g_params->irCommandCodes[ir_code] != ir_data.command)) {
+            steps += g_keyRepeatCount / USER_KEY_REPEAT_ACCEL_FRAMES;
+
+            if (steps > USER_KEY_REPEAT_MAX_STEPS) {
 
-                ++ir_code;
+                steps = USER_KEY_REPEAT_MAX_STEPS;
 
             }
 
-            handle_user_command((user_command_t)ir_code);
+        } else if (command != UC_BRIGHTNESS_UP && command != UC_BRIGHTNESS_DOWN) {
+
+            user_start_key_delay();
+
+        }
+
+        while (steps--) {
+
+            user_command_handle(command);
 
         }
 
@@ -993,13 +1278,17 @@ void handle_ir_code()
 
 }
 
+#endif /* (ENABLE_IR_SUPPORT == 1) */
+
 /**
  * @brief Initializes the user module
  *
  * This initializes the user module: First of all it calls UserState_init(),
  * which will initialize all the user modes implemented within usermodes.c.
  * Afterwards it will restore the mode previously stored. If no mode was
- * stored, it will fallback to the default values. Furthermore this function
+ * stored, it will fallback to the default values. With support for the IR
+ * remote control, the "training" mode is entered on top of it for
+ * USER_STARTUP_WAIT_IR_TRAIN_S seconds. Furthermore this function
  * also sets up the data direction registers of the lines in control of the
  * Ambilight, Bluetooth and/or auxiliary GPO lines.
  *
@@ -1017,6 +1306,15 @@ void user_init()
 {
 
     UserState_init();
+
+    #if (ENABLE_IR_SUPPORT == 1)
+
+        buildIrCommandIndex();
+
+    #endif /* (ENABLE_IR_SUPPORT == 1) */
+
+    timer_start(TIMER_USER_AUTO_OFF, TIMER_1S,
+        USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S, NULL);
     addState(g_params->mode & 0x7f, 0);
 
     if (g_params->mode & 0x80) {
@@ -1025,7 +1323,11 @@ void user_init()
 
     }
 
-    addState(MS_irTrain, NULL);
+    #if (ENABLE_IR_SUPPORT == 1)
+
+        addState(MS_irTrain, NULL);
+
+    #endif /* (ENABLE_IR_SUPPORT == 1) */
 
     #if (ENABLE_AMBILIGHT_SUPPORT == 1)
 
@@ -1074,7 +1376,7 @@ static void dispInternalTime(const datetime_t* i_time, display_state_t blinkmask
  * @brief Takes over the given time internally
  *
  * This will take over the given time internally (g_dateTime). It then checks
- * whether enough time (g_checkIfAutoOffDelay) has passed to check whether the
+ * whether enough time (TIMER_USER_AUTO_OFF) has passed to check whether the
  * autoOff times should be consulted to decide whether the display should be
  * enabled and/or disabled by the autoOff feature. It will then turn the
  * display on and/or off if neccessary - depending upon the result of the
@@ -1083,9 +1385,10 @@ static void dispInternalTime(const datetime_t* i_time, display_state_t blinkmask
  * @param i_time The new date and time to set
  *
  * @see g_dateTime
- * @see g_checkIfAutoOffDelay
+ * @see TIMER_USER_AUTO_OFF
  * @see USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S
  * @see checkActivation()
+ * @see pwm_set_hour()
  */
 void user_setNewTime(const datetime_t* i_time)
 {
@@ -1094,9 +1397,35 @@ void user_setNewTime(const datetime_t* i_time)
 
         log_time("saved Time ");
 
-        if ((g_checkIfAutoOffDelay >= USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S)) {
+        if (pwm_set_hour(i_time->hh)) {
 
-            if (checkActivation()) {
+            user_save_delayed();
+
+        }
+
+        if (!timer_is_armed(TIMER_USER_AUTO_OFF)) {
+
+            #if (ENABLE_PRESENCE_SUPPORT == 1)
+
+                /*
+                 * Apply the on/off times to the state the display returns
+                 * to, but keep it turned off
+                 */
+                bool idle = (user_power_state == UPS_IDLE_OFF);
+
+                if (idle) {
+
+                    user_power_state = g_powerStateBeforeIdle;
+
+                }
+
+            #else
+
+                const bool idle = false;
+
+            #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
+            if (checkActivation(i_time)) {
 
                 if (user_power_state != UPS_MANUAL_OFF) {
 
@@ -1111,7 +1440,12 @@ void user_setNewTime(const datetime_t* i_time)
                     #endif
 
                     user_power_state = UPS_NORMAL_ON;
-                    pwm_on();
+
+                    if (!idle) {
+
+                        pwm_on();
+
+                    }
 
                 }
 
@@ -1138,6 +1472,17 @@ void user_setNewTime(const datetime_t* i_time)
 
             }
 
+            #if (ENABLE_PRESENCE_SUPPORT == 1)
+
+                if (idle) {
+
+                    g_powerStateBeforeIdle = user_power_state;
+                    user_power_state = UPS_IDLE_OFF;
+
+                }
+
+            #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
         }
 
     }
@@ -1148,6 +1493,23 @@ void user_setNewTime(const datetime_t* i_time)
         log_time("disp Time ");
 
         putTime(datetime_get());
+
+        if (g_bootTimeMs == UINT16_MAX) {
+
+            g_bootTimeMs = timer_get_ms();
+
+            #if (ENABLE_FAST_BOOT == 1)
+
+                display_setNewTime(datetime_get());
+
+                log_time("\n");
+
+                return;
+
+            #endif /* (ENABLE_FAST_BOOT == 1) */
+
+        }
+
         display_fadeNewTime(datetime_get());
 
         log_time("\n");
@@ -1157,82 +1519,212 @@ void user_setNewTime(const datetime_t* i_time)
 }
 
 /**
- * @brief "ISR" executed with a frequency of 1000 Hz
+ * @brief Prepares the display for the time of the next minute
+ *
+ * This is invoked by the datetime module during the last second of each
+ * minute. If the time would be shown by user_setNewTime() at all, the
+ * change over to the given time is armed within the display module, so it
+ * starts right at the boundary of the minute (see display_armNewTime()).
+ * user_setNewTime() won't start it a second time once the new minute has
+ * been noticed.
  *
- * This "ISR" will be executed a thousand times each second (INTERRUPT_1000HZ).
- * It is responsible for calling UserState_Isr1000Hz() with the current state
- * as parameter.
+ * @param i_time The time of the next minute, only the time itself is of any
+ * relevance
  *
- * @see INTERRUPT_1000HZ
- * @see UserState_Isr1000Hz()
+ * @see display_armNewTime()
+ * @see user_setNewTime()
  */
-void user_isr1000Hz()
+void user_armNewTime(const datetime_t* i_time)
 {
 
-    UserState_Isr1000Hz(user_get_current_menu_state());
+    if (!UserState_prohibitTimeDisplay(user_get_current_menu_state())
+            && (user_power_state != UPS_AUTO_OFF)
+            && g_bootTimeMs != UINT16_MAX) {
+
+        display_armNewTime(i_time);
+
+    }
 
 }
 
 /**
- * @brief "ISR" executed with a frequency of 100 Hz
+ * @brief Returns the time it took to show the time after the last reset
  *
- * This "ISR" will be executed a hundred times each second (INTERRUPT_100HZ).
- * It is responsible for calling UserState_Isr100Hz() with the current state as
- * parameter.
+ * @return Milliseconds from enabling interrupts until the time was shown for
+ * the first time, `UINT16_MAX` if it hasn't been shown yet
  *
- * @see INTERRUPT_100HZ
- * @see UserState_Isr100Hz()
+ * @see g_bootTimeMs
+ * @see ENABLE_FAST_BOOT
  */
-void user_isr100Hz()
+uint16_t user_get_boot_time()
 {
 
-    UserState_Isr100Hz(user_get_current_menu_state());
+    return g_bootTimeMs;
 
 }
 
+#if (ENABLE_WARM_RESTART == 1)
+
+    /**
+     * @brief Returns the current "power" state
+     *
+     * @return Current power state, see user_power_state_t
+     *
+     * @see user_restore_power_state()
+     */
+    uint8_t user_get_power_state()
+    {
+
+        return user_power_state;
+
+    }
+
+    /**
+     * @brief Restores the "power" state after a warm restart
+     *
+     * The display is turned off again unless it was on before the reset (or
+     * showing the autoOff animation). As it isn't known what the display
+     * would return to, user_power_state_t::UPS_IDLE_OFF is restored as
+     * user_power_state_t::UPS_NORMAL_ON, so the timeout simply starts over.
+     *
+     * @param state Power state, as returned by user_get_power_state()
+     *
+     * @see restart_restore()
+     */
+    void user_restore_power_state(uint8_t state)
+    {
+
+        if (state >= UPS_IDLE_OFF) {
+
+            state = UPS_NORMAL_ON;
+
+        }
+
+        user_power_state = state;
+
+        if (state == UPS_MANUAL_OFF
+                || (state == UPS_AUTO_OFF && !g_params->useAutoOffAnimation)) {
+
+            pwm_off();
+
+        }
+
+    }
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+    /**
+     * @brief Starts the delay in the recognition of repeated key presses
+     *
+     * handle_ir_code() won't process any repeated frames of a key being held
+     * down until USER_KEY_PRESS_DELAY_100MS has passed, i.e. as long as
+     * TIMER_USER_KEY is armed.
+     *
+     * @see TIMER_USER_KEY
+     * @see USER_KEY_PRESS_DELAY_100MS
+     * @see handle_ir_code()
+     */
+    static void user_start_key_delay()
+    {
+
+        timer_start(TIMER_USER_KEY, TIMER_100MS, USER_KEY_PRESS_DELAY_100MS, NULL);
+
+    }
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
+
+#if (ENABLE_USER_AUTOSAVE == 1)
+
+    /**
+     * @brief Initiates the writeback to the EEPROM once the delay has passed
+     *
+     * @see TIMER_USER_SAVE
+     * @see user_save_delayed()
+     * @see preferences_save()
+     */
+    static void user_save_expired()
+    {
+
+        preferences_save();
+
+    }
+
+#endif /* (ENABLE_USER_AUTOSAVE == 1) */
+
 /**
- * @brief "ISR" executed with a frequency of 10 Hz
+ * @brief Schedules the writeback of changed preferences to the EEPROM
+ *
+ * This restarts TIMER_USER_SAVE, so the preferences are written back once
+ * USER_DELAY_BEFORE_SAVE_EEPROM_S has passed without any further change,
+ * just like it is done for changes made by IR commands. This way a series of
+ * changes, e.g. made via the UART protocol, results in a single record being
+ * written only. If ENABLE_USER_AUTOSAVE is disabled, the writeback is
+ * initiated right away.
+ *
+ * @see TIMER_USER_SAVE
+ * @see user_save_expired()
+ * @see preferences_save()
+ */
+void user_save_delayed()
+{
+
+    #if (ENABLE_USER_AUTOSAVE == 1)
+
+        timer_start(TIMER_USER_SAVE, TIMER_1S | TIMER_DEFERRED,
+            USER_DELAY_BEFORE_SAVE_EEPROM_S, user_save_expired);
+
+    #else
+
+        preferences_save();
+
+    #endif /* (ENABLE_USER_AUTOSAVE == 1) */
+
+}
+
+/**
+ * @brief Restarts the delays that depend on the last user command
  *
- * This "ISR" will be executed ten times each second (INTERRUPT_10HZ). It is
- * responsible for calling UserState_Isr10Hz() with the current state as
- * parameter and decreases the delay counter for key press recognition
- * (g_keyDelay).
+ * The writeback to the EEPROM is scheduled USER_DELAY_BEFORE_SAVE_EEPROM_S
+ * after the last command (if ENABLE_USER_AUTOSAVE is enabled), and the
+ * autoOff times are not consulted until USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S
+ * has passed, so the user can turn the clock on and/or off manually.
  *
- * @see INTERRUPT_10HZ
- * @see UserState_Isr10Hz()
- * @see g_keyDelay
+ * @see user_command_handle()
+ * @see user_save_delayed()
+ * @see TIMER_USER_AUTO_OFF
+ * @see user_setNewTime()
  */
-void user_isr10Hz()
+static void user_restart_delays()
 {
 
-    UserState_Isr10Hz(user_get_current_menu_state());
+    #if (ENABLE_USER_AUTOSAVE == 1)
 
-    if (g_keyDelay != 0) {
+        user_save_delayed();
 
-        --g_keyDelay;
+    #endif /* (ENABLE_USER_AUTOSAVE == 1) */
 
-    }
+    timer_start(TIMER_USER_AUTO_OFF, TIMER_1S,
+        USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S, NULL);
 
 }
 
 /**
  * @brief "ISR" executed with a frequency of 1 Hz
  *
- * This "ISR" will be executed once a second (INTERRUPT_1HZ) and contains some
- * task, which are executed comparatively slow. Among other things it increases
- * various delay counters (g_eepromSaveDelay, g_checkIfAutoOffDelay) and
- * will initiate the writeback to the EEPROM once the appropriate delay
- * (g_eepromSaveDelay) has reached its threshold
- * (USER_DELAY_BEFORE_SAVE_EEPROM_S). It will also make sure that either
- * UserState_Isr1Hz() with the current state as parameter and/or
- * display_autoOffAnimStep1Hz() with the current setting of g_animPreview are
- * executed - depending on the current power "state" (user_power_state).
- *
- * @see INTERRUPT_1HZ
- * @see g_eepromSaveDelay
- * @see g_checkIfAutoOffDelay
- * @see g_eepromSaveDelay
- * @see USER_DELAY_BEFORE_SAVE_EEPROM_S
+ * This "ISR" will be executed once a second from within the main loop
+ * (INTERRUPT_1HZ_DEFERRED) and contains some task, which are executed
+ * comparatively slow. It will make sure that either UserState_Isr1Hz() with
+ * the current state as parameter and/or display_autoOffAnimStep1Hz() with the
+ * current setting of g_animPreview are executed - depending on the current
+ * power "state" (user_power_state).
+ *
+ * With ENABLE_PRESENCE_SUPPORT enabled, this also turns the display off once
+ * no motion has been detected for user_prefs_t::presenceTimeout minutes (see
+ * user_power_state_t::UPS_IDLE_OFF).
+ *
+ * @see INTERRUPT_1HZ_DEFERRED
  * @see UserState_Isr1Hz()
  * @see display_autoOffAnimStep1Hz()
  * @see g_animPreview
@@ -1243,27 +1735,24 @@ void user_isr1Hz()
 
     useAutoOffAnimation = false;
 
-    if (g_eepromSaveDelay <= USER_DELAY_BEFORE_SAVE_EEPROM_S) {
+    #if (ENABLE_PRESENCE_SUPPORT == 1)
 
-        ++g_eepromSaveDelay;
+        if (presence_is_active() || g_params->presenceTimeout == 0
+                || user_power_state >= UPS_AUTO_OFF) {
 
-    }
-
-    if (g_checkIfAutoOffDelay <= USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S) {
-
-        ++g_checkIfAutoOffDelay;
+            g_idleSeconds = 0;
 
-    }
-
-    #if (ENABLE_USER_AUTOSAVE == 1)
+        } else if (++g_idleSeconds >= g_params->presenceTimeout * 60U) {
 
-        if (g_eepromSaveDelay == USER_DELAY_BEFORE_SAVE_EEPROM_S) {
+            log_state("IDLE\n");
 
-            preferences_save();
+            g_powerStateBeforeIdle = user_power_state;
+            user_power_state = UPS_IDLE_OFF;
+            pwm_off();
 
         }
 
-    #endif
+    #endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
 
     if ((user_power_state != UPS_AUTO_OFF) && (!g_animPreview)) {
 
@@ -1282,73 +1771,243 @@ void user_isr1Hz()
 
 }
 
+#if (ENABLE_PRESENCE_SUPPORT == 1)
+
+    /**
+     * @brief Handles motion detected by the motion sensor
+     *
+     * This restarts the timeout and turns the display back on in case it
+     * was turned off due to the absence of motion. The previous power state
+     * is restored, so the autoOff animation is shown again if appropriate.
+     *
+     * This needs to be called whenever `EVENT_PRESENCE` has been posted.
+     *
+     * @see user_power_state_t::UPS_IDLE_OFF
+     * @see g_powerStateBeforeIdle
+     * @see user_isr1Hz()
+     */
+    void user_presence_detected()
+    {
+
+        g_idleSeconds = 0;
+
+        if (user_power_state == UPS_IDLE_OFF) {
+
+            log_state("WAKE\n");
+
+            user_power_state = g_powerStateBeforeIdle;
+
+            if ((user_power_state != UPS_AUTO_OFF) || g_params->useAutoOffAnimation) {
+
+                pwm_on();
+
+            }
+
+        }
+
+    }
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
 /**
- * @brief Checks whether the current time lies within the given range
+ * @brief Checks whether the given minute lies within any on/off range
  *
- * The range is defined by the four parameters, whereas the first two parameter
- * define the hours and/or minutes of the first boundary, and the last two
- * parameters the hours and/or minutes of the second boundary.
+ * Each range starts with the even and ends (exclusively) with the odd entry
+ * of user_prefs_t::onOffTimes. Ranges with an end before their start wrap
+ * around at midnight, ranges with equal boundaries are empty.
  *
- * @param h1 The hours of the first boundary
- * @param m1 The minutes of the first boundary
- * @param h2 The hours of the second boundary
- * @param m2 The minutes of the second boundary
+ * @param minute Minutes since midnight
  *
- * @return True if current time lies in between the given range, else false
+ * @return True if the minute lies within any range, else false
  *
- * @see datetime_get()
+ * @see user_onoff_sort()
  */
-static bool curTimeIsBetween(uint8_t h1, uint8_t m1, uint8_t h2, uint8_t m2)
+static bool user_onoff_within(uint16_t minute)
 {
 
-    const datetime_t* datetime = datetime_get();
+    uint8_t i;
+
+    for (i = 0; i < UI_ONOFFTIMES_COUNT; i += 2) {
 
-    uint8_t h = datetime->hh;
-    uint8_t m = datetime->mm;
+        uint16_t start = g_params->onOffTimes[i].h * 60 + g_params->onOffTimes[i].m;
+        uint16_t end = g_params->onOffTimes[i + 1].h * 60 + g_params->onOffTimes[i + 1].m;
 
-    uint8_t largert1 = (h > h1) || ((h == h1) && (m >= m1));
-    uint8_t lesst2 = (h < h2) || ((h == h2) && (m < m2));
+        if (start <= end) {
 
-    if (h2 < h1) {
+            if (minute >= start && minute < end) {
 
-        return  largert1 || lesst2;
+                return true;
 
-    } else {
+            }
 
-        return  largert1 && lesst2;
+        } else if (minute >= start || minute < end) {
+
+            return true;
+
+        }
 
     }
 
+    return false;
+
 }
 
+/**
+ * @brief Sorts the boundaries of the on/off (autoOff) times
+ *
+ * This puts all boundaries of user_prefs_t::onOffTimes into
+ * user_onoff_boundaries in ascending order and precalculates the state of
+ * the display in between each of them. The state can only change at one of
+ * the boundaries, so it is enough to evaluate the ranges once for each of
+ * them.
+ *
+ * @see user_onoff_boundaries
+ * @see user_onoff_off_mask
+ * @see user_onoff_within()
+ */
+static void user_onoff_sort()
+{
+
+    uint8_t i;
+    uint8_t j;
+
+    for (i = 0; i < UI_ONOFFTIMES_COUNT; i++) {
+
+        uint16_t minute = g_params->onOffTimes[i].h * 60 + g_params->onOffTimes[i].m;
+
+        for (j = i; j > 0 && user_onoff_boundaries[j - 1] > minute; j--) {
+
+            user_onoff_boundaries[j] = user_onoff_boundaries[j - 1];
+
+        }
+
+        user_onoff_boundaries[j] = minute;
+
+    }
+
+    user_onoff_off_mask = 0;
+
+    for (i = 0; i < UI_ONOFFTIMES_COUNT; i++) {
+
+        if (user_onoff_within(user_onoff_boundaries[i])) {
+
+            user_onoff_off_mask |= _BV(i);
+
+        }
+
+    }
+
+    user_onoff_sorted = true;
+
+}
+
+/**
+ * @brief Looks up the state of the display and its next transition
+ *
+ * The current state is the one following the last boundary not after the
+ * given minute, and the next transition takes place at the first boundary
+ * after it. Before the first and after the last boundary the state of the
+ * last boundary applies, as it wraps around at midnight.
+ *
+ * @param minute Minutes since midnight
+ *
+ * @see user_onoff_next
+ * @see user_onoff_off
+ */
+static void user_onoff_locate(uint16_t minute)
+{
+
+    uint8_t i;
+
+    for (i = 0; i < UI_ONOFFTIMES_COUNT && user_onoff_boundaries[i] <= minute; i++);
+
+    user_onoff_off = user_onoff_off_mask & _BV((i + UI_ONOFFTIMES_COUNT - 1) % UI_ONOFFTIMES_COUNT);
+    user_onoff_next = user_onoff_boundaries[i % UI_ONOFFTIMES_COUNT];
+
+}
+
+/**
+ * @brief Invalidates the schedule of the on/off (autoOff) times
+ *
+ * This needs to be invoked whenever user_prefs_t::onOffTimes has been
+ * changed. The schedule is rebuilt with the next invocation of
+ * checkActivation().
+ *
+ * @see user_onoff_sort()
+ */
+void user_on_off_times_changed()
+{
+
+    user_onoff_sorted = false;
+
+}
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+    /**
+     * @brief Rebuilds the index of the IR command codes
+     *
+     * This needs to be invoked whenever user_prefs_t::irCommandCodes has been
+     * changed from outside of this module, e.g. by a transfer of the
+     * preferences via UART.
+     *
+     * @see buildIrCommandIndex()
+     */
+    void user_ir_codes_changed()
+    {
+
+        buildIrCommandIndex();
+
+    }
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
+
 /**
  * @brief Checks whether display should be activated for autoOff feature
  *
- * This function checks whether the current time lies outside of any defined
+ * This function checks whether the given time lies outside of any defined
  * on/off (autoOff) time range and returns true if it does.
  *
- * @return True if current time lies outside any on/off time ranges, else false
+ * The ranges themselves are only evaluated when the schedule has changed
+ * (see user_on_off_times_changed()) or the time has jumped, otherwise the
+ * minute is simply compared against the next transition.
+ *
+ * @param i_time The current time
+ *
+ * @return True if the time lies outside any on/off time ranges, else false
  *
  * @see user_prefs_t::onOffTimes
- * @see curTimeIsBetween()
+ * @see user_onoff_locate()
  * @see user_setNewTime()
  */
-static bool checkActivation()
+static bool checkActivation(const datetime_t* i_time)
 {
 
-    uint8_t i;
+    uint16_t minute = i_time->hh * 60 + i_time->mm;
+    uint16_t expected = user_onoff_last + 1;
 
-    for (i = 0; i < UI_ONOFFTIMES_COUNT; i += 2) {
+    if (expected == USER_MINUTES_PER_DAY) {
 
-        if (curTimeIsBetween(g_params->onOffTimes[i].h, g_params->onOffTimes[i].m,
-            g_params->onOffTimes[i + 1].h, g_params->onOffTimes[i + 1].m)) {
+        expected = 0;
 
-            return false;
+    }
 
-        }
+    if (!user_onoff_sorted) {
+
+        user_onoff_sort();
+        user_onoff_last = USER_ONOFF_INVALID;
+
+    }
+
+    if (user_onoff_last == USER_ONOFF_INVALID || minute != expected
+            || minute == user_onoff_next) {
+
+        user_onoff_locate(minute);
 
     }
 
-    return true;
+    user_onoff_last = minute;
+
+    return !user_onoff_off;
 
 }
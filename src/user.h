@@ -38,6 +38,7 @@
 
 #include "color.h"
 #include "config.h"
+#include "presence.h"
 #include "user_command.h"
 
 /**
@@ -192,7 +193,7 @@ typedef enum
  * receiving an IR command before changed data is written back to EEPROM.
  *
  * @see ENABLE_USER_AUTOSAVE
- * @see user_isr1Hz()
+ * @see TIMER_USER_SAVE
  */
 #define USER_DELAY_BEFORE_SAVE_EEPROM_S 120
 
@@ -205,7 +206,7 @@ typedef enum
  * time(s) defined by the user. This makes sure that the display isn't simply
  * turned off while the user is still interacting with the clock itself.
  *
- * @see user_isr1Hz()
+ * @see TIMER_USER_AUTO_OFF
  */
 #define USER_DELAY_CHECK_IF_AUTO_OFF_REACHED_S 10
 
@@ -756,6 +757,17 @@ typedef struct {
      */
     uint8_t mode;
 
+    /**
+     * @brief Minutes without motion before the display is turned off
+     *
+     * A value of zero disables this. It is only used when the firmware is
+     * built with ENABLE_PRESENCE_SUPPORT.
+     *
+     * @see PRESENCE_TIMEOUT_DEFAULT_MIN
+     * @see user_power_state_t::UPS_IDLE_OFF
+     */
+    uint8_t presenceTimeout;
+
 } user_prefs_t;
 
 extern bool useAutoOffAnimation;
@@ -772,6 +784,26 @@ extern bool useAutoOffAnimation;
  */
 #define USER_KEY_PRESS_DELAY_100MS 3
 
+/**
+ * @brief Number of repeated IR frames after which UC_UP and UC_DOWN speed up
+ *
+ * While UC_UP or UC_DOWN is being held down on the remote control, the
+ * amount of steps executed per received frame is increased by one each time
+ * this amount of repeated frames has been received, up to
+ * USER_KEY_REPEAT_MAX_STEPS.
+ *
+ * @see USER_KEY_REPEAT_MAX_STEPS
+ * @see handle_ir_code()
+ */
+#define USER_KEY_REPEAT_ACCEL_FRAMES 8
+
+/**
+ * @brief Maximum amount of steps executed per repeated IR frame
+ *
+ * @see USER_KEY_REPEAT_ACCEL_FRAMES
+ */
+#define USER_KEY_REPEAT_MAX_STEPS 4
+
 /**
  * @brief Default value for interval between two animation steps in hue fading
  * mode
@@ -986,20 +1018,46 @@ extern void quitMyself(menu_state_t state, const void* result);
 
 extern menu_state_t user_get_current_menu_state();
 
-extern void handle_user_command(user_command_t user_command);
+extern void user_command_handle(user_command_t user_command);
 
-extern void handle_ir_code();
+#if (ENABLE_IR_SUPPORT == 1)
+
+    extern void handle_ir_code();
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
 
 extern void user_setNewTime(const datetime_t* i_time);
 
-extern void user_isr1000Hz();
+extern void user_armNewTime(const datetime_t* i_time);
+
+extern uint16_t user_get_boot_time();
+
+#if (ENABLE_WARM_RESTART == 1)
+
+    extern uint8_t user_get_power_state();
+
+    extern void user_restore_power_state(uint8_t state);
+
+#endif /* (ENABLE_WARM_RESTART == 1) */
 
-extern void user_isr100Hz();
+extern void user_save_delayed();
 
-extern void user_isr10Hz();
+extern void user_on_off_times_changed();
+
+#if (ENABLE_IR_SUPPORT == 1)
+
+    extern void user_ir_codes_changed();
+
+#endif /* (ENABLE_IR_SUPPORT == 1) */
 
 extern void user_isr1Hz();
 
+#if (ENABLE_PRESENCE_SUPPORT == 1)
+
+    extern void user_presence_detected();
+
+#endif /* (ENABLE_PRESENCE_SUPPORT == 1) */
+
 extern void user_init();
 
 /**
@@ -1165,7 +1223,8 @@ extern void user_init();
     1, \
     USER_PULSE_CHANGE_INT_10MS, \
     USER_HUE_CHANGE_INT_100MS, \
-    MS_normalMode \
+    MS_normalMode, \
+    PRESENCE_TIMEOUT_DEFAULT_MIN \
 \
 }
 
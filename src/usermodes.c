@@ -32,10 +32,11 @@
  * @see user.c
  */
 
+#if (ENABLE_IR_SUPPORT == 1)
+
 /**
  * @brief Data needed for the "training" mode
  *
- * @see mode_trainIrState
  * @see menu_state_t::MS_irTrain
  */
 typedef struct {
@@ -64,47 +65,7 @@ typedef struct {
 
 } TrainIrState;
 
-/**
- * @brief Actual variable holding TrainIrState
- *
- * @see TrainIrState
- * @see TrainIrState_1Hz()
- * @see TrainIrState_handleIR()
- */
-static TrainIrState mode_trainIrState;
-
-/**
- * @brief Data needed for the "show number" mode
- *
- * @see mode_showNumberState
- * @see menu_state_t::MS_showNumber
- */
-typedef struct {
-
-    /**
-     * @brief Counter to keep track of the time the number has been shown
-     *
-     * This is used as counter to keep track of the duration the current number
-     * has already been displayed. Once the number has been shown for the
-     * amount of time defined in USER_NORMAL_SHOW_NUMBER_DELAY_100MS the mode
-     * will quit itself.
-     *
-     * @see ShowNumberState_enter()
-     * @see ShowNumberState_10Hz()
-     * @see USER_NORMAL_SHOW_NUMBER_DELAY_100MS
-     */
-    uint8_t delay100ms;
-
-} ShowNumberState;
-
-/**
- * @brief Actual variable holding ShowNumberState
- *
- * @see ShowNumberState
- * @see ShowNumberState_enter()
- * @see ShowNumberState_10Hz()
- */
-static ShowNumberState mode_showNumberState;
+#endif /* (ENABLE_IR_SUPPORT == 1) */
 
 #if (ENABLE_RGB_SUPPORT == 1)
 
@@ -144,7 +105,6 @@ static ShowNumberState mode_showNumberState;
     /**
      * @brief Data needed for the "normal" mode
      *
-     * @see mode_normalState
      * @see menu_state_t::MS_normalMode
      */
     typedef struct {
@@ -166,7 +126,8 @@ static ShowNumberState mode_showNumberState;
          * @brief Current hue value
          *
          * This holds the current hue value, which can only be changed by the
-         * user in this mode.
+         * user in this mode. It is derived from the current color once the
+         * user starts changing the hue.
          *
          * @see NormalState_handleUserCommand()
          * @see UC_CHANGE_HUE
@@ -175,20 +136,11 @@ static ShowNumberState mode_showNumberState;
 
     } NormalState;
 
-    /**
-     * @brief Actual variable holding NormalState
-     *
-     * @see NormalState
-     * @see NormalState_handleUserCommand()
-     */
-    static NormalState mode_normalState;
-
 #endif
 
 /**
  * @brief Data needed for the "pulse" mode
  *
- * @see mode_pulseState
  * @see menu_state_t::MS_pulseMode
  */
 typedef struct {
@@ -197,43 +149,21 @@ typedef struct {
      * @brief Holds the current brightness step
      *
      * This contains the current brightness step, which will be passed on to
-     * color_pulse_waveform() when in  pulse mode and is newly calculated every
-     * 10 ms by PulseState_100Hz().
+     * color_pulse_waveform() when in  pulse mode and is newly calculated
+     * whenever TIMER_USER_PULSE expires, see PulseState_step().
      *
-     * @see PulseState_100Hz()
+     * @see PulseState_step()
      * @see color_pulse_waveform()
      */
     uint8_t curBrightness;
 
-    /**
-     * @brief Counter keeping track of the time displaying with same brightness
-     *
-     * This is used as counter to keep track of the duration the output is
-     * already being displayed with the current brightness. Once the brightness
-     * hasn't changed for the amount of time defined by the user in
-     * user_prefs_t::pulseUpdateInterval it will be updated.
-     *
-     * @see user_prefs_t::pulseUpdateInterval
-     * @see PulseState_100Hz()
-     */
-    uint8_t delay10ms;
-
 } PulseState;
 
-/**
- * @brief Actual variable holding PulseState
- *
- * @see PulseState
- * @see PulseState_100Hz()
- */
-static PulseState mode_pulseState;
-
 #if (ENABLE_RGB_SUPPORT == 1)
 
     /**
      * @brief Data needed for the "hue fading" mode
      *
-     * @see mode_autoHueState
      * @see menu_state_t::MS_hueMode
      */
     typedef struct {
@@ -247,41 +177,17 @@ static PulseState mode_pulseState;
          *
          * @see COLOR_HUE_MAX
          * @see color_hue2rgb()
-         * @see AutoHueState_10Hz()
+         * @see AutoHueState_step()
          */
         color_hue_t curHue;
 
-        /**
-         * @brief Counter to keep track of the length of the current hue fading
-         *
-         * This is used as counter to keep track of the duration the output
-         * has been displayed with the current hue (AutoHueState::curHue).
-         * Once the user defined time interval
-         * (user_prefs_t::hueChangeInterval) has been reached, it will
-         * update and apply the new hue.
-         *
-         * @see AutoHueState_10Hz()
-         * @see user_prefs_t::hueChangeInterval
-         * @see USER_NORMAL_SHOW_NUMBER_DELAY_100MS
-         */
-        uint8_t delay100ms;
-
     } AutoHueState;
 
-    /**
-     * @brief Actual variable holding AutoHueState
-     *
-     * @see AutoHueState
-     * @see AutoHueState_10Hz()
-     */
-    static AutoHueState mode_autoHueState;
-
 #endif
 
 /**
  * @brief Data needed for the "demo" mode
  *
- * @see mode_demoState
  * @see menu_state_t::MS_demoMode
  */
 typedef struct {
@@ -289,34 +195,16 @@ typedef struct {
     /**
      * @brief The current step of the demo animation
      *
-     * The demo (both in normal as well as in fast mode) is consisting of
-     * different steps. Each step corresponds to a different display state.
-     * The actual meaning of a step depends upon the mode ("normal" and/or
-     * "fast"). Within "normal" mode each step corresponds to a different
-     * LED group being enabled. Within "fast" mode there are actually only
-     * eight different steps. Within each step a different output of each LED
-     * driver is enabled. This is responsible for the multiplexing, which
-     * makes all LEDs appear to be enabled.
+     * The "normal" demo is consisting of different steps. Each step
+     * corresponds to a different LED group being enabled. The "fast" mode
+     * doesn't make use of this, as it is entirely scanned out by the display
+     * module, see DemoState_handleUserCommand().
      *
      * @see display_state_t
-     * @see DemoState_1000Hz()
-     * @see DemoState_10Hz()
+     * @see DemoState_step()
      */
     uint8_t demoStep;
 
-    /**
-     * @brief Counter to keep track of the length of the current step
-     *
-     * This is used as counter to keep track of the duration of the current
-     * step within the demo animation. It is only used in "normal" mode. Once
-     * the interval reaches the limit defined by USER_DEMO_CHANGE_INT_100MS
-     * the next demo step is performed.
-     *
-     * @see AutoHueState_10Hz()
-     * @see USER_DEMO_CHANGE_INT_100MS
-     */
-    uint8_t delay100ms;
-
     /*
      * @brief Indicates whether or not the "fast" mode is enabled
      *
@@ -325,26 +213,14 @@ typedef struct {
      * selected, and reset to false when it is left again.
      *
      * @see DemoState_handleUserCommand()
-     * @see AutoHueState_1000Hz()
      */
     bool fastMode;
 
 } DemoState;
 
-/**
- * @brief Actual variable holding DemoState
- *
- * @see DemoState
- * @see DemoState_handleUserCommand()
- * @see AutoHueState_10Hz()
- * @see AutoHueState_1000Hz()
- */
-static DemoState mode_demoState;
-
 /**
  * @brief Data needed for the "set system time" mode
  *
- * @see mode_setSystemTimeState
  * @see menu_state_t::MS_setSystemTime
  */
 typedef struct {
@@ -360,20 +236,9 @@ typedef struct {
 
 } SetSystemTimeState;
 
-/**
- * @brief Actual variable holding SetSystemTimeState
- *
- * @see SetSystemTimeState
- * @see SetSystemTimeState_enter()
- * @see SetSystemTimeState_substateFinished()
- * @see UserState_prohibitLeave()
- */
-static SetSystemTimeState mode_setSystemTimeState;
-
 /**
  * @brief Data needed for the "set on/off time(s)" mode
  *
- * @see mode_setOnOffTimeState
  * @see menu_state_t::MS_setOnOffTime
  */
 typedef struct {
@@ -402,21 +267,9 @@ typedef struct {
 
 } SetOnOffTimeState;
 
-/**
- * @brief Actual variable holding SetOnOffTimeState
- *
- * @see SetOnOffTimeState
- * @see SetOnOffTimeState_enter()
- * @see SetOnOffTimeState_substateFinished()
- * @see UserState_prohibitLeave()
- * @see SetOnOffTimeState_handleUserCommand()
- */
-static SetOnOffTimeState mode_setOnOffTimeState;
-
 /**
  * @brief Data needed for the "enter time" mode
  *
- * @see mode_enterTimeState
  * @see menu_state_t::MS_enterTime
  */
 typedef struct {
@@ -467,26 +320,79 @@ typedef struct {
 } EnterTimeState;
 
 /**
- * @brief Actual variable holding EnterTimeState
+ * @brief Layout of the storage needed by the deepest supported state stack
  *
- * @see EnterTimeState
- * @see EnterTimeState_enter()
- * @see EnterTimeState_handleUserCommand()
- * @see UserState_prohibitLeave()
+ * Only the states currently on the stack (g_stateStack) need their data, so
+ * instead of a separate variable for each of the states, all of them share a
+ * single arena (g_stateStorage). Each state gets its share of the arena when
+ * entered, directly on top of the storage of the states below it, and hands it
+ * back when it is left again (see UserState_allocate()).
+ *
+ * This type is never instantiated. It only describes the deepest stack that is
+ * supported and thereby defines the size of the arena: A base state, the
+ * "pulse" mode, one of the modal states, one of the "set time" modes and the
+ * "enter time" mode as substate of the latter.
+ *
+ * @see g_stateStorage
+ * @see UserState_allocate()
  */
-static EnterTimeState mode_enterTimeState;
+typedef struct {
 
-static void UserState_init();
+    #if (ENABLE_RGB_SUPPORT == 1)
 
-static bool UserState_prohibitLeave(menu_state_t state);
+        union {
 
-static bool UserState_prohibitTimeDisplay(menu_state_t state);
+            NormalState normal;
+            AutoHueState autoHue;
+
+        } base;
+
+    #endif
+
+    PulseState pulse;
+
+    union {
+
+        #if (ENABLE_IR_SUPPORT == 1)
+
+            TrainIrState trainIr;
+
+        #endif /* (ENABLE_IR_SUPPORT == 1) */
+
+        DemoState demo;
 
-static void UserState_Isr1000Hz(menu_state_t state);
+    } modal;
 
-static void UserState_Isr100Hz(menu_state_t state);
+    union {
 
-static void UserState_Isr10Hz(menu_state_t state);
+        SetSystemTimeState setSystemTime;
+        SetOnOffTimeState setOnOffTime;
+
+    } setTime;
+
+    EnterTimeState enterTime;
+
+} UserStateStorageLayout;
+
+/**
+ * @brief Arena holding the data of all states currently on the stack
+ *
+ * The data of a state can be accessed by means of UserState_storage().
+ *
+ * @see UserStateStorageLayout
+ * @see UserState_storage()
+ */
+static uint8_t g_stateStorage[sizeof(UserStateStorageLayout)];
+
+static void* UserState_storage(menu_state_t state);
+
+static bool UserState_allocate(menu_state_t state);
+
+static void UserState_init();
+
+static bool UserState_prohibitLeave(menu_state_t state);
+
+static bool UserState_prohibitTimeDisplay(menu_state_t state);
 
 static void UserState_Isr1Hz(menu_state_t state);
 
@@ -498,6 +404,8 @@ static void UserState_SubstateFinished(menu_state_t state, menu_state_t finished
 
 static void UserState_enter(menu_state_t state, const void* param);
 
+#if (ENABLE_IR_SUPPORT == 1)
+
 #if (LOG_USER_IR_TRAIN == 1)
 
     /**
@@ -531,20 +439,26 @@ static void UserState_enter(menu_state_t state, const void* param);
  * (menu_state_t::MS_irTrain) mode is entered. It retrieves the indicator mask
  * for the display and applies it in a way that it will be blinking.
  *
+ * With ENABLE_FAST_BOOT enabled the display is left untouched, so the time
+ * can be shown while waiting for the first IR command.
+ *
  * @param param Void parameter for consistency reasons only
  *
+ * @see ENABLE_FAST_BOOT
  * @see display_getIndicatorMask()
  * @see display_setDisplayState()
  */
 static void TrainIrState_enter(const void* param)
 {
 
-    display_state_t disp;
-
     log_state("enter train\n");
 
-    disp = display_getIndicatorMask();
-    display_setDisplayState(disp, disp);
+    #if (ENABLE_FAST_BOOT == 0)
+
+        display_state_t disp = display_getIndicatorMask();
+        display_setDisplayState(disp, disp);
+
+    #endif /* (ENABLE_FAST_BOOT == 0) */
 
 }
 
@@ -563,11 +477,13 @@ static void TrainIrState_enter(const void* param)
 static void TrainIrState_1Hz()
 {
 
-    if (mode_trainIrState.seconds != UINT8_MAX) {
+    TrainIrState* trainIrState = UserState_storage(MS_irTrain);
+
+    if (trainIrState->seconds != UINT8_MAX) {
 
-        ++mode_trainIrState.seconds;
+        ++trainIrState->seconds;
 
-        if (mode_trainIrState.seconds == USER_STARTUP_WAIT_IR_TRAIN_S) {
+        if (trainIrState->seconds == USER_STARTUP_WAIT_IR_TRAIN_S) {
 
             log_irTrain("leave IR-wait4train\n");
 
@@ -594,10 +510,10 @@ static void TrainIrState_1Hz()
  *
  * @param i_irCode The decoded IRMP data that was received
  *
- * @see mode_trainIrState
  * @see TrainIrState::curKey
  * @see user_prefs_t::irAddress
  * @see user_prefs_t::irCommandCodes
+ * @see buildIrCommandIndex()
  * @see preferences_save()
  * @see quitMyself()
  * @see display_getNumberDisplayState()
@@ -606,9 +522,11 @@ static void TrainIrState_1Hz()
 static void TrainIrState_handleIR(const IRMP_DATA* i_irCode)
 {
 
+    TrainIrState* trainIrState = UserState_storage(MS_irTrain);
+
     display_state_t disp;
 
-    if (mode_trainIrState.curKey > 0) {
+    if (trainIrState->curKey > 0) {
 
         if (g_params->irAddress != i_irCode->address) {
 
@@ -616,27 +534,28 @@ static void TrainIrState_handleIR(const IRMP_DATA* i_irCode)
 
         } else {
 
-            g_params->irCommandCodes[mode_trainIrState.curKey - 1] = i_irCode->command;
+            g_params->irCommandCodes[trainIrState->curKey - 1] = i_irCode->command;
 
-            if (mode_trainIrState.curKey == UC_COMMAND_COUNT) {
+            if (trainIrState->curKey == UC_COMMAND_COUNT) {
 
                 log_irTrain("Ir train finished\n");
 
+                buildIrCommandIndex();
                 preferences_save();
 
                 quitMyself(MS_irTrain, NULL);
 
             }
 
-            ++mode_trainIrState.curKey;
+            ++trainIrState->curKey;
 
         }
 
     } else {
 
-        mode_trainIrState.seconds = UINT8_MAX;
+        trainIrState->seconds = UINT8_MAX;
         g_params->irAddress = i_irCode->address;
-        ++mode_trainIrState.curKey;
+        ++trainIrState->curKey;
 
     }
 
@@ -644,10 +563,10 @@ static void TrainIrState_handleIR(const IRMP_DATA* i_irCode)
 
     {
 
-        char buff[5];
+        char buff[FORMAT_DEC_MAX_LENGTH];
 
         uart_puts_P("Ir train. Enter cmd #");
-        sprintf_P(buff, fmt_output_unsigned_decimal, mode_trainIrState.curKey);
+        format_dec(buff, trainIrState->curKey);
         uart_puts(buff);
         uart_putc('\n');
 
@@ -655,34 +574,27 @@ static void TrainIrState_handleIR(const IRMP_DATA* i_irCode)
 
     #endif
 
-    disp = display_getNumberDisplayState(mode_trainIrState.curKey);
+    disp = display_getNumberDisplayState(trainIrState->curKey);
     disp |= display_getIndicatorMask();
     display_setDisplayState(disp, disp);
 
 }
 
+#endif /* (ENABLE_IR_SUPPORT == 1) */
+
 /**
- * @brief ISR for the "show number" mode executed with a frequency of 10 Hz
+ * @brief Quits the "show number" mode once the number has been shown long enough
  *
- * This "ISR" gets executed with a frequency of 10 Hz whenever the
- * "show number" (menu_state_t::MS_showNumber) mode is currently active. It
- * check whether enough time has passed to quit itself and does so if
- * necessary.
+ * This is executed from within the main loop once TIMER_USER_SHOW_NUMBER,
+ * which has been started by ShowNumberState_enter(), has expired.
  *
- * @see ShowNumberState::delay100ms
- * @see mode_showNumberState
+ * @see TIMER_USER_SHOW_NUMBER
  * @see quitMyself()
  */
-static void ShowNumberState_10Hz()
+static void ShowNumberState_expired()
 {
 
-    --mode_showNumberState.delay100ms;
-
-    if (mode_showNumberState.delay100ms == 0) {
-
-        quitMyself(MS_showNumber, NULL);
-
-    }
+    quitMyself(MS_showNumber, NULL);
 
 }
 
@@ -690,16 +602,15 @@ static void ShowNumberState_10Hz()
  * @brief Routine executed when entering the "show number" mode
  *
  * This routine gets executed whenever the "show number"
- * (menu_state_t::MS_showNumber) mode is entered. It sets up the counter
- * (mode_showNumberState.delay100ms) with the value defined in
+ * (menu_state_t::MS_showNumber) mode is entered. It starts
+ * TIMER_USER_SHOW_NUMBER with the value defined in
  * USER_NORMAL_SHOW_NUMBER_DELAY_100MS, gets the display state for the given
  * number and applies it to the display. The parameter itself is a pointer to
  * a value interpreted as uint8_t.
  *
  * @param param Pointer to number to be shown (uint8_t)
  *
- * @see ShowNumberState::delay100ms
- * @see mode_showNumberState
+ * @see ShowNumberState_expired()
  * @see display_getNumberDisplayState()
  * @see display_setDisplayState()
  */
@@ -710,7 +621,8 @@ static void ShowNumberState_enter(const void* param)
 
     log_state("enter showNumber\n");
 
-    mode_showNumberState.delay100ms = USER_NORMAL_SHOW_NUMBER_DELAY_100MS;
+    timer_start(TIMER_USER_SHOW_NUMBER, TIMER_100MS | TIMER_DEFERRED,
+        USER_NORMAL_SHOW_NUMBER_DELAY_100MS, ShowNumberState_expired);
 
     /*
      * Double cast to prevent warning
@@ -720,6 +632,21 @@ static void ShowNumberState_enter(const void* param)
 
 }
 
+/**
+ * @brief Routine executed when leaving the "show number" mode
+ *
+ * This makes sure TIMER_USER_SHOW_NUMBER is stopped in case the mode is left
+ * before it has expired.
+ *
+ * @see TIMER_USER_SHOW_NUMBER
+ */
+static void ShowNumberState_leave()
+{
+
+    timer_stop(TIMER_USER_SHOW_NUMBER);
+
+}
+
 /**
  * @brief Routine executed when entering the "normal" mode
  *
@@ -734,7 +661,7 @@ static void ShowNumberState_enter(const void* param)
  * @param param Pointer to number of the color profile to work on
  *
  * @see ENABLE_RGB_SUPPORT
- * @see pwm_set_color()
+ * @see pwm_fade_color()
  * @see user_prefs_t::curColorProfile
  * @see user_prefs_t::colorPresets
  * @see addSubState()
@@ -748,7 +675,8 @@ static void NormalState_enter(const void* param)
 
     #if (ENABLE_RGB_SUPPORT == 1)
 
-        pwm_set_color(g_params->colorPresets[g_params->curColorProfile]);
+        pwm_fade_color(g_params->colorPresets[g_params->curColorProfile],
+            PWM_COLOR_FADE_STEPS);
 
         if (((uint16_t)param) != 0) {
 
@@ -779,7 +707,6 @@ static void NormalState_enter(const void* param)
  *
  * @param command The received user command
  *
- * @see mode_normalState
  * @see NormalState::propertyToSet
  * @see user_command_t::UC_NORMAL_MODE
  * @see user_command_t::UC_CHANGE_R
@@ -795,6 +722,8 @@ static bool NormalState_handleUserCommand(user_command_t command)
 
     #if (ENABLE_RGB_SUPPORT == 1)
 
+        NormalState* normalState = UserState_storage(MS_normalMode);
+
         if (UC_NORMAL_MODE == command) {
 
             ++(g_params->curColorProfile);
@@ -805,25 +734,29 @@ static bool NormalState_handleUserCommand(user_command_t command)
 
             log_state("CR\n");
 
-            mode_normalState.propertyToSet = NS_propColorR;
+            normalState->propertyToSet = NS_propColorR;
 
         } else if (UC_CHANGE_G == command) {
 
             log_state("CG\n");
 
-            mode_normalState.propertyToSet = NS_propColorG;
+            normalState->propertyToSet = NS_propColorG;
 
         } else if (UC_CHANGE_B == command) {
 
             log_state("CB\n");
 
-            mode_normalState.propertyToSet = NS_propColorB;
+            normalState->propertyToSet = NS_propColorB;
 
         } else if (UC_CHANGE_HUE == command) {
 
             log_state("CH\n");
 
-            mode_normalState.propertyToSet = NS_propHue;
+            color_hsv_t hsv;
+
+            color_rgb2hsv(pwm_get_color(), &hsv);
+            normalState->curHue = hsv.hue;
+            normalState->propertyToSet = NS_propHue;
 
         } else if (UC_UP == command || UC_DOWN == command) {
 
@@ -831,25 +764,25 @@ static bool NormalState_handleUserCommand(user_command_t command)
 
             log_state("CC\n");
 
-            if (mode_normalState.propertyToSet == NS_propHue) {
+            if (normalState->propertyToSet == NS_propHue) {
 
-                if (dir < 0 && mode_normalState.curHue < USER_HUE_CHANGE_MANUAL_STEPS) {
+                if (dir < 0 && normalState->curHue < USER_HUE_CHANGE_MANUAL_STEPS) {
 
-                    mode_normalState.curHue = COLOR_HUE_MAX;
+                    normalState->curHue = COLOR_HUE_MAX;
 
-                } else if (dir > 0 && mode_normalState.curHue >= COLOR_HUE_MAX - USER_HUE_CHANGE_MANUAL_STEPS) {
+                } else if (dir > 0 && normalState->curHue >= COLOR_HUE_MAX - USER_HUE_CHANGE_MANUAL_STEPS) {
 
-                    mode_normalState.curHue = 0;
+                    normalState->curHue = 0;
 
                 } else {
 
-                    mode_normalState.curHue += dir * USER_HUE_CHANGE_MANUAL_STEPS;
+                    normalState->curHue += dir * USER_HUE_CHANGE_MANUAL_STEPS;
 
                 }
 
                 color_rgb_t color;
 
-                color_hue2rgb(mode_normalState.curHue, &color);
+                color_hue2rgb(normalState->curHue, &color);
                 pwm_set_color(color);
 
             } else {
@@ -858,7 +791,7 @@ static bool NormalState_handleUserCommand(user_command_t command)
 
                 color_rgb_t* color = &(g_params->colorPresets[g_params->curColorProfile]);
 
-                switch (mode_normalState.propertyToSet) {
+                switch (normalState->propertyToSet) {
 
                     case NS_propColorR:
 
@@ -907,36 +840,63 @@ static bool NormalState_handleUserCommand(user_command_t command)
 #if (ENABLE_RGB_SUPPORT == 1)
 
     /**
-     * @brief ISR for the "hue fading" mode executed with a frequency of 10 Hz
+     * @brief Starts the timer for the next step of the "hue fading" mode
      *
-     * This "ISR" gets executed with a frequency of 10 Hz whenever the
-     * "hue fading" (menu_state_t::MS_hueMode) mode is currently active. It
-     * checks the appropriate time interval set by the user
-     * (user_prefs_t::hueChangeInterval) has passed and updates the hue
-     * if necessary.
+     * The interval is taken from user_prefs_t::hueChangeInterval each time,
+     * so changes made by the user are taken into account with the next step.
      *
-     * @see AutoHueState::delay100ms
-     * @see mode_autoHueState
+     * @see TIMER_USER_HUE
+     * @see AutoHueState_step()
+     */
+    static void AutoHueState_step();
+
+    static void AutoHueState_startTimer()
+    {
+
+        timer_start(TIMER_USER_HUE, TIMER_100MS | TIMER_DEFERRED,
+            g_params->hueChangeInterval + 1, AutoHueState_step);
+
+    }
+
+    /**
+     * @brief Performs a single step of the "hue fading" mode
+     *
+     * This is executed from within the main loop whenever TIMER_USER_HUE has
+     * expired, i.e. once the time interval set by the user
+     * (user_prefs_t::hueChangeInterval) has passed. It updates the hue and
+     * starts the timer for the next step. The color is faded over the
+     * interval, so entering the mode doesn't jump away from the previous
+     * color.
+     *
+     * @see AutoHueState_startTimer()
      * @see user_prefs_t::hueChangeInterval
      * @see color_hue2rgb()
-     * @see pwm_set_color()
+     * @see pwm_fade_color()
      */
-    static void AutoHueState_10Hz()
+    static void AutoHueState_step()
     {
 
-        mode_autoHueState.delay100ms++;
+        AutoHueState* autoHueState = UserState_storage(MS_hueMode);
+
+        color_rgb_t color;
+
+        ++autoHueState->curHue;
+        autoHueState->curHue %= (COLOR_HUE_MAX + 1);
+        color_hue2rgb(autoHueState->curHue, &color);
+
+        #if (PWM_COLOR_FADE == 1)
 
-        if (mode_autoHueState.delay100ms > (volatile uint8_t)(g_params->hueChangeInterval)) {
+            // Spread the change over the interval (10 fade steps per 100 ms)
+            uint16_t steps = (g_params->hueChangeInterval + 1) * 10;
+            pwm_fade_color(color, steps > UINT8_MAX ? UINT8_MAX : steps);
 
-            color_rgb_t color;
+        #else
 
-            ++mode_autoHueState.curHue;
-            mode_autoHueState.curHue %= (COLOR_HUE_MAX + 1);
-            color_hue2rgb(mode_autoHueState.curHue, &color);
             pwm_set_color(color);
-            mode_autoHueState.delay100ms = 0;
 
-        }
+        #endif /* (PWM_COLOR_FADE == 1) */
+
+        AutoHueState_startTimer();
 
     }
 
@@ -944,18 +904,29 @@ static bool NormalState_handleUserCommand(user_command_t command)
      * @brief Routine executed when entering the "hue fading" mode
      *
      * This routine gets executed whenever the "hue fading"
-     * (menu_state_t::MS_hueMode) mode is entered. It simply resets the
-     * appropriate counter responsible for the hue fading interval.
+     * (menu_state_t::MS_hueMode) mode is entered. It simply starts the timer
+     * responsible for the hue fading interval.
      *
      * @param param Void parameter for consistency reasons only
      *
-     * @see AutoHueState::delay100ms
-     * @see mode_autoHueState
+     * @see AutoHueState_startTimer()
      */
     static void AutoHueState_enter(const void* param)
     {
 
-        mode_autoHueState.delay100ms = 0;
+        AutoHueState_startTimer();
+
+    }
+
+    /**
+     * @brief Routine executed when leaving the "hue fading" mode
+     *
+     * @see TIMER_USER_HUE
+     */
+    static void AutoHueState_leave()
+    {
+
+        timer_stop(TIMER_USER_HUE);
 
     }
 
@@ -1005,76 +976,56 @@ static bool NormalState_handleUserCommand(user_command_t command)
 #endif
 
 /**
- * @brief ISR for the "demo" mode executed with a frequency of 1 kHz
+ * @brief Performs a single step of the "demo" mode
  *
- * This "ISR" gets executed with a frequency of 1 kHz whenever the "demo"
- * (menu_state_t::MS_demo) mode is currently active. It is only needed
- * when the "fast" mode (DemoState::fastMode) is being used. Otherwise it will
- * return immediately. In "fast" mode it sets the brightness to its maximum,
- * and then multiplexes the output so each word appears to be enabled at once.
+ * This is executed from within the main loop whenever TIMER_USER_DEMO has
+ * expired, i.e. every USER_DEMO_CHANGE_INT_100MS, and turns on the next LED
+ * group. The timer is stopped while the "fast" mode (DemoState::fastMode) is
+ * being used.
  *
- * @see mode_demoState
- * @see DemoState::fastMode
+ * @see TIMER_USER_DEMO
+ * @see USER_DEMO_CHANGE_INT_100MS
  * @see DemoState::demoStep
- * @see pwm_lock_brightness_val()
  */
-static void DemoState_1000Hz()
+static void DemoState_step()
 {
 
-    display_state_t disp;
+    DemoState* demoState = UserState_storage(MS_demoMode);
 
-    if (!mode_demoState.fastMode) {
-
-        return;
-
-    }
+    display_state_t disp;
 
-    pwm_lock_brightness_val(255);
-    disp = (display_state_t)0x01010101 << mode_demoState.demoStep;
+    disp = (display_state_t)1 << demoState->demoStep;
     display_setDisplayState(disp, 0);
-    ++mode_demoState.demoStep;
-    mode_demoState.demoStep %= 8;
+    ++demoState->demoStep;
+    demoState->demoStep %= 32;
 
 }
 
 /**
- * @brief ISR for the "demo" mode executed with a frequency of 10 Hz
+ * @brief Starts the timer for the steps of the "demo" mode
  *
- * This "ISR" gets executed with a frequency of 10 Hz whenever the "demo"
- * (menu_state_t::MS_demo) mode is currently active. It is only needed
- * when the "normal" mode (DemoState::fastMode) is being used. Otherwise it
- * will return immediately. In "normal" mode it checks whether the appropriate
- * time interval has passed (USER_DEMO_CHANGE_INT_100MS) and turns on the next
- * LED group if necessary.
- *
- * @see mode_demoState
- * @see DemoState::fastMode
- * @see DemoState::delay100ms
- * @see USER_DEMO_CHANGE_INT_100MS
- * @see DemoState::demoStep
+ * @see TIMER_USER_DEMO
+ * @see DemoState_step()
  */
-static void DemoState_10Hz()
+static void DemoState_startTimer()
 {
 
-    display_state_t disp;
-
-    if (mode_demoState.fastMode) {
-
-        return;
-
-    }
+    timer_start(TIMER_USER_DEMO, TIMER_100MS | TIMER_PERIODIC | TIMER_DEFERRED,
+        USER_DEMO_CHANGE_INT_100MS, DemoState_step);
 
-    ++mode_demoState.delay100ms;
-
-    if (mode_demoState.delay100ms >= USER_DEMO_CHANGE_INT_100MS) {
+}
 
-        disp = (display_state_t)1 << mode_demoState.demoStep;
-        display_setDisplayState(disp, 0);
-        ++mode_demoState.demoStep;
-        mode_demoState.demoStep %= 32;
-        mode_demoState.delay100ms = 0;
+/**
+ * @brief Routine executed when entering the "demo" mode
+ *
+ * @param param Void parameter for consistency reasons only
+ *
+ * @see DemoState_startTimer()
+ */
+static void DemoState_enter(const void* param)
+{
 
-    }
+    DemoState_startTimer();
 
 }
 
@@ -1086,21 +1037,54 @@ static void DemoState_10Hz()
  * user command was received and toggles between the "fast" and/or "normal"
  * mode.
  *
+ * The "fast" mode sets the brightness to its maximum and hands over eight
+ * sub-frames to the scan-out of the display module. Within each sub-frame a
+ * different output of each LED driver is enabled. This is responsible for
+ * the multiplexing, which makes all LEDs appear to be enabled. When switching
+ * back to the "normal" mode, the brightness is released and the animation
+ * continues with the next step right away.
+ *
  * @param command The received user command
  *
  * @see user_command_t::UC_UP
  * @see user_command_t::UC_DOWN
- * @see mode_demoState
  * @see DemoState::fastMode
+ * @see display_setScanFrames()
+ * @see pwm_lock_brightness_val()
  */
 static bool DemoState_handleUserCommand(user_command_t command)
 {
 
+    DemoState* demoState = UserState_storage(MS_demoMode);
+
     if (UC_UP == command || UC_DOWN == command) {
 
         log_state("DMF\n");
 
-        mode_demoState.fastMode = !mode_demoState.fastMode;
+        demoState->fastMode = !demoState->fastMode;
+
+        if (demoState->fastMode) {
+
+            display_state_t frames[8];
+
+            timer_stop(TIMER_USER_DEMO);
+
+            for (uint8_t i = 0; i < 8; i++) {
+
+                frames[i] = (display_state_t)0x01010101 << i;
+
+            }
+
+            pwm_lock_brightness_val(255);
+            display_setScanFrames(frames, 8);
+
+        } else {
+
+            pwm_release_brightness();
+            DemoState_step();
+            DemoState_startTimer();
+
+        }
 
     } else {
 
@@ -1117,14 +1101,25 @@ static bool DemoState_handleUserCommand(user_command_t command)
  *
  * This routine gets executed whenever the "demo" (menu_state_t::MS_demo) mode
  * is left. It will make sure the brightness lock for the PWM module is
- * released, which was acquired by the appropriate ISR.
+ * released, which was acquired when entering the "fast" mode. The scan-out
+ * of the "fast" mode and TIMER_USER_DEMO are stopped, too.
  *
  * @see pwm_release_brightness()
- * @see DemoState_1000Hz()
+ * @see DemoState_handleUserCommand()
  */
 static void DemoState_leave()
 {
 
+    DemoState* demoState = UserState_storage(MS_demoMode);
+
+    timer_stop(TIMER_USER_DEMO);
+
+    if (demoState->fastMode) {
+
+        display_setDisplayState(0, 0);
+
+    }
+
     pwm_release_brightness();
 
 }
@@ -1142,7 +1137,6 @@ static void DemoState_leave()
  *
  * @param param Pointer to buffer for time manipulation
  *
- * @see mode_enterTimeState
  * @see EnterTimeState
  * @see USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
  * @see pwm_lock_brightness_val()
@@ -1153,16 +1147,18 @@ static void DemoState_leave()
 static void EnterTimeState_enter(const void* param)
 {
 
+    EnterTimeState* enterTimeState = UserState_storage(MS_enterTime);
+
     display_state_t disp;
 
     log_time("TH\n");
 
-    mode_enterTimeState.time = *((datetime_t*)param);
-    mode_enterTimeState.curSubState = ETS_hour;
-    mode_enterTimeState.prohibitLeave = true;
+    enterTimeState->time = *((datetime_t*)param);
+    enterTimeState->curSubState = ETS_hour;
+    enterTimeState->prohibitLeave = true;
 
-    if (mode_enterTimeState.time.hh >= USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
-        && mode_enterTimeState.time.hh < USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR + 12) {
+    if (enterTimeState->time.hh >= USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
+        && enterTimeState->time.hh < USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR + 12) {
 
         pwm_lock_brightness_val(USER_ENTERTIME_DAY_BRIGHTNESS);
 
@@ -1174,7 +1170,7 @@ static void EnterTimeState_enter(const void* param)
 
     disp = display_getHoursMask();
     disp |= display_getTimeSetIndicatorMask();
-    dispInternalTime(&mode_enterTimeState.time, disp);
+    dispInternalTime(&enterTimeState->time, disp);
 
 }
 
@@ -1202,7 +1198,6 @@ static void EnterTimeState_enter(const void* param)
  *
  * @see user_command_t::UC_SET_TIME
  * @see user_command_t::UC_SET_ONOFF_TIMES
- * @see mode_enterTimeState
  * @see USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
  * @see pwm_lock_brightness_val()
  * @see pwm_release_brightness()
@@ -1216,25 +1211,27 @@ static void EnterTimeState_enter(const void* param)
 static bool EnterTimeState_handleUserCommand(user_command_t command)
 {
 
+    EnterTimeState* enterTimeState = UserState_storage(MS_enterTime);
+
     uint8_t caller = g_stateStack[g_currentIdxs[MS_enterTime] - 1];
 
     if (((MS_setSystemTime == caller) && (UC_SET_TIME == command))
         || ((MS_setOnOffTime == caller) && (UC_SET_ONOFF_TIMES == command))) {
 
-        if (ETS_hour == mode_enterTimeState.curSubState) {
+        if (ETS_hour == enterTimeState->curSubState) {
 
             log_time("TM\n");
 
-            mode_enterTimeState.curSubState = ETS_minutes;
+            enterTimeState->curSubState = ETS_minutes;
 
-        } else if (ETS_minutes == mode_enterTimeState.curSubState) {
+        } else if (ETS_minutes == enterTimeState->curSubState) {
 
             log_time("TS\n");
 
-            mode_enterTimeState.time.ss = 0;
-            mode_enterTimeState.prohibitLeave = false;
+            enterTimeState->time.ss = 0;
+            enterTimeState->prohibitLeave = false;
             pwm_release_brightness();
-            quitMyself(MS_enterTime, &(mode_enterTimeState.time));
+            quitMyself(MS_enterTime, &(enterTimeState->time));
 
             return true;
 
@@ -1246,12 +1243,12 @@ static bool EnterTimeState_handleUserCommand(user_command_t command)
 
         log_state("CHS\n");
 
-        if (ETS_hour == mode_enterTimeState.curSubState) {
+        if (ETS_hour == enterTimeState->curSubState) {
 
-            incDecRangeOverflow(&(mode_enterTimeState.time.hh), dir, 23);
+            incDecRangeOverflow(&(enterTimeState->time.hh), dir, 23);
 
-            if (mode_enterTimeState.time.hh >= USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
-                && mode_enterTimeState.time.hh < USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR + 12) {
+            if (enterTimeState->time.hh >= USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR
+                && enterTimeState->time.hh < USER_ENTERTIME_DAY_NIGHT_CHANGE_HOUR + 12) {
 
                 pwm_lock_brightness_val(USER_ENTERTIME_DAY_BRIGHTNESS);
 
@@ -1261,7 +1258,7 @@ static bool EnterTimeState_handleUserCommand(user_command_t command)
 
             }
 
-        } else if (ETS_minutes == mode_enterTimeState.curSubState) {
+        } else if (ETS_minutes == enterTimeState->curSubState) {
 
             if (MS_setOnOffTime == caller) {
 
@@ -1269,14 +1266,14 @@ static bool EnterTimeState_handleUserCommand(user_command_t command)
 
             }
 
-            incDecRangeOverflow(&(mode_enterTimeState.time.mm), dir, 59);
+            incDecRangeOverflow(&(enterTimeState->time.mm), dir, 59);
 
         }
 
     }
 
-    dispInternalTime(&mode_enterTimeState.time,
-        ((ETS_hour == mode_enterTimeState.curSubState)
+    dispInternalTime(&enterTimeState->time,
+        ((ETS_hour == enterTimeState->curSubState)
         ? display_getHoursMask()
         : display_getMinuteMask()) | display_getTimeSetIndicatorMask());
 
@@ -1294,7 +1291,6 @@ static bool EnterTimeState_handleUserCommand(user_command_t command)
  *
  * @param param Void parameter for consistency reasons only
  *
- * @see mode_setSystemTimeState
  * @see SetSystemTimeState
  * @see addSubState()
  * @see menu_state_t::MS_enterTime
@@ -1303,10 +1299,12 @@ static bool EnterTimeState_handleUserCommand(user_command_t command)
 static void SetSystemTimeState_enter(const void* param)
 {
 
+    SetSystemTimeState* setSystemTimeState = UserState_storage(MS_setSystemTime);
+
     log_state("SST\n");
 
     addSubState(MS_setSystemTime, MS_enterTime, datetime_get());
-    mode_setSystemTimeState.prohibitLeave = true;
+    setSystemTimeState->prohibitLeave = true;
 
 }
 
@@ -1323,7 +1321,6 @@ static void SetSystemTimeState_enter(const void* param)
  * @param result Pointer to the result of the substate (set time)
  *
  * @see SetSystemTimeState_enter()
- * @see mode_setSystemTimeState
  * @see SetSystemTimeState
  * @see datetime_t
  * @see datetime_set()
@@ -1332,12 +1329,14 @@ static void SetSystemTimeState_enter(const void* param)
 static void SetSystemTimeState_substateFinished(menu_state_t finishedState, const void* result)
 {
 
+    SetSystemTimeState* setSystemTimeState = UserState_storage(MS_setSystemTime);
+
     if (finishedState == MS_enterTime) {
 
         datetime_t* time = (datetime_t*)result;
 
         datetime_set(time);
-        mode_setSystemTimeState.prohibitLeave = false;
+        setSystemTimeState->prohibitLeave = false;
         quitMyself(MS_setSystemTime, NULL);
 
     }
@@ -1356,7 +1355,6 @@ static void SetSystemTimeState_substateFinished(menu_state_t finishedState, cons
  *
  * @param param Void parameter for consistency reasons only
  *
- * @see mode_setOnOffTimeState
  * @see SetOnOffTimeState
  * @see UserEepromParam::onOffTimes
  * @see menu_state_t::MS_enterTime
@@ -1365,17 +1363,19 @@ static void SetSystemTimeState_substateFinished(menu_state_t finishedState, cons
 static void SetOnOffTimeState_enter(const void* param)
 {
 
+    SetOnOffTimeState* setOnOffTimeState = UserState_storage(MS_setOnOffTime);
+
     datetime_t dt = {0, 0, 0, 0, 0, 0, 0};
     dt.hh = g_params->onOffTimes[0].h;
     dt.mm = g_params->onOffTimes[0].m;
 
     log_state("SOOT\n");
 
-    mode_setOnOffTimeState.currentTimeToSet = 0;
+    setOnOffTimeState->currentTimeToSet = 0;
 
     addSubState(MS_setOnOffTime, MS_enterTime, &dt);
 
-    mode_setOnOffTimeState.prohibitLeave = true;
+    setOnOffTimeState->prohibitLeave = true;
 
 }
 
@@ -1393,26 +1393,29 @@ static void SetOnOffTimeState_enter(const void* param)
  * @param result Pointer to the result of the substate (set time)
  *
  * @see SetOnOffTimeState_enter()
- * @see mode_setOnOffTimeState
  * @see SetOnOffTimeState
  * @see user_prefs_t::onOffTimes
  * @see user_prefs_t::useAutoOffAnimation
  * @see UI_ONOFFTIMES_COUNT
+ * @see user_on_off_times_changed()
  * @see addSubState()
  */
 static void SetOnOffTimeState_substateFinished(menu_state_t finishedState, const void* result)
 {
 
+    SetOnOffTimeState* setOnOffTimeState = UserState_storage(MS_setOnOffTime);
+
     if (finishedState == MS_enterTime) {
 
         const datetime_t* time = result;
         datetime_t dt = *time;
-        g_params->onOffTimes[mode_setOnOffTimeState.currentTimeToSet].h = dt.hh;
-        g_params->onOffTimes[mode_setOnOffTimeState.currentTimeToSet].m = dt.mm;
+        g_params->onOffTimes[setOnOffTimeState->currentTimeToSet].h = dt.hh;
+        g_params->onOffTimes[setOnOffTimeState->currentTimeToSet].m = dt.mm;
+        user_on_off_times_changed();
 
-        ++mode_setOnOffTimeState.currentTimeToSet;
+        ++setOnOffTimeState->currentTimeToSet;
 
-        if (UI_ONOFFTIMES_COUNT == mode_setOnOffTimeState.currentTimeToSet) {
+        if (UI_ONOFFTIMES_COUNT == setOnOffTimeState->currentTimeToSet) {
 
             display_state_t disp;
             uint8_t autoOnOff = (uint8_t)g_params->useAutoOffAnimation + 1;
@@ -1422,8 +1425,8 @@ static void SetOnOffTimeState_substateFinished(menu_state_t finishedState, const
 
         } else {
 
-            dt.hh = g_params->onOffTimes[mode_setOnOffTimeState.currentTimeToSet].h;
-            dt.mm = g_params->onOffTimes[mode_setOnOffTimeState.currentTimeToSet].m;
+            dt.hh = g_params->onOffTimes[setOnOffTimeState->currentTimeToSet].h;
+            dt.mm = g_params->onOffTimes[setOnOffTimeState->currentTimeToSet].m;
             addSubState(MS_setOnOffTime, MS_enterTime, &dt);
 
         }
@@ -1446,7 +1449,6 @@ static void SetOnOffTimeState_substateFinished(menu_state_t finishedState, const
  *
  * @param command The received user command
  *
- * @see mode_setOnOffTimeState
  * @see SetOnOffTimeState
  * @see user_prefs_t::useAutoOffAnimation
  * @see user_command_t::UC_DOWN
@@ -1457,7 +1459,9 @@ static void SetOnOffTimeState_substateFinished(menu_state_t finishedState, const
 static bool SetOnOffTimeState_handleUserCommand(user_command_t command)
 {
 
-    if (UI_ONOFFTIMES_COUNT == mode_setOnOffTimeState.currentTimeToSet) {
+    SetOnOffTimeState* setOnOffTimeState = UserState_storage(MS_setOnOffTime);
+
+    if (UI_ONOFFTIMES_COUNT == setOnOffTimeState->currentTimeToSet) {
 
         if ((command == UC_DOWN) || (command == UC_UP)) {
 
@@ -1472,7 +1476,7 @@ static bool SetOnOffTimeState_handleUserCommand(user_command_t command)
 
         if (command == UC_SET_ONOFF_TIMES) {
 
-            mode_setOnOffTimeState.prohibitLeave = false;
+            setOnOffTimeState->prohibitLeave = false;
             g_animPreview = false;
             quitMyself(MS_setOnOffTime, NULL);
 
@@ -1530,51 +1534,61 @@ static bool PulseState_handleUserCommand(user_command_t command)
 }
 
 /**
- * @brief ISR for the "pulse" mode executed with a frequency of 100 Hz
+ * @brief Starts the timer for the next step of the "pulse" mode
  *
- * This "ISR" gets executed with a frequency of 100 Hz whenever the "pulse"
- * (menu_state_t::MS_pulse) mode is currently active. It checks whether enough
- * time has already passed (user_prefs_t::pulseUpdateInterval) for
- * a new brightness to be calculated and applied to the display and does so if
- * necessary.
+ * The interval is taken from user_prefs_t::pulseUpdateInterval each time, so
+ * changes made by the user are taken into account with the next step.
  *
- * @see mode_pulseState
- * @see PulseState::delay10ms
- * @see user_prefs_t::pulseUpdateInterval
- * @see pwm_lock_brightness()
- * @see color_pulse_wafeform
- * @see mode_pulseState.curBrightness
+ * @see TIMER_USER_PULSE
+ * @see PulseState_step()
  */
-static void PulseState_100Hz()
+static void PulseState_step();
+
+static void PulseState_startTimer()
 {
 
-    ++mode_pulseState.delay10ms;
+    timer_start(TIMER_USER_PULSE, TIMER_10MS, g_params->pulseUpdateInterval,
+        PulseState_step);
 
-    if (mode_pulseState.delay10ms >= (volatile uint8_t)(g_params->pulseUpdateInterval)) {
+}
 
-        pwm_lock_brightness_val(color_pulse_waveform(mode_pulseState.curBrightness));
-        ++mode_pulseState.curBrightness;
-        mode_pulseState.delay10ms = 0;
+/**
+ * @brief Performs a single step of the "pulse" mode
+ *
+ * This is executed from within the ISR whenever TIMER_USER_PULSE has
+ * expired, i.e. once the time interval set by the user
+ * (user_prefs_t::pulseUpdateInterval) has passed. It calculates the new
+ * brightness, applies it to the display and starts the timer for the next
+ * step.
+ *
+ * @see PulseState_startTimer()
+ * @see user_prefs_t::pulseUpdateInterval
+ * @see pwm_lock_brightness_val()
+ * @see color_pulse_waveform()
+ */
+static void PulseState_step()
+{
 
-    }
+    PulseState* pulseState = UserState_storage(MS_pulse);
+
+    pwm_lock_brightness_val(color_pulse_waveform(pulseState->curBrightness));
+    ++pulseState->curBrightness;
+
+    PulseState_startTimer();
 
 }
 
 /**
- * @brief ISR for the "pulse" mode executed with a frequency of 10 Hz
+ * @brief Routine executed when entering the "pulse" mode
  *
- * This "ISR" gets executed with a frequency of 10 Hz whenever the "pulse"
- * (menu_state_t::MS_pulse) mode is currently active. It makes sure that the
- * mode underneath the "pulse" mode will get updated, too.
+ * @param param Void parameter for consistency reasons only
  *
- * @see UserState_Isr10Hz
- * @see g_stateStack
- * @see g_currentIdxs
+ * @see PulseState_startTimer()
  */
-static void PulseState_10Hz()
+static void PulseState_enter(const void* param)
 {
 
-    UserState_Isr10Hz(g_stateStack[g_currentIdxs[MS_pulse] - 1]);
+    PulseState_startTimer();
 
 }
 
@@ -1582,289 +1596,441 @@ static void PulseState_10Hz()
  * @brief Routine executed when leaving the "pulse" mode
  *
  * This routine gets executed whenever the "pulse" (menu_state_t::MS_pulse)
- * mode is left. It will make sure the brightness lock for the PWM module is
- * released, which was acquired by the appropriate ISR (PulseState_100Hz()).
+ * mode is left. It stops TIMER_USER_PULSE and makes sure the brightness lock
+ * for the PWM module is released, which was acquired by PulseState_step().
  *
  * @see pwm_release_brightness()
- * @see PulseState_100Hz()
+ * @see PulseState_step()
  */
 static void PulseState_leave()
 {
 
+    timer_stop(TIMER_USER_PULSE);
+
     pwm_release_brightness();
 
 }
 
 /**
- * @brief Initializes all available user states
+ * @brief Type of functions without parameters within user_state_descriptor_t
  *
- * This makes sure that all appropriate *_init() functions are called, which
- * gives each mode a chance to initialize itself. For now no user mode actually
- * requires a separate initialization, so this can be considered a dummy.
+ * This is used for the *_leave() functions and the ISRs of each state.
+ *
+ * @see user_state_descriptor_t
  */
-static void UserState_init()
-{
+typedef void (*user_state_func_t)();
 
-}
+/**
+ * @brief Type of the *_enter() functions within user_state_descriptor_t
+ *
+ * @see user_state_descriptor_t::enter
+ */
+typedef void (*user_state_enter_t)(const void* param);
 
 /**
- * @brief Dispatcher routine for entering a state
+ * @brief Type of the *_handleUserCommand() functions
  *
- * This function makes sure that the correct *_enter() function will be called
- * for the given state along with the provided parameter.
+ * @see user_state_descriptor_t::handleUserCommand
+ */
+typedef bool (*user_state_command_t)(user_command_t command);
+
+/**
+ * @brief Type of the *_substateFinished() functions
  *
- * @param state The state to be entered
- * @param param Parameter that should be passed along to the given state
+ * @see user_state_descriptor_t::substateFinished
  */
-static void UserState_enter(menu_state_t state, const void* param)
-{
+typedef void (*user_state_substate_finished_t)(menu_state_t finishedState, const void* result);
+
+/**
+ * @brief Describes the functions implemented by a single state
+ *
+ * Each state only implements the functions it actually needs, all of the
+ * other entries are NULL. The dispatcher routines (UserState_*()) will then
+ * return right away for these states.
+ *
+ * @see user_states
+ */
+typedef struct {
+
+    /**
+     * @brief Function to be called when the state is entered
+     */
+    user_state_enter_t enter;
+
+    /**
+     * @brief Function to be called when the state is left
+     */
+    user_state_func_t leave;
+
+    /**
+     * @brief Function to be called with a frequency of 1 Hz
+     */
+    user_state_func_t isr1Hz;
+
+    /**
+     * @brief Function to be called in order to handle user commands
+     */
+    user_state_command_t handleUserCommand;
+
+    /**
+     * @brief Function to be called once a substate has finished
+     */
+    user_state_substate_finished_t substateFinished;
+
+    /**
+     * @brief Indicates whether the state prohibits the display of the time
+     *
+     * @see UserState_prohibitTimeDisplay()
+     */
+    bool prohibitTimeDisplay;
+
+    /**
+     * @brief Size of the data needed by the state within g_stateStorage
+     *
+     * @see UserState_allocate()
+     */
+    uint8_t size;
+
+} user_state_descriptor_t;
 
-    if (MS_enterTime == state) {
+/**
+ * @brief Descriptors of all available states
+ *
+ * This table is indexed by menu_state_t and is located within the program
+ * space, so it needs to be accessed by means of pgm_read_word() and/or
+ * pgm_read_byte().
+ *
+ * @see user_state_descriptor_t
+ * @see menu_state_t
+ */
+static const user_state_descriptor_t user_states[MS_COUNT] PROGMEM = {
+
+    #if (ENABLE_IR_SUPPORT == 1)
+
+        [MS_irTrain] = {
+
+            .enter = TrainIrState_enter,
+            .isr1Hz = TrainIrState_1Hz,
+            .prohibitTimeDisplay = true,
+            .size = sizeof(TrainIrState),
 
-        EnterTimeState_enter(param);
+        },
 
-    } else if (MS_normalMode == state) {
+    #endif /* (ENABLE_IR_SUPPORT == 1) */
 
-        NormalState_enter(param);
+    [MS_normalMode] = {
 
-    } else if (MS_setOnOffTime == state) {
+        .enter = NormalState_enter,
+        .handleUserCommand = NormalState_handleUserCommand,
 
-        SetOnOffTimeState_enter(param);
+        #if (ENABLE_RGB_SUPPORT == 1)
 
-    } else if (MS_setSystemTime == state) {
+            .size = sizeof(NormalState),
 
-        SetSystemTimeState_enter(param);
+        #endif
 
-    } else if (MS_showNumber == state) {
+    },
 
-        ShowNumberState_enter(param);
+    [MS_demoMode] = {
 
-    } else if (MS_irTrain == state) {
+        .enter = DemoState_enter,
+        .leave = DemoState_leave,
+        .handleUserCommand = DemoState_handleUserCommand,
+        .prohibitTimeDisplay = true,
+        .size = sizeof(DemoState),
 
-        TrainIrState_enter(param);
+    },
 
     #if (ENABLE_RGB_SUPPORT == 1)
 
-        } else if (MS_hueMode == state) {
+        [MS_hueMode] = {
 
-            AutoHueState_enter(param);
+            .enter = AutoHueState_enter,
+            .leave = AutoHueState_leave,
+            .handleUserCommand = AutoHueState_handleUserCommand,
+            .size = sizeof(AutoHueState),
 
-    #endif
+        },
 
-    }
+    #endif /* (ENABLE_RGB_SUPPORT == 1) */
 
-}
+    [MS_pulse] = {
+
+        .enter = PulseState_enter,
+        .leave = PulseState_leave,
+        .handleUserCommand = PulseState_handleUserCommand,
+        .size = sizeof(PulseState),
+
+    },
+
+    [MS_setSystemTime] = {
+
+        .enter = SetSystemTimeState_enter,
+        .substateFinished = SetSystemTimeState_substateFinished,
+        .prohibitTimeDisplay = true,
+        .size = sizeof(SetSystemTimeState),
+
+    },
+
+    [MS_setOnOffTime] = {
+
+        .enter = SetOnOffTimeState_enter,
+        .handleUserCommand = SetOnOffTimeState_handleUserCommand,
+        .substateFinished = SetOnOffTimeState_substateFinished,
+        .prohibitTimeDisplay = true,
+        .size = sizeof(SetOnOffTimeState),
+
+    },
+
+    [MS_enterTime] = {
+
+        .enter = EnterTimeState_enter,
+        .handleUserCommand = EnterTimeState_handleUserCommand,
+        .prohibitTimeDisplay = true,
+        .size = sizeof(EnterTimeState),
+
+    },
+
+    [MS_showNumber] = {
+
+        .enter = ShowNumberState_enter,
+        .leave = ShowNumberState_leave,
+        .prohibitTimeDisplay = true,
+
+    },
+
+};
 
 /**
- * @brief Dispatcher routine to handle the result of finished substates
+ * @brief Executes the function without parameters found at the given address
  *
- * A couple of states can execute substates, which will return a result once
- * finished. This makes sure that the result is given back to the state that
- * initially called the substate and provides it with the result.
+ * The address is expected to point to an entry of type user_state_func_t
+ * within user_states. If the entry is NULL, nothing is done.
  *
- * @param state The state that initiated the entering of the substate
- * @param finishedState The substate that has finished its job
- * @param result The result from the job performed by the substate
+ * @param entry Address of the function pointer within the program space
+ *
+ * @see user_states
  */
-static void UserState_SubstateFinished(menu_state_t state, menu_state_t finishedState, const void* result)
+static void UserState_call(const user_state_func_t* entry)
 {
 
-    if (MS_setOnOffTime == state) {
-
-        SetOnOffTimeState_substateFinished(finishedState, result);
+    user_state_func_t func = (user_state_func_t)pgm_read_word(entry);
 
-    } else if (MS_setSystemTime == state) {
+    if (func) {
 
-        SetSystemTimeState_substateFinished(finishedState, result);
+        func();
 
     }
 
 }
 
 /**
- * @brief Dispatcher routine for user command handling within a given state
+ * @brief Returns the offset of the data of the given stack position
  *
- * Each user mode may define its own user command handler along with its own
- * logic on how to handle specific user commands. This will dispatch a received
- * user command to the correct user command handler and return a boolean value
- * which indicates whether or not the appropriate handler has actually
- * processed the command.
+ * The data of the states is stacked within g_stateStorage just like the states
+ * themselves are stacked within g_stateStack, so the offset is the sum of the
+ * sizes of all states below the given stack position.
  *
- * @param state The state that should handle the command code
- * @param command The command code that should be handled
+ * @param idx Stack position to get the offset for
  *
- * @return True if event was processed by user command handler, false otherwise
+ * @return Offset of the data within g_stateStorage
  *
- * @see EnterTimeState_handleUserCommand()
- * @see NormalState_handleUserCommand()
- * @see DemoState_handleUserCommand()
- * @see PulseState_handleUserCommand()
- * @see SetOnOffTimeState_handleUserCommand()
- * @see AutoHueState_handleUserCommand()
+ * @see g_stateStorage
+ * @see user_state_descriptor_t::size
  */
-static bool UserState_HandleUserCommand(menu_state_t state, user_command_t command)
+static uint8_t UserState_storageOffset(int8_t idx)
 {
 
-    bool handled = false;
+    uint8_t offset = 0;
+    int8_t i;
 
-    if (MS_enterTime == state) {
+    for (i = 0; i < idx; ++i) {
 
-        handled = EnterTimeState_handleUserCommand(command);
+        offset += pgm_read_byte(&(user_states[g_stateStack[i]].size));
 
-    } else if (MS_normalMode == state) {
+    }
 
-        handled = NormalState_handleUserCommand(command);
+    return offset;
 
-    } else if (MS_demoMode == state) {
+}
 
-        handled = DemoState_handleUserCommand(command);
+/**
+ * @brief Returns a pointer to the data of the given state
+ *
+ * The given state is expected to be on the stack, as states that are not on
+ * the stack have no data assigned.
+ *
+ * @param state The state to get the data for
+ *
+ * @return Pointer to the data of the given state within g_stateStorage
+ *
+ * @see g_stateStorage
+ * @see g_currentIdxs
+ */
+static void* UserState_storage(menu_state_t state)
+{
 
-    } else if (MS_pulse == state) {
+    return &g_stateStorage[UserState_storageOffset(g_currentIdxs[state])];
 
-        handled = PulseState_handleUserCommand(command);
+}
 
-    } else if (MS_setOnOffTime == state) {
+/**
+ * @brief Assigns storage to the given state before it is put onto the stack
+ *
+ * This reserves the amount of memory needed by the given state directly on top
+ * of the data of the states currently on the stack and clears it, so each
+ * state starts with its data set to zero.
+ *
+ * @param state The state that is about to be put onto the stack
+ *
+ * @return True if there was enough space left, false otherwise
+ *
+ * @see g_stateStorage
+ * @see addState()
+ */
+static bool UserState_allocate(menu_state_t state)
+{
 
-        handled = SetOnOffTimeState_handleUserCommand(command);
+    uint8_t offset = UserState_storageOffset(g_topOfStack);
+    uint8_t size = pgm_read_byte(&(user_states[state].size));
 
-    #if (ENABLE_RGB_SUPPORT == 1)
+    if (offset + size > sizeof(g_stateStorage)) {
 
-        } else if (MS_hueMode == state) {
+        return false;
 
-            handled = AutoHueState_handleUserCommand(command);
+    }
 
-    #endif
+    memset(&g_stateStorage[offset], 0, size);
 
-    }
+    return true;
 
-    return handled;
+}
+
+/**
+ * @brief Initializes all available user states
+ *
+ * This makes sure that all appropriate *_init() functions are called, which
+ * gives each mode a chance to initialize itself. For now no user mode actually
+ * requires a separate initialization, so this can be considered a dummy.
+ */
+static void UserState_init()
+{
 
 }
 
 /**
- * @brief Dispatcher routine for leaving a state
+ * @brief Dispatcher routine for entering a state
  *
- * This will call the appropriate *_leave() function for the given state.
+ * This function makes sure that the correct *_enter() function will be called
+ * for the given state along with the provided parameter.
  *
- * @param state The state supposed to be left
+ * @param state The state to be entered
+ * @param param Parameter that should be passed along to the given state
  *
- * @see PulseState_leave()
- * @see DemoState_leave()
+ * @see user_state_descriptor_t::enter
  */
-static void UserState_LeaveState(menu_state_t state)
+static void UserState_enter(menu_state_t state, const void* param)
 {
 
-    if (MS_pulse == state) {
-
-        PulseState_leave();
+    user_state_enter_t enter = (user_state_enter_t)pgm_read_word(&(user_states[state].enter));
 
-    } else if (MS_demoMode == state) {
+    if (enter) {
 
-        DemoState_leave();
+        enter(param);
 
     }
 
 }
 
 /**
- * @brief Dispatcher routine for 1 Hz events
+ * @brief Dispatcher routine to handle the result of finished substates
  *
- * This function is called with a frequency of 1 Hz and will call the correct
- * ISR of the given state.
+ * A couple of states can execute substates, which will return a result once
+ * finished. This makes sure that the result is given back to the state that
+ * initially called the substate and provides it with the result.
  *
- * @param state The state the correct ISR should be called for
+ * @param state The state that initiated the entering of the substate
+ * @param finishedState The substate that has finished its job
+ * @param result The result from the job performed by the substate
  *
- * @see TrainIrState_1Hz()
+ * @see user_state_descriptor_t::substateFinished
  */
-static void UserState_Isr1Hz(menu_state_t state)
+static void UserState_SubstateFinished(menu_state_t state, menu_state_t finishedState, const void* result)
 {
-    if (MS_irTrain == state) {
 
-        TrainIrState_1Hz();
+    user_state_substate_finished_t substateFinished =
+        (user_state_substate_finished_t)pgm_read_word(&(user_states[state].substateFinished));
+
+    if (substateFinished) {
+
+        substateFinished(finishedState, result);
 
     }
 
 }
 
 /**
- * @brief Dispatcher routine for 10 Hz events
+ * @brief Dispatcher routine for user command handling within a given state
  *
- * This function is called with a frequency of 10 Hz and will call the correct
- * ISR of the given state.
+ * Each user mode may define its own user command handler along with its own
+ * logic on how to handle specific user commands. This will dispatch a received
+ * user command to the correct user command handler and return a boolean value
+ * which indicates whether or not the appropriate handler has actually
+ * processed the command.
  *
- * @param state The state the correct ISR should be called for
+ * @param state The state that should handle the command code
+ * @param command The command code that should be handled
  *
- * @see ShowNumberState_10Hz()
- * @see DemoState_10Hz()
- * @see PulseState_10Hz()
- * @see AutoHueState_10Hz()
+ * @return True if event was processed by user command handler, false otherwise
+ *
+ * @see user_state_descriptor_t::handleUserCommand
  */
-static void UserState_Isr10Hz(menu_state_t state)
+static bool UserState_HandleUserCommand(menu_state_t state, user_command_t command)
 {
 
-    if (MS_showNumber == state) {
+    user_state_command_t handleUserCommand =
+        (user_state_command_t)pgm_read_word(&(user_states[state].handleUserCommand));
 
-        ShowNumberState_10Hz();
+    if (handleUserCommand) {
 
-    } else if (MS_demoMode == state) {
-
-        DemoState_10Hz();
-
-    } else if (MS_pulse == state) {
-
-        PulseState_10Hz();
-
-    #if (ENABLE_RGB_SUPPORT == 1)
-
-        } else if (MS_hueMode == state) {
-
-            AutoHueState_10Hz();
-
-    #endif
+        return handleUserCommand(command);
 
     }
 
+    return false;
+
 }
 
 /**
- * @brief Dispatcher routine for 100 Hz events
+ * @brief Dispatcher routine for leaving a state
  *
- * This function is called with a frequency of 100 Hz and will call the correct
- * ISR of the given state.
+ * This will call the appropriate *_leave() function for the given state.
  *
- * @param state The state the correct ISR should be called for
+ * @param state The state supposed to be left
  *
- * @see PulseState_100Hz()
+ * @see user_state_descriptor_t::leave
  */
-static void UserState_Isr100Hz(menu_state_t state)
+static void UserState_LeaveState(menu_state_t state)
 {
 
-    if (MS_pulse == state) {
-
-        PulseState_100Hz();
-
-    }
+    UserState_call(&(user_states[state].leave));
 
 }
 
 /**
- * @brief Dispatcher routine for 1 kHz events
+ * @brief Dispatcher routine for 1 Hz events
  *
- * This function is called with a frequency of 1 kHz and will call the correct
+ * This function is called with a frequency of 1 Hz and will call the correct
  * ISR of the given state.
  *
  * @param state The state the correct ISR should be called for
  *
- * @see DemoState_1000Hz()
+ * @see user_state_descriptor_t::isr1Hz
  */
-static void UserState_Isr1000Hz(menu_state_t state)
+static void UserState_Isr1Hz(menu_state_t state)
 {
 
-    if (MS_demoMode == state) {
-
-        DemoState_1000Hz();
-
-    }
+    UserState_call(&(user_states[state].isr1Hz));
 
 }
 
@@ -1877,14 +2043,31 @@ static void UserState_Isr1000Hz(menu_state_t state)
  *
  * @param state The state the check should be performed for
  *
+ * With ENABLE_FAST_BOOT enabled the "training" mode only prohibits the time
+ * display once the first IR command has been received.
+ *
  * @return True if the given mode prohibits the time display, false otherwise
+ *
+ * @see user_state_descriptor_t::prohibitTimeDisplay
+ * @see ENABLE_FAST_BOOT
  */
 static bool UserState_prohibitTimeDisplay(menu_state_t state)
 {
 
-    return (MS_irTrain == state) || (MS_showNumber == state)
-        || (MS_demoMode == state) || (MS_setSystemTime == state)
-        || (MS_setOnOffTime  == state) || (MS_enterTime == state);
+    #if (ENABLE_FAST_BOOT == 1) && (ENABLE_IR_SUPPORT == 1)
+
+        /*
+         * The time is shown while waiting for the first IR command
+         */
+        if (state == MS_irTrain) {
+
+            return ((TrainIrState*)UserState_storage(MS_irTrain))->curKey > 0;
+
+        }
+
+    #endif /* (ENABLE_FAST_BOOT == 1) && (ENABLE_IR_SUPPORT == 1) */
+
+    return pgm_read_byte(&(user_states[state].prohibitTimeDisplay));
 
 }
 
@@ -1897,6 +2080,9 @@ static bool UserState_prohibitTimeDisplay(menu_state_t state)
  *
  * @param state The state the check should be performed for
  *
+ * The "normal" mode can't be left while the "enter time" mode is on the stack
+ * and prohibits to be left.
+ *
  * @return True if the current mode prohibits to be left, false otherwise
  *
  * @see EnterTimeState
@@ -1910,19 +2096,25 @@ static bool UserState_prohibitLeave(menu_state_t state)
 
     if (MS_normalMode == state) {
 
-        prohibit = mode_enterTimeState.prohibitLeave;
+        int8_t idx = g_currentIdxs[MS_enterTime];
+
+        if (idx < g_topOfStack && MS_enterTime == g_stateStack[idx]) {
+
+            prohibit = ((EnterTimeState*)UserState_storage(MS_enterTime))->prohibitLeave;
+
+        }
 
     }
 
     if (MS_setOnOffTime == state) {
 
-        prohibit = mode_setOnOffTimeState.prohibitLeave;
+        prohibit = ((SetOnOffTimeState*)UserState_storage(state))->prohibitLeave;
 
     }
 
     if (MS_setSystemTime == state) {
 
-        prohibit = mode_setSystemTimeState.prohibitLeave;
+        prohibit = ((SetSystemTimeState*)UserState_storage(state))->prohibitLeave;
 
     }
 
@@ -0,0 +1,470 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench.c
+ * @brief Benchmark runner for hot paths of the firmware built for the host
+ *
+ * This times display_getTimeState(), dcf77_check(), color_hue2rgb() and the
+ * parsing of the UART protocol, and checks their results along the way, so
+ * it fails (with an exit status other than zero) whenever one of them
+ * misbehaves. The timings are those of the host, so they are only meant to
+ * be compared against each other, e.g. before and after a change.
+ *
+ * Furthermore the fade schedule of the display is checked against the gamma
+ * curve it has been calculated with.
+ *
+ * dcf77_check() and display_fade_schedule are static, so dcf77.c and
+ * display.c are included into this file directly, just like usermodes.c is
+ * included into user.c.
+ *
+ * @see Makefile
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "host.h"
+#include "color.h"
+#include "datetime.h"
+#include "display.h"
+#include "preferences.h"
+#include "uart.h"
+#include "uart_protocol.h"
+
+#include "dcf77.c"
+#include "display.c"
+
+/**
+ * @brief Number of times each of the benchmarks is repeated
+ *
+ * Each repetition covers a whole set of inputs, e.g. all minutes of a day.
+ */
+#define BENCH_REPETITIONS 1000
+
+/**
+ * @brief Number of pauses making up a single time frame of DCF77
+ *
+ * @see bench_dcf77_frame()
+ */
+#define BENCH_DCF77_FRAME_LENGTH 59
+
+/**
+ * @brief Number of benchmarks that have failed so far
+ */
+static uint8_t bench_failures;
+
+/**
+ * @brief Sink for results, so the compiler can't optimize the calls away
+ */
+static volatile uint32_t bench_sink;
+
+/**
+ * @brief Lines of the UART protocol being parsed
+ *
+ * These only cover commands, which neither change the state nor access the
+ * hardware, along with some invalid ones.
+ */
+static const char* const bench_protocol_lines[] = {
+
+    "bt\r",
+    "cr\r",
+    "dg\r",
+    "hg\r",
+    "k\r",
+    "lb\r",
+    "pa\r",
+    "pn\r",
+    "pr 01\r",
+    "sg\r",
+    "tg\r",
+    "ug\r",
+    "#2a tg\r",
+    "zz\r",
+    "pr\r",
+    "tg 1 2 3 4 5 6 7 8\r",
+
+};
+
+/**
+ * @brief Number of lines within bench_protocol_lines expected to fail
+ *
+ * These are the last ones, i.e. an unknown command, a missing argument and
+ * too many arguments.
+ *
+ * @see bench_protocol_lines
+ */
+#define BENCH_PROTOCOL_INVALID_LINES 3
+
+/**
+ * @brief Outputs the result of a single benchmark
+ *
+ * @param name Name of the benchmark
+ * @param ns Time spent in nanoseconds
+ * @param calls Number of calls made during this time
+ * @param ok Whether the results have been found to be correct
+ */
+static void bench_report(const char* name, uint64_t ns, uint32_t calls, bool ok)
+{
+
+    printf("%-24s %10.1f ns/call %10u calls  %s\n", name, (double)ns / calls,
+        calls, ok ? "OK" : "FAILED");
+
+    if (!ok) {
+
+        bench_failures++;
+
+    }
+
+}
+
+/**
+ * @brief Benchmarks display_getTimeState() for all minutes of a day
+ *
+ * Apart from "it is" and the words for the minutes, each state needs to
+ * contain as many minute LEDs as the minutes exceed the last multiple of
+ * five.
+ */
+static void bench_display_getTimeState()
+{
+
+    datetime_t dt = {14, 5, 10, 6, 0, 0, 0};
+    uint32_t calls = 0;
+    bool ok = true;
+
+    uint64_t start = host_time_ns();
+
+    for (uint16_t i = 0; i < BENCH_REPETITIONS; i++) {
+
+        for (dt.hh = 0; dt.hh < 24; dt.hh++) {
+
+            for (dt.mm = 0; dt.mm < 60; dt.mm++) {
+
+                display_state_t state = display_getTimeState(&dt);
+                uint8_t leds = (state >> DWP_MIN_LEDS_BEGIN) & 0x0f;
+
+                if (leds != (1 << (dt.mm % 5)) - 1) {
+
+                    ok = false;
+
+                }
+
+                bench_sink += state;
+                calls++;
+
+            }
+
+        }
+
+    }
+
+    bench_report("display_getTimeState()", host_time_ns() - start, calls, ok);
+
+}
+
+/**
+ * @brief Benchmarks color_hue2rgb() for all hues
+ *
+ * Saturation and value are both at their maximum, so one of the channels
+ * needs to be fully on and another one fully off for each hue.
+ */
+static void bench_color_hue2rgb()
+{
+
+    color_rgb_t color;
+    uint32_t calls = 0;
+    bool ok = true;
+
+    uint64_t start = host_time_ns();
+
+    for (uint16_t i = 0; i < BENCH_REPETITIONS; i++) {
+
+        for (color_hue_t h = 0; h <= COLOR_HUE_MAX; h++) {
+
+            color_hue2rgb(h, &color);
+
+            uint8_t max = color.red > color.green ? color.red : color.green;
+            uint8_t min = color.red < color.green ? color.red : color.green;
+
+            max = max > color.blue ? max : color.blue;
+            min = min < color.blue ? min : color.blue;
+
+            if (max != 255 || min != 0) {
+
+                ok = false;
+
+            }
+
+            bench_sink += color.red + color.green + color.blue;
+            calls++;
+
+        }
+
+    }
+
+    bench_report("color_hue2rgb()", host_time_ns() - start, calls, ok);
+
+}
+
+/**
+ * @brief Converts a decimal number into BCD
+ *
+ * @param value Decimal number to convert, ranges from 0 to 99
+ *
+ * @return BCD representation of the given number
+ */
+static uint8_t bench_bcd(uint8_t value)
+{
+
+    return ((value / 10) << 4) | (value % 10);
+
+}
+
+/**
+ * @brief Encodes the given bits of a time frame into pauses
+ *
+ * @param pauses Pauses of the time frame, indexed by the number of the bit
+ * @param first Number of the first bit to encode
+ * @param count Number of bits to encode
+ * @param value Value of the bits, LSB first
+ * @param parity Pointer to the parity of the bits encoded so far
+ */
+static void bench_dcf77_bits(uint8_t* pauses, uint8_t first, uint8_t count,
+    uint8_t value, uint8_t* parity)
+{
+
+    for (uint8_t i = 0; i < count; i++) {
+
+        bool bit = (value >> i) & 1;
+
+        pauses[first + i] = bit ? 80 : 90;
+        *parity ^= bit;
+
+    }
+
+}
+
+/**
+ * @brief Generates the pauses of a time frame as measured by dcf77_ISR()
+ *
+ * Each pause is given in units of 10 ms and preceded by a pulse of 200 ms
+ * (1) or 100 ms (0), so a pause of 800 ms encodes a one and a pause of
+ * 900 ms encodes a zero. The last pause lasts for another second, as there
+ * is no pulse in the 59th second, and marks the beginning of the minute
+ * encoded by the time frame.
+ *
+ * @param pauses Pointer to memory of BENCH_DCF77_FRAME_LENGTH pauses
+ * @param dt Date and time to encode
+ */
+static void bench_dcf77_frame(uint8_t* pauses, const datetime_t* dt)
+{
+
+    uint8_t parity = 0;
+
+    memset(pauses, 90, BENCH_DCF77_FRAME_LENGTH);
+
+    // Start of encoded time
+    pauses[20] = 80;
+
+    bench_dcf77_bits(pauses, 21, 7, bench_bcd(dt->mm), &parity);
+    bench_dcf77_bits(pauses, 28, 1, parity, &parity);
+    bench_dcf77_bits(pauses, 29, 6, bench_bcd(dt->hh), &parity);
+    bench_dcf77_bits(pauses, 35, 1, parity, &parity);
+    bench_dcf77_bits(pauses, 36, 6, bench_bcd(dt->DD), &parity);
+    bench_dcf77_bits(pauses, 42, 3, dt->WD, &parity);
+    bench_dcf77_bits(pauses, 45, 5, bench_bcd(dt->MM), &parity);
+    bench_dcf77_bits(pauses, 50, 8, bench_bcd(dt->YY), &parity);
+
+    pauses[58] = parity ? 180 : 190;
+
+}
+
+/**
+ * @brief Benchmarks dcf77_check() with two consecutive time frames
+ *
+ * The decoding starts in the middle of a time frame, so the first minute
+ * mark resets it. The first complete time frame is taken over, and the
+ * second one, which needs to be the successor of the first one, is accepted.
+ * Nothing else may be accepted.
+ */
+static void bench_dcf77_check()
+{
+
+    static const datetime_t first = {14, 5, 10, 6, 12, 34, 0};
+    static const datetime_t second = {14, 5, 10, 6, 12, 35, 0};
+
+    uint8_t pauses[1 + 2 * BENCH_DCF77_FRAME_LENGTH];
+    uint32_t calls = 0;
+    bool ok = true;
+
+    pauses[0] = 190;
+    bench_dcf77_frame(&pauses[1], &first);
+    bench_dcf77_frame(&pauses[1 + BENCH_DCF77_FRAME_LENGTH], &second);
+
+    dcf77_init();
+
+    uint64_t start = host_time_ns();
+
+    for (uint16_t i = 0; i < BENCH_REPETITIONS; i++) {
+
+        dcf77_reset();
+        DCF.OldTime = 0;
+
+        for (uint8_t j = 0; j < sizeof(pauses); j++) {
+
+            DCF.PauseCounter = pauses[j];
+
+            if (dcf77_check() != (j == sizeof(pauses) - 1)) {
+
+                ok = false;
+
+            }
+
+            calls++;
+
+        }
+
+        if (memcmp((const uint8_t*)DCF.NewTime, (const uint8_t[]){35, 12, 10, 6, 5, 14}, 6)) {
+
+            ok = false;
+
+        }
+
+    }
+
+    bench_report("dcf77_check()", host_time_ns() - start, calls, ok);
+
+}
+
+/**
+ * @brief Benchmarks the parsing of the UART protocol
+ *
+ * Each line of bench_protocol_lines is handled by uart_protocol_handle().
+ * The valid ones need to be answered by something other than an error,
+ * whereas the invalid ones need to be answered by an error.
+ *
+ * @see bench_protocol_lines
+ */
+static void bench_uart_protocol()
+{
+
+    const uint8_t count = sizeof(bench_protocol_lines) / sizeof(bench_protocol_lines[0]);
+    uint32_t calls = 0;
+    bool ok = true;
+
+    uint64_t start = host_time_ns();
+
+    for (uint16_t i = 0; i < BENCH_REPETITIONS; i++) {
+
+        for (uint8_t j = 0; j < count; j++) {
+
+            size_t length;
+
+            host_uart_output_clear();
+            host_uart_input(bench_protocol_lines[j]);
+
+            uart_protocol_handle();
+
+            static const char error_str[] = "ERROR" UART_PROTOCOL_OUTPUT_EOL;
+            const char* output = host_uart_output(&length);
+            const size_t error_length = sizeof(error_str) - 1;
+
+            bool error = (length >= error_length)
+                && !memcmp(&output[length - error_length], error_str, error_length);
+
+            if (uart_available() || error != (j >= count - BENCH_PROTOCOL_INVALID_LINES)) {
+
+                if (ok) {
+
+                    printf("Unexpected response to %.*s: %.*s",
+                        (int)strlen(bench_protocol_lines[j]) - 1, bench_protocol_lines[j],
+                        (int)length, output);
+
+                }
+
+                ok = false;
+
+            }
+
+            calls++;
+
+        }
+
+    }
+
+    bench_report("uart_protocol_handle()", host_time_ns() - start, calls, ok);
+
+}
+
+/**
+ * @brief Checks display_fade_schedule against the gamma curve
+ *
+ * Each entry needs to equal `max(1, round(DISPLAY_FADE_CYCLE * (i /
+ * DISPLAY_FADE_STEPS) ^ 2.2))`, see display_fade_schedule.
+ */
+static void bench_display_fade_schedule()
+{
+
+    bool ok = true;
+
+    for (uint8_t i = 1; i <= DISPLAY_FADE_STEPS; i++) {
+
+        long expected = lround(DISPLAY_FADE_CYCLE * pow((double)i / DISPLAY_FADE_STEPS, 2.2));
+
+        if (expected < 1) {
+
+            expected = 1;
+
+        }
+
+        if (pgm_read_byte(&display_fade_schedule[i - 1]) != expected) {
+
+            ok = false;
+
+        }
+
+    }
+
+    printf("%-24s %s\n", "display_fade_schedule", ok ? "OK" : "FAILED");
+
+    if (!ok) {
+
+        bench_failures++;
+
+    }
+
+}
+
+int main()
+{
+
+    uart_init();
+    preferences_init();
+
+    bench_display_getTimeState();
+    bench_dcf77_check();
+    bench_color_hue2rgb();
+    bench_uart_protocol();
+    bench_display_fade_schedule();
+
+    return bench_failures ? 1 : 0;
+
+}
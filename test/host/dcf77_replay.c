@@ -0,0 +1,699 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dcf77_replay.c
+ * @brief Replays captures of the DCF77 signal into the decoder
+ *
+ * Each capture given on the command line is fed into dcf77_ISR() tick by
+ * tick (10 ms), just like `INTERRUPT_100HZ` would, by setting the level of
+ * the input pin accordingly. After each tick dcf77_get_datetime() is
+ * invoked, which runs dcf77_check(), just like the main loop would. For each
+ * capture the time until the first time frame was accepted, the number of
+ * accepted time frames, false accepts and resets are reported.
+ *
+ * Captures are text files describing the signal by the length of its pauses
+ * in units of 10 ms, i.e. the same numbers LOG_DCF77 puts out:
+ *
+ * - `P`: Pause of P ticks, preceded by a pulse filling up the second, e.g.
+ *   80 is preceded by a pulse of 20 ticks (a one), 190 by a pulse of 10
+ *   ticks (a zero, followed by the minute mark)
+ * - `L/P`: Pause of P ticks, preceded by a pulse of L ticks, e.g. for spikes
+ *   (`2/40`) or dropouts (`0/1500`)
+ * - `@ YYYY-MM-DD hh:mm`: The next pause is the minute mark preceding the
+ *   given minute. Only the first of these is taken into account. Without it
+ *   false accepts can't be detected.
+ * - `#`: Comment up to the end of the line
+ *
+ * The receiver is emulated to be high active and the detection of the
+ * receiver type (DCF77_RECEIVER_DETECT) is part of the replay. Each capture
+ * is replayed within a process of its own, so it starts out with the state
+ * of the decoder right after a reset of the microcontroller. Once a time
+ * frame has been accepted, the decoding is enabled again right away (rather
+ * than with the next hour), so that all of the capture is analyzed.
+ *
+ * dcf77.c is included into this file directly, with timer_get_ms(),
+ * datetime_get() and datetime_is_valid() replaced by a clock driven by the
+ * replay. By default this clock is invalid, just like after the battery of
+ * the RTC has run out. With `-s` it is set from the anchor, but running
+ * behind by REPLAY_CLOCK_OFFSET, so that a single plausible time frame can be
+ * accepted (DCF77_FAST_SYNC). Once a time frame has been accepted, the clock
+ * takes over the received time, just like after datetime_set().
+ *
+ * The Makefile builds this once with the polled decoding and once with
+ * DCF77_USE_EDGE_TIMESTAMPS, in which case the pin change interrupt is
+ * emulated, too. The latter discards the pause in progress when the decoding
+ * is enabled again, so the time frame following an accepted one is lost.
+ *
+ * @see Makefile
+ * @see dcf77/
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <avr/io.h>
+
+#include "config.h"
+#include "host.h"
+
+#define timer_get_ms replay_get_ms
+#define datetime_get replay_datetime_get
+#define datetime_is_valid replay_datetime_is_valid
+
+#include "dcf77.c"
+
+/**
+ * @brief Maximum number of pulses a single capture can consist of
+ */
+#define REPLAY_MAX_PULSES 16384
+
+/**
+ * @brief Number of ticks (of dcf77_ISR()) per second
+ */
+#define REPLAY_TICKS_PER_SECOND 100
+
+/**
+ * @brief Seconds the clock set by `-s` is running behind
+ *
+ * This needs to be within DCF77_FAST_SYNC_WINDOW for a single time frame to
+ * be accepted.
+ */
+#define REPLAY_CLOCK_OFFSET (-120)
+
+/**
+ * @brief A pulse along with the pause following it
+ *
+ * @see replay_load()
+ */
+typedef struct {
+
+    /**
+     * @brief Length of the pulse in ticks
+     */
+    uint16_t pulse;
+
+    /**
+     * @brief Length of the pause in ticks
+     */
+    uint16_t pause;
+
+} replay_pulse_t;
+
+/**
+ * @brief A capture loaded from a file
+ *
+ * @see replay_load()
+ */
+typedef struct {
+
+    /**
+     * @brief Number of valid entries within pulses
+     */
+    size_t count;
+
+    /**
+     * @brief Tick at which the minute of the anchor begins
+     *
+     * This is only valid if anchor_valid is set.
+     */
+    uint32_t anchor_tick;
+
+    /**
+     * @brief Minute the anchor refers to
+     */
+    time_t anchor_time;
+
+    /**
+     * @brief Indicates whether an anchor was found
+     */
+    bool anchor_valid;
+
+    /**
+     * @brief The pulses making up this capture
+     */
+    replay_pulse_t pulses[REPLAY_MAX_PULSES];
+
+} replay_capture_t;
+
+/**
+ * @brief Results of a single replay
+ *
+ * @see replay_run()
+ */
+typedef struct {
+
+    /**
+     * @brief Length of the capture in ticks
+     */
+    uint32_t ticks;
+
+    /**
+     * @brief Tick at which the first time frame was accepted
+     *
+     * This is only valid if accepts is not zero.
+     */
+    uint32_t first_sync;
+
+    /**
+     * @brief Number of accepted time frames
+     */
+    uint16_t accepts;
+
+    /**
+     * @brief Number of accepted time frames differing from the anchor
+     */
+    uint16_t false_accepts;
+
+} replay_result_t;
+
+/**
+ * @brief The capture currently being replayed
+ *
+ * This is too big to be put onto the stack.
+ */
+static replay_capture_t replay_capture;
+
+/**
+ * @brief Tick currently being replayed
+ *
+ * @see replay_get_ms()
+ */
+static uint32_t replay_now;
+
+/**
+ * @brief Indicates whether the clock of the replay is valid
+ *
+ * @see replay_datetime_is_valid()
+ */
+static bool replay_clock_valid;
+
+/**
+ * @brief Time of the clock of the replay at tick 0
+ *
+ * @see replay_datetime_get()
+ */
+static time_t replay_clock_origin;
+
+/**
+ * @brief Replacement of timer_get_ms() used by dcf77.c
+ *
+ * @return Milliseconds replayed so far, truncated to 16 bits
+ */
+uint16_t replay_get_ms()
+{
+
+    return replay_now * (1000 / REPLAY_TICKS_PER_SECOND);
+
+}
+
+/**
+ * @brief Replacement of datetime_is_valid() used by dcf77.c
+ *
+ * @return True if the clock has been set, false otherwise
+ */
+bool replay_datetime_is_valid()
+{
+
+    return replay_clock_valid;
+
+}
+
+/**
+ * @brief Replacement of datetime_get() used by dcf77.c
+ *
+ * @return Current date and time of the clock of the replay
+ */
+const datetime_t* replay_datetime_get()
+{
+
+    static datetime_t dt;
+
+    time_t now = replay_clock_origin + replay_now / REPLAY_TICKS_PER_SECOND;
+    struct tm tm;
+
+    gmtime_r(&now, &tm);
+
+    dt.YY = tm.tm_year % 100;
+    dt.MM = tm.tm_mon + 1;
+    dt.DD = tm.tm_mday;
+    dt.WD = tm.tm_wday ? tm.tm_wday : 7;
+    dt.hh = tm.tm_hour;
+    dt.mm = tm.tm_min;
+    dt.ss = tm.tm_sec;
+
+    return &dt;
+
+}
+
+/**
+ * @brief Sets the clock of the replay
+ *
+ * @param now Time the clock should have at the current tick
+ */
+static void replay_clock_set(time_t now)
+{
+
+    replay_clock_origin = now - replay_now / REPLAY_TICKS_PER_SECOND;
+    replay_clock_valid = true;
+
+}
+
+/**
+ * @brief Parses an anchor (`@ YYYY-MM-DD hh:mm`)
+ *
+ * @param line The line containing the anchor, without the leading `@`
+ * @param o_time Pointer to memory the parsed minute will be copied to
+ *
+ * @return True if the anchor could be parsed, false otherwise
+ */
+static bool replay_parse_anchor(const char* line, time_t* o_time)
+{
+
+    struct tm tm = {0};
+
+    if (sscanf(line, " %d-%d-%d %d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+            &tm.tm_hour, &tm.tm_min) != 5) {
+
+        return false;
+
+    }
+
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    *o_time = timegm(&tm);
+
+    return true;
+
+}
+
+/**
+ * @brief Parses a single pause, optionally preceded by its pulse (`L/P`)
+ *
+ * @param token The token to parse
+ * @param o_pulse Pointer to memory the parsed pulse will be copied to
+ *
+ * @return True if the token could be parsed, false otherwise
+ */
+static bool replay_parse_pulse(const char* token, replay_pulse_t* o_pulse)
+{
+
+    char* end;
+    unsigned long pulse = 0;
+    unsigned long pause = strtoul(token, &end, 10);
+
+    if (*end == '/') {
+
+        pulse = pause;
+        pause = strtoul(end + 1, &end, 10);
+
+    } else {
+
+        pulse = (REPLAY_TICKS_PER_SECOND - pause % REPLAY_TICKS_PER_SECOND)
+            % REPLAY_TICKS_PER_SECOND;
+
+    }
+
+    if (end == token || *end != '\0' || pulse > UINT16_MAX || pause > UINT16_MAX) {
+
+        return false;
+
+    }
+
+    o_pulse->pulse = pulse;
+    o_pulse->pause = pause;
+
+    return true;
+
+}
+
+/**
+ * @brief Loads a capture from the given file
+ *
+ * @param filename Name of the file to load
+ * @param o_capture Pointer to memory the capture will be put into
+ *
+ * @return True if the capture could be loaded, false otherwise
+ *
+ * @see replay_capture_t
+ */
+static bool replay_load(const char* filename, replay_capture_t* o_capture)
+{
+
+    FILE* file = fopen(filename, "r");
+    char line[256];
+    unsigned int line_number = 0;
+    uint32_t tick = 0;
+    bool anchor_pending = false;
+
+    if (!file) {
+
+        fprintf(stderr, "%s: %s\n", filename, strerror(errno));
+
+        return false;
+
+    }
+
+    o_capture->count = 0;
+    o_capture->anchor_valid = false;
+
+    while (fgets(line, sizeof(line), file)) {
+
+        line_number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        if (line[0] == '@') {
+
+            time_t anchor;
+
+            if (!replay_parse_anchor(&line[1], &anchor)) {
+
+                fprintf(stderr, "%s:%u: Invalid anchor\n", filename, line_number);
+                fclose(file);
+
+                return false;
+
+            }
+
+            if (!o_capture->anchor_valid && !anchor_pending) {
+
+                o_capture->anchor_time = anchor;
+                anchor_pending = true;
+
+            }
+
+            continue;
+
+        }
+
+        for (char* token = strtok(line, " \t"); token; token = strtok(NULL, " \t")) {
+
+            replay_pulse_t* pulse = &o_capture->pulses[o_capture->count];
+
+            if (o_capture->count == REPLAY_MAX_PULSES
+                    || !replay_parse_pulse(token, pulse)) {
+
+                fprintf(stderr, "%s:%u: Invalid pause: %s\n", filename,
+                    line_number, token);
+                fclose(file);
+
+                return false;
+
+            }
+
+            tick += pulse->pulse + pulse->pause;
+            o_capture->count++;
+
+            if (anchor_pending) {
+
+                o_capture->anchor_tick = tick;
+                o_capture->anchor_valid = true;
+                anchor_pending = false;
+
+            }
+
+        }
+
+    }
+
+    fclose(file);
+
+    return true;
+
+}
+
+/**
+ * @brief Advances the decoder by a single tick
+ *
+ * @param level Level of the input pin, high during a pause
+ * @param tick Number of the tick
+ * @param result Pointer to the results, which are updated accordingly
+ */
+static void replay_tick(bool level, uint32_t tick, replay_result_t* result)
+{
+
+    datetime_t dt;
+
+    #if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+        bool previous = PINB & _BV(PB7);
+
+    #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+    replay_now = tick;
+
+    if (level) {
+
+        PINB |= _BV(PB7);
+
+    } else {
+
+        PINB &= ~_BV(PB7);
+
+    }
+
+    #if (DCF77_USE_EDGE_TIMESTAMPS == 1)
+
+        if (level != previous && (PCICR & _BV(DCF_INPUT_PCIE))
+                && (DCF_INPUT_PCMSK & _BV(BIT(DCF_INPUT)))) {
+
+            DCF_INPUT_PCINT_vect();
+
+        }
+
+    #endif /* (DCF77_USE_EDGE_TIMESTAMPS == 1) */
+
+    dcf77_ISR();
+
+    if ((tick + 1) % REPLAY_TICKS_PER_SECOND == 0) {
+
+        dcf77_stats_ISR();
+
+    }
+
+    if (!dcf77_get_datetime(&dt)) {
+
+        return;
+
+    }
+
+    if (!result->accepts++) {
+
+        result->first_sync = tick;
+
+    }
+
+    if (replay_capture.anchor_valid) {
+
+        int32_t offset = (int32_t)(tick - replay_capture.anchor_tick);
+        int32_t minutes = (offset + 30 * REPLAY_TICKS_PER_SECOND * (offset < 0 ? -1 : 1))
+            / (60 * REPLAY_TICKS_PER_SECOND);
+        time_t expected = replay_capture.anchor_time + minutes * 60;
+        struct tm tm;
+
+        gmtime_r(&expected, &tm);
+
+        if (dt.YY != tm.tm_year % 100 || dt.MM != tm.tm_mon + 1
+                || dt.DD != tm.tm_mday || dt.hh != tm.tm_hour
+                || dt.mm != tm.tm_min) {
+
+            result->false_accepts++;
+
+        }
+
+    }
+
+    struct tm tm = {
+
+        .tm_year = 100 + dt.YY,
+        .tm_mon = dt.MM - 1,
+        .tm_mday = dt.DD,
+        .tm_hour = dt.hh,
+        .tm_min = dt.mm,
+
+    };
+
+    replay_clock_set(timegm(&tm));
+    dcf77_enable();
+
+}
+
+/**
+ * @brief Replays the capture currently loaded
+ *
+ * @param result Pointer to memory the results will be put into
+ * @param set_clock True to set the clock from the anchor (if any) before
+ * replaying, false to leave it invalid
+ *
+ * @see replay_capture
+ * @see REPLAY_CLOCK_OFFSET
+ */
+static void replay_run(replay_result_t* result, bool set_clock)
+{
+
+    uint32_t tick = 0;
+
+    memset(result, 0, sizeof(*result));
+
+    replay_now = 0;
+    replay_clock_valid = false;
+
+    if (set_clock && replay_capture.anchor_valid) {
+
+        replay_clock_set(replay_capture.anchor_time + REPLAY_CLOCK_OFFSET
+            - replay_capture.anchor_tick / REPLAY_TICKS_PER_SECOND);
+
+    }
+
+    dcf77_init();
+    dcf77_reset_stats();
+    dcf77_enable();
+
+    for (size_t i = 0; i < replay_capture.count; i++) {
+
+        const replay_pulse_t* pulse = &replay_capture.pulses[i];
+
+        for (uint16_t j = 0; j < pulse->pulse; j++) {
+
+            replay_tick(false, tick++, result);
+
+        }
+
+        for (uint16_t j = 0; j < pulse->pause; j++) {
+
+            replay_tick(true, tick++, result);
+
+        }
+
+    }
+
+    result->ticks = tick;
+
+}
+
+/**
+ * @brief Replays the given capture and outputs the results
+ *
+ * This is expected to be executed within a process of its own.
+ *
+ * @param filename Name of the file containing the capture
+ * @param set_clock See replay_run()
+ *
+ * @return Exit status of the process
+ */
+static int replay_file(const char* filename, bool set_clock)
+{
+
+    replay_result_t result;
+    dcf77_stats_t stats;
+    char first[16] = "-";
+
+    if (!replay_load(filename, &replay_capture)) {
+
+        return 1;
+
+    }
+
+    replay_run(&result, set_clock);
+    dcf77_get_stats(&stats);
+
+    if (result.accepts) {
+
+        snprintf(first, sizeof(first), "%u s",
+            result.first_sync / REPLAY_TICKS_PER_SECOND);
+
+    }
+
+    const char* name = strrchr(filename, '/');
+
+    printf("%-24s %5u s %9s %7u ", name ? name + 1 : filename,
+        result.ticks / REPLAY_TICKS_PER_SECOND, first, result.accepts);
+
+    if (replay_capture.anchor_valid) {
+
+        printf("%7u ", result.false_accepts);
+
+    } else {
+
+        printf("%7s ", "-");
+
+    }
+
+    printf("%7u %7u\n", stats.resets, stats.parity_errors);
+
+    return 0;
+
+}
+
+int main(int argc, char* argv[])
+{
+
+    int status = 0;
+    bool set_clock = false;
+    int first = 1;
+
+    if (argc > 1 && !strcmp(argv[1], "-s")) {
+
+        set_clock = true;
+        first++;
+
+    }
+
+    if (argc <= first) {
+
+        fprintf(stderr, "Usage: %s [-s] <capture>...\n", argv[0]);
+
+        return 2;
+
+    }
+
+    printf("%s decoding, clock %s\n",
+        DCF77_USE_EDGE_TIMESTAMPS ? "Edge timestamped" : "Polled",
+        set_clock ? "set" : "invalid");
+    printf("%-24s %7s %9s %7s %7s %7s %7s\n", "Capture", "Length", "First",
+        "Accepts", "False", "Resets", "Parity");
+    fflush(stdout);
+
+    for (int i = first; i < argc; i++) {
+
+        int child_status;
+        pid_t pid = fork();
+
+        if (pid == 0) {
+
+            exit(replay_file(argv[i], set_clock));
+
+        }
+
+        if (pid < 0 || waitpid(pid, &child_status, 0) < 0
+                || !WIFEXITED(child_status) || WEXITSTATUS(child_status)) {
+
+            status = 1;
+
+        }
+
+    }
+
+    return status;
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file host.c
+ * @brief Implementation of the header declared in host.h
+ *
+ * @see host.h
+ */
+
+#include <time.h>
+#include <avr/io.h>
+
+#include "host.h"
+
+/**
+ * @brief Backing storage of the I/O registers
+ *
+ * @see avr/io.h
+ */
+volatile uint8_t host_sfr[0x100];
+
+/**
+ * @brief Returns a monotonic timestamp
+ *
+ * @return Timestamp in nanoseconds, with an arbitrary point of origin
+ */
+uint64_t host_time_ns()
+{
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file host.h
+ * @brief Header for the glue needed to run the firmware on the host
+ *
+ * The modules of the firmware are built for the host against the mocks
+ * within `include/`. Nothing is driven by the hardware there, so the
+ * programs built on top of them (see bench.c) feed the modules directly.
+ * This provides the few things that can't be mocked by headers alone, most
+ * notably the UART (see uart.c), which is replaced by a buffer, as the
+ * original one would wait for the hardware to transmit its data.
+ *
+ * @see host.c
+ * @see uart.c
+ */
+
+#ifndef _WC_HOST_H_
+#define _WC_HOST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of the buffer capturing data transmitted via UART
+ *
+ * Anything beyond this is dropped, but still counted.
+ *
+ * @see host_uart_output()
+ */
+#define HOST_UART_OUTPUT_SIZE 1024
+
+extern uint64_t host_time_ns();
+
+extern void host_uart_input(const char* str);
+
+extern void host_uart_input_block(const void* data, size_t length);
+
+extern const char* host_uart_output(size_t* length);
+
+extern void host_uart_output_clear();
+
+#endif /* _WC_HOST_H_ */
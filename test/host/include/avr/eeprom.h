@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file avr/eeprom.h
+ * @brief Mock of the EEPROM access for host builds
+ *
+ * Variables declared with EEMEM are placed within the RAM of the host, so
+ * the EEPROM is accessed just like any other data.
+ */
+
+#ifndef _HOST_AVR_EEPROM_H_
+#define _HOST_AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait()
+
+#define eeprom_read_byte(addr) (*(const uint8_t*)(addr))
+#define eeprom_read_word(addr) (*(const uint16_t*)(addr))
+#define eeprom_write_byte(addr, value) (*(uint8_t*)(addr) = (value))
+#define eeprom_update_byte(addr, value) (*(uint8_t*)(addr) = (value))
+#define eeprom_read_block(dst, src, n) ((void)memcpy((dst), (src), (n)))
+#define eeprom_write_block(src, dst, n) ((void)memcpy((dst), (src), (n)))
+#define eeprom_update_block(src, dst, n) ((void)memcpy((dst), (src), (n)))
+
+#endif /* _HOST_AVR_EEPROM_H_ */
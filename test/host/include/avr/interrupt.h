@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file avr/interrupt.h
+ * @brief Mock of the interrupt handling for host builds
+ *
+ * Interrupts are never triggered on their own. ISRs are turned into plain
+ * functions named after their vector, so they can be invoked directly.
+ * cli() and sei() only maintain the I bit within SREG.
+ */
+
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli() do { __asm__ __volatile__ ("" ::: "memory"); SREG &= ~_BV(SREG_I); } while (0)
+#define sei() do { __asm__ __volatile__ ("" ::: "memory"); SREG |= _BV(SREG_I); } while (0)
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+#endif /* _HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file stdio.h
+ * @brief Extension of the standard I/O functions of the host by the
+ * variants of avr-libc taking their format from the program space
+ *
+ * There is only a single address space on the host, so these simply map to
+ * their ordinary counterparts.
+ *
+ * @see avr/pgmspace.h
+ */
+
+#ifndef _HOST_STDIO_H_
+#define _HOST_STDIO_H_
+
+#include_next <stdio.h>
+
+#define printf_P printf
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define sscanf_P sscanf
+#define vsprintf_P vsprintf
+#define vsnprintf_P vsnprintf
+
+#endif /* _HOST_STDIO_H_ */
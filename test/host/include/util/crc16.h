@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file util/crc16.h
+ * @brief CRC routines of avr-libc for host builds
+ *
+ * These are implemented just like the C equivalents given within the
+ * documentation of avr-libc, so checksums match the ones of the target.
+ */
+
+#ifndef _HOST_UTIL_CRC16_H_
+#define _HOST_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t a)
+{
+
+    crc ^= a;
+
+    for (uint8_t i = 0; i < 8; i++) {
+
+        crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+
+    }
+
+    return crc;
+
+}
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data)
+{
+
+    data ^= crc & 0xff;
+    data ^= data << 4;
+
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4)
+        ^ ((uint16_t)data << 3));
+
+}
+
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+
+    crc ^= data;
+
+    for (uint8_t i = 0; i < 8; i++) {
+
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+
+    }
+
+    return crc;
+
+}
+
+#endif /* _HOST_UTIL_CRC16_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file util/setbaud.h
+ * @brief Baud rate calculation of avr-libc for host builds
+ *
+ * This always uses single speed mode, which is sufficient as the registers
+ * aren't connected to anything anyway.
+ */
+
+#ifndef F_CPU
+#  error "F_CPU needs to be defined"
+#endif
+
+#ifndef BAUD
+#  error "BAUD needs to be defined"
+#endif
+
+#undef UBRR_VALUE
+#undef UBRRL_VALUE
+#undef UBRRH_VALUE
+#undef USE_2X
+
+#define UBRR_VALUE (((F_CPU) + 8UL * (BAUD)) / (16UL * (BAUD)) - 1UL)
+#define UBRRL_VALUE (UBRR_VALUE & 0xff)
+#define UBRRH_VALUE (UBRR_VALUE >> 8)
+#define USE_2X 0
@@ -0,0 +1,1311 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file protocol.c
+ * @brief Conformance and performance suite for the UART protocol
+ *
+ * This issues every command of #uart_protocol_commands in ASCII as well as
+ * in binary mode and checks the responses against the ones documented
+ * within doc/UART_PROTOCOL.md, which is passed as the only argument. The
+ * opcodes and the number of arguments are taken from the document itself,
+ * whereas the format of the responses is transcribed into protocol_specs.
+ *
+ * Along the way the time spent on the host and the number of bytes
+ * transferred are measured for each command, the latter being converted
+ * into the rate the link could sustain at #UART_BAUD. Afterwards malformed
+ * and garbled lines and frames are thrown at the parser, which needs to
+ * answer each of them properly without getting out of sync.
+ *
+ * uart_protocol.c is included into this file directly, so that the command
+ * table and the internal limits are accessible.
+ *
+ * @see Makefile
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "host.h"
+#include "preferences.h"
+#include "uart.h"
+
+#include "uart_protocol.c"
+
+/**
+ * @brief Number of times each command is issued to measure its latency
+ */
+#define PROTOCOL_REPETITIONS 1000
+
+/**
+ * @brief Number of random lines thrown at the parser
+ *
+ * @see protocol_fuzz_lines()
+ */
+#define PROTOCOL_FUZZ_LINES 20000
+
+/**
+ * @brief Number of corrupted frames thrown at the parser
+ *
+ * @see protocol_fuzz_frames()
+ */
+#define PROTOCOL_FUZZ_FRAMES 20000
+
+/**
+ * @brief Number of commands sent in a row without waiting for responses
+ *
+ * @see protocol_pipeline()
+ */
+#define PROTOCOL_PIPELINE_LENGTH 32
+
+/**
+ * @brief Maximum number of commands that can be read from the document
+ *
+ * @see protocol_doc
+ */
+#define PROTOCOL_DOC_MAX_COMMANDS 64
+
+/**
+ * @brief Specification of a single command
+ *
+ * @see protocol_specs
+ */
+typedef struct {
+
+    /**
+     * @brief Name of the command
+     */
+    const char* command;
+
+    /**
+     * @brief Valid arguments to issue the command with
+     *
+     * The arguments are given just like in ASCII mode. In binary mode
+     * arguments consisting of two hex digits are sent as the byte they
+     * represent, others as their first character. NULL if the command can't
+     * be issued on the host at all.
+     */
+    const char* args;
+
+    /**
+     * @brief Responses allowed by the document
+     *
+     * The alternatives are separated by `|`, each one consisting of tokens
+     * separated by spaces: `2` for a value with two hex digits (one byte in
+     * binary mode), `4` for a value with four hex digits (two bytes in binary
+     * mode), `OK`, `ERROR` or `-` for no response at all.
+     */
+    const char* responses;
+
+} protocol_spec_t;
+
+/**
+ * @brief Responses of all commands as documented in doc/UART_PROTOCOL.md
+ *
+ * `b`, `f` and `r` are not issued by protocol_commands(), as the latter two
+ * reset the microcontroller and `b` is covered by switching the modes.
+ *
+ * @see protocol_spec_t
+ */
+static const protocol_spec_t protocol_specs[] = {
+
+    {"b", NULL, "OK"},
+    {"bt", "", "4"},
+    {"cr", "", "2 2 2"},
+    {"cw", "10 20 30", "OK"},
+    {"dg", "", "2 2 2 2|ERROR"},
+    {"ds", "0a 05 0e 06", "OK|ERROR"},
+    {"dt", "00", "OK"},
+    {"f", NULL, "OK"},
+    {"hc", "", "OK"},
+    {"hg", "", "4 4 4 4 4 4 4"},
+    {"i", "N", "OK"},
+    {"ic", "", "OK"},
+    {"ig", "00", "4 4 4 4"},
+    {"k", "", "OK"},
+    {"lb", "", "2"},
+    {"mc", "", "4"},
+    {"mu", "", "4"},
+    {"ms", "", "4 4 4 4 4 4 4"},
+    {"og", "", "2"},
+    {"os", "05", "OK"},
+    {"pa", "", "2"},
+    {"pn", "", "2"},
+    {"pr", "00", "2 2 2"},
+    {"ps", "00", "OK"},
+    {"pw", "00 10 20 30", "OK"},
+    {"r", NULL, "OK"},
+    {"sc", "", "OK"},
+    {"sg", "", "4 4 4 4 4 4 4 4 4 4 2 2 2 2 2"},
+    {"su", "00 00", "2"},
+    {"tb", "2d c3 99 c0 02", "-"},
+    {"tg", "", "2 2 2|ERROR"},
+    {"ts", "0c 22 00", "OK|ERROR"},
+    {"tx", "00", "2"},
+    {"uc", "", "OK"},
+    {"ug", "", "4 4 4"},
+    {"v", "", "2 2"},
+    {"xc", "00 00 00", "OK|ERROR"},
+    {"xg", "00", "2 2 2"},
+    {"xr", "00 00", "2 2 2 2"},
+    {"xw", "00 01 02 03", "OK"},
+
+};
+
+/**
+ * @brief Number of entries within protocol_specs
+ */
+#define PROTOCOL_SPECS_COUNT (sizeof(protocol_specs) / sizeof(protocol_spec_t))
+
+/**
+ * @brief A command as described by doc/UART_PROTOCOL.md
+ *
+ * @see protocol_read_doc()
+ */
+typedef struct {
+
+    /**
+     * @brief Name of the command
+     */
+    char command[UART_PROTOCOL_COMMAND_MAX_LENGTH + 1];
+
+    /**
+     * @brief Opcode listed within the table of the section BINARY MODE
+     *
+     * -1 if the command isn't listed there.
+     */
+    int16_t opcode;
+
+    /**
+     * @brief Number of arguments of its section within COMMANDS
+     *
+     * -1 if there is no such section.
+     */
+    int8_t arguments;
+
+} protocol_doc_t;
+
+/**
+ * @brief Commands read from doc/UART_PROTOCOL.md
+ *
+ * @see protocol_read_doc()
+ */
+static protocol_doc_t protocol_doc[PROTOCOL_DOC_MAX_COMMANDS];
+
+/**
+ * @brief Number of entries within protocol_doc
+ */
+static uint8_t protocol_doc_count;
+
+/**
+ * @brief Number of checks that have failed so far
+ */
+static uint16_t protocol_failures;
+
+/**
+ * @brief Reports a failed check
+ *
+ * Only the first few failures are output, so that a broken parser doesn't
+ * flood the output.
+ *
+ * @param fmt Format string describing the failure, followed by its arguments
+ */
+static void protocol_fail(const char* fmt, ...)
+{
+
+    if (protocol_failures++ < 20) {
+
+        va_list va;
+        va_start(va, fmt);
+
+        printf("FAILED: ");
+        vprintf(fmt, va);
+        printf("\n");
+
+        va_end(va);
+
+    }
+
+}
+
+/**
+ * @brief Returns the entry of protocol_doc for the given command
+ *
+ * If there is no entry for the command yet, a new one is created.
+ *
+ * @param command Name of the command
+ *
+ * @return Pointer to the entry, NULL if the command is invalid and/or there
+ * are too many commands
+ */
+static protocol_doc_t* protocol_doc_entry(const char* command)
+{
+
+    if (strlen(command) > UART_PROTOCOL_COMMAND_MAX_LENGTH) {
+
+        return NULL;
+
+    }
+
+    for (uint8_t i = 0; i < protocol_doc_count; i++) {
+
+        if (!strcmp(protocol_doc[i].command, command)) {
+
+            return &protocol_doc[i];
+
+        }
+
+    }
+
+    if (protocol_doc_count == PROTOCOL_DOC_MAX_COMMANDS) {
+
+        return NULL;
+
+    }
+
+    protocol_doc_t* entry = &protocol_doc[protocol_doc_count++];
+
+    strcpy(entry->command, command);
+    entry->opcode = -1;
+    entry->arguments = -1;
+
+    return entry;
+
+}
+
+/**
+ * @brief Reads the commands from doc/UART_PROTOCOL.md
+ *
+ * The opcodes are taken from the rows of the table within BINARY MODE
+ * (`| cw      | 11     |`), the number of arguments from the lines
+ * introducing each command (`**Command**: cw R G B`).
+ *
+ * @param path Path to the document
+ *
+ * @return True if the document could be read, false otherwise
+ */
+static bool protocol_read_doc(const char* path)
+{
+
+    FILE* file = fopen(path, "r");
+    bool table = false;
+    char line[256];
+
+    if (!file) {
+
+        return false;
+
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+
+        char command[8];
+        unsigned int opcode;
+        int offset;
+
+        if (!strncmp(line, "| Command | Opcode |", 20)) {
+
+            table = true;
+
+        } else if (line[0] != '|') {
+
+            table = false;
+
+        }
+
+        if (table && sscanf(line, "| %7s | %2x |", command, &opcode) == 2) {
+
+            protocol_doc_t* entry = protocol_doc_entry(command);
+
+            if (entry) {
+
+                entry->opcode = opcode;
+
+            }
+
+        } else if (sscanf(line, "**Command**: %7s%n", command, &offset) == 1) {
+
+            protocol_doc_t* entry = protocol_doc_entry(command);
+
+            if (entry) {
+
+                entry->arguments = 0;
+
+                for (char* token = strtok(&line[offset], " \n"); token; token = strtok(NULL, " \n")) {
+
+                    entry->arguments++;
+
+                }
+
+            }
+
+        }
+
+    }
+
+    fclose(file);
+
+    return protocol_doc_count != 0;
+
+}
+
+/**
+ * @brief Returns the specification of the given command
+ *
+ * @param command Name of the command
+ *
+ * @return Pointer to the entry within protocol_specs, NULL if not found
+ */
+static const protocol_spec_t* protocol_find_spec(const char* command)
+{
+
+    for (uint8_t i = 0; i < PROTOCOL_SPECS_COUNT; i++) {
+
+        if (!strcmp(protocol_specs[i].command, command)) {
+
+            return &protocol_specs[i];
+
+        }
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * @brief Checks the command table against the document
+ *
+ * The table needs to be sorted in ascending order by both, the command and
+ * the opcode, as uart_protocol_find_command() performs a binary search on
+ * it. Each command compiled in needs to be documented with the same opcode
+ * and number of arguments, and needs to be covered by protocol_specs.
+ */
+static void protocol_check_table()
+{
+
+    for (uint8_t i = 0; i < UART_PROTOCOL_COMMANDS_COUNT; i++) {
+
+        const uart_protocol_command_t* entry = &uart_protocol_commands[i];
+        protocol_doc_t* doc = protocol_doc_entry(entry->command);
+
+        if (i > 0) {
+
+            const uart_protocol_command_t* prev = &uart_protocol_commands[i - 1];
+
+            if (strcmp(prev->command, entry->command) >= 0) {
+
+                protocol_fail("%s: not sorted by command after %s", entry->command, prev->command);
+
+            }
+
+            if (prev->opcode >= entry->opcode) {
+
+                protocol_fail("%s: not sorted by opcode after %s", entry->command, prev->command);
+
+            }
+
+        }
+
+        if (!doc || doc->opcode != entry->opcode) {
+
+            protocol_fail("%s: opcode %02x not documented", entry->command, entry->opcode);
+
+        }
+
+        if (!doc || doc->arguments != entry->arguments) {
+
+            protocol_fail("%s: %u arguments not documented", entry->command, entry->arguments);
+
+        }
+
+        if (!protocol_find_spec(entry->command)) {
+
+            protocol_fail("%s: no specification of its responses", entry->command);
+
+        }
+
+    }
+
+}
+
+/**
+ * @brief Feeds the given data to the parser
+ *
+ * uart_protocol_handle() processes at most one command per invocation, so it
+ * is invoked until all of the data has been consumed.
+ *
+ * @param data Data to receive
+ * @param length Number of bytes to receive
+ * @param response Pointer to memory the number of bytes put out will be
+ * copied to
+ *
+ * @return Data put out in response
+ */
+static const char* protocol_request(const void* data, size_t length, size_t* response)
+{
+
+    host_uart_output_clear();
+    host_uart_input_block(data, length);
+
+    while (uart_available()) {
+
+        uart_protocol_handle();
+
+    }
+
+    return host_uart_output(response);
+
+}
+
+/**
+ * @brief Checks a response in ASCII mode against a single alternative
+ *
+ * @param response Response to check, without the prefix and request ID
+ * @param length Length of the response, without the EOL
+ * @param alternative Alternative to check against (see protocol_spec_t)
+ * @param alternative_length Length of the alternative
+ *
+ * @return True if the response matches, false otherwise
+ */
+static bool protocol_match_ascii(const char* response, size_t length,
+    const char* alternative, size_t alternative_length)
+{
+
+    if ((alternative_length == 2 && !memcmp(alternative, "OK", 2))
+            || (alternative_length == 5 && !memcmp(alternative, "ERROR", 5))) {
+
+        return length == alternative_length && !memcmp(response, alternative, length);
+
+    }
+
+    size_t i = 0;
+
+    for (size_t j = 0; j < alternative_length; j += 2) {
+
+        uint8_t digits = alternative[j] - '0';
+
+        if (j != 0) {
+
+            if (i >= length || response[i++] != ' ') {
+
+                return false;
+
+            }
+
+        }
+
+        for (uint8_t k = 0; k < digits; k++, i++) {
+
+            if (i >= length || !strchr("0123456789abcdef", response[i])) {
+
+                return false;
+
+            }
+
+        }
+
+    }
+
+    return i == length;
+
+}
+
+/**
+ * @brief Checks a response in binary mode against a single alternative
+ *
+ * @param frame Payload of the response frame (status and data)
+ * @param length Length of the payload
+ * @param alternative Alternative to check against (see protocol_spec_t)
+ * @param alternative_length Length of the alternative
+ *
+ * @return True if the response matches, false otherwise
+ */
+static bool protocol_match_binary(const uint8_t* frame, size_t length,
+    const char* alternative, size_t alternative_length)
+{
+
+    if (alternative_length == 5 && !memcmp(alternative, "ERROR", 5)) {
+
+        return length == 1 && frame[0] == UART_PROTOCOL_FRAME_STATUS_ERROR;
+
+    }
+
+    size_t bytes = 0;
+
+    if (!(alternative_length == 2 && !memcmp(alternative, "OK", 2))) {
+
+        for (size_t j = 0; j < alternative_length; j += 2) {
+
+            bytes += (alternative[j] - '0') / 2;
+
+        }
+
+    }
+
+    return length == 1 + bytes && frame[0] == UART_PROTOCOL_FRAME_STATUS_OK;
+
+}
+
+/**
+ * @brief Checks a response against the specification of a command
+ *
+ * In ASCII mode the response needs to consist of a single line made up of
+ * #UART_PROTOCOL_OUTPUT_PREFIX, the given request ID, the payload and
+ * #UART_PROTOCOL_OUTPUT_EOL. In binary mode it needs to consist of a single
+ * frame with a valid checksum.
+ *
+ * @param spec Specification of the command
+ * @param output Response to check
+ * @param length Length of the response
+ * @param id Request ID the response needs to carry, NULL for none
+ *
+ * @return True if the response matches one of the alternatives, false
+ * otherwise
+ */
+static bool protocol_check_response(const protocol_spec_t* spec,
+    const char* output, size_t length, const char* id)
+{
+
+    const char* payload = output;
+    size_t payload_length = length;
+
+    if (!strcmp(spec->responses, "-")) {
+
+        return length == 0;
+
+    }
+
+    if (uart_protocol_binary_mode) {
+
+        const uint8_t* frame = (const uint8_t*)output;
+        uint8_t crc = 0;
+
+        if (length < 3 || frame[0] + 2 != length) {
+
+            return false;
+
+        }
+
+        for (size_t i = 0; i < length - 1; i++) {
+
+            crc = _crc8_ccitt_update(crc, frame[i]);
+
+        }
+
+        if (crc != frame[length - 1]) {
+
+            return false;
+
+        }
+
+        payload = &output[1];
+        payload_length = frame[0];
+
+    } else {
+
+        const size_t prefix_length = strlen(UART_PROTOCOL_OUTPUT_PREFIX);
+        const size_t eol_length = strlen(UART_PROTOCOL_OUTPUT_EOL);
+        const size_t id_length = id ? strlen(id) + 2 : 0;
+
+        if (length < prefix_length + id_length + eol_length
+                || memcmp(output, UART_PROTOCOL_OUTPUT_PREFIX, prefix_length)
+                || memcmp(&output[length - eol_length], UART_PROTOCOL_OUTPUT_EOL, eol_length)) {
+
+            return false;
+
+        }
+
+        if (id && (output[prefix_length] != UART_PROTOCOL_REQUEST_ID_PREFIX
+                || memcmp(&output[prefix_length + 1], id, id_length - 2)
+                || output[prefix_length + id_length - 1] != ' ')) {
+
+            return false;
+
+        }
+
+        payload = &output[prefix_length + id_length];
+        payload_length = length - prefix_length - id_length - eol_length;
+
+    }
+
+    const char* alternative = spec->responses;
+
+    while (true) {
+
+        const char* end = strchr(alternative, '|');
+        size_t alternative_length = end ? (size_t)(end - alternative) : strlen(alternative);
+
+        bool match = uart_protocol_binary_mode
+            ? protocol_match_binary((const uint8_t*)payload, payload_length, alternative, alternative_length)
+            : protocol_match_ascii(payload, payload_length, alternative, alternative_length);
+
+        if (match) {
+
+            return true;
+
+        }
+
+        if (!end) {
+
+            return false;
+
+        }
+
+        alternative = end + 1;
+
+    }
+
+}
+
+/**
+ * @brief Builds the request for the given command
+ *
+ * @param request Pointer to memory of at least UART_PROTOCOL_COMMAND_BUFFER_SIZE
+ * bytes the request will be written to
+ * @param command Name of the command
+ * @param args Arguments as given in protocol_spec_t
+ *
+ * @return Length of the request
+ */
+static size_t protocol_build_request(char* request, const char* command, const char* args)
+{
+
+    if (!uart_protocol_binary_mode) {
+
+        return sprintf(request, "%s%s%s\r", command, *args ? " " : "", args);
+
+    }
+
+    uint8_t* frame = (uint8_t*)request;
+    uint8_t length = 1;
+    char copy[UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+
+    frame[1] = uart_protocol_find_command(command, 0)->opcode;
+
+    strcpy(copy, args);
+
+    for (char* token = strtok(copy, " "); token; token = strtok(NULL, " ")) {
+
+        uint8_t byte;
+
+        if (!format_parse_hex8(token, &byte)) {
+
+            byte = token[0];
+
+        }
+
+        frame[++length] = byte;
+
+    }
+
+    frame[0] = length;
+    frame[length + 1] = 0;
+
+    for (uint8_t i = 0; i <= length; i++) {
+
+        frame[length + 1] = _crc8_ccitt_update(frame[length + 1], frame[i]);
+
+    }
+
+    return length + 2;
+
+}
+
+/**
+ * @brief Switches between ASCII and binary mode
+ *
+ * @param binary True to switch to binary mode, false to switch to ASCII mode
+ */
+static void protocol_switch_mode(bool binary)
+{
+
+    char request[UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+    size_t length;
+
+    if (uart_protocol_binary_mode == binary) {
+
+        return;
+
+    }
+
+    length = protocol_build_request(request, "b", "");
+
+    const protocol_spec_t* spec = protocol_find_spec("b");
+    const char* output = protocol_request(request, length, &length);
+
+    // The command is confirmed in the mode being left
+    uart_protocol_binary_mode = !uart_protocol_binary_mode;
+    bool ok = protocol_check_response(spec, output, length, NULL);
+    uart_protocol_binary_mode = !uart_protocol_binary_mode;
+
+    if (!ok || uart_protocol_binary_mode != binary) {
+
+        protocol_fail("b: switching to %s mode", binary ? "binary" : "ASCII");
+
+    }
+
+}
+
+/**
+ * @brief Issues every command compiled in and checks its responses
+ *
+ * Each command is issued #PROTOCOL_REPETITIONS times to measure the time it
+ * takes to be processed on the host. The number of bytes transferred is
+ * converted into the number of commands per second the link could carry at
+ * #UART_BAUD with 8N1 (10 bits per byte).
+ *
+ * @param binary True to issue the commands in binary mode, false otherwise
+ */
+static void protocol_commands(bool binary)
+{
+
+    uint32_t request_bytes = 0;
+    uint32_t response_bytes = 0;
+    uint8_t commands = 0;
+    uint64_t total = 0;
+
+    protocol_switch_mode(binary);
+
+    printf("%s mode:\n", binary ? "Binary" : "ASCII");
+
+    for (uint8_t i = 0; i < UART_PROTOCOL_COMMANDS_COUNT; i++) {
+
+        const protocol_spec_t* spec = protocol_find_spec(uart_protocol_commands[i].command);
+
+        if (!spec || !spec->args) {
+
+            continue;
+
+        }
+
+        char request[UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+        size_t request_length = protocol_build_request(request, spec->command, spec->args);
+        size_t length = 0;
+        bool ok = true;
+
+        uint64_t start = host_time_ns();
+
+        for (uint16_t j = 0; j < PROTOCOL_REPETITIONS; j++) {
+
+            const char* output = protocol_request(request, request_length, &length);
+
+            if (ok && !protocol_check_response(spec, output, length, NULL)) {
+
+                protocol_fail("%s: unexpected response of %zu bytes in %s mode",
+                    spec->command, length, binary ? "binary" : "ASCII");
+                ok = false;
+
+            }
+
+        }
+
+        uint64_t ns = host_time_ns() - start;
+
+        printf("  %-4s %8.1f ns/command %4zu bytes sent %4zu bytes received  %s\n",
+            spec->command, (double)ns / PROTOCOL_REPETITIONS, request_length, length,
+            ok ? "OK" : "FAILED");
+
+        request_bytes += request_length;
+        response_bytes += length;
+        total += ns;
+        commands++;
+
+    }
+
+    printf("  Average: %.1f ns/command, %.1f bytes sent, %.1f bytes received, "
+        "%.0f commands/s at %lu baud\n",
+        (double)total / PROTOCOL_REPETITIONS / commands,
+        (double)request_bytes / commands, (double)response_bytes / commands,
+        (double)UART_BAUD / 10 * commands / (request_bytes > response_bytes ? request_bytes : response_bytes),
+        (unsigned long)UART_BAUD);
+
+}
+
+/**
+ * @brief Checks the handling of the number of arguments and request IDs
+ *
+ * Each command needs to be rejected when issued with one argument too few
+ * and/or too many. Valid request IDs need to be put out along with the
+ * response, invalid ones need to result in an error without a request ID.
+ */
+static void protocol_syntax()
+{
+
+    static const protocol_spec_t error = {"", "", "ERROR"};
+
+    char request[2 * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+    size_t length;
+
+    protocol_switch_mode(false);
+
+    for (uint8_t i = 0; i < UART_PROTOCOL_COMMANDS_COUNT; i++) {
+
+        const uart_protocol_command_t* entry = &uart_protocol_commands[i];
+
+        // Too many arguments
+        strcpy(request, entry->command);
+
+        for (uint8_t j = 0; j <= entry->arguments; j++) {
+
+            strcat(request, " 00");
+
+        }
+
+        strcat(request, "\r");
+
+        const char* output = protocol_request(request, strlen(request), &length);
+
+        if (!protocol_check_response(&error, output, length, NULL)) {
+
+            protocol_fail("%s: accepted %u arguments", entry->command, entry->arguments + 1);
+
+        }
+
+        // Too few arguments
+        if (entry->arguments == 0) {
+
+            continue;
+
+        }
+
+        strcpy(request, entry->command);
+
+        for (uint8_t j = 1; j < entry->arguments; j++) {
+
+            strcat(request, " 00");
+
+        }
+
+        strcat(request, "\r");
+
+        output = protocol_request(request, strlen(request), &length);
+
+        if (!protocol_check_response(&error, output, length, NULL)) {
+
+            protocol_fail("%s: accepted %u arguments", entry->command, entry->arguments - 1);
+
+        }
+
+    }
+
+    static const char* const valid_ids[] = {"00", "2a", "ff"};
+    static const char* const invalid_ids[] = {"#", "#2", "#2g", "#2a2", "#-1"};
+
+    for (uint8_t i = 0; i < sizeof(valid_ids) / sizeof(valid_ids[0]); i++) {
+
+        sprintf(request, "#%s v\r", valid_ids[i]);
+
+        const char* output = protocol_request(request, strlen(request), &length);
+
+        if (!protocol_check_response(protocol_find_spec("v"), output, length, valid_ids[i])) {
+
+            protocol_fail("#%s v: request ID not put out", valid_ids[i]);
+
+        }
+
+    }
+
+    for (uint8_t i = 0; i < sizeof(invalid_ids) / sizeof(invalid_ids[0]); i++) {
+
+        sprintf(request, "%s v\r", invalid_ids[i]);
+
+        const char* output = protocol_request(request, strlen(request), &length);
+
+        if (!protocol_check_response(&error, output, length, NULL)) {
+
+            protocol_fail("%s v: invalid request ID accepted", invalid_ids[i]);
+
+        }
+
+    }
+
+}
+
+/**
+ * @brief Returns the command of the given line
+ *
+ * This skips a leading request ID just like
+ * uart_protocol_tokenize_command_buffer() does.
+ *
+ * @param line Line to look at
+ * @param command Pointer to memory of at least
+ * UART_PROTOCOL_COMMAND_BUFFER_SIZE bytes the command will be copied to
+ */
+static void protocol_line_command(const char* line, char* command)
+{
+
+    char copy[2 * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+
+    strcpy(copy, line);
+
+    char* token = strtok(copy, " ");
+
+    if (token && token[0] == UART_PROTOCOL_REQUEST_ID_PREFIX) {
+
+        token = strtok(NULL, " ");
+
+    }
+
+    strcpy(command, token ? token : "");
+
+}
+
+/**
+ * @brief Checks whether the given response is an error in ASCII mode
+ *
+ * Other than protocol_check_response() this accepts any request ID, as the
+ * request IDs of random lines might or might not be valid.
+ *
+ * @param output Response to check
+ * @param length Length of the response
+ *
+ * @return True if the response is an error, false otherwise
+ */
+static bool protocol_is_error(const char* output, size_t length)
+{
+
+    static const char error_str[] = "ERROR" UART_PROTOCOL_OUTPUT_EOL;
+
+    const size_t error_length = sizeof(error_str) - 1;
+    const size_t prefix_length = strlen(UART_PROTOCOL_OUTPUT_PREFIX);
+
+    if (length < prefix_length + error_length
+            || memcmp(output, UART_PROTOCOL_OUTPUT_PREFIX, prefix_length)
+            || memcmp(&output[length - error_length], error_str, error_length)) {
+
+        return false;
+
+    }
+
+    // Nothing but a request ID in between
+    size_t between = length - prefix_length - error_length;
+
+    return between == 0 || (between == 4 && output[prefix_length] == UART_PROTOCOL_REQUEST_ID_PREFIX);
+
+}
+
+/**
+ * @brief Throws random lines at the parser
+ *
+ * The lines are made up of commands, arguments, request IDs and garbage,
+ * and some of them exceed the command buffer. Each line needs to be
+ * answered by exactly one response (apart from `tb`), which needs to be an
+ * error for unknown commands and for lines exceeding the command buffer.
+ * The latter also need to be counted (see `ug`), unless the counter has
+ * been cleared by `uc` in between. Lines issuing `b`, `f` or `r` are
+ * skipped.
+ */
+static void protocol_fuzz_lines()
+{
+
+    uint16_t exceeding = 0;
+    uint16_t oversize = 0;
+    uint64_t ns = 0;
+
+    protocol_switch_mode(false);
+    uart_protocol_oversize_lines = 0;
+    srand(1);
+
+    for (uint32_t i = 0; i < PROTOCOL_FUZZ_LINES; i++) {
+
+        char line[2 * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+        char command[2 * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+        size_t length = 0;
+
+        if (rand() % 4 == 0) {
+
+            length += sprintf(&line[length], "#%02x ", rand() % 256);
+
+        }
+
+        if (rand() % 4 == 0) {
+
+            length += sprintf(&line[length], "%c%c", 'a' + rand() % 26, 'a' + rand() % 26);
+
+        } else {
+
+            length += sprintf(&line[length], "%s", protocol_specs[rand() % PROTOCOL_SPECS_COUNT].command);
+
+        }
+
+        for (int8_t args = rand() % 8; args > 0; args--) {
+
+            length += sprintf(&line[length], rand() % 2 ? " %02x" : " %x", rand() % 256);
+
+        }
+
+        // Garble a few of the lines (without introducing EOL and/or NUL)
+        for (int8_t garble = rand() % 16 - 12; garble > 0; garble--) {
+
+            char c = 1 + rand() % 255;
+
+            line[rand() % length] = (c == UART_PROTOCOL_INPUT_EOL) ? ' ' : c;
+
+        }
+
+        line[length] = '\0';
+        protocol_line_command(line, command);
+
+        if (!strcmp(command, "b") || !strcmp(command, "f") || !strcmp(command, "r")) {
+
+            continue;
+
+        }
+
+        bool exceeded = length > UART_PROTOCOL_COMMAND_BUFFER_SIZE - 1;
+        line[length++] = UART_PROTOCOL_INPUT_EOL;
+
+        uint64_t start = host_time_ns();
+        const char* output = protocol_request(line, length, &length);
+        ns += host_time_ns() - start;
+
+        const char* eol = memchr(output, '\n', length);
+
+        if (strcmp(command, "tb") && (!eol || eol != &output[length - 1])) {
+
+            protocol_fail("%.*s: not answered by a single line", (int)strlen(line) - 1, line);
+
+        } else if ((exceeded || !protocol_find_spec(command)) && !protocol_is_error(output, length)) {
+
+            protocol_fail("%.*s: not rejected", (int)strlen(line) - 1, line);
+
+        }
+
+        exceeding += exceeded;
+        oversize += exceeded;
+
+        if (!strcmp(command, "uc") && !protocol_is_error(output, length)) {
+
+            oversize = 0;
+
+        }
+
+    }
+
+    if (uart_protocol_oversize_lines != oversize) {
+
+        protocol_fail("%u lines exceeding the command buffer counted, %u expected",
+            uart_protocol_oversize_lines, oversize);
+
+    }
+
+    printf("Random lines: %u lines (%u exceeding the buffer), %.1f ns/line\n",
+        PROTOCOL_FUZZ_LINES, exceeding, (double)ns / PROTOCOL_FUZZ_LINES);
+
+}
+
+/**
+ * @brief Throws malformed and corrupted frames at the parser
+ *
+ * A single bit flipped after the length needs to be answered by exactly one
+ * error frame, as CRC-8 detects all of these. A length exceeding the command
+ * buffer needs to be rejected right away and leading zeros need to be
+ * ignored. A truncated frame followed by zeros needs to be rejected once
+ * the zeros have completed it, and must not keep the parser from answering
+ * the following frame properly.
+ */
+static void protocol_fuzz_frames()
+{
+
+    static const protocol_spec_t error = {"", "", "ERROR"};
+
+    const protocol_spec_t* version = protocol_find_spec("v");
+    char request[2 * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+    char valid[UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+    size_t valid_length;
+    size_t length;
+
+    protocol_switch_mode(true);
+    srand(1);
+
+    valid_length = protocol_build_request(valid, "v", "");
+
+    for (uint32_t i = 0; i < PROTOCOL_FUZZ_FRAMES; i++) {
+
+        const protocol_spec_t* spec = &protocol_specs[rand() % PROTOCOL_SPECS_COUNT];
+
+        if (!spec->args || !uart_protocol_find_command(spec->command, 0)) {
+
+            continue;
+
+        }
+
+        size_t request_length = protocol_build_request(request, spec->command, spec->args);
+
+        request[1 + rand() % (request_length - 1)] ^= 1 << (rand() % 8);
+
+        const char* output = protocol_request(request, request_length, &length);
+
+        if (!protocol_check_response(&error, output, length, NULL)) {
+
+            protocol_fail("%s: corrupted frame not rejected", spec->command);
+
+        }
+
+    }
+
+    for (uint16_t c = UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS + 1; c <= 0xff; c++) {
+
+        request[0] = c;
+
+        const char* output = protocol_request(request, 1, &length);
+
+        if (!protocol_check_response(&error, output, length, NULL)) {
+
+            protocol_fail("%02x: length exceeding the buffer not rejected", c);
+
+        }
+
+    }
+
+    memset(request, 0, 4);
+    memcpy(&request[4], valid, valid_length);
+
+    const char* output = protocol_request(request, 4 + valid_length, &length);
+
+    if (!protocol_check_response(version, output, length, NULL)) {
+
+        protocol_fail("Leading zeros not ignored");
+
+    }
+
+    request[0] = UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS;
+    request[1] = 0x60;
+    memset(&request[2], 0, UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS + 2);
+
+    output = protocol_request(request, UART_PROTOCOL_COMMAND_BUFFER_MAX_ARGS + 4, &length);
+
+    if (!protocol_check_response(&error, output, length, NULL)) {
+
+        protocol_fail("Truncated frame not answered by a single frame");
+
+    }
+
+    output = protocol_request(valid, valid_length, &length);
+
+    if (!protocol_check_response(version, output, length, NULL)) {
+
+        protocol_fail("Not in sync after truncated frame");
+
+    }
+
+    printf("Corrupted frames: %u frames\n", PROTOCOL_FUZZ_FRAMES);
+
+}
+
+/**
+ * @brief Sends a batch of commands without waiting for the responses
+ *
+ * Each command carries its own request ID. All of the responses need to be
+ * put out in order, each one carrying the request ID of its command.
+ */
+static void protocol_pipeline()
+{
+
+    static const char* const commands[] = {"v", "k", "cr", "lb", "pn"};
+
+    char requests[PROTOCOL_PIPELINE_LENGTH * UART_PROTOCOL_COMMAND_BUFFER_SIZE];
+    size_t length = 0;
+
+    protocol_switch_mode(false);
+
+    for (uint8_t i = 0; i < PROTOCOL_PIPELINE_LENGTH; i++) {
+
+        length += sprintf(&requests[length], "#%02x %s\r", i,
+            commands[i % (sizeof(commands) / sizeof(commands[0]))]);
+
+    }
+
+    uint64_t start = host_time_ns();
+    const char* output = protocol_request(requests, length, &length);
+    uint64_t ns = host_time_ns() - start;
+
+    uint8_t responses = 0;
+
+    for (const char* end = output; end < &output[length]; responses++) {
+
+        const char* line = end;
+        char id[3];
+
+        end = memchr(line, '\n', &output[length] - line);
+
+        if (!end++ || responses == PROTOCOL_PIPELINE_LENGTH) {
+
+            break;
+
+        }
+
+        sprintf(id, "%02x", responses);
+
+        const char* command = commands[responses % (sizeof(commands) / sizeof(commands[0]))];
+
+        if (!protocol_check_response(protocol_find_spec(command), line, end - line, id)) {
+
+            protocol_fail("#%s %s: response dropped or garbled", id, command);
+
+            return;
+
+        }
+
+    }
+
+    if (responses != PROTOCOL_PIPELINE_LENGTH) {
+
+        protocol_fail("%u of %u pipelined commands answered", responses, PROTOCOL_PIPELINE_LENGTH);
+
+    }
+
+    printf("Pipeline: %u commands, %.1f ns/command\n", PROTOCOL_PIPELINE_LENGTH,
+        (double)ns / PROTOCOL_PIPELINE_LENGTH);
+
+}
+
+int main(int argc, char* argv[])
+{
+
+    if (argc != 2 || !protocol_read_doc(argv[1])) {
+
+        fprintf(stderr, "Usage: %s UART_PROTOCOL.md\n", argv[0]);
+
+        return 2;
+
+    }
+
+    uart_init();
+    preferences_init();
+
+    protocol_check_table();
+    protocol_commands(false);
+    protocol_commands(true);
+    protocol_syntax();
+    protocol_fuzz_lines();
+    protocol_fuzz_frames();
+    protocol_pipeline();
+
+    protocol_switch_mode(false);
+
+    printf("%s\n", protocol_failures ? "FAILED" : "OK");
+
+    return protocol_failures ? 1 : 0;
+
+}
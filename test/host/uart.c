@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file uart.c
+ * @brief Replacement of src/uart.c for host builds
+ *
+ * Received data is taken from the data set by host_uart_input(), while
+ * transmitted data is collected within a buffer, which can be retrieved by
+ * host_uart_output(). The UDRIE0 bit is never set, so uart_flush_output()
+ * returns right away.
+ *
+ * @see host.h
+ * @see uart.h
+ */
+
+#include <string.h>
+
+#include "host.h"
+#include "uart.h"
+
+/**
+ * @brief Data not yet retrieved by uart_getc_nowait()
+ *
+ * @see host_uart_input_block()
+ */
+static const char* uart_input;
+
+/**
+ * @brief Number of bytes left within uart_input
+ *
+ * @see host_uart_input_block()
+ */
+static size_t uart_input_length;
+
+/**
+ * @brief Data transmitted so far
+ *
+ * @see host_uart_output()
+ */
+static char uart_output[HOST_UART_OUTPUT_SIZE];
+
+/**
+ * @brief Number of bytes transmitted so far
+ *
+ * This also counts bytes that didn't fit into uart_output anymore.
+ *
+ * @see uart_output
+ */
+static size_t uart_output_length;
+
+/**
+ * @brief Sets the data that is going to be received next
+ *
+ * @param str String to receive, which needs to remain valid until it has
+ * been consumed completely
+ *
+ * @see uart_getc_nowait()
+ */
+void host_uart_input(const char* str)
+{
+
+    host_uart_input_block(str, strlen(str));
+
+}
+
+/**
+ * @brief Sets the data that is going to be received next
+ *
+ * Other than host_uart_input() this can also be used for binary data.
+ *
+ * @param data Data to receive, which needs to remain valid until it has been
+ * consumed completely
+ * @param length Number of bytes to receive
+ *
+ * @see uart_getc_nowait()
+ */
+void host_uart_input_block(const void* data, size_t length)
+{
+
+    uart_input = data;
+    uart_input_length = length;
+
+}
+
+/**
+ * @brief Retrieves the data transmitted since the last invocation of
+ * host_uart_output_clear()
+ *
+ * @param length Pointer to memory the number of bytes transmitted will be
+ * copied to, which might be more than has actually been captured
+ *
+ * @return Captured data (not terminated)
+ *
+ * @see HOST_UART_OUTPUT_SIZE
+ */
+const char* host_uart_output(size_t* length)
+{
+
+    *length = uart_output_length;
+
+    return uart_output;
+
+}
+
+/**
+ * @brief Discards the data transmitted so far
+ */
+void host_uart_output_clear()
+{
+
+    uart_output_length = 0;
+
+}
+
+void uart_init()
+{
+
+    uart_input = NULL;
+    uart_input_length = 0;
+    uart_output_length = 0;
+
+}
+
+bool uart_putc(char c)
+{
+
+    if (uart_output_length < HOST_UART_OUTPUT_SIZE) {
+
+        uart_output[uart_output_length] = c;
+
+    }
+
+    uart_output_length++;
+
+    return true;
+
+}
+
+bool uart_getc_nowait(char* c)
+{
+
+    if (!uart_available()) {
+
+        return false;
+
+    }
+
+    *c = *uart_input++;
+    uart_input_length--;
+
+    return true;
+
+}
+
+char uart_getc_wait()
+{
+
+    char c = 0;
+
+    uart_getc_nowait(&c);
+
+    return c;
+
+}
+
+bool uart_available()
+{
+
+    return uart_input_length != 0;
+
+}
+
+uint8_t uart_free()
+{
+
+    return UART_BUFFER_SIZE_OUT;
+
+}
+
+void uart_puts(const char* str)
+{
+
+    while (*str) {
+
+        uart_putc(*str++);
+
+    }
+
+}
+
+void uart_puts_p(PGM_P str)
+{
+
+    uart_puts(str);
+
+}
+
+bool uart_put_block(const void* data, size_t length)
+{
+
+    const char* ptr = data;
+
+    while (length--) {
+
+        uart_putc(*ptr++);
+
+    }
+
+    return true;
+
+}
+
+bool uart_puts_p_block(PGM_P str)
+{
+
+    uart_puts(str);
+
+    return true;
+
+}
+
+void uart_get_stats(uart_stats_t* stats)
+{
+
+    memset(stats, 0, sizeof(*stats));
+
+}
+
+void uart_reset_stats()
+{
+
+}
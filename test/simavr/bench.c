@@ -0,0 +1,667 @@
+/*
+ * Copyright (C) 2014 Karol Babioch <karol@babioch.de>
+ *
+ * This file is part of Wordclock.
+ *
+ * Wordclock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Wordclock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Wordclock. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench.c
+ * @brief Cycle accurate benchmark of the firmware image running in simavr
+ *
+ * This boots the actual firmware image (ELF) on a simulated ATmega328P and
+ * injects traffic on all of its inputs while it is running:
+ *
+ * - DCF77: A valid time signal on DCF_INPUT (PB7), starting out with
+ *   2014-05-10 12:34, emulating a high active receiver
+ * - IR: A NEC frame on the IR input (PB6) every BENCH_IR_INTERVAL_MS
+ * - UART: One of bench_uart_lines every BENCH_UART_INTERVAL_MS at the
+ *   configured baud rate
+ *
+ * The cycles spent within `TIMER1_CAPT_vect` and `DISPLAY_TIMER_OVF_vect`
+ * are recorded by means of the interrupt IRQs of simavr, which are raised
+ * whenever a vector is entered and left (`reti`). The numbers include nested
+ * interrupts, if any. Invocations of `TIMER1_CAPT_vect` exceeding the time
+ * between two ticks (BENCH_TICK_BUDGET) are counted separately.
+ *
+ * An iteration of the main loop is measured from the return of event_get()
+ * to its next invocation, excluding all of the cycles spent within ISRs in
+ * between. The address of event_get() needs to be passed in (`-l`), as it
+ * depends on the build, see Makefile.
+ *
+ * @see Makefile
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_interrupts.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_uart.h"
+
+/**
+ * @brief Frequency of the microcontroller, unless the image defines one
+ */
+#define BENCH_F_CPU 8000000
+
+/**
+ * @brief Frequency of `TIMER1_CAPT_vect`
+ *
+ * @see F_INTERRUPT
+ */
+#define BENCH_F_INTERRUPT 10000
+
+/**
+ * @brief Cycles available per invocation of `TIMER1_CAPT_vect`
+ */
+#define BENCH_TICK_BUDGET (BENCH_F_CPU / BENCH_F_INTERRUPT)
+
+/**
+ * @brief Baud rate of the UART
+ *
+ * @see UART_BAUD
+ */
+#define BENCH_UART_BAUD 9600
+
+/**
+ * @brief Interval in which lines are sent via UART
+ */
+#define BENCH_UART_INTERVAL_MS 250
+
+/**
+ * @brief Interval in which IR frames are sent
+ */
+#define BENCH_IR_INTERVAL_MS 500
+
+/**
+ * @brief Default length of the simulation in seconds
+ *
+ * This covers the detection of the DCF77 receiver along with a few time
+ * frames.
+ */
+#define BENCH_DEFAULT_SECONDS 200
+
+/**
+ * @brief Vector of `TIMER1_CAPT_vect` on the ATmega328P
+ */
+#define BENCH_VECTOR_TIMER1_CAPT 10
+
+/**
+ * @brief Vector of `DISPLAY_TIMER_OVF_vect` (`TIMER2_OVF_vect`) on the
+ * ATmega328P
+ *
+ * @see DISPLAY_TIMER_OVF_vect
+ */
+#define BENCH_VECTOR_DISPLAY_TIMER_OVF 9
+
+/**
+ * @brief Cycle statistics of a single vector or section of code
+ */
+typedef struct {
+
+    /**
+     * @brief Name as put out by bench_report()
+     */
+    const char* name;
+
+    /**
+     * @brief Number of the vector, not used for the main loop
+     */
+    uint8_t vector;
+
+    /**
+     * @brief Cycle the current invocation has started at
+     */
+    avr_cycle_count_t start;
+
+    /**
+     * @brief Number of invocations
+     */
+    uint32_t count;
+
+    /**
+     * @brief Cycles spent within all invocations
+     */
+    uint64_t total;
+
+    /**
+     * @brief Cycles spent within the longest invocation
+     */
+    uint32_t max;
+
+    /**
+     * @brief Number of invocations exceeding BENCH_TICK_BUDGET
+     */
+    uint32_t over_budget;
+
+} bench_stats_t;
+
+/**
+ * @brief The simulated microcontroller
+ */
+static avr_t* bench_avr;
+
+/**
+ * @brief Statistics of the vectors being measured
+ */
+static bench_stats_t bench_vectors[] = {
+
+    {"TIMER1_CAPT_vect", BENCH_VECTOR_TIMER1_CAPT},
+    {"DISPLAY_TIMER_OVF_vect", BENCH_VECTOR_DISPLAY_TIMER_OVF},
+
+};
+
+/**
+ * @brief Statistics of the main loop
+ */
+static bench_stats_t bench_main_loop = {"Main loop"};
+
+/**
+ * @brief Cycles spent within ISRs in total
+ *
+ * Nested interrupts are only counted once.
+ */
+static uint64_t bench_isr_cycles;
+
+/**
+ * @brief Cycle the outermost ISR currently running has started at
+ */
+static avr_cycle_count_t bench_isr_start;
+
+/**
+ * @brief Lines sent via UART in turns
+ *
+ * These only cover commands, which neither change the state nor access the
+ * EEPROM.
+ */
+static const char* const bench_uart_lines[] = {
+
+    "tg\r",
+    "dg\r",
+    "lb\r",
+    "sg\r",
+    "k\r",
+
+};
+
+/**
+ * @brief Number of bytes received via UART
+ */
+static uint32_t bench_uart_received;
+
+/**
+ * @brief Number of lines sent via UART
+ */
+static uint32_t bench_uart_sent;
+
+/**
+ * @brief Records the time spent within a single vector
+ *
+ * This is notified by simavr with value set to 1 whenever the vector is
+ * entered and with value set to 0 whenever it is left.
+ *
+ * @param irq The AVR_INT_IRQ_RUNNING IRQ of the vector
+ * @param value Whether the vector is running
+ * @param param The bench_stats_t of the vector
+ */
+static void bench_vector_notify(avr_irq_t* irq, uint32_t value, void* param)
+{
+
+    bench_stats_t* stats = param;
+
+    if (value) {
+
+        stats->start = bench_avr->cycle;
+
+        return;
+
+    }
+
+    uint32_t cycles = bench_avr->cycle - stats->start;
+
+    stats->count++;
+    stats->total += cycles;
+
+    if (cycles > stats->max) {
+
+        stats->max = cycles;
+
+    }
+
+    if (cycles > BENCH_TICK_BUDGET) {
+
+        stats->over_budget++;
+
+    }
+
+}
+
+/**
+ * @brief Records the time spent within ISRs of any kind
+ *
+ * This is notified by simavr with the number of the vector currently
+ * running, or 0 once the last one has been left.
+ *
+ * @param irq The AVR_INT_IRQ_RUNNING IRQ of AVR_INT_ANY
+ * @param value Number of the vector currently running
+ * @param param Unused
+ */
+static void bench_any_notify(avr_irq_t* irq, uint32_t value, void* param)
+{
+
+    if (value && !bench_isr_start) {
+
+        bench_isr_start = bench_avr->cycle;
+
+    } else if (!value && bench_isr_start) {
+
+        bench_isr_cycles += bench_avr->cycle - bench_isr_start;
+        bench_isr_start = 0;
+
+    }
+
+}
+
+/**
+ * @brief Counts the bytes sent by the firmware via UART
+ *
+ * @param irq The UART_IRQ_OUTPUT IRQ
+ * @param value The byte sent
+ * @param param Unused
+ */
+static void bench_uart_notify(avr_irq_t* irq, uint32_t value, void* param)
+{
+
+    bench_uart_received++;
+
+}
+
+/**
+ * @brief Converts a decimal number into BCD
+ *
+ * @param value Decimal number to convert, ranges from 0 to 99
+ *
+ * @return BCD representation of the given number
+ */
+static uint8_t bench_bcd(uint8_t value)
+{
+
+    return ((value / 10) << 4) | (value % 10);
+
+}
+
+/**
+ * @brief Encodes the given bits of a time frame
+ *
+ * @param bits Bits of the time frame, indexed by the number of the second
+ * @param first Number of the first bit to encode
+ * @param count Number of bits to encode
+ * @param value Value of the bits, LSB first
+ * @param parity Pointer to the parity of the bits encoded so far
+ */
+static void bench_dcf77_bits(bool* bits, uint8_t first, uint8_t count,
+    uint8_t value, bool* parity)
+{
+
+    for (uint8_t i = 0; i < count; i++) {
+
+        bits[first + i] = (value >> i) & 1;
+        *parity ^= bits[first + i];
+
+    }
+
+}
+
+/**
+ * @brief Timer generating the DCF77 signal
+ *
+ * This is invoked every 10 ms. The time frame being transmitted during a
+ * minute encodes the next one. Within each second but the last one of a
+ * minute the carrier is reduced for 100 ms (0) or 200 ms (1), which makes
+ * the output of the emulated receiver go high.
+ *
+ * @see avr_cycle_timer_t
+ */
+static avr_cycle_count_t bench_dcf77_timer(avr_t* avr,
+    avr_cycle_count_t when, void* param)
+{
+
+    static uint32_t tick;
+    static bool bits[60];
+
+    avr_irq_t* irq = param;
+    uint8_t second = (tick / 100) % 60;
+    uint8_t hundredth = tick % 100;
+
+    if (second == 0 && hundredth == 0) {
+
+        uint32_t minutes = 12 * 60 + 34 + tick / 6000 + 1;
+        bool parity = false;
+
+        memset(bits, 0, sizeof(bits));
+        bits[20] = true;
+
+        bench_dcf77_bits(bits, 21, 7, bench_bcd(minutes % 60), &parity);
+        bench_dcf77_bits(bits, 28, 1, parity, &parity);
+        bench_dcf77_bits(bits, 29, 6, bench_bcd((minutes / 60) % 24), &parity);
+        bench_dcf77_bits(bits, 35, 1, parity, &parity);
+        bench_dcf77_bits(bits, 36, 6, bench_bcd(10), &parity);
+        bench_dcf77_bits(bits, 42, 3, 6, &parity);
+        bench_dcf77_bits(bits, 45, 5, bench_bcd(5), &parity);
+        bench_dcf77_bits(bits, 50, 8, bench_bcd(14), &parity);
+        bench_dcf77_bits(bits, 58, 1, parity, &parity);
+
+    }
+
+    bool level = second != 59 && hundredth < (bits[second] ? 20 : 10);
+
+    avr_raise_irq(irq, level);
+    tick++;
+
+    return when + avr_usec_to_cycles(avr, 10000);
+
+}
+
+/**
+ * @brief Timer generating the IR signal
+ *
+ * This transmits a NEC frame (address 0x00, command 0x45) every
+ * BENCH_IR_INTERVAL_MS. The output of the emulated receiver is low while the
+ * carrier is being transmitted.
+ *
+ * @see avr_cycle_timer_t
+ */
+static avr_cycle_count_t bench_ir_timer(avr_t* avr,
+    avr_cycle_count_t when, void* param)
+{
+
+    static const uint32_t frame = 0x00ff45baUL;
+    static uint8_t segment;
+
+    avr_irq_t* irq = param;
+    uint32_t usec;
+
+    // Leader (mark & space), 32 bits (mark & space each), stop bit (mark)
+    if (segment == 0) {
+
+        usec = 9000;
+
+    } else if (segment == 1) {
+
+        usec = 4500;
+
+    } else if (segment < 66) {
+
+        bool bit = (frame >> (31 - (segment - 2) / 2)) & 1;
+
+        usec = (segment % 2 == 0 || !bit) ? 560 : 1690;
+
+    } else if (segment == 66) {
+
+        usec = 560;
+
+    } else {
+
+        avr_raise_irq(irq, 1);
+        segment = 0;
+
+        return when + avr_usec_to_cycles(avr, BENCH_IR_INTERVAL_MS * 1000UL);
+
+    }
+
+    avr_raise_irq(irq, segment % 2);
+    segment++;
+
+    return when + avr_usec_to_cycles(avr, usec);
+
+}
+
+/**
+ * @brief Timer feeding lines into the UART
+ *
+ * This passes a single byte every time it takes to transmit one at
+ * BENCH_UART_BAUD (8N1), and waits for BENCH_UART_INTERVAL_MS after each
+ * line.
+ *
+ * @see avr_cycle_timer_t
+ */
+static avr_cycle_count_t bench_uart_timer(avr_t* avr,
+    avr_cycle_count_t when, void* param)
+{
+
+    static uint8_t line;
+    static uint8_t pos;
+
+    avr_irq_t* irq = param;
+    const char* str = bench_uart_lines[line];
+
+    avr_raise_irq(irq, str[pos++]);
+
+    if (str[pos]) {
+
+        return when + avr_usec_to_cycles(avr, 10 * 1000000UL / BENCH_UART_BAUD);
+
+    }
+
+    pos = 0;
+    line = (line + 1) % (sizeof(bench_uart_lines) / sizeof(bench_uart_lines[0]));
+    bench_uart_sent++;
+
+    return when + avr_usec_to_cycles(avr, BENCH_UART_INTERVAL_MS * 1000UL);
+
+}
+
+/**
+ * @brief Replaces the sleep callback of simavr
+ *
+ * By default simavr sleeps in real time whenever the microcontroller does,
+ * which isn't needed here.
+ */
+static void bench_sleep(avr_t* avr, avr_cycle_count_t howLong)
+{
+
+}
+
+/**
+ * @brief Outputs the statistics of a single vector or section of code
+ *
+ * @param stats The statistics to output
+ */
+static void bench_report(const bench_stats_t* stats)
+{
+
+    printf("%-24s %10u %10.1f %10u %10u\n", stats->name, stats->count,
+        stats->count ? (double)stats->total / stats->count : 0.0, stats->max,
+        stats->over_budget);
+
+}
+
+int main(int argc, char* argv[])
+{
+
+    elf_firmware_t firmware = {{0}};
+    uint32_t main_loop = 0;
+    uint32_t seconds = BENCH_DEFAULT_SECONDS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:s:")) != -1) {
+
+        switch (opt) {
+
+            case 'l':
+                main_loop = strtoul(optarg, NULL, 0);
+                break;
+
+            case 's':
+                seconds = strtoul(optarg, NULL, 0);
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-l <event_get>] [-s <seconds>] <firmware.elf>\n",
+                    argv[0]);
+
+                return 2;
+
+        }
+
+    }
+
+    if (optind != argc - 1 || elf_read_firmware(argv[optind], &firmware)) {
+
+        fprintf(stderr, "Unable to load the firmware image\n");
+
+        return 2;
+
+    }
+
+    avr_t* avr = avr_make_mcu_by_name(firmware.mmcu[0] ? firmware.mmcu : "atmega328p");
+
+    if (!avr) {
+
+        fprintf(stderr, "Unknown microcontroller: %s\n", firmware.mmcu);
+
+        return 2;
+
+    }
+
+    bench_avr = avr;
+    avr_init(avr);
+    avr->frequency = BENCH_F_CPU;
+
+    // This takes over the frequency of the image, if it defines one
+    avr_load_firmware(avr, &firmware);
+    avr->sleep = bench_sleep;
+
+    for (uint8_t i = 0; i < sizeof(bench_vectors) / sizeof(bench_vectors[0]); i++) {
+
+        avr_irq_t* irq = avr_get_interrupt_irq(avr, bench_vectors[i].vector);
+
+        avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, bench_vector_notify,
+            &bench_vectors[i]);
+
+    }
+
+    avr_irq_register_notify(avr_get_interrupt_irq(avr, AVR_INT_ANY)
+        + AVR_INT_IRQ_RUNNING, bench_any_notify, NULL);
+
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'),
+        UART_IRQ_OUTPUT), bench_uart_notify, NULL);
+
+    avr_irq_t* dcf77 = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 7);
+    avr_irq_t* ir = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 6);
+
+    avr_raise_irq(dcf77, 0);
+    avr_raise_irq(ir, 1);
+
+    // Leave the firmware some time to initialize itself
+    avr_cycle_timer_register_usec(avr, 1000000, bench_dcf77_timer, dcf77);
+    avr_cycle_timer_register_usec(avr, 1000000, bench_ir_timer, ir);
+    avr_cycle_timer_register_usec(avr, 1000000, bench_uart_timer,
+        avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT));
+
+    avr_cycle_count_t end = (avr_cycle_count_t)seconds * avr->frequency;
+    avr_cycle_count_t main_loop_exit = 0;
+    uint64_t main_loop_isr_cycles = 0;
+    uint16_t main_loop_sp = 0;
+    uint32_t main_loop_return = 0;
+    bool within_event_get = false;
+
+    while (avr->cycle < end) {
+
+        /*
+         * Check the instruction about to be executed, as the one executed
+         * by avr_run() might already be followed by the entry of an ISR.
+         */
+        if (main_loop) {
+
+            uint16_t sp = avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+
+            if (!within_event_get && avr->pc == main_loop) {
+
+                if (main_loop_exit) {
+
+                    uint32_t cycles = avr->cycle - main_loop_exit
+                        - (bench_isr_cycles - main_loop_isr_cycles);
+
+                    bench_main_loop.count++;
+                    bench_main_loop.total += cycles;
+
+                    if (cycles > bench_main_loop.max) {
+
+                        bench_main_loop.max = cycles;
+
+                    }
+
+                }
+
+                // The return address is pushed high byte last (word address)
+                main_loop_sp = sp;
+                main_loop_return = ((avr->data[sp + 1] << 8) | avr->data[sp + 2]) * 2;
+                within_event_get = true;
+
+            } else if (within_event_get && avr->pc == main_loop_return
+                    && sp == main_loop_sp + 2) {
+
+                main_loop_exit = avr->cycle;
+                main_loop_isr_cycles = bench_isr_cycles;
+                within_event_get = false;
+
+            }
+
+        }
+
+        int state = avr_run(avr);
+
+        if (state == cpu_Done || state == cpu_Crashed) {
+
+            fprintf(stderr, "Simulation stopped at 0x%04x\n", avr->pc);
+
+            return 1;
+
+        }
+
+    }
+
+    printf("Simulated %u s at %u Hz, budget per tick: %u cycles\n", seconds,
+        avr->frequency, BENCH_TICK_BUDGET);
+    printf("ISR load: %.2f %%, UART: %u lines sent, %u bytes received\n\n",
+        100.0 * bench_isr_cycles / avr->cycle, bench_uart_sent,
+        bench_uart_received);
+
+    printf("%-24s %10s %10s %10s %10s\n", "Section", "Count", "Average", "Max",
+        "Over");
+
+    for (uint8_t i = 0; i < sizeof(bench_vectors) / sizeof(bench_vectors[0]); i++) {
+
+        bench_report(&bench_vectors[i]);
+
+    }
+
+    if (main_loop) {
+
+        bench_report(&bench_main_loop);
+
+    }
+
+    return 0;
+
+}